@@ -40,7 +40,7 @@ typedef bool lto_bool_t;
  * @{
  */
 
-#define LTO_API_VERSION 15
+#define LTO_API_VERSION 16
 
 /**
  * \since prior to LTO_API_VERSION=3
@@ -523,6 +523,32 @@ lto_codegen_optimize(lto_code_gen_t cg);
 extern const void*
 lto_codegen_compile_optimized(lto_code_gen_t cg, size_t* length);
 
+/**
+ * Sets the number of partitions the merged module is split into by
+ * lto_codegen_compile_optimized_to_files(). The partitions are code generated
+ * in parallel. The default is 1.
+ *
+ * \since LTO_API_VERSION=16
+ */
+extern void
+lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned int parallelism);
+
+/**
+ * Generates code for the optimized merged module into one native object file
+ * per partition (see lto_codegen_set_parallelism()). It will not run any IR
+ * optimizations on the merged module.
+ *
+ * On success returns the number of object files and sets names to an array of
+ * their paths. The array is owned by the lto_code_gen_t and will be freed when
+ * lto_codegen_dispose() is called, or this function is called again. It is up
+ * to the linker to remove the object files. On failure, returns 0 (check
+ * lto_get_error_message() for details).
+ *
+ * \since LTO_API_VERSION=16
+ */
+extern unsigned int
+lto_codegen_compile_optimized_to_files(lto_code_gen_t cg, const char ***names);
+
 /**
  * Returns the runtime API version.
  *
@@ -28,6 +28,7 @@
 
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Valgrind.h"
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
@@ -176,6 +177,22 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics to the given output stream as a single line JSON
+/// object of the form {"stats":[{"name":...,"desc":...,"value":...},...]},
+/// sorted like the PrintStatistics report.
+void PrintStatisticsJSON(raw_ostream &OS);
+
+/// \brief Return the statistics that have been bumped since they were last
+/// reset, sorted by name and description.
+std::vector<const Statistic *> GetStatistics();
+
+/// \brief Zero all the statistics that have been bumped and forget them, so
+/// that they are not printed at exit until they are bumped again.  Together
+/// with GetStatistics or PrintStatisticsJSON this collects the statistics of
+/// each compilation separately.  It must not be called while statistics are
+/// being updated by other threads.
+void ResetStatistics();
+
 } // End llvm namespace
 
 #endif
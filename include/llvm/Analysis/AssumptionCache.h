@@ -23,6 +23,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/ValueHandle.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Mutex.h"
 #include <memory>
 
 namespace llvm {
@@ -157,6 +158,10 @@ class AssumptionCacheTracker : public ImmutablePass {
                    FunctionCallbackVH::DMI> FunctionCallsMap;
   FunctionCallsMap AssumptionCaches;
 
+  /// Guards AssumptionCaches when function passes run in parallel. Functions
+  /// are never deleted then, so FunctionCallbackVH::deleted doesn't take it.
+  sys::Mutex CachesLock;
+
 public:
   /// \brief Get the cached assumptions for a function.
   ///
@@ -83,6 +83,9 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override;
   void releaseMemory() override;
   bool runOnFunction(Function &F) override;
+  FunctionPass *createParallelCopy() const override {
+    return new LazyValueInfo();
+  }
 };
 
 }  // end namespace llvm
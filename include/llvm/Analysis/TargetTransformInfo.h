@@ -28,6 +28,9 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/DataTypes.h"
 #include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace llvm {
 
@@ -886,6 +889,11 @@ class TargetTransformInfoWrapperPass : public ImmutablePass {
   TargetIRAnalysis TIRA;
   Optional<TargetTransformInfo> TTI;
 
+  /// The TTI of each thread running function passes in parallel, and the
+  /// lock that serializes creating them.
+  std::map<std::thread::id, Optional<TargetTransformInfo>> ThreadTTI;
+  std::mutex ThreadTTILock;
+
   virtual void anchor();
 
 public:
@@ -0,0 +1,132 @@
+//===- llvm/Bitcode/BitcodeSymbolTable.h - Bitcode symbol table -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the layout of the symbol table that the bitcode writer
+// emits after the module, and BitcodeSymbolTable, which reads it in place.
+// Linkers and archivers can use the table to list the symbols of a bitcode
+// file without creating an LLVMContext or parsing the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BITCODE_BITCODESYMBOLTABLE_H
+#define LLVM_BITCODE_BITCODESYMBOLTABLE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace llvm {
+
+/// \brief A read-only view of the symbol table of a bitcode file.
+///
+/// The table is the blob of the SYMTAB_BLOB record of the top-level
+/// SYMTAB_BLOCK. It is used where it lies in the bitcode, so it is only valid
+/// for as long as the memory of the bitcode is.
+///
+/// The symbols are those of the functions, global variables and aliases of
+/// the module, in that order, which is also the order of IRObjectFile. The
+/// writer does not emit a table for modules with module-level inline asm,
+/// since the symbols that it defines can only be found by parsing it.
+class BitcodeSymbolTable {
+public:
+  /// The version of the layout, which is bumped on incompatible changes.
+  enum { CurrentVersion = 2 };
+
+  enum SymbolFlags {
+    SF_Undefined = 1 << 0,      // Declaration, including extern_weak.
+    SF_Global = 1 << 1,         // Not local to the module.
+    SF_Weak = 1 << 2,           // linkonce, weak or extern_weak.
+    SF_Common = 1 << 3,         // Common linkage.
+    SF_FormatSpecific = 1 << 4, // Private, llvm.* or in llvm.metadata.
+    SF_Executable = 1 << 5,     // A function, or an alias to one.
+    SF_Constant = 1 << 6,       // A constant global variable.
+    SF_Hidden = 1 << 7,         // Hidden visibility.
+    SF_Protected = 1 << 8,      // Protected visibility.
+    SF_UnnamedAddr = 1 << 9,    // unnamed_addr.
+    SF_ThreadLocal = 1 << 10,   // A thread-local global variable.
+    SF_LinkOnceODR = 1 << 11,   // linkonce_odr linkage.
+    SF_Alias = 1 << 12          // An alias.
+  };
+
+  /// Properties of the module that a symbol table can't describe, for the
+  /// readers that need to look at the module when one is set.
+  enum ModuleFlags {
+    MF_LinkerOptions = 1 << 0, // A "Linker Options" module flag.
+    MF_ObjCSections = 1 << 1,  // Variables in "__OBJC," sections.
+    MF_NoDataLayout = 1 << 2   // No data layout, so no global prefix.
+  };
+
+  /// A string of the table, as an offset from its start and a size.
+  struct Str {
+    support::ulittle32_t Offset, Size;
+  };
+
+  /// The table starts with a header, which is followed by the symbols and
+  /// then by the strings. All fields are little-endian.
+  struct Header {
+    support::ulittle32_t Version;
+    support::ulittle32_t NumSymbols;
+    support::ulittle32_t Flags;
+    Str TargetTriple;
+  };
+
+  struct Symbol {
+    Str Name;
+    support::ulittle32_t Flags;
+    support::ulittle32_t Alignment;
+  };
+
+private:
+  StringRef Data;
+  const Header *Hdr;
+  const Symbol *Symbols;
+
+  StringRef getString(const Str &S) const {
+    return Data.substr(S.Offset, S.Size);
+  }
+
+public:
+  BitcodeSymbolTable() : Hdr(nullptr), Symbols(nullptr) {}
+
+  /// Check that Data holds a table that this version can read, and return a
+  /// view of it.
+  static ErrorOr<BitcodeSymbolTable> create(StringRef Data);
+
+  StringRef getTargetTriple() const { return getString(Hdr->TargetTriple); }
+
+  /// A combination of ModuleFlags.
+  uint32_t getModuleFlags() const { return Hdr->Flags; }
+
+  unsigned getNumSymbols() const { return Hdr->NumSymbols; }
+
+  /// The name of symbol I, as the linker sees it. This includes the global
+  /// prefix of the target, if any.
+  StringRef getSymbolName(unsigned I) const {
+    return getString(Symbols[I].Name);
+  }
+
+  /// A combination of SymbolFlags.
+  uint32_t getSymbolFlags(unsigned I) const { return Symbols[I].Flags; }
+
+  /// The alignment of symbol I, or 0 if it was not specified.
+  unsigned getSymbolAlignment(unsigned I) const {
+    return Symbols[I].Alignment;
+  }
+};
+
+/// Find the symbol table of the bitcode in Buffer, which may have a wrapper
+/// header. Returns BitcodeError::SymbolTableNotFound if the bitcode has no
+/// table that this version can read, in which case the module has to be
+/// parsed instead.
+ErrorOr<BitcodeSymbolTable> getBitcodeSymbolTable(MemoryBufferRef Buffer);
+
+} // End llvm namespace
+
+#endif
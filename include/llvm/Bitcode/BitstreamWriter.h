@@ -104,6 +104,20 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Overwrite the 32 bits that were emitted at bit position BitNo,
+  /// which need not be aligned, with NewWord. The bits must already have been
+  /// flushed to the output, e.g. by exiting the enclosing block.
+  void BackpatchWordAtBit(uint64_t BitNo, unsigned NewWord) {
+    assert(BitNo + 32 <= GetBufferOffset() * 8 && "Bits not flushed yet");
+    for (unsigned I = 0; I != 32; ++I, ++BitNo) {
+      unsigned char Mask = 1 << (BitNo & 7);
+      if ((NewWord >> I) & 1)
+        Out[BitNo / 8] |= Mask;
+      else
+        Out[BitNo / 8] &= ~Mask;
+    }
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
@@ -42,7 +42,15 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    // Function summaries, either nested in a module block or at the top level
+    // of a combined index file.
+    FUNCTION_SUMMARY_BLOCK_ID,
+
+    // The symbol table of the module, at the top level after the module
+    // block. See BitcodeSymbolTable.h.
+    SYMTAB_BLOCK_ID
   };
 
 
@@ -167,6 +175,8 @@ namespace bitc {
     METADATA_EXPRESSION    = 29,  // [distinct, n x element]
     METADATA_OBJC_PROPERTY = 30,  // [distinct, name, file, line, ...]
     METADATA_IMPORTED_ENTITY=31,  // [distinct, tag, scope, entity, line, name]
+    METADATA_INDEX_OFFSET  = 32,  // [offset low 32 bits, offset high 32 bits]
+    METADATA_INDEX         = 33,  // [n x bitpos delta, named bitpos delta]
   };
 
   // The constants block (CONSTANTS_BLOCK_ID) describes emission for each
@@ -406,6 +416,23 @@ namespace bitc {
     ATTR_KIND_CONVERGENT = 43
   };
 
+  /// FUNCTION_SUMMARY blocks describe the function definitions of one or more
+  /// modules, for use by summary-based cross-module optimization.
+  enum FunctionSummaryCodes {
+    // ENTRY: [instcount, flags, entrycount, namechar x N]
+    FS_CODE_ENTRY = 1,
+    // MODULE_PATH: [modid, namechar x N]
+    FS_CODE_MODULE_PATH = 2,
+    // COMBINED_ENTRY: [modid, instcount, flags, entrycount, namechar x N]
+    FS_CODE_COMBINED_ENTRY = 3
+  };
+
+  /// SYMTAB blocks hold the symbol table of a module as a blob, so that it can
+  /// be used where it lies.
+  enum SymtabCodes {
+    SYMTAB_BLOB = 1  // BLOB: [blob]
+  };
+
   enum ComdatSelectionKindCodes {
     COMDAT_SELECTION_KIND_ANY = 1,
     COMDAT_SELECTION_KIND_EXACT_MATCH = 2,
@@ -0,0 +1,83 @@
+//===-- llvm/CodeGen/CodeGenCache.h - Code generation cache -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares CodeGenCache, a content-addressed on-disk cache of the
+// output of the code generator, which lets incremental builds skip code
+// generation for modules that did not change.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_CODEGENCACHE_H
+#define LLVM_CODEGEN_CODEGENCACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Target/TargetMachine.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+
+class MemoryBuffer;
+class Module;
+
+/// \brief A directory of code generator outputs, keyed by a hash of
+/// everything that determines them.
+///
+/// The cache can be shared by concurrent processes: entries are written to a
+/// temporary file and renamed into place, so readers never see a partial
+/// entry, and pruning is serialized with a LockFileManager. Caches whose
+/// entries have different name prefixes can share a directory, as each one
+/// only reads and prunes its own entries.
+class CodeGenCache {
+  std::string Dir;
+  std::string EntryPrefix;
+
+public:
+  /// Create a cache in directory Dir, which is created on demand. The names of
+  /// its entries start with EntryPrefix.
+  explicit CodeGenCache(StringRef Dir, StringRef EntryPrefix = "llvmcache-")
+      : Dir(Dir), EntryPrefix(EntryPrefix) {}
+
+  /// Compute the part of a key that describes the code generator: the target
+  /// triple, CPU, features, relocation and code models, optimization level
+  /// and TargetOptions of TM, and the version of LLVM.
+  static std::string computeTargetKey(const TargetMachine &TM);
+
+  /// Compute the key of the output of generating code for M with TM.
+  ///
+  /// The key covers the bitcode and identifier of M, the target key of TM
+  /// (see computeTargetKey), and the file type. ExtraArgs should contain any
+  /// other setting that affects the output, such as the command-line options
+  /// of the code generator.
+  static std::string computeKey(const Module &M, const TargetMachine &TM,
+                                TargetMachine::CodeGenFileType FileType,
+                                ArrayRef<std::string> ExtraArgs = None);
+
+  /// Get the path of the file that holds (or would hold) the entry for Key.
+  void getEntryPath(StringRef Key, SmallVectorImpl<char> &Path) const;
+
+  /// Return the entry for Key, or null if there is none. This marks the
+  /// entry as recently used.
+  std::unique_ptr<MemoryBuffer> lookup(StringRef Key) const;
+
+  /// Add Data to the cache under Key. Returns true on success; failing to
+  /// write to the cache is not otherwise an error.
+  bool store(StringRef Key, StringRef Data) const;
+
+  /// Remove the least recently used entries until the cache uses at most
+  /// MaxSize bytes, and return the number of entries removed. This does
+  /// nothing if MaxSize is 0, or if another process is already pruning the
+  /// directory.
+  unsigned prune(uint64_t MaxSize) const;
+};
+
+} // End llvm namespace
+
+#endif
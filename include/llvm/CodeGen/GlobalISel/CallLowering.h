@@ -0,0 +1,79 @@
+//===-- llvm/CodeGen/GlobalISel/CallLowering.h - Call lowering --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file describes how the global instruction selector lowers the
+/// arguments and the return value of a function, and the calls it makes, for
+/// a target.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+#define LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+
+#include "llvm/ADT/ArrayRef.h"
+
+namespace llvm {
+
+class CallInst;
+class Function;
+class MachineIRBuilder;
+class TargetLowering;
+class Value;
+
+/// \brief Target hooks of the IR translator for the parts of the calling
+/// convention that can't be described with generic opcodes.
+class CallLowering {
+  const TargetLowering *TLI;
+
+protected:
+  const TargetLowering *getTLI() const { return TLI; }
+
+public:
+  CallLowering(const TargetLowering *TLI) : TLI(TLI) {}
+  virtual ~CallLowering() {}
+
+  /// Copy the incoming arguments of \p F into \p VRegs, which holds one
+  /// virtual register for each argument, at the insertion point of
+  /// \p MIRBuilder in the entry block.
+  ///
+  /// \return false if the arguments can't be lowered, e.g. because some of
+  /// them are passed on the stack.
+  virtual bool lowerFormalArguments(MachineIRBuilder &MIRBuilder,
+                                    const Function &F,
+                                    ArrayRef<unsigned> VRegs) const {
+    return false;
+  }
+
+  /// Emit the return of \p Val, which lives in \p VReg, at the insertion
+  /// point of \p MIRBuilder. \p Val is null for a return without a value.
+  ///
+  /// \return false if the return can't be lowered.
+  virtual bool lowerReturn(MachineIRBuilder &MIRBuilder, const Value *Val,
+                           unsigned VReg) const {
+    return false;
+  }
+
+  /// Emit the call \p CI at the insertion point of \p MIRBuilder. \p Callee
+  /// holds the address of the callee for an indirect call, and is 0 if
+  /// \p CI calls a function directly. \p ArgVRegs holds one virtual register
+  /// for each argument, and the result goes in \p ResVReg unless \p CI
+  /// returns void.
+  ///
+  /// \return false if the call can't be lowered.
+  virtual bool lowerCall(MachineIRBuilder &MIRBuilder, const CallInst &CI,
+                         unsigned Callee, unsigned ResVReg,
+                         ArrayRef<unsigned> ArgVRegs) const {
+    return false;
+  }
+};
+
+} // End namespace llvm.
+
+#endif
@@ -0,0 +1,40 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelector.h -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the interface of the targets to the last stage of the
+/// global instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+#define LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+
+namespace llvm {
+
+class MachineInstr;
+
+/// \brief Replaces the generic instructions of a legalized function with
+/// target instructions.
+class InstructionSelector {
+public:
+  virtual ~InstructionSelector() {}
+
+  /// Replace the generic instruction \p I with equivalent target
+  /// instructions, inserted in its place, and erase it. The registers \p I
+  /// defines must keep their values; their register classes may be narrowed.
+  ///
+  /// \return false if \p I can't be selected, in which case the function is
+  /// left in an unspecified state.
+  virtual bool select(MachineInstr &I) const = 0;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -0,0 +1,86 @@
+//===-- llvm/CodeGen/GlobalISel/MachineIRBuilder.h - MIBuilder --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the MachineIRBuilder class, which the passes of the
+/// global instruction selector use to create MachineInstrs.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_MACHINEIRBUILDER_H
+#define LLVM_CODEGEN_GLOBALISEL_MACHINEIRBUILDER_H
+
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/IR/DebugLoc.h"
+
+namespace llvm {
+
+class MachineFunction;
+class TargetInstrInfo;
+
+/// \brief Helper class to build MachineInstrs at an insertion point, much like
+/// IRBuilder does for LLVM IR.
+class MachineIRBuilder {
+  MachineFunction *MF;
+  const TargetInstrInfo *TII;
+  MachineBasicBlock *MBB;
+  /// The instruction to insert before, or the end of MBB.
+  MachineBasicBlock::iterator II;
+  /// The debug location of the instructions that are built.
+  DebugLoc DL;
+
+public:
+  MachineIRBuilder() : MF(nullptr), TII(nullptr), MBB(nullptr) {}
+
+  /// Start building instructions for \p NewMF. The insertion point must be set
+  /// before anything is built.
+  void setMF(MachineFunction &NewMF);
+
+  MachineFunction &getMF() {
+    assert(MF && "MachineFunction is not set");
+    return *MF;
+  }
+
+  MachineBasicBlock &getMBB() {
+    assert(MBB && "MachineBasicBlock is not set");
+    return *MBB;
+  }
+
+  MachineBasicBlock::iterator getInsertPt() { return II; }
+
+  /// Insert at the beginning or at the end of \p NewMBB.
+  void setMBB(MachineBasicBlock &NewMBB, bool Beginning = false);
+
+  /// Insert before or after \p MI, in the block of \p MI.
+  void setInstr(MachineInstr &MI, bool Before = true);
+
+  void setDebugLoc(DebugLoc NewDL) { DL = NewDL; }
+  DebugLoc getDebugLoc() const { return DL; }
+
+  /// Build an instruction with opcode \p Opcode and no operands. It is
+  /// inserted at the insertion point, and the insertion point is left after
+  /// it.
+  MachineInstrBuilder buildInstr(unsigned Opcode);
+
+  /// Build an instruction \p Opcode that defines \p Res.
+  MachineInstrBuilder buildInstr(unsigned Opcode, unsigned Res);
+
+  /// Build the binary operation \p Res = \p Opcode \p Op0, \p Op1.
+  MachineInstrBuilder buildInstr(unsigned Opcode, unsigned Res, unsigned Op0,
+                                 unsigned Op1);
+
+  /// Build a COPY of \p Op into \p Res. Either of them may be a physical
+  /// register.
+  MachineInstrBuilder buildCopy(unsigned Res, unsigned Op);
+};
+
+} // End namespace llvm.
+
+#endif
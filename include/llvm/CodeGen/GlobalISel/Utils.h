@@ -0,0 +1,32 @@
+//===-- llvm/CodeGen/GlobalISel/Utils.h - GlobalISel utilities --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the helpers shared by the passes of the global
+/// instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_UTILS_H
+#define LLVM_CODEGEN_GLOBALISEL_UTILS_H
+
+namespace llvm {
+
+class MachineFunction;
+class Twine;
+
+/// Give up on selecting \p MF with the global instruction selector because of
+/// \p Reason. Everything that was built for \p MF is erased, so that the
+/// SelectionDAG instruction selector starts from scratch. With
+/// -global-isel-abort, this is a fatal error instead.
+void fallBackToSelectionDAG(MachineFunction &MF, const Twine &Reason);
+
+} // End namespace llvm.
+
+#endif
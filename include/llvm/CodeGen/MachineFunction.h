@@ -145,6 +145,10 @@ class MachineFunction {
   /// True if the function includes any inline assembly.
   bool HasInlineAsm;
 
+  /// True once the instructions of the function have been selected by the
+  /// global instruction selector, which runs before the SelectionDAG one.
+  bool Selected;
+
   MachineFunction(const MachineFunction &) = delete;
   void operator=(const MachineFunction&) = delete;
 public:
@@ -249,6 +253,16 @@ public:
     HasInlineAsm = B;
   }
 
+  /// Returns true if the instructions of the function have already been
+  /// selected, so that the SelectionDAG instruction selector must skip it.
+  bool isSelected() const {
+    return Selected;
+  }
+
+  void setSelected(bool B) {
+    Selected = B;
+  }
+
   /// getInfo - Keep track of various per-function pieces of information for
   /// backends that would like to do so.
   ///
@@ -0,0 +1,50 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace llvm {
+
+class Module;
+class TargetOptions;
+class raw_pwrite_stream;
+
+/// Split M into OSs.size() partitions, and generate code for each partition in
+/// parallel on a pool of ThreadCount threads (one thread per partition if
+/// ThreadCount is 0), writing the output of partition I to *OSs[I]. Each
+/// partition is code generated in its own LLVMContext, whose diagnostics are
+/// reported, one at a time, through the context of M.
+///
+/// The assignment of globals to partitions only depends on M and on the number
+/// of partitions, so the output does not depend on ThreadCount or on the order
+/// in which the threads happen to run.
+///
+/// If OSs.size() == 1, M is code generated as is on the calling thread.
+/// Otherwise M is left with its local symbols externalized by SplitModule.
+void splitCodeGen(Module &M, ArrayRef<raw_pwrite_stream *> OSs, StringRef CPU,
+                  StringRef Features, const TargetOptions &Options,
+                  Reloc::Model RM = Reloc::Default,
+                  CodeModel::Model CM = CodeModel::Default,
+                  CodeGenOpt::Level OL = CodeGenOpt::Default,
+                  TargetMachine::CodeGenFileType FT =
+                      TargetMachine::CGFT_ObjectFile,
+                  unsigned ThreadCount = 0);
+
+} // namespace llvm
+
+#endif
@@ -204,6 +204,11 @@ public:
   /// instruction selection.
   virtual void addISelPrepare();
 
+  /// Add the passes of the global instruction selector. They select whole
+  /// functions before the instruction selector of addInstSelector, which then
+  /// only handles the functions that they couldn't.
+  void addGlobalInstructionSelect();
+
   /// addInstSelector - This method should install an instruction selector pass,
   /// which converts from LLVM code to machine instructions.
   virtual bool addInstSelector() {
@@ -599,6 +604,18 @@ namespace llvm {
   /// pointer or stack pointer index addressing.
   extern char &LocalStackSlotAllocationID;
 
+  /// IRTranslator - This pass translates LLVM IR into generic machine
+  /// instructions for the global instruction selector.
+  extern char &IRTranslatorID;
+
+  /// MachineLegalizePass - This pass rewrites the generic machine instructions
+  /// that the target can't select.
+  extern char &MachineLegalizePassID;
+
+  /// InstructionSelect - This pass replaces the generic machine instructions
+  /// with target instructions.
+  extern char &InstructionSelectID;
+
   /// ExpandISelPseudos - This pass expands pseudo-instructions.
   extern char &ExpandISelPseudosID;
 
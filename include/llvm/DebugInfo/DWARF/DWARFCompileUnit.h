@@ -21,7 +21,9 @@ public:
                    StringRef SOS, StringRef AOS, bool LE,
                    const DWARFUnitSectionBase &UnitSection)
       : DWARFUnit(Context, Section, DA, RS, SS, SOS, AOS, LE, UnitSection) {}
-  void dump(raw_ostream &OS);
+  /// Dump the unit header and its DIEs. With \p Streaming, the DIEs are
+  /// printed as they are decoded rather than extracted first.
+  void dump(raw_ostream &OS, bool Streaming = false);
   // VTable anchor.
   ~DWARFCompileUnit() override;
 };
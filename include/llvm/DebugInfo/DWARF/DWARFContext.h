@@ -77,7 +77,16 @@ public:
     return DICtx->getKind() == CK_DWARF;
   }
 
-  void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) override;
+  void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) override {
+    dump(OS, DumpType, /*StreamUnits=*/false);
+  }
+
+  /// Dump the selected sections. With \p StreamUnits, the DIEs of
+  /// .debug_info and .debug_types units (and their .dwo counterparts) are
+  /// printed as they are decoded instead of being extracted and kept, so
+  /// peak memory does not grow with the size of those sections. The output
+  /// is identical either way.
+  void dump(raw_ostream &OS, DIDumpType DumpType, bool StreamUnits);
 
   typedef DWARFUnitSection<DWARFCompileUnit>::iterator_range cu_iterator_range;
   typedef DWARFUnitSection<DWARFTypeUnit>::iterator_range tu_iterator_range;
@@ -164,6 +173,14 @@ public:
   /// Get a pointer to a parsed line table corresponding to a compile unit.
   const DWARFDebugLine::LineTable *getLineTableForUnit(DWARFUnit *cu);
 
+  /// Extract the DIEs of all compile and type units and parse the line tables
+  /// of all compile units, using up to \p NumThreads threads (0 selects the
+  /// hardware concurrency). Afterwards the context is in the same state as if
+  /// the lazy accessors had been called on every unit, so later queries
+  /// return identical results without parsing anything. Must not be called
+  /// while other threads are using this context.
+  void parseAllUnits(unsigned NumThreads = 0);
+
   DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
   DILineInfoTable getLineInfoForAddressRange(uint64_t Address, uint64_t Size,
@@ -207,13 +224,13 @@ public:
   static bool isSupportedVersion(unsigned version) {
     return version == 2 || version == 3 || version == 4;
   }
-private:
-  /// Return the compile unit that includes an offset (relative to .debug_info).
-  DWARFCompileUnit *getCompileUnitForOffset(uint32_t Offset);
-
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
+
+private:
+  /// Return the compile unit that includes an offset (relative to .debug_info).
+  DWARFCompileUnit *getCompileUnitForOffset(uint32_t Offset);
 };
 
 /// DWARFContextInMemory is the simplest possible implementation of a
@@ -10,6 +10,7 @@
 #ifndef LLVM_LIB_DEBUGINFO_DWARFDEBUGLINE_H
 #define LLVM_LIB_DEBUGINFO_DWARFDEBUGLINE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFRelocMap.h"
 #include "llvm/Support/DataExtractor.h"
@@ -20,6 +21,7 @@
 namespace llvm {
 
 class raw_ostream;
+class ThreadPool;
 
 class DWARFDebugLine {
 public:
@@ -224,6 +226,15 @@ public:
   const LineTable *getOrParseLineTable(DataExtractor debug_line_data,
                                        uint32_t offset);
 
+  /// Parse and cache the line tables at each of the given offsets, running
+  /// the parses concurrently on \p Pool. Each offset is paired with the
+  /// address size to parse it with. Tables that are already cached are left
+  /// alone; tables that fail to parse are not cached, so a later
+  /// getOrParseLineTable() call behaves as if this was never called.
+  void parseLineTables(ThreadPool &Pool, StringRef DebugLineData,
+                       bool IsLittleEndian,
+                       ArrayRef<std::pair<uint32_t, uint8_t>> Tables);
+
 private:
   struct ParsingState {
     ParsingState(struct LineTable *LT);
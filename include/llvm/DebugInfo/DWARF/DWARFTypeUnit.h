@@ -27,7 +27,9 @@ public:
   uint32_t getHeaderSize() const override {
     return DWARFUnit::getHeaderSize() + 12;
   }
-  void dump(raw_ostream &OS);
+  /// Dump the unit header and its DIEs. With \p Streaming, the DIEs are
+  /// printed as they are decoded rather than extracted first.
+  void dump(raw_ostream &OS, bool Streaming = false);
 protected:
   bool extractImpl(DataExtractor debug_info, uint32_t *offset_ptr) override;
 };
@@ -238,6 +238,13 @@ public:
     return &DieArray[Index];
   }
 
+  /// \brief Dump the DIE tree of this unit exactly as
+  /// getUnitDIE(false)->dump(OS, this, -1U) would, but decode and print one
+  /// DIE at a time instead of extracting them all first, so memory use does
+  /// not grow with the size of the unit. Returns false if the unit DIE can't
+  /// be parsed.
+  bool dumpDIEsStreaming(raw_ostream &OS);
+
   /// \brief Return the DIE object for a given offset inside the
   /// unit's DIE vector.
   ///
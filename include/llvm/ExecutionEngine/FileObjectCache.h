@@ -0,0 +1,93 @@
+//===- FileObjectCache.h - Persistent on-disk object cache ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of an ObjectCache that keeps the objects
+// compiled by the JIT in a directory, so that they can be reused across runs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+#define LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/CodeGen/CodeGenCache.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include <mutex>
+#include <string>
+
+namespace llvm {
+
+class TargetMachine;
+
+/// An ObjectCache that stores objects as files in a cache directory.
+///
+/// Objects are keyed by a hash of the module's contents together with the
+/// target key of the TargetMachine that compiles them (see
+/// CodeGenCache::computeTargetKey). A cached object is therefore only reused
+/// for a module that would compile to the same code; the module identifier
+/// plays no part.
+///
+/// The objects are the entries of a CodeGenCache whose names start with
+/// "llvmobjcache-", so the directory may also hold the entries of other
+/// CodeGenCaches. If a size limit is given, the least recently used objects
+/// are removed whenever a new object is written and the cache exceeds the
+/// limit.
+///
+/// The cache can be shared by MCJIT (ExecutionEngine::setObjectCache) and by
+/// Orc's IRCompileLayer (IRCompileLayer::setObjectCache), and may be used
+/// from several threads and processes at once. Use one cache per
+/// TargetMachine; caches for different TargetMachines may share a directory.
+///
+/// Modules that are still being materialized lazily, or that refer to globals
+/// in other modules, are not cached.
+class FileObjectCache : public ObjectCache {
+  FileObjectCache(const FileObjectCache&) = delete;
+  void operator=(const FileObjectCache&) = delete;
+
+public:
+  /// Create a cache for objects compiled by \p TM in \p CacheDir, which is
+  /// created if it does not exist. If \p SizeLimit is non-zero the objects in
+  /// the directory are kept below that many bytes.
+  FileObjectCache(StringRef CacheDir, const TargetMachine &TM,
+                  uint64_t SizeLimit = 0);
+  ~FileObjectCache() override;
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override;
+
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override;
+
+  /// Remove the least recently used objects until the cache is within its
+  /// size limit. Does nothing if the cache has no size limit.
+  void prune();
+
+  /// Get the path of the file that holds (or would hold) the object for
+  /// \p M.
+  std::string getObjectPath(const Module &M) const;
+
+  StringRef getCacheDir() const { return CacheDir; }
+  uint64_t getSizeLimit() const { return SizeLimit; }
+
+private:
+  std::string computeKey(const Module &M) const;
+
+  std::string CacheDir;
+  CodeGenCache Cache;
+  // The target key of the TargetMachine, hashed into every key.
+  std::string TargetKey;
+  uint64_t SizeLimit;
+
+  // Compilation may change a module, so the key computed by getObject for a
+  // module that missed is remembered until its object is written.
+  std::mutex PendingKeysMutex;
+  DenseMap<const Module*, std::string> PendingKeys;
+};
+
+}
+
+#endif // LLVM_EXECUTIONENGINE_FILEOBJECTCACHE_H
@@ -18,10 +18,19 @@
 //#include "CloneSubModule.h"
 #include "IndirectionUtils.h"
 #include "LambdaResolver.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include <atomic>
+#include <condition_variable>
 #include <list>
+#include <mutex>
 #include <set>
 
 #include "llvm/Support/Debug.h"
@@ -36,6 +45,18 @@ namespace orc {
 /// added to the layer below. When a stub is called it triggers the extraction
 /// of the function body from the original module. The extracted body is then
 /// compiled and executed.
+///
+///   If the layer is constructed with speculation threads, then each time a
+/// function is compiled on demand, the functions it calls directly are
+/// compiled on those threads in the background, so they are likely to be
+/// ready by the time they are first called. Each partition is then compiled
+/// in an LLVMContext of its own, so the layer lock is only held while a
+/// partition is extracted from its source module and while its stubs are
+/// updated, and compile callbacks may be triggered from any thread. Calls into
+/// the layer below, which need not be thread-safe, are serialized by a
+/// separate lock. That context is destroyed as soon as the partition has been
+/// added to the layer below, so the layer below must compile the modules it
+/// is given without keeping them past addModuleSet, like IRCompileLayer.
 template <typename BaseLayerT, typename CompileCallbackMgrT>
 class CompileOnDemandLayer {
 private:
@@ -96,7 +117,6 @@ private:
     typedef std::list<LogicalModule> LogicalModuleList;
   public:
 
-    typedef unsigned UncompiledPartitionID;
     typedef typename LogicalModuleList::iterator LMHandle;
 
     // Construct a logical dylib.
@@ -139,9 +159,29 @@ private:
     UncompiledPartition& createUncompiledPartition(LMHandle LMH,
                                                    std::shared_ptr<Module> SrcM);
 
-    // Take ownership of the given UncompiledPartition from the logical dylib.
-    std::unique_ptr<UncompiledPartition>
-    takeUPOwnership(UncompiledPartitionID ID);
+    // Record that F will be compiled as part of UP.
+    void setPartitionFor(const Function &F, UncompiledPartition &UP) {
+      PartitionsByFunction[&F] = &UP;
+    }
+
+    // Return the partition that F will be compiled in, or null if F has
+    // already been compiled.
+    UncompiledPartition* getPartitionFor(const Function &F) {
+      return PartitionsByFunction.lookup(&F);
+    }
+
+    // Forget the partition for F, once F has been compiled.
+    void clearPartitionFor(const Function &F) {
+      PartitionsByFunction.erase(&F);
+    }
+
+    // Compile the partition containing F ahead of its first call, if it hasn't
+    // been compiled yet.
+    void speculate(const Function &F) {
+      std::unique_lock<std::mutex> Lock(CODLayer.LayerMutex);
+      if (UncompiledPartition *UP = getPartitionFor(F))
+        UP->emit(Lock);
+    }
 
     // Look up a symbol in this context.
     JITSymbol findSymbolInternally(LMHandle LMH, const std::string &Name) {
@@ -185,6 +225,7 @@ private:
 
     CompileOnDemandLayer &CODLayer;
     LogicalModuleList LogicalModules;
+    DenseMap<const Function*, UncompiledPartition*> PartitionsByFunction;
     std::vector<std::unique_ptr<UncompiledPartition>> UncompiledPartitions;
   };
 
@@ -213,107 +254,155 @@ private:
 
   // Uncompiled partition.
   //
-  // Represents one as-yet uncompiled portion of a module.
+  // Represents one as-yet uncompiled portion of a module. Once compiled, the
+  // partition stays around until its logical dylib is removed, so that
+  // callbacks racing with a background compile can still be answered.
   class UncompiledPartition {
   public:
 
     struct PartitionEntry {
       PartitionEntry(Function *F, TargetAddress CallbackID)
-          : F(F), CallbackID(CallbackID) {}
+          : F(F), CallbackID(CallbackID), BodyAddr(0) {}
       Function *F;
       TargetAddress CallbackID;
+      TargetAddress BodyAddr;
     };
 
     typedef std::vector<PartitionEntry> PartitionEntryList;
 
+    enum EmitState { NotEmitted, Emitting, Emitted };
+
     // Creates an uncompiled partition with the list of functions that make up
     // this partition.
     UncompiledPartition(LogicalDylib &LD, typename LogicalDylib::LMHandle LMH,
                         std::shared_ptr<Module> SrcM)
-        : LD(LD), LMH(LMH), SrcM(std::move(SrcM)), ID(~0U) {}
+        : LD(LD), LMH(LMH), SrcM(std::move(SrcM)), State(NotEmitted) {}
 
     ~UncompiledPartition() {
-      // FIXME: When we want to support threaded lazy compilation we'll need to
-      //        lock the callback manager here.
+      // Release the callbacks that never ran. (The callback manager has
+      // already removed the ones that did.)
       auto &CCMgr = LD.getCODLayer().CompileCallbackMgr;
       for (auto PEntry : PartitionEntries)
-        CCMgr.releaseCompileCallback(PEntry.CallbackID);
-    }
-
-    // Set the ID for this partition.
-    void setID(typename LogicalDylib::UncompiledPartitionID ID) {
-      this->ID = ID;
+        if (PEntry.CallbackID)
+          CCMgr.releaseCompileCallback(PEntry.CallbackID);
     }
 
     // Set the function set and callbacks for this partition.
     void setPartitionEntries(PartitionEntryList PartitionEntries) {
       this->PartitionEntries = std::move(PartitionEntries);
+      for (auto &PEntry : this->PartitionEntries)
+        LD.setPartitionFor(*PEntry.F, *this);
     }
 
     // Handle a compile callback for the function at index FnIdx.
     TargetAddress compile(unsigned FnIdx) {
-      // Take ownership of self. This will ensure we delete the partition and
-      // free all its resources once we're done compiling.
-      std::unique_ptr<UncompiledPartition> This = LD.takeUPOwnership(ID);
+      auto &CODLayer = LD.getCODLayer();
+      std::unique_lock<std::mutex> Lock(CODLayer.LayerMutex);
+
+      // The callback manager removed the callback that called us.
+      PartitionEntries[FnIdx].CallbackID = 0;
+
+      if (State == NotEmitted) {
+        // Look for callees worth compiling ahead of time before the bodies
+        // are moved out of the source module.
+        std::vector<const Function*> Callees = findSpeculationCandidates();
+        emit(Lock);
+        CODLayer.speculate(LD, std::move(Callees));
+      }
 
-      // Release all other compile callbacks for this partition.
-      // We skip the callback for this function because that's the one that
-      // called us, and the callback manager will already have removed it.
-      auto &CCMgr = LD.getCODLayer().CompileCallbackMgr;
-      for (unsigned I = 0; I < PartitionEntries.size(); ++I)
-        if (I != FnIdx)
-          CCMgr.releaseCompileCallback(PartitionEntries[I].CallbackID);
+      // The partition may be being compiled speculatively on another thread,
+      // in which case wait for its bodies to be published.
+      CODLayer.PartitionEmitted.wait(Lock,
+                                     [this]() { return State == Emitted; });
+      return PartitionEntries[FnIdx].BodyAddr;
+    }
 
-      // Grab the name of the function being called here.
-      Function *F = PartitionEntries[FnIdx].F;
-      std::string CalledFnName = Mangle(F->getName(), SrcM->getDataLayout());
+    // Compile this partition and point its stubs at the compiled bodies.
+    //
+    //   Lock must hold the layer lock. With speculation enabled it is released
+    // while the partition is compiled in a context of its own.
+    void emit(std::unique_lock<std::mutex> &Lock) {
+      assert(State == NotEmitted && "Partition is already being emitted.");
+      State = Emitting;
+      for (auto &PEntry : PartitionEntries)
+        LD.clearPartitionFor(*PEntry.F);
 
-      // Extract the function and add it to the base layer.
-      auto PartitionImplH = emitPartition();
-      LD.addToLogicalModule(LMH, PartitionImplH);
+      auto &CODLayer = LD.getCODLayer();
+      std::unique_ptr<Module> PM = extractPartition();
+      std::vector<TargetAddress> FnPtrAddrs;
+
+      // The source functions go away with the last reference to SrcM.
+      std::vector<std::string> FNames;
+      for (auto &PEntry : PartitionEntries)
+        FNames.push_back(PEntry.F->getName());
+
+      if (CODLayer.SpeculationPool) {
+        // Other threads may be extracting partitions from modules in SrcM's
+        // context, so move this partition to a context of its own before
+        // compiling it without the lock.
+        SmallVector<char, 0> Bitcode;
+        {
+          raw_svector_ostream BitcodeOS(Bitcode);
+          WriteBitcodeToFile(PM.get(), BitcodeOS);
+        }
+        std::string Name = PM->getModuleIdentifier();
+        PM.reset();
+        SrcM.reset();
+        Lock.unlock();
+
+        // The base layer is done with the partition once it has been added,
+        // so the context goes away with it.
+        LLVMContext Context;
+        auto PMOrErr =
+          parseBitcodeFile(MemoryBufferRef(StringRef(Bitcode.data(),
+                                                     Bitcode.size()), Name),
+                           Context);
+        if (!PMOrErr)
+          report_fatal_error("Couldn't reload partition " + Name + ": " +
+                             PMOrErr.getError().message());
+        FnPtrAddrs = addPartition(std::unique_ptr<Module>(*PMOrErr), FNames);
+        Lock.lock();
+      } else {
+        FnPtrAddrs = addPartition(std::move(PM), FNames);
+        SrcM.reset();
+      }
 
       // Update body pointers.
       // FIXME: When we start supporting remote lazy jitting this will need to
       //        be replaced with a user-supplied callback for updating the
       //        remote pointers.
-      TargetAddress CalledAddr = 0;
-      for (unsigned I = 0; I < PartitionEntries.size(); ++I) {
-        auto F = PartitionEntries[I].F;
-        std::string FName(F->getName());
-        auto FnBodySym =
-          LD.getBaseLayer().findSymbolIn(PartitionImplH,
-                                         Mangle(FName, SrcM->getDataLayout()),
-                                         false);
-        auto FnPtrSym =
-          LD.getBaseLayer().findSymbolIn(LD.getGVsAndStubsHandle(LMH),
-                                         Mangle(FName + "$orc_addr",
-                                                SrcM->getDataLayout()),
-                                         false);
-        assert(FnBodySym && "Couldn't find function body.");
-        assert(FnPtrSym && "Couldn't find function body pointer.");
-
-        auto FnBodyAddr = FnBodySym.getAddress();
-        void *FnPtrAddr = reinterpret_cast<void*>(
-                            static_cast<uintptr_t>(FnPtrSym.getAddress()));
-
-        // If this is the function we're calling record the address so we can
-        // return it from this function.
-        if (I == FnIdx)
-          CalledAddr = FnBodyAddr;
-
-        memcpy(FnPtrAddr, &FnBodyAddr, sizeof(uintptr_t));
-      }
-
-      // Finally, clear the partition structure so we don't try to
-      // double-release the callbacks in the UncompiledPartition destructor.
-      PartitionEntries.clear();
-
-      return CalledAddr;
+      for (unsigned I = 0, E = PartitionEntries.size(); I != E; ++I)
+        CODLayer.setBodyPointer(FnPtrAddrs[I], PartitionEntries[I].BodyAddr);
+      State = Emitted;
+      CODLayer.PartitionEmitted.notify_all();
     }
 
   private:
 
-    BaseLayerModuleSetHandleT emitPartition() {
+    // Collect the not-yet-compiled functions that this partition calls
+    // directly.
+    std::vector<const Function*> findSpeculationCandidates() {
+      std::vector<const Function*> Callees;
+      if (!LD.getCODLayer().SpeculationPool)
+        return Callees;
+      std::set<const Function*> Seen;
+      for (auto &PEntry : PartitionEntries)
+        for (auto &I : inst_range(PEntry.F)) {
+          CallSite CS(&I);
+          if (!CS)
+            continue;
+          const Function *Callee = CS.getCalledFunction();
+          if (Callee && LD.getPartitionFor(*Callee) &&
+              LD.getPartitionFor(*Callee) != this &&
+              Seen.insert(Callee).second)
+            Callees.push_back(Callee);
+        }
+      return Callees;
+    }
+
+    // Move the bodies of this partition's functions into a new module, which
+    // refers to everything else through declarations.
+    std::unique_ptr<Module> extractPartition() {
       // Create the module.
       std::string NewName(SrcM->getName());
       for (auto &PEntry : PartitionEntries) {
@@ -331,7 +420,26 @@ private:
 
       // Move the function bodies.
       for (auto &PEntry : PartitionEntries)
-        moveFunctionBody(*PEntry.F, VMap);
+        moveFunctionBody(*PEntry.F, VMap, &GDM);
+
+      return PM;
+    }
+
+    // Add the extracted partition PM to the base layer. FNames are the names
+    // of the partition's functions. Records the address of each compiled
+    // body, and returns the addresses of the body pointers in the same order.
+    std::vector<TargetAddress>
+    addPartition(std::unique_ptr<Module> PM,
+                 const std::vector<std::string> &FNames) {
+      auto &CODLayer = LD.getCODLayer();
+      std::lock_guard<std::recursive_mutex> Lock(CODLayer.BaseLayerMutex);
+
+      std::vector<std::pair<std::string, std::string>> Names;
+      for (auto &FName : FNames) {
+        Names.push_back(
+          std::make_pair(Mangle(FName, PM->getDataLayout()),
+                         Mangle(FName + "$orc_addr", PM->getDataLayout())));
+      }
 
       // Create memory manager and symbol resolver.
       auto MemMgr = llvm::make_unique<SectionMemoryManager>();
@@ -350,15 +458,31 @@ private:
           });
       std::vector<std::unique_ptr<Module>> PartMSet;
       PartMSet.push_back(std::move(PM));
-      return LD.getBaseLayer().addModuleSet(std::move(PartMSet),
-                                            std::move(MemMgr),
-                                            std::move(Resolver));
+      auto PartitionImplH =
+        LD.getBaseLayer().addModuleSet(std::move(PartMSet),
+                                       std::move(MemMgr),
+                                       std::move(Resolver));
+      LD.addToLogicalModule(LMH, PartitionImplH);
+
+      std::vector<TargetAddress> FnPtrAddrs;
+      for (unsigned I = 0, E = PartitionEntries.size(); I != E; ++I) {
+        auto FnBodySym =
+          LD.getBaseLayer().findSymbolIn(PartitionImplH, Names[I].first, false);
+        auto FnPtrSym =
+          LD.getBaseLayer().findSymbolIn(LD.getGVsAndStubsHandle(LMH),
+                                         Names[I].second, false);
+        assert(FnBodySym && "Couldn't find function body.");
+        assert(FnPtrSym && "Couldn't find function body pointer.");
+        PartitionEntries[I].BodyAddr = FnBodySym.getAddress();
+        FnPtrAddrs.push_back(FnPtrSym.getAddress());
+      }
+      return FnPtrAddrs;
     }
 
     LogicalDylib &LD;
     typename LogicalDylib::LMHandle LMH;
     std::shared_ptr<Module> SrcM;
-    typename LogicalDylib::UncompiledPartitionID ID;
+    EmitState State;
     PartitionEntryList PartitionEntries;
   };
 
@@ -369,8 +493,24 @@ public:
   typedef typename LogicalDylibList::iterator ModuleSetHandleT;
 
   /// @brief Construct a compile-on-demand layer instance.
-  CompileOnDemandLayer(BaseLayerT &BaseLayer, CompileCallbackMgrT &CallbackMgr)
-      : BaseLayer(BaseLayer), CompileCallbackMgr(CallbackMgr) {}
+  /// @param NumSpeculationThreads Number of threads used to compile the
+  ///        callees of on-demand compiled functions in the background. If
+  ///        zero (or if LLVM was built without threads) functions are only
+  ///        compiled when they are first called.
+  CompileOnDemandLayer(BaseLayerT &BaseLayer, CompileCallbackMgrT &CallbackMgr,
+                       unsigned NumSpeculationThreads = 0)
+      : BaseLayer(BaseLayer), CompileCallbackMgr(CallbackMgr) {
+#if LLVM_ENABLE_THREADS
+    if (NumSpeculationThreads)
+      SpeculationPool = llvm::make_unique<ThreadPool>(NumSpeculationThreads);
+#endif
+  }
+
+  /// @brief Wait for any speculative compiles before tearing down.
+  ~CompileOnDemandLayer() {
+    if (SpeculationPool)
+      SpeculationPool->wait();
+  }
 
   /// @brief Add a module to the compile-on-demand layer.
   template <typename ModuleSetT, typename MemoryManagerPtrT,
@@ -382,6 +522,8 @@ public:
     assert(MemMgr == nullptr &&
            "User supplied memory managers not supported with COD yet.");
 
+    std::lock_guard<std::mutex> Lock(LayerMutex);
+    std::lock_guard<std::recursive_mutex> BaseLock(BaseLayerMutex);
     LogicalDylibs.push_back(createLogicalDylib(*this, std::move(Resolver)));
 
     // Process each of the modules in this module set.
@@ -405,6 +547,11 @@ public:
   ///   This will remove all modules in the layers below that were derived from
   /// the module represented by H.
   void removeModuleSet(ModuleSetHandleT H) {
+    // Speculative compiles refer to the logical dylib; let them finish.
+    if (SpeculationPool)
+      SpeculationPool->wait();
+    std::lock_guard<std::mutex> Lock(LayerMutex);
+    std::lock_guard<std::recursive_mutex> BaseLock(BaseLayerMutex);
     LogicalDylibs.erase(H);
   }
 
@@ -413,18 +560,48 @@ public:
   /// @param ExportedSymbolsOnly If true, search only for exported symbols.
   /// @return A handle for the given named symbol, if it exists.
   JITSymbol findSymbol(StringRef Name, bool ExportedSymbolsOnly) {
-    return BaseLayer.findSymbol(Name, ExportedSymbolsOnly);
+    std::lock_guard<std::recursive_mutex> Lock(BaseLayerMutex);
+    return guardSymbol(BaseLayer.findSymbol(Name, ExportedSymbolsOnly));
   }
 
   /// @brief Get the address of a symbol provided by this layer, or some layer
   ///        below this one.
   JITSymbol findSymbolIn(ModuleSetHandleT H, const std::string &Name,
                          bool ExportedSymbolsOnly) {
-    return (*H)->findSymbol(Name, ExportedSymbolsOnly);
+    std::lock_guard<std::recursive_mutex> Lock(BaseLayerMutex);
+    return guardSymbol((*H)->findSymbol(Name, ExportedSymbolsOnly));
   }
 
 private:
 
+  // Make materializing a symbol from the layer below take the base layer
+  // lock, as it may race with a compile on another thread.
+  JITSymbol guardSymbol(JITSymbol Sym) {
+    if (!Sym)
+      return Sym;
+    JITSymbolFlags Flags = Sym.getFlags();
+    return JITSymbol(
+      [this, Sym]() mutable {
+        std::lock_guard<std::recursive_mutex> Lock(BaseLayerMutex);
+        return Sym.getAddress();
+      },
+      Flags);
+  }
+
+  // Publish a compiled body to its stub. With speculation enabled the stub
+  // may be running on another thread, so the store must not tear.
+  static void setBodyPointer(TargetAddress FnPtrAddr, TargetAddress BodyAddr) {
+    auto *FnPtr = reinterpret_cast<std::atomic<uintptr_t>*>(
+                    static_cast<uintptr_t>(FnPtrAddr));
+    FnPtr->store(static_cast<uintptr_t>(BodyAddr), std::memory_order_release);
+  }
+
+  // Queue the given callees for compilation on the speculation threads.
+  void speculate(LogicalDylib &LD, std::vector<const Function*> Callees) {
+    for (auto *Callee : Callees)
+      SpeculationPool->async([&LD, Callee]() { LD.speculate(*Callee); });
+  }
+
   void addLogicalModule(LogicalDylib &LD, std::shared_ptr<Module> SrcM,
                         std::vector<std::vector<Function*>> Partitions) {
 
@@ -446,6 +623,7 @@ private:
     // We create the stubs before copying the global variables as we know the
     // stubs won't refer to any globals (they only refer to their implementation
     // pointer) so there's no ordering/value-mapping issues.
+    std::vector<std::pair<std::string, TargetAddress>> Callbacks;
     for (auto& Partition : Partitions) {
       auto &UP = LD.createUncompiledPartition(LMH, SrcM);
       typename UncompiledPartition::PartitionEntryList PartitionEntries;
@@ -459,10 +637,11 @@ private:
         Function *StubF = cloneFunctionDecl(*GVsAndStubsM, *F, &VMap);
         GlobalVariable *FnBodyPtr =
           createImplPointer(*StubF->getType(), *StubF->getParent(),
-                            StubF->getName() + "$orc_addr",
-                            createIRTypedAddress(*StubF->getFunctionType(),
-                                                 CCI.getAddress()));
+                            StubF->getName() + "$orc_addr", nullptr);
         makeStub(*StubF, *FnBodyPtr);
+        Callbacks.push_back(
+          std::make_pair(Mangle(FnBodyPtr->getName(), SrcM->getDataLayout()),
+                         CCI.getAddress()));
         CCI.setCompileAction([&UP, FnIdx]() { return UP.compile(FnIdx); });
       }
 
@@ -499,6 +678,16 @@ private:
                              llvm::make_unique<SectionMemoryManager>(),
                              std::move(GVsAndStubsResolver));
     LD.setGVsAndStubsHandle(LMH, GVsAndStubsH);
+
+    // Point the stubs at their compile callbacks. The body pointers start out
+    // null rather than being initialized with the callback addresses, so that
+    // the stubs module doesn't change from run to run and can be cached.
+    for (auto &Callback : Callbacks) {
+      auto FnPtrSym =
+        BaseLayer.findSymbolIn(GVsAndStubsH, Callback.first, false);
+      assert(FnPtrSym && "Couldn't find function body pointer.");
+      setBodyPointer(FnPtrSym.getAddress(), Callback.second);
+    }
   }
 
   static std::string Mangle(StringRef Name, const DataLayout &DL) {
@@ -513,7 +702,16 @@ private:
 
   BaseLayerT &BaseLayer;
   CompileCallbackMgrT &CompileCallbackMgr;
+  // Guards the partitions and the contexts of the source modules. Taken
+  // before BaseLayerMutex when both are needed.
+  std::mutex LayerMutex;
+  // Signalled whenever a partition's bodies have been published.
+  std::condition_variable PartitionEmitted;
+  // Guards the base layer and the logical dylibs' lists of modules in it.
+  // Recursive, as the base layer calls back into the resolvers.
+  std::recursive_mutex BaseLayerMutex;
   LogicalDylibList LogicalDylibs;
+  std::unique_ptr<ThreadPool> SpeculationPool;
 };
 
 template <typename BaseLayerT, typename CompileCallbackMgrT>
@@ -523,23 +721,9 @@ CompileOnDemandLayer<BaseLayerT, CompileCallbackMgrT>::LogicalDylib::
   createUncompiledPartition(LMHandle LMH, std::shared_ptr<Module> SrcM) {
   UncompiledPartitions.push_back(
       llvm::make_unique<UncompiledPartition>(*this, LMH, std::move(SrcM)));
-  UncompiledPartitions.back()->setID(UncompiledPartitions.size() - 1);
   return *UncompiledPartitions.back();
 }
 
-template <typename BaseLayerT, typename CompileCallbackMgrT>
-std::unique_ptr<typename CompileOnDemandLayer<BaseLayerT, CompileCallbackMgrT>::
-                  UncompiledPartition>
-CompileOnDemandLayer<BaseLayerT, CompileCallbackMgrT>::LogicalDylib::
-  takeUPOwnership(UncompiledPartitionID ID) {
-
-  std::swap(UncompiledPartitions[ID], UncompiledPartitions.back());
-  UncompiledPartitions[ID]->setID(ID);
-  auto UP = std::move(UncompiledPartitions.back());
-  UncompiledPartitions.pop_back();
-  return UP;
-}
-
 } // End namespace orc.
 } // End namespace llvm.
 
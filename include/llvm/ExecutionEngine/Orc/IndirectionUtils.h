@@ -22,6 +22,7 @@
 #include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
+#include <mutex>
 #include <sstream>
 
 namespace llvm {
@@ -66,22 +67,29 @@ public:
 
   /// @brief Execute the callback for the given trampoline id. Called by the JIT
   ///        to compile functions on demand.
+  ///
+  ///   This may be called from several threads at once. The compile action
+  /// itself runs without the callback manager's lock held.
   TargetAddress executeCompileCallback(TargetAddress TrampolineAddr) {
-    auto I = ActiveTrampolines.find(TrampolineAddr);
-    // FIXME: Also raise an error in the Orc error-handler when we finally have
-    //        one.
-    if (I == ActiveTrampolines.end())
-      return ErrorHandlerAddress;
-
-    // Found a callback handler. Yank this trampoline out of the active list and
-    // put it back in the available trampolines list, then try to run the
-    // handler's compile and update actions.
-    // Moving the trampoline ID back to the available list first means there's at
-    // least one available trampoline if the compile action triggers a request for
-    // a new one.
-    auto Compile = std::move(I->second);
-    ActiveTrampolines.erase(I);
-    AvailableTrampolines.push_back(TrampolineAddr);
+    CompileFtor Compile;
+    {
+      std::lock_guard<std::mutex> Lock(TrampolinesMutex);
+      auto I = ActiveTrampolines.find(TrampolineAddr);
+      // FIXME: Also raise an error in the Orc error-handler when we finally
+      //        have one.
+      if (I == ActiveTrampolines.end())
+        return ErrorHandlerAddress;
+
+      // Found a callback handler. Yank this trampoline out of the active list
+      // and put it back in the available trampolines list, then try to run the
+      // handler's compile and update actions.
+      // Moving the trampoline ID back to the available list first means
+      // there's at least one available trampoline if the compile action
+      // triggers a request for a new one.
+      Compile = std::move(I->second);
+      ActiveTrampolines.erase(I);
+      AvailableTrampolines.push_back(TrampolineAddr);
+    }
 
     if (auto Addr = Compile())
       return Addr;
@@ -94,6 +102,7 @@ public:
 
   /// @brief Get a CompileCallbackInfo for an existing callback.
   CompileCallbackInfo getCompileCallbackInfo(TargetAddress TrampolineAddr) {
+    std::lock_guard<std::mutex> Lock(TrampolinesMutex);
     auto I = ActiveTrampolines.find(TrampolineAddr);
     assert(I != ActiveTrampolines.end() && "Not an active trampoline.");
     return CompileCallbackInfo(I->first, I->second);
@@ -105,6 +114,7 @@ public:
   /// only be called to manually release a callback that is not going to
   /// execute.
   void releaseCompileCallback(TargetAddress TrampolineAddr) {
+    std::lock_guard<std::mutex> Lock(TrampolinesMutex);
     auto I = ActiveTrampolines.find(TrampolineAddr);
     assert(I != ActiveTrampolines.end() && "Not an active trampoline.");
     ActiveTrampolines.erase(I);
@@ -116,6 +126,7 @@ protected:
   unsigned NumTrampolinesPerBlock;
 
   typedef std::map<TargetAddress, CompileFtor> TrampolineMapT;
+  std::mutex TrampolinesMutex;
   TrampolineMapT ActiveTrampolines;
   std::vector<TargetAddress> AvailableTrampolines;
 };
@@ -146,6 +157,7 @@ public:
 
   /// @brief Get/create a compile callback with the given signature.
   CompileCallbackInfo getCompileCallback(LLVMContext &Context) final {
+    std::lock_guard<std::mutex> Lock(this->TrampolinesMutex);
     TargetAddress TrampolineAddr = getAvailableTrampolineAddr(Context);
     auto &Compile = this->ActiveTrampolines[TrampolineAddr];
     return CompileCallbackInfo(TrampolineAddr, Compile);
@@ -236,8 +248,31 @@ GlobalVariable* createImplPointer(PointerType &PT, Module &M,
 
 /// @brief Turn a function declaration into a stub function that makes an
 ///        indirect call using the given function pointer.
+///
+///   The function pointer is loaded atomically, so it may be updated while
+/// other threads are calling through the stub.
 void makeStub(Function &F, GlobalVariable &ImplPointer);
 
+/// @brief Create a zero-initialized 64-bit call counter with the given name in
+///        the given Module.
+GlobalVariable* createCallCounter(Module &M, const Twine &Name);
+
+/// @brief Turn a function declaration into a stub function that counts its
+///        calls before making an indirect call using the given function
+///        pointer.
+///
+///   Each call atomically increments CallCount. The call that brings the count
+/// to Threshold first calls Notify (a function of type void(i8*)) with
+/// NotifyArg, which can be used to schedule recompilation of a hot function.
+/// As with makeStub, the implementation pointer is loaded atomically.
+///
+///   The counter can only be bypassed by not calling F: to stop counting once
+/// a function is hot, call it through a plain stub (see makeStub) whose
+/// implementation pointer initially points at F, and repoint that instead.
+void makeCountingStub(Function &F, GlobalVariable &ImplPointer,
+                      GlobalVariable &CallCount, uint64_t Threshold,
+                      Constant *Notify, Constant *NotifyArg);
+
 /// @brief Raise linkage types and rename as necessary to ensure that all
 ///        symbols are accessible for other modules.
 ///
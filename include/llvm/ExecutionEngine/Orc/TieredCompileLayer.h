@@ -0,0 +1,481 @@
+//===- TieredCompileLayer.h - Recompile hot functions ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// JIT layer that emits every function through a cheap baseline layer first,
+// counts calls through its stubs, and recompiles hot functions through an
+// optimizing layer on a background thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
+#define LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
+
+#include "IndirectionUtils.h"
+#include "LambdaResolver.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+
+namespace llvm {
+namespace orc {
+
+/// @brief Tiered compilation layer.
+///
+///   When a module is added to this layer a stub and a call counter are
+/// created for each of its function definitions, and all of the function
+/// bodies are emitted right away through BaseLayer, which is expected to be a
+/// fast, unoptimized compiler (e.g. an IRCompileLayer whose TargetMachine uses
+/// CodeGenOpt::None, and thus FastISel). Each stub initially calls the baseline
+/// body through the counter. Once a function has been called HotThreshold
+/// times, a copy of its body, along with available_externally copies of the
+/// functions it calls directly, is added to OptLayer (e.g. an IRTransformLayer
+/// running the -O2 pipeline over an optimizing IRCompileLayer) on a background
+/// thread, and the stub's implementation pointer is atomically switched over
+/// to the optimized body, so that later calls no longer pay for the counter.
+///
+///   Both layers must emit into the same address space as the host, and their
+/// symbols must be visible to each other only through this layer. The
+/// original modules are kept alive for recompilation, so while a background
+/// compile may be in flight, their LLVMContext must only be used through this
+/// layer.
+template <typename BaseLayerT, typename OptLayerT>
+class TieredCompileLayer {
+private:
+
+  // Utility class for MapValue. Only materializes declarations for global
+  // values.
+  class GlobalDeclMaterializer : public ValueMaterializer {
+  public:
+    GlobalDeclMaterializer(Module &Dst) : Dst(Dst) {}
+    Value* materializeValueFor(Value *V) final {
+      if (auto *GV = dyn_cast<GlobalVariable>(V))
+        return cloneGlobalVariableDecl(Dst, *GV);
+      else if (auto *F = dyn_cast<Function>(V))
+        return cloneFunctionDecl(Dst, *F);
+      // Else.
+      return nullptr;
+    }
+  private:
+    Module &Dst;
+  };
+
+  typedef typename BaseLayerT::ModuleSetHandleT BaseLayerModuleSetHandleT;
+  typedef typename OptLayerT::ModuleSetHandleT OptLayerModuleSetHandleT;
+  class TieredModuleSet;
+  struct TieredModule;
+
+  // A function with a stub and a call counter. The counter passes the address
+  // of this struct to notifyHot once the function becomes hot.
+  struct TieredFunction {
+    TieredFunction(TieredModuleSet &MS, TieredModule &TM, Function &F)
+        : MS(MS), TM(TM), F(F), ImplPtrAddr(0) {}
+    TieredModuleSet &MS;
+    TieredModule &TM;
+    Function &F;
+    TargetAddress ImplPtrAddr;
+  };
+
+  // A module added to this layer.
+  //
+  //   SrcM keeps the function bodies for recompilation. The stubs and global
+  // variables live in the StubsHandle module; lookups only ever search that
+  // module, so calls always go through the stubs.
+  struct TieredModule {
+    std::unique_ptr<Module> SrcM;
+    BaseLayerModuleSetHandleT StubsHandle;
+    BaseLayerModuleSetHandleT BaselineHandle;
+    std::vector<OptLayerModuleSetHandleT> OptHandles;
+    std::list<TieredFunction> Functions;
+  };
+
+  // The modules added by a single call to addModuleSet, plus the resolver for
+  // the symbols they don't define.
+  class TieredModuleSet {
+  public:
+    TieredModuleSet(TieredCompileLayer &Parent) : Parent(Parent) {}
+
+    virtual ~TieredModuleSet() {
+      for (auto &TM : Modules) {
+        Parent.BaseLayer.removeModuleSet(TM.StubsHandle);
+        Parent.BaseLayer.removeModuleSet(TM.BaselineHandle);
+        for (auto H : TM.OptHandles)
+          Parent.OptLayer.removeModuleSet(H);
+      }
+    }
+
+    // Look up a symbol in this set's stubs-and-globals modules.
+    JITSymbol findSymbol(const std::string &Name, bool ExportedSymbolsOnly) {
+      for (auto &TM : Modules)
+        if (auto Symbol = Parent.BaseLayer.findSymbolIn(TM.StubsHandle, Name,
+                                                        ExportedSymbolsOnly))
+          return Symbol;
+      return nullptr;
+    }
+
+    // Find an external symbol (via the user supplied SymbolResolver).
+    virtual RuntimeDyld::SymbolInfo
+    findSymbolExternally(const std::string &Name) const = 0;
+
+    // Build a resolver for the modules emitted on behalf of this set.
+    std::unique_ptr<RuntimeDyld::SymbolResolver> createResolver() {
+      return createLambdaResolver(
+          [this](const std::string &Name) {
+            if (auto Symbol = findSymbol(Name, false))
+              return RuntimeDyld::SymbolInfo(Symbol.getAddress(),
+                                             Symbol.getFlags());
+            return findSymbolExternally(Name);
+          },
+          [this](const std::string &Name) {
+            if (auto Symbol = findSymbol(Name, false))
+              return RuntimeDyld::SymbolInfo(Symbol.getAddress(),
+                                             Symbol.getFlags());
+            return RuntimeDyld::SymbolInfo(nullptr);
+          });
+    }
+
+    // Get a reference to the containing layer.
+    TieredCompileLayer &getParent() { return Parent; }
+
+    std::list<TieredModule> Modules;
+
+  private:
+    TieredCompileLayer &Parent;
+  };
+
+  template <typename ResolverPtrT>
+  class TieredModuleSetImpl : public TieredModuleSet {
+  public:
+    TieredModuleSetImpl(TieredCompileLayer &Parent, ResolverPtrT Resolver)
+      : TieredModuleSet(Parent), Resolver(std::move(Resolver)) {}
+
+    RuntimeDyld::SymbolInfo
+    findSymbolExternally(const std::string &Name) const override {
+      return Resolver->findSymbol(Name);
+    }
+
+  private:
+    ResolverPtrT Resolver;
+  };
+
+  typedef std::list<std::unique_ptr<TieredModuleSet>> TieredModuleSetList;
+
+public:
+  /// @brief Handle to a set of loaded modules.
+  typedef typename TieredModuleSetList::iterator ModuleSetHandleT;
+
+  /// @brief Construct a tiered compilation layer.
+  /// @param BaseLayer Layer used to emit every function when it is added.
+  /// @param OptLayer Layer used to re-emit functions once they are hot.
+  /// @param HotThreshold Number of calls after which a function is hot.
+  /// @param NumThreads Number of background recompilation threads.
+  TieredCompileLayer(BaseLayerT &BaseLayer, OptLayerT &OptLayer,
+                     uint64_t HotThreshold, unsigned NumThreads = 1)
+      : BaseLayer(BaseLayer), OptLayer(OptLayer), HotThreshold(HotThreshold),
+        RecompilePool(NumThreads) {
+    assert(HotThreshold != 0 && "Calls are counted from one.");
+  }
+
+  /// @brief Wait for any pending recompilation before tearing down.
+  ~TieredCompileLayer() { waitForRecompilation(); }
+
+  /// @brief Add a module set to the tiered compilation layer.
+  ///
+  ///   Every function definition is emitted through the base layer before this
+  /// returns.
+  template <typename ModuleSetT, typename MemoryManagerPtrT,
+            typename SymbolResolverPtrT>
+  ModuleSetHandleT addModuleSet(ModuleSetT Ms,
+                                MemoryManagerPtrT MemMgr,
+                                SymbolResolverPtrT Resolver) {
+    assert(MemMgr == nullptr &&
+           "User supplied memory managers not supported with tiering yet.");
+
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    typedef TieredModuleSetImpl<SymbolResolverPtrT> Impl;
+    ModuleSets.push_back(llvm::make_unique<Impl>(*this, std::move(Resolver)));
+    TieredModuleSet &MS = *ModuleSets.back();
+
+    for (auto &M : Ms)
+      addTieredModule(MS, std::move(M));
+
+    return std::prev(ModuleSets.end());
+  }
+
+  /// @brief Remove the module represented by the given handle.
+  ///
+  ///   This waits for any pending recompilation, then removes all modules in
+  /// the layers below that were derived from the modules represented by H.
+  void removeModuleSet(ModuleSetHandleT H) {
+    waitForRecompilation();
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    ModuleSets.erase(H);
+  }
+
+  /// @brief Search for the given named symbol.
+  /// @param Name The name of the symbol to search for.
+  /// @param ExportedSymbolsOnly If true, search only for exported symbols.
+  /// @return A handle for the given named symbol, if it exists.
+  JITSymbol findSymbol(const std::string &Name, bool ExportedSymbolsOnly) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    for (auto &MS : ModuleSets)
+      if (auto Symbol = MS->findSymbol(Name, ExportedSymbolsOnly))
+        return JITSymbol(Symbol.getAddress(), Symbol.getFlags());
+    return nullptr;
+  }
+
+  /// @brief Get the address of a symbol provided by this layer, or some layer
+  ///        below this one.
+  JITSymbol findSymbolIn(ModuleSetHandleT H, const std::string &Name,
+                         bool ExportedSymbolsOnly) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    if (auto Symbol = (*H)->findSymbol(Name, ExportedSymbolsOnly))
+      return JITSymbol(Symbol.getAddress(), Symbol.getFlags());
+    return nullptr;
+  }
+
+  /// @brief Block until every function that has become hot so far has been
+  ///        recompiled.
+  void waitForRecompilation() { RecompilePool.wait(); }
+
+private:
+
+  void addTieredModule(TieredModuleSet &MS, std::unique_ptr<Module> SrcM) {
+    // Bump the linkage and rename any anonymous/private members in SrcM so
+    // the stubs, the baseline bodies and any recompiled bodies can all refer
+    // to each other.
+    makeAllSymbolsExternallyAccessible(*SrcM);
+
+    MS.Modules.push_back(TieredModule());
+    TieredModule &TM = MS.Modules.back();
+    TM.SrcM = std::move(SrcM);
+    Module &M = *TM.SrcM;
+    LLVMContext &Context = M.getContext();
+
+    // Create the stubs-and-globals module. Each stub calls through
+    // "$orc_addr", which starts out pointing at the "$orc_counter" function;
+    // that counts the call and calls the baseline body through "$orc_body".
+    // The pointers are filled in once the bodies have been emitted.
+    auto StubsM = llvm::make_unique<Module>(
+                    (M.getName() + ".globals_and_stubs").str(), Context);
+    StubsM->setDataLayout(M.getDataLayout());
+    FunctionType *NotifyTy =
+      FunctionType::get(Type::getVoidTy(Context), Type::getInt8PtrTy(Context),
+                        false);
+    Constant *Notify =
+      createIRTypedAddress(*NotifyTy, static_cast<TargetAddress>(
+                                        reinterpret_cast<uintptr_t>(
+                                          &notifyHot)));
+    ValueToValueMapTy StubsVMap;
+    for (auto &F : M) {
+      if (F.isDeclaration())
+        continue;
+      TM.Functions.push_back(TieredFunction(MS, TM, F));
+      Constant *NotifyArg =
+        ConstantExpr::getIntToPtr(
+          ConstantInt::get(Type::getInt64Ty(Context),
+                           reinterpret_cast<uintptr_t>(&TM.Functions.back())),
+          Type::getInt8PtrTy(Context));
+      Function *StubF = cloneFunctionDecl(*StubsM, F, &StubsVMap);
+      GlobalVariable *ImplPtr =
+        createImplPointer(*StubF->getType(), *StubsM,
+                          StubF->getName() + "$orc_addr", nullptr);
+      makeStub(*StubF, *ImplPtr);
+      Function *CounterF =
+        Function::Create(StubF->getFunctionType(), GlobalValue::ExternalLinkage,
+                         StubF->getName() + "$orc_counter", StubsM.get());
+      CounterF->setAttributes(StubF->getAttributes());
+      GlobalVariable *BodyPtr =
+        createImplPointer(*StubF->getType(), *StubsM,
+                          StubF->getName() + "$orc_body", nullptr);
+      GlobalVariable *Count =
+        createCallCounter(*StubsM, StubF->getName() + "$orc_count");
+      makeCountingStub(*CounterF, *BodyPtr, *Count, HotThreshold, Notify,
+                       NotifyArg);
+    }
+
+    GlobalDeclMaterializer StubsMat(*StubsM);
+    for (auto &GV : M.globals())
+      if (!GV.isDeclaration())
+        cloneGlobalVariableDecl(*StubsM, GV, &StubsVMap);
+    for (auto &GV : M.globals())
+      if (!GV.isDeclaration())
+        moveGlobalVariableInitializer(GV, StubsVMap, &StubsMat);
+
+    // Copy every function body into the baseline module, leaving SrcM intact
+    // for recompilation. The bodies are renamed, and references to the
+    // functions themselves become declarations: otherwise calls between them
+    // would be resolved within the baseline object, bypassing the stubs.
+    auto BaselineM = llvm::make_unique<Module>(
+                       (M.getName() + ".baseline").str(), Context);
+    BaselineM->setDataLayout(M.getDataLayout());
+    ValueToValueMapTy BaselineVMap;
+    GlobalDeclMaterializer BaselineMat(*BaselineM);
+    for (auto &TF : TM.Functions)
+      cloneFunctionDecl(*BaselineM, TF.F, &BaselineVMap);
+    for (auto &TF : TM.Functions) {
+      Function *BodyF =
+        Function::Create(TF.F.getFunctionType(), GlobalValue::ExternalLinkage,
+                         TF.F.getName() + "$orc_baseline", BaselineM.get());
+      cloneFunctionBody(TF.F, *BodyF, BaselineVMap, BaselineMat);
+    }
+
+    TM.StubsHandle =
+      BaseLayer.addModuleSet(singletonSet(std::move(StubsM)),
+                             llvm::make_unique<SectionMemoryManager>(),
+                             MS.createResolver());
+    TM.BaselineHandle =
+      BaseLayer.addModuleSet(singletonSet(std::move(BaselineM)),
+                             llvm::make_unique<SectionMemoryManager>(),
+                             MS.createResolver());
+
+    // Point the counters at the baseline bodies, and the stubs at the
+    // counters.
+    for (auto &TF : TM.Functions) {
+      std::string FName = TF.F.getName();
+      auto FnBodySym =
+        BaseLayer.findSymbolIn(TM.BaselineHandle,
+                               Mangle(FName + "$orc_baseline", M), false);
+      auto CounterSym =
+        BaseLayer.findSymbolIn(TM.StubsHandle,
+                               Mangle(FName + "$orc_counter", M), false);
+      auto BodyPtrSym =
+        BaseLayer.findSymbolIn(TM.StubsHandle, Mangle(FName + "$orc_body", M),
+                               false);
+      auto FnPtrSym =
+        BaseLayer.findSymbolIn(TM.StubsHandle, Mangle(FName + "$orc_addr", M),
+                               false);
+      assert(FnBodySym && "Couldn't find function body.");
+      assert(CounterSym && "Couldn't find call counter.");
+      assert(BodyPtrSym && "Couldn't find baseline body pointer.");
+      assert(FnPtrSym && "Couldn't find function body pointer.");
+      setImplPointer(BodyPtrSym.getAddress(), FnBodySym.getAddress());
+      TF.ImplPtrAddr = FnPtrSym.getAddress();
+      setImplPointer(TF.ImplPtrAddr, CounterSym.getAddress());
+    }
+  }
+
+  // Called from the JITed counters, on whichever thread made the call that
+  // brought the function's count to the threshold.
+  static void notifyHot(void *Ctx) {
+    TieredFunction &TF = *static_cast<TieredFunction*>(Ctx);
+    TieredCompileLayer &Layer = TF.MS.getParent();
+    Layer.RecompilePool.async([&Layer, &TF]() { Layer.recompile(TF); });
+  }
+
+  void recompile(TieredFunction &TF) {
+    std::lock_guard<std::recursive_mutex> Lock(LayerMutex);
+    TieredModule &TM = TF.TM;
+    Module &SrcM = *TM.SrcM;
+
+    auto OptM = llvm::make_unique<Module>(
+                  (SrcM.getName() + "." + TF.F.getName() + ".opt").str(),
+                  SrcM.getContext());
+    OptM->setDataLayout(SrcM.getDataLayout());
+    ValueToValueMapTy VMap;
+    GlobalDeclMaterializer GDMat(*OptM);
+    Function *OptF = cloneFunctionDecl(*OptM, TF.F, &VMap);
+
+    // Give the optimizer available_externally copies of the direct callees
+    // defined in SrcM, so that they can be inlined. Calls that are not inlined
+    // still go through the callees' stubs, since no code is emitted for these
+    // copies.
+    std::vector<Function*> Callees;
+    for (auto &BB : TF.F)
+      for (auto &I : BB) {
+        CallSite CS(&I);
+        if (!CS)
+          continue;
+        Function *Callee = CS.getCalledFunction();
+        if (!Callee || Callee == &TF.F || Callee->isDeclaration() ||
+            VMap.count(Callee))
+          continue;
+        cloneFunctionDecl(*OptM, *Callee, &VMap);
+        Callees.push_back(Callee);
+      }
+
+    cloneFunctionBody(TF.F, *OptF, VMap, GDMat);
+    for (auto *Callee : Callees) {
+      Function *CalleeCopy = cast<Function>(VMap[Callee]);
+      cloneFunctionBody(*Callee, *CalleeCopy, VMap, GDMat);
+      CalleeCopy->setLinkage(GlobalValue::AvailableExternallyLinkage);
+    }
+
+    auto H = OptLayer.addModuleSet(singletonSet(std::move(OptM)),
+                                   llvm::make_unique<SectionMemoryManager>(),
+                                   TF.MS.createResolver());
+    TM.OptHandles.push_back(H);
+
+    auto FnBodySym = OptLayer.findSymbolIn(H, Mangle(TF.F.getName(), SrcM),
+                                           false);
+    assert(FnBodySym && "Couldn't find recompiled function body.");
+    // Bypass the counter: calls through the stub now go straight to the
+    // optimized body.
+    setImplPointer(TF.ImplPtrAddr, FnBodySym.getAddress());
+  }
+
+  // Copy the body of F into NewF, which need not be the function F maps to.
+  static void cloneFunctionBody(Function &F, Function &NewF,
+                                ValueToValueMapTy &VMap,
+                                ValueMaterializer &Materializer) {
+    auto NewArgI = NewF.arg_begin();
+    for (auto ArgI = F.arg_begin(), ArgE = F.arg_end(); ArgI != ArgE;
+         ++ArgI, ++NewArgI)
+      VMap[ArgI] = NewArgI;
+    SmallVector<ReturnInst *, 8> Returns; // Ignore returns cloned.
+    CloneFunctionInto(&NewF, &F, VMap, /*ModuleLevelChanges=*/true, Returns,
+                      "", nullptr, nullptr, &Materializer);
+  }
+
+  // The stubs load their implementation pointer atomically, so publish new
+  // bodies with a matching atomic store.
+  // FIXME: When we start supporting remote tiered jitting this will need to
+  //        be replaced with a user-supplied callback for updating the remote
+  //        pointers.
+  static void setImplPointer(TargetAddress ImplPtrAddr, TargetAddress Addr) {
+    static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t),
+                  "Implementation pointers can't be updated atomically.");
+    auto *ImplPtr = reinterpret_cast<std::atomic<uintptr_t>*>(
+                      static_cast<uintptr_t>(ImplPtrAddr));
+    ImplPtr->store(static_cast<uintptr_t>(Addr), std::memory_order_release);
+  }
+
+  static std::vector<std::unique_ptr<Module>>
+  singletonSet(std::unique_ptr<Module> M) {
+    std::vector<std::unique_ptr<Module>> Ms;
+    Ms.push_back(std::move(M));
+    return Ms;
+  }
+
+  static std::string Mangle(StringRef Name, const Module &M) {
+    Mangler Mang(&M.getDataLayout());
+    std::string MangledName;
+    {
+      raw_string_ostream MangledNameStream(MangledName);
+      Mang.getNameWithPrefix(MangledNameStream, Name);
+    }
+    return MangledName;
+  }
+
+  BaseLayerT &BaseLayer;
+  OptLayerT &OptLayer;
+  uint64_t HotThreshold;
+  std::recursive_mutex LayerMutex;
+  TieredModuleSetList ModuleSets;
+  ThreadPool RecompilePool;
+};
+
+} // End namespace orc.
+} // End namespace llvm.
+
+#endif // LLVM_EXECUTIONENGINE_ORC_TIEREDCOMPILELAYER_H
@@ -0,0 +1,150 @@
+//===- SlabMemoryManager.h - Pooled memory manager for the JIT --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains the declaration of a section-based memory manager that
+// carves its memory out of large, shared slabs, and gives it back when it is
+// destroyed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_SLABMEMORYMANAGER_H
+#define LLVM_EXECUTIONENGINE_SLABMEMORYMANAGER_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
+#include "llvm/Support/Memory.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace llvm {
+
+/// A memory manager for section-based loading, like SectionMemoryManager,
+/// whose pages come from a SlabPool shared by many memory managers.
+///
+/// JITs that keep adding and removing modules typically create one memory
+/// manager per module. With SectionMemoryManager every one of them maps its
+/// own memory, and that memory is unmapped when the manager is destroyed.
+/// SlabMemoryManager instead takes page runs from a pool of large mappings
+/// and returns them to the pool when it is destroyed, so the next module
+/// reuses the same pages.
+///
+/// Each manager owns whole pages, so that finalizing one module never changes
+/// the permissions of another's memory. Permission changes are batched: all
+/// contiguous runs that need the same permissions are changed with a single
+/// call.
+///
+/// A pool may be shared by memory managers used on different threads. A
+/// single memory manager should only be used by one object load at a time.
+class SlabMemoryManager : public RTDyldMemoryManager {
+  SlabMemoryManager(const SlabMemoryManager&) = delete;
+  void operator=(const SlabMemoryManager&) = delete;
+
+public:
+  /// A thread-safe pool of read-write page runs carved out of large slabs.
+  class SlabPool {
+    SlabPool(const SlabPool&) = delete;
+    void operator=(const SlabPool&) = delete;
+
+  public:
+    /// Create a pool that maps memory \p SlabSize bytes (rounded up to the
+    /// page size) at a time.
+    explicit SlabPool(size_t SlabSize = 1 << 20);
+    ~SlabPool();
+
+    /// Allocate a read-write run of at least \p Size bytes, rounded up to
+    /// whole pages. Returns an empty block and sets \p EC on failure.
+    sys::MemoryBlock allocate(size_t Size, std::error_code &EC);
+
+    /// Return a run obtained from allocate(), or a contiguous part of one, to
+    /// the pool. The pages may have any permissions.
+    void release(sys::MemoryBlock Block);
+
+    /// Number of slabs currently mapped.
+    size_t getNumSlabs() const;
+
+    /// Number of bytes in mapped slabs that are not in use.
+    size_t getFreeBytes() const;
+
+    /// Size of the pages handed out by this pool.
+    size_t getPageSize() const { return PageSize; }
+
+  private:
+    size_t PageSize;
+    size_t SlabSize;
+    mutable std::mutex PoolMutex;
+    // Start address -> size of every mapped slab.
+    std::map<uintptr_t, size_t> Slabs;
+    // Start address -> size of every free run. Runs never span two slabs.
+    std::map<uintptr_t, size_t> FreeRuns;
+    // A fully free slab that is kept mapped to avoid map/unmap churn.
+    uintptr_t SpareSlab;
+  };
+
+  /// Create a memory manager that allocates from \p Pool.
+  explicit SlabMemoryManager(std::shared_ptr<SlabPool> Pool);
+
+  /// Create a memory manager that allocates from a pool shared by all of the
+  /// memory managers created this way.
+  SlabMemoryManager();
+
+  /// Return all memory to the pool.
+  ~SlabMemoryManager() override;
+
+  /// \brief Allocates a memory block of (at least) the given size suitable for
+  /// executable code.
+  ///
+  /// The value of \p Alignment must be a power of two.  If \p Alignment is zero
+  /// a default alignment of 16 will be used.
+  uint8_t *allocateCodeSection(uintptr_t Size, unsigned Alignment,
+                               unsigned SectionID,
+                               StringRef SectionName) override;
+
+  /// \brief Allocates a memory block of (at least) the given size suitable for
+  /// data.
+  ///
+  /// The value of \p Alignment must be a power of two.  If \p Alignment is zero
+  /// a default alignment of 16 will be used.
+  uint8_t *allocateDataSection(uintptr_t Size, unsigned Alignment,
+                               unsigned SectionID, StringRef SectionName,
+                               bool isReadOnly) override;
+
+  /// \brief Make the code allocated since the last call executable and the
+  /// read-only data read-only, and invalidate the instruction cache for the
+  /// new code.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool finalizeMemory(std::string *ErrMsg = nullptr) override;
+
+  /// \brief Get the pool this memory manager allocates from.
+  SlabPool &getPool() const { return *Pool; }
+
+private:
+  struct MemoryGroup {
+    MemoryGroup() : NumFinalized(0) {}
+    // The page runs owned by this group, in allocation order.
+    SmallVector<sys::MemoryBlock, 4> Runs;
+    // The runs in Runs[0, NumFinalized) have had their permissions applied.
+    unsigned NumFinalized;
+    // Unused space at the end of runs that may still be allocated from.
+    SmallVector<sys::MemoryBlock, 4> FreeMem;
+  };
+
+  uint8_t *allocateSection(MemoryGroup &MemGroup, uintptr_t Size,
+                           unsigned Alignment);
+
+  std::shared_ptr<SlabPool> Pool;
+  MemoryGroup CodeMem;
+  MemoryGroup RWDataMem;
+  MemoryGroup RODataMem;
+};
+
+}
+
+#endif // LLVM_EXECUTIONENGINE_SLABMEMORYMANAGER_H
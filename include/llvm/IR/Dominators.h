@@ -218,6 +218,9 @@ public:
   const DominatorTree &getDomTree() const { return DT; }
 
   bool runOnFunction(Function &F) override;
+  FunctionPass *createParallelCopy() const override {
+    return new DominatorTreeWrapperPass();
+  }
 
   void verifyAnalysis() const override;
 
@@ -0,0 +1,111 @@
+//===-- llvm/IR/FunctionInfo.h - Function summary index ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines FunctionSummary, a compact description of a function
+// definition, and FunctionInfoIndex, which maps function names to the summary
+// and defining module of each function in a set of modules. The index is what
+// summary-based cross-module optimization uses to decide which function bodies
+// to import into a module without having to load the other modules.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_FUNCTIONINFO_H
+#define LLVM_IR_FUNCTIONINFO_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class Function;
+
+/// \brief Summary of a single function definition.
+class FunctionSummary {
+public:
+  /// Bits of the flags field of the bitcode records.
+  enum Flags {
+    /// The body can be copied into another module. This is false if it
+    /// refers to symbols that are local to its module, takes the address of
+    /// a basic block, or is marked noinline.
+    EligibleToImport = 1 << 0
+  };
+
+private:
+  unsigned InstCount;
+  unsigned FlagBits;
+  uint64_t EntryCount;
+
+public:
+  FunctionSummary() : InstCount(0), FlagBits(0), EntryCount(0) {}
+  FunctionSummary(unsigned InstCount, unsigned FlagBits, uint64_t EntryCount)
+      : InstCount(InstCount), FlagBits(FlagBits), EntryCount(EntryCount) {}
+
+  /// Compute the summary of the definition F.
+  static FunctionSummary compute(const Function &F);
+
+  /// Number of instructions in the function, not counting debug intrinsics.
+  unsigned getInstCount() const { return InstCount; }
+
+  /// The profile entry count of the function, or 0 if it has none.
+  uint64_t getEntryCount() const { return EntryCount; }
+
+  unsigned getFlags() const { return FlagBits; }
+  bool isEligibleToImport() const { return FlagBits & EligibleToImport; }
+};
+
+/// \brief Index of the function summaries of one or more modules.
+///
+/// Modules are identified by their path, which is what the importer uses to
+/// load the body of a function.
+class FunctionInfoIndex {
+public:
+  struct FunctionInfo {
+    unsigned ModuleId;
+    FunctionSummary Summary;
+  };
+
+  typedef StringMap<FunctionInfo>::const_iterator const_iterator;
+
+private:
+  StringMap<FunctionInfo> FunctionMap;
+  std::vector<std::string> ModulePaths;
+  StringMap<unsigned> ModuleIds;
+
+public:
+  /// Return the id of the module at Path, adding it to the index if needed.
+  unsigned addModulePath(StringRef Path);
+
+  /// Record the summary of the definition of Name in module ModuleId. If
+  /// Name is already defined by the index, the first definition is kept.
+  void addFunction(StringRef Name, unsigned ModuleId, FunctionSummary Summary);
+
+  /// Return the summary of Name, or null if it is not in the index.
+  const FunctionInfo *findFunction(StringRef Name) const;
+
+  StringRef getModulePath(unsigned ModuleId) const {
+    return ModulePaths[ModuleId];
+  }
+  ArrayRef<std::string> modulePaths() const { return ModulePaths; }
+
+  const_iterator begin() const { return FunctionMap.begin(); }
+  const_iterator end() const { return FunctionMap.end(); }
+  size_t size() const { return FunctionMap.size(); }
+  bool empty() const { return FunctionMap.empty(); }
+
+  /// Add the modules and functions of Other to this index.
+  void mergeFrom(const FunctionInfoIndex &Other);
+};
+
+} // End llvm namespace
+
+#endif
@@ -160,6 +160,19 @@ public:
   /// any global mutex or cannot block the execution in another LLVM context.
   void yield();
 
+  /// \brief Allow the IR in this context to be changed from several threads
+  /// at once.
+  ///
+  /// In multithreaded mode the state shared by all the IR of the context
+  /// (uniqued constants, types, attributes and metadata, value names and
+  /// handles, and the use lists of values that aren't local to a function) is
+  /// only accessed under a lock, so that each thread may change a different
+  /// function. Anything else, including module-level IR such as the global
+  /// lists, still needs external synchronization. This must not be changed
+  /// while other threads are using the context.
+  void setMultithreaded(bool Enable);
+  bool isMultithreaded() const;
+
   /// emitError - Emit an error message to the currently installed error handler
   /// with optional location information.  This function returns, so code should
   /// be prepared to drop the erroneous construct on the floor and "not crash".
@@ -201,6 +201,16 @@ public:
   /// Find analysis usage information for the pass P.
   AnalysisUsage *findAnalysisUsage(Pass *P);
 
+  /// Register the copies of passes made to run them on several threads.
+  /// \p Copies maps each pass to its copy. The copies are freed like the
+  /// passes they were copied from, and their analysis usage is computed
+  /// ahead, as the threads can't update this manager.
+  void addParallelCopies(const DenseMap<Pass *, Pass *> &Copies);
+
+  /// Forget the copies registered by addParallelCopies before they are
+  /// deleted.
+  void removeParallelCopies(const DenseMap<Pass *, Pass *> &Copies);
+
   virtual ~PMTopLevelManager();
 
   /// Add immutable pass and initialize it.
@@ -425,6 +435,12 @@ public:
   bool runOnFunction(Function &F);
   bool runOnModule(Module &M) override;
 
+  /// runInParallel - Run the passes on the functions of M on NumThreads
+  /// threads, each with its own copies of the passes. Return false, without
+  /// running anything, if some pass can't be copied. Otherwise set Changed
+  /// to whether a pass modified the module.
+  bool runInParallel(Module &M, unsigned NumThreads, bool &Changed);
+
   /// cleanup - After running all passes, clean up pass manager cache.
   void cleanup();
 
@@ -470,6 +486,10 @@ public:
   PassManagerType getPassManagerType() const override {
     return PMT_FunctionPassManager;
   }
+
+private:
+  /// Run the passes on F, with the inherited analysis already populated.
+  bool runPasses(Function &F);
 };
 
 Timer *getPassTimer(Pass *);
@@ -29,6 +29,7 @@
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/Support/CBindingWrapping.h"
 #include "llvm/Support/Compiler.h"
+#include <atomic>
 #include <cstddef>
 #include <iterator>
 
@@ -81,7 +82,11 @@ private:
 
   /// Destructor - Only for zap()
   ~Use() {
-    if (Val)
+    if (!Val)
+      return;
+    if (LLVM_UNLIKELY(MultithreadedContexts.load(std::memory_order_relaxed)))
+      removeFromListLocked();
+    else
       removeFromList();
   }
 
@@ -129,6 +134,13 @@ public:
   /// a User changes.
   static void zap(Use *Start, const Use *Stop, bool del = false);
 
+  /// \brief The number of contexts that are currently multithreaded.
+  ///
+  /// While it is non-zero, the use lists of values that aren't local to a
+  /// function are changed under the lock of their context.
+  /// \see LLVMContext::setMultithreaded.
+  static std::atomic<unsigned> MultithreadedContexts;
+
 private:
   const Use *getImpliedUser() const;
 
@@ -151,6 +163,10 @@ private:
       Next->setPrev(StrippedPrev);
   }
 
+  // Variants of set() and removeFromList() for multithreaded contexts.
+  void setLocked(Value *V);
+  void removeFromListLocked();
+
   friend class Value;
 };
 
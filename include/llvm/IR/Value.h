@@ -521,6 +521,8 @@ inline raw_ostream &operator<<(raw_ostream &OS, const Value &V) {
 }
 
 void Use::set(Value *V) {
+  if (LLVM_UNLIKELY(MultithreadedContexts.load(std::memory_order_relaxed)))
+    return setLocked(V);
   if (Val) removeFromList();
   Val = V;
   if (V) V->addUse(*this);
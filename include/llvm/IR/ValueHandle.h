@@ -70,7 +70,7 @@ public:
   ValueHandleBase(HandleBaseKind Kind, const ValueHandleBase &RHS)
     : PrevPair(nullptr, Kind), Next(nullptr), V(RHS.V) {
     if (isValid(V))
-      AddToExistingUseList(RHS.getPrevPtr());
+      AddToExistingUseListBefore(RHS);
   }
   ~ValueHandleBase() {
     if (isValid(V))
@@ -89,7 +89,7 @@ public:
     if (V == RHS.V) return RHS.V;
     if (isValid(V)) RemoveFromUseList();
     V = RHS.V;
-    if (isValid(V)) AddToExistingUseList(RHS.getPrevPtr());
+    if (isValid(V)) AddToExistingUseListBefore(RHS);
     return V;
   }
 
@@ -125,6 +125,12 @@ private:
   /// \brief Add this ValueHandle to the use list after Node.
   void AddToExistingUseListAfter(ValueHandleBase *Node);
 
+  /// \brief Add this ValueHandle to the use list before Node.
+  ///
+  /// Unlike AddToExistingUseList(Node.getPrevPtr()), this reads the position
+  /// of Node under the lock of a multithreaded context.
+  void AddToExistingUseListBefore(const ValueHandleBase &Node);
+
   /// \brief Add this ValueHandle to the use list for V.
   void AddToUseList();
   /// \brief Remove this ValueHandle from its current use list.
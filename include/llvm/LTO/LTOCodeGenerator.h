@@ -79,6 +79,17 @@ struct LTOCodeGenerator {
   void setAttr(const char *mAttr) { MAttr = mAttr; }
   void setOptLevel(unsigned optLevel) { OptLevel = optLevel; }
 
+  // Set the number of partitions the merged module is split into by
+  // compileOptimizedToFiles(). The partitions are code generated in parallel.
+  void setParallelism(unsigned Value) { Parallelism = Value ? Value : 1; }
+
+  // Reuse the objects generated for the same merged module and options by
+  // previous runs, from and to the directory Dir. The least recently used
+  // entries are pruned to keep the directory below MaxSize bytes, unless
+  // MaxSize is 0.
+  void setCacheDir(StringRef Dir) { CacheDir = Dir; }
+  void setCacheMaxSize(uint64_t MaxSize) { CacheMaxSize = MaxSize; }
+
   void setShouldInternalize(bool Value) { ShouldInternalize = Value; }
   void setShouldEmbedUselists(bool Value) { ShouldEmbedUselists = Value; }
 
@@ -133,6 +144,20 @@ struct LTOCodeGenerator {
   // if the compilation was not successful.
   std::unique_ptr<MemoryBuffer> compileOptimized(std::string &errMsg);
 
+  // Compiles the merged optimized module into Out.size() object files, one
+  // per stream. If more than one stream is given, the module is split into
+  // that many partitions which are code generated in parallel. The merged
+  // module then has its local symbols externalized. Return true on success.
+  bool compileOptimized(ArrayRef<raw_pwrite_stream *> Out, std::string &errMsg);
+
+  // Compiles the merged optimized module into one object file per partition
+  // (see setParallelism()); the paths to the object files are returned to the
+  // caller via argument "Names". Return true on success.
+  //
+  // NOTE that it is up to the linker to remove the intermediate object files.
+  bool compileOptimizedToFiles(std::vector<const char *> &Names,
+                               std::string &errMsg);
+
   void setDiagnosticHandler(lto_diagnostic_handler_t, void *);
 
   LLVMContext &getContext() { return Context; }
@@ -140,8 +165,8 @@ struct LTOCodeGenerator {
 private:
   void initializeLTOPasses();
 
-  bool compileOptimized(raw_pwrite_stream &out, std::string &errMsg);
   bool compileOptimizedToFile(const char **name, std::string &errMsg);
+  bool generateObjects(ArrayRef<raw_pwrite_stream *> Out, std::string &errMsg);
   void applyScopeRestrictions();
   void applyRestriction(GlobalValue &GV, ArrayRef<StringRef> Libcalls,
                         std::vector<const char *> &MustPreserveList,
@@ -169,8 +194,12 @@ private:
   std::string MCpu;
   std::string MAttr;
   std::string NativeObjectPath;
+  std::vector<std::string> NativeObjectPaths;
   TargetOptions Options;
   unsigned OptLevel = 2;
+  unsigned Parallelism = 1;
+  std::string CacheDir;
+  uint64_t CacheMaxSize = 0;
   lto_diagnostic_handler_t DiagHandler = nullptr;
   void *DiagContext = nullptr;
   LTOModule *OwnedModule = nullptr;
@@ -27,6 +27,7 @@
 
 // Forward references to llvm classes.
 namespace llvm {
+  class BitcodeSymbolTable;
   class Function;
   class GlobalValue;
   class MemoryBuffer;
@@ -47,7 +48,10 @@ private:
 
   std::unique_ptr<LLVMContext> OwnedContext;
 
+  /// The module, which is not parsed when the symbols can be read from the
+  /// symbol table of the bitcode instead. See makeLTOModule.
   std::unique_ptr<object::IRObjectFile> IRFile;
+  std::string TargetTriple;
   std::unique_ptr<TargetMachine> _target;
   StringSet<>                             _linkeropt_strings;
   std::vector<const char *>               _deplibs;
@@ -111,17 +115,21 @@ public:
     return const_cast<LTOModule*>(this)->getModule();
   }
   Module &getModule() {
+    assert(IRFile && "The module was not parsed");
     return IRFile->getModule();
   }
 
   /// Return the Module's target triple.
   const std::string &getTargetTriple() {
-    return getModule().getTargetTriple();
+    return IRFile ? getModule().getTargetTriple() : TargetTriple;
   }
 
   /// Set the Module's target triple.
   void setTargetTriple(StringRef Triple) {
-    getModule().setTargetTriple(Triple);
+    if (IRFile)
+      getModule().setTargetTriple(Triple);
+    else
+      TargetTriple = Triple;
   }
 
   /// Get the number of symbols
@@ -180,6 +188,10 @@ private:
   /// either the defined or undefined lists.
   bool parseSymbols(std::string &errMsg);
 
+  /// Add the symbols of the symbol table of the bitcode to the defined and
+  /// undefined lists, as parseSymbols would for the module.
+  void parseSymbolTable(const BitcodeSymbolTable &Symtab);
+
   /// Add a symbol which isn't defined just yet to a list to be resolved later.
   void addPotentialUndefinedSymbol(const object::BasicSymbolRef &Sym,
                                    bool isFunc);
@@ -214,6 +226,11 @@ private:
   /// Get string that the data pointer points to.
   bool objcClassNameFromExpression(const Constant *c, std::string &name);
 
+  /// Create the TargetMachine for a module with the given triple.
+  static TargetMachine *makeTargetMachine(std::string TripleStr,
+                                          TargetOptions options,
+                                          std::string &errMsg);
+
   /// Create an LTOModule (private version).
   static LTOModule *makeLTOModule(MemoryBufferRef Buffer, TargetOptions options,
                                   std::string &errMsg, LLVMContext *Context);
@@ -42,6 +42,7 @@ protected:
     ID_Archive,
     ID_MachOUniversalBinary,
     ID_IR, // LLVM IR
+    ID_IRSymtab, // Symbol table of LLVM IR
 
     // Object and children.
     ID_StartObjects,
@@ -90,7 +91,7 @@ public:
   }
 
   bool isSymbolic() const {
-    return isIR() || isObject();
+    return isIR() || isIRSymtab() || isObject();
   }
 
   bool isArchive() const {
@@ -117,6 +118,10 @@ public:
     return TypeID == ID_IR;
   }
 
+  bool isIRSymtab() const {
+    return TypeID == ID_IRSymtab;
+  }
+
   bool isLittleEndian() const {
     return !(TypeID == ID_ELF32B || TypeID == ID_ELF64B ||
              TypeID == ID_MachO32B || TypeID == ID_MachO64B);
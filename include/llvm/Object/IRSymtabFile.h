@@ -0,0 +1,59 @@
+//===- IRSymtabFile.h - Symbol table of LLVM IR -----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares IRSymtabFile, which lists the symbols of a bitcode file
+// from the symbol table that the bitcode writer emits, without parsing the
+// module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_IRSYMTABFILE_H
+#define LLVM_OBJECT_IRSYMTABFILE_H
+
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
+#include "llvm/Object/SymbolicFile.h"
+
+namespace llvm {
+namespace object {
+
+/// \brief The symbols of a bitcode file, as recorded by its symbol table.
+///
+/// The symbols and their flags are the same as those of an IRObjectFile for
+/// the same bitcode, but this needs neither an LLVMContext nor the target, and
+/// only reads the table where it lies in the buffer.
+class IRSymtabFile : public SymbolicFile {
+  BitcodeSymbolTable Symtab;
+
+public:
+  IRSymtabFile(MemoryBufferRef Object, BitcodeSymbolTable Symtab);
+
+  void moveSymbolNext(DataRefImpl &Symb) const override;
+  std::error_code printSymbolName(raw_ostream &OS,
+                                  DataRefImpl Symb) const override;
+  uint32_t getSymbolFlags(DataRefImpl Symb) const override;
+  basic_symbol_iterator symbol_begin_impl() const override;
+  basic_symbol_iterator symbol_end_impl() const override;
+
+  const BitcodeSymbolTable &getSymbolTable() const { return Symtab; }
+  StringRef getTargetTriple() const { return Symtab.getTargetTriple(); }
+
+  static inline bool classof(const Binary *v) {
+    return v->isIRSymtab();
+  }
+
+  /// \brief Read the symbol table of the bitcode in Object, which may be
+  /// either a bitcode file or a native object file with embedded bitcode.
+  /// Fails with BitcodeError::SymbolTableNotFound if the bitcode has no
+  /// table, in which case IRObjectFile has to be used instead.
+  static ErrorOr<std::unique_ptr<IRSymtabFile>> create(MemoryBufferRef Object);
+};
+}
+}
+
+#endif
@@ -304,6 +304,17 @@ public:
   ///
   virtual bool runOnFunction(Function &F) = 0;
 
+  /// createParallelCopy - Return a new instance of this pass, configured like
+  /// this one, that the pass manager can run on other functions while this
+  /// instance runs, or null if the pass can't be run that way. This is only
+  /// possible if the pass changes nothing but the function it runs on (it
+  /// may declare new functions), keeps all of its state in the pass instance,
+  /// and doesn't look at the IR of other functions or at the users of values
+  /// shared between functions, such as constants and globals. Only
+  /// runOnFunction is called on the copy; doInitialization and doFinalization
+  /// are still called on this instance.
+  virtual FunctionPass *createParallelCopy() const { return nullptr; }
+
   void assignPassManager(PMStack &PMS, PassManagerType T) override;
 
   ///  Return what kind of Pass Manager can manage this pass.
@@ -0,0 +1,152 @@
+//===-- llvm/Support/ThreadPool.h - A ThreadPool implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a crude C++11 based thread pool.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+#include <functional>
+#include <future>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace llvm {
+
+/// A ThreadPool for asynchronous parallel execution on a defined number of
+/// threads.
+///
+/// The pool keeps a vector of threads alive, waiting on a condition variable
+/// for some work to become available. Tasks are run in FIFO order, which keeps
+/// scheduling predictable for clients that need deterministic output: they
+/// can rely on the futures returned by async() to collect results in the order
+/// the work was submitted, whatever the number of threads.
+///
+/// When LLVM is built without thread support the tasks are deferred and run
+/// sequentially on the calling thread from wait() or when their future is
+/// queried.
+class ThreadPool {
+public:
+  typedef std::function<void()> TaskTy;
+  typedef std::packaged_task<void()> PackagedTaskTy;
+
+  /// Construct a pool with the number of threads reported by
+  /// getDefaultConcurrency().
+  ThreadPool();
+
+  /// Construct a pool of \p ThreadCount threads.
+  explicit ThreadPool(unsigned ThreadCount);
+
+  /// Blocking destructor: the pool will wait for all the threads to complete.
+  ~ThreadPool();
+
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  template <typename Function, typename... Args>
+  inline std::shared_future<void> async(Function &&F, Args &&... ArgList) {
+    auto Task =
+        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...);
+    return asyncImpl(std::move(Task));
+  }
+
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  template <typename Function>
+  inline std::shared_future<void> async(Function &&F) {
+    return asyncImpl(std::forward<Function>(F));
+  }
+
+  /// Blocking wait for all the threads to complete and the queue to be empty.
+  /// It is an error to try to add new tasks while blocking on this call.
+  void wait();
+
+  /// Return the number of worker threads in the pool.
+  unsigned getThreadCount() const { return ThreadCount; }
+
+  /// Return the number of threads a default-constructed pool uses: the
+  /// hardware concurrency of the host, or 1 if it cannot be determined or
+  /// threading is disabled.
+  static unsigned getDefaultConcurrency();
+
+private:
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  std::shared_future<void> asyncImpl(TaskTy F);
+
+  ThreadPool(const ThreadPool &) = delete;
+  void operator=(const ThreadPool &) = delete;
+
+  unsigned ThreadCount;
+
+  /// Tasks waiting for execution in the pool.
+  std::queue<PackagedTaskTy> Tasks;
+
+#if LLVM_ENABLE_THREADS
+  /// Threads in flight.
+  std::vector<std::thread> Threads;
+
+  /// Locking and signaling for accessing the Tasks queue and ActiveThreads.
+  std::mutex QueueLock;
+  std::condition_variable QueueCondition;
+
+  /// Signaling for job completion, under QueueLock.
+  std::condition_variable CompletionCondition;
+
+  /// Keep track of the number of threads actually busy.
+  unsigned ActiveThreads;
+
+  /// Signal for the destruction of the pool, asking threads to exit.
+  bool EnableFlag;
+#endif
+};
+
+/// A set of tasks submitted to a shared ThreadPool that can be waited on
+/// independently of the rest of the work queued in the pool.
+///
+/// wait() must not be called from a task running on the same pool: if every
+/// worker blocks on a group, the tasks of that group never get scheduled.
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool &Pool) : Pool(Pool) {}
+
+  /// Blocking destructor: waits for all the tasks of the group.
+  ~TaskGroup() { wait(); }
+
+  /// Submit \p F to the underlying pool as part of this group.
+  template <typename Function> void spawn(Function &&F) {
+    Futures.push_back(Pool.async(std::forward<Function>(F)));
+  }
+
+  /// Blocking wait for the tasks spawned in this group so far.
+  void wait() {
+    for (auto &Future : Futures)
+      Future.wait();
+    Futures.clear();
+  }
+
+private:
+  TaskGroup(const TaskGroup &) = delete;
+  void operator=(const TaskGroup &) = delete;
+
+  ThreadPool &Pool;
+  std::vector<std::shared_future<void>> Futures;
+};
+}
+
+#endif // LLVM_SUPPORT_THREADPOOL_H
@@ -0,0 +1,100 @@
+//===- llvm/Support/TimeTraceProfiler.h - Hierarchical time trace -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a profiler that records a timeline of the scopes a
+// compilation goes through, such as passes, instruction selection phases and
+// code emission, and writes it in the Chrome trace event format.  The trace
+// can be loaded in chrome://tracing or other trace viewers to get a flame
+// view of each function.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_TIMETRACEPROFILER_H
+#define LLVM_SUPPORT_TIMETRACEPROFILER_H
+
+#include "llvm/ADT/StringRef.h"
+#include <chrono>
+#include <string>
+#include <system_error>
+
+namespace llvm {
+
+class raw_ostream;
+class TimeTraceProfiler;
+
+extern TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// Start recording the time trace.  Scopes shorter than \p GranularityInUs
+/// microseconds are not recorded, to keep the trace of large compilations
+/// small.  \p ProcessName names the process in the trace.
+///
+/// This must not be called while scopes are being recorded by other threads.
+void timeTraceProfilerInitialize(unsigned GranularityInUs,
+                                 StringRef ProcessName);
+
+/// Stop recording the time trace and discard it.  This must not be called
+/// while scopes are being recorded by other threads.
+void timeTraceProfilerCleanup();
+
+/// Is the time trace being recorded?
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// Write the recorded time trace to \p OS as a Chrome trace event JSON
+/// object.  Each scope is a complete event on the thread that ran it, with
+/// its detail as the "detail" argument.  The total time spent in the scopes
+/// of each name is added at the end as one more thread per name, so that the
+/// hot scopes stand out.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// Start recording the time trace if it was requested with -time-trace, with
+/// the granularity given by -time-trace-granularity.
+void timeTraceProfilerInitializeFromOptions(StringRef ProcessName);
+
+/// If the time trace is being recorded, write it to the file given by
+/// -time-trace-file and stop recording it.  By default the trace goes next to
+/// \p OutputFilename, or to time-trace.json if the output is stdout.  An
+/// error is printed if the file can't be written.
+std::error_code timeTraceProfilerWriteFile(StringRef OutputFilename);
+
+/// The TimeTraceScope class records the time between its construction and
+/// its destruction as a scope named \p Name in the time trace, when it is
+/// enabled.  \p Detail, such as the name of the function being compiled,
+/// distinguishes scopes with the same name.  Scopes nest on each thread.
+class TimeTraceScope {
+  std::chrono::steady_clock::time_point Start;
+  std::string Name;
+  std::string Detail;
+  bool Enabled;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name, StringRef Detail = StringRef())
+      : Enabled(timeTraceProfilerEnabled()) {
+    if (!Enabled)
+      return;
+    this->Name = Name;
+    this->Detail = Detail;
+    Start = std::chrono::steady_clock::now();
+  }
+  ~TimeTraceScope() {
+    if (Enabled)
+      end();
+  }
+
+private:
+  void end();
+};
+
+} // end namespace llvm
+
+#endif
@@ -176,12 +176,30 @@ public:
   
   /// printAll - This static method prints all timers and clears them all out.
   static void printAll(raw_ostream &OS);
-  
+
+  /// printJSON - Print any started timers in this group as a single line JSON
+  /// object and zero them.  The object has the name of the group, the total
+  /// of its timers and an array of timers, sorted by decreasing wall time:
+  ///
+  ///   {"name":"...","total":{...},"timers":[{"name":"...","wall":...,
+  ///    "user":...,"sys":...,"mem":...},...]}
+  ///
+  /// Times are in seconds and memory in bytes.  This can be used to collect
+  /// the timings of each compilation without printing them at exit.
+  void printJSON(raw_ostream &OS);
+
+  /// printAllJSON - This static method prints the started timers of all
+  /// groups as a JSON array of the objects printJSON prints, and clears them
+  /// all out.
+  static void printAllJSON(raw_ostream &OS);
+
 private:
   friend class Timer;
   void addTimer(Timer &T);
   void removeTimer(Timer &T);
+  void queueStartedTimers();
   void PrintQueuedTimers(raw_ostream &OS);
+  void PrintQueuedTimersJSON(raw_ostream &OS);
 };
 
 } // End llvm namespace
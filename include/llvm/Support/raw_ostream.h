@@ -208,6 +208,11 @@ public:
   /// satisfy std::isprint into an escape sequence.
   raw_ostream &write_escaped(StringRef Str, bool UseHexEscapes = false);
 
+  /// Output \p Str as a JSON string, in double quotes. '"', '\\' and the
+  /// control characters are escaped; other bytes, including those of UTF-8
+  /// sequences, are written as they are.
+  raw_ostream &write_json_string(StringRef Str);
+
   raw_ostream &write(unsigned char C);
   raw_ostream &write(const char *Ptr, size_t Size);
 
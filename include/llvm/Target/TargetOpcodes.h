@@ -122,7 +122,63 @@ enum {
   /// label. Created by the llvm.frameallocate intrinsic. It has two arguments:
   /// the symbol for the label and the frame index of the stack allocation.
   FRAME_ALLOC = 21,
+
+  /// Generic opcodes produced by the IR translator of the global instruction
+  /// selector. They operate on virtual registers whose register class stands
+  /// for the type of the value, and are all replaced by target instructions
+  /// before register allocation.
+
+  /// Integer arithmetic: $dst = op $src1, $src2.
+  G_ADD = 22,
+  G_SUB = 23,
+  G_MUL = 24,
+  G_AND = 25,
+  G_OR = 26,
+  G_XOR = 27,
+
+  /// Integer comparison: $dst = G_ICMP $pred, $src1, $src2. $pred is a
+  /// CmpInst::Predicate and $dst holds 0 or 1.
+  G_ICMP = 28,
+
+  /// Integer conversions: $dst = op $src.
+  G_ZEXT = 29,
+  G_SEXT = 30,
+  G_TRUNC = 31,
+
+  /// Materialize the integer immediate operand: $dst = G_CONSTANT $imm.
+  G_CONSTANT = 32,
+
+  /// Unconditional branch to the basic block operand.
+  G_BR = 33,
+
+  /// Branch to the basic block operand if the condition register is 1:
+  /// G_BRCOND $cond, $target.
+  G_BRCOND = 34,
+
+  /// Materialize the address of the stack object operand:
+  /// $dst = G_FRAME_INDEX $fi.
+  G_FRAME_INDEX = 35,
+
+  /// Materialize the address of the global value operand:
+  /// $dst = G_GLOBAL_VALUE @global.
+  G_GLOBAL_VALUE = 36,
+
+  /// Memory accesses: $dst = G_LOAD $addr and G_STORE $src, $addr. The size of
+  /// the access is the one of the memory operand, which is smaller than the
+  /// register for booleans; a G_LOAD then zero extends the value.
+  G_LOAD = 37,
+  G_STORE = 38,
+
+  PRE_ISEL_GENERIC_OPCODE_START = G_ADD,
+  PRE_ISEL_GENERIC_OPCODE_END = G_STORE
 };
+
+/// Return true if \p Opcode is one of the generic opcodes that have to be
+/// selected.
+inline bool isPreISelGenericOpcode(unsigned Opcode) {
+  return Opcode >= PRE_ISEL_GENERIC_OPCODE_START &&
+         Opcode <= PRE_ISEL_GENERIC_OPCODE_END;
+}
 } // end namespace TargetOpcode
 } // end namespace llvm
 
@@ -20,7 +20,9 @@
 
 namespace llvm {
 
+class CallLowering;
 class DataLayout;
+class InstructionSelector;
 class MachineFunction;
 class MachineInstr;
 class SDep;
@@ -74,6 +76,16 @@ public:
     return nullptr;
   }
 
+  /// Return the argument and return lowering of the global instruction
+  /// selector, or null if the target doesn't support that selector.
+  virtual const CallLowering *getCallLowering() const { return nullptr; }
+
+  /// Return the target instruction selector of the global instruction
+  /// selector, or null if the target doesn't support that selector.
+  virtual const InstructionSelector *getInstructionSelector() const {
+    return nullptr;
+  }
+
   /// getRegisterInfo - If register information is available, return it.  If
   /// not, return null.  This is kept separate from RegInfo until RegInfo has
   /// details of graph coloring register allocation removed from it.
@@ -22,6 +22,7 @@ namespace llvm {
 class ModulePass;
 class Pass;
 class Function;
+class FunctionInfoIndex;
 class BasicBlock;
 class GlobalValue;
 
@@ -203,6 +204,11 @@ ModulePass *createBarrierNoopPass();
 /// to bitsets.
 ModulePass *createLowerBitSetsPass();
 
+/// \brief This pass imports the definitions of small external functions from
+/// other modules, as directed by a combined function summary index. If Index
+/// is null, the index is read from the file given by -summary-file.
+ModulePass *createFunctionImportPass(const FunctionInfoIndex *Index = nullptr);
+
 } // End llvm namespace
 
 #endif
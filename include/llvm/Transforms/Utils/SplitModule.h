@@ -0,0 +1,44 @@
+//===- SplitModule.h - Split a module into partitions -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for large modules and for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+#define LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+
+#include <functional>
+#include <memory>
+
+namespace llvm {
+
+class Module;
+
+/// Splits the module M into N linkable partitions. The function ModuleCallback
+/// is called N times passing each individual partition as the MPart argument.
+///
+/// Global definitions are assigned to partitions by a hash of their name (or
+/// of their comdat's name), so the partitioning only depends on the contents
+/// of M and on N. Symbols with local linkage are given hidden visibility and a
+/// name that is unique to M, so that references across partitions resolve and
+/// cannot collide with symbols defined outside the module. This renaming is
+/// done in place, so M is left with the externalized symbols.
+///
+/// FIXME: Internal symbols defined in module-level inline asm are only visible
+/// to the first partition, which is the only one that keeps the inline asm.
+void SplitModule(
+    Module &M, unsigned N,
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback);
+
+} // End llvm namespace
+
+#endif
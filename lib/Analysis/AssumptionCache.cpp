@@ -100,6 +100,7 @@ AssumptionCache &AssumptionCacheTracker::getAssumptionCache(Function &F) {
   // around the function in common cases. This makes insertion a bit slower,
   // but if we have to insert we're going to scan the whole function so that
   // shouldn't matter.
+  sys::ScopedLock Lock(CachesLock);
   auto I = AssumptionCaches.find_as(&F);
   if (I != AssumptionCaches.end())
     return *I->second;
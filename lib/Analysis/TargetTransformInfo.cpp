@@ -14,6 +14,7 @@
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -323,8 +324,19 @@ TargetTransformInfoWrapperPass::TargetTransformInfoWrapperPass(
 }
 
 TargetTransformInfo &TargetTransformInfoWrapperPass::getTTI(Function &F) {
-  TTI = TIRA.run(F);
-  return *TTI;
+  if (!F.getContext().isMultithreaded()) {
+    ThreadTTI.clear();
+    TTI = TIRA.run(F);
+    return *TTI;
+  }
+
+  // Each thread keeps its result until it asks for the next one. Creating the
+  // result may fill in caches of the target machine, so it is serialized.
+  std::lock_guard<std::mutex> Lock(ThreadTTILock);
+  Optional<TargetTransformInfo> &ThisTTI =
+      ThreadTTI[std::this_thread::get_id()];
+  ThisTTI = TIRA.run(F);
+  return *ThisTTI;
 }
 
 ImmutablePass *
@@ -20,6 +20,7 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/GVMaterializer.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -100,16 +101,26 @@ class BitcodeReaderMDValueList {
   unsigned MaxFwdRef;
   std::vector<TrackingMDRef> MDValuePtrs;
 
+  /// The IDs below this one can be loaded on demand through the index of the
+  /// module-level metadata block.
+  unsigned NumLazyMDs;
+  /// IDs that were referenced while they were still in the index.
+  std::vector<unsigned> PendingLazyLoads;
+
   LLVMContext &Context;
 public:
   BitcodeReaderMDValueList(LLVMContext &C)
-      : NumFwdRefs(0), AnyFwdRefs(false), Context(C) {}
+      : NumFwdRefs(0), AnyFwdRefs(false), NumLazyMDs(0), Context(C) {}
 
   // vector compatibility methods
   unsigned size() const       { return MDValuePtrs.size(); }
   void resize(unsigned N)     { MDValuePtrs.resize(N); }
   void push_back(Metadata *MD) { MDValuePtrs.emplace_back(MD); }
-  void clear()                { MDValuePtrs.clear();  }
+  void clear() {
+    MDValuePtrs.clear();
+    NumLazyMDs = 0;
+    PendingLazyLoads.clear();
+  }
   Metadata *back() const      { return MDValuePtrs.back(); }
   void pop_back()             { MDValuePtrs.pop_back(); }
   bool empty() const          { return MDValuePtrs.empty(); }
@@ -127,6 +138,34 @@ public:
   Metadata *getValueFwdRef(unsigned Idx);
   void AssignValue(Metadata *MD, unsigned Idx);
   void tryToResolveCycles();
+
+  /// Make the first N IDs loadable on demand. References to them create
+  /// placeholders that are queued until takeLazyLoad() returns them.
+  void setNumLazyMDs(unsigned N) {
+    if (N > size())
+      resize(N);
+    NumLazyMDs = N;
+  }
+
+  /// Return true if Idx is yet to be loaded from the index.
+  bool needsLazyLoad(unsigned Idx) const {
+    if (Idx >= NumLazyMDs)
+      return false;
+    auto *N = dyn_cast_or_null<MDNode>(MDValuePtrs[Idx].get());
+    return !MDValuePtrs[Idx] || (N && N->isTemporary());
+  }
+
+  /// Get the next ID that was referenced but is yet to be loaded from the
+  /// index. Returns false if there is none.
+  bool takeLazyLoad(unsigned &Idx) {
+    while (!PendingLazyLoads.empty()) {
+      Idx = PendingLazyLoads.back();
+      PendingLazyLoads.pop_back();
+      if (needsLazyLoad(Idx))
+        return true;
+    }
+    return false;
+  }
 };
 
 class BitcodeReader : public GVMaterializer {
@@ -192,6 +231,13 @@ class BitcodeReader : public GVMaterializer {
   /// which Metadata blocks are deferred.
   std::vector<uint64_t> DeferredMetadataInfo;
 
+  /// When metadata is loaded lazily and the module-level metadata block has
+  /// an index, the nodes are loaded one by one as they are referenced. This
+  /// is a cursor in that block and the bit position of the record of each
+  /// metadata ID, followed by the position of the named metadata.
+  BitstreamCursor MetadataCursor;
+  std::vector<uint64_t> MetadataIndex;
+
   /// These are basic blocks forward-referenced by block addresses.  They are
   /// inserted lazily into functions when they're loaded.  The basic block ID is
   /// its index into the vector.
@@ -251,6 +297,9 @@ public:
   /// @returns true if an error occurred.
   ErrorOr<std::string> parseTriple();
 
+  /// @brief Read only the function summaries of the bitcode into Index.
+  std::error_code parseFunctionSummaries(FunctionInfoIndex &Index);
+
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
   /// Materialize any deferred Metadata block.
@@ -364,12 +413,22 @@ private:
   std::error_code RememberAndSkipFunctionBody();
   /// Save the positions of the Metadata blocks and skip parsing the blocks.
   std::error_code rememberAndSkipMetadata();
+  std::error_code parseMetadataIndex(bool &HasIndex);
+  std::error_code parseDeferredMetadata();
+  std::error_code loadLazyMetadata(unsigned ID);
+  std::error_code resolveLazyMetadata();
   std::error_code ParseFunctionBody(Function *F);
   std::error_code GlobalCleanup();
   std::error_code ResolveGlobalAndAliasInits();
   std::error_code ParseMetadata();
+  std::error_code parseMetadataRecord(BitstreamCursor &Cursor, unsigned Code,
+                                      SmallVectorImpl<uint64_t> &Record,
+                                      unsigned &NextMDValueNo);
   std::error_code ParseMetadataAttachment(Function &F);
   ErrorOr<std::string> parseModuleTriple();
+  std::error_code parseModuleFunctionSummaries(FunctionInfoIndex &Index);
+  std::error_code parseFunctionSummaryBlock(FunctionInfoIndex &Index,
+                                            bool IsCombined);
   std::error_code ParseUseLists();
   std::error_code InitStream();
   std::error_code InitStreamFromBuffer();
@@ -486,6 +545,7 @@ void BitcodeReader::FreeState() {
   std::vector<Function*>().swap(FunctionsWithBodies);
   DeferredFunctionInfo.clear();
   DeferredMetadataInfo.clear();
+  std::vector<uint64_t>().swap(MetadataIndex);
   MDKindMap.clear();
 
   assert(BasicBlockFwdRefs.empty() && "Unresolved blockaddress fwd references");
@@ -941,6 +1001,8 @@ Metadata *BitcodeReaderMDValueList::getValueFwdRef(unsigned Idx) {
   // Create and return a placeholder, which will later be RAUW'd.
   Metadata *MD = MDNode::getTemporary(Context, None).release();
   MDValuePtrs[Idx].reset(MD);
+  if (Idx < NumLazyMDs)
+    PendingLazyLoads.push_back(Idx);
   return MD;
 }
 
@@ -1591,22 +1653,6 @@ std::error_code BitcodeReader::ParseMetadata() {
 
   SmallVector<uint64_t, 64> Record;
 
-  auto getMD =
-      [&](unsigned ID) -> Metadata *{ return MDValueList.getValueFwdRef(ID); };
-  auto getMDOrNull = [&](unsigned ID) -> Metadata *{
-    if (ID)
-      return getMD(ID - 1);
-    return nullptr;
-  };
-  auto getMDString = [&](unsigned ID) -> MDString *{
-    // This requires that the ID is not really a forward reference.  In
-    // particular, the MDString must already have been resolved.
-    return cast_or_null<MDString>(getMDOrNull(ID));
-  };
-
-#define GET_OR_DISTINCT(CLASS, DISTINCT, ARGS)                                 \
-  (DISTINCT ? CLASS::getDistinct ARGS : CLASS::get ARGS)
-
   // Read all the records.
   while (1) {
     BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
@@ -1626,400 +1672,435 @@ std::error_code BitcodeReader::ParseMetadata() {
     // Read a record.
     Record.clear();
     unsigned Code = Stream.readRecord(Entry.ID, Record);
-    bool IsDistinct = false;
-    switch (Code) {
-    default:  // Default behavior: ignore.
-      break;
-    case bitc::METADATA_NAME: {
-      // Read name of the named metadata.
-      SmallString<8> Name(Record.begin(), Record.end());
-      Record.clear();
-      Code = Stream.ReadCode();
-
-      unsigned NextBitCode = Stream.readRecord(Code, Record);
-      if (NextBitCode != bitc::METADATA_NAMED_NODE)
-        return Error("METADATA_NAME not followed by METADATA_NAMED_NODE");
-
-      // Read named metadata elements.
-      unsigned Size = Record.size();
-      NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
-      for (unsigned i = 0; i != Size; ++i) {
-        MDNode *MD = dyn_cast_or_null<MDNode>(MDValueList.getValueFwdRef(Record[i]));
-        if (!MD)
-          return Error("Invalid record");
-        NMD->addOperand(MD);
-      }
-      break;
-    }
-    case bitc::METADATA_OLD_FN_NODE: {
-      // FIXME: Remove in 4.0.
-      // This is a LocalAsMetadata record, the only type of function-local
-      // metadata.
-      if (Record.size() % 2 == 1)
-        return Error("Invalid record");
+    if (std::error_code EC =
+            parseMetadataRecord(Stream, Code, Record, NextMDValueNo))
+      return EC;
+  }
+}
 
-      // If this isn't a LocalAsMetadata record, we're dropping it.  This used
-      // to be legal, but there's no upgrade path.
-      auto dropRecord = [&] {
-        MDValueList.AssignValue(MDNode::get(Context, None), NextMDValueNo++);
-      };
-      if (Record.size() != 2) {
-        dropRecord();
-        break;
+/// Parse a single record of a METADATA_BLOCK that was read from Cursor,
+/// assigning metadata IDs from NextMDValueNo.
+std::error_code
+BitcodeReader::parseMetadataRecord(BitstreamCursor &Cursor, unsigned Code,
+                                   SmallVectorImpl<uint64_t> &Record,
+                                   unsigned &NextMDValueNo) {
+  auto getMD =
+      [&](unsigned ID) -> Metadata *{ return MDValueList.getValueFwdRef(ID); };
+  auto getMDOrNull = [&](unsigned ID) -> Metadata *{
+    if (ID)
+      return getMD(ID - 1);
+    return nullptr;
+  };
+  std::error_code LazyEC;
+  auto getMDString = [&](unsigned ID) -> MDString *{
+    // This requires that the ID is not really a forward reference.  In
+    // particular, the MDString must already have been resolved, so load it
+    // right away if it is still in the index.
+    if (ID && MDValueList.needsLazyLoad(ID - 1))
+      if (std::error_code EC = loadLazyMetadata(ID - 1)) {
+        LazyEC = EC;
+        return nullptr;
       }
+    return cast_or_null<MDString>(getMDOrNull(ID));
+  };
 
-      Type *Ty = getTypeByID(Record[0]);
-      if (Ty->isMetadataTy() || Ty->isVoidTy()) {
-        dropRecord();
-        break;
-      }
+#define GET_OR_DISTINCT(CLASS, DISTINCT, ARGS)                                 \
+  (DISTINCT ? CLASS::getDistinct ARGS : CLASS::get ARGS)
 
-      MDValueList.AssignValue(
-          LocalAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_OLD_NODE: {
-      // FIXME: Remove in 4.0.
-      if (Record.size() % 2 == 1)
-        return Error("Invalid record");
+  bool IsDistinct = false;
+  switch (Code) {
+  default:  // Default behavior: ignore.
+    break;
+  case bitc::METADATA_NAME: {
+    // Read name of the named metadata.
+    SmallString<8> Name(Record.begin(), Record.end());
+    Record.clear();
+    Code = Cursor.ReadCode();
 
-      unsigned Size = Record.size();
-      SmallVector<Metadata *, 8> Elts;
-      for (unsigned i = 0; i != Size; i += 2) {
-        Type *Ty = getTypeByID(Record[i]);
-        if (!Ty)
-          return Error("Invalid record");
-        if (Ty->isMetadataTy())
-          Elts.push_back(MDValueList.getValueFwdRef(Record[i+1]));
-        else if (!Ty->isVoidTy()) {
-          auto *MD =
-              ValueAsMetadata::get(ValueList.getValueFwdRef(Record[i + 1], Ty));
-          assert(isa<ConstantAsMetadata>(MD) &&
-                 "Expected non-function-local metadata");
-          Elts.push_back(MD);
-        } else
-          Elts.push_back(nullptr);
-      }
-      MDValueList.AssignValue(MDNode::get(Context, Elts), NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_VALUE: {
-      if (Record.size() != 2)
-        return Error("Invalid record");
+    unsigned NextBitCode = Cursor.readRecord(Code, Record);
+    if (NextBitCode != bitc::METADATA_NAMED_NODE)
+      return Error("METADATA_NAME not followed by METADATA_NAMED_NODE");
 
-      Type *Ty = getTypeByID(Record[0]);
-      if (Ty->isMetadataTy() || Ty->isVoidTy())
+    // Read named metadata elements.
+    unsigned Size = Record.size();
+    NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
+    for (unsigned i = 0; i != Size; ++i) {
+      MDNode *MD = dyn_cast_or_null<MDNode>(MDValueList.getValueFwdRef(Record[i]));
+      if (!MD)
         return Error("Invalid record");
-
-      MDValueList.AssignValue(
-          ValueAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
-          NextMDValueNo++);
-      break;
+      NMD->addOperand(MD);
     }
-    case bitc::METADATA_DISTINCT_NODE:
-      IsDistinct = true;
-      // fallthrough...
-    case bitc::METADATA_NODE: {
-      SmallVector<Metadata *, 8> Elts;
-      Elts.reserve(Record.size());
-      for (unsigned ID : Record)
-        Elts.push_back(ID ? MDValueList.getValueFwdRef(ID - 1) : nullptr);
-      MDValueList.AssignValue(IsDistinct ? MDNode::getDistinct(Context, Elts)
-                                         : MDNode::get(Context, Elts),
-                              NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_OLD_FN_NODE: {
+    // FIXME: Remove in 4.0.
+    // This is a LocalAsMetadata record, the only type of function-local
+    // metadata.
+    if (Record.size() % 2 == 1)
+      return Error("Invalid record");
+
+    // If this isn't a LocalAsMetadata record, we're dropping it.  This used
+    // to be legal, but there's no upgrade path.
+    auto dropRecord = [&] {
+      MDValueList.AssignValue(MDNode::get(Context, None), NextMDValueNo++);
+    };
+    if (Record.size() != 2) {
+      dropRecord();
       break;
     }
-    case bitc::METADATA_LOCATION: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
 
-      unsigned Line = Record[1];
-      unsigned Column = Record[2];
-      MDNode *Scope = cast<MDNode>(MDValueList.getValueFwdRef(Record[3]));
-      Metadata *InlinedAt =
-          Record[4] ? MDValueList.getValueFwdRef(Record[4] - 1) : nullptr;
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DILocation, Record[0],
-                          (Context, Line, Column, Scope, InlinedAt)),
-          NextMDValueNo++);
+    Type *Ty = getTypeByID(Record[0]);
+    if (Ty->isMetadataTy() || Ty->isVoidTy()) {
+      dropRecord();
       break;
     }
-    case bitc::METADATA_GENERIC_DEBUG: {
-      if (Record.size() < 4)
-        return Error("Invalid record");
 
-      unsigned Tag = Record[1];
-      unsigned Version = Record[2];
+    MDValueList.AssignValue(
+        LocalAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_OLD_NODE: {
+    // FIXME: Remove in 4.0.
+    if (Record.size() % 2 == 1)
+      return Error("Invalid record");
 
-      if (Tag >= 1u << 16 || Version != 0)
+    unsigned Size = Record.size();
+    SmallVector<Metadata *, 8> Elts;
+    for (unsigned i = 0; i != Size; i += 2) {
+      Type *Ty = getTypeByID(Record[i]);
+      if (!Ty)
         return Error("Invalid record");
-
-      auto *Header = getMDString(Record[3]);
-      SmallVector<Metadata *, 8> DwarfOps;
-      for (unsigned I = 4, E = Record.size(); I != E; ++I)
-        DwarfOps.push_back(Record[I] ? MDValueList.getValueFwdRef(Record[I] - 1)
-                                     : nullptr);
-      MDValueList.AssignValue(GET_OR_DISTINCT(GenericDINode, Record[0],
-                                              (Context, Tag, Header, DwarfOps)),
-                              NextMDValueNo++);
-      break;
+      if (Ty->isMetadataTy())
+        Elts.push_back(MDValueList.getValueFwdRef(Record[i+1]));
+      else if (!Ty->isVoidTy()) {
+        auto *MD =
+            ValueAsMetadata::get(ValueList.getValueFwdRef(Record[i + 1], Ty));
+        assert(isa<ConstantAsMetadata>(MD) &&
+               "Expected non-function-local metadata");
+        Elts.push_back(MD);
+      } else
+        Elts.push_back(nullptr);
     }
-    case bitc::METADATA_SUBRANGE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    MDValueList.AssignValue(MDNode::get(Context, Elts), NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_VALUE: {
+    if (Record.size() != 2)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DISubrange, Record[0],
-                          (Context, Record[1], unrotateSign(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_ENUMERATOR: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    Type *Ty = getTypeByID(Record[0]);
+    if (Ty->isMetadataTy() || Ty->isVoidTy())
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(GET_OR_DISTINCT(DIEnumerator, Record[0],
-                                              (Context, unrotateSign(Record[1]),
-                                               getMDString(Record[2]))),
-                              NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_BASIC_TYPE: {
-      if (Record.size() != 6)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        ValueAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_DISTINCT_NODE:
+    IsDistinct = true;
+    // fallthrough...
+  case bitc::METADATA_NODE: {
+    SmallVector<Metadata *, 8> Elts;
+    Elts.reserve(Record.size());
+    for (unsigned ID : Record)
+      Elts.push_back(ID ? MDValueList.getValueFwdRef(ID - 1) : nullptr);
+    MDValueList.AssignValue(IsDistinct ? MDNode::getDistinct(Context, Elts)
+                                       : MDNode::get(Context, Elts),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LOCATION: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIBasicType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           Record[3], Record[4], Record[5])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_DERIVED_TYPE: {
-      if (Record.size() != 12)
-        return Error("Invalid record");
+    unsigned Line = Record[1];
+    unsigned Column = Record[2];
+    MDNode *Scope = cast<MDNode>(MDValueList.getValueFwdRef(Record[3]));
+    Metadata *InlinedAt =
+        Record[4] ? MDValueList.getValueFwdRef(Record[4] - 1) : nullptr;
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DILocation, Record[0],
+                        (Context, Line, Column, Scope, InlinedAt)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_GENERIC_DEBUG: {
+    if (Record.size() < 4)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIDerivedType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDOrNull(Record[5]), getMDOrNull(Record[6]),
-                           Record[7], Record[8], Record[9], Record[10],
-                           getMDOrNull(Record[11]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_COMPOSITE_TYPE: {
-      if (Record.size() != 16)
-        return Error("Invalid record");
+    unsigned Tag = Record[1];
+    unsigned Version = Record[2];
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DICompositeType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDOrNull(Record[5]), getMDOrNull(Record[6]),
-                           Record[7], Record[8], Record[9], Record[10],
-                           getMDOrNull(Record[11]), Record[12],
-                           getMDOrNull(Record[13]), getMDOrNull(Record[14]),
-                           getMDString(Record[15]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_SUBROUTINE_TYPE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    if (Tag >= 1u << 16 || Version != 0)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DISubroutineType, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_FILE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    auto *Header = getMDString(Record[3]);
+    SmallVector<Metadata *, 8> DwarfOps;
+    for (unsigned I = 4, E = Record.size(); I != E; ++I)
+      DwarfOps.push_back(Record[I] ? MDValueList.getValueFwdRef(Record[I] - 1)
+                                   : nullptr);
+    MDValueList.AssignValue(GET_OR_DISTINCT(GenericDINode, Record[0],
+                                            (Context, Tag, Header, DwarfOps)),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBRANGE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIFile, Record[0], (Context, getMDString(Record[1]),
-                                              getMDString(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_COMPILE_UNIT: {
-      if (Record.size() < 14 || Record.size() > 15)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DISubrange, Record[0],
+                        (Context, Record[1], unrotateSign(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_ENUMERATOR: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DICompileUnit, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDString(Record[3]), Record[4],
-                           getMDString(Record[5]), Record[6],
-                           getMDString(Record[7]), Record[8],
-                           getMDOrNull(Record[9]), getMDOrNull(Record[10]),
-                           getMDOrNull(Record[11]), getMDOrNull(Record[12]),
-                           getMDOrNull(Record[13]),
-                           Record.size() == 14 ? 0 : Record[14])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_SUBPROGRAM: {
-      if (Record.size() != 19)
-        return Error("Invalid record");
+    MDValueList.AssignValue(GET_OR_DISTINCT(DIEnumerator, Record[0],
+                                            (Context, unrotateSign(Record[1]),
+                                             getMDString(Record[2]))),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_BASIC_TYPE: {
+    if (Record.size() != 6)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(
-              DISubprogram, Record[0],
-              (Context, getMDOrNull(Record[1]), getMDString(Record[2]),
-               getMDString(Record[3]), getMDOrNull(Record[4]), Record[5],
-               getMDOrNull(Record[6]), Record[7], Record[8], Record[9],
-               getMDOrNull(Record[10]), Record[11], Record[12], Record[13],
-               Record[14], getMDOrNull(Record[15]), getMDOrNull(Record[16]),
-               getMDOrNull(Record[17]), getMDOrNull(Record[18]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LEXICAL_BLOCK: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIBasicType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         Record[3], Record[4], Record[5])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_DERIVED_TYPE: {
+    if (Record.size() != 12)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DILexicalBlock, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), Record[3], Record[4])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LEXICAL_BLOCK_FILE: {
-      if (Record.size() != 4)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIDerivedType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDOrNull(Record[5]), getMDOrNull(Record[6]),
+                         Record[7], Record[8], Record[9], Record[10],
+                         getMDOrNull(Record[11]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_COMPOSITE_TYPE: {
+    if (Record.size() != 16)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DILexicalBlockFile, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), Record[3])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_NAMESPACE: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DICompositeType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDOrNull(Record[5]), getMDOrNull(Record[6]),
+                         Record[7], Record[8], Record[9], Record[10],
+                         getMDOrNull(Record[11]), Record[12],
+                         getMDOrNull(Record[13]), getMDOrNull(Record[14]),
+                         getMDString(Record[15]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBROUTINE_TYPE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DINamespace, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), getMDString(Record[3]),
-                           Record[4])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_TEMPLATE_TYPE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DISubroutineType, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_FILE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(GET_OR_DISTINCT(DITemplateTypeParameter,
-                                              Record[0],
-                                              (Context, getMDString(Record[1]),
-                                               getMDOrNull(Record[2]))),
-                              NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_TEMPLATE_VALUE: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIFile, Record[0], (Context, getMDString(Record[1]),
+                                            getMDString(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_COMPILE_UNIT: {
+    if (Record.size() < 14 || Record.size() > 15)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DITemplateValueParameter, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), getMDOrNull(Record[4]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_GLOBAL_VAR: {
-      if (Record.size() != 11)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DICompileUnit, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDString(Record[3]), Record[4],
+                         getMDString(Record[5]), Record[6],
+                         getMDString(Record[7]), Record[8],
+                         getMDOrNull(Record[9]), getMDOrNull(Record[10]),
+                         getMDOrNull(Record[11]), getMDOrNull(Record[12]),
+                         getMDOrNull(Record[13]),
+                         Record.size() == 14 ? 0 : Record[14])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBPROGRAM: {
+    if (Record.size() != 19)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIGlobalVariable, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDString(Record[2]), getMDString(Record[3]),
-                           getMDOrNull(Record[4]), Record[5],
-                           getMDOrNull(Record[6]), Record[7], Record[8],
-                           getMDOrNull(Record[9]), getMDOrNull(Record[10]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LOCAL_VAR: {
-      // 10th field is for the obseleted 'inlinedAt:' field.
-      if (Record.size() != 9 && Record.size() != 10)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(
+            DISubprogram, Record[0],
+            (Context, getMDOrNull(Record[1]), getMDString(Record[2]),
+             getMDString(Record[3]), getMDOrNull(Record[4]), Record[5],
+             getMDOrNull(Record[6]), Record[7], Record[8], Record[9],
+             getMDOrNull(Record[10]), Record[11], Record[12], Record[13],
+             Record[14], getMDOrNull(Record[15]), getMDOrNull(Record[16]),
+             getMDOrNull(Record[17]), getMDOrNull(Record[18]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LEXICAL_BLOCK: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DILocalVariable, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDString(Record[3]), getMDOrNull(Record[4]),
-                           Record[5], getMDOrNull(Record[6]), Record[7],
-                           Record[8])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_EXPRESSION: {
-      if (Record.size() < 1)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DILexicalBlock, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), Record[3], Record[4])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LEXICAL_BLOCK_FILE: {
+    if (Record.size() != 4)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIExpression, Record[0],
-                          (Context, makeArrayRef(Record).slice(1))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_OBJC_PROPERTY: {
-      if (Record.size() != 8)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DILexicalBlockFile, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), Record[3])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_NAMESPACE: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIObjCProperty, Record[0],
-                          (Context, getMDString(Record[1]),
-                           getMDOrNull(Record[2]), Record[3],
-                           getMDString(Record[4]), getMDString(Record[5]),
-                           Record[6], getMDOrNull(Record[7]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_IMPORTED_ENTITY: {
-      if (Record.size() != 6)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DINamespace, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), getMDString(Record[3]),
+                         Record[4])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_TEMPLATE_TYPE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(DIImportedEntity, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDString(Record[5]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_STRING: {
-      std::string String(Record.begin(), Record.end());
-      llvm::UpgradeMDStringConstant(String);
-      Metadata *MD = MDString::get(Context, String);
-      MDValueList.AssignValue(MD, NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_KIND: {
-      if (Record.size() < 2)
-        return Error("Invalid record");
+    MDValueList.AssignValue(GET_OR_DISTINCT(DITemplateTypeParameter,
+                                            Record[0],
+                                            (Context, getMDString(Record[1]),
+                                             getMDOrNull(Record[2]))),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_TEMPLATE_VALUE: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      unsigned Kind = Record[0];
-      SmallString<8> Name(Record.begin()+1, Record.end());
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DITemplateValueParameter, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), getMDOrNull(Record[4]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_GLOBAL_VAR: {
+    if (Record.size() != 11)
+      return Error("Invalid record");
 
-      unsigned NewKind = TheModule->getMDKindID(Name.str());
-      if (!MDKindMap.insert(std::make_pair(Kind, NewKind)).second)
-        return Error("Conflicting METADATA_KIND records");
-      break;
-    }
-    }
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIGlobalVariable, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDString(Record[2]), getMDString(Record[3]),
+                         getMDOrNull(Record[4]), Record[5],
+                         getMDOrNull(Record[6]), Record[7], Record[8],
+                         getMDOrNull(Record[9]), getMDOrNull(Record[10]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LOCAL_VAR: {
+    // 10th field is for the obseleted 'inlinedAt:' field.
+    if (Record.size() != 9 && Record.size() != 10)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DILocalVariable, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDString(Record[3]), getMDOrNull(Record[4]),
+                         Record[5], getMDOrNull(Record[6]), Record[7],
+                         Record[8])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_EXPRESSION: {
+    if (Record.size() < 1)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIExpression, Record[0],
+                        (Context, makeArrayRef(Record).slice(1))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_OBJC_PROPERTY: {
+    if (Record.size() != 8)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIObjCProperty, Record[0],
+                        (Context, getMDString(Record[1]),
+                         getMDOrNull(Record[2]), Record[3],
+                         getMDString(Record[4]), getMDString(Record[5]),
+                         Record[6], getMDOrNull(Record[7]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_IMPORTED_ENTITY: {
+    if (Record.size() != 6)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(DIImportedEntity, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDString(Record[5]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_STRING: {
+    std::string String(Record.begin(), Record.end());
+    llvm::UpgradeMDStringConstant(String);
+    Metadata *MD = MDString::get(Context, String);
+    MDValueList.AssignValue(MD, NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_KIND: {
+    if (Record.size() < 2)
+      return Error("Invalid record");
+
+    unsigned Kind = Record[0];
+    SmallString<8> Name(Record.begin()+1, Record.end());
+
+    unsigned NewKind = TheModule->getMDKindID(Name.str());
+    if (!MDKindMap.insert(std::make_pair(Kind, NewKind)).second)
+      return Error("Conflicting METADATA_KIND records");
+    break;
+  }
   }
 #undef GET_OR_DISTINCT
+  return LazyEC;
 }
 
 /// decodeSignRotatedValue - Decode a signed value stored with the sign bit in
@@ -2641,7 +2722,14 @@ std::error_code BitcodeReader::ParseUseLists() {
 std::error_code BitcodeReader::rememberAndSkipMetadata() {
   // Save the current stream state.
   uint64_t CurBit = Stream.GetCurrentBitNo();
-  DeferredMetadataInfo.push_back(CurBit);
+
+  // If the block has an index, its nodes are loaded when they are first
+  // referenced rather than with the rest of the deferred blocks.
+  bool HasIndex;
+  if (std::error_code EC = parseMetadataIndex(HasIndex))
+    return EC;
+  if (!HasIndex)
+    DeferredMetadataInfo.push_back(CurBit);
 
   // Skip over the block for now.
   if (Stream.SkipBlock())
@@ -2649,7 +2737,58 @@ std::error_code BitcodeReader::rememberAndSkipMetadata() {
   return std::error_code();
 }
 
-std::error_code BitcodeReader::materializeMetadata() {
+/// Look for an index at the start of the metadata block at the current
+/// position of the stream, and if there is one, make the metadata IDs that
+/// the block defines loadable on demand.
+std::error_code BitcodeReader::parseMetadataIndex(bool &HasIndex) {
+  HasIndex = false;
+
+  // Only the module-level block, which defines the first IDs, is indexed.
+  if (!MetadataIndex.empty() || !DeferredMetadataInfo.empty() ||
+      !MDValueList.empty())
+    return std::error_code();
+
+  // Peek into the block with a copy of the stream, which keeps the
+  // abbreviations of the block for the lazy loads.
+  BitstreamCursor Cursor = Stream;
+  if (Cursor.EnterSubBlock(bitc::METADATA_BLOCK_ID))
+    return Error("Invalid record");
+  BitstreamEntry Entry = Cursor.advanceSkippingSubblocks();
+  if (Entry.Kind != BitstreamEntry::Record)
+    return std::error_code();
+  SmallVector<uint64_t, 64> Record;
+  if (Cursor.readRecord(Entry.ID, Record) != bitc::METADATA_INDEX_OFFSET)
+    return std::error_code();
+  if (Record.size() != 2)
+    return Error("Invalid record");
+
+  // The offset and the positions in the index are relative to the end of
+  // the METADATA_INDEX_OFFSET record.
+  uint64_t BeginPos = Cursor.GetCurrentBitNo();
+  Cursor.JumpToBit(BeginPos + (Record[0] | (Record[1] << 32)));
+  Entry = Cursor.advanceSkippingSubblocks();
+  if (Entry.Kind != BitstreamEntry::Record)
+    return Error("Invalid metadata index");
+  Record.clear();
+  if (Cursor.readRecord(Entry.ID, Record) != bitc::METADATA_INDEX ||
+      Record.empty())
+    return Error("Invalid metadata index");
+
+  uint64_t Pos = BeginPos;
+  MetadataIndex.reserve(Record.size());
+  for (uint64_t Delta : Record) {
+    Pos += Delta;
+    MetadataIndex.push_back(Pos);
+  }
+  MetadataCursor = Cursor;
+  MDValueList.setNumLazyMDs(MetadataIndex.size() - 1);
+  HasIndex = true;
+  return std::error_code();
+}
+
+/// Parse the metadata blocks that were skipped, other than the one that is
+/// loaded through its index.
+std::error_code BitcodeReader::parseDeferredMetadata() {
   for (uint64_t BitPos : DeferredMetadataInfo) {
     // Move the bit stream to the saved position.
     Stream.JumpToBit(BitPos);
@@ -2660,6 +2799,72 @@ std::error_code BitcodeReader::materializeMetadata() {
   return std::error_code();
 }
 
+/// Load the record of metadata ID from the index.
+std::error_code BitcodeReader::loadLazyMetadata(unsigned ID) {
+  MetadataCursor.JumpToBit(MetadataIndex[ID]);
+  BitstreamEntry Entry = MetadataCursor.advanceSkippingSubblocks();
+  if (Entry.Kind != BitstreamEntry::Record)
+    return Error("Invalid metadata index");
+
+  SmallVector<uint64_t, 64> Record;
+  unsigned Code = MetadataCursor.readRecord(Entry.ID, Record);
+  unsigned NextMDValueNo = ID;
+  if (std::error_code EC =
+          parseMetadataRecord(MetadataCursor, Code, Record, NextMDValueNo))
+    return EC;
+  if (NextMDValueNo != ID + 1)
+    return Error("Invalid metadata index");
+  return std::error_code();
+}
+
+/// Load the metadata that was referenced since the last call, along with
+/// everything that it refers to.
+std::error_code BitcodeReader::resolveLazyMetadata() {
+  unsigned ID;
+  while (MDValueList.takeLazyLoad(ID))
+    if (std::error_code EC = loadLazyMetadata(ID))
+      return EC;
+  MDValueList.tryToResolveCycles();
+  return std::error_code();
+}
+
+std::error_code BitcodeReader::materializeMetadata() {
+  if (std::error_code EC = parseDeferredMetadata())
+    return EC;
+  if (MetadataIndex.empty())
+    return std::error_code();
+
+  // Load the nodes that nothing referenced so far, in order, so that most
+  // operands are already loaded.
+  for (unsigned ID = 0, E = MetadataIndex.size() - 1; ID != E; ++ID)
+    if (MDValueList.needsLazyLoad(ID))
+      if (std::error_code EC = loadLazyMetadata(ID))
+        return EC;
+  if (std::error_code EC = resolveLazyMetadata())
+    return EC;
+
+  // The named metadata runs up to the index.
+  MetadataCursor.JumpToBit(MetadataIndex.back());
+  SmallVector<uint64_t, 64> Record;
+  unsigned NextMDValueNo = MDValueList.size();
+  while (1) {
+    BitstreamEntry Entry = MetadataCursor.advanceSkippingSubblocks();
+    if (Entry.Kind != BitstreamEntry::Record)
+      return Error("Malformed block");
+    Record.clear();
+    unsigned Code = MetadataCursor.readRecord(Entry.ID, Record);
+    if (Code == bitc::METADATA_INDEX)
+      break;
+    if (std::error_code EC = parseMetadataRecord(MetadataCursor, Code, Record,
+                                                 NextMDValueNo))
+      return EC;
+  }
+
+  std::vector<uint64_t>().swap(MetadataIndex);
+  MDValueList.setNumLazyMDs(0);
+  return std::error_code();
+}
+
 void BitcodeReader::setStripDebugInfo() { StripDebugInfo = true; }
 
 /// RememberAndSkipFunctionBody - When we see the block for a function body,
@@ -3244,6 +3449,145 @@ ErrorOr<std::string> BitcodeReader::parseTriple() {
   }
 }
 
+/// Parse a FUNCTION_SUMMARY_BLOCK. The entries of a per-module block are
+/// attributed to the module of the buffer being read, while a combined block
+/// names the module of each entry.
+std::error_code BitcodeReader::parseFunctionSummaryBlock(
+    FunctionInfoIndex &Index, bool IsCombined) {
+  if (Stream.EnterSubBlock(bitc::FUNCTION_SUMMARY_BLOCK_ID))
+    return Error("Invalid record");
+
+  // Maps the module ids of the records to the module ids of the index.
+  DenseMap<uint64_t, unsigned> ModuleIds;
+  unsigned ThisModuleId = 0;
+  if (!IsCombined)
+    ThisModuleId = Index.addModulePath(Buffer->getBufferIdentifier());
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    switch (Code) {
+    default: // Default behavior: ignore.
+      break;
+    case bitc::FS_CODE_MODULE_PATH: { // MODULE_PATH: [modid, namechar x N]
+      std::string Path;
+      if (Record.size() < 1 || ConvertToString(Record, 1, Path))
+        return Error("Invalid record");
+      ModuleIds[Record[0]] = Index.addModulePath(Path);
+      break;
+    }
+    case bitc::FS_CODE_ENTRY:
+    case bitc::FS_CODE_COMBINED_ENTRY: {
+      // ENTRY: [instcount, flags, entrycount, namechar x N]
+      // COMBINED_ENTRY: [modid, instcount, flags, entrycount, namechar x N]
+      bool HasModId = Code == bitc::FS_CODE_COMBINED_ENTRY;
+      unsigned Idx = HasModId ? 1 : 0;
+      std::string Name;
+      if (Record.size() < Idx + 3 || ConvertToString(Record, Idx + 3, Name))
+        return Error("Invalid record");
+      unsigned ModuleId = ThisModuleId;
+      if (HasModId) {
+        auto I = ModuleIds.find(Record[0]);
+        if (I == ModuleIds.end())
+          return Error("Invalid record");
+        ModuleId = I->second;
+      }
+      Index.addFunction(Name, ModuleId,
+                        FunctionSummary(Record[Idx], Record[Idx + 1],
+                                        Record[Idx + 2]));
+      break;
+    }
+    }
+  }
+}
+
+std::error_code
+BitcodeReader::parseModuleFunctionSummaries(FunctionInfoIndex &Index) {
+  if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
+    return Error("Invalid record");
+
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+
+    case BitstreamEntry::SubBlock:
+      // The summaries precede the function bodies, so there is nothing left
+      // to read once we have seen them.
+      if (Entry.ID == bitc::FUNCTION_SUMMARY_BLOCK_ID)
+        return parseFunctionSummaryBlock(Index, /*IsCombined=*/false);
+      if (Stream.SkipBlock())
+        return Error("Malformed block");
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
+std::error_code BitcodeReader::parseFunctionSummaries(FunctionInfoIndex &Index) {
+  if (std::error_code EC = InitStream())
+    return EC;
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 ||
+      Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE ||
+      Stream.Read(4) != 0xD)
+    return Error("Invalid bitcode signature");
+
+  while (1) {
+    if (Stream.AtEndOfStream())
+      return std::error_code();
+
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == bitc::MODULE_BLOCK_ID)
+        return parseModuleFunctionSummaries(Index);
+      if (Entry.ID == bitc::FUNCTION_SUMMARY_BLOCK_ID)
+        return parseFunctionSummaryBlock(Index, /*IsCombined=*/true);
+
+      // Ignore other sub-blocks.
+      if (Stream.SkipBlock())
+        return Error("Malformed block");
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
 /// ParseMetadataAttachment - Parse metadata attachments.
 std::error_code BitcodeReader::ParseMetadataAttachment(Function &F) {
   if (Stream.EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
@@ -4407,6 +4751,10 @@ OutOfRecordLoop:
     }
   }
 
+  // Load the module-level metadata that the function refers to.
+  if (std::error_code EC = resolveLazyMetadata())
+    return EC;
+
   // FIXME: Check for unresolved forward-declared metadata references
   // and clean up leaks.
 
@@ -4439,7 +4787,9 @@ std::error_code BitcodeReader::FindFunctionInStream(
 void BitcodeReader::releaseBuffer() { Buffer.release(); }
 
 std::error_code BitcodeReader::materialize(GlobalValue *GV) {
-  if (std::error_code EC = materializeMetadata())
+  // Function bodies need the metadata kinds, but the nodes in the indexed
+  // block are only loaded as the body refers to them.
+  if (std::error_code EC = parseDeferredMetadata())
     return EC;
 
   Function *F = dyn_cast<Function>(GV);
@@ -4628,6 +4978,8 @@ class BitcodeErrorCategoryType : public std::error_category {
       return "Invalid bitcode signature";
     case BitcodeError::CorruptedBitcode:
       return "Corrupted bitcode";
+    case BitcodeError::SymbolTableNotFound:
+      return "Symbol table not found";
     }
     llvm_unreachable("Unknown error type!");
   }
@@ -4723,6 +5075,18 @@ llvm::parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
   return M;
 }
 
+ErrorOr<std::unique_ptr<FunctionInfoIndex>>
+llvm::getFunctionInfoIndex(MemoryBufferRef Buffer, LLVMContext &Context,
+                           DiagnosticHandlerFunction DiagnosticHandler) {
+  std::unique_ptr<MemoryBuffer> Buf = MemoryBuffer::getMemBuffer(Buffer, false);
+  auto R = llvm::make_unique<BitcodeReader>(Buf.release(), Context,
+                                            DiagnosticHandler);
+  auto Index = llvm::make_unique<FunctionInfoIndex>();
+  if (std::error_code EC = R->parseFunctionSummaries(*Index))
+    return EC;
+  return std::move(Index);
+}
+
 std::string
 llvm::getBitcodeTargetTriple(MemoryBufferRef Buffer, LLVMContext &Context,
                              DiagnosticHandlerFunction DiagnosticHandler) {
@@ -0,0 +1,103 @@
+//===- BitcodeSymbolTable.cpp - Bitcode symbol table ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+using namespace llvm;
+
+ErrorOr<BitcodeSymbolTable> BitcodeSymbolTable::create(StringRef Data) {
+  if (Data.size() < sizeof(Header))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+
+  BitcodeSymbolTable Table;
+  Table.Data = Data;
+  Table.Hdr = reinterpret_cast<const Header *>(Data.data());
+  if (Table.Hdr->Version != CurrentVersion)
+    return make_error_code(BitcodeError::SymbolTableNotFound);
+
+  uint64_t NumSymbols = Table.Hdr->NumSymbols;
+  if (NumSymbols * sizeof(Symbol) > Data.size() - sizeof(Header))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+  Table.Symbols =
+      reinterpret_cast<const Symbol *>(Data.data() + sizeof(Header));
+
+  // Check the strings once here so that the accessors do not have to.
+  auto IsValid = [&](const Str &S) {
+    return uint64_t(S.Offset) + S.Size <= Data.size();
+  };
+  if (!IsValid(Table.Hdr->TargetTriple))
+    return make_error_code(BitcodeError::CorruptedBitcode);
+  for (unsigned I = 0; I != NumSymbols; ++I)
+    if (!IsValid(Table.Symbols[I].Name))
+      return make_error_code(BitcodeError::CorruptedBitcode);
+  return Table;
+}
+
+ErrorOr<BitcodeSymbolTable>
+llvm::getBitcodeSymbolTable(MemoryBufferRef Buffer) {
+  const unsigned char *BufPtr = (const unsigned char *)Buffer.getBufferStart();
+  const unsigned char *BufEnd = BufPtr + Buffer.getBufferSize();
+  if (Buffer.getBufferSize() & 3)
+    return make_error_code(BitcodeError::InvalidBitcodeSignature);
+  if (isBitcodeWrapper(BufPtr, BufEnd))
+    if (SkipBitcodeWrapperHeader(BufPtr, BufEnd, true))
+      return make_error_code(BitcodeError::InvalidBitcodeSignature);
+
+  // The reader is only used to find the table; the blob points into Buffer.
+  BitstreamReader StreamFile(BufPtr, BufEnd);
+  BitstreamCursor Stream(StreamFile);
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 ||
+      Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE ||
+      Stream.Read(4) != 0xD)
+    return make_error_code(BitcodeError::InvalidBitcodeSignature);
+
+  // The table follows the module block, which is skipped in one jump.
+  while (!Stream.AtEndOfStream()) {
+    BitstreamEntry Entry =
+        Stream.advance(BitstreamCursor::AF_DontAutoprocessAbbrevs);
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+    case BitstreamEntry::EndBlock:
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    case BitstreamEntry::Record:
+      // Only the padding of the Xcode 4 ranlib can follow the blocks.
+      return make_error_code(BitcodeError::SymbolTableNotFound);
+    case BitstreamEntry::SubBlock:
+      break;
+    }
+
+    if (Entry.ID != bitc::SYMTAB_BLOCK_ID) {
+      if (Stream.SkipBlock())
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      continue;
+    }
+
+    if (Stream.EnterSubBlock(bitc::SYMTAB_BLOCK_ID))
+      return make_error_code(BitcodeError::CorruptedBitcode);
+    SmallVector<uint64_t, 1> Record;
+    while (1) {
+      Entry = Stream.advanceSkippingSubblocks();
+      if (Entry.Kind != BitstreamEntry::Record)
+        return make_error_code(BitcodeError::CorruptedBitcode);
+      StringRef Blob;
+      Record.clear();
+      if (Stream.readRecord(Entry.ID, Record, &Blob) == bitc::SYMTAB_BLOB)
+        return BitcodeSymbolTable::create(Blob);
+    }
+  }
+  return make_error_code(BitcodeError::SymbolTableNotFound);
+}
@@ -13,19 +13,24 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "ValueEnumerator.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/UseListOrder.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
@@ -34,6 +39,12 @@
 #include <map>
 using namespace llvm;
 
+static cl::opt<unsigned> MetadataIndexThreshold(
+    "bitcode-mdindex-threshold", cl::Hidden, cl::init(25),
+    cl::desc("Emit an index of the module-level metadata, which allows it to "
+             "be loaded lazily, when there are more than this many metadata "
+             "records"));
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -1150,7 +1161,10 @@ static void WriteModuleMetadata(const Module *M,
   if (MDs.empty() && M->named_metadata_empty())
     return;
 
-  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+  // The index adds two abbreviations of its own, which don't fit next to all
+  // the others in 3-bit abbreviation IDs.
+  bool EmitIndex = MDs.size() > MetadataIndexThreshold;
+  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, EmitIndex ? 4 : 3);
 
   unsigned MDSAbbrev = 0;
   if (VE.hasMDString()) {
@@ -1207,8 +1221,32 @@ static void WriteModuleMetadata(const Module *M,
     NameAbbrev = Stream.EmitAbbrev(Abbv);
   }
 
+  // When there is enough metadata for it to pay off, start the block with a
+  // placeholder for the offset of an index of the records, which lets the
+  // reader materialize the nodes one by one when they are first used. The
+  // offset is backpatched once the index has been written at the end of the
+  // block.
   SmallVector<uint64_t, 64> Record;
+  uint64_t IndexOffsetBitPos = 0, IndexBeginBitPos = 0;
+  std::vector<uint64_t> IndexBitPos;
+  if (EmitIndex) {
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX_OFFSET));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    unsigned OffsetAbbrev = Stream.EmitAbbrev(Abbv);
+    Record.push_back(0);
+    Record.push_back(0);
+    Stream.EmitRecord(bitc::METADATA_INDEX_OFFSET, Record, OffsetAbbrev);
+    Record.clear();
+    IndexBeginBitPos = Stream.GetCurrentBitNo();
+    IndexOffsetBitPos = IndexBeginBitPos - 64;
+    IndexBitPos.reserve(MDs.size() + 1);
+  }
+
   for (const Metadata *MD : MDs) {
+    if (EmitIndex)
+      IndexBitPos.push_back(Stream.GetCurrentBitNo());
     if (const MDNode *N = dyn_cast<MDNode>(MD)) {
       assert(N->isResolved() && "Expected forward references to be resolved");
 
@@ -1236,6 +1274,8 @@ static void WriteModuleMetadata(const Module *M,
   }
 
   // Write named metadata.
+  if (EmitIndex)
+    IndexBitPos.push_back(Stream.GetCurrentBitNo());
   for (const NamedMDNode &NMD : M->named_metadata()) {
     // Write name.
     StringRef Str = NMD.getName();
@@ -1250,7 +1290,34 @@ static void WriteModuleMetadata(const Module *M,
     Record.clear();
   }
 
+  if (!EmitIndex) {
+    Stream.ExitBlock();
+    return;
+  }
+
+  // Write the index: the position of the record of each metadata ID, followed
+  // by the position of the named metadata, as deltas from the previous
+  // position, starting from the end of the METADATA_INDEX_OFFSET record.
+  uint64_t IndexPos = Stream.GetCurrentBitNo();
+  uint64_t PrevPos = IndexBeginBitPos;
+  for (uint64_t Pos : IndexBitPos) {
+    Record.push_back(Pos - PrevPos);
+    PrevPos = Pos;
+  }
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  unsigned IndexAbbrev = Stream.EmitAbbrev(Abbv);
+  Stream.EmitRecord(bitc::METADATA_INDEX, Record, IndexAbbrev);
+  Record.clear();
+
   Stream.ExitBlock();
+
+  // Now that the block has been flushed, point the placeholder at the index.
+  uint64_t Offset = IndexPos - IndexBeginBitPos;
+  Stream.BackpatchWordAtBit(IndexOffsetBitPos, (uint32_t)Offset);
+  Stream.BackpatchWordAtBit(IndexOffsetBitPos + 32, (uint32_t)(Offset >> 32));
 }
 
 static void WriteFunctionLocalMetadata(const Function &F,
@@ -2328,9 +2395,64 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+/// Emit the abbreviation for summary records of the form
+/// [Fields..., namechar x N], where the first field is a VBR6 and the others
+/// are VBR8s.
+static unsigned createFunctionSummaryAbbrev(unsigned Code, unsigned NumFields,
+                                            BitstreamWriter &Stream) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(Code));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  for (unsigned I = 1; I != NumFields; ++I)
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  return Stream.EmitAbbrev(Abbv);
+}
+
+static void appendString(SmallVectorImpl<uint64_t> &Vals, StringRef Str) {
+  for (char C : Str)
+    Vals.push_back((unsigned char)C);
+}
+
+/// Emit the summaries of the functions that M defines and that can be
+/// referenced from other modules. Entries are sorted by name so that the
+/// output does not depend on the order of the functions in M.
+static void WriteFunctionSummary(const Module *M, BitstreamWriter &Stream) {
+  std::vector<const Function *> Funcs;
+  for (const Function &F : *M)
+    if (!F.isDeclaration() && F.hasName() && F.hasExternalLinkage())
+      Funcs.push_back(&F);
+  if (Funcs.empty())
+    return;
+  std::sort(Funcs.begin(), Funcs.end(),
+            [](const Function *A, const Function *B) {
+              return A->getName() < B->getName();
+            });
+
+  Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+  unsigned EntryAbbrev =
+      createFunctionSummaryAbbrev(bitc::FS_CODE_ENTRY, 3, Stream);
+
+  SmallVector<uint64_t, 64> Vals;
+  for (const Function *F : Funcs) {
+    // ENTRY: [instcount, flags, entrycount, namechar x N]
+    FunctionSummary FS = FunctionSummary::compute(*F);
+    Vals.push_back(FS.getInstCount());
+    Vals.push_back(FS.getFlags());
+    Vals.push_back(FS.getEntryCount());
+    appendString(Vals, F->getName());
+    Stream.EmitRecord(bitc::FS_CODE_ENTRY, Vals, EntryAbbrev);
+    Vals.clear();
+  }
+
+  Stream.ExitBlock();
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream,
-                        bool ShouldPreserveUseListOrder) {
+                        bool ShouldPreserveUseListOrder,
+                        bool EmitFunctionSummary) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
 
   SmallVector<unsigned, 1> Vals;
@@ -2375,6 +2497,11 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream,
   if (VE.shouldPreserveUseListOrder())
     WriteUseListBlock(nullptr, VE, Stream);
 
+  // Emit the function summaries ahead of the bodies, so that readers that only
+  // want the summaries can stop early.
+  if (EmitFunctionSummary)
+    WriteFunctionSummary(M, Stream);
+
   // Emit function bodies.
   for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
     if (!F->isDeclaration())
@@ -2456,10 +2583,126 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
     Buffer.push_back(0);
 }
 
+/// Return the BitcodeSymbolTable flags of GV, which mirror the symbol flags
+/// that IRObjectFile computes from the module.
+static uint32_t getSymbolTableFlags(const GlobalValue &GV) {
+  uint32_t Flags = 0;
+  if (GV.isDeclarationForLinker())
+    Flags |= BitcodeSymbolTable::SF_Undefined;
+  if (!GV.hasLocalLinkage())
+    Flags |= BitcodeSymbolTable::SF_Global;
+  if (GV.hasLinkOnceLinkage() || GV.hasWeakLinkage() ||
+      GV.hasExternalWeakLinkage())
+    Flags |= BitcodeSymbolTable::SF_Weak;
+  if (GV.hasLinkOnceODRLinkage())
+    Flags |= BitcodeSymbolTable::SF_LinkOnceODR;
+  if (GV.hasCommonLinkage())
+    Flags |= BitcodeSymbolTable::SF_Common;
+
+  if (GV.hasPrivateLinkage() || GV.getName().startswith("llvm."))
+    Flags |= BitcodeSymbolTable::SF_FormatSpecific;
+  if (const auto *Var = dyn_cast<GlobalVariable>(&GV)) {
+    if (Var->getSection() == StringRef("llvm.metadata"))
+      Flags |= BitcodeSymbolTable::SF_FormatSpecific;
+    if (Var->isConstant())
+      Flags |= BitcodeSymbolTable::SF_Constant;
+    if (Var->isThreadLocal())
+      Flags |= BitcodeSymbolTable::SF_ThreadLocal;
+  }
+
+  if (isa<GlobalAlias>(GV))
+    Flags |= BitcodeSymbolTable::SF_Alias;
+  const GlobalObject *Base = isa<GlobalAlias>(GV)
+                                 ? cast<GlobalAlias>(GV).getBaseObject()
+                                 : cast<GlobalObject>(&GV);
+  if (Base && isa<Function>(Base))
+    Flags |= BitcodeSymbolTable::SF_Executable;
+
+  if (GV.hasHiddenVisibility())
+    Flags |= BitcodeSymbolTable::SF_Hidden;
+  else if (GV.hasProtectedVisibility())
+    Flags |= BitcodeSymbolTable::SF_Protected;
+  if (GV.hasUnnamedAddr())
+    Flags |= BitcodeSymbolTable::SF_UnnamedAddr;
+  return Flags;
+}
+
+/// Emit the symbol table of M, as laid out in BitcodeSymbolTable.h, in a
+/// top-level block after the module block.
+static void WriteSymbolTable(const Module *M, BitstreamWriter &Stream) {
+  // The symbols of module-level inline asm can only be found by parsing it
+  // with the assembler of the target, so readers have to use the module.
+  if (!M->getModuleInlineAsm().empty())
+    return;
+
+  // Symbols are listed in the order of IRObjectFile, which is also the order
+  // in which the mangler numbers unnamed globals.
+  std::vector<const GlobalValue *> GVs;
+  for (const Function &F : *M)
+    GVs.push_back(&F);
+  for (const GlobalVariable &GV : M->globals())
+    GVs.push_back(&GV);
+  for (const GlobalAlias &GA : M->aliases())
+    GVs.push_back(&GA);
+
+  uint32_t ModuleFlags = 0;
+  if (M->getModuleFlag("Linker Options"))
+    ModuleFlags |= BitcodeSymbolTable::MF_LinkerOptions;
+  for (const GlobalVariable &GV : M->globals())
+    if (StringRef(GV.getSection()).startswith("__OBJC,"))
+      ModuleFlags |= BitcodeSymbolTable::MF_ObjCSections;
+  if (M->getDataLayoutStr().empty())
+    ModuleFlags |= BitcodeSymbolTable::MF_NoDataLayout;
+
+  Mangler Mang(&M->getDataLayout());
+  std::string Strtab;
+  raw_string_ostream StrtabOS(Strtab);
+  StrtabOS << M->getTargetTriple();
+  std::vector<std::pair<uint32_t, uint32_t>> Names;
+  for (const GlobalValue *GV : GVs) {
+    uint64_t Start = StrtabOS.tell();
+    Mang.getNameWithPrefix(StrtabOS, GV, false);
+    Names.push_back(std::make_pair(Start, StrtabOS.tell() - Start));
+  }
+  StrtabOS.flush();
+
+  // String offsets are relative to the start of the table.
+  uint32_t StrtabOffset = sizeof(BitcodeSymbolTable::Header) +
+                          GVs.size() * sizeof(BitcodeSymbolTable::Symbol);
+  SmallString<1024> Table;
+  {
+    raw_svector_ostream OS(Table);
+    support::endian::Writer<support::little> W(OS);
+    W.write<uint32_t>(BitcodeSymbolTable::CurrentVersion);
+    W.write<uint32_t>(GVs.size());
+    W.write<uint32_t>(ModuleFlags);
+    W.write<uint32_t>(StrtabOffset);
+    W.write<uint32_t>(M->getTargetTriple().size());
+    for (unsigned I = 0, E = GVs.size(); I != E; ++I) {
+      W.write<uint32_t>(StrtabOffset + Names[I].first);
+      W.write<uint32_t>(Names[I].second);
+      W.write<uint32_t>(getSymbolTableFlags(*GVs[I]));
+      W.write<uint32_t>(GVs[I]->getAlignment());
+    }
+    OS << Strtab;
+  }
+
+  Stream.EnterSubblock(bitc::SYMTAB_BLOCK_ID, 3);
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_BLOB));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned BlobAbbrev = Stream.EmitAbbrev(Abbv);
+  SmallVector<uint64_t, 1> Vals;
+  Vals.push_back(bitc::SYMTAB_BLOB);
+  Stream.EmitRecordWithBlob(BlobAbbrev, Vals, Table);
+  Stream.ExitBlock();
+}
+
 /// WriteBitcodeToFile - Write the specified module to the specified output
 /// stream.
 void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
-                              bool ShouldPreserveUseListOrder) {
+                              bool ShouldPreserveUseListOrder,
+                              bool EmitFunctionSummary) {
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -2482,7 +2725,10 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
     Stream.Emit(0xD, 4);
 
     // Emit the module.
-    WriteModule(M, Stream, ShouldPreserveUseListOrder);
+    WriteModule(M, Stream, ShouldPreserveUseListOrder, EmitFunctionSummary);
+
+    // Emit the symbol table for the tools that only need the symbols.
+    WriteSymbolTable(M, Stream);
   }
 
   if (TT.isOSDarwin())
@@ -2491,3 +2737,63 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
   // Write the generated bitstream to "Out".
   Out.write((char*)&Buffer.front(), Buffer.size());
 }
+
+/// WriteFunctionSummaryToFile - Write the specified combined function summary
+/// index to the specified output stream.
+void llvm::WriteFunctionSummaryToFile(const FunctionInfoIndex &Index,
+                                      raw_ostream &Out) {
+  SmallVector<char, 0> Buffer;
+  Buffer.reserve(256 * 1024);
+
+  {
+    BitstreamWriter Stream(Buffer);
+
+    // Emit the file header.
+    Stream.Emit((unsigned)'B', 8);
+    Stream.Emit((unsigned)'C', 8);
+    Stream.Emit(0x0, 4);
+    Stream.Emit(0xC, 4);
+    Stream.Emit(0xE, 4);
+    Stream.Emit(0xD, 4);
+
+    Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+    unsigned PathAbbrev =
+        createFunctionSummaryAbbrev(bitc::FS_CODE_MODULE_PATH, 1, Stream);
+    unsigned EntryAbbrev =
+        createFunctionSummaryAbbrev(bitc::FS_CODE_COMBINED_ENTRY, 4, Stream);
+
+    SmallVector<uint64_t, 64> Vals;
+    ArrayRef<std::string> Paths = Index.modulePaths();
+    for (unsigned I = 0, E = Paths.size(); I != E; ++I) {
+      // MODULE_PATH: [modid, namechar x N]
+      Vals.push_back(I);
+      appendString(Vals, Paths[I]);
+      Stream.EmitRecord(bitc::FS_CODE_MODULE_PATH, Vals, PathAbbrev);
+      Vals.clear();
+    }
+
+    std::vector<FunctionInfoIndex::const_iterator> Entries;
+    for (auto I = Index.begin(), E = Index.end(); I != E; ++I)
+      Entries.push_back(I);
+    std::sort(Entries.begin(), Entries.end(),
+              [](FunctionInfoIndex::const_iterator A,
+                 FunctionInfoIndex::const_iterator B) {
+                return A->getKey() < B->getKey();
+              });
+    for (FunctionInfoIndex::const_iterator I : Entries) {
+      // COMBINED_ENTRY: [modid, instcount, flags, entrycount, namechar x N]
+      const FunctionSummary &FS = I->getValue().Summary;
+      Vals.push_back(I->getValue().ModuleId);
+      Vals.push_back(FS.getInstCount());
+      Vals.push_back(FS.getFlags());
+      Vals.push_back(FS.getEntryCount());
+      appendString(Vals, I->getKey());
+      Stream.EmitRecord(bitc::FS_CODE_COMBINED_ENTRY, Vals, EntryAbbrev);
+      Vals.clear();
+    }
+
+    Stream.ExitBlock();
+  }
+
+  Out.write((char *)&Buffer.front(), Buffer.size());
+}
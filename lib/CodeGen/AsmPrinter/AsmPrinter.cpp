@@ -46,6 +46,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TimeTraceProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Target/TargetFrameLowering.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -783,6 +784,8 @@ void AsmPrinter::emitFrameAlloc(const MachineInstr &MI) {
 /// EmitFunctionBody - This method emits the body and trailer for a
 /// function.
 void AsmPrinter::EmitFunctionBody() {
+  TimeTraceScope TraceScope("EmitFunctionBody", MF->getName());
+
   EmitFunctionHeader();
 
   // Emit target-specific gunk before the function body.
@@ -1005,6 +1008,9 @@ void AsmPrinter::emitGlobalGOTEquivs() {
 }
 
 bool AsmPrinter::doFinalization(Module &M) {
+  TimeTraceScope TraceScope("AsmPrinter::doFinalization",
+                            M.getModuleIdentifier());
+
   // Set the MachineFunction to nullptr so that we can catch attempted
   // accesses to MF specific features at the module level and so that
   // we can conditionalize accesses based on whether or not it is nullptr.
@@ -1068,6 +1074,7 @@ bool AsmPrinter::doFinalization(Module &M) {
   for (const HandlerInfo &HI : Handlers) {
     NamedRegionTimer T(HI.TimerName, HI.TimerGroupName,
                        TimePassesIsEnabled);
+    TimeTraceScope HandlerScope(HI.TimerName);
     HI.Handler->endModule();
     delete HI.Handler;
   }
@@ -1151,7 +1158,10 @@ bool AsmPrinter::doFinalization(Module &M) {
   delete Mang; Mang = nullptr;
   MMI = nullptr;
 
-  OutStreamer->Finish();
+  {
+    TimeTraceScope StreamerScope("Finish MC streamer");
+    OutStreamer->Finish();
+  }
   OutStreamer->reset();
 
   return false;
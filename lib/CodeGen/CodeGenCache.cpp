@@ -0,0 +1,251 @@
+//===-- CodeGenCache.cpp - On-disk code generation cache ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements CodeGenCache, a content-addressed on-disk cache of the
+// output of the code generator.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/CodeGenCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetOptions.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+/// Accumulates the fields of a cache key. Each field is followed by a
+/// separator so that adjacent fields cannot run into each other.
+class KeyHasher {
+  MD5 Hash;
+
+public:
+  void add(StringRef Str) {
+    Hash.update(Str);
+    Hash.update(StringRef("", 1));
+  }
+  void add(uint64_t N) {
+    uint8_t Bytes[8];
+    for (unsigned I = 0; I != 8; ++I)
+      Bytes[I] = N >> (8 * I);
+    Hash.update(Bytes);
+  }
+  std::string result() {
+    MD5::MD5Result R;
+    Hash.final(R);
+    SmallString<32> Str;
+    MD5::stringifyResult(R, Str);
+    return Str.str();
+  }
+};
+}
+
+std::string CodeGenCache::computeTargetKey(const TargetMachine &TM) {
+  KeyHasher H;
+  H.add(LLVM_VERSION_MAJOR);
+  H.add(LLVM_VERSION_MINOR);
+
+  H.add(TM.getTargetTriple());
+  H.add(TM.getTargetCPU());
+  H.add(TM.getTargetFeatureString());
+  H.add(TM.getRelocationModel());
+  H.add(TM.getCodeModel());
+  H.add(TM.getOptLevel());
+
+  // The reciprocal estimate settings cannot be queried without asserting that
+  // they were initialized; they are only set from the command line, which is
+  // part of ExtraArgs.
+  const TargetOptions &Options = TM.Options;
+  H.add(Options.LessPreciseFPMADOption);
+  H.add(Options.UnsafeFPMath);
+  H.add(Options.NoInfsFPMath);
+  H.add(Options.NoNaNsFPMath);
+  H.add(Options.HonorSignDependentRoundingFPMathOption);
+  H.add(Options.NoZerosInBSS);
+  H.add(Options.GuaranteedTailCallOpt);
+  H.add(Options.DisableTailCalls);
+  H.add(Options.StackAlignmentOverride);
+  H.add(Options.EnableFastISel);
+  H.add(Options.PositionIndependentExecutable);
+  H.add(Options.UseInitArray);
+  H.add(Options.DisableIntegratedAS);
+  H.add(Options.CompressDebugSections);
+  H.add(Options.FunctionSections);
+  H.add(Options.DataSections);
+  H.add(Options.UniqueSectionNames);
+  H.add(Options.TrapUnreachable);
+  H.add(Options.TrapFuncName);
+  H.add(Options.FloatABIType);
+  H.add(Options.AllowFPOpFusion);
+  H.add(Options.JTType);
+  H.add(Options.ThreadModel);
+
+  const MCTargetOptions &MCOptions = Options.MCOptions;
+  H.add(MCOptions.SanitizeAddress);
+  H.add(MCOptions.MCRelaxAll);
+  H.add(MCOptions.MCNoExecStack);
+  H.add(MCOptions.MCFatalWarnings);
+  H.add(MCOptions.MCSaveTempLabels);
+  H.add(MCOptions.MCUseDwarfDirectory);
+  H.add(MCOptions.ShowMCEncoding);
+  H.add(MCOptions.ShowMCInst);
+  H.add(MCOptions.AsmVerbose);
+  H.add(MCOptions.DwarfVersion);
+  H.add(MCOptions.ABIName);
+
+  return H.result();
+}
+
+std::string CodeGenCache::computeKey(const Module &M, const TargetMachine &TM,
+                                     TargetMachine::CodeGenFileType FileType,
+                                     ArrayRef<std::string> ExtraArgs) {
+  KeyHasher H;
+  H.add(computeTargetKey(TM));
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(&M, OS);
+  }
+  H.add(StringRef(Bitcode.data(), Bitcode.size()));
+  // The bitcode doesn't include the module identifier, which names the source
+  // file in the output (as the STT_FILE symbol of an ELF object, for example).
+  H.add(M.getModuleIdentifier());
+  H.add(FileType);
+
+  H.add(ExtraArgs.size());
+  for (const std::string &Arg : ExtraArgs)
+    H.add(Arg);
+
+  return H.result();
+}
+
+void CodeGenCache::getEntryPath(StringRef Key,
+                                SmallVectorImpl<char> &Path) const {
+  Path.clear();
+  Path.append(Dir.begin(), Dir.end());
+  sys::path::append(Path, EntryPrefix + Key);
+}
+
+std::unique_ptr<MemoryBuffer> CodeGenCache::lookup(StringRef Key) const {
+  SmallString<128> Path;
+  getEntryPath(Key, Path);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFile(Path, -1, false);
+  if (!BufferOrErr)
+    return nullptr;
+
+  // Pruning evicts the entries with the oldest modification times first, so
+  // bump the time of the entries that are used.
+  int FD;
+  if (!sys::fs::openFileForWrite(Path, FD, sys::fs::F_Append)) {
+    sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+  return std::move(BufferOrErr.get());
+}
+
+bool CodeGenCache::store(StringRef Key, StringRef Data) const {
+  if (sys::fs::create_directories(Dir))
+    return false;
+
+  // Write the entry to a temporary file and rename it into place, so that
+  // concurrent lookups see either the whole entry or nothing.
+  SmallString<128> TempPath;
+  int FD;
+  if (sys::fs::createUniqueFile(Twine(Dir) + "/" + EntryPrefix +
+                                    "%%%%%%%%.tmp",
+                                FD, TempPath))
+    return false;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Data;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return false;
+    }
+  }
+
+  SmallString<128> Path;
+  getEntryPath(Key, Path);
+  if (sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return false;
+  }
+  return true;
+}
+
+unsigned CodeGenCache::prune(uint64_t MaxSize) const {
+  if (MaxSize == 0)
+    return 0;
+
+  // Only one process prunes the directory at a time. Any other process that
+  // gets here meanwhile can skip pruning, as the owner of the lock takes care
+  // of the entries that it added.
+  SmallString<128> LockPath(Dir);
+  sys::path::append(LockPath, "llvmcache.prune");
+  LockFileManager Locker(LockPath);
+  if (Locker.getState() != LockFileManager::LFS_Owned)
+    return 0;
+
+  struct Entry {
+    std::string Path;
+    uint64_t Size;
+    sys::TimeValue Time;
+  };
+  std::vector<Entry> Entries;
+  uint64_t TotalSize = 0;
+
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    StringRef Name = sys::path::filename(I->path());
+    // Skip the files that are not entries, including the ones that are still
+    // being written.
+    if (!Name.startswith(EntryPrefix) || Name.endswith(".tmp"))
+      continue;
+    sys::fs::file_status Status;
+    if (I->status(Status))
+      continue;
+    Entry Ent = {I->path(), Status.getSize(), Status.getLastModificationTime()};
+    Entries.push_back(Ent);
+    TotalSize += Ent.Size;
+  }
+
+  if (TotalSize <= MaxSize)
+    return 0;
+
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &A, const Entry &B) { return A.Time < B.Time; });
+  unsigned NumRemoved = 0;
+  for (const Entry &Ent : Entries) {
+    if (TotalSize <= MaxSize)
+      break;
+    if (!sys::fs::remove(Ent.Path)) {
+      TotalSize -= Ent.Size;
+      ++NumRemoved;
+    }
+  }
+  return NumRemoved;
+}
@@ -0,0 +1,634 @@
+//===-- llvm/CodeGen/GlobalISel/IRTranslator.cpp - IRTranslator -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the IRTranslator pass, the first stage of the global
+/// instruction selector. It translates a whole function into MachineInstrs
+/// with generic opcodes, in virtual registers whose register class is the one
+/// of the legal type of the value. Only the calling convention, including
+/// calls, is lowered to target instructions, through the CallLowering hooks
+/// of the target. Static allocas become stack objects, and address arithmetic
+/// is translated into integer arithmetic on pointer-sized registers.
+///
+/// Functions that use anything the translator doesn't handle yet, such as
+/// floating point, vectors, aggregates, dynamic allocas, atomics, invokes and
+/// most intrinsics, are left empty for the SelectionDAG instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Target/TargetLowering.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "irtranslator"
+
+namespace {
+class IRTranslator : public MachineFunctionPass {
+  const TargetLowering *TLI;
+  const CallLowering *CLI;
+  MachineRegisterInfo *MRI;
+  MachineIRBuilder MIRBuilder;
+
+  /// The virtual register of each non-constant value.
+  DenseMap<const Value *, unsigned> ValToVReg;
+
+  /// The constants materialized in the current block.
+  DenseMap<const Value *, unsigned> LocalConstants;
+
+  DenseMap<const BasicBlock *, MachineBasicBlock *> BBToMBB;
+
+  /// The PHI nodes whose incoming values are added once all the blocks have
+  /// been translated.
+  SmallVector<std::pair<const PHINode *, MachineInstr *>, 8> PendingPHIs;
+
+  /// Why the last translation failed.
+  const char *FailureReason;
+
+public:
+  static char ID;
+  IRTranslator() : MachineFunctionPass(ID) {
+    initializeIRTranslatorPass(*PassRegistry::getPassRegistry());
+  }
+
+  const char *getPassName() const override { return "IRTranslator"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+private:
+  bool fail(const char *Reason) {
+    FailureReason = Reason;
+    return false;
+  }
+
+  /// Return the register class standing for \p Ty, or null if values of that
+  /// type aren't supported.
+  const TargetRegisterClass *getRegClassFor(Type *Ty) const;
+
+  /// Return the virtual register holding \p V, or 0 if \p V can't be
+  /// translated. Constants are materialized at the insertion point, at most
+  /// once per block.
+  unsigned getOrCreateVReg(const Value &V);
+
+  /// Materialize the constant \p C in a new virtual register at the insertion
+  /// point.
+  unsigned materializeConstant(const Constant &C);
+
+  /// Return the memory operand of an access of type \p Ty to \p Ptr.
+  MachineMemOperand *getMemOperand(const Value *Ptr, Type *Ty, unsigned Flags,
+                                   bool IsVolatile, unsigned Alignment);
+
+  /// Compute the address of the getelementptr \p U, which is either an
+  /// instruction or a constant expression, into \p Res.
+  bool translateGEP(const User &U, unsigned Res);
+
+  bool translate(const Instruction &I);
+  bool translateBinaryOp(unsigned Opcode, const Instruction &I);
+  bool translateICmp(const ICmpInst &I);
+  bool translateCast(unsigned Opcode, const CastInst &I);
+  bool translateBr(const BranchInst &I);
+  bool translateRet(const ReturnInst &I);
+  bool translatePHI(const PHINode &I);
+  bool translateAlloca(const AllocaInst &I);
+  bool translateLoad(const LoadInst &I);
+  bool translateStore(const StoreInst &I);
+  bool translateBitCast(const CastInst &I);
+  bool translateCall(const CallInst &I);
+  bool translateIntrinsic(const CallInst &I, Intrinsic::ID ID);
+  bool finishPendingPHIs();
+};
+} // end anonymous namespace
+
+char IRTranslator::ID = 0;
+char &llvm::IRTranslatorID = IRTranslator::ID;
+INITIALIZE_PASS(IRTranslator, "irtranslator", "IRTranslator LLVM IR -> MI",
+                false, false)
+
+const TargetRegisterClass *IRTranslator::getRegClassFor(Type *Ty) const {
+  if (!Ty->isIntegerTy() && !Ty->isPointerTy())
+    return nullptr;
+  EVT VT = TLI->getValueType(Ty, /*AllowUnknown=*/true);
+  if (!VT.isSimple())
+    return nullptr;
+  // Booleans live in the register of the type they are promoted to, and are
+  // always 0 or 1.
+  if (VT == MVT::i1)
+    VT = TLI->getTypeToTransformTo(Ty->getContext(), VT);
+  if (!TLI->isTypeLegal(VT))
+    return nullptr;
+  return TLI->getRegClassFor(VT.getSimpleVT());
+}
+
+unsigned IRTranslator::getOrCreateVReg(const Value &V) {
+  if (const Constant *C = dyn_cast<Constant>(&V)) {
+    // Materializing a constant expression may add its operands to the map.
+    auto It = LocalConstants.find(C);
+    if (It != LocalConstants.end())
+      return It->second;
+    unsigned Reg = materializeConstant(*C);
+    LocalConstants[C] = Reg;
+    return Reg;
+  }
+
+  unsigned &Reg = ValToVReg[&V];
+  if (!Reg) {
+    const TargetRegisterClass *RC = getRegClassFor(V.getType());
+    if (!RC)
+      return 0;
+    Reg = MRI->createVirtualRegister(RC);
+  }
+  return Reg;
+}
+
+unsigned IRTranslator::materializeConstant(const Constant &C) {
+  const TargetRegisterClass *RC = getRegClassFor(C.getType());
+  if (!RC)
+    return 0;
+  unsigned Reg = MRI->createVirtualRegister(RC);
+  if (isa<UndefValue>(C)) {
+    MIRBuilder.buildInstr(TargetOpcode::IMPLICIT_DEF, Reg);
+    return Reg;
+  }
+  if (const GlobalValue *GV = dyn_cast<GlobalValue>(&C)) {
+    if (GV->isThreadLocal())
+      return 0;
+    MIRBuilder.buildInstr(TargetOpcode::G_GLOBAL_VALUE, Reg)
+        .addGlobalAddress(GV);
+    return Reg;
+  }
+  if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(&C)) {
+    if (CE->getOpcode() == Instruction::GetElementPtr)
+      return translateGEP(*CE, Reg) ? Reg : 0;
+    if (CE->getOpcode() == Instruction::BitCast &&
+        CE->getType()->isPointerTy()) {
+      unsigned Op = getOrCreateVReg(*CE->getOperand(0));
+      if (!Op)
+        return 0;
+      MIRBuilder.buildCopy(Reg, Op);
+      return Reg;
+    }
+    return 0;
+  }
+  int64_t Imm;
+  if (const ConstantInt *CI = dyn_cast<ConstantInt>(&C)) {
+    if (CI->getBitWidth() > 64)
+      return 0;
+    // Keep booleans canonical: true is 1, not -1.
+    Imm = CI->getBitWidth() == 1 ? CI->getZExtValue() : CI->getSExtValue();
+  } else if (isa<ConstantPointerNull>(C)) {
+    Imm = 0;
+  } else {
+    return 0;
+  }
+  MIRBuilder.buildInstr(TargetOpcode::G_CONSTANT, Reg).addImm(Imm);
+  return Reg;
+}
+
+MachineMemOperand *IRTranslator::getMemOperand(const Value *Ptr, Type *Ty,
+                                               unsigned Flags, bool IsVolatile,
+                                               unsigned Alignment) {
+  const DataLayout &DL = *TLI->getDataLayout();
+  if (IsVolatile)
+    Flags |= MachineMemOperand::MOVolatile;
+  if (!Alignment)
+    Alignment = DL.getABITypeAlignment(Ty);
+  return MIRBuilder.getMF().getMachineMemOperand(
+      MachinePointerInfo(Ptr), Flags, DL.getTypeStoreSize(Ty), Alignment);
+}
+
+bool IRTranslator::translateGEP(const User &U, unsigned Res) {
+  const DataLayout &DL = *TLI->getDataLayout();
+  if (U.getType()->isVectorTy())
+    return fail("unsupported vector getelementptr");
+  unsigned Addr = getOrCreateVReg(*U.getOperand(0));
+  if (!Addr)
+    return fail("unsupported getelementptr base");
+  const TargetRegisterClass *PtrRC = MRI->getRegClass(Addr);
+
+  // Add the variable indices one at a time, and all the constant offsets at
+  // the end.
+  int64_t Offset = 0;
+  Type *Ty = U.getOperand(0)->getType();
+  for (auto OI = U.op_begin() + 1, OE = U.op_end(); OI != OE; ++OI) {
+    const Value *Idx = *OI;
+    if (StructType *STy = dyn_cast<StructType>(Ty)) {
+      unsigned Field = cast<ConstantInt>(Idx)->getZExtValue();
+      Offset += DL.getStructLayout(STy)->getElementOffset(Field);
+      Ty = STy->getElementType(Field);
+      continue;
+    }
+    Ty = cast<SequentialType>(Ty)->getElementType();
+    int64_t ElementSize = DL.getTypeAllocSize(Ty);
+    if (const ConstantInt *CI = dyn_cast<ConstantInt>(Idx)) {
+      if (CI->getBitWidth() > 64)
+        return fail("unsupported getelementptr index");
+      Offset += ElementSize * CI->getSExtValue();
+      continue;
+    }
+
+    // Booleans are 0 or 1, and can't be sign extended as is.
+    if (Idx->getType()->isIntegerTy(1))
+      return fail("unsupported boolean getelementptr index");
+    unsigned IdxReg = getOrCreateVReg(*Idx);
+    if (!IdxReg)
+      return fail("unsupported getelementptr index");
+    unsigned IdxSize = MRI->getRegClass(IdxReg)->getSize();
+    if (IdxSize != PtrRC->getSize()) {
+      unsigned ExtReg = MRI->createVirtualRegister(PtrRC);
+      MIRBuilder.buildInstr(IdxSize < PtrRC->getSize() ? TargetOpcode::G_SEXT
+                                                       : TargetOpcode::G_TRUNC,
+                            ExtReg)
+          .addReg(IdxReg);
+      IdxReg = ExtReg;
+    }
+    if (ElementSize != 1) {
+      unsigned SizeReg = MRI->createVirtualRegister(PtrRC);
+      MIRBuilder.buildInstr(TargetOpcode::G_CONSTANT, SizeReg)
+          .addImm(ElementSize);
+      unsigned ScaledReg = MRI->createVirtualRegister(PtrRC);
+      MIRBuilder.buildInstr(TargetOpcode::G_MUL, ScaledReg, IdxReg, SizeReg);
+      IdxReg = ScaledReg;
+    }
+    unsigned SumReg = MRI->createVirtualRegister(PtrRC);
+    MIRBuilder.buildInstr(TargetOpcode::G_ADD, SumReg, Addr, IdxReg);
+    Addr = SumReg;
+  }
+
+  if (Offset) {
+    unsigned OffsetReg = MRI->createVirtualRegister(PtrRC);
+    MIRBuilder.buildInstr(TargetOpcode::G_CONSTANT, OffsetReg).addImm(Offset);
+    MIRBuilder.buildInstr(TargetOpcode::G_ADD, Res, Addr, OffsetReg);
+  } else {
+    MIRBuilder.buildCopy(Res, Addr);
+  }
+  return true;
+}
+
+bool IRTranslator::translateBinaryOp(unsigned Opcode, const Instruction &I) {
+  // Only the bitwise operations keep booleans canonical.
+  if (I.getType()->isIntegerTy(1) && Opcode != TargetOpcode::G_AND &&
+      Opcode != TargetOpcode::G_OR && Opcode != TargetOpcode::G_XOR)
+    return fail("unsupported boolean arithmetic");
+  unsigned Op0 = getOrCreateVReg(*I.getOperand(0));
+  unsigned Op1 = getOrCreateVReg(*I.getOperand(1));
+  unsigned Res = getOrCreateVReg(I);
+  if (!Op0 || !Op1 || !Res)
+    return fail("unsupported type");
+  MIRBuilder.buildInstr(Opcode, Res, Op0, Op1);
+  return true;
+}
+
+bool IRTranslator::translateICmp(const ICmpInst &I) {
+  // Canonical booleans only compare correctly as unsigned values.
+  if (I.getOperand(0)->getType()->isIntegerTy(1) && I.isSigned())
+    return fail("unsupported signed boolean comparison");
+  unsigned Op0 = getOrCreateVReg(*I.getOperand(0));
+  unsigned Op1 = getOrCreateVReg(*I.getOperand(1));
+  unsigned Res = getOrCreateVReg(I);
+  if (!Op0 || !Op1 || !Res)
+    return fail("unsupported type");
+  MIRBuilder.buildInstr(TargetOpcode::G_ICMP, Res)
+      .addImm(I.getPredicate())
+      .addReg(Op0)
+      .addReg(Op1);
+  return true;
+}
+
+bool IRTranslator::translateCast(unsigned Opcode, const CastInst &I) {
+  // A boolean can be zero extended as is, but the other conversions would
+  // have to canonicalize it.
+  if (I.getType()->isIntegerTy(1) ||
+      (I.getSrcTy()->isIntegerTy(1) && Opcode != TargetOpcode::G_ZEXT))
+    return fail("unsupported boolean conversion");
+  unsigned Op = getOrCreateVReg(*I.getOperand(0));
+  unsigned Res = getOrCreateVReg(I);
+  if (!Op || !Res)
+    return fail("unsupported type");
+  MIRBuilder.buildInstr(Opcode, Res).addReg(Op);
+  return true;
+}
+
+bool IRTranslator::translateBr(const BranchInst &I) {
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  if (I.isConditional()) {
+    unsigned Cond = getOrCreateVReg(*I.getCondition());
+    if (!Cond)
+      return fail("unsupported branch condition");
+    MIRBuilder.buildInstr(TargetOpcode::G_BRCOND)
+        .addReg(Cond)
+        .addMBB(BBToMBB[I.getSuccessor(0)]);
+  }
+  // The last successor is always reached with an unconditional branch, which
+  // the target can drop later if it falls through.
+  MIRBuilder.buildInstr(TargetOpcode::G_BR)
+      .addMBB(BBToMBB[I.getSuccessor(I.getNumSuccessors() - 1)]);
+
+  for (unsigned Idx = 0, E = I.getNumSuccessors(); Idx != E; ++Idx) {
+    MachineBasicBlock *SuccMBB = BBToMBB[I.getSuccessor(Idx)];
+    if (!MBB.isSuccessor(SuccMBB))
+      MBB.addSuccessor(SuccMBB);
+  }
+  return true;
+}
+
+bool IRTranslator::translateRet(const ReturnInst &I) {
+  const Value *Ret = I.getReturnValue();
+  unsigned Reg = 0;
+  if (Ret) {
+    Reg = getOrCreateVReg(*Ret);
+    if (!Reg)
+      return fail("unsupported return type");
+  }
+  if (!CLI->lowerReturn(MIRBuilder, Ret, Reg))
+    return fail("unsupported return");
+  return true;
+}
+
+bool IRTranslator::translatePHI(const PHINode &I) {
+  unsigned Res = getOrCreateVReg(I);
+  if (!Res)
+    return fail("unsupported type");
+  MachineInstr *PHI = MIRBuilder.buildInstr(TargetOpcode::PHI, Res);
+  PendingPHIs.push_back(std::make_pair(&I, PHI));
+  return true;
+}
+
+bool IRTranslator::translateAlloca(const AllocaInst &I) {
+  // Dynamic allocas would have to adjust the stack pointer.
+  if (!I.isStaticAlloca())
+    return fail("unsupported dynamic alloca");
+  unsigned Res = getOrCreateVReg(I);
+  if (!Res)
+    return fail("unsupported type");
+
+  const DataLayout &DL = *TLI->getDataLayout();
+  Type *Ty = I.getAllocatedType();
+  uint64_t Size = DL.getTypeAllocSize(Ty) *
+                  cast<ConstantInt>(I.getArraySize())->getZExtValue();
+  if (Size == 0) // Don't create zero-sized stack objects.
+    Size = 1;
+  unsigned Align =
+      std::max((unsigned)DL.getPrefTypeAlignment(Ty), I.getAlignment());
+  int FI = MIRBuilder.getMF().getFrameInfo()->CreateStackObject(Size, Align,
+                                                                false, &I);
+  MIRBuilder.buildInstr(TargetOpcode::G_FRAME_INDEX, Res).addFrameIndex(FI);
+  return true;
+}
+
+bool IRTranslator::translateLoad(const LoadInst &I) {
+  if (I.isAtomic())
+    return fail("unsupported atomic load");
+  unsigned Addr = getOrCreateVReg(*I.getPointerOperand());
+  unsigned Res = getOrCreateVReg(I);
+  if (!Addr || !Res)
+    return fail("unsupported type");
+  MIRBuilder.buildInstr(TargetOpcode::G_LOAD, Res)
+      .addReg(Addr)
+      .addMemOperand(getMemOperand(I.getPointerOperand(), I.getType(),
+                                   MachineMemOperand::MOLoad, I.isVolatile(),
+                                   I.getAlignment()));
+  return true;
+}
+
+bool IRTranslator::translateStore(const StoreInst &I) {
+  if (I.isAtomic())
+    return fail("unsupported atomic store");
+  const Value *Val = I.getValueOperand();
+  unsigned Src = getOrCreateVReg(*Val);
+  unsigned Addr = getOrCreateVReg(*I.getPointerOperand());
+  if (!Src || !Addr)
+    return fail("unsupported type");
+  MIRBuilder.buildInstr(TargetOpcode::G_STORE)
+      .addReg(Src)
+      .addReg(Addr)
+      .addMemOperand(getMemOperand(I.getPointerOperand(), Val->getType(),
+                                   MachineMemOperand::MOStore, I.isVolatile(),
+                                   I.getAlignment()));
+  return true;
+}
+
+bool IRTranslator::translateBitCast(const CastInst &I) {
+  // Pointers all live in the same registers.
+  if (!I.getType()->isPointerTy())
+    return fail("unsupported bitcast");
+  unsigned Op = getOrCreateVReg(*I.getOperand(0));
+  unsigned Res = getOrCreateVReg(I);
+  if (!Op || !Res)
+    return fail("unsupported type");
+  MIRBuilder.buildCopy(Res, Op);
+  return true;
+}
+
+bool IRTranslator::translateCall(const CallInst &I) {
+  if (I.isInlineAsm())
+    return fail("unsupported inline asm");
+  if (I.isMustTailCall())
+    return fail("unsupported musttail call");
+  const Function *F = I.getCalledFunction();
+  if (F && F->isIntrinsic())
+    return translateIntrinsic(I, F->getIntrinsicID());
+
+  unsigned Res = 0;
+  if (!I.getType()->isVoidTy()) {
+    Res = getOrCreateVReg(I);
+    if (!Res)
+      return fail("unsupported return type");
+  }
+  SmallVector<unsigned, 8> Args;
+  for (const Use &Arg : I.arg_operands()) {
+    unsigned Reg = getOrCreateVReg(*Arg);
+    if (!Reg)
+      return fail("unsupported argument type");
+    Args.push_back(Reg);
+  }
+  unsigned Callee = 0;
+  if (!F) {
+    Callee = getOrCreateVReg(*I.getCalledValue());
+    if (!Callee)
+      return fail("unsupported callee");
+  }
+  if (!CLI->lowerCall(MIRBuilder, I, Callee, Res, Args))
+    return fail("unsupported call");
+  return true;
+}
+
+bool IRTranslator::translateIntrinsic(const CallInst &I, Intrinsic::ID ID) {
+  switch (ID) {
+  case Intrinsic::dbg_declare:
+  case Intrinsic::dbg_value:
+    // The locations of the variables aren't tracked yet.
+    if (MIRBuilder.getMF().getMMI().hasDebugInfo())
+      return fail("unsupported debug info");
+    return true;
+  case Intrinsic::lifetime_start:
+  case Intrinsic::lifetime_end:
+    // Stack coloring is not enabled at -O0, so there is no use for these.
+    return true;
+  default:
+    return fail("unsupported intrinsic");
+  }
+}
+
+bool IRTranslator::finishPendingPHIs() {
+  for (auto &Pending : PendingPHIs) {
+    const PHINode *PI = Pending.first;
+    MachineInstrBuilder MIB(MIRBuilder.getMF(), Pending.second);
+    SmallPtrSet<const MachineBasicBlock *, 4> SeenPreds;
+    for (unsigned I = 0, E = PI->getNumIncomingValues(); I != E; ++I) {
+      MachineBasicBlock *Pred = BBToMBB[PI->getIncomingBlock(I)];
+      // A block that branches twice to the same successor only gets one
+      // entry: the incoming values are the same.
+      if (!SeenPreds.insert(Pred).second)
+        continue;
+      // Constants are materialized at the end of the predecessor.
+      MIRBuilder.setMBB(*Pred);
+      MachineBasicBlock::iterator Term = Pred->getFirstTerminator();
+      if (Term != Pred->end())
+        MIRBuilder.setInstr(*Term);
+      LocalConstants.clear();
+      unsigned Reg = getOrCreateVReg(*PI->getIncomingValue(I));
+      if (!Reg)
+        return fail("unsupported PHI operand");
+      MIB.addReg(Reg).addMBB(Pred);
+    }
+  }
+  return true;
+}
+
+bool IRTranslator::translate(const Instruction &I) {
+  MIRBuilder.setDebugLoc(I.getDebugLoc());
+  switch (I.getOpcode()) {
+  case Instruction::Add:
+    return translateBinaryOp(TargetOpcode::G_ADD, I);
+  case Instruction::Sub:
+    return translateBinaryOp(TargetOpcode::G_SUB, I);
+  case Instruction::Mul:
+    return translateBinaryOp(TargetOpcode::G_MUL, I);
+  case Instruction::And:
+    return translateBinaryOp(TargetOpcode::G_AND, I);
+  case Instruction::Or:
+    return translateBinaryOp(TargetOpcode::G_OR, I);
+  case Instruction::Xor:
+    return translateBinaryOp(TargetOpcode::G_XOR, I);
+  case Instruction::ICmp:
+    return translateICmp(cast<ICmpInst>(I));
+  case Instruction::ZExt:
+    return translateCast(TargetOpcode::G_ZEXT, cast<CastInst>(I));
+  case Instruction::SExt:
+    return translateCast(TargetOpcode::G_SEXT, cast<CastInst>(I));
+  case Instruction::Trunc:
+    return translateCast(TargetOpcode::G_TRUNC, cast<CastInst>(I));
+  case Instruction::BitCast:
+    return translateBitCast(cast<CastInst>(I));
+  case Instruction::Alloca:
+    return translateAlloca(cast<AllocaInst>(I));
+  case Instruction::Load:
+    return translateLoad(cast<LoadInst>(I));
+  case Instruction::Store:
+    return translateStore(cast<StoreInst>(I));
+  case Instruction::GetElementPtr: {
+    unsigned Res = getOrCreateVReg(I);
+    if (!Res)
+      return fail("unsupported type");
+    return translateGEP(I, Res);
+  }
+  case Instruction::Call:
+    return translateCall(cast<CallInst>(I));
+  case Instruction::Br:
+    return translateBr(cast<BranchInst>(I));
+  case Instruction::Ret:
+    return translateRet(cast<ReturnInst>(I));
+  case Instruction::PHI:
+    return translatePHI(cast<PHINode>(I));
+  case Instruction::Unreachable:
+    // Nothing to do, unless unreachable code has to trap.
+    if (MIRBuilder.getMF().getTarget().Options.TrapUnreachable)
+      return fail("unsupported trapping unreachable");
+    return true;
+  default:
+    return fail("unsupported instruction");
+  }
+}
+
+bool IRTranslator::runOnMachineFunction(MachineFunction &MF) {
+  const Function &F = *MF.getFunction();
+  TLI = MF.getSubtarget().getTargetLowering();
+  CLI = MF.getSubtarget().getCallLowering();
+  MRI = &MF.getRegInfo();
+  if (!CLI || !MF.getSubtarget().getInstructionSelector())
+    return false;
+
+  FailureReason = nullptr;
+  MIRBuilder.setMF(MF);
+  for (const BasicBlock &BB : F) {
+    MachineBasicBlock *MBB = MF.CreateMachineBasicBlock(&BB);
+    MF.push_back(MBB);
+    BBToMBB[&BB] = MBB;
+  }
+
+  // Copy the arguments into their virtual registers at the top of the entry
+  // block.
+  SmallVector<unsigned, 8> ArgRegs;
+  for (const Argument &Arg : F.args()) {
+    unsigned Reg = getOrCreateVReg(Arg);
+    if (!Reg) {
+      fail("unsupported argument type");
+      break;
+    }
+    ArgRegs.push_back(Reg);
+  }
+  bool Success = !FailureReason;
+  if (Success) {
+    MIRBuilder.setMBB(*BBToMBB[&F.getEntryBlock()]);
+    Success = CLI->lowerFormalArguments(MIRBuilder, F, ArgRegs) ||
+              fail("unsupported arguments");
+  }
+
+  for (const BasicBlock &BB : F) {
+    if (!Success)
+      break;
+    MIRBuilder.setMBB(*BBToMBB[&BB]);
+    LocalConstants.clear();
+    for (const Instruction &I : BB)
+      if (!(Success = translate(I)))
+        break;
+  }
+  if (Success)
+    Success = finishPendingPHIs();
+
+  ValToVReg.clear();
+  LocalConstants.clear();
+  BBToMBB.clear();
+  PendingPHIs.clear();
+
+  if (!Success) {
+    fallBackToSelectionDAG(MF, FailureReason);
+    return false;
+  }
+  return true;
+}
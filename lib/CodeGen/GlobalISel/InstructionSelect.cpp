@@ -0,0 +1,86 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelect.cpp - Select ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the InstructionSelect pass, the last stage of the
+/// global instruction selector. It asks the InstructionSelector of the target
+/// to replace each generic instruction with target instructions. Once it is
+/// done, the SelectionDAG instruction selector skips the function.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "instruction-select"
+
+STATISTIC(NumSelected,
+          "Number of functions selected by the global instruction selector");
+
+namespace {
+class InstructionSelect : public MachineFunctionPass {
+public:
+  static char ID;
+  InstructionSelect() : MachineFunctionPass(ID) {
+    initializeInstructionSelectPass(*PassRegistry::getPassRegistry());
+  }
+
+  const char *getPassName() const override { return "InstructionSelect"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+};
+} // end anonymous namespace
+
+char InstructionSelect::ID = 0;
+char &llvm::InstructionSelectID = InstructionSelect::ID;
+INITIALIZE_PASS(InstructionSelect, "instruction-select",
+                "Select target instructions out of generic instructions",
+                false, false)
+
+bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
+  // Nothing to do if the function wasn't translated.
+  if (MF.empty())
+    return false;
+
+  const InstructionSelector &ISel =
+      *MF.getSubtarget().getInstructionSelector();
+  for (MachineBasicBlock &MBB : MF) {
+    for (MachineBasicBlock::iterator I = MBB.begin(), E = MBB.end(); I != E;) {
+      MachineInstr &MI = *I++;
+      if (!TargetOpcode::isPreISelGenericOpcode(MI.getOpcode()))
+        continue;
+      DEBUG(dbgs() << "Selecting " << MI);
+      if (!ISel.select(MI)) {
+        fallBackToSelectionDAG(MF, "unable to select instruction");
+        return false;
+      }
+    }
+  }
+
+  // SelectionDAG would do this at the end of the selection.
+  MachineFrameInfo *MFI = MF.getFrameInfo();
+  for (const MachineBasicBlock &MBB : MF)
+    for (const MachineInstr &MI : MBB)
+      if (MI.isCall() && !MI.isReturn())
+        MFI->setHasCalls(true);
+  MF.getRegInfo().freezeReservedRegs(MF);
+  MF.setSelected(true);
+  ++NumSelected;
+  return true;
+}
@@ -0,0 +1,57 @@
+//===-- llvm/CodeGen/GlobalISel/MachineIRBuilder.cpp - MIBuilder ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the MachineIRBuilder class.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+using namespace llvm;
+
+void MachineIRBuilder::setMF(MachineFunction &NewMF) {
+  MF = &NewMF;
+  TII = NewMF.getSubtarget().getInstrInfo();
+  MBB = nullptr;
+  DL = DebugLoc();
+}
+
+void MachineIRBuilder::setMBB(MachineBasicBlock &NewMBB, bool Beginning) {
+  MBB = &NewMBB;
+  II = Beginning ? NewMBB.begin() : NewMBB.end();
+}
+
+void MachineIRBuilder::setInstr(MachineInstr &MI, bool Before) {
+  MBB = MI.getParent();
+  II = MI;
+  if (!Before)
+    ++II;
+}
+
+MachineInstrBuilder MachineIRBuilder::buildInstr(unsigned Opcode) {
+  return BuildMI(getMBB(), II, DL, TII->get(Opcode));
+}
+
+MachineInstrBuilder MachineIRBuilder::buildInstr(unsigned Opcode,
+                                                 unsigned Res) {
+  return BuildMI(getMBB(), II, DL, TII->get(Opcode), Res);
+}
+
+MachineInstrBuilder MachineIRBuilder::buildInstr(unsigned Opcode, unsigned Res,
+                                                 unsigned Op0, unsigned Op1) {
+  return buildInstr(Opcode, Res).addReg(Op0).addReg(Op1);
+}
+
+MachineInstrBuilder MachineIRBuilder::buildCopy(unsigned Res, unsigned Op) {
+  return buildInstr(TargetOpcode::COPY, Res).addReg(Op);
+}
@@ -0,0 +1,135 @@
+//===-- llvm/CodeGen/GlobalISel/MachineLegalizePass.cpp - Legalize --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the MachineLegalizePass, the stage of the global
+/// instruction selector that rewrites the generic instructions the target
+/// can't select into ones it can. Legality comes from the operation actions
+/// that the target registers for SelectionDAG: operations it promotes are
+/// widened here, and a function with any other non-legal operation is left
+/// to SelectionDAG.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/CodeGen/ISDOpcodes.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Target/TargetLowering.h"
+#include "llvm/Target/TargetOpcodes.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "legalize-mir"
+
+namespace {
+class MachineLegalizePass : public MachineFunctionPass {
+public:
+  static char ID;
+  MachineLegalizePass() : MachineFunctionPass(ID) {
+    initializeMachineLegalizePassPass(*PassRegistry::getPassRegistry());
+  }
+
+  const char *getPassName() const override { return "MachineLegalizePass"; }
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+private:
+  /// Make \p MI legal if needed, setting \p Changed if it was rewritten.
+  /// Return false if that isn't possible.
+  bool legalize(MachineInstr &MI, MachineRegisterInfo &MRI,
+                const TargetLowering &TLI, bool &Changed);
+};
+} // end anonymous namespace
+
+char MachineLegalizePass::ID = 0;
+char &llvm::MachineLegalizePassID = MachineLegalizePass::ID;
+INITIALIZE_PASS(MachineLegalizePass, "legalize-mir",
+                "Legalize the generic instructions of a function", false,
+                false)
+
+/// Return the ISD opcode of the generic binary operation \p Opcode, or 0.
+static unsigned getISDOpcode(unsigned Opcode) {
+  switch (Opcode) {
+  case TargetOpcode::G_ADD: return ISD::ADD;
+  case TargetOpcode::G_SUB: return ISD::SUB;
+  case TargetOpcode::G_MUL: return ISD::MUL;
+  case TargetOpcode::G_AND: return ISD::AND;
+  case TargetOpcode::G_OR:  return ISD::OR;
+  case TargetOpcode::G_XOR: return ISD::XOR;
+  default: return 0;
+  }
+}
+
+bool MachineLegalizePass::legalize(MachineInstr &MI, MachineRegisterInfo &MRI,
+                                   const TargetLowering &TLI, bool &Changed) {
+  // The types of the other generic instructions are legal by construction.
+  unsigned ISDOpc = getISDOpcode(MI.getOpcode());
+  if (!ISDOpc)
+    return true;
+
+  unsigned Res = MI.getOperand(0).getReg();
+  MVT VT = MVT::getIntegerVT(MRI.getRegClass(Res)->getSize() * 8);
+  switch (TLI.getOperationAction(ISDOpc, VT)) {
+  case TargetLowering::Legal:
+    return true;
+  case TargetLowering::Promote:
+    break;
+  default:
+    return false;
+  }
+
+  // Compute in the wider type and truncate the result. The high bits of the
+  // operands don't affect the low bits of these operations.
+  MVT NVT = TLI.getTypeToPromoteTo(ISDOpc, VT);
+  const TargetRegisterClass *NRC = TLI.getRegClassFor(NVT);
+  MachineIRBuilder MIRBuilder;
+  MIRBuilder.setMF(*MI.getParent()->getParent());
+  MIRBuilder.setInstr(MI);
+  MIRBuilder.setDebugLoc(MI.getDebugLoc());
+  unsigned WideOps[2];
+  for (unsigned I = 0; I != 2; ++I) {
+    WideOps[I] = MRI.createVirtualRegister(NRC);
+    MIRBuilder.buildInstr(TargetOpcode::G_ZEXT, WideOps[I])
+        .addReg(MI.getOperand(I + 1).getReg());
+  }
+  unsigned WideRes = MRI.createVirtualRegister(NRC);
+  MIRBuilder.buildInstr(MI.getOpcode(), WideRes, WideOps[0], WideOps[1]);
+  MIRBuilder.buildInstr(TargetOpcode::G_TRUNC, Res).addReg(WideRes);
+  MI.eraseFromParent();
+  Changed = true;
+  return true;
+}
+
+bool MachineLegalizePass::runOnMachineFunction(MachineFunction &MF) {
+  // Nothing to do if the function wasn't translated.
+  if (MF.empty())
+    return false;
+
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const TargetLowering &TLI = *MF.getSubtarget().getTargetLowering();
+  bool Changed = false;
+  for (MachineBasicBlock &MBB : MF) {
+    for (MachineBasicBlock::iterator I = MBB.begin(), E = MBB.end(); I != E;) {
+      MachineInstr &MI = *I++;
+      if (!TargetOpcode::isPreISelGenericOpcode(MI.getOpcode()))
+        continue;
+      if (!legalize(MI, MRI, TLI, Changed)) {
+        DEBUG(dbgs() << "Can't legalize " << MI);
+        fallBackToSelectionDAG(MF, "unable to legalize instruction");
+        return false;
+      }
+    }
+  }
+  return Changed;
+}
@@ -0,0 +1,54 @@
+//===-- llvm/CodeGen/GlobalISel/Utils.cpp - GlobalISel utilities ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the helpers shared by the passes of the global
+/// instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/Utils.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "globalisel"
+
+STATISTIC(NumFallbacks, "Number of functions left to SelectionDAG");
+
+static cl::opt<bool>
+AbortOnFallback("global-isel-abort", cl::Hidden,
+                cl::desc("Report a fatal error when the global instruction "
+                         "selector can't handle a function"));
+
+void llvm::fallBackToSelectionDAG(MachineFunction &MF, const Twine &Reason) {
+  if (AbortOnFallback)
+    report_fatal_error("global instruction selector failed on function '" +
+                       MF.getFunction()->getName() + "': " + Reason);
+  DEBUG(dbgs() << "GlobalISel: " << MF.getFunction()->getName() << ": "
+               << Reason << ", falling back to SelectionDAG\n");
+  ++NumFallbacks;
+
+  // Drop the instructions first, so that no operand refers to the virtual
+  // registers or to the blocks anymore.
+  for (MachineBasicBlock &MBB : MF)
+    MBB.clear();
+  while (!MF.empty())
+    MF.erase(MF.begin());
+  MF.RenumberBlocks();
+  MF.getRegInfo().clearVirtRegs();
+  MF.setSelected(false);
+}
@@ -42,6 +42,11 @@ static cl::opt<cl::boolOrDefault>
 EnableFastISelOption("fast-isel", cl::Hidden,
   cl::desc("Enable the \"fast\" instruction selector"));
 
+static cl::opt<bool>
+EnableGlobalISel("global-isel", cl::Hidden,
+  cl::desc("Try the \"global\" instruction selector before the default one "
+           "at -O0"));
+
 void LLVMTargetMachine::initAsmInfo() {
   MRI = TheTarget.createMCRegInfo(getTargetTriple());
   MII = TheTarget.createMCInstrInfo();
@@ -129,6 +134,12 @@ static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
        EnableFastISelOption != cl::BOU_FALSE))
     TM->setFastISel(true);
 
+  // At -O0, the global instruction selector gets the first try if it was
+  // asked for. It leaves the functions it can't handle to the target's
+  // selector.
+  if (EnableGlobalISel && TM->getOptLevel() == CodeGenOpt::None)
+    PassConfig->addGlobalInstructionSelect();
+
   // Ask the target for an isel.
   if (PassConfig->addInstSelector())
     return nullptr;
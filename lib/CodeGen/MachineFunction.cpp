@@ -80,6 +80,7 @@ MachineFunction::MachineFunction(const Function *F, const TargetMachine &TM,
 
   FunctionNumber = FunctionNum;
   JumpTableInfo = nullptr;
+  Selected = false;
 }
 
 MachineFunction::~MachineFunction() {
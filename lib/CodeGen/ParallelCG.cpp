@@ -0,0 +1,113 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <mutex>
+
+using namespace llvm;
+
+namespace {
+/// The context of the module being split, which reports the diagnostics of
+/// all the partitions, one at a time.
+struct DiagnosticForwarder {
+  LLVMContext &Ctx;
+  std::mutex Lock;
+
+  DiagnosticForwarder(LLVMContext &Ctx) : Ctx(Ctx) {}
+};
+} // end anonymous namespace
+
+static void forwardDiagnostic(const DiagnosticInfo &DI, void *Context) {
+  auto *Forwarder = static_cast<DiagnosticForwarder *>(Context);
+  std::lock_guard<std::mutex> Lock(Forwarder->Lock);
+  Forwarder->Ctx.diagnose(DI);
+}
+
+static void codegen(Module *M, raw_pwrite_stream &OS,
+                    const Target *TheTarget, StringRef CPU, StringRef Features,
+                    const TargetOptions &Options, Reloc::Model RM,
+                    CodeModel::Model CM, CodeGenOpt::Level OL,
+                    TargetMachine::CodeGenFileType FileType) {
+  std::unique_ptr<TargetMachine> TM(TheTarget->createTargetMachine(
+      M->getTargetTriple(), CPU, Features, Options, RM, CM, OL));
+
+  legacy::PassManager CodeGenPasses;
+  if (TM->addPassesToEmitFile(CodeGenPasses, OS, FileType))
+    report_fatal_error("Failed to setup codegen");
+  CodeGenPasses.run(*M);
+}
+
+void llvm::splitCodeGen(Module &M, ArrayRef<raw_pwrite_stream *> OSs,
+                        StringRef CPU, StringRef Features,
+                        const TargetOptions &Options, Reloc::Model RM,
+                        CodeModel::Model CM, CodeGenOpt::Level OL,
+                        TargetMachine::CodeGenFileType FileType,
+                        unsigned ThreadCount) {
+  StringRef TripleStr = M.getTargetTriple();
+  std::string ErrMsg;
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
+  if (!TheTarget)
+    report_fatal_error(Twine("Target not found: ") + ErrMsg);
+
+  if (OSs.size() == 1) {
+    codegen(&M, *OSs[0], TheTarget, CPU, Features, Options, RM, CM, OL,
+            FileType);
+    return;
+  }
+
+  DiagnosticForwarder Forwarder(M.getContext());
+  ThreadPool Pool(ThreadCount ? ThreadCount : OSs.size());
+  unsigned PartitionIndex = 0;
+  SplitModule(M, OSs.size(), [&](std::unique_ptr<Module> MPart) {
+    // We want to clone the module in a new context to multi-thread the codegen.
+    // We do it by serializing partition modules to bitcode (while still on the
+    // main thread, in order to avoid data races) and handing the bitcode to
+    // the pool, whose tasks deserialize the partitions into separate contexts.
+    // FIXME: Provide a more direct way to do this in LLVM.
+    auto BC = std::make_shared<SmallVector<char, 0>>();
+    raw_svector_ostream BCOS(*BC);
+    WriteBitcodeToFile(MPart.get(), BCOS);
+    BCOS.flush();
+
+    raw_pwrite_stream *ThreadOS = OSs[PartitionIndex++];
+    Pool.async([TheTarget, CPU, Features, &Options, RM, CM, OL, FileType,
+                ThreadOS, BC, &Forwarder] {
+      LLVMContext Ctx;
+      // Report the diagnostics through the handler of the original context,
+      // such as the one installed by an LTO client.
+      Ctx.setDiagnosticHandler(forwardDiagnostic, &Forwarder);
+      ErrorOr<Module *> MOrErr = parseBitcodeFile(
+          MemoryBufferRef(StringRef(BC->data(), BC->size()), "<split-module>"),
+          Ctx);
+      if (!MOrErr)
+        report_fatal_error("Failed to read bitcode");
+      std::unique_ptr<Module> MPartInCtx(MOrErr.get());
+
+      codegen(MPartInCtx.get(), *ThreadOS, TheTarget, CPU, Features, Options,
+              RM, CM, OL, FileType);
+    });
+  });
+
+  Pool.wait();
+}
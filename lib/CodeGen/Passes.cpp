@@ -464,6 +464,12 @@ void TargetPassConfig::addISelPrepare() {
     addPass(createVerifierPass());
 }
 
+void TargetPassConfig::addGlobalInstructionSelect() {
+  addPass(&IRTranslatorID);
+  addPass(&MachineLegalizePassID);
+  addPass(&InstructionSelectID);
+}
+
 /// Add the complete set of target-independent postISel code generator passes.
 ///
 /// This can be read as the standard order of major LLVM CodeGen stages. Stages
@@ -398,6 +398,19 @@ bool FastISel::selectBinaryOp(const User *I, unsigned ISDOpcode) {
       return false;
   }
 
+  // Targets may perform vector bitwise operations in another vector type of
+  // the same size, e.g. x86 does them all in v2i64. These only need the
+  // operands to live in the same registers.
+  if (VT.isVector() && (ISDOpcode == ISD::AND || ISDOpcode == ISD::OR ||
+                        ISDOpcode == ISD::XOR) &&
+      TLI.getOperationAction(ISDOpcode, VT) == TargetLowering::Promote) {
+    MVT PVT = TLI.getTypeToPromoteTo(ISDOpcode, VT.getSimpleVT());
+    if (PVT.getSizeInBits() != VT.getSizeInBits() ||
+        TLI.getRegClassFor(PVT) != TLI.getRegClassFor(VT.getSimpleVT()))
+      return false;
+    VT = PVT;
+  }
+
   // Check if the first operand is a constant, and handle it as "ri".  At -O0,
   // we don't have anything that canonicalizes operand order.
   if (const auto *CI = dyn_cast<ConstantInt>(I->getOperand(0)))
@@ -1283,9 +1296,13 @@ bool FastISel::selectBitCast(const User *I) {
     return false;
   bool Op0IsKill = hasTrivialKill(I->getOperand(0));
 
-  // First, try to perform the bitcast by inserting a reg-reg copy.
+  // First, try to perform the bitcast by inserting a reg-reg copy. On a
+  // little-endian target this also works for vectors of the same size, since
+  // the lanes then have the same layout in the register as in memory.
   unsigned ResultReg = 0;
-  if (SrcVT == DstVT) {
+  if (SrcVT == DstVT ||
+      (DL.isLittleEndian() && SrcVT.isVector() && DstVT.isVector() &&
+       SrcVT.getSizeInBits() == DstVT.getSizeInBits())) {
     const TargetRegisterClass *SrcClass = TLI.getRegClassFor(SrcVT);
     const TargetRegisterClass *DstClass = TLI.getRegClassFor(DstVT);
     // Don't attempt a cross-class copy. It will likely fail.
@@ -2073,9 +2090,9 @@ bool FastISel::tryToFoldLoad(const LoadInst *LI, const Instruction *FoldInst) {
   if (TheUser != FoldInst)
     return false;
 
-  // Don't try to fold volatile loads.  Target has to deal with alignment
-  // constraints.
-  if (LI->isVolatile())
+  // Don't try to fold volatile or atomic loads.  Target has to deal with
+  // alignment constraints.
+  if (LI->isVolatile() || LI->isAtomic())
     return false;
 
   // Figure out which vreg this is going into.  If there is no assigned vreg yet
@@ -2130,13 +2147,16 @@ FastISel::createMachineMemOperandFor(const Instruction *I) const {
 
   if (const auto *LI = dyn_cast<LoadInst>(I)) {
     Alignment = LI->getAlignment();
-    IsVolatile = LI->isVolatile();
+    // As in SelectionDAG, atomic accesses are marked volatile: the memory
+    // operand can't express the ordering, and nothing may reorder or merge
+    // them.
+    IsVolatile = LI->isVolatile() || LI->isAtomic();
     Flags = MachineMemOperand::MOLoad;
     Ptr = LI->getPointerOperand();
     ValTy = LI->getType();
   } else if (const auto *SI = dyn_cast<StoreInst>(I)) {
     Alignment = SI->getAlignment();
-    IsVolatile = SI->isVolatile();
+    IsVolatile = SI->isVolatile() || SI->isAtomic();
     Flags = MachineMemOperand::MOStore;
     Ptr = SI->getPointerOperand();
     ValTy = SI->getValueOperand()->getType();
@@ -47,6 +47,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TimeTraceProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -71,11 +72,8 @@ STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
 
-#ifndef NDEBUG
-static cl::opt<bool>
-EnableFastISelVerbose2("fast-isel-verbose2", cl::Hidden,
-          cl::desc("Enable extra verbose messages in the \"fast\" "
-                   "instruction selector"));
+// Per-opcode counts of the instructions fast isel bails out on; see
+// collectFailStats.
 
   // Terminators
 STATISTIC(NumFastIselFailRet,"Fast isel fails on Ret");
@@ -110,8 +108,8 @@ STATISTIC(NumFastIselFailAlloca,"Fast isel fails on Alloca");
 STATISTIC(NumFastIselFailLoad,"Fast isel fails on Load");
 STATISTIC(NumFastIselFailStore,"Fast isel fails on Store");
 STATISTIC(NumFastIselFailAtomicCmpXchg,"Fast isel fails on AtomicCmpXchg");
-STATISTIC(NumFastIselFailAtomicRMW,"Fast isel fails on AtomicRWM");
-STATISTIC(NumFastIselFailFence,"Fast isel fails on Frence");
+STATISTIC(NumFastIselFailAtomicRMW,"Fast isel fails on AtomicRMW");
+STATISTIC(NumFastIselFailFence,"Fast isel fails on Fence");
 STATISTIC(NumFastIselFailGetElementPtr,"Fast isel fails on GetElementPtr");
 
   // Convert instructions...
@@ -127,6 +125,7 @@ STATISTIC(NumFastIselFailSIToFP,"Fast isel fails on SIToFP");
 STATISTIC(NumFastIselFailIntToPtr,"Fast isel fails on IntToPtr");
 STATISTIC(NumFastIselFailPtrToInt,"Fast isel fails on PtrToInt");
 STATISTIC(NumFastIselFailBitCast,"Fast isel fails on BitCast");
+STATISTIC(NumFastIselFailAddrSpaceCast,"Fast isel fails on AddrSpaceCast");
 
   // Other instructions...
 STATISTIC(NumFastIselFailICmp,"Fast isel fails on ICmp");
@@ -163,7 +162,9 @@ STATISTIC(NumFastIselFailFrameaddress, "Fast isel fails on Frameaddress");
 STATISTIC(NumFastIselFailSqrt, "Fast isel fails on sqrt call");
 STATISTIC(NumFastIselFailStackMap, "Fast isel fails on StackMap call");
 STATISTIC(NumFastIselFailPatchPoint, "Fast isel fails on PatchPoint call");
-#endif
+STATISTIC(NumFastIselFailMemCpy, "Fast isel fails on memcpy call");
+STATISTIC(NumFastIselFailMemMove, "Fast isel fails on memmove call");
+STATISTIC(NumFastIselFailMemSet, "Fast isel fails on memset call");
 
 static cl::opt<bool>
 EnableFastISelVerbose("fast-isel-verbose", cl::Hidden,
@@ -419,6 +420,10 @@ bool SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
   assert((!EnableFastISelAbort || TM.Options.EnableFastISel) &&
          "-fast-isel-abort > 0 requires -fast-isel");
 
+  // The global instruction selector has already taken care of the function.
+  if (mf.isSelected())
+    return false;
+
   const Function &Fn = *mf.getFunction();
   MF = &mf;
 
@@ -662,6 +667,7 @@ void SelectionDAGISel::ComputeLiveOutVRegInfo() {
 }
 
 void SelectionDAGISel::CodeGenAndEmitDAG() {
+  TimeTraceScope BlockScope("CodeGenAndEmitDAG", MF->getName());
   std::string GroupName;
   if (TimePassesIsEnabled)
     GroupName = "Instruction Selection and Scheduling";
@@ -693,6 +699,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   // Run the DAG combiner in pre-legalize mode.
   {
     NamedRegionTimer T("DAG Combining 1", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("DAG Combining 1");
     CurDAG->Combine(BeforeLegalizeTypes, *AA, OptLevel);
   }
 
@@ -707,6 +714,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   bool Changed;
   {
     NamedRegionTimer T("Type Legalization", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Type Legalization");
     Changed = CurDAG->LegalizeTypes();
   }
 
@@ -723,6 +731,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("DAG Combining after legalize types", GroupName,
                          TimePassesIsEnabled);
+      TimeTraceScope TraceScope("DAG Combining after legalize types");
       CurDAG->Combine(AfterLegalizeTypes, *AA, OptLevel);
     }
 
@@ -733,12 +742,14 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
 
   {
     NamedRegionTimer T("Vector Legalization", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Vector Legalization");
     Changed = CurDAG->LegalizeVectors();
   }
 
   if (Changed) {
     {
       NamedRegionTimer T("Type Legalization 2", GroupName, TimePassesIsEnabled);
+      TimeTraceScope TraceScope("Type Legalization 2");
       CurDAG->LegalizeTypes();
     }
 
@@ -749,6 +760,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("DAG Combining after legalize vectors", GroupName,
                          TimePassesIsEnabled);
+      TimeTraceScope TraceScope("DAG Combining after legalize vectors");
       CurDAG->Combine(AfterLegalizeVectorOps, *AA, OptLevel);
     }
 
@@ -761,6 +773,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
 
   {
     NamedRegionTimer T("DAG Legalization", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("DAG Legalization");
     CurDAG->Legalize();
   }
 
@@ -773,6 +786,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   // Run the DAG combiner in post-legalize mode.
   {
     NamedRegionTimer T("DAG Combining 2", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("DAG Combining 2");
     CurDAG->Combine(AfterLegalizeDAG, *AA, OptLevel);
   }
 
@@ -789,6 +803,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   // code to the MachineBasicBlock.
   {
     NamedRegionTimer T("Instruction Selection", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Instruction Selection");
     DoInstructionSelection();
   }
 
@@ -803,6 +818,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("Instruction Scheduling", GroupName,
                        TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Instruction Scheduling");
     Scheduler->Run(CurDAG, FuncInfo->MBB);
   }
 
@@ -813,6 +829,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   MachineBasicBlock *FirstMBB = FuncInfo->MBB, *LastMBB;
   {
     NamedRegionTimer T("Instruction Creation", GroupName, TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Instruction Creation");
 
     // FuncInfo->InsertPt is passed by reference and set to the end of the
     // scheduled instructions.
@@ -828,6 +845,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   {
     NamedRegionTimer T("Instruction Scheduling Cleanup", GroupName,
                        TimePassesIsEnabled);
+    TimeTraceScope TraceScope("Instruction Scheduling Cleanup");
     delete Scheduler;
   }
 
@@ -995,14 +1013,13 @@ static bool isFoldedOrDeadInstruction(const Instruction *I,
          !FuncInfo->isExportedInst(I); // Exported instrs must be computed.
 }
 
-#ifndef NDEBUG
 // Collect per Instruction statistics for fast-isel misses.  Only those
 // instructions that cause the bail are accounted for.  It does not account for
 // instructions higher in the block.  Thus, summing the per instructions stats
 // will not add up to what is reported by NumFastIselFailures.
 static void collectFailStats(const Instruction *I) {
   switch (I->getOpcode()) {
-  default: assert (0 && "<Invalid operator> ");
+  default: llvm_unreachable("<Invalid operator>");
 
   // Terminators
   case Instruction::Ret:         NumFastIselFailRet++; return;
@@ -1054,6 +1071,7 @@ static void collectFailStats(const Instruction *I) {
   case Instruction::IntToPtr: NumFastIselFailIntToPtr++; return;
   case Instruction::PtrToInt: NumFastIselFailPtrToInt++; return;
   case Instruction::BitCast:  NumFastIselFailBitCast++; return;
+  case Instruction::AddrSpaceCast: NumFastIselFailAddrSpaceCast++; return;
 
   // Other instructions...
   case Instruction::ICmp:           NumFastIselFailICmp++; return;
@@ -1086,6 +1104,12 @@ static void collectFailStats(const Instruction *I) {
       case Intrinsic::experimental_patchpoint_void: // fall-through
       case Intrinsic::experimental_patchpoint_i64:
         NumFastIselFailPatchPoint++; return;
+      case Intrinsic::memcpy:
+        NumFastIselFailMemCpy++; return;
+      case Intrinsic::memmove:
+        NumFastIselFailMemMove++; return;
+      case Intrinsic::memset:
+        NumFastIselFailMemSet++; return;
       }
     }
     NumFastIselFailCall++;
@@ -1103,7 +1127,6 @@ static void collectFailStats(const Instruction *I) {
   case Instruction::LandingPad:     NumFastIselFailLandingPad++; return;
   }
 }
-#endif
 
 void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
   // Initialize the Fast-ISel state, if needed.
@@ -1225,10 +1248,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           continue;
         }
 
-#ifndef NDEBUG
-        if (EnableFastISelVerbose2)
+        if (AreStatisticsEnabled())
           collectFailStats(Inst);
-#endif
 
         // Then handle certain instructions as single-LLVM-Instruction blocks.
         if (isa<CallInst>(Inst)) {
@@ -13,7 +13,7 @@
 
 using namespace llvm;
 
-void DWARFCompileUnit::dump(raw_ostream &OS) {
+void DWARFCompileUnit::dump(raw_ostream &OS, bool Streaming) {
   OS << format("0x%08x", getOffset()) << ": Compile Unit:"
      << " length = " << format("0x%08x", getLength())
      << " version = " << format("0x%04x", getVersion())
@@ -22,7 +22,10 @@ void DWARFCompileUnit::dump(raw_ostream &OS) {
      << " (next unit at " << format("0x%08x", getNextUnitOffset())
      << ")\n";
 
-  if (const DWARFDebugInfoEntryMinimal *CU = getUnitDIE(false))
+  if (Streaming) {
+    if (!dumpDIEsStreaming(OS))
+      OS << "<compile unit can't be parsed!>\n\n";
+  } else if (const DWARFDebugInfoEntryMinimal *CU = getUnitDIE(false))
     CU->dump(OS, this, -1U);
   else
     OS << "<compile unit can't be parsed!>\n\n";
@@ -16,6 +16,7 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -71,7 +72,8 @@ static void dumpAccelSection(raw_ostream &OS, StringRef Name,
   Accel.dump(OS);
 }
 
-void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
+void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType,
+                        bool StreamUnits) {
   if (DumpType == DIDT_All || DumpType == DIDT_Abbrev) {
     OS << ".debug_abbrev contents:\n";
     getDebugAbbrev()->dump(OS);
@@ -86,21 +88,21 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
   if (DumpType == DIDT_All || DumpType == DIDT_Info) {
     OS << "\n.debug_info contents:\n";
     for (const auto &CU : compile_units())
-      CU->dump(OS);
+      CU->dump(OS, StreamUnits);
   }
 
   if ((DumpType == DIDT_All || DumpType == DIDT_InfoDwo) &&
       getNumDWOCompileUnits()) {
     OS << "\n.debug_info.dwo contents:\n";
     for (const auto &DWOCU : dwo_compile_units())
-      DWOCU->dump(OS);
+      DWOCU->dump(OS, StreamUnits);
   }
 
   if ((DumpType == DIDT_All || DumpType == DIDT_Types) && getNumTypeUnits()) {
     OS << "\n.debug_types contents:\n";
     for (const auto &TUS : type_unit_sections())
       for (const auto &TU : TUS)
-        TU->dump(OS);
+        TU->dump(OS, StreamUnits);
   }
 
   if ((DumpType == DIDT_All || DumpType == DIDT_TypesDwo) &&
@@ -108,7 +110,7 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
     OS << "\n.debug_types.dwo contents:\n";
     for (const auto &DWOTUS : dwo_type_unit_sections())
       for (const auto &DWOTU : DWOTUS)
-        DWOTU->dump(OS);
+        DWOTU->dump(OS, StreamUnits);
   }
 
   if (DumpType == DIDT_All || DumpType == DIDT_Loc) {
@@ -344,6 +346,45 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
   return Line->getOrParseLineTable(lineData, stmtOffset);
 }
 
+void DWARFContext::parseAllUnits(unsigned NumThreads) {
+  parseCompileUnits();
+  parseTypeUnits();
+  if (!Line)
+    Line.reset(new DWARFDebugLine(&getLineSection().Relocs));
+
+  ThreadPool Pool(NumThreads ? NumThreads
+                             : ThreadPool::getDefaultConcurrency());
+
+  // Units only read the shared abbreviations and sections while extracting
+  // their DIEs, so each unit can be extracted on its own thread.
+  std::vector<DWARFUnit *> Units;
+  for (const auto &CU : CUs)
+    Units.push_back(CU.get());
+  for (const auto &TUS : TUs)
+    for (const auto &TU : TUS)
+      Units.push_back(TU.get());
+  for (DWARFUnit *U : Units)
+    Pool.async([U] { U->getNumDIEs(); });
+  Pool.wait();
+
+  // Line tables are cached by offset, so collect them in unit order; when
+  // units share a table the first unit's address size wins, as it would in
+  // getLineTableForUnit.
+  std::vector<std::pair<uint32_t, uint8_t>> LineTables;
+  for (const auto &CU : CUs) {
+    const auto *UnitDIE = CU->getUnitDIE();
+    if (!UnitDIE)
+      continue;
+    unsigned StmtOffset = UnitDIE->getAttributeValueAsSectionOffset(
+        CU.get(), DW_AT_stmt_list, -1U);
+    if (StmtOffset != -1U)
+      LineTables.push_back(
+          std::make_pair(StmtOffset, CU->getAddressByteSize()));
+  }
+  Line->parseLineTables(Pool, getLineSection().Data, isLittleEndian(),
+                        LineTables);
+}
+
 void DWARFContext::parseCompileUnits() {
   CUs.parse(*this, getInfoSection());
 }
@@ -11,6 +11,7 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -253,6 +254,41 @@ DWARFDebugLine::getOrParseLineTable(DataExtractor debug_line_data,
   return LT;
 }
 
+void DWARFDebugLine::parseLineTables(
+    ThreadPool &Pool, StringRef DebugLineData, bool IsLittleEndian,
+    ArrayRef<std::pair<uint32_t, uint8_t>> Tables) {
+  // Create the map entries up front, so that the parses don't touch the map
+  // and each one writes only to its own table.
+  struct PendingTable {
+    uint32_t Offset;
+    uint8_t AddrSize;
+    LineTable *LT;
+    bool Failed;
+  };
+  std::vector<PendingTable> Pending;
+  for (const auto &T : Tables) {
+    std::pair<LineTableIter, bool> pos =
+        LineTableMap.insert(LineTableMapTy::value_type(T.first, LineTable()));
+    if (pos.second) {
+      PendingTable PT = {T.first, T.second, &pos.first->second, false};
+      Pending.push_back(PT);
+    }
+  }
+
+  for (PendingTable &PT : Pending) {
+    Pool.async([&PT, DebugLineData, IsLittleEndian, this] {
+      DataExtractor Data(DebugLineData, IsLittleEndian, PT.AddrSize);
+      uint32_t Offset = PT.Offset;
+      PT.Failed = !PT.LT->parse(Data, RelocMap, &Offset);
+    });
+  }
+  Pool.wait();
+
+  for (const PendingTable &PT : Pending)
+    if (PT.Failed)
+      LineTableMap.erase(PT.Offset);
+}
+
 bool DWARFDebugLine::LineTable::parse(DataExtractor debug_line_data,
                                       const RelocAddrMap *RMap,
                                       uint32_t *offset_ptr) {
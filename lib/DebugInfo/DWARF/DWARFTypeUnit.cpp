@@ -22,7 +22,7 @@ bool DWARFTypeUnit::extractImpl(DataExtractor debug_info,
   return TypeOffset < getLength();
 }
 
-void DWARFTypeUnit::dump(raw_ostream &OS) {
+void DWARFTypeUnit::dump(raw_ostream &OS, bool Streaming) {
   OS << format("0x%08x", getOffset()) << ": Type Unit:"
      << " length = " << format("0x%08x", getLength())
      << " version = " << format("0x%04x", getVersion())
@@ -33,7 +33,10 @@ void DWARFTypeUnit::dump(raw_ostream &OS) {
      << " (next unit at " << format("0x%08x", getNextUnitOffset())
      << ")\n";
 
-  if (const DWARFDebugInfoEntryMinimal *TU = getUnitDIE(false))
+  if (Streaming) {
+    if (!dumpDIEsStreaming(OS))
+      OS << "<type unit can't be parsed!>\n\n";
+  } else if (const DWARFDebugInfoEntryMinimal *TU = getUnitDIE(false))
     TU->dump(OS, this, -1U);
   else
     OS << "<type unit can't be parsed!>\n\n";
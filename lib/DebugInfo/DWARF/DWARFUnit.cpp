@@ -216,6 +216,38 @@ void DWARFUnit::extractDIEsToVector(
                     "bounds cu 0x%8.8x at 0x%8.8x'\n", getOffset(), DIEOffset);
 }
 
+bool DWARFUnit::dumpDIEsStreaming(raw_ostream &OS) {
+  // Walk the DIEs in the same order and with the same termination rules as
+  // extractDIEsToVector, indenting each one by its depth in the tree the way
+  // the recursive dump does. NULL entries are printed at the depth of the
+  // children they terminate.
+  // Attribute decoding needs the base addresses read from the unit DIE, so
+  // that one DIE is still extracted and kept.
+  extractDIEsIfNeeded(true);
+  uint32_t DIEOffset = Offset + getHeaderSize();
+  uint32_t NextCUOffset = getNextUnitOffset();
+  DWARFDebugInfoEntryMinimal DIE;
+  uint32_t Depth = 0;
+  bool IsCUDie = true;
+
+  while (DIEOffset < NextCUOffset && DIE.extractFast(this, &DIEOffset)) {
+    DIE.dump(OS, this, 0, Depth * 2);
+    if (DIE.hasChildren()) {
+      ++Depth;
+    } else if (IsCUDie) {
+      // A unit DIE without children is all the recursive dump prints.
+      return true;
+    } else if (DIE.isNULL()) {
+      if (Depth > 0)
+        --Depth;
+      if (Depth == 0)
+        break;
+    }
+    IsCUDie = false;
+  }
+  return !IsCUDie;
+}
+
 size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
   if ((CUDieOnly && DieArray.size() > 0) ||
       DieArray.size() > 1)
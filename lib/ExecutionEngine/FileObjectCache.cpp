@@ -0,0 +1,153 @@
+//===- FileObjectCache.cpp - Persistent on-disk object cache --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ObjectCache that keeps JIT-compiled objects in a
+// directory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/FileObjectCache.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "object-cache"
+
+STATISTIC(NumCacheHits, "Number of objects loaded from the object cache");
+STATISTIC(NumCacheMisses, "Number of objects not found in the object cache");
+STATISTIC(NumObjectsWritten, "Number of objects written to the object cache");
+STATISTIC(NumObjectsPruned, "Number of objects removed from the object cache");
+
+FileObjectCache::FileObjectCache(StringRef CacheDir, const TargetMachine &TM,
+                                 uint64_t SizeLimit)
+    : CacheDir(CacheDir), Cache(CacheDir, "llvmobjcache-"),
+      TargetKey(CodeGenCache::computeTargetKey(TM)), SizeLimit(SizeLimit) {
+  sys::fs::create_directories(this->CacheDir);
+}
+
+FileObjectCache::~FileObjectCache() {}
+
+// Returns true if M refers to a global value that belongs to another module.
+// Such a module can't be serialized.
+static bool referencesOtherModules(const Module &M) {
+  SmallVector<const Constant*, 16> Worklist;
+  SmallPtrSet<const Constant*, 32> Visited;
+  auto AddOperands = [&](const User &U) {
+    for (const Value *Op : U.operands())
+      if (auto *C = dyn_cast<Constant>(Op))
+        if (Visited.insert(C).second)
+          Worklist.push_back(C);
+  };
+
+  for (const GlobalVariable &GV : M.globals())
+    AddOperands(GV);
+  for (const GlobalAlias &GA : M.aliases())
+    AddOperands(GA);
+  for (const Function &F : M) {
+    AddOperands(F);
+    for (const BasicBlock &BB : F)
+      for (const Instruction &I : BB)
+        AddOperands(I);
+  }
+
+  while (!Worklist.empty()) {
+    const Constant *C = Worklist.pop_back_val();
+    if (auto *GV = dyn_cast<GlobalValue>(C)) {
+      if (GV->getParent() != &M)
+        return true;
+      continue;
+    }
+    AddOperands(*C);
+  }
+  return false;
+}
+
+std::string FileObjectCache::computeKey(const Module &M) const {
+  SmallVector<char, 0> Bitcode;
+  raw_svector_ostream BitcodeOS(Bitcode);
+  WriteBitcodeToFile(&M, BitcodeOS);
+  BitcodeOS.flush();
+
+  MD5 Hash;
+  Hash.update(TargetKey);
+  Hash.update(ArrayRef<uint8_t>((const uint8_t*)Bitcode.data(),
+                                Bitcode.size()));
+  MD5::MD5Result Result;
+  Hash.final(Result);
+
+  SmallString<32> Key;
+  MD5::stringifyResult(Result, Key);
+  return Key.str();
+}
+
+std::string FileObjectCache::getObjectPath(const Module &M) const {
+  SmallString<128> Path;
+  Cache.getEntryPath(computeKey(M), Path);
+  return Path.str();
+}
+
+std::unique_ptr<MemoryBuffer> FileObjectCache::getObject(const Module *M) {
+  // The bitcode of a module that hasn't been fully read yet doesn't identify
+  // the code it will compile to.
+  if (M->getMaterializer() || referencesOtherModules(*M))
+    return nullptr;
+
+  std::string Key = computeKey(*M);
+
+  // Don't hand out anything that isn't an object, e.g. a file truncated by a
+  // full disk. It will be replaced once the module has been compiled.
+  std::unique_ptr<MemoryBuffer> Buffer = Cache.lookup(Key);
+  if (Buffer &&
+      object::ObjectFile::createObjectFile(Buffer->getMemBufferRef())) {
+    ++NumCacheHits;
+    return Buffer;
+  }
+
+  ++NumCacheMisses;
+  std::lock_guard<std::mutex> Lock(PendingKeysMutex);
+  PendingKeys[M] = std::move(Key);
+  return nullptr;
+}
+
+void FileObjectCache::notifyObjectCompiled(const Module *M,
+                                           MemoryBufferRef Obj) {
+  std::string Key;
+  {
+    std::lock_guard<std::mutex> Lock(PendingKeysMutex);
+    auto I = PendingKeys.find(M);
+    if (I != PendingKeys.end()) {
+      Key = std::move(I->second);
+      PendingKeys.erase(I);
+    }
+  }
+  if (Key.empty()) {
+    // The module wasn't looked up first, so it may already have been changed
+    // by compilation; its object can't be keyed reliably.
+    return;
+  }
+
+  if (!Cache.store(Key, Obj.getBuffer()))
+    return;
+  ++NumObjectsWritten;
+
+  prune();
+}
+
+void FileObjectCache::prune() {
+  NumObjectsPruned += Cache.prune(SizeLimit);
+}
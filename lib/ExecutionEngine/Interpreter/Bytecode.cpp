@@ -0,0 +1,479 @@
+//===-- Bytecode.cpp - Translate functions for the interpreter -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file translates LLVM functions into the pre-decoded form executed by
+//  the interpreter.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Interpreter.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/Host.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "interpreter"
+
+STATISTIC(NumTranslatedFunctions, "Number of functions translated");
+STATISTIC(NumFastInsts, "Number of instructions with a dedicated handler");
+STATISTIC(NumGenericInsts, "Number of instructions executed by visiting them");
+
+typedef InterpFunction IF;
+
+namespace {
+// The kinds of values that have dedicated handlers.
+enum ScalarKind { SK_Other, SK_Int, SK_Float, SK_Double, SK_Pointer };
+}
+
+static ScalarKind getScalarKind(Type *Ty) {
+  switch (Ty->getTypeID()) {
+  case Type::IntegerTyID:
+    return cast<IntegerType>(Ty)->getBitWidth() <= 64 ? SK_Int : SK_Other;
+  case Type::FloatTyID:
+    return SK_Float;
+  case Type::DoubleTyID:
+    return SK_Double;
+  case Type::PointerTyID:
+    return SK_Pointer;
+  default:
+    return SK_Other;
+  }
+}
+
+static unsigned getIntWidth(Type *Ty) {
+  return cast<IntegerType>(Ty)->getBitWidth();
+}
+
+InterpFunction &Interpreter::getFunctionCode(Function *F) {
+  std::unique_ptr<InterpFunction> &Code = FunctionCode[F];
+  if (!Code) {
+    Code.reset(new InterpFunction());
+    translateFunction(*F, *Code);
+  }
+  return *Code;
+}
+
+IF::Operand Interpreter::getTranslatedOperand(Value *V, InterpFunction &Code) {
+  if (!isa<Constant>(V))
+    return Code.getSlot(V);
+
+  auto I = Code.ConstantNumbers.find(V);
+  if (I != Code.ConstantNumbers.end())
+    return ~IF::Operand(I->second);
+
+  // Constants don't depend on the frame.
+  ExecutionContext NoFrame;
+  unsigned Number = Code.Constants.size();
+  Code.Constants.push_back(getOperandValue(V, NoFrame));
+  Code.ConstantNumbers[V] = Number;
+  return ~IF::Operand(Number);
+}
+
+unsigned Interpreter::addEdge(BasicBlock *From, BasicBlock *To,
+                              InterpFunction &Code) {
+  IF::Edge E;
+  E.Dest = Code.BlockNumbers.lookup(To);
+  E.FirstMove = Code.Moves.size();
+  for (BasicBlock::iterator I = To->begin(); PHINode *PN = dyn_cast<PHINode>(I);
+       ++I) {
+    IF::Move M;
+    M.Src = getTranslatedOperand(PN->getIncomingValueForBlock(From), Code);
+    M.Dst = Code.getSlot(PN);
+    Code.Moves.push_back(M);
+  }
+  E.NumMoves = Code.Moves.size() - E.FirstMove;
+  Code.Edges.push_back(E);
+  return Code.Edges.size() - 1;
+}
+
+void Interpreter::translateFunction(Function &F, InterpFunction &Code) {
+  ++NumTranslatedFunctions;
+
+  // Number the slots.  Existing numbers are kept, so that frames that are
+  // already executing F stay valid.
+  for (Argument &A : F.args())
+    if (!Code.Slots.count(&A))
+      Code.Slots[&A] = Code.NumSlots++;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (!I.getType()->isVoidTy() && !Code.Slots.count(&I))
+        Code.Slots[&I] = Code.NumSlots++;
+
+  Code.Insts.clear();
+  Code.Blocks.clear();
+  Code.Edges.clear();
+  Code.Moves.clear();
+  Code.GEPIndices.clear();
+  Code.GEPs.clear();
+  Code.CallArgs.clear();
+  Code.BlockNumbers.clear();
+  Code.InstNumbers.clear();
+
+  for (BasicBlock &BB : F) {
+    Code.BlockNumbers[&BB] = Code.Blocks.size();
+    IF::Block B = { &BB, 0 };
+    Code.Blocks.push_back(B);
+  }
+
+  for (BasicBlock &BB : F) {
+    Code.Blocks[Code.BlockNumbers[&BB]].FirstInst = Code.Insts.size();
+    for (Instruction &I : BB) {
+      if (isa<PHINode>(I))
+        continue;
+      Code.InstNumbers[&I] = Code.Insts.size();
+      translateInstruction(I, Code);
+    }
+  }
+}
+
+void Interpreter::translateInstruction(Instruction &I, InterpFunction &Code) {
+  IF::Inst Inst;
+  Inst.Op = IF::Generic;
+  Inst.Width = 0;
+  Inst.Extra = 0;
+  Inst.Dst = I.getType()->isVoidTy() ? 0 : Code.getSlot(&I);
+  Inst.Ops[0] = Inst.Ops[1] = Inst.Ops[2] = 0;
+  Inst.I = &I;
+
+  // Loads and stores can only access memory directly if the target uses the
+  // host's byte order and pointer size.
+  bool HostMemory = TD.isLittleEndian() == sys::IsLittleEndianHost &&
+                    TD.getPointerSize() == sizeof(PointerTy);
+
+  // Only operands that are constants or have a slot can be resolved; anything
+  // else (inline asm, metadata) is left to the visitor.
+  bool Resolvable = true;
+  for (Value *Op : I.operands())
+    if (!isa<Constant>(Op) && !Code.Slots.count(Op) && !isa<BasicBlock>(Op))
+      Resolvable = false;
+
+  ScalarKind Kind = getScalarKind(I.getType());
+  unsigned Opcode = Resolvable ? I.getOpcode() : 0;
+  switch (Opcode) {
+  default:
+    break;
+
+  case Instruction::Add:  case Instruction::Sub:  case Instruction::Mul:
+  case Instruction::UDiv: case Instruction::SDiv: case Instruction::URem:
+  case Instruction::SRem: case Instruction::And:  case Instruction::Or:
+  case Instruction::Xor:  case Instruction::Shl:  case Instruction::LShr:
+  case Instruction::AShr: {
+    if (Kind != SK_Int)
+      break;
+    static const IF::Opcode IntOps[] = {
+      IF::Add, IF::Sub, IF::Mul, IF::UDiv, IF::SDiv, IF::URem, IF::SRem,
+      IF::And, IF::Or, IF::Xor, IF::Shl, IF::LShr, IF::AShr
+    };
+    static const unsigned IROps[] = {
+      Instruction::Add, Instruction::Sub, Instruction::Mul, Instruction::UDiv,
+      Instruction::SDiv, Instruction::URem, Instruction::SRem,
+      Instruction::And, Instruction::Or, Instruction::Xor, Instruction::Shl,
+      Instruction::LShr, Instruction::AShr
+    };
+    for (unsigned i = 0; i != array_lengthof(IROps); ++i)
+      if (IROps[i] == Opcode)
+        Inst.Op = IntOps[i];
+    Inst.Width = getIntWidth(I.getType());
+    break;
+  }
+
+  case Instruction::FAdd: case Instruction::FSub: case Instruction::FMul:
+  case Instruction::FDiv: case Instruction::FRem: {
+    if (Kind != SK_Float && Kind != SK_Double)
+      break;
+    bool IsFloat = Kind == SK_Float;
+    switch (Opcode) {
+    case Instruction::FAdd: Inst.Op = IsFloat ? IF::FAddF : IF::FAddD; break;
+    case Instruction::FSub: Inst.Op = IsFloat ? IF::FSubF : IF::FSubD; break;
+    case Instruction::FMul: Inst.Op = IsFloat ? IF::FMulF : IF::FMulD; break;
+    case Instruction::FDiv: Inst.Op = IsFloat ? IF::FDivF : IF::FDivD; break;
+    case Instruction::FRem: Inst.Op = IsFloat ? IF::FRemF : IF::FRemD; break;
+    }
+    break;
+  }
+
+  case Instruction::ICmp: {
+    Type *OpTy = I.getOperand(0)->getType();
+    ScalarKind OpKind = getScalarKind(OpTy);
+    if (OpKind == SK_Int) {
+      Inst.Op = IF::ICmpInt;
+      Inst.Width = getIntWidth(OpTy);
+      Inst.Extra = cast<ICmpInst>(I).getPredicate();
+    } else if (OpKind == SK_Pointer) {
+      // Pointers compare as unsigned values, whatever the predicate.
+      Inst.Op = IF::ICmpPtr;
+      Inst.Extra = cast<ICmpInst>(I).getUnsignedPredicate();
+    }
+    break;
+  }
+
+  case Instruction::FCmp: {
+    ScalarKind OpKind = getScalarKind(I.getOperand(0)->getType());
+    if (OpKind != SK_Float && OpKind != SK_Double)
+      break;
+    Inst.Op = OpKind == SK_Float ? IF::FCmpF : IF::FCmpD;
+    Inst.Extra = cast<FCmpInst>(I).getPredicate();
+    break;
+  }
+
+  case Instruction::Trunc: case Instruction::ZExt: case Instruction::SExt: {
+    if (Kind != SK_Int || getScalarKind(I.getOperand(0)->getType()) != SK_Int)
+      break;
+    Inst.Op = Opcode == Instruction::SExt ? IF::SExt : IF::ZExtOrTrunc;
+    Inst.Width = getIntWidth(I.getType());
+    break;
+  }
+
+  case Instruction::PtrToInt:
+    if (Kind != SK_Int ||
+        getScalarKind(I.getOperand(0)->getType()) != SK_Pointer)
+      break;
+    Inst.Op = IF::PtrToInt;
+    Inst.Width = getIntWidth(I.getType());
+    break;
+
+  case Instruction::IntToPtr:
+    if (Kind != SK_Pointer ||
+        getScalarKind(I.getOperand(0)->getType()) != SK_Int)
+      break;
+    Inst.Op = IF::IntToPtr;
+    Inst.Width = TD.getPointerSizeInBits();
+    break;
+
+  case Instruction::BitCast:
+    if (Kind == SK_Pointer &&
+        getScalarKind(I.getOperand(0)->getType()) == SK_Pointer)
+      Inst.Op = IF::BitCastPtr;
+    break;
+
+  case Instruction::SIToFP: case Instruction::UIToFP: {
+    Type *SrcTy = I.getOperand(0)->getType();
+    if (getScalarKind(SrcTy) != SK_Int || (Kind != SK_Float && Kind != SK_Double))
+      break;
+    bool IsSigned = Opcode == Instruction::SIToFP;
+    if (Kind == SK_Float)
+      Inst.Op = IsSigned ? IF::SIToFPF : IF::UIToFPF;
+    else
+      Inst.Op = IsSigned ? IF::SIToFPD : IF::UIToFPD;
+    Inst.Width = getIntWidth(SrcTy);
+    break;
+  }
+
+  case Instruction::FPToSI: case Instruction::FPToUI: {
+    ScalarKind SrcKind = getScalarKind(I.getOperand(0)->getType());
+    if (Kind != SK_Int || (SrcKind != SK_Float && SrcKind != SK_Double))
+      break;
+    bool IsSigned = Opcode == Instruction::FPToSI;
+    if (SrcKind == SK_Float)
+      Inst.Op = IsSigned ? IF::FToSI : IF::FToUI;
+    else
+      Inst.Op = IsSigned ? IF::DToSI : IF::DToUI;
+    Inst.Width = getIntWidth(I.getType());
+    break;
+  }
+
+  case Instruction::FPExt:
+    if (Kind == SK_Double &&
+        getScalarKind(I.getOperand(0)->getType()) == SK_Float)
+      Inst.Op = IF::FPExt;
+    break;
+
+  case Instruction::FPTrunc:
+    if (Kind == SK_Float &&
+        getScalarKind(I.getOperand(0)->getType()) == SK_Double)
+      Inst.Op = IF::FPTrunc;
+    break;
+
+  case Instruction::Select:
+    if (I.getOperand(0)->getType()->isVectorTy())
+      break;
+    switch (Kind) {
+    case SK_Int:     Inst.Op = IF::SelectInt; break;
+    case SK_Float:   Inst.Op = IF::SelectF;   break;
+    case SK_Double:  Inst.Op = IF::SelectD;   break;
+    case SK_Pointer: Inst.Op = IF::SelectPtr; break;
+    case SK_Other:   break;
+    }
+    break;
+
+  case Instruction::Load: {
+    LoadInst &LI = cast<LoadInst>(I);
+    if (!HostMemory || LI.isVolatile())
+      break;
+    switch (Kind) {
+    case SK_Int: {
+      unsigned Width = getIntWidth(I.getType());
+      if (Width == 8 || Width == 16 || Width == 32 || Width == 64) {
+        Inst.Op = IF::LoadInt;
+        Inst.Width = Width;
+      }
+      break;
+    }
+    case SK_Float:   Inst.Op = IF::LoadF;   break;
+    case SK_Double:  Inst.Op = IF::LoadD;   break;
+    case SK_Pointer: Inst.Op = IF::LoadPtr; break;
+    case SK_Other:   break;
+    }
+    break;
+  }
+
+  case Instruction::Store: {
+    StoreInst &SI = cast<StoreInst>(I);
+    if (!HostMemory || SI.isVolatile())
+      break;
+    Type *ValTy = SI.getValueOperand()->getType();
+    switch (getScalarKind(ValTy)) {
+    case SK_Int: {
+      unsigned Width = getIntWidth(ValTy);
+      if (Width == 8 || Width == 16 || Width == 32 || Width == 64) {
+        Inst.Op = IF::StoreInt;
+        Inst.Width = Width;
+      }
+      break;
+    }
+    case SK_Float:   Inst.Op = IF::StoreF;   break;
+    case SK_Double:  Inst.Op = IF::StoreD;   break;
+    case SK_Pointer: Inst.Op = IF::StorePtr; break;
+    case SK_Other:   break;
+    }
+    break;
+  }
+
+  case Instruction::GetElementPtr: {
+    GetElementPtrInst &GEP = cast<GetElementPtrInst>(I);
+    if (Kind != SK_Pointer)
+      break;
+    // Fold the constant indices into a single offset.
+    IF::GEPInfo Info = { 0, (unsigned)Code.GEPIndices.size(), 0 };
+    bool Supported = true;
+    for (gep_type_iterator GTI = gep_type_begin(GEP), E = gep_type_end(GEP);
+         GTI != E; ++GTI) {
+      if (StructType *STy = dyn_cast<StructType>(*GTI)) {
+        unsigned Index = cast<ConstantInt>(GTI.getOperand())->getZExtValue();
+        Info.ConstantOffset += TD.getStructLayout(STy)->getElementOffset(Index);
+        continue;
+      }
+      int64_t Scale =
+        TD.getTypeAllocSize(cast<SequentialType>(*GTI)->getElementType());
+      Value *Index = GTI.getOperand();
+      unsigned IndexWidth = getIntWidth(Index->getType());
+      if (IndexWidth != 32 && IndexWidth != 64) {
+        Supported = false;
+        break;
+      }
+      if (ConstantInt *CI = dyn_cast<ConstantInt>(Index)) {
+        Info.ConstantOffset += Scale * CI->getSExtValue();
+        continue;
+      }
+      IF::GEPIndex GI = { getTranslatedOperand(Index, Code), IndexWidth == 32,
+                          Scale };
+      Code.GEPIndices.push_back(GI);
+      ++Info.NumIndices;
+    }
+    if (!Supported) {
+      Code.GEPIndices.resize(Info.FirstIndex);
+      break;
+    }
+    Inst.Op = IF::GEP;
+    Inst.Ops[0] = getTranslatedOperand(GEP.getPointerOperand(), Code);
+    Inst.Extra = Code.GEPs.size();
+    Code.GEPs.push_back(Info);
+    break;
+  }
+
+  case Instruction::Br: {
+    BranchInst &BI = cast<BranchInst>(I);
+    if (BI.isUnconditional()) {
+      Inst.Op = IF::Br;
+      Inst.Extra = addEdge(BI.getParent(), BI.getSuccessor(0), Code);
+    } else {
+      Inst.Op = IF::CondBr;
+      Inst.Ops[0] = getTranslatedOperand(BI.getCondition(), Code);
+      Inst.Extra = addEdge(BI.getParent(), BI.getSuccessor(0), Code);
+      addEdge(BI.getParent(), BI.getSuccessor(1), Code);
+    }
+    break;
+  }
+
+  case Instruction::Ret: {
+    ReturnInst &RI = cast<ReturnInst>(I);
+    Inst.Op = IF::Ret;
+    if (Value *RetVal = RI.getReturnValue()) {
+      Inst.Width = 1;
+      Inst.Ops[0] = getTranslatedOperand(RetVal, Code);
+    }
+    break;
+  }
+
+  case Instruction::Call: {
+    CallInst &CI = cast<CallInst>(I);
+    // Intrinsics need special handling.
+    if (Function *F = CI.getCalledFunction())
+      if (F->isIntrinsic())
+        break;
+    Inst.Op = IF::Call;
+    Inst.Ops[0] = getTranslatedOperand(CI.getCalledValue(), Code);
+    Inst.Ops[1] = CI.getNumArgOperands();
+    Inst.Extra = Code.CallArgs.size();
+    for (Value *Arg : CI.arg_operands())
+      Code.CallArgs.push_back(getTranslatedOperand(Arg, Code));
+    break;
+  }
+  }
+
+  // Resolve the operands of the simple instructions, whose operand order
+  // matches the IR.
+  switch (Inst.Op) {
+  case IF::Generic:
+    ++NumGenericInsts;
+    break;
+  case IF::GEP: case IF::Br: case IF::CondBr: case IF::Ret: case IF::Call:
+    ++NumFastInsts;
+    break;
+  case IF::StoreInt: case IF::StoreF: case IF::StoreD: case IF::StorePtr:
+    ++NumFastInsts;
+    Inst.Ops[0] = getTranslatedOperand(I.getOperand(0), Code);
+    Inst.Ops[1] = getTranslatedOperand(I.getOperand(1), Code);
+    break;
+  default:
+    ++NumFastInsts;
+    for (unsigned i = 0, e = I.getNumOperands(); i != e; ++i)
+      Inst.Ops[i] = getTranslatedOperand(I.getOperand(i), Code);
+    break;
+  }
+
+  Code.Insts.push_back(Inst);
+}
+
+void Interpreter::retranslateAfterLowering(Function *F, Instruction *Lowered,
+                                           Instruction *Resume) {
+  InterpFunction &Code = getFunctionCode(F);
+
+  // Remember the instruction at which each frame executing F resumes.  The
+  // pointers are only compared: Lowered has already been deleted.
+  std::vector<std::pair<ExecutionContext *, Instruction *>> Frames;
+  for (ExecutionContext &SF : ECStack)
+    if (SF.Code == &Code) {
+      Instruction *At =
+        SF.PC < Code.Insts.size() ? Code.Insts[SF.PC].I : nullptr;
+      Frames.push_back(std::make_pair(&SF, At == Lowered ? Resume : At));
+    }
+
+  translateFunction(*F, Code);
+
+  for (auto &Frame : Frames) {
+    if (Frame.second)
+      Frame.first->PC = Code.InstNumbers.lookup(Frame.second);
+    Frame.first->Values.resize(Code.NumSlots);
+  }
+}
@@ -13,6 +13,7 @@
 
 #include "Interpreter.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/IntrinsicLowering.h"
 #include "llvm/IR/Constants.h"
@@ -21,11 +22,13 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 using namespace llvm;
 
 #define DEBUG_TYPE "interpreter"
@@ -40,7 +43,7 @@ static cl::opt<bool> PrintVolatile("interpreter-print-volatile", cl::Hidden,
 //===----------------------------------------------------------------------===//
 
 static void SetValue(Value *V, GenericValue Val, ExecutionContext &SF) {
-  SF.Values[V] = Val;
+  SF.Values[SF.Code->getSlot(V)] = Val;
 }
 
 //===----------------------------------------------------------------------===//
@@ -930,14 +933,16 @@ void Interpreter::visitIndirectBrInst(IndirectBrInst &I) {
 void Interpreter::SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF){
   BasicBlock *PrevBB = SF.CurBB;      // Remember where we came from...
   SF.CurBB   = Dest;                  // Update CurBB to branch destination
-  SF.CurInst = SF.CurBB->begin();     // Update new instruction ptr...
+  // Update the PC to the first instruction after the PHI nodes.
+  SF.PC = SF.Code->Blocks[SF.Code->BlockNumbers.lookup(Dest)].FirstInst;
 
-  if (!isa<PHINode>(SF.CurInst)) return;  // Nothing fancy to do
+  BasicBlock::iterator CurInst = Dest->begin();
+  if (!isa<PHINode>(CurInst)) return;  // Nothing fancy to do
 
   // Loop over all of the PHI nodes in the current block, reading their inputs.
   std::vector<GenericValue> ResultValues;
 
-  for (; PHINode *PN = dyn_cast<PHINode>(SF.CurInst); ++SF.CurInst) {
+  for (; PHINode *PN = dyn_cast<PHINode>(CurInst); ++CurInst) {
     // Search for the value corresponding to this previous bb...
     int i = PN->getBasicBlockIndex(PrevBB);
     assert(i != -1 && "PHINode doesn't contain entry for predecessor??");
@@ -948,9 +953,9 @@ void Interpreter::SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF){
   }
 
   // Now loop over all of the PHI nodes setting their values...
-  SF.CurInst = SF.CurBB->begin();
-  for (unsigned i = 0; isa<PHINode>(SF.CurInst); ++SF.CurInst, ++i) {
-    PHINode *PN = cast<PHINode>(SF.CurInst);
+  CurInst = Dest->begin();
+  for (unsigned i = 0; isa<PHINode>(CurInst); ++CurInst, ++i) {
+    PHINode *PN = cast<PHINode>(CurInst);
     SetValue(PN, ResultValues[i], SF);
   }
 }
@@ -1086,21 +1091,19 @@ void Interpreter::visitCallSite(CallSite CS) {
       // If it is an unknown intrinsic function, use the intrinsic lowering
       // class to transform it into hopefully tasty LLVM code.
       //
-      BasicBlock::iterator me(CS.getInstruction());
-      BasicBlock *Parent = CS.getInstruction()->getParent();
+      Instruction *Lowered = CS.getInstruction();
+      BasicBlock::iterator me(Lowered);
+      BasicBlock *Parent = Lowered->getParent();
       bool atBegin(Parent->begin() == me);
       if (!atBegin)
         --me;
-      IL->LowerIntrinsicCall(cast<CallInst>(CS.getInstruction()));
+      IL->LowerIntrinsicCall(cast<CallInst>(Lowered));
 
-      // Restore the CurInst pointer to the first instruction newly inserted, if
-      // any.
-      if (atBegin) {
-        SF.CurInst = Parent->begin();
-      } else {
-        SF.CurInst = me;
-        ++SF.CurInst;
-      }
+      // Resume at the first instruction newly inserted, if any, once the
+      // function has been translated again.
+      Instruction *Resume = atBegin ? Parent->begin() : std::next(me);
+      --SF.PC;
+      retranslateAfterLowering(SF.CurFunction, Lowered, Resume);
       return;
     }
 
@@ -2062,7 +2065,7 @@ GenericValue Interpreter::getOperandValue(Value *V, ExecutionContext &SF) {
   } else if (GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
     return PTOGV(getPointerToGlobal(GV));
   } else {
-    return SF.Values[V];
+    return SF.Values[SF.Code->getSlot(V)];
   }
 }
 
@@ -2091,44 +2094,402 @@ void Interpreter::callFunction(Function *F,
     return;
   }
 
-  // Get pointers to first LLVM BB & Instruction in function.
+  // Get the translation of the function, and start at its entry block.
+  StackFrame.Code      = &getFunctionCode(F);
   StackFrame.CurBB     = F->begin();
-  StackFrame.CurInst   = StackFrame.CurBB->begin();
+  StackFrame.PC        = StackFrame.Code->Blocks[0].FirstInst;
+  StackFrame.Values.resize(StackFrame.Code->NumSlots);
 
   // Run through the function arguments and initialize their values...
   assert((ArgVals.size() == F->arg_size() ||
          (ArgVals.size() > F->arg_size() && F->getFunctionType()->isVarArg()))&&
          "Invalid number of values passed to function invocation!");
 
-  // Handle non-varargs arguments...
+  // Handle non-varargs arguments; they occupy the first slots.
   unsigned i = 0;
-  for (Function::arg_iterator AI = F->arg_begin(), E = F->arg_end(); 
-       AI != E; ++AI, ++i)
-    SetValue(AI, ArgVals[i], StackFrame);
+  for (unsigned e = F->arg_size(); i != e; ++i)
+    StackFrame.Values[i] = ArgVals[i];
 
   // Handle varargs arguments...
   StackFrame.VarArgs.assign(ArgVals.begin()+i, ArgVals.end());
 }
 
 
+//===----------------------------------------------------------------------===//
+// executeInst - Execute an instruction that has a dedicated handler.  The
+// operands are already resolved and their types known, so unlike the visit*
+// methods these don't look at the IR at all.
+//
+static inline const GenericValue &getOperand(InterpFunction::Operand Op,
+                                             ExecutionContext &SF) {
+  return Op >= 0 ? SF.Values[Op] : SF.Code->Constants[~Op];
+}
+
+static inline uint64_t getShiftAmount(uint64_t Amount, unsigned BitWidth) {
+  // Match the APInt based implementation: out of range shift amounts are
+  // masked to the next power of two.
+  if (Amount < BitWidth)
+    return Amount;
+  return (NextPowerOf2(BitWidth - 1) - 1) & Amount;
+}
+
+static bool evaluateICmp(unsigned Pred, uint64_t L, uint64_t R,
+                         unsigned BitWidth) {
+  switch (Pred) {
+  case ICmpInst::ICMP_EQ:  return L == R;
+  case ICmpInst::ICMP_NE:  return L != R;
+  case ICmpInst::ICMP_UGT: return L > R;
+  case ICmpInst::ICMP_UGE: return L >= R;
+  case ICmpInst::ICMP_ULT: return L < R;
+  case ICmpInst::ICMP_ULE: return L <= R;
+  default:
+    break;
+  }
+  int64_t SL = SignExtend64(L, BitWidth), SR = SignExtend64(R, BitWidth);
+  switch (Pred) {
+  case ICmpInst::ICMP_SGT: return SL > SR;
+  case ICmpInst::ICMP_SGE: return SL >= SR;
+  case ICmpInst::ICMP_SLT: return SL < SR;
+  case ICmpInst::ICMP_SLE: return SL <= SR;
+  default:
+    llvm_unreachable("Invalid icmp predicate");
+  }
+}
+
+template <typename T> static bool evaluateFCmp(unsigned Pred, T L, T R) {
+  bool Unordered = L != L || R != R;
+  switch (Pred) {
+  case FCmpInst::FCMP_FALSE: return false;
+  case FCmpInst::FCMP_OEQ:   return L == R;
+  case FCmpInst::FCMP_OGT:   return L > R;
+  case FCmpInst::FCMP_OGE:   return L >= R;
+  case FCmpInst::FCMP_OLT:   return L < R;
+  case FCmpInst::FCMP_OLE:   return L <= R;
+  case FCmpInst::FCMP_ONE:   return !Unordered && L != R;
+  case FCmpInst::FCMP_ORD:   return !Unordered;
+  case FCmpInst::FCMP_UNO:   return Unordered;
+  case FCmpInst::FCMP_UEQ:   return Unordered || L == R;
+  case FCmpInst::FCMP_UGT:   return Unordered || L > R;
+  case FCmpInst::FCMP_UGE:   return Unordered || L >= R;
+  case FCmpInst::FCMP_ULT:   return Unordered || L < R;
+  case FCmpInst::FCMP_ULE:   return Unordered || L <= R;
+  case FCmpInst::FCMP_UNE:   return L != R;
+  case FCmpInst::FCMP_TRUE:  return true;
+  default:
+    llvm_unreachable("Invalid fcmp predicate");
+  }
+}
+
+// Load or store a W-bit integer (W is 8, 16, 32 or 64) in the host's byte
+// order, which the translator has checked is also the target's.
+static uint64_t loadHostInt(const void *Ptr, unsigned W) {
+  using namespace support;
+  switch (W) {
+  case 8:  return *static_cast<const uint8_t*>(Ptr);
+  case 16: return endian::read<uint16_t, native, unaligned>(Ptr);
+  case 32: return endian::read<uint32_t, native, unaligned>(Ptr);
+  case 64: return endian::read<uint64_t, native, unaligned>(Ptr);
+  default:
+    llvm_unreachable("Invalid integer width");
+  }
+}
+
+static void storeHostInt(void *Ptr, uint64_t Val, unsigned W) {
+  using namespace support;
+  switch (W) {
+  case 8:  *static_cast<uint8_t*>(Ptr) = Val; return;
+  case 16: endian::write<uint16_t, native, unaligned>(Ptr, Val); return;
+  case 32: endian::write<uint32_t, native, unaligned>(Ptr, Val); return;
+  case 64: endian::write<uint64_t, native, unaligned>(Ptr, Val); return;
+  default:
+    llvm_unreachable("Invalid integer width");
+  }
+}
+
+// Take the edge with index EdgeNo: perform its PHI copies, all reading their
+// inputs before any result is written, and jump to its destination.
+static void takeEdge(unsigned EdgeNo, ExecutionContext &SF) {
+  const InterpFunction &Code = *SF.Code;
+  const InterpFunction::Edge &E = Code.Edges[EdgeNo];
+  const InterpFunction::Move *Moves = Code.Moves.data() + E.FirstMove;
+  if (E.NumMoves == 1) {
+    SF.Values[Moves[0].Dst] = getOperand(Moves[0].Src, SF);
+  } else if (E.NumMoves) {
+    SmallVector<GenericValue, 8> Tmp;
+    Tmp.reserve(E.NumMoves);
+    for (unsigned i = 0; i != E.NumMoves; ++i)
+      Tmp.push_back(getOperand(Moves[i].Src, SF));
+    for (unsigned i = 0; i != E.NumMoves; ++i)
+      SF.Values[Moves[i].Dst] = std::move(Tmp[i]);
+  }
+  const InterpFunction::Block &Dest = Code.Blocks[E.Dest];
+  SF.CurBB = Dest.BB;
+  SF.PC = Dest.FirstInst;
+}
+
+void Interpreter::executeInst(const InterpFunction::Inst &Inst,
+                              ExecutionContext &SF) {
+  typedef InterpFunction IF;
+  const unsigned W = Inst.Width;
+
+  switch (Inst.Op) {
+  case IF::Generic:
+    visit(*Inst.I);
+    return;
+
+#define INT_BINOP(OPCODE, EXPR)                                               \
+  case IF::OPCODE: {                                                          \
+    uint64_t L = getOperand(Inst.Ops[0], SF).IntVal.getZExtValue();           \
+    uint64_t R = getOperand(Inst.Ops[1], SF).IntVal.getZExtValue();           \
+    (void)L; (void)R;                                                         \
+    SF.Values[Inst.Dst].IntVal = APInt(W, EXPR);                              \
+    return;                                                                   \
+  }
+  INT_BINOP(Add, L + R)
+  INT_BINOP(Sub, L - R)
+  INT_BINOP(Mul, L * R)
+  INT_BINOP(And, L & R)
+  INT_BINOP(Or, L | R)
+  INT_BINOP(Xor, L ^ R)
+  INT_BINOP(Shl, L << getShiftAmount(R, W))
+  INT_BINOP(LShr, L >> getShiftAmount(R, W))
+  INT_BINOP(AShr, SignExtend64(L, W) >> getShiftAmount(R, W))
+#undef INT_BINOP
+
+  // Division is rare enough to leave the corner cases to APInt.
+  case IF::UDiv:
+    SF.Values[Inst.Dst].IntVal = getOperand(Inst.Ops[0], SF).IntVal.udiv(
+        getOperand(Inst.Ops[1], SF).IntVal);
+    return;
+  case IF::SDiv:
+    SF.Values[Inst.Dst].IntVal = getOperand(Inst.Ops[0], SF).IntVal.sdiv(
+        getOperand(Inst.Ops[1], SF).IntVal);
+    return;
+  case IF::URem:
+    SF.Values[Inst.Dst].IntVal = getOperand(Inst.Ops[0], SF).IntVal.urem(
+        getOperand(Inst.Ops[1], SF).IntVal);
+    return;
+  case IF::SRem:
+    SF.Values[Inst.Dst].IntVal = getOperand(Inst.Ops[0], SF).IntVal.srem(
+        getOperand(Inst.Ops[1], SF).IntVal);
+    return;
+
+#define FP_BINOP(OPCODE, FIELD, EXPR)                                         \
+  case IF::OPCODE: {                                                          \
+    auto L = getOperand(Inst.Ops[0], SF).FIELD;                               \
+    auto R = getOperand(Inst.Ops[1], SF).FIELD;                               \
+    SF.Values[Inst.Dst].FIELD = EXPR;                                         \
+    return;                                                                   \
+  }
+  FP_BINOP(FAddF, FloatVal, L + R)
+  FP_BINOP(FSubF, FloatVal, L - R)
+  FP_BINOP(FMulF, FloatVal, L * R)
+  FP_BINOP(FDivF, FloatVal, L / R)
+  FP_BINOP(FRemF, FloatVal, fmod(L, R))
+  FP_BINOP(FAddD, DoubleVal, L + R)
+  FP_BINOP(FSubD, DoubleVal, L - R)
+  FP_BINOP(FMulD, DoubleVal, L * R)
+  FP_BINOP(FDivD, DoubleVal, L / R)
+  FP_BINOP(FRemD, DoubleVal, fmod(L, R))
+#undef FP_BINOP
+
+  case IF::ICmpInt: {
+    uint64_t L = getOperand(Inst.Ops[0], SF).IntVal.getZExtValue();
+    uint64_t R = getOperand(Inst.Ops[1], SF).IntVal.getZExtValue();
+    SF.Values[Inst.Dst].IntVal = APInt(1, evaluateICmp(Inst.Extra, L, R, W));
+    return;
+  }
+  case IF::ICmpPtr: {
+    uint64_t L = (uintptr_t)getOperand(Inst.Ops[0], SF).PointerVal;
+    uint64_t R = (uintptr_t)getOperand(Inst.Ops[1], SF).PointerVal;
+    SF.Values[Inst.Dst].IntVal = APInt(1, evaluateICmp(Inst.Extra, L, R, 64));
+    return;
+  }
+  case IF::FCmpF:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(1, evaluateFCmp(Inst.Extra, getOperand(Inst.Ops[0], SF).FloatVal,
+                            getOperand(Inst.Ops[1], SF).FloatVal));
+    return;
+  case IF::FCmpD:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(1, evaluateFCmp(Inst.Extra, getOperand(Inst.Ops[0], SF).DoubleVal,
+                            getOperand(Inst.Ops[1], SF).DoubleVal));
+    return;
+
+  case IF::ZExtOrTrunc:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(W, getOperand(Inst.Ops[0], SF).IntVal.getZExtValue());
+    return;
+  case IF::SExt:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(W, getOperand(Inst.Ops[0], SF).IntVal.getSExtValue());
+    return;
+  case IF::PtrToInt:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(W, (intptr_t)getOperand(Inst.Ops[0], SF).PointerVal);
+    return;
+  case IF::IntToPtr: {
+    // W is the pointer size.
+    APInt Src = APInt(W, getOperand(Inst.Ops[0], SF).IntVal.getZExtValue());
+    SF.Values[Inst.Dst].PointerVal = (PointerTy)(intptr_t)Src.getZExtValue();
+    return;
+  }
+  case IF::BitCastPtr:
+    SF.Values[Inst.Dst].PointerVal = getOperand(Inst.Ops[0], SF).PointerVal;
+    return;
+  case IF::SIToFPF:
+    SF.Values[Inst.Dst].FloatVal =
+      APIntOps::RoundSignedAPIntToFloat(getOperand(Inst.Ops[0], SF).IntVal);
+    return;
+  case IF::SIToFPD:
+    SF.Values[Inst.Dst].DoubleVal =
+      APIntOps::RoundSignedAPIntToDouble(getOperand(Inst.Ops[0], SF).IntVal);
+    return;
+  case IF::UIToFPF:
+    SF.Values[Inst.Dst].FloatVal =
+      APIntOps::RoundAPIntToFloat(getOperand(Inst.Ops[0], SF).IntVal);
+    return;
+  case IF::UIToFPD:
+    SF.Values[Inst.Dst].DoubleVal =
+      APIntOps::RoundAPIntToDouble(getOperand(Inst.Ops[0], SF).IntVal);
+    return;
+  case IF::FToSI:
+  case IF::FToUI:
+    SF.Values[Inst.Dst].IntVal =
+      APIntOps::RoundFloatToAPInt(getOperand(Inst.Ops[0], SF).FloatVal, W);
+    return;
+  case IF::DToSI:
+  case IF::DToUI:
+    SF.Values[Inst.Dst].IntVal =
+      APIntOps::RoundDoubleToAPInt(getOperand(Inst.Ops[0], SF).DoubleVal, W);
+    return;
+  case IF::FPExt:
+    SF.Values[Inst.Dst].DoubleVal = getOperand(Inst.Ops[0], SF).FloatVal;
+    return;
+  case IF::FPTrunc:
+    SF.Values[Inst.Dst].FloatVal = getOperand(Inst.Ops[0], SF).DoubleVal;
+    return;
+
+  case IF::SelectInt:
+  case IF::SelectF:
+  case IF::SelectD:
+  case IF::SelectPtr: {
+    bool Cond = getOperand(Inst.Ops[0], SF).IntVal != 0;
+    const GenericValue &Src = getOperand(Inst.Ops[Cond ? 1 : 2], SF);
+    GenericValue &Dest = SF.Values[Inst.Dst];
+    if (Inst.Op == IF::SelectInt)
+      Dest.IntVal = Src.IntVal;
+    else if (Inst.Op == IF::SelectF)
+      Dest.FloatVal = Src.FloatVal;
+    else if (Inst.Op == IF::SelectD)
+      Dest.DoubleVal = Src.DoubleVal;
+    else
+      Dest.PointerVal = Src.PointerVal;
+    return;
+  }
+
+  case IF::LoadInt:
+    SF.Values[Inst.Dst].IntVal =
+      APInt(W, loadHostInt(getOperand(Inst.Ops[0], SF).PointerVal, W));
+    return;
+  case IF::LoadF:
+    memcpy(&SF.Values[Inst.Dst].FloatVal,
+           getOperand(Inst.Ops[0], SF).PointerVal, sizeof(float));
+    return;
+  case IF::LoadD:
+    memcpy(&SF.Values[Inst.Dst].DoubleVal,
+           getOperand(Inst.Ops[0], SF).PointerVal, sizeof(double));
+    return;
+  case IF::LoadPtr:
+    memcpy(&SF.Values[Inst.Dst].PointerVal,
+           getOperand(Inst.Ops[0], SF).PointerVal, sizeof(PointerTy));
+    return;
+  case IF::StoreInt:
+    storeHostInt(getOperand(Inst.Ops[1], SF).PointerVal,
+                 getOperand(Inst.Ops[0], SF).IntVal.getZExtValue(), W);
+    return;
+  case IF::StoreF:
+    memcpy(getOperand(Inst.Ops[1], SF).PointerVal,
+           &getOperand(Inst.Ops[0], SF).FloatVal, sizeof(float));
+    return;
+  case IF::StoreD:
+    memcpy(getOperand(Inst.Ops[1], SF).PointerVal,
+           &getOperand(Inst.Ops[0], SF).DoubleVal, sizeof(double));
+    return;
+  case IF::StorePtr:
+    memcpy(getOperand(Inst.Ops[1], SF).PointerVal,
+           &getOperand(Inst.Ops[0], SF).PointerVal, sizeof(PointerTy));
+    return;
+
+  case IF::GEP: {
+    const IF::GEPInfo &Info = SF.Code->GEPs[Inst.Extra];
+    int64_t Offset = Info.ConstantOffset;
+    for (unsigned i = 0; i != Info.NumIndices; ++i) {
+      const IF::GEPIndex &Index = SF.Code->GEPIndices[Info.FirstIndex + i];
+      uint64_t Idx = getOperand(Index.Index, SF).IntVal.getZExtValue();
+      Offset += Index.Scale *
+                (Index.Is32Bit ? (int64_t)(int32_t)Idx : (int64_t)Idx);
+    }
+    SF.Values[Inst.Dst].PointerVal =
+      (char*)getOperand(Inst.Ops[0], SF).PointerVal + Offset;
+    return;
+  }
+
+  case IF::Br:
+    takeEdge(Inst.Extra, SF);
+    return;
+  case IF::CondBr:
+    takeEdge(getOperand(Inst.Ops[0], SF).IntVal == 0 ? Inst.Extra + 1
+                                                     : Inst.Extra, SF);
+    return;
+
+  case IF::Ret: {
+    if (!W) {
+      popStackAndReturnValueToCaller(nullptr, GenericValue());
+      return;
+    }
+    // Copy the result out of the frame before it is popped.
+    GenericValue Result = getOperand(Inst.Ops[0], SF);
+    popStackAndReturnValueToCaller(Inst.I->getOperand(0)->getType(), Result);
+    return;
+  }
+
+  case IF::Call: {
+    SF.Caller = CallSite(Inst.I);
+    std::vector<GenericValue> ArgVals;
+    unsigned NumArgs = Inst.Ops[1];
+    ArgVals.reserve(NumArgs);
+    for (unsigned i = 0; i != NumArgs; ++i)
+      ArgVals.push_back(getOperand(SF.Code->CallArgs[Inst.Extra + i], SF));
+    callFunction((Function*)GVTOP(getOperand(Inst.Ops[0], SF)), ArgVals);
+    return;
+  }
+  }
+  llvm_unreachable("Unknown interpreter opcode");
+}
+
+
 void Interpreter::run() {
   while (!ECStack.empty()) {
     // Interpret a single instruction & increment the "PC".
     ExecutionContext &SF = ECStack.back();  // Current stack frame
-    Instruction &I = *SF.CurInst++;         // Increment before execute
+    const InterpFunction::Inst &Inst = SF.Code->Insts[SF.PC++];
 
     // Track the number of dynamic instructions executed.
     ++NumDynamicInsts;
 
-    DEBUG(dbgs() << "About to interpret: " << I);
-    visit(I);   // Dispatch to one of the visit* methods...
+    DEBUG(dbgs() << "About to interpret: " << *Inst.I);
+    if (Inst.Op == InterpFunction::Generic)
+      visit(*Inst.I);   // Dispatch to one of the visit* methods...
+    else
+      executeInst(Inst, SF);
 #if 0
     // This is not safe, as visiting the instruction could lower it and free I.
 DEBUG(
     if (!isa<CallInst>(I) && !isa<InvokeInst>(I) && 
         I.getType() != Type::VoidTy) {
       dbgs() << "  --> ";
-      const GenericValue &Val = SF.Values[&I];
+      const GenericValue &Val = SF.Values[SF.Code->getSlot(&I)];
       switch (I.getType()->getTypeID()) {
       default: llvm_unreachable("Invalid GenericValue Type");
       case Type::VoidTyID:    dbgs() << "void"; break;
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 #define LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/IR/CallSite.h"
@@ -59,30 +60,152 @@ public:
 
 typedef std::vector<GenericValue> ValuePlaneTy;
 
+// InterpFunction - The pre-decoded form of a function, built the first time
+// the function is called.  Every argument and every instruction that produces
+// a value is given a slot in the stack frame, and the instructions are
+// translated into a flat array of InterpInsts whose operands are already
+// resolved to slots or to entries of a constant pool.  Instructions on scalar
+// values (integers of up to 64 bits, float, double and pointers) get a
+// dedicated handler; all others are executed by visiting the original
+// instruction.  PHI nodes are not translated: each CFG edge carries the copies
+// that implement the PHI nodes of its destination.
+//
+struct InterpFunction {
+  enum Opcode : uint16_t {
+    Generic,        // Visit I.
+
+    // Integer arithmetic on Width-bit integers.
+    Add, Sub, Mul, UDiv, SDiv, URem, SRem, And, Or, Xor, Shl, LShr, AShr,
+    // Floating point arithmetic on floats and doubles.
+    FAddF, FSubF, FMulF, FDivF, FRemF,
+    FAddD, FSubD, FMulD, FDivD, FRemD,
+    // Comparisons; Extra is the predicate.
+    ICmpInt, ICmpPtr, FCmpF, FCmpD,
+
+    // Casts.  Width is the width of the integer destination, or of the
+    // integer source for [SU]IToFP.
+    ZExtOrTrunc, SExt, PtrToInt, IntToPtr, BitCastPtr,
+    SIToFPF, SIToFPD, UIToFPF, UIToFPD,
+    FToSI, DToSI, FToUI, DToUI, FPExt, FPTrunc,
+
+    // Ops[0] ? Ops[1] : Ops[2].
+    SelectInt, SelectF, SelectD, SelectPtr,
+
+    // Loads and stores of Width-bit integers (whole bytes), floats, doubles
+    // and pointers in host byte order.  Stores take the value in Ops[0] and
+    // the address in Ops[1].
+    LoadInt, LoadF, LoadD, LoadPtr,
+    StoreInt, StoreF, StoreD, StorePtr,
+
+    // Extra is an index into GEPs.
+    GEP,
+
+    // Extra is an index into Edges.  CondBr takes edge Extra if Ops[0] is
+    // true, and edge Extra + 1 otherwise.
+    Br, CondBr,
+
+    // Return Ops[0], or nothing if Width is zero.
+    Ret,
+
+    // Call Ops[0] with the NumArgs = Ops[1] arguments starting at
+    // CallArgs[Extra].
+    Call
+  };
+
+  // An operand is a frame slot if it is non-negative, and constant ~Operand
+  // otherwise.
+  typedef int Operand;
+
+  struct Inst {
+    Opcode Op;
+    uint16_t Width;
+    unsigned Extra;
+    unsigned Dst;
+    Operand Ops[3];
+    Instruction *I;
+  };
+
+  struct Block {
+    BasicBlock *BB;
+    unsigned FirstInst;    // The first instruction after the PHI nodes.
+  };
+
+  // Copy Src to slot Dst; the moves of an edge happen in parallel.
+  struct Move {
+    Operand Src;
+    unsigned Dst;
+  };
+
+  struct Edge {
+    unsigned Dest;         // Destination block number.
+    unsigned FirstMove;
+    unsigned NumMoves;
+  };
+
+  struct GEPIndex {
+    Operand Index;
+    bool Is32Bit;          // Sign-extend a 32-bit index, else 64-bit.
+    int64_t Scale;
+  };
+
+  struct GEPInfo {
+    int64_t ConstantOffset;
+    unsigned FirstIndex;
+    unsigned NumIndices;
+  };
+
+  std::vector<Inst> Insts;
+  std::vector<Block> Blocks;
+  std::vector<Edge> Edges;
+  std::vector<Move> Moves;
+  std::vector<GEPIndex> GEPIndices;
+  std::vector<GEPInfo> GEPs;
+  std::vector<Operand> CallArgs;
+  std::vector<GenericValue> Constants;
+
+  DenseMap<const Value *, unsigned> Slots;
+  DenseMap<const Value *, unsigned> ConstantNumbers;
+  DenseMap<const BasicBlock *, unsigned> BlockNumbers;
+  DenseMap<const Instruction *, unsigned> InstNumbers;
+  unsigned NumSlots;
+
+  InterpFunction() : NumSlots(0) {}
+
+  unsigned getSlot(const Value *V) const {
+    auto I = Slots.find(V);
+    assert(I != Slots.end() && "Value has no slot in this function!");
+    return I->second;
+  }
+};
+
 // ExecutionContext struct - This struct represents one stack frame currently
 // executing.
 //
 struct ExecutionContext {
   Function             *CurFunction;// The currently executing function
+  InterpFunction       *Code;       // Its translation
   BasicBlock           *CurBB;      // The currently executing BB
-  BasicBlock::iterator  CurInst;    // The next instruction to execute
+  unsigned              PC;         // The next instruction in Code to execute
   CallSite             Caller;     // Holds the call that called subframes.
                                    // NULL if main func or debugger invoked fn
-  std::map<Value *, GenericValue> Values; // LLVM values used in this invocation
+  ValuePlaneTy         Values;     // LLVM values used in this invocation,
+                                   // indexed by slot
   std::vector<GenericValue>  VarArgs; // Values passed through an ellipsis
   AllocaHolder Allocas;            // Track memory allocated by alloca
 
-  ExecutionContext() : CurFunction(nullptr), CurBB(nullptr), CurInst(nullptr) {}
+  ExecutionContext()
+      : CurFunction(nullptr), Code(nullptr), CurBB(nullptr), PC(0) {}
 
   ExecutionContext(ExecutionContext &&O)
-      : CurFunction(O.CurFunction), CurBB(O.CurBB), CurInst(O.CurInst),
+      : CurFunction(O.CurFunction), Code(O.Code), CurBB(O.CurBB), PC(O.PC),
         Caller(O.Caller), Values(std::move(O.Values)),
         VarArgs(std::move(O.VarArgs)), Allocas(std::move(O.Allocas)) {}
 
   ExecutionContext &operator=(ExecutionContext &&O) {
     CurFunction = O.CurFunction;
+    Code = O.Code;
     CurBB = O.CurBB;
-    CurInst = O.CurInst;
+    PC = O.PC;
     Caller = O.Caller;
     Values = std::move(O.Values);
     VarArgs = std::move(O.VarArgs);
@@ -106,6 +229,9 @@ class Interpreter : public ExecutionEngine, public InstVisitor<Interpreter> {
   // registered with the atexit() library function.
   std::vector<Function*> AtExitHandlers;
 
+  // The translation of each function that has been called.
+  DenseMap<Function*, std::unique_ptr<InterpFunction>> FunctionCode;
+
 public:
   explicit Interpreter(std::unique_ptr<Module> M);
   ~Interpreter() override;
@@ -139,6 +265,7 @@ public:
   // Place a call on the stack
   void callFunction(Function *F, const std::vector<GenericValue> &ArgVals);
   void run();                // Execute instructions until nothing left to do
+  void executeInst(const InterpFunction::Inst &Inst, ExecutionContext &SF);
 
   // Opcode Implementations
   void visitReturnInst(ReturnInst &I);
@@ -215,6 +342,22 @@ private:  // Helper functions
   //
   void SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF);
 
+  // getFunctionCode - Return the translation of F, translating it if needed.
+  InterpFunction &getFunctionCode(Function *F);
+
+  // translateFunction - (Re)build Code from F.  Slots and constants that were
+  // already assigned keep their numbers.
+  void translateFunction(Function &F, InterpFunction &Code);
+  void translateInstruction(Instruction &I, InterpFunction &Code);
+  InterpFunction::Operand getTranslatedOperand(Value *V, InterpFunction &Code);
+  unsigned addEdge(BasicBlock *From, BasicBlock *To, InterpFunction &Code);
+
+  // retranslateAfterLowering - Translate F again after the intrinsic call
+  // Lowered was replaced by other instructions starting at Resume, and
+  // update the frames that are executing F.
+  void retranslateAfterLowering(Function *F, Instruction *Lowered,
+                                Instruction *Resume);
+
   void *getPointerToFunction(Function *F) override { return (void*)F; }
 
   void initializeExecutionEngine() { }
@@ -39,13 +39,82 @@ GlobalVariable* createImplPointer(PointerType &PT, Module &M,
   return IP;
 }
 
+// Load the implementation pointer of a stub. The load is atomic, so that the
+// pointer can be updated while the stub is running on another thread.
+static LoadInst *loadImplPointer(IRBuilder<> &Builder, Module &M,
+                                 GlobalVariable &ImplPointer) {
+  unsigned PtrAlign =
+    M.getDataLayout().getABITypeAlignment(ImplPointer.getValueType());
+  if (ImplPointer.getAlignment() < PtrAlign)
+    ImplPointer.setAlignment(PtrAlign);
+  LoadInst *ImplAddr = Builder.CreateLoad(&ImplPointer);
+  ImplAddr->setAlignment(PtrAlign);
+  ImplAddr->setAtomic(Acquire);
+  return ImplAddr;
+}
+
 void makeStub(Function &F, GlobalVariable &ImplPointer) {
   assert(F.isDeclaration() && "Can't turn a definition into a stub.");
   assert(F.getParent() && "Function isn't in a module.");
   Module &M = *F.getParent();
   BasicBlock *EntryBlock = BasicBlock::Create(M.getContext(), "entry", &F);
   IRBuilder<> Builder(EntryBlock);
-  LoadInst *ImplAddr = Builder.CreateLoad(&ImplPointer);
+  LoadInst *ImplAddr = loadImplPointer(Builder, M, ImplPointer);
+  std::vector<Value*> CallArgs;
+  for (auto &A : F.args())
+    CallArgs.push_back(&A);
+  CallInst *Call = Builder.CreateCall(ImplAddr, CallArgs);
+  Call->setTailCall();
+  Call->setAttributes(F.getAttributes());
+  if (F.getReturnType()->isVoidTy())
+    Builder.CreateRetVoid();
+  else
+    Builder.CreateRet(Call);
+}
+
+GlobalVariable* createCallCounter(Module &M, const Twine &Name) {
+  Type *CountTy = Type::getInt64Ty(M.getContext());
+  auto Count = new GlobalVariable(M, CountTy, false,
+                                  GlobalValue::ExternalLinkage,
+                                  ConstantInt::get(CountTy, 0), Name);
+  Count->setVisibility(GlobalValue::HiddenVisibility);
+  Count->setAlignment(8);
+  return Count;
+}
+
+void makeCountingStub(Function &F, GlobalVariable &ImplPointer,
+                      GlobalVariable &CallCount, uint64_t Threshold,
+                      Constant *Notify, Constant *NotifyArg) {
+  assert(F.isDeclaration() && "Can't turn a definition into a stub.");
+  assert(F.getParent() && "Function isn't in a module.");
+  assert(Threshold != 0 && "Calls are counted from one.");
+  Module &M = *F.getParent();
+  LLVMContext &Context = M.getContext();
+
+  // The stub writes memory, whatever the attributes of the function it
+  // forwards to.
+  F.removeFnAttr(Attribute::ReadNone);
+  F.removeFnAttr(Attribute::ReadOnly);
+
+  BasicBlock *EntryBlock = BasicBlock::Create(Context, "entry", &F);
+  BasicBlock *NotifyBlock = BasicBlock::Create(Context, "notify", &F);
+  BasicBlock *CallBlock = BasicBlock::Create(Context, "call", &F);
+
+  IRBuilder<> Builder(EntryBlock);
+  Type *CountTy = CallCount.getValueType();
+  Value *PrevCount =
+    Builder.CreateAtomicRMW(AtomicRMWInst::Add, &CallCount,
+                            ConstantInt::get(CountTy, 1), Monotonic);
+  Value *IsHot =
+    Builder.CreateICmpEQ(PrevCount, ConstantInt::get(CountTy, Threshold - 1));
+  Builder.CreateCondBr(IsHot, NotifyBlock, CallBlock);
+
+  Builder.SetInsertPoint(NotifyBlock);
+  Builder.CreateCall(Notify, NotifyArg);
+  Builder.CreateBr(CallBlock);
+
+  Builder.SetInsertPoint(CallBlock);
+  LoadInst *ImplAddr = loadImplPointer(Builder, M, ImplPointer);
   std::vector<Value*> CallArgs;
   for (auto &A : F.args())
     CallArgs.push_back(&A);
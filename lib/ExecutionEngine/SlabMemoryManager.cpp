@@ -0,0 +1,299 @@
+//===- SlabMemoryManager.cpp - Pooled memory manager for the JIT ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the section-based memory manager that allocates from a
+// shared pool of slabs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/SlabMemoryManager.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Process.h"
+#include <algorithm>
+
+namespace llvm {
+
+//===----------------------------------------------------------------------===//
+// SlabPool
+//===----------------------------------------------------------------------===//
+
+SlabMemoryManager::SlabPool::SlabPool(size_t SlabSize)
+    : PageSize(sys::Process::getPageSize()), SpareSlab(0) {
+  this->SlabSize = RoundUpToAlignment(std::max<size_t>(SlabSize, 1), PageSize);
+}
+
+SlabMemoryManager::SlabPool::~SlabPool() {
+  for (auto &Slab : Slabs) {
+    sys::MemoryBlock MB((void*)Slab.first, Slab.second);
+    sys::Memory::releaseMappedMemory(MB);
+  }
+}
+
+sys::MemoryBlock SlabMemoryManager::SlabPool::allocate(size_t Size,
+                                                       std::error_code &EC) {
+  Size = RoundUpToAlignment(std::max<size_t>(Size, 1), PageSize);
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+
+  // Take the lowest free run that is large enough, which keeps the slabs
+  // densely used.
+  auto I = FreeRuns.begin(), E = FreeRuns.end();
+  while (I != E && I->second < Size)
+    ++I;
+
+  if (I == E) {
+    // Map a new slab, near the last one so that code stays within range of
+    // itself.
+    sys::MemoryBlock Near;
+    if (!Slabs.empty())
+      Near = sys::MemoryBlock((void*)Slabs.rbegin()->first,
+                              Slabs.rbegin()->second);
+    sys::MemoryBlock MB =
+      sys::Memory::allocateMappedMemory(std::max(Size, SlabSize), &Near,
+                                        sys::Memory::MF_READ |
+                                          sys::Memory::MF_WRITE,
+                                        EC);
+    if (EC)
+      return sys::MemoryBlock();
+    uintptr_t Base = (uintptr_t)MB.base();
+    Slabs[Base] = MB.size();
+    I = FreeRuns.insert(std::make_pair(Base, MB.size())).first;
+  }
+
+  uintptr_t Start = I->first;
+  size_t RunSize = I->second;
+  FreeRuns.erase(I);
+  if (RunSize > Size)
+    FreeRuns[Start + Size] = RunSize - Size;
+  if (Start == SpareSlab)
+    SpareSlab = 0;
+
+  EC = std::error_code();
+  return sys::MemoryBlock((void*)Start, Size);
+}
+
+void SlabMemoryManager::SlabPool::release(sys::MemoryBlock Block) {
+  uintptr_t Start = (uintptr_t)Block.base();
+  uintptr_t End = Start + Block.size();
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+
+  while (Start < End) {
+    // Find the slab containing Start; adjacent slabs may be contiguous, and
+    // free runs must not span them.
+    auto SlabI = Slabs.upper_bound(Start);
+    assert(SlabI != Slabs.begin() && "Releasing memory not from this pool.");
+    --SlabI;
+    uintptr_t SlabStart = SlabI->first;
+    uintptr_t SlabEnd = SlabStart + SlabI->second;
+    assert(Start < SlabEnd && "Releasing memory not from this pool.");
+    uintptr_t ChunkEnd = std::min(End, SlabEnd);
+
+    // Make the pages writable again before anyone else gets them.
+    sys::MemoryBlock Chunk((void*)Start, ChunkEnd - Start);
+    sys::Memory::protectMappedMemory(Chunk, sys::Memory::MF_READ |
+                                              sys::Memory::MF_WRITE);
+
+    // Insert the chunk, merging it with the free runs around it.
+    uintptr_t RunStart = Start, RunEnd = ChunkEnd;
+    auto Next = FreeRuns.lower_bound(RunStart);
+    if (Next != FreeRuns.end() && Next->first == RunEnd && RunEnd < SlabEnd) {
+      RunEnd += Next->second;
+      Next = FreeRuns.erase(Next);
+    }
+    if (Next != FreeRuns.begin()) {
+      auto Prev = std::prev(Next);
+      if (Prev->first + Prev->second == RunStart && RunStart > SlabStart) {
+        RunStart = Prev->first;
+        FreeRuns.erase(Prev);
+      }
+    }
+
+    if (RunStart == SlabStart && RunEnd == SlabEnd) {
+      // The whole slab is free. Keep one such slab around for the next
+      // allocation, and give the others back to the system.
+      if (!SpareSlab) {
+        SpareSlab = SlabStart;
+        FreeRuns[RunStart] = RunEnd - RunStart;
+      } else {
+        sys::MemoryBlock MB((void*)SlabStart, SlabEnd - SlabStart);
+        sys::Memory::releaseMappedMemory(MB);
+        Slabs.erase(SlabI);
+      }
+    } else
+      FreeRuns[RunStart] = RunEnd - RunStart;
+
+    Start = ChunkEnd;
+  }
+}
+
+size_t SlabMemoryManager::SlabPool::getNumSlabs() const {
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  return Slabs.size();
+}
+
+size_t SlabMemoryManager::SlabPool::getFreeBytes() const {
+  std::lock_guard<std::mutex> Lock(PoolMutex);
+  size_t Free = 0;
+  for (auto &Run : FreeRuns)
+    Free += Run.second;
+  return Free;
+}
+
+//===----------------------------------------------------------------------===//
+// SlabMemoryManager
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct DefaultSlabPool {
+  DefaultSlabPool() : Pool(std::make_shared<SlabMemoryManager::SlabPool>()) {}
+  std::shared_ptr<SlabMemoryManager::SlabPool> Pool;
+};
+}
+
+static ManagedStatic<DefaultSlabPool> DefaultPool;
+
+SlabMemoryManager::SlabMemoryManager(std::shared_ptr<SlabPool> Pool)
+    : Pool(std::move(Pool)) {}
+
+SlabMemoryManager::SlabMemoryManager() : Pool(DefaultPool->Pool) {}
+
+// Sort Runs by address and merge the contiguous ones, so that each maximal
+// range can be handled with a single call.
+static void coalesceRuns(SmallVectorImpl<sys::MemoryBlock> &Runs) {
+  std::sort(Runs.begin(), Runs.end(),
+            [](const sys::MemoryBlock &A, const sys::MemoryBlock &B) {
+              return A.base() < B.base();
+            });
+  SmallVector<sys::MemoryBlock, 8> Merged;
+  for (auto &Run : Runs) {
+    if (!Merged.empty()) {
+      sys::MemoryBlock &Last = Merged.back();
+      if ((uint8_t*)Last.base() + Last.size() == Run.base()) {
+        Last = sys::MemoryBlock(Last.base(), Last.size() + Run.size());
+        continue;
+      }
+    }
+    Merged.push_back(Run);
+  }
+  Runs.swap(Merged);
+}
+
+SlabMemoryManager::~SlabMemoryManager() {
+  SmallVector<sys::MemoryBlock, 8> Runs;
+  Runs.append(CodeMem.Runs.begin(), CodeMem.Runs.end());
+  Runs.append(RWDataMem.Runs.begin(), RWDataMem.Runs.end());
+  Runs.append(RODataMem.Runs.begin(), RODataMem.Runs.end());
+  coalesceRuns(Runs);
+  for (auto &Run : Runs)
+    Pool->release(Run);
+}
+
+uint8_t *SlabMemoryManager::allocateDataSection(uintptr_t Size,
+                                                unsigned Alignment,
+                                                unsigned SectionID,
+                                                StringRef SectionName,
+                                                bool IsReadOnly) {
+  if (IsReadOnly)
+    return allocateSection(RODataMem, Size, Alignment);
+  return allocateSection(RWDataMem, Size, Alignment);
+}
+
+uint8_t *SlabMemoryManager::allocateCodeSection(uintptr_t Size,
+                                                unsigned Alignment,
+                                                unsigned SectionID,
+                                                StringRef SectionName) {
+  return allocateSection(CodeMem, Size, Alignment);
+}
+
+uint8_t *SlabMemoryManager::allocateSection(MemoryGroup &MemGroup,
+                                            uintptr_t Size,
+                                            unsigned Alignment) {
+  if (!Alignment)
+    Alignment = 16;
+
+  assert(!(Alignment & (Alignment - 1)) && "Alignment must be a power of two.");
+
+  // Look in the list of free memory regions and use a block there if one
+  // is available.
+  for (auto &MB : MemGroup.FreeMem) {
+    uintptr_t Addr = RoundUpToAlignment((uintptr_t)MB.base(), Alignment);
+    uintptr_t EndOfBlock = (uintptr_t)MB.base() + MB.size();
+    if (Addr + Size <= EndOfBlock) {
+      MB = sys::MemoryBlock((void*)(Addr + Size), EndOfBlock - Addr - Size);
+      return (uint8_t*)Addr;
+    }
+  }
+
+  // Take a new run from the pool, with room to align the section.
+  std::error_code EC;
+  sys::MemoryBlock Run = Pool->allocate(Size + Alignment, EC);
+  if (EC) {
+    // FIXME: Add error propagation to the interface.
+    return nullptr;
+  }
+  MemGroup.Runs.push_back(Run);
+
+  uintptr_t Addr = RoundUpToAlignment((uintptr_t)Run.base(), Alignment);
+  uintptr_t EndOfBlock = (uintptr_t)Run.base() + Run.size();
+
+  // The run is rounded up to whole pages; keep the rest of it for the next
+  // sections of this group.
+  uintptr_t FreeSize = EndOfBlock - Addr - Size;
+  if (FreeSize > 16)
+    MemGroup.FreeMem.push_back(sys::MemoryBlock((void*)(Addr + Size),
+                                                FreeSize));
+
+  return (uint8_t*)Addr;
+}
+
+// Apply Permissions to the runs of MemGroup that haven't been finalized yet.
+// Returns the affected runs in NewRuns, coalesced.
+static std::error_code
+applyNewRunPermissions(SmallVectorImpl<sys::MemoryBlock> &AllRuns,
+                       unsigned &NumFinalized,
+                       SmallVectorImpl<sys::MemoryBlock> &NewRuns,
+                       unsigned Permissions) {
+  NewRuns.append(AllRuns.begin() + NumFinalized, AllRuns.end());
+  NumFinalized = AllRuns.size();
+  coalesceRuns(NewRuns);
+  for (auto &Run : NewRuns)
+    if (std::error_code EC = sys::Memory::protectMappedMemory(Run, Permissions))
+      return EC;
+  return std::error_code();
+}
+
+bool SlabMemoryManager::finalizeMemory(std::string *ErrMsg) {
+  // Don't allow free memory blocks to be used after setting protection flags.
+  CodeMem.FreeMem.clear();
+  RODataMem.FreeMem.clear();
+
+  SmallVector<sys::MemoryBlock, 8> NewCode;
+  std::error_code EC =
+    applyNewRunPermissions(CodeMem.Runs, CodeMem.NumFinalized, NewCode,
+                           sys::Memory::MF_READ | sys::Memory::MF_EXEC);
+  if (!EC) {
+    SmallVector<sys::MemoryBlock, 8> NewROData;
+    EC = applyNewRunPermissions(RODataMem.Runs, RODataMem.NumFinalized,
+                                NewROData, sys::Memory::MF_READ);
+  }
+  if (EC) {
+    if (ErrMsg)
+      *ErrMsg = EC.message();
+    return true;
+  }
+
+  // Read-write data memory already has the correct permissions.
+
+  for (auto &Run : NewCode)
+    sys::Memory::InvalidateInstructionCache(Run.base(), Run.size());
+
+  return false;
+}
+
+} // namespace llvm
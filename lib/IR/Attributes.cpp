@@ -33,6 +33,7 @@ using namespace llvm;
 
 Attribute Attribute::get(LLVMContext &Context, Attribute::AttrKind Kind,
                          uint64_t Val) {
+  ContextLock Lock(Context);
   LLVMContextImpl *pImpl = Context.pImpl;
   FoldingSetNodeID ID;
   ID.AddInteger(Kind);
@@ -56,6 +57,7 @@ Attribute Attribute::get(LLVMContext &Context, Attribute::AttrKind Kind,
 }
 
 Attribute Attribute::get(LLVMContext &Context, StringRef Kind, StringRef Val) {
+  ContextLock Lock(Context);
   LLVMContextImpl *pImpl = Context.pImpl;
   FoldingSetNodeID ID;
   ID.AddString(Kind);
@@ -458,6 +460,7 @@ AttributeSetNode *AttributeSetNode::get(LLVMContext &C,
     return nullptr;
 
   // Otherwise, build a key to look up the existing attributes.
+  ContextLock Lock(C);
   LLVMContextImpl *pImpl = C.pImpl;
   FoldingSetNodeID ID;
 
@@ -598,6 +601,7 @@ void AttributeSetImpl::dump() const {
 AttributeSet
 AttributeSet::getImpl(LLVMContext &C,
                       ArrayRef<std::pair<unsigned, AttributeSetNode*> > Attrs) {
+  ContextLock Lock(C);
   LLVMContextImpl *pImpl = C.pImpl;
   FoldingSetNodeID ID;
   AttributeSetImpl::Profile(ID, Attrs);
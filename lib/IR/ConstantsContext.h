@@ -15,6 +15,7 @@
 #ifndef LLVM_LIB_IR_CONSTANTSCONTEXT_H
 #define LLVM_LIB_IR_CONSTANTSCONTEXT_H
 
+#include "ContextLock.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/IR/InlineAsm.h"
@@ -576,6 +577,7 @@ private:
 public:
   /// Return the specified constant from the map, creating it if necessary.
   ConstantClass *getOrCreate(TypeClass *Ty, ValType V) {
+    ContextLock Lock(Ty->getContext());
     LookupKey Lookup(Ty, V);
     ConstantClass *Result = nullptr;
 
@@ -599,6 +601,7 @@ public:
 
   /// Remove this constant from the map
   void remove(ConstantClass *CP) {
+    ContextLock Lock(CP->getContext());
     typename MapTy::iterator I = Map.find(CP);
     assert(I != Map.end() && "Constant not found in constant table!");
     assert(I->first == CP && "Didn't find correct element?");
@@ -609,6 +612,7 @@ public:
                                         ConstantClass *CP, Value *From,
                                         Constant *To, unsigned NumUpdated = 0,
                                         unsigned OperandNo = ~0u) {
+    ContextLock Lock(CP->getContext());
     LookupKey Lookup(CP->getType(), ValType(Operands, CP));
     auto I = find(Lookup);
     if (I != Map.end())
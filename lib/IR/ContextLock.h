@@ -0,0 +1,51 @@
+//===- ContextLock.h - Lock the shared state of an LLVMContext --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares ContextLock, which guards the state of an LLVMContext
+// that is shared by all the IR in it while the context is multithreaded.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_IR_CONTEXTLOCK_H
+#define LLVM_LIB_IR_CONTEXTLOCK_H
+
+#include "llvm/IR/Use.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
+
+namespace llvm {
+
+class LLVMContext;
+
+/// Holds the lock of a context for as long as it is in scope, if the context
+/// is multithreaded; otherwise it does nothing. The lock is recursive.
+/// \see LLVMContext::setMultithreaded.
+class ContextLock {
+  sys::SmartMutex<true> *Mutex;
+
+  ContextLock(const ContextLock &) = delete;
+  void operator=(const ContextLock &) = delete;
+
+  void acquire(LLVMContext &C);
+
+public:
+  explicit ContextLock(LLVMContext &C) : Mutex(nullptr) {
+    if (LLVM_UNLIKELY(Use::MultithreadedContexts.load(
+            std::memory_order_relaxed)))
+      acquire(C);
+  }
+  ~ContextLock() {
+    if (Mutex)
+      Mutex->unlock();
+  }
+};
+
+} // end namespace llvm
+
+#endif
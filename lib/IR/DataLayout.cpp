@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/DataLayout.h"
+#include "ContextLock.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
@@ -549,6 +550,9 @@ DataLayout::~DataLayout() {
 }
 
 const StructLayout *DataLayout::getStructLayout(StructType *Ty) const {
+  // The layouts are computed lazily, possibly by passes running on several
+  // functions of the module at once.
+  ContextLock Lock(Ty->getContext());
   if (!LayoutMap)
     LayoutMap = new StructLayoutMap();
 
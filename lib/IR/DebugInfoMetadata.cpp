@@ -44,6 +44,7 @@ DILocation *DILocation::getImpl(LLVMContext &Context, unsigned Line,
                                 bool ShouldCreate) {
   // Fixup column.
   adjustColumn(Column);
+  ContextLock Lock(Context);
 
   assert(Scope && "Expected scope");
   if (Storage == Uniqued) {
@@ -80,6 +81,7 @@ unsigned DILocation::computeNewDiscriminator() const {
   // AddDiscriminators::runOnFunction(), where it doesn't pollute the
   // LLVMContext.
   std::pair<const char *, unsigned> Key(getFilename().data(), getLine());
+  ContextLock Lock(getContext());
   return ++getContext().pImpl->DiscriminatorTable[Key];
 }
 
@@ -172,6 +174,7 @@ GenericDINode *GenericDINode::getImpl(LLVMContext &Context, unsigned Tag,
                                       MDString *Header,
                                       ArrayRef<Metadata *> DwarfOps,
                                       StorageType Storage, bool ShouldCreate) {
+  ContextLock Lock(Context);
   unsigned Hash = 0;
   if (Storage == Uniqued) {
     GenericDINodeInfo::KeyTy Key(Tag, getString(Header), DwarfOps);
@@ -199,6 +202,7 @@ void GenericDINode::recalculateHash() {
 #define UNWRAP_ARGS_IMPL(...) __VA_ARGS__
 #define UNWRAP_ARGS(ARGS) UNWRAP_ARGS_IMPL ARGS
 #define DEFINE_GETIMPL_LOOKUP(CLASS, ARGS)                                     \
+  ContextLock Lock(Context);                                                   \
   do {                                                                         \
     if (Storage == Uniqued) {                                                  \
       if (auto *N = getUniqued(Context.pImpl->CLASS##s,                        \
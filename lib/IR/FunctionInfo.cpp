@@ -0,0 +1,101 @@
+//===-- FunctionInfo.cpp - Function summary index -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the function summary index used by summary-based
+// cross-module optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IntrinsicInst.h"
+using namespace llvm;
+
+/// Return true if the body of a function that uses C cannot be copied into
+/// another module.
+static bool isLocalToModule(const Constant *C,
+                            SmallPtrSetImpl<const Constant *> &Visited) {
+  if (!Visited.insert(C).second)
+    return false;
+  if (const GlobalValue *GV = dyn_cast<GlobalValue>(C))
+    return GV->hasLocalLinkage();
+  if (isa<BlockAddress>(C))
+    return true;
+  for (const Use &Op : C->operands())
+    if (isLocalToModule(cast<Constant>(Op), Visited))
+      return true;
+  return false;
+}
+
+FunctionSummary FunctionSummary::compute(const Function &F) {
+  assert(!F.isDeclaration() && "Cannot summarize a declaration");
+  unsigned InstCount = 0;
+  bool Eligible = !F.hasFnAttribute(Attribute::NoInline);
+  SmallPtrSet<const Constant *, 16> Visited;
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB) {
+      if (isa<DbgInfoIntrinsic>(I))
+        continue;
+      ++InstCount;
+      if (!Eligible)
+        continue;
+      for (const Use &Op : I.operands())
+        if (const Constant *C = dyn_cast<Constant>(Op))
+          if (isLocalToModule(C, Visited)) {
+            Eligible = false;
+            break;
+          }
+    }
+
+  if (Eligible && F.hasPrefixData())
+    Eligible = !isLocalToModule(F.getPrefixData(), Visited);
+  if (Eligible && F.hasPrologueData())
+    Eligible = !isLocalToModule(F.getPrologueData(), Visited);
+
+  uint64_t EntryCount = 0;
+  if (Optional<uint64_t> Count = F.getEntryCount())
+    EntryCount = *Count;
+
+  return FunctionSummary(InstCount, Eligible ? EligibleToImport : 0,
+                         EntryCount);
+}
+
+unsigned FunctionInfoIndex::addModulePath(StringRef Path) {
+  auto Inserted = ModuleIds.insert(std::make_pair(Path, ModulePaths.size()));
+  if (Inserted.second)
+    ModulePaths.push_back(Path);
+  return Inserted.first->second;
+}
+
+void FunctionInfoIndex::addFunction(StringRef Name, unsigned ModuleId,
+                                    FunctionSummary Summary) {
+  assert(ModuleId < ModulePaths.size() && "Unknown module");
+  FunctionInfo Info = {ModuleId, Summary};
+  FunctionMap.insert(std::make_pair(Name, Info));
+}
+
+const FunctionInfoIndex::FunctionInfo *
+FunctionInfoIndex::findFunction(StringRef Name) const {
+  auto I = FunctionMap.find(Name);
+  if (I == FunctionMap.end())
+    return nullptr;
+  return &I->second;
+}
+
+void FunctionInfoIndex::mergeFrom(const FunctionInfoIndex &Other) {
+  // Add the modules first so that their ids follow the order of Other.
+  std::vector<unsigned> IdMap;
+  for (const std::string &Path : Other.ModulePaths)
+    IdMap.push_back(addModulePath(Path));
+  for (const auto &I : Other.FunctionMap)
+    addFunction(I.getKey(), IdMap[I.getValue().ModuleId],
+                I.getValue().Summary);
+}
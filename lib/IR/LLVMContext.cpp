@@ -105,7 +105,10 @@ LLVMContext::LLVMContext() : pImpl(new LLVMContextImpl(*this)) {
          "dereferenceable_or_null kind id drifted");
   (void)DereferenceableOrNullID;
 }
-LLVMContext::~LLVMContext() { delete pImpl; }
+LLVMContext::~LLVMContext() {
+  setMultithreaded(false);
+  delete pImpl;
+}
 
 void LLVMContext::addModule(Module *M) {
   pImpl->OwnedModules.insert(M);
@@ -166,6 +169,27 @@ void LLVMContext::yield() {
     pImpl->YieldCallback(this, pImpl->YieldOpaqueHandle);
 }
 
+void LLVMContext::setMultithreaded(bool Enable) {
+  if (pImpl->Multithreaded == Enable)
+    return;
+  pImpl->Multithreaded = Enable;
+  if (Enable)
+    ++Use::MultithreadedContexts;
+  else
+    --Use::MultithreadedContexts;
+}
+
+bool LLVMContext::isMultithreaded() const {
+  return pImpl->Multithreaded;
+}
+
+void ContextLock::acquire(LLVMContext &C) {
+  if (!C.pImpl->Multithreaded)
+    return;
+  Mutex = &C.pImpl->ContextMutex;
+  Mutex->lock();
+}
+
 void LLVMContext::emitError(const Twine &ErrorStr) {
   diagnose(DiagnosticInfoInlineAsm(ErrorStr));
 }
@@ -200,6 +224,8 @@ static bool isDiagnosticEnabled(const DiagnosticInfo &DI) {
 }
 
 void LLVMContext::diagnose(const DiagnosticInfo &DI) {
+  ContextLock Lock(*this);
+
   // If there is a report handler, use it.
   if (pImpl->DiagnosticHandler) {
     if (!pImpl->RespectDiagnosticFilters || isDiagnosticEnabled(DI))
@@ -242,6 +268,7 @@ void LLVMContext::emitError(unsigned LocCookie, const Twine &ErrorStr) {
 
 /// Return a unique non-zero ID for the specified metadata kind.
 unsigned LLVMContext::getMDKindID(StringRef Name) const {
+  ContextLock Lock(const_cast<LLVMContext &>(*this));
   // If this is new, assign it its ID.
   return pImpl->CustomMDKindNames.insert(
                                      std::make_pair(
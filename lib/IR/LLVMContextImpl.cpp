@@ -38,6 +38,7 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
     Int64Ty(C, 64),
     Int128Ty(C, 128) {
   InlineAsmDiagHandler = nullptr;
+  Multithreaded = false;
   InlineAsmDiagContext = nullptr;
   DiagnosticHandler = nullptr;
   DiagnosticContext = nullptr;
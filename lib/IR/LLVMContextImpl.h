@@ -1015,6 +1015,12 @@ public:
   typedef DenseMap<const Function *, ReturnInst *> PrologueDataMapTy;
   PrologueDataMapTy PrologueDataMap;
 
+  /// Whether the context may be used from several threads at once, and the
+  /// lock that guards the state above while it is.
+  /// \see LLVMContext::setMultithreaded.
+  bool Multithreaded;
+  sys::SmartMutex<true> ContextMutex;
+
   int getOrAddScopeRecordIdxEntry(MDNode *N, int ExistingIdx);
   int getOrAddScopeInlinedAtIdxEntry(MDNode *Scope, MDNode *IA,int ExistingIdx);
 
@@ -13,6 +13,7 @@
 
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LegacyPassManagers.h"
@@ -23,14 +24,20 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeTraceProfiler.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <map>
 using namespace llvm;
 using namespace llvm::legacy;
 
+#define DEBUG_TYPE "ir"
+
 // See PassManagers.h for Pass Manager infrastructure overview.
 
 //===----------------------------------------------------------------------===//
@@ -74,6 +81,11 @@ PrintAfter("print-after",
            llvm::cl::desc("Print IR after specified passes"),
            cl::Hidden);
 
+static cl::opt<unsigned>
+ParallelFunctionPasses("parallel-function-passes", cl::Hidden, cl::init(0),
+    cl::desc("Run function passes on this many functions at once, when all "
+             "the passes support it"));
+
 static cl::opt<bool>
 PrintBeforeAll("print-before-all",
                llvm::cl::desc("Print IR before each pass"),
@@ -580,6 +592,47 @@ AnalysisUsage *PMTopLevelManager::findAnalysisUsage(Pass *P) {
   return AnUsage;
 }
 
+void PMTopLevelManager::addParallelCopies(
+    const DenseMap<Pass *, Pass *> &Copies) {
+  for (const auto &PC : Copies) {
+    Pass *P = PC.first, *Copy = PC.second;
+    findAnalysisUsage(Copy);
+    findAnalysisPassInfo(P->getPassID());
+
+    // The copies of the passes whose last user is P are last used by the copy
+    // of P.
+    DenseMap<Pass *, SmallPtrSet<Pass *, 8> >::iterator DMI =
+      InversedLastUser.find(P);
+    if (DMI == InversedLastUser.end())
+      continue;
+    SmallPtrSet<Pass *, 8> LastUses;
+    for (Pass *LUP : DMI->second) {
+      DenseMap<Pass *, Pass *>::const_iterator CI = Copies.find(LUP);
+      if (CI != Copies.end())
+        LastUses.insert(CI->second);
+    }
+    if (!LastUses.empty())
+      InversedLastUser[Copy] = LastUses;
+  }
+
+  // Looking up an immutable pass fills in the pass info cache.
+  for (ImmutablePass *IP : ImmutablePasses)
+    findAnalysisPassInfo(IP->getPassID());
+}
+
+void PMTopLevelManager::removeParallelCopies(
+    const DenseMap<Pass *, Pass *> &Copies) {
+  for (const auto &PC : Copies) {
+    Pass *Copy = PC.second;
+    InversedLastUser.erase(Copy);
+    DenseMap<Pass *, AnalysisUsage *>::iterator DMI = AnUsageMap.find(Copy);
+    if (DMI != AnUsageMap.end()) {
+      delete DMI->second;
+      AnUsageMap.erase(DMI);
+    }
+  }
+}
+
 /// Schedule pass P for execution. Make sure that passes required by
 /// P are run before P is run. Update analysis info maintained by
 /// the manager. Remove dead passes. This is a recursive function.
@@ -1301,6 +1354,7 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        TimeTraceScope TraceScope(BP->getPassName(), F.getName());
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1499,11 +1553,18 @@ bool FPPassManager::runOnFunction(Function &F) {
   if (F.isDeclaration())
     return false;
 
-  bool Changed = false;
-
   // Collect inherited analysis from Module level pass manager.
   populateInheritedAnalysis(TPM->activeStack);
 
+  return runPasses(F);
+}
+
+bool FPPassManager::runPasses(Function &F) {
+  // Group the passes run on F in the time trace.
+  TimeTraceScope FunctionScope("RunFunctionPasses", F.getName());
+
+  bool Changed = false;
+
   for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
     FunctionPass *FP = getContainedPass(Index);
     bool LocalChanged = false;
@@ -1516,6 +1577,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      TimeTraceScope TraceScope(FP->getPassName(), F.getName());
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1533,9 +1595,178 @@ bool FPPassManager::runOnFunction(Function &F) {
   return Changed;
 }
 
+/// Number the constants used by U, after their own operands, and collect the
+/// values it uses that aren't local to a function.
+static void rankOperands(User *U, DenseMap<const User *, unsigned> &Rank,
+                         SetVector<Value *> &Shared, unsigned &NextRank) {
+  for (Value *Op : U->operands()) {
+    if (!Op || isa<Instruction>(Op) || isa<Argument>(Op) ||
+        isa<BasicBlock>(Op))
+      continue;
+    Shared.insert(Op);
+    Constant *C = dyn_cast<Constant>(Op);
+    if (!C || isa<GlobalValue>(C) || Rank.count(C))
+      continue;
+    rankOperands(C, Rank, Shared, NextRank);
+    Rank[C] = NextRank++;
+  }
+}
+
+/// Give the values shared by all the functions of M (globals, constants and
+/// other uniqued values) a use list order that depends only on the IR: the
+/// order that reading the module back would give, where the last use in the
+/// module comes first.  The functions are processed in a different order each
+/// time they are run in parallel, and later passes must not see the
+/// difference.
+static void canonicalizeSharedUseLists(Module &M) {
+  DenseMap<const User *, unsigned> Rank;
+  SetVector<Value *> Shared;
+  unsigned NextRank = 1;
+
+  auto RankGlobal = [&](GlobalValue &GV) {
+    Shared.insert(&GV);
+    rankOperands(&GV, Rank, Shared, NextRank);
+    Rank[&GV] = NextRank++;
+  };
+  for (GlobalVariable &GV : M.globals())
+    RankGlobal(GV);
+  for (GlobalAlias &GA : M.aliases())
+    RankGlobal(GA);
+  for (Function &F : M)
+    RankGlobal(F);
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB) {
+        rankOperands(&I, Rank, Shared, NextRank);
+        Rank[&I] = NextRank++;
+      }
+
+  // Users that aren't part of the module, such as dead constants, go last.
+  auto getRank = [&](const Use &U) {
+    DenseMap<const User *, unsigned>::const_iterator I =
+      Rank.find(U.getUser());
+    return I == Rank.end() ? 0 : I->second;
+  };
+  for (Value *V : Shared) {
+    if (V->use_empty() || V->hasOneUse())
+      continue;
+    V->sortUseList([&](const Use &L, const Use &R) {
+      unsigned LR = getRank(L), RR = getRank(R);
+      if (LR != RR)
+        return LR > RR;
+      return L.getOperandNo() > R.getOperandNo();
+    });
+  }
+}
+
+bool FPPassManager::runInParallel(Module &M, unsigned NumThreads,
+                                  bool &Changed) {
+  LLVMContext &Context = M.getContext();
+  if (!llvm_is_multithreaded() || PassDebugging >= Executions ||
+      TimePassesIsEnabled || Context.isMultithreaded())
+    return false;
+
+  std::vector<Function *> Functions;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Functions.push_back(&F);
+  NumThreads = std::min<size_t>(NumThreads, Functions.size());
+  if (NumThreads < 2)
+    return false;
+
+  // Each thread runs copies of the passes, in a pass manager of its own that
+  // sees its own copy of the analysis inherited from the module level.
+  populateInheritedAnalysis(TPM->activeStack);
+  std::vector<std::unique_ptr<FPPassManager>> Workers;
+  std::vector<DenseMap<Pass *, Pass *>> Copies(NumThreads);
+  std::vector<DenseMap<AnalysisID, Pass *>> Inherited(NumThreads * PMT_Last);
+  for (unsigned T = 0; T != NumThreads; ++T) {
+    FPPassManager *W = new FPPassManager();
+    Workers.emplace_back(W);
+    W->setTopLevelManager(TPM);
+    W->setDepth(getDepth());
+    for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
+      FunctionPass *FP = getContainedPass(Index);
+      FunctionPass *Copy = FP->createParallelCopy();
+      if (!Copy)
+        return false;
+      W->add(Copy, false);
+      Copies[T][FP] = Copy;
+    }
+    for (unsigned Index = 0; Index != PMT_Last; ++Index) {
+      if (!InheritedAnalysis[Index])
+        continue;
+      Inherited[T * PMT_Last + Index] = *InheritedAnalysis[Index];
+      W->InheritedAnalysis[Index] = &Inherited[T * PMT_Last + Index];
+    }
+  }
+  for (const DenseMap<Pass *, Pass *> &C : Copies)
+    TPM->addParallelCopies(C);
+
+  // Function declarations added by the passes are appended to the module.
+  Function *LastFunction = M.empty() ? nullptr : &M.getFunctionList().back();
+
+  DEBUG(dbgs() << "Running function passes on " << Functions.size()
+               << " functions with " << NumThreads << " threads\n");
+
+  std::atomic<unsigned> NextFunction(0);
+  std::atomic<bool> AnyChanged(false);
+  Context.setMultithreaded(true);
+  {
+    ThreadPool Pool(NumThreads);
+    for (std::unique_ptr<FPPassManager> &W : Workers) {
+      FPPassManager *WP = W.get();
+      Pool.async([&, WP] {
+        bool LocalChanged = false;
+        for (unsigned I = NextFunction++; I < Functions.size();
+             I = NextFunction++)
+          LocalChanged |= WP->runPasses(*Functions[I]);
+        if (LocalChanged)
+          AnyChanged = true;
+      });
+    }
+    Pool.wait();
+  }
+  Context.setMultithreaded(false);
+
+  for (const DenseMap<Pass *, Pass *> &C : Copies)
+    TPM->removeParallelCopies(C);
+  Workers.clear();
+
+  // Drop the inherited analysis that the passes didn't preserve, as running
+  // them sequentially would have.
+  populateInheritedAnalysis(TPM->activeStack);
+  for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index)
+    removeNotPreservedAnalysis(getContainedPass(Index));
+
+  // Put the new declarations in an order that doesn't depend on which thread
+  // added them first.
+  Module::iterator NewBegin =
+    LastFunction ? std::next(Module::iterator(LastFunction)) : M.begin();
+  std::vector<Function *> NewDecls;
+  for (Module::iterator I = NewBegin, E = M.end(); I != E; ++I)
+    NewDecls.push_back(&*I);
+  std::stable_sort(NewDecls.begin(), NewDecls.end(),
+                   [](const Function *L, const Function *R) {
+                     return L->getName() < R->getName();
+                   });
+  for (Function *F : NewDecls)
+    M.getFunctionList().splice(M.end(), M.getFunctionList(),
+                               Module::iterator(F));
+
+  canonicalizeSharedUseLists(M);
+
+  Changed = AnyChanged;
+  return true;
+}
+
 bool FPPassManager::runOnModule(Module &M) {
   bool Changed = false;
 
+  if (ParallelFunctionPasses > 1 &&
+      runInParallel(M, ParallelFunctionPasses, Changed))
+    return Changed;
+
   for (Function &F : M)
     Changed |= runOnFunction(F);
 
@@ -1592,6 +1823,8 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      TimeTraceScope TraceScope(MP->getPassName(),
+                                M.getModuleIdentifier());
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -35,6 +35,7 @@ MetadataAsValue::MetadataAsValue(Type *Ty, Metadata *MD)
 }
 
 MetadataAsValue::~MetadataAsValue() {
+  ContextLock Lock(getContext());
   getType()->getContext().pImpl->MetadataAsValues.erase(MD);
   untrack();
 }
@@ -73,6 +74,7 @@ static Metadata *canonicalizeMetadataForValue(LLVMContext &Context,
 }
 
 MetadataAsValue *MetadataAsValue::get(LLVMContext &Context, Metadata *MD) {
+  ContextLock Lock(Context);
   MD = canonicalizeMetadataForValue(Context, MD);
   auto *&Entry = Context.pImpl->MetadataAsValues[MD];
   if (!Entry)
@@ -82,12 +84,14 @@ MetadataAsValue *MetadataAsValue::get(LLVMContext &Context, Metadata *MD) {
 
 MetadataAsValue *MetadataAsValue::getIfExists(LLVMContext &Context,
                                               Metadata *MD) {
+  ContextLock Lock(Context);
   MD = canonicalizeMetadataForValue(Context, MD);
   auto &Store = Context.pImpl->MetadataAsValues;
   return Store.lookup(MD);
 }
 
 void MetadataAsValue::handleChangedMetadata(Metadata *MD) {
+  ContextLock Lock(getContext());
   LLVMContext &Context = getContext();
   MD = canonicalizeMetadataForValue(Context, MD);
   auto &Store = Context.pImpl->MetadataAsValues;
@@ -121,6 +125,7 @@ void MetadataAsValue::untrack() {
 }
 
 void ReplaceableMetadataImpl::addRef(void *Ref, OwnerTy Owner) {
+  ContextLock Lock(Context);
   bool WasInserted =
       UseMap.insert(std::make_pair(Ref, std::make_pair(Owner, NextIndex)))
           .second;
@@ -132,6 +137,7 @@ void ReplaceableMetadataImpl::addRef(void *Ref, OwnerTy Owner) {
 }
 
 void ReplaceableMetadataImpl::dropRef(void *Ref) {
+  ContextLock Lock(Context);
   bool WasErased = UseMap.erase(Ref);
   (void)WasErased;
   assert(WasErased && "Expected to drop a reference");
@@ -139,6 +145,7 @@ void ReplaceableMetadataImpl::dropRef(void *Ref) {
 
 void ReplaceableMetadataImpl::moveRef(void *Ref, void *New,
                                       const Metadata &MD) {
+  ContextLock Lock(Context);
   auto I = UseMap.find(Ref);
   assert(I != UseMap.end() && "Expected to move a reference");
   auto OwnerAndIndex = I->second;
@@ -158,6 +165,7 @@ void ReplaceableMetadataImpl::moveRef(void *Ref, void *New,
 void ReplaceableMetadataImpl::replaceAllUsesWith(Metadata *MD) {
   assert(!(MD && isa<MDNode>(MD) && cast<MDNode>(MD)->isTemporary()) &&
          "Expected non-temp node");
+  ContextLock Lock(Context);
 
   if (UseMap.empty())
     return;
@@ -207,6 +215,7 @@ void ReplaceableMetadataImpl::replaceAllUsesWith(Metadata *MD) {
 }
 
 void ReplaceableMetadataImpl::resolveAllUses(bool ResolveUsers) {
+  ContextLock Lock(Context);
   if (UseMap.empty())
     return;
 
@@ -252,6 +261,7 @@ ValueAsMetadata *ValueAsMetadata::get(Value *V) {
   assert(V && "Unexpected null Value");
 
   auto &Context = V->getContext();
+  ContextLock Lock(Context);
   auto *&Entry = Context.pImpl->ValuesAsMetadata[V];
   if (!Entry) {
     assert((isa<Constant>(V) || isa<Argument>(V) || isa<Instruction>(V)) &&
@@ -269,6 +279,7 @@ ValueAsMetadata *ValueAsMetadata::get(Value *V) {
 }
 
 ValueAsMetadata *ValueAsMetadata::getIfExists(Value *V) {
+  ContextLock Lock(V->getContext());
   assert(V && "Unexpected null Value");
   return V->getContext().pImpl->ValuesAsMetadata.lookup(V);
 }
@@ -276,6 +287,7 @@ ValueAsMetadata *ValueAsMetadata::getIfExists(Value *V) {
 void ValueAsMetadata::handleDeletion(Value *V) {
   assert(V && "Expected valid value");
 
+  ContextLock Lock(V->getContext());
   auto &Store = V->getType()->getContext().pImpl->ValuesAsMetadata;
   auto I = Store.find(V);
   if (I == Store.end())
@@ -299,6 +311,7 @@ void ValueAsMetadata::handleRAUW(Value *From, Value *To) {
   assert(From->getType() == To->getType() && "Unexpected type change");
 
   LLVMContext &Context = From->getType()->getContext();
+  ContextLock Lock(Context);
   auto &Store = Context.pImpl->ValuesAsMetadata;
   auto I = Store.find(From);
   if (I == Store.end()) {
@@ -358,6 +371,7 @@ void ValueAsMetadata::handleRAUW(Value *From, Value *To) {
 //
 
 MDString *MDString::get(LLVMContext &Context, StringRef Str) {
+  ContextLock Lock(Context);
   auto &Store = Context.pImpl->MDStringCache;
   auto I = Store.find(Str);
   if (I != Store.end())
@@ -569,6 +583,7 @@ void MDNode::dropAllReferences() {
 }
 
 void MDNode::handleChangedOperand(void *Ref, Metadata *New) {
+  ContextLock Lock(getContext());
   unsigned Op = static_cast<MDOperand *>(Ref) - op_begin();
   assert(Op < getNumOperands() && "Expected valid operand");
 
@@ -651,6 +666,7 @@ template <class NodeTy> struct MDNode::HasCachedHash {
 };
 
 MDNode *MDNode::uniquify() {
+  ContextLock Lock(getContext());
   assert(!hasSelfReference(this) && "Cannot uniquify a self-referencing node");
 
   // Try to insert into uniquing store.
@@ -670,6 +686,7 @@ MDNode *MDNode::uniquify() {
 }
 
 void MDNode::eraseFromStore() {
+  ContextLock Lock(getContext());
   switch (getMetadataID()) {
   default:
     llvm_unreachable("Invalid subclass of MDNode");
@@ -683,6 +700,7 @@ void MDNode::eraseFromStore() {
 
 MDTuple *MDTuple::getImpl(LLVMContext &Context, ArrayRef<Metadata *> MDs,
                           StorageType Storage, bool ShouldCreate) {
+  ContextLock Lock(Context);
   unsigned Hash = 0;
   if (Storage == Uniqued) {
     MDTupleInfo::KeyTy Key(MDs);
@@ -706,6 +724,7 @@ void MDNode::deleteTemporary(MDNode *N) {
 }
 
 void MDNode::storeDistinctInContext() {
+  ContextLock Lock(getContext());
   assert(isResolved() && "Expected resolved nodes");
   Storage = Distinct;
 
@@ -1041,6 +1060,7 @@ void Instruction::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
   if (!hasMetadataHashEntry())
     return; // Nothing to remove!
 
+  ContextLock Lock(getContext());
   auto &InstructionMetadata = getContext().pImpl->InstructionMetadata;
 
   if (KnownSet.empty()) {
@@ -1066,6 +1086,7 @@ void Instruction::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
 /// node.  This updates/replaces metadata if already present, or removes it if
 /// Node is null.
 void Instruction::setMetadata(unsigned KindID, MDNode *Node) {
+  ContextLock Lock(getContext());
   if (!Node && !hasMetadata())
     return;
 
@@ -1117,6 +1138,7 @@ MDNode *Instruction::getMetadataImpl(unsigned KindID) const {
 
   if (!hasMetadataHashEntry())
     return nullptr;
+  ContextLock Lock(getContext());
   auto &Info = getContext().pImpl->InstructionMetadata[this];
   assert(!Info.empty() && "bit out of sync with hash table");
 
@@ -1134,6 +1156,7 @@ void Instruction::getAllMetadataImpl(
     if (!hasMetadataHashEntry()) return;
   }
 
+  ContextLock Lock(getContext());
   assert(hasMetadataHashEntry() &&
          getContext().pImpl->InstructionMetadata.count(this) &&
          "Shouldn't have called this");
@@ -1144,6 +1167,7 @@ void Instruction::getAllMetadataImpl(
 
 void Instruction::getAllMetadataOtherThanDebugLocImpl(
     SmallVectorImpl<std::pair<unsigned, MDNode *>> &Result) const {
+  ContextLock Lock(getContext());
   Result.clear();
   assert(hasMetadataHashEntry() &&
          getContext().pImpl->InstructionMetadata.count(this) &&
@@ -1156,12 +1180,14 @@ void Instruction::getAllMetadataOtherThanDebugLocImpl(
 /// clearMetadataHashEntries - Clear all hashtable-based metadata from
 /// this instruction.
 void Instruction::clearMetadataHashEntries() {
+  ContextLock Lock(getContext());
   assert(hasMetadataHashEntry() && "Caller should check");
   getContext().pImpl->InstructionMetadata.erase(this);
   setHasMetadataHashEntry(false);
 }
 
 MDNode *Function::getMetadata(unsigned KindID) const {
+  ContextLock Lock(getContext());
   if (!hasMetadata())
     return nullptr;
   return getContext().pImpl->FunctionMetadata[this].lookup(KindID);
@@ -1174,6 +1200,7 @@ MDNode *Function::getMetadata(StringRef Kind) const {
 }
 
 void Function::setMetadata(unsigned KindID, MDNode *MD) {
+  ContextLock Lock(getContext());
   if (MD) {
     if (!hasMetadata())
       setHasMetadataHashEntry(true);
@@ -1200,6 +1227,7 @@ void Function::setMetadata(StringRef Kind, MDNode *MD) {
 
 void Function::getAllMetadata(
     SmallVectorImpl<std::pair<unsigned, MDNode *>> &MDs) const {
+  ContextLock Lock(getContext());
   MDs.clear();
 
   if (!hasMetadata())
@@ -1209,6 +1237,7 @@ void Function::getAllMetadata(
 }
 
 void Function::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
+  ContextLock Lock(getContext());
   if (!hasMetadata())
     return;
   if (KnownIDs.empty()) {
@@ -1231,6 +1260,7 @@ void Function::dropUnknownMetadata(ArrayRef<unsigned> KnownIDs) {
 }
 
 void Function::clearMetadata() {
+  ContextLock Lock(getContext());
   if (!hasMetadata())
     return;
   getContext().pImpl->FunctionMetadata.erase(this);
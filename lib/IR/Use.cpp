@@ -8,16 +8,63 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/Use.h"
+#include "ContextLock.h"
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instruction.h"
 #include "llvm/IR/User.h"
 #include "llvm/IR/Value.h"
 #include <new>
 
 namespace llvm {
 
+std::atomic<unsigned> Use::MultithreadedContexts(0);
+
+/// Whether the use list of V may be changed by threads working on different
+/// functions. Blocks whose address is taken are used by constants.
+static bool isShared(const Value *V) {
+  if (isa<Instruction>(V) || isa<Argument>(V))
+    return false;
+  if (auto *BB = dyn_cast<BasicBlock>(V))
+    return BB->hasAddressTaken();
+  return true;
+}
+
+void Use::setLocked(Value *V) {
+  if (Val) {
+    if (isShared(Val)) {
+      ContextLock Lock(Val->getContext());
+      removeFromList();
+    } else {
+      removeFromList();
+    }
+  }
+  Val = V;
+  if (V) {
+    if (isShared(V)) {
+      ContextLock Lock(V->getContext());
+      V->addUse(*this);
+    } else {
+      V->addUse(*this);
+    }
+  }
+}
+
+void Use::removeFromListLocked() {
+  if (isShared(Val)) {
+    ContextLock Lock(Val->getContext());
+    removeFromList();
+  } else {
+    removeFromList();
+  }
+}
+
 void Use::swap(Use &RHS) {
   if (Val == RHS.Val)
     return;
 
+  ContextLock Lock((Val ? Val : RHS.Val)->getContext());
+
   if (Val)
     removeFromList();
 
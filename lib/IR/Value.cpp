@@ -162,6 +162,7 @@ ValueName *Value::getValueName() const {
   if (!HasName) return nullptr;
 
   LLVMContext &Ctx = getContext();
+  ContextLock Lock(Ctx);
   auto I = Ctx.pImpl->ValueNames.find(this);
   assert(I != Ctx.pImpl->ValueNames.end() &&
          "No name entry found!");
@@ -171,6 +172,7 @@ ValueName *Value::getValueName() const {
 
 void Value::setValueName(ValueName *VN) {
   LLVMContext &Ctx = getContext();
+  ContextLock Lock(Ctx);
 
   assert(HasName == Ctx.pImpl->ValueNames.count(this) &&
          "HasName bit out of sync!");
@@ -544,6 +546,7 @@ void Value::reverseUseList() {
 
 void ValueHandleBase::AddToExistingUseList(ValueHandleBase **List) {
   assert(List && "Handle list is null?");
+  ContextLock Lock(V->getContext());
 
   // Splice ourselves into the list.
   Next = *List;
@@ -557,6 +560,7 @@ void ValueHandleBase::AddToExistingUseList(ValueHandleBase **List) {
 
 void ValueHandleBase::AddToExistingUseListAfter(ValueHandleBase *List) {
   assert(List && "Must insert after existing node");
+  ContextLock Lock(V->getContext());
 
   Next = List->Next;
   setPrevPtr(&List->Next);
@@ -565,9 +569,15 @@ void ValueHandleBase::AddToExistingUseListAfter(ValueHandleBase *List) {
     Next->setPrevPtr(&Next);
 }
 
+void ValueHandleBase::AddToExistingUseListBefore(const ValueHandleBase &Node) {
+  ContextLock Lock(V->getContext());
+  AddToExistingUseList(Node.getPrevPtr());
+}
+
 void ValueHandleBase::AddToUseList() {
   assert(V && "Null pointer doesn't have a use list!");
 
+  ContextLock Lock(V->getContext());
   LLVMContextImpl *pImpl = V->getContext().pImpl;
 
   if (V->HasValueHandle) {
@@ -611,6 +621,7 @@ void ValueHandleBase::AddToUseList() {
 void ValueHandleBase::RemoveFromUseList() {
   assert(V && V->HasValueHandle &&
          "Pointer doesn't have a use list!");
+  ContextLock Lock(V->getContext());
 
   // Unlink this from its use list.
   ValueHandleBase **PrevPtr = getPrevPtr();
@@ -640,6 +651,7 @@ void ValueHandleBase::ValueIsDeleted(Value *V) {
 
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
+  ContextLock Lock(V->getContext());
   LLVMContextImpl *pImpl = V->getContext().pImpl;
   ValueHandleBase *Entry = pImpl->ValueHandles[V];
   assert(Entry && "Value bit set but no entries exist");
@@ -700,6 +712,7 @@ void ValueHandleBase::ValueIsRAUWd(Value *Old, Value *New) {
 
   // Get the linked list base, which is guaranteed to exist since the
   // HasValueHandle flag is set.
+  ContextLock Lock(Old->getContext());
   LLVMContextImpl *pImpl = Old->getContext().pImpl;
   ValueHandleBase *Entry = pImpl->ValueHandles[Old];
 
@@ -73,6 +73,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdarg>
@@ -280,6 +281,20 @@ public:
     return !Broken;
   }
 
+  /// \brief Take over the state that verifying functions with \p Other left
+  /// for the verification of the module.
+  void takeFunctionState(Verifier &Other) {
+    UnresolvedTypeRefs.insert(Other.UnresolvedTypeRefs.begin(),
+                              Other.UnresolvedTypeRefs.end());
+    Other.UnresolvedTypeRefs.clear();
+    for (auto &Counts : Other.FrameEscapeInfo) {
+      auto &Entry = FrameEscapeInfo[Counts.first];
+      Entry.first = std::max(Entry.first, Counts.second.first);
+      Entry.second = std::max(Entry.second, Counts.second.second);
+    }
+    Other.FrameEscapeInfo.clear();
+  }
+
 private:
   // Verification methods...
   void visitGlobalValue(const GlobalValue &GV);
@@ -3676,21 +3691,39 @@ struct VerifierLegacyPass : public FunctionPass {
   Verifier V;
   bool FatalErrors;
 
-  VerifierLegacyPass() : FunctionPass(ID), V(dbgs()), FatalErrors(true) {
+  /// The pass that this one is a parallel copy of, which verifies the module
+  /// with the state left by verifying the functions.
+  VerifierLegacyPass *Original;
+  sys::Mutex StateLock;
+
+  VerifierLegacyPass()
+      : FunctionPass(ID), V(dbgs()), FatalErrors(true), Original(nullptr) {
     initializeVerifierLegacyPassPass(*PassRegistry::getPassRegistry());
   }
   explicit VerifierLegacyPass(bool FatalErrors)
-      : FunctionPass(ID), V(dbgs()), FatalErrors(FatalErrors) {
+      : FunctionPass(ID), V(dbgs()), FatalErrors(FatalErrors),
+        Original(nullptr) {
     initializeVerifierLegacyPassPass(*PassRegistry::getPassRegistry());
   }
 
   bool runOnFunction(Function &F) override {
-    if (!V.verify(F) && FatalErrors)
+    bool Broken = !V.verify(F);
+    if (Original) {
+      sys::ScopedLock Lock(Original->StateLock);
+      Original->V.takeFunctionState(V);
+    }
+    if (Broken && FatalErrors)
       report_fatal_error("Broken function found, compilation aborted!");
 
     return false;
   }
 
+  FunctionPass *createParallelCopy() const override {
+    auto *Copy = new VerifierLegacyPass(FatalErrors);
+    Copy->Original = const_cast<VerifierLegacyPass *>(this);
+    return Copy;
+  }
+
   bool doFinalization(Module &M) override {
     if (!V.verify(M) && FatalErrors)
       report_fatal_error("Broken module found, compilation aborted!");
@@ -18,6 +18,8 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/CodeGenCache.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RuntimeLibcalls.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
@@ -52,6 +54,7 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/ObjCARC.h"
+#include <list>
 #include <system_error>
 using namespace llvm;
 
@@ -231,7 +234,8 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   // generate object file
   tool_output_file objFile(Filename.c_str(), FD);
 
-  bool genResult = compileOptimized(objFile.os(), errMsg);
+  raw_pwrite_stream *OS = &objFile.os();
+  bool genResult = compileOptimized(OS, errMsg);
   objFile.os().close();
   if (objFile.os().has_error()) {
     objFile.os().clear_error();
@@ -250,6 +254,49 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   return true;
 }
 
+bool LTOCodeGenerator::compileOptimizedToFiles(std::vector<const char *> &Names,
+                                               std::string &errMsg) {
+  NativeObjectPaths.clear();
+  std::list<tool_output_file> ObjFiles;
+  std::vector<raw_pwrite_stream *> OSs;
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    // make unique temp .o file to put generated object file
+    SmallString<128> Filename;
+    int FD;
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      return false;
+    }
+    ObjFiles.emplace_back(Filename.c_str(), FD);
+    OSs.push_back(&ObjFiles.back().os());
+    NativeObjectPaths.push_back(Filename.c_str());
+  }
+
+  // generate object files
+  bool genResult = compileOptimized(OSs, errMsg);
+  for (tool_output_file &ObjFile : ObjFiles) {
+    ObjFile.os().close();
+    if (ObjFile.os().has_error()) {
+      ObjFile.os().clear_error();
+      genResult = false;
+    }
+  }
+  // On failure the tool_output_files remove the temporaries for us.
+  if (!genResult) {
+    NativeObjectPaths.clear();
+    return false;
+  }
+
+  Names.clear();
+  for (tool_output_file &ObjFile : ObjFiles)
+    ObjFile.keep();
+  for (const std::string &Path : NativeObjectPaths)
+    Names.push_back(Path.c_str());
+  return true;
+}
+
 std::unique_ptr<MemoryBuffer>
 LTOCodeGenerator::compileOptimized(std::string &errMsg) {
   const char *name;
@@ -546,20 +593,83 @@ bool LTOCodeGenerator::optimize(bool DisableInline,
   return true;
 }
 
-bool LTOCodeGenerator::compileOptimized(raw_pwrite_stream &out,
+bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_pwrite_stream *> Out,
                                         std::string &errMsg) {
   if (!this->determineTarget(errMsg))
     return false;
 
+  if (CacheDir.empty())
+    return generateObjects(Out, errMsg);
+
+  // The objects depend on the merged module, the target machine, the codegen
+  // options and the number of partitions. Each partition has its own entry.
+  std::vector<std::string> Args(CodegenOptions.begin(), CodegenOptions.end());
+  Args.push_back(utostr(Out.size()));
+  std::string Key = CodeGenCache::computeKey(
+      *IRLinker.getModule(), *TargetMach, TargetMachine::CGFT_ObjectFile, Args);
+  CodeGenCache Cache(CacheDir);
+
+  std::vector<std::unique_ptr<MemoryBuffer>> Cached;
+  for (unsigned I = 0, E = Out.size(); I != E; ++I) {
+    std::unique_ptr<MemoryBuffer> Buffer = Cache.lookup(Key + "-" + utostr(I));
+    if (!Buffer)
+      break;
+    Cached.push_back(std::move(Buffer));
+  }
+  if (Cached.size() == Out.size()) {
+    for (unsigned I = 0, E = Out.size(); I != E; ++I)
+      *Out[I] << Cached[I]->getBuffer();
+    return true;
+  }
+
+  // Generate the objects into memory, then add them to the cache and copy
+  // them to the real outputs.
+  std::vector<SmallVector<char, 0>> Buffers(Out.size());
+  std::vector<std::unique_ptr<raw_svector_ostream>> BufferOSs;
+  std::vector<raw_pwrite_stream *> BufferOSPtrs;
+  for (SmallVector<char, 0> &Buffer : Buffers) {
+    BufferOSs.push_back(llvm::make_unique<raw_svector_ostream>(Buffer));
+    BufferOSPtrs.push_back(BufferOSs.back().get());
+  }
+  if (!generateObjects(BufferOSPtrs, errMsg))
+    return false;
+
+  for (unsigned I = 0, E = Out.size(); I != E; ++I) {
+    BufferOSs[I]->flush();
+    StringRef Object(Buffers[I].data(), Buffers[I].size());
+    Cache.store(Key + "-" + utostr(I), Object);
+    *Out[I] << Object;
+  }
+  Cache.prune(CacheMaxSize);
+  return true;
+}
+
+bool LTOCodeGenerator::generateObjects(ArrayRef<raw_pwrite_stream *> Out,
+                                       std::string &errMsg) {
   Module *mergedModule = IRLinker.getModule();
 
+  if (Out.size() > 1) {
+    // If the bitcode files contain ARC code and were compiled with
+    // optimization, the ObjCARCContractPass must be run, so do it
+    // unconditionally here, before the module is split.
+    legacy::PassManager preCodeGenPasses;
+    preCodeGenPasses.add(createObjCARCContractPass());
+    preCodeGenPasses.run(*mergedModule);
+
+    splitCodeGen(*mergedModule, Out, TargetMach->getTargetCPU(),
+                 TargetMach->getTargetFeatureString(), TargetMach->Options,
+                 TargetMach->getRelocationModel(), TargetMach->getCodeModel(),
+                 TargetMach->getOptLevel(), TargetMachine::CGFT_ObjectFile);
+    return true;
+  }
+
   legacy::PassManager codeGenPasses;
 
   // If the bitcode files contain ARC code and were compiled with optimization,
   // the ObjCARCContractPass must be run, so do it unconditionally here.
   codeGenPasses.add(createObjCARCContractPass());
 
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, out,
+  if (TargetMach->addPassesToEmitFile(codeGenPasses, *Out[0],
                                       TargetMachine::CGFT_ObjectFile)) {
     errMsg = "target file type not supported";
     return false;
@@ -14,6 +14,7 @@
 
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/IR/Constants.h"
@@ -85,6 +86,9 @@ bool LTOModule::isBitcodeForTarget(MemoryBuffer *Buffer,
       IRObjectFile::findBitcodeInMemBuffer(Buffer->getMemBufferRef());
   if (!BCOrErr)
     return false;
+  // The symbol table records the triple, which saves creating a context.
+  if (ErrorOr<BitcodeSymbolTable> Symtab = getBitcodeSymbolTable(*BCOrErr))
+    return Symtab->getTargetTriple().startswith(TriplePrefix);
   LLVMContext Context;
   std::string Triple = getBitcodeTargetTriple(*BCOrErr, Context);
   return StringRef(Triple).startswith(TriplePrefix);
@@ -186,24 +190,30 @@ static Module *parseBitcodeFileImpl(MemoryBufferRef Buffer,
   return *M;
 }
 
-LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
-                                    TargetOptions options, std::string &errMsg,
-                                    LLVMContext *Context) {
-  std::unique_ptr<LLVMContext> OwnedContext;
-  if (!Context) {
-    OwnedContext = llvm::make_unique<LLVMContext>();
-    Context = OwnedContext.get();
+/// Whether a symbol-only LTOModule can be built from the symbol table alone.
+/// The module is still needed for its linker options, for the ObjC symbols
+/// that are made up from the data in "__OBJC," sections, for the global prefix
+/// of the target if it has no data layout of its own, and to tell whether a
+/// linkonce_odr symbol that is not unnamed_addr can be hidden, which depends
+/// on how the module uses it (see canBeOmittedFromSymbolTable).
+static bool canUseSymbolTable(const BitcodeSymbolTable &Symtab) {
+  if (Symtab.getModuleFlags())
+    return false;
+  for (unsigned I = 0, E = Symtab.getNumSymbols(); I != E; ++I) {
+    uint32_t Flags = Symtab.getSymbolFlags(I);
+    if ((Flags & BitcodeSymbolTable::SF_LinkOnceODR) &&
+        !(Flags & (BitcodeSymbolTable::SF_UnnamedAddr |
+                   BitcodeSymbolTable::SF_Alias)) &&
+        (Flags & (BitcodeSymbolTable::SF_Executable |
+                  BitcodeSymbolTable::SF_Constant)))
+      return false;
   }
+  return true;
+}
 
-  // If we own a context, we know this is being used only for symbol
-  // extraction, not linking.  Be lazy in that case.
-  std::unique_ptr<Module> M(parseBitcodeFileImpl(
-      Buffer, *Context,
-      /* ShouldBeLazy */ static_cast<bool>(OwnedContext), errMsg));
-  if (!M)
-    return nullptr;
-
-  std::string TripleStr = M->getTargetTriple();
+TargetMachine *LTOModule::makeTargetMachine(std::string TripleStr,
+                                            TargetOptions options,
+                                            std::string &errMsg) {
   if (TripleStr.empty())
     TripleStr = sys::getDefaultTargetTriple();
   llvm::Triple Triple(TripleStr);
@@ -213,7 +223,6 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
   if (!march)
     return nullptr;
 
-  // construct LTOModule, hand over ownership of module and target
   SubtargetFeatures Features;
   Features.getDefaultSubtargetFeatures(Triple);
   std::string FeatureStr = Features.getString();
@@ -228,8 +237,53 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
       CPU = "cyclone";
   }
 
-  TargetMachine *target = march->createTargetMachine(TripleStr, CPU, FeatureStr,
-                                                     options);
+  return march->createTargetMachine(TripleStr, CPU, FeatureStr, options);
+}
+
+LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
+                                    TargetOptions options, std::string &errMsg,
+                                    LLVMContext *Context) {
+  // Without a context, this is being used only for symbol extraction, not
+  // linking. The symbol table of the bitcode has the symbols then, unless the
+  // module is needed to tell some of their attributes.
+  if (!Context) {
+    ErrorOr<MemoryBufferRef> BCOrErr =
+        IRObjectFile::findBitcodeInMemBuffer(Buffer);
+    ErrorOr<BitcodeSymbolTable> Symtab =
+        make_error_code(BitcodeError::SymbolTableNotFound);
+    if (BCOrErr)
+      Symtab = getBitcodeSymbolTable(*BCOrErr);
+    if (Symtab && canUseSymbolTable(*Symtab)) {
+      TargetMachine *target =
+          makeTargetMachine(Symtab->getTargetTriple(), options, errMsg);
+      if (!target)
+        return nullptr;
+      LTOModule *Ret = new LTOModule(nullptr, target);
+      Ret->TargetTriple = Symtab->getTargetTriple();
+      Ret->parseSymbolTable(*Symtab);
+      return Ret;
+    }
+  }
+
+  std::unique_ptr<LLVMContext> OwnedContext;
+  if (!Context) {
+    OwnedContext = llvm::make_unique<LLVMContext>();
+    Context = OwnedContext.get();
+  }
+
+  // If we own a context, we know this is being used only for symbol
+  // extraction, not linking.  Be lazy in that case.
+  std::unique_ptr<Module> M(parseBitcodeFileImpl(
+      Buffer, *Context,
+      /* ShouldBeLazy */ static_cast<bool>(OwnedContext), errMsg));
+  if (!M)
+    return nullptr;
+
+  // construct LTOModule, hand over ownership of module and target
+  TargetMachine *target =
+      makeTargetMachine(M->getTargetTriple(), options, errMsg);
+  if (!target)
+    return nullptr;
   M->setDataLayout(*target->getDataLayout());
 
   std::unique_ptr<object::IRObjectFile> IRObj(
@@ -636,6 +690,87 @@ bool LTOModule::parseSymbols(std::string &errMsg) {
   return false;
 }
 
+/// parseSymbolTable - Add the symbols of the symbol table of the bitcode, with
+/// the attributes that parseSymbols gives the globals of the module.
+void LTOModule::parseSymbolTable(const BitcodeSymbolTable &Symtab) {
+  for (unsigned I = 0, E = Symtab.getNumSymbols(); I != E; ++I) {
+    uint32_t Flags = Symtab.getSymbolFlags(I);
+    if (Flags & BitcodeSymbolTable::SF_FormatSpecific)
+      continue;
+
+    StringRef Name = Symtab.getSymbolName(I);
+    bool IsFunction = (Flags & BitcodeSymbolTable::SF_Executable) &&
+                      !(Flags & BitcodeSymbolTable::SF_Alias);
+
+    if (Flags & BitcodeSymbolTable::SF_Undefined) {
+      auto IterBool =
+          _undefines.insert(std::make_pair(Name, NameAndAttributes()));
+      if (!IterBool.second)
+        continue;
+      NameAndAttributes &info = IterBool.first->second;
+      info.name = IterBool.first->first().data();
+      if (Flags & BitcodeSymbolTable::SF_Weak)
+        info.attributes = LTO_SYMBOL_DEFINITION_WEAKUNDEF;
+      else
+        info.attributes = LTO_SYMBOL_DEFINITION_UNDEFINED;
+      info.isFunction = IsFunction;
+      info.symbol = nullptr;
+      continue;
+    }
+
+    // set alignment part log2() can have rounding errors
+    uint32_t align = Symtab.getSymbolAlignment(I);
+    uint32_t attr = align ? countTrailingZeros(align) : 0;
+
+    // set permissions part
+    if (IsFunction)
+      attr |= LTO_SYMBOL_PERMISSIONS_CODE;
+    else if (Flags & BitcodeSymbolTable::SF_Constant)
+      attr |= LTO_SYMBOL_PERMISSIONS_RODATA;
+    else
+      attr |= LTO_SYMBOL_PERMISSIONS_DATA;
+
+    // set definition part
+    if (Flags & BitcodeSymbolTable::SF_Weak)
+      attr |= LTO_SYMBOL_DEFINITION_WEAK;
+    else if (Flags & BitcodeSymbolTable::SF_Common)
+      attr |= LTO_SYMBOL_DEFINITION_TENTATIVE;
+    else
+      attr |= LTO_SYMBOL_DEFINITION_REGULAR;
+
+    // set scope part; canUseSymbolTable made sure that the table tells which
+    // linkonce_odr symbols can be hidden.
+    if (!(Flags & BitcodeSymbolTable::SF_Global))
+      attr |= LTO_SYMBOL_SCOPE_INTERNAL;
+    else if (Flags & BitcodeSymbolTable::SF_Hidden)
+      attr |= LTO_SYMBOL_SCOPE_HIDDEN;
+    else if (Flags & BitcodeSymbolTable::SF_Protected)
+      attr |= LTO_SYMBOL_SCOPE_PROTECTED;
+    else if ((Flags & BitcodeSymbolTable::SF_LinkOnceODR) &&
+             (Flags & BitcodeSymbolTable::SF_UnnamedAddr))
+      attr |= LTO_SYMBOL_SCOPE_DEFAULT_CAN_BE_HIDDEN;
+    else
+      attr |= LTO_SYMBOL_SCOPE_DEFAULT;
+
+    NameAndAttributes info;
+    info.name = _defines.insert(Name).first->first().data();
+    info.attributes = attr;
+    info.isFunction = IsFunction;
+    info.symbol = nullptr;
+    _symbols.push_back(info);
+  }
+
+  // make symbols for all undefines
+  for (StringMap<NameAndAttributes>::iterator u =_undefines.begin(),
+         e = _undefines.end(); u != e; ++u) {
+    // If this symbol also has a definition, then don't make an undefine because
+    // it is a tentative definition.
+    if (_defines.count(u->getKey())) continue;
+    NameAndAttributes info = u->getValue();
+    _symbols.push_back(info);
+  }
+}
+
 /// parseMetadata - Parse metadata from the module
 void LTOModule::parseMetadata() {
   // Linker Options
@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/IRSymtabFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -171,12 +172,26 @@ writeSymbolTable(raw_fd_ostream &Out, ArrayRef<NewArchiveIterator> Members,
                                               E = Members.end();
        I != E; ++I, ++MemberNum) {
     MemoryBufferRef MemberBuffer = Buffers[MemberNum];
-    ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
-        object::SymbolicFile::createSymbolicFile(
-            MemberBuffer, sys::fs::file_magic::unknown, &Context);
-    if (!ObjOrErr)
-      continue;  // FIXME: check only for "not an object file" errors.
-    object::SymbolicFile &Obj = *ObjOrErr.get();
+    sys::fs::file_magic Magic =
+        sys::fs::identify_magic(MemberBuffer.getBuffer());
+
+    // Bitcode members with a symbol table do not need to be parsed.
+    std::unique_ptr<object::SymbolicFile> ObjPtr;
+    if (Magic == sys::fs::file_magic::bitcode) {
+      ErrorOr<std::unique_ptr<object::IRSymtabFile>> SymtabOrErr =
+          object::IRSymtabFile::create(MemberBuffer);
+      if (SymtabOrErr)
+        ObjPtr = std::move(*SymtabOrErr);
+    }
+    if (!ObjPtr) {
+      ErrorOr<std::unique_ptr<object::SymbolicFile>> ObjOrErr =
+          object::SymbolicFile::createSymbolicFile(MemberBuffer, Magic,
+                                                   &Context);
+      if (!ObjOrErr)
+        continue;  // FIXME: check only for "not an object file" errors.
+      ObjPtr = std::move(*ObjOrErr);
+    }
+    object::SymbolicFile &Obj = *ObjPtr;
 
     if (!StartOffset) {
       printMemberHeader(Out, "", sys::TimeValue::now(), 0, 0, 0, 0);
@@ -0,0 +1,73 @@
+//===- IRSymtabFile.cpp - Symbol table of LLVM IR -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Part of the IRSymtabFile class implementation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/IRSymtabFile.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+using namespace object;
+
+IRSymtabFile::IRSymtabFile(MemoryBufferRef Object, BitcodeSymbolTable Symtab)
+    : SymbolicFile(Binary::ID_IRSymtab, Object), Symtab(Symtab) {}
+
+void IRSymtabFile::moveSymbolNext(DataRefImpl &Symb) const { ++Symb.p; }
+
+std::error_code IRSymtabFile::printSymbolName(raw_ostream &OS,
+                                              DataRefImpl Symb) const {
+  OS << Symtab.getSymbolName(Symb.p);
+  return object_error::success;
+}
+
+uint32_t IRSymtabFile::getSymbolFlags(DataRefImpl Symb) const {
+  uint32_t Flags = Symtab.getSymbolFlags(Symb.p);
+
+  // Only report the flags that IRObjectFile does, so that both agree.
+  uint32_t Res = BasicSymbolRef::SF_None;
+  if (Flags & BitcodeSymbolTable::SF_Undefined)
+    Res |= BasicSymbolRef::SF_Undefined;
+  else if (Flags & BitcodeSymbolTable::SF_Weak)
+    Res |= BasicSymbolRef::SF_Weak;
+  if (Flags & BitcodeSymbolTable::SF_Global)
+    Res |= BasicSymbolRef::SF_Global;
+  if (Flags & BitcodeSymbolTable::SF_Common)
+    Res |= BasicSymbolRef::SF_Common;
+  if (Flags & BitcodeSymbolTable::SF_FormatSpecific)
+    Res |= BasicSymbolRef::SF_FormatSpecific;
+  return Res;
+}
+
+basic_symbol_iterator IRSymtabFile::symbol_begin_impl() const {
+  DataRefImpl Ret;
+  Ret.p = 0;
+  return basic_symbol_iterator(BasicSymbolRef(Ret, this));
+}
+
+basic_symbol_iterator IRSymtabFile::symbol_end_impl() const {
+  DataRefImpl Ret;
+  Ret.p = Symtab.getNumSymbols();
+  return basic_symbol_iterator(BasicSymbolRef(Ret, this));
+}
+
+ErrorOr<std::unique_ptr<IRSymtabFile>>
+llvm::object::IRSymtabFile::create(MemoryBufferRef Object) {
+  ErrorOr<MemoryBufferRef> BCOrErr =
+      IRObjectFile::findBitcodeInMemBuffer(Object);
+  if (!BCOrErr)
+    return BCOrErr.getError();
+
+  ErrorOr<BitcodeSymbolTable> SymtabOrErr = getBitcodeSymbolTable(*BCOrErr);
+  if (std::error_code EC = SymtabOrErr.getError())
+    return EC;
+  return llvm::make_unique<IRSymtabFile>(Object, *SymtabOrErr);
+}
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Object/IRSymtabFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -34,6 +35,10 @@ ErrorOr<std::unique_ptr<SymbolicFile>> SymbolicFile::createSymbolicFile(
   case sys::fs::file_magic::bitcode:
     if (Context)
       return IRObjectFile::create(Object, *Context);
+    // Without a context, the symbols can still come from the symbol table.
+    if (ErrorOr<std::unique_ptr<IRSymtabFile>> Symtab =
+            IRSymtabFile::create(Object))
+      return std::move(Symtab);
   // Fallthrough
   case sys::fs::file_magic::unknown:
   case sys::fs::file_magic::archive:
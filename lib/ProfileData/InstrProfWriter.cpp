@@ -106,6 +106,30 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   return instrprof_error::success;
 }
 
+void InstrProfWriter::mergeRecordsFromWriter(
+    InstrProfWriter &&IPW,
+    function_ref<void(StringRef, std::error_code)> Warn) {
+  for (auto &I : IPW.FunctionData) {
+    StringRef FunctionName = I.getKey();
+    auto Where = FunctionData.find(FunctionName);
+    if (Where == FunctionData.end()) {
+      // We've never seen this function, take all its counts over.
+      for (const auto &Func : I.getValue())
+        if (Func.second[0] > MaxFunctionCount)
+          MaxFunctionCount = Func.second[0];
+      FunctionData[FunctionName] = std::move(I.getValue());
+      continue;
+    }
+
+    for (const auto &Func : I.getValue())
+      if (std::error_code EC =
+              addFunctionCounts(FunctionName, Func.first, Func.second))
+        Warn(FunctionName, EC);
+  }
+  IPW.FunctionData.clear();
+  IPW.MaxFunctionCount = 0;
+}
+
 std::pair<uint64_t, uint64_t> InstrProfWriter::writeImpl(raw_ostream &OS) {
   OnDiskChainedHashTableGenerator<InstrProfRecordTrait> Generator;
 
@@ -44,6 +44,11 @@ Enabled(
     "stats",
     cl::desc("Enable statistics output from program (available with Asserts)"));
 
+/// -stats-json - Command line option to print the statistics as JSON.
+static cl::opt<bool>
+StatsAsJSON("stats-json", cl::desc("Print -stats output as JSON"),
+            cl::Hidden);
+
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
@@ -53,12 +58,18 @@ class StatisticInfo {
   std::vector<const Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
+  friend std::vector<const Statistic *> llvm::GetStatistics();
+  friend void llvm::ResetStatistics();
 public:
   ~StatisticInfo();
 
   void addStatistic(const Statistic *S) {
     Stats.push_back(S);
   }
+
+  /// sort - Sort the statistics by name, then by description.
+  void sort();
 };
 }
 
@@ -97,6 +108,17 @@ bool llvm::AreStatisticsEnabled() {
   return Enabled;
 }
 
+void StatisticInfo::sort() {
+  std::stable_sort(Stats.begin(), Stats.end(),
+                   [](const Statistic *LHS, const Statistic *RHS) {
+    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
+      return Cmp < 0;
+
+    // Secondary key is the description.
+    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
+  });
+}
+
 void llvm::PrintStatistics(raw_ostream &OS) {
   StatisticInfo &Stats = *StatInfo;
 
@@ -110,14 +132,7 @@ void llvm::PrintStatistics(raw_ostream &OS) {
   }
 
   // Sort the fields by name.
-  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(),
-                   [](const Statistic *LHS, const Statistic *RHS) {
-    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
-      return Cmp < 0;
-
-    // Secondary key is the description.
-    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
-  });
+  Stats.sort();
 
   // Print out the statistics header...
   OS << "===" << std::string(73, '-') << "===\n"
@@ -136,6 +151,48 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
 }
 
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+
+  Stats.sort();
+
+  OS << "{\"stats\":[";
+  for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i) {
+    if (i)
+      OS << ',';
+    OS << "{\"name\":";
+    OS.write_json_string(Stats.Stats[i]->getName());
+    OS << ",\"desc\":";
+    OS.write_json_string(Stats.Stats[i]->getDesc());
+    OS << ",\"value\":" << Stats.Stats[i]->getValue() << '}';
+  }
+  OS << "]}\n";
+  OS.flush();
+}
+
+std::vector<const Statistic *> llvm::GetStatistics() {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+
+  Stats.sort();
+  return Stats.Stats;
+}
+
+void llvm::ResetStatistics() {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+
+  // Clear Initialized too, so that the next bump registers the statistic
+  // again.
+  for (const Statistic *S : Stats.Stats) {
+    Statistic &Stat = const_cast<Statistic &>(*S);
+    Stat.Value = 0;
+    Stat.Initialized = false;
+  }
+  Stats.Stats.clear();
+}
+
 void llvm::PrintStatistics() {
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
   StatisticInfo &Stats = *StatInfo;
@@ -145,7 +202,10 @@ void llvm::PrintStatistics() {
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
-  PrintStatistics(OutStream);
+  if (StatsAsJSON)
+    PrintStatisticsJSON(OutStream);
+  else
+    PrintStatistics(OutStream);
   delete &OutStream;   // Close the file.
 #else
   // Check if the -stats option is set instead of checking
@@ -0,0 +1,254 @@
+//===- TimeTraceProfiler.cpp - Hierarchical time trace ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the time trace profiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeTraceProfiler.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+
+using namespace llvm;
+
+typedef std::chrono::steady_clock ClockType;
+typedef std::chrono::microseconds DurationType;
+
+TimeTraceProfiler *llvm::TimeTraceProfilerInstance = nullptr;
+
+static cl::opt<bool>
+TimeTrace("time-trace",
+          cl::desc("Record a timeline of the passes and code generation "
+                   "phases in the Chrome trace event format"));
+
+static cl::opt<unsigned>
+TimeTraceGranularity("time-trace-granularity",
+                     cl::desc("Minimum duration of the scopes recorded by "
+                              "-time-trace"),
+                     cl::value_desc("microseconds"), cl::init(500));
+
+static cl::opt<std::string>
+TimeTraceFile("time-trace-file",
+              cl::desc("Write the -time-trace output to this file (default: "
+                       "<output>.time-trace.json)"),
+              cl::value_desc("filename"));
+
+namespace {
+/// A scope that was recorded, with its times in microseconds since the start
+/// of the trace.
+struct Entry {
+  uint64_t Start;
+  uint64_t Duration;
+  unsigned Tid;
+  /// The position of the entry in the order the scopes ended.
+  size_t Index;
+  std::string Name;
+  std::string Detail;
+};
+}
+
+// Threads are numbered in the order in which they record their first scope,
+// which gives small, stable tids in the trace.
+static std::atomic<unsigned> NextTid(0);
+static LLVM_THREAD_LOCAL unsigned ThreadTid = 0;
+
+static unsigned getTid() {
+  // Tid 0 means that the thread has not been numbered yet.
+  if (!ThreadTid)
+    ThreadTid = ++NextTid;
+  return ThreadTid;
+}
+
+namespace llvm {
+class TimeTraceProfiler {
+public:
+  TimeTraceProfiler(unsigned GranularityInUs, StringRef ProcessName)
+      : Start(ClockType::now()), Granularity(GranularityInUs),
+        ProcessName(ProcessName) {}
+
+  void record(ClockType::time_point Begin, StringRef Name, StringRef Detail);
+  void write(raw_ostream &OS);
+
+private:
+  const ClockType::time_point Start;
+  const uint64_t Granularity;
+  const std::string ProcessName;
+
+  sys::Mutex Lock;
+  std::vector<Entry> Entries;
+};
+}
+
+void TimeTraceProfiler::record(ClockType::time_point Begin, StringRef Name,
+                               StringRef Detail) {
+  ClockType::time_point End = ClockType::now();
+  uint64_t Duration =
+      std::chrono::duration_cast<DurationType>(End - Begin).count();
+  if (Duration < Granularity)
+    return;
+
+  Entry E;
+  E.Start = std::chrono::duration_cast<DurationType>(Begin - Start).count();
+  E.Duration = Duration;
+  E.Tid = getTid();
+  E.Name = Name;
+  E.Detail = Detail;
+
+  sys::ScopedLock L(Lock);
+  E.Index = Entries.size();
+  Entries.push_back(std::move(E));
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  sys::ScopedLock L(Lock);
+
+  // Scopes are recorded when they end, so inner scopes come first.  Sort them
+  // by start time, enclosing scopes first, which is what trace viewers
+  // expect.  Short nested scopes can have the same start and duration at the
+  // resolution of the trace, in which case the one that ended last encloses
+  // the others.
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &LHS, const Entry &RHS) {
+    if (LHS.Start != RHS.Start)
+      return LHS.Start < RHS.Start;
+    if (LHS.Duration != RHS.Duration)
+      return LHS.Duration > RHS.Duration;
+    return LHS.Index > RHS.Index;
+  });
+
+  OS << "{\"traceEvents\":[\n";
+  unsigned MaxTid = 0;
+  for (const Entry &E : Entries) {
+    OS << "{\"pid\":1,\"tid\":" << E.Tid << ",\"ph\":\"X\",\"ts\":" << E.Start
+       << ",\"dur\":" << E.Duration << ",\"name\":";
+    OS.write_json_string(E.Name);
+    if (!E.Detail.empty()) {
+      OS << ",\"args\":{\"detail\":";
+      OS.write_json_string(E.Detail);
+      OS << '}';
+    }
+    OS << "},\n";
+    MaxTid = std::max(MaxTid, E.Tid);
+  }
+
+  // Sum up the time of each scope name.  Scopes nested in a scope with the
+  // same name, such as recursive ones, are only counted once.  The scopes
+  // enclosing the current one on each thread are kept on a stack.
+  struct OpenScopes {
+    std::vector<const Entry *> Stack;
+    StringMap<unsigned> Count;
+  };
+  std::map<unsigned, OpenScopes> Threads;
+  StringMap<std::pair<uint64_t, unsigned> > Totals;
+  for (const Entry &E : Entries) {
+    OpenScopes &Open = Threads[E.Tid];
+    while (!Open.Stack.empty() &&
+           Open.Stack.back()->Start + Open.Stack.back()->Duration <= E.Start) {
+      --Open.Count[Open.Stack.back()->Name];
+      Open.Stack.pop_back();
+    }
+    unsigned &Count = Open.Count[E.Name];
+    if (!Count) {
+      std::pair<uint64_t, unsigned> &Total = Totals[E.Name];
+      Total.first += E.Duration;
+      ++Total.second;
+    }
+    ++Count;
+    Open.Stack.push_back(&E);
+  }
+
+  // Write the totals as one thread per name, longest first.
+  std::vector<std::pair<std::string, std::pair<uint64_t, unsigned> > >
+      SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.push_back(std::make_pair(Total.getKey().str(),
+                                          Total.getValue()));
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const std::pair<std::string, std::pair<uint64_t, unsigned> > &L,
+               const std::pair<std::string, std::pair<uint64_t, unsigned> > &R) {
+    if (L.second.first != R.second.first)
+      return L.second.first > R.second.first;
+    return L.first < R.first;
+  });
+  unsigned Tid = MaxTid;
+  for (const auto &Total : SortedTotals) {
+    ++Tid;
+    OS << "{\"pid\":1,\"tid\":" << Tid << ",\"ph\":\"X\",\"ts\":0,\"dur\":"
+       << Total.second.first << ",\"name\":";
+    OS.write_json_string("Total " + Total.first);
+    OS << ",\"args\":{\"count\":" << Total.second.second << ",\"avg us\":"
+       << Total.second.first / Total.second.second << "}},\n";
+  }
+
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"ts\":0,\"cat\":\"\","
+        "\"name\":\"process_name\",\"args\":{\"name\":";
+  OS.write_json_string(ProcessName);
+  OS << "}}\n]}\n";
+  OS.flush();
+}
+
+void llvm::timeTraceProfilerInitialize(unsigned GranularityInUs,
+                                       StringRef ProcessName) {
+  assert(!TimeTraceProfilerInstance && "Profiler already initialized");
+  TimeTraceProfilerInstance =
+      new TimeTraceProfiler(GranularityInUs, ProcessName);
+}
+
+void llvm::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void llvm::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "Profiler not initialized");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+void llvm::timeTraceProfilerInitializeFromOptions(StringRef ProcessName) {
+  if (TimeTrace)
+    timeTraceProfilerInitialize(TimeTraceGranularity, ProcessName);
+}
+
+std::error_code llvm::timeTraceProfilerWriteFile(StringRef OutputFilename) {
+  if (!TimeTraceProfilerInstance)
+    return std::error_code();
+
+  std::string Path = TimeTraceFile;
+  if (Path.empty()) {
+    if (OutputFilename.empty() || OutputFilename == "-")
+      Path = "time-trace.json";
+    else
+      Path = (OutputFilename + ".time-trace.json").str();
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << "Error opening time trace file '" << Path << "': "
+           << EC.message() << '\n';
+    return EC;
+  }
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  return std::error_code();
+}
+
+void TimeTraceScope::end() {
+  // The trace may have been stopped while this scope was open.
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->record(Start, Name, Detail);
+}
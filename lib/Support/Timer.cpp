@@ -50,6 +50,11 @@ namespace {
   InfoOutputFilename("info-output-file", cl::value_desc("filename"),
                      cl::desc("File to append -stats and -timer output to"),
                    cl::Hidden, cl::location(getLibSupportInfoOutputFilename()));
+
+  static cl::opt<bool>
+  TimersAsJSON("timers-json", cl::desc("Print -time-passes and other timer "
+                                       "reports as JSON, one line per group"),
+               cl::Hidden);
 }
 
 // CreateInfoOutputFile - Return a file stream to print our output on.
@@ -310,6 +315,13 @@ void TimerGroup::addTimer(Timer &T) {
 }
 
 void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
+  if (TimersAsJSON) {
+    PrintQueuedTimersJSON(OS);
+    OS << '\n';
+    OS.flush();
+    return;
+  }
+
   // Sort the timers in descending order by amount of time taken.
   std::sort(TimersToPrint.begin(), TimersToPrint.end());
   
@@ -358,12 +370,43 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   TimersToPrint.clear();
 }
 
-/// print - Print any started timers in this group and zero them.
-void TimerGroup::print(raw_ostream &OS) {
-  sys::SmartScopedLock<true> L(*TimerLock);
+static void printJSONRecord(const TimeRecord &Time, raw_ostream &OS) {
+  OS << format("\"wall\":%.6f,\"user\":%.6f,\"sys\":%.6f,\"mem\":%" PRId64,
+               Time.getWallTime(), Time.getUserTime(), Time.getSystemTime(),
+               (int64_t)Time.getMemUsed());
+}
+
+void TimerGroup::PrintQueuedTimersJSON(raw_ostream &OS) {
+  // Sort the timers in descending order by amount of time taken.
+  std::sort(TimersToPrint.begin(), TimersToPrint.end());
+
+  TimeRecord Total;
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i)
+    Total += TimersToPrint[i].first;
+
+  OS << "{\"name\":";
+  OS.write_json_string(Name);
+  OS << ",\"total\":{";
+  printJSONRecord(Total, OS);
+  OS << "},\"timers\":[";
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
+    const std::pair<TimeRecord, std::string> &Entry = TimersToPrint[e-i-1];
+    if (i)
+      OS << ',';
+    OS << "{\"name\":";
+    OS.write_json_string(Entry.second);
+    OS << ',';
+    printJSONRecord(Entry.first, OS);
+    OS << '}';
+  }
+  OS << "]}";
 
-  // See if any of our timers were started, if so add them to TimersToPrint and
-  // reset them.
+  TimersToPrint.clear();
+}
+
+/// queueStartedTimers - Move the data of the started timers in this group to
+/// TimersToPrint and reset them.
+void TimerGroup::queueStartedTimers() {
   for (Timer *T = FirstTimer; T; T = T->Next) {
     if (!T->Started) continue;
     TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
@@ -372,6 +415,13 @@ void TimerGroup::print(raw_ostream &OS) {
     T->Started = 0;
     T->Time = TimeRecord();
   }
+}
+
+/// print - Print any started timers in this group and zero them.
+void TimerGroup::print(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  queueStartedTimers();
 
   // If any timers were started, print the group.
   if (!TimersToPrint.empty())
@@ -385,3 +435,31 @@ void TimerGroup::printAll(raw_ostream &OS) {
   for (TimerGroup *TG = TimerGroupList; TG; TG = TG->Next)
     TG->print(OS);
 }
+
+/// printJSON - Print any started timers in this group as JSON and zero them.
+void TimerGroup::printJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  queueStartedTimers();
+  PrintQueuedTimersJSON(OS);
+  OS.flush();
+}
+
+/// printAllJSON - This static method prints all timers as a JSON array and
+/// clears them all out.  Groups without any started timer are skipped.
+void TimerGroup::printAllJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  OS << '[';
+  bool First = true;
+  for (TimerGroup *TG = TimerGroupList; TG; TG = TG->Next) {
+    TG->queueStartedTimers();
+    if (TG->TimersToPrint.empty())
+      continue;
+    OS << (First ? "\n" : ",\n");
+    First = false;
+    TG->PrintQueuedTimersJSON(OS);
+  }
+  OS << "\n]\n";
+  OS.flush();
+}
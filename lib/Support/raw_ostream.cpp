@@ -217,6 +217,49 @@ raw_ostream &raw_ostream::write_escaped(StringRef Str,
   return *this;
 }
 
+raw_ostream &raw_ostream::write_json_string(StringRef Str) {
+  *this << '"';
+  for (unsigned i = 0, e = Str.size(); i != e; ++i) {
+    unsigned char c = Str[i];
+
+    switch (c) {
+    case '\\':
+      *this << '\\' << '\\';
+      break;
+    case '"':
+      *this << '\\' << '"';
+      break;
+    case '\b':
+      *this << '\\' << 'b';
+      break;
+    case '\f':
+      *this << '\\' << 'f';
+      break;
+    case '\n':
+      *this << '\\' << 'n';
+      break;
+    case '\r':
+      *this << '\\' << 'r';
+      break;
+    case '\t':
+      *this << '\\' << 't';
+      break;
+    default:
+      if (c >= 0x20) {
+        *this << c;
+        break;
+      }
+
+      // JSON has no octal or hex escapes, only \uXXXX.
+      *this << "\\u00";
+      *this << hexdigit((c >> 4) & 0xF);
+      *this << hexdigit((c >> 0) & 0xF);
+    }
+  }
+
+  return *this << '"';
+}
+
 raw_ostream &raw_ostream::operator<<(const void *P) {
   *this << '0' << 'x';
 
@@ -0,0 +1,198 @@
+//===-- AArch64CallLowering.cpp - Call lowering for GlobalISel ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the lowering of the arguments, the return value and
+/// the calls of AArch64 functions for the global instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#include "AArch64CallLowering.h"
+#include "AArch64ISelLowering.h"
+#include "AArch64InstrInfo.h"
+#include "AArch64Subtarget.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Target/TargetMachine.h"
+using namespace llvm;
+
+// Only handle simple cases, i.e. up to 8 integer arguments in registers.
+static const MCPhysReg GPR32ArgRegs[] = {
+  AArch64::W0, AArch64::W1, AArch64::W2, AArch64::W3,
+  AArch64::W4, AArch64::W5, AArch64::W6, AArch64::W7
+};
+static const MCPhysReg GPR64ArgRegs[] = {
+  AArch64::X0, AArch64::X1, AArch64::X2, AArch64::X3,
+  AArch64::X4, AArch64::X5, AArch64::X6, AArch64::X7
+};
+
+AArch64CallLowering::AArch64CallLowering(const AArch64TargetLowering *TLI)
+    : CallLowering(TLI) {}
+
+bool AArch64CallLowering::isSupportedFunction(const MachineFunction &MF) const {
+  const Function &F = *MF.getFunction();
+  CallingConv::ID CC = F.getCallingConv();
+  // fastcc with -tailcallopt makes the callee pop its arguments.
+  if (CC != CallingConv::C &&
+      (CC != CallingConv::Fast ||
+       MF.getTarget().Options.GuaranteedTailCallOpt))
+    return false;
+  return !F.isVarArg() && !F.hasStructRetAttr();
+}
+
+bool AArch64CallLowering::lowerFormalArguments(MachineIRBuilder &MIRBuilder,
+                                               const Function &F,
+                                               ArrayRef<unsigned> VRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (!isSupportedFunction(MF))
+    return false;
+
+  if (VRegs.size() > array_lengthof(GPR64ArgRegs))
+    return false;
+
+  const AttributeSet &Attrs = F.getAttributes();
+  unsigned Idx = 0;
+  for (const Argument &Arg : F.args()) {
+    // The first argument is at index 1.
+    if (Attrs.hasAttribute(Idx + 1, Attribute::ByVal) ||
+        Attrs.hasAttribute(Idx + 1, Attribute::InReg) ||
+        Attrs.hasAttribute(Idx + 1, Attribute::Nest))
+      return false;
+    // Booleans are only known to be 0 or 1 if the caller extended them.
+    if (Arg.getType()->isIntegerTy(1) &&
+        !Attrs.hasAttribute(Idx + 1, Attribute::ZExt))
+      return false;
+    ++Idx;
+  }
+
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  for (unsigned I = 0, E = VRegs.size(); I != E; ++I) {
+    unsigned PhysReg;
+    switch (MRI.getRegClass(VRegs[I])->getSize()) {
+    case 4: PhysReg = GPR32ArgRegs[I]; break;
+    case 8: PhysReg = GPR64ArgRegs[I]; break;
+    default: return false;
+    }
+    MBB.addLiveIn(PhysReg);
+    MIRBuilder.buildCopy(VRegs[I], PhysReg);
+  }
+  return true;
+}
+
+bool AArch64CallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
+                                      const Value *Val, unsigned VReg) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = *MF.getFunction();
+  if (!isSupportedFunction(MF))
+    return false;
+
+  unsigned RetReg = 0;
+  if (Val) {
+    // Booleans are 0 or 1, so they are already zero extended; sign extending
+    // one takes more than a move.
+    const AttributeSet &Attrs = F.getAttributes();
+    if (Val->getType()->isIntegerTy(1) &&
+        Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::SExt))
+      return false;
+    switch (MF.getRegInfo().getRegClass(VReg)->getSize()) {
+    case 4: RetReg = AArch64::W0; break;
+    case 8: RetReg = AArch64::X0; break;
+    default: return false;
+    }
+    MIRBuilder.buildCopy(RetReg, VReg);
+  }
+
+  MachineInstrBuilder MIB = MIRBuilder.buildInstr(AArch64::RET_ReallyLR);
+  if (RetReg)
+    MIB.addReg(RetReg, RegState::Implicit);
+  return true;
+}
+
+bool AArch64CallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
+                                    const CallInst &CI, unsigned Callee,
+                                    unsigned ResVReg,
+                                    ArrayRef<unsigned> ArgVRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (!isSupportedFunction(MF))
+    return false;
+  const TargetMachine &TM = MF.getTarget();
+  CallingConv::ID CC = CI.getCallingConv();
+  if (CC != CallingConv::C &&
+      (CC != CallingConv::Fast || TM.Options.GuaranteedTailCallOpt))
+    return false;
+  // BL only reaches everything in the small code model. Variadic arguments
+  // go on the stack on Darwin.
+  if (ArgVRegs.size() > array_lengthof(GPR64ArgRegs) ||
+      TM.getCodeModel() != CodeModel::Small ||
+      CI.getFunctionType()->isVarArg())
+    return false;
+
+  const AttributeSet &Attrs = CI.getAttributes();
+  if (Attrs.hasAttribute(1, Attribute::StructRet))
+    return false;
+  for (unsigned I = 0, E = ArgVRegs.size(); I != E; ++I) {
+    if (Attrs.hasAttribute(I + 1, Attribute::ByVal) ||
+        Attrs.hasAttribute(I + 1, Attribute::InReg) ||
+        Attrs.hasAttribute(I + 1, Attribute::Nest) ||
+        Attrs.hasAttribute(I + 1, Attribute::InAlloca))
+      return false;
+    // Booleans are 0 or 1, so they are already zero extended; sign extending
+    // one takes more than a move.
+    if (CI.getArgOperand(I)->getType()->isIntegerTy(1) &&
+        Attrs.hasAttribute(I + 1, Attribute::SExt))
+      return false;
+  }
+  // Booleans are only known to be 0 or 1 if the callee extended them.
+  if (ResVReg && CI.getType()->isIntegerTy(1) &&
+      !Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::ZExt))
+    return false;
+
+  // All the arguments are in registers, so the call frame is empty.
+  const AArch64Subtarget &Subtarget = MF.getSubtarget<AArch64Subtarget>();
+  const AArch64InstrInfo &TII = *Subtarget.getInstrInfo();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  MIRBuilder.buildInstr(TII.getCallFrameSetupOpcode()).addImm(0);
+
+  SmallVector<unsigned, 8> ArgRegs;
+  for (unsigned I = 0, E = ArgVRegs.size(); I != E; ++I) {
+    unsigned VReg = ArgVRegs[I];
+    bool Is64Bit = MRI.getRegClass(VReg)->getSize() == 8;
+    unsigned PhysReg = Is64Bit ? GPR64ArgRegs[I] : GPR32ArgRegs[I];
+    MIRBuilder.buildCopy(PhysReg, VReg);
+    ArgRegs.push_back(PhysReg);
+  }
+
+  MachineInstrBuilder MIB;
+  if (!Callee) {
+    MIB = MIRBuilder.buildInstr(AArch64::BL)
+              .addGlobalAddress(CI.getCalledFunction(), 0, 0);
+  } else {
+    if (!MRI.constrainRegClass(Callee, &AArch64::GPR64RegClass))
+      return false;
+    MIB = MIRBuilder.buildInstr(AArch64::BLR).addReg(Callee);
+  }
+  MIB.addRegMask(Subtarget.getRegisterInfo()->getCallPreservedMask(MF, CC));
+  for (unsigned Reg : ArgRegs)
+    MIB.addReg(Reg, RegState::Implicit);
+  unsigned RetReg = 0;
+  if (ResVReg) {
+    RetReg = MRI.getRegClass(ResVReg)->getSize() == 8 ? AArch64::X0
+                                                       : AArch64::W0;
+    MIB.addReg(RetReg, RegState::ImplicitDefine);
+  }
+
+  MIRBuilder.buildInstr(TII.getCallFrameDestroyOpcode()).addImm(0).addImm(0);
+  if (RetReg)
+    MIRBuilder.buildCopy(ResVReg, RetReg);
+  return true;
+}
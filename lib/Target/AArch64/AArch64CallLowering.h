@@ -0,0 +1,49 @@
+//===-- AArch64CallLowering.h - Call lowering for GlobalISel ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file describes how the global instruction selector lowers the
+/// arguments, the return value and the calls of AArch64 functions.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_AARCH64_AARCH64CALLLOWERING_H
+#define LLVM_LIB_TARGET_AARCH64_AARCH64CALLLOWERING_H
+
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+
+namespace llvm {
+
+class AArch64TargetLowering;
+class MachineFunction;
+
+/// Only handles functions and calls of the AAPCS64 calling convention whose
+/// arguments and return value are integers passed in registers.
+class AArch64CallLowering : public CallLowering {
+public:
+  AArch64CallLowering(const AArch64TargetLowering *TLI);
+
+  bool lowerFormalArguments(MachineIRBuilder &MIRBuilder, const Function &F,
+                            ArrayRef<unsigned> VRegs) const override;
+
+  bool lowerReturn(MachineIRBuilder &MIRBuilder, const Value *Val,
+                   unsigned VReg) const override;
+
+  bool lowerCall(MachineIRBuilder &MIRBuilder, const CallInst &CI,
+                 unsigned Callee, unsigned ResVReg,
+                 ArrayRef<unsigned> ArgVRegs) const override;
+
+private:
+  /// Return true if the calling convention of \p MF is handled by this class.
+  bool isSupportedFunction(const MachineFunction &MF) const;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -118,6 +118,10 @@ private:
   bool selectStore(const Instruction *I);
   bool selectBranch(const Instruction *I);
   bool selectIndirectBr(const Instruction *I);
+  bool selectSwitch(const Instruction *I);
+  bool selectFence(const Instruction *I);
+  bool selectOrderedLoad(const LoadInst *LI, MVT VT);
+  bool selectOrderedStore(const StoreInst *SI, MVT VT);
   bool selectCmp(const Instruction *I);
   bool selectSelect(const Instruction *I);
   bool selectFPExt(const Instruction *I);
@@ -139,6 +143,9 @@ private:
   bool isTypeLegal(Type *Ty, MVT &VT);
   bool isTypeSupported(Type *Ty, MVT &VT, bool IsVectorAllowed = false);
   bool isValueAvailable(const Value *V) const;
+  bool isSimpleAtomicAccess(MVT VT, unsigned Alignment);
+  MachineMemOperand *getAtomicMemOperand(const Value *Ptr, MVT VT,
+                                         unsigned Flags);
   bool computeAddress(const Value *Obj, Address &Addr, Type *Ty = nullptr);
   bool computeCallAddress(const Value *V, Address &Addr);
   bool simplifyAddress(Address &Addr, MVT VT);
@@ -951,6 +958,24 @@ bool AArch64FastISel::isValueAvailable(const Value *V) const {
   return false;
 }
 
+/// \brief Check if an atomic load or store of the given type and alignment is
+/// single-copy atomic, which is the case for naturally aligned integers.
+bool AArch64FastISel::isSimpleAtomicAccess(MVT VT, unsigned Alignment) {
+  return VT.isInteger() && VT != MVT::i1 && Alignment >= VT.getStoreSize();
+}
+
+/// \brief Return the memory operand of an ordered access of type VT to Ptr.
+/// Like SelectionDAG, mark it volatile so that nothing moves other memory
+/// accesses across it.
+MachineMemOperand *AArch64FastISel::getAtomicMemOperand(const Value *Ptr,
+                                                        MVT VT,
+                                                        unsigned Flags) {
+  unsigned Size = VT.getStoreSize();
+  return FuncInfo.MF->getMachineMemOperand(
+      MachinePointerInfo(Ptr), Flags | MachineMemOperand::MOVolatile, Size,
+      Size);
+}
+
 bool AArch64FastISel::simplifyAddress(Address &Addr, MVT VT) {
   unsigned ScaleFactor = getImplicitScaleFactor(VT);
   if (!ScaleFactor)
@@ -1870,10 +1895,19 @@ bool AArch64FastISel::selectLoad(const Instruction *I) {
   // Verify we have a legal type before going any further.  Currently, we handle
   // simple types that will directly fit in a register (i32/f32/i64/f64) or
   // those that can be sign or zero-extended to a basic operation (i1/i8/i16).
-  if (!isTypeSupported(I->getType(), VT, /*IsVectorAllowed=*/true) ||
-      cast<LoadInst>(I)->isAtomic())
+  if (!isTypeSupported(I->getType(), VT, /*IsVectorAllowed=*/true))
     return false;
 
+  // Aligned unordered and monotonic loads are ordinary loads. Acquiring loads
+  // need LDAR.
+  const auto *LI = cast<LoadInst>(I);
+  if (LI->isAtomic()) {
+    if (!isSimpleAtomicAccess(VT, LI->getAlignment()))
+      return false;
+    if (isAtLeastAcquire(LI->getOrdering()))
+      return selectOrderedLoad(LI, VT);
+  }
+
   // See if we can handle this address.
   Address Addr;
   if (!computeAddress(I->getOperand(0), Addr, I->getType()))
@@ -2031,10 +2065,19 @@ bool AArch64FastISel::selectStore(const Instruction *I) {
   // Verify we have a legal type before going any further.  Currently, we handle
   // simple types that will directly fit in a register (i32/f32/i64/f64) or
   // those that can be sign or zero-extended to a basic operation (i1/i8/i16).
-  if (!isTypeSupported(Op0->getType(), VT, /*IsVectorAllowed=*/true) ||
-      cast<StoreInst>(I)->isAtomic())
+  if (!isTypeSupported(Op0->getType(), VT, /*IsVectorAllowed=*/true))
     return false;
 
+  // Aligned unordered and monotonic stores are ordinary stores. Releasing
+  // stores need STLR.
+  const auto *SI = cast<StoreInst>(I);
+  if (SI->isAtomic()) {
+    if (!isSimpleAtomicAccess(VT, SI->getAlignment()))
+      return false;
+    if (isAtLeastRelease(SI->getOrdering()))
+      return selectOrderedStore(SI, VT);
+  }
+
   // Get the value to be stored into a register. Use the zero register directly
   // when possible to avoid an unnecessary copy and a wasted register.
   unsigned SrcReg = 0;
@@ -2064,6 +2107,82 @@ bool AArch64FastISel::selectStore(const Instruction *I) {
   return true;
 }
 
+bool AArch64FastISel::selectOrderedLoad(const LoadInst *LI, MVT VT) {
+  unsigned Opc;
+  const TargetRegisterClass *RC;
+  switch (VT.SimpleTy) {
+  default:
+    return false;
+  case MVT::i8:
+    Opc = AArch64::LDARB;
+    RC = &AArch64::GPR32RegClass;
+    break;
+  case MVT::i16:
+    Opc = AArch64::LDARH;
+    RC = &AArch64::GPR32RegClass;
+    break;
+  case MVT::i32:
+    Opc = AArch64::LDARW;
+    RC = &AArch64::GPR32RegClass;
+    break;
+  case MVT::i64:
+    Opc = AArch64::LDARX;
+    RC = &AArch64::GPR64RegClass;
+    break;
+  }
+
+  // LDAR only takes a base register.
+  const Value *Ptr = LI->getPointerOperand();
+  unsigned AddrReg = getRegForValue(Ptr);
+  if (!AddrReg)
+    return false;
+  bool AddrIsKill = hasTrivialKill(Ptr);
+
+  const MCInstrDesc &II = TII.get(Opc);
+  AddrReg = constrainOperandRegClass(II, AddrReg, II.getNumDefs());
+  unsigned ResultReg = createResultReg(RC);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, II, ResultReg)
+      .addReg(AddrReg, getKillRegState(AddrIsKill))
+      .addMemOperand(getAtomicMemOperand(Ptr, VT, MachineMemOperand::MOLoad));
+
+  updateValueMap(LI, ResultReg);
+  return true;
+}
+
+bool AArch64FastISel::selectOrderedStore(const StoreInst *SI, MVT VT) {
+  unsigned Opc;
+  switch (VT.SimpleTy) {
+  default:
+    return false;
+  case MVT::i8:  Opc = AArch64::STLRB; break;
+  case MVT::i16: Opc = AArch64::STLRH; break;
+  case MVT::i32: Opc = AArch64::STLRW; break;
+  case MVT::i64: Opc = AArch64::STLRX; break;
+  }
+
+  const Value *Val = SI->getValueOperand();
+  unsigned SrcReg = getRegForValue(Val);
+  if (!SrcReg)
+    return false;
+  bool SrcIsKill = hasTrivialKill(Val);
+
+  // STLR only takes a base register.
+  const Value *Ptr = SI->getPointerOperand();
+  unsigned AddrReg = getRegForValue(Ptr);
+  if (!AddrReg)
+    return false;
+  bool AddrIsKill = hasTrivialKill(Ptr);
+
+  const MCInstrDesc &II = TII.get(Opc);
+  SrcReg = constrainOperandRegClass(II, SrcReg, 0);
+  AddrReg = constrainOperandRegClass(II, AddrReg, 1);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, II)
+      .addReg(SrcReg, getKillRegState(SrcIsKill))
+      .addReg(AddrReg, getKillRegState(AddrIsKill))
+      .addMemOperand(getAtomicMemOperand(Ptr, VT, MachineMemOperand::MOStore));
+  return true;
+}
+
 static AArch64CC::CondCode getCompareCC(CmpInst::Predicate Pred) {
   switch (Pred) {
   case CmpInst::FCMP_ONE:
@@ -2445,6 +2564,119 @@ bool AArch64FastISel::selectIndirectBr(const Instruction *I) {
   return true;
 }
 
+/// \brief Select a switch whose cases all go to the same block and cover a
+/// contiguous range of values. That takes a single compare and branch; other
+/// switches are left to SelectionDAG, which builds jump tables and bit tests.
+bool AArch64FastISel::selectSwitch(const Instruction *I) {
+  const SwitchInst *SI = cast<SwitchInst>(I);
+  const Value *Cond = SI->getCondition();
+  MVT VT;
+  if (!isTypeSupported(Cond->getType(), VT) || VT == MVT::i1)
+    return false;
+
+  const BasicBlock *CaseBB = nullptr;
+  APInt Low, High;
+  for (auto Case : SI->cases()) {
+    const APInt &Val = Case.getCaseValue()->getValue();
+    if (!CaseBB) {
+      CaseBB = Case.getCaseSuccessor();
+      Low = High = Val;
+      continue;
+    }
+    if (Case.getCaseSuccessor() != CaseBB)
+      return false;
+    if (Val.slt(Low))
+      Low = Val;
+    if (Val.sgt(High))
+      High = Val;
+  }
+
+  const BasicBlock *BB = SI->getParent();
+  if (CaseBB) {
+    // Case values are unique, so they are contiguous if there are as many of
+    // them as values in [Low, High].
+    APInt Range = High - Low;
+    if (Range.getZExtValue() != SI->getNumCases() - 1)
+      return false;
+
+    AArch64CC::CondCode CC;
+    if (Range == 0) {
+      const ConstantInt *CaseVal = SI->case_begin().getCaseValue();
+      if (!emitCmp(Cond, CaseVal, /*IsZExt=*/true))
+        return false;
+      CC = AArch64CC::EQ;
+    } else {
+      // Branch to the case block if (Cond - Low) <=u (High - Low). Narrow
+      // values are sign-extended first; Low and High are signed bounds, so
+      // the subtraction can't wrap around in 32 bits.
+      unsigned CondReg = getRegForValue(Cond);
+      if (!CondReg)
+        return false;
+      bool CondIsKill = hasTrivialKill(Cond);
+      MVT CmpVT = VT;
+      if (VT == MVT::i8 || VT == MVT::i16) {
+        CondReg = emitIntExt(VT, CondReg, MVT::i32, /*isZExt=*/false);
+        if (!CondReg)
+          return false;
+        CondIsKill = true;
+        CmpVT = MVT::i32;
+      }
+
+      if (Low != 0) {
+        APInt NegLow = -Low.sextOrSelf(CmpVT.getSizeInBits());
+        if (NegLow.isMinSignedValue())
+          return false;
+        CondReg = emitAdd_ri_(CmpVT, CondReg, CondIsKill,
+                              NegLow.getSExtValue());
+        if (!CondReg)
+          return false;
+        CondIsKill = true;
+      }
+
+      uint64_t RangeVal = Range.getZExtValue();
+      if (!emitICmp_ri(CmpVT, CondReg, CondIsKill, RangeVal)) {
+        unsigned RangeReg = fastEmit_i(CmpVT, CmpVT, ISD::Constant, RangeVal);
+        if (!RangeReg ||
+            !emitSubs_rr(CmpVT, CondReg, CondIsKill, RangeReg,
+                         /*RHSIsKill=*/true, /*WantResult=*/false))
+          return false;
+      }
+      CC = AArch64CC::LS;
+    }
+
+    MachineBasicBlock *CaseMBB = FuncInfo.MBBMap[CaseBB];
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(AArch64::Bcc))
+        .addImm(CC)
+        .addMBB(CaseMBB);
+    uint32_t BranchWeight = 0;
+    if (FuncInfo.BPI)
+      BranchWeight = FuncInfo.BPI->getEdgeWeight(BB, CaseBB);
+    FuncInfo.MBB->addSuccessor(CaseMBB, BranchWeight);
+  }
+
+  // Branch to the default block, unless it is also the case block.
+  MachineBasicBlock *DefaultMBB = FuncInfo.MBBMap[SI->getDefaultDest()];
+  if (FuncInfo.MBB->isSuccessor(DefaultMBB)) {
+    if (!FuncInfo.MBB->isLayoutSuccessor(DefaultMBB))
+      TII.InsertBranch(*FuncInfo.MBB, DefaultMBB, nullptr,
+                       SmallVector<MachineOperand, 0>(), DbgLoc);
+    return true;
+  }
+  fastEmitBranch(DefaultMBB, DbgLoc);
+  return true;
+}
+
+bool AArch64FastISel::selectFence(const Instruction *I) {
+  const FenceInst *FI = cast<FenceInst>(I);
+
+  // Same barriers as the SelectionDAG patterns: an acquire fence only has to
+  // order earlier loads (DMB ISHLD), everything else needs DMB ISH.
+  unsigned BarrierOpt = FI->getOrdering() == Acquire ? 0x9 : 0xb;
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(AArch64::DMB))
+      .addImm(BarrierOpt);
+  return true;
+}
+
 bool AArch64FastISel::selectCmp(const Instruction *I) {
   const CmpInst *CI = cast<CmpInst>(I);
 
@@ -4930,6 +5162,10 @@ bool AArch64FastISel::fastSelectInstruction(const Instruction *I) {
     return selectBranch(I);
   case Instruction::IndirectBr:
     return selectIndirectBr(I);
+  case Instruction::Switch:
+    return selectSwitch(I);
+  case Instruction::Fence:
+    return selectFence(I);
   case Instruction::BitCast:
     if (!FastISel::selectBitCast(I))
       return selectBitCast(I);
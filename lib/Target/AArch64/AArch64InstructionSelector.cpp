@@ -0,0 +1,354 @@
+//===-- AArch64InstructionSelector.cpp - Select AArch64 instructions ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the selection of the generic instructions into
+/// AArch64 instructions for the global instruction selector. The type of a
+/// generic instruction is given by the size of the register class of its
+/// registers; only 32 and 64-bit integers are legal.
+///
+//===----------------------------------------------------------------------===//
+
+#include "AArch64InstructionSelector.h"
+#include "AArch64InstrInfo.h"
+#include "AArch64RegisterInfo.h"
+#include "AArch64Subtarget.h"
+#include "Utils/AArch64BaseInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Target/TargetOpcodes.h"
+using namespace llvm;
+
+AArch64InstructionSelector::AArch64InstructionSelector(
+    const AArch64InstrInfo &TII, const AArch64RegisterInfo &TRI)
+    : TII(TII), TRI(TRI) {}
+
+/// Return the size in bytes of the values held in \p Reg.
+static unsigned getRegSize(const MachineRegisterInfo &MRI, unsigned Reg) {
+  return MRI.getRegClass(Reg)->getSize();
+}
+
+bool AArch64InstructionSelector::constrainOperands(
+    const MachineInstrBuilder &MIB) const {
+  MachineInstr &MI = *MIB;
+  MachineFunction &MF = *MI.getParent()->getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const MCInstrDesc &Desc = MI.getDesc();
+  for (unsigned I = 0, E = MI.getNumOperands(); I != E; ++I) {
+    const MachineOperand &MO = MI.getOperand(I);
+    if (!MO.isReg() || !TargetRegisterInfo::isVirtualRegister(MO.getReg()))
+      continue;
+    const TargetRegisterClass *RC = TII.getRegClass(Desc, I, &TRI, MF);
+    if (RC && !MRI.constrainRegClass(MO.getReg(), RC))
+      return false;
+  }
+  return true;
+}
+
+bool AArch64InstructionSelector::selectBinaryOp(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  unsigned Res = I.getOperand(0).getReg();
+  bool Is64Bit = getRegSize(MRI, Res) == 8;
+
+  unsigned Opc;
+  switch (I.getOpcode()) {
+  default: llvm_unreachable("Unexpected binary operation");
+  case TargetOpcode::G_ADD:
+    Opc = Is64Bit ? AArch64::ADDXrr : AArch64::ADDWrr;
+    break;
+  case TargetOpcode::G_SUB:
+    Opc = Is64Bit ? AArch64::SUBXrr : AArch64::SUBWrr;
+    break;
+  case TargetOpcode::G_MUL:
+    Opc = Is64Bit ? AArch64::MADDXrrr : AArch64::MADDWrrr;
+    break;
+  case TargetOpcode::G_AND:
+    Opc = Is64Bit ? AArch64::ANDXrr : AArch64::ANDWrr;
+    break;
+  case TargetOpcode::G_OR:
+    Opc = Is64Bit ? AArch64::ORRXrr : AArch64::ORRWrr;
+    break;
+  case TargetOpcode::G_XOR:
+    Opc = Is64Bit ? AArch64::EORXrr : AArch64::EORWrr;
+    break;
+  }
+
+  MachineInstrBuilder MIB =
+      BuildMI(MBB, II, I.getDebugLoc(), TII.get(Opc), Res)
+          .addReg(I.getOperand(1).getReg())
+          .addReg(I.getOperand(2).getReg());
+  // A multiply is a multiply-add of zero.
+  if (I.getOpcode() == TargetOpcode::G_MUL)
+    MIB.addReg(Is64Bit ? AArch64::XZR : AArch64::WZR);
+  I.eraseFromParent();
+  return constrainOperands(MIB);
+}
+
+bool AArch64InstructionSelector::selectConstant(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  unsigned Res = I.getOperand(0).getReg();
+  int64_t Imm = I.getOperand(1).getImm();
+
+  // The pseudos are expanded into the shortest sequence of moves.
+  unsigned Opc;
+  switch (getRegSize(MRI, Res)) {
+  default: return false;
+  case 4: Opc = AArch64::MOVi32imm; break;
+  case 8: Opc = AArch64::MOVi64imm; break;
+  }
+  MachineInstrBuilder MIB =
+      BuildMI(MBB, II, I.getDebugLoc(), TII.get(Opc), Res).addImm(Imm);
+  I.eraseFromParent();
+  return constrainOperands(MIB);
+}
+
+/// Return the condition code that holds after a compare for \p Pred.
+static AArch64CC::CondCode getCondCode(CmpInst::Predicate Pred) {
+  switch (Pred) {
+  default: return AArch64CC::Invalid;
+  case CmpInst::ICMP_EQ:  return AArch64CC::EQ;
+  case CmpInst::ICMP_NE:  return AArch64CC::NE;
+  case CmpInst::ICMP_UGT: return AArch64CC::HI;
+  case CmpInst::ICMP_UGE: return AArch64CC::HS;
+  case CmpInst::ICMP_ULT: return AArch64CC::LO;
+  case CmpInst::ICMP_ULE: return AArch64CC::LS;
+  case CmpInst::ICMP_SGT: return AArch64CC::GT;
+  case CmpInst::ICMP_SGE: return AArch64CC::GE;
+  case CmpInst::ICMP_SLT: return AArch64CC::LT;
+  case CmpInst::ICMP_SLE: return AArch64CC::LE;
+  }
+}
+
+bool AArch64InstructionSelector::selectICmp(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  DebugLoc DL = I.getDebugLoc();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op0 = I.getOperand(2).getReg();
+  unsigned Op1 = I.getOperand(3).getReg();
+  AArch64CC::CondCode CC =
+      getCondCode(CmpInst::Predicate(I.getOperand(1).getImm()));
+  if (CC == AArch64CC::Invalid)
+    return false;
+
+  // cmp Op0, Op1; cset Res, CC
+  bool Is64Bit = getRegSize(MRI, Op0) == 8;
+  MachineInstrBuilder Cmp =
+      BuildMI(MBB, II, DL,
+              TII.get(Is64Bit ? AArch64::SUBSXrr : AArch64::SUBSWrr),
+              Is64Bit ? AArch64::XZR : AArch64::WZR)
+          .addReg(Op0)
+          .addReg(Op1);
+  MachineInstrBuilder CSet =
+      BuildMI(MBB, II, DL, TII.get(AArch64::CSINCWr), Res)
+          .addReg(AArch64::WZR)
+          .addReg(AArch64::WZR)
+          .addImm(AArch64CC::getInvertedCondCode(CC));
+  I.eraseFromParent();
+  return constrainOperands(Cmp) && constrainOperands(CSet);
+}
+
+bool AArch64InstructionSelector::selectExt(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  DebugLoc DL = I.getDebugLoc();
+  bool IsZExt = I.getOpcode() == TargetOpcode::G_ZEXT;
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op = I.getOperand(1).getReg();
+  unsigned ResSize = getRegSize(MRI, Res);
+  unsigned OpSize = getRegSize(MRI, Op);
+
+  // Only booleans are extended within a register, and they are already 0 or
+  // 1.
+  if (OpSize == ResSize) {
+    if (!IsZExt)
+      return false;
+    BuildMI(MBB, II, DL, TII.get(TargetOpcode::COPY), Res).addReg(Op);
+    I.eraseFromParent();
+    return true;
+  }
+  if (OpSize != 4 || ResSize != 8)
+    return false;
+
+  // Writing a 32-bit register clears the upper half of its 64-bit register.
+  unsigned Op64 =
+      IsZExt ? Res : MRI.createVirtualRegister(&AArch64::GPR64RegClass);
+  BuildMI(MBB, II, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Op64)
+      .addImm(0)
+      .addReg(Op)
+      .addImm(AArch64::sub_32);
+  if (!IsZExt) {
+    // sxtw Res, Op
+    MachineInstrBuilder MIB =
+        BuildMI(MBB, II, DL, TII.get(AArch64::SBFMXri), Res)
+            .addReg(Op64)
+            .addImm(0)
+            .addImm(31);
+    if (!constrainOperands(MIB))
+      return false;
+  }
+  I.eraseFromParent();
+  return true;
+}
+
+bool AArch64InstructionSelector::selectTrunc(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op = I.getOperand(1).getReg();
+  if (getRegSize(MRI, Res) != 4 || getRegSize(MRI, Op) != 8)
+    return false;
+
+  // The truncation is a copy of the low part of the operand.
+  const TargetRegisterClass *RC =
+      TRI.getSubClassWithSubReg(MRI.getRegClass(Op), AArch64::sub_32);
+  if (!RC || !MRI.constrainRegClass(Op, RC))
+    return false;
+  BuildMI(MBB, II, I.getDebugLoc(), TII.get(TargetOpcode::COPY), Res)
+      .addReg(Op, 0, AArch64::sub_32);
+  I.eraseFromParent();
+  return true;
+}
+
+bool AArch64InstructionSelector::selectGlobalValue(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineFunction &MF = *MBB.getParent();
+  const AArch64Subtarget &STI = MF.getSubtarget<AArch64Subtarget>();
+  const TargetMachine &TM = MF.getTarget();
+  DebugLoc DL = I.getDebugLoc();
+  unsigned Res = I.getOperand(0).getReg();
+  const GlobalValue *GV = I.getOperand(1).getGlobal();
+  // ADRP only reaches everything in the small code model.
+  if (TM.getCodeModel() != CodeModel::Small)
+    return false;
+
+  // Either compute the address, or load it from the GOT.
+  unsigned char OpFlags = STI.ClassifyGlobalReference(GV, TM);
+  if (OpFlags != AArch64II::MO_NO_FLAG && OpFlags != AArch64II::MO_GOT)
+    return false;
+  unsigned ADRPReg =
+      MF.getRegInfo().createVirtualRegister(&AArch64::GPR64commonRegClass);
+  BuildMI(MBB, II, DL, TII.get(AArch64::ADRP), ADRPReg)
+      .addGlobalAddress(GV, 0, OpFlags | AArch64II::MO_PAGE);
+  MachineInstrBuilder MIB;
+  if (OpFlags == AArch64II::MO_GOT) {
+    MIB = BuildMI(MBB, II, DL, TII.get(AArch64::LDRXui), Res)
+              .addReg(ADRPReg)
+              .addGlobalAddress(GV, 0, AArch64II::MO_GOT |
+                                           AArch64II::MO_PAGEOFF |
+                                           AArch64II::MO_NC)
+              .addMemOperand(MF.getMachineMemOperand(
+                  MachinePointerInfo::getGOT(), MachineMemOperand::MOLoad, 8,
+                  8));
+  } else {
+    MIB = BuildMI(MBB, II, DL, TII.get(AArch64::ADDXri), Res)
+              .addReg(ADRPReg)
+              .addGlobalAddress(GV, 0,
+                                AArch64II::MO_PAGEOFF | AArch64II::MO_NC)
+              .addImm(0);
+  }
+  I.eraseFromParent();
+  return constrainOperands(MIB);
+}
+
+bool AArch64InstructionSelector::selectLoadStore(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  bool IsLoad = I.getOpcode() == TargetOpcode::G_LOAD;
+  unsigned Val = I.getOperand(0).getReg();
+  unsigned Addr = I.getOperand(1).getReg();
+  if (!I.hasOneMemOperand())
+    return false;
+
+  // Booleans live in 32-bit registers but take a byte in memory, which the
+  // byte load zero extends.
+  unsigned Size = (*I.memoperands_begin())->getSize();
+  unsigned Opc;
+  if (Size == 1 && getRegSize(MRI, Val) == 4)
+    Opc = IsLoad ? AArch64::LDRBBui : AArch64::STRBBui;
+  else if (Size != getRegSize(MRI, Val))
+    return false;
+  else if (Size == 4)
+    Opc = IsLoad ? AArch64::LDRWui : AArch64::STRWui;
+  else
+    Opc = IsLoad ? AArch64::LDRXui : AArch64::STRXui;
+
+  MachineInstrBuilder MIB =
+      IsLoad ? BuildMI(MBB, II, I.getDebugLoc(), TII.get(Opc), Val)
+             : BuildMI(MBB, II, I.getDebugLoc(), TII.get(Opc)).addReg(Val);
+  MIB.addReg(Addr).addImm(0).setMemRefs(I.memoperands_begin(),
+                                         I.memoperands_end());
+  I.eraseFromParent();
+  return constrainOperands(MIB);
+}
+
+bool AArch64InstructionSelector::select(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  switch (I.getOpcode()) {
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_SUB:
+  case TargetOpcode::G_MUL:
+  case TargetOpcode::G_AND:
+  case TargetOpcode::G_OR:
+  case TargetOpcode::G_XOR:
+    return selectBinaryOp(I);
+  case TargetOpcode::G_CONSTANT:
+    return selectConstant(I);
+  case TargetOpcode::G_ICMP:
+    return selectICmp(I);
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT:
+    return selectExt(I);
+  case TargetOpcode::G_TRUNC:
+    return selectTrunc(I);
+  case TargetOpcode::G_FRAME_INDEX: {
+    MachineInstrBuilder MIB =
+        BuildMI(MBB, II, I.getDebugLoc(), TII.get(AArch64::ADDXri),
+                I.getOperand(0).getReg())
+            .addFrameIndex(I.getOperand(1).getIndex())
+            .addImm(0)
+            .addImm(0);
+    I.eraseFromParent();
+    return constrainOperands(MIB);
+  }
+  case TargetOpcode::G_GLOBAL_VALUE:
+    return selectGlobalValue(I);
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    return selectLoadStore(I);
+  case TargetOpcode::G_BRCOND: {
+    // Booleans are always 0 or 1.
+    MachineInstrBuilder MIB =
+        BuildMI(MBB, II, I.getDebugLoc(), TII.get(AArch64::CBNZW))
+            .addReg(I.getOperand(0).getReg())
+            .addMBB(I.getOperand(1).getMBB());
+    I.eraseFromParent();
+    return constrainOperands(MIB);
+  }
+  case TargetOpcode::G_BR:
+    BuildMI(MBB, II, I.getDebugLoc(), TII.get(AArch64::B))
+        .addMBB(I.getOperand(0).getMBB());
+    I.eraseFromParent();
+    return true;
+  default:
+    return false;
+  }
+}
@@ -0,0 +1,53 @@
+//===- AArch64InstructionSelector.h - Select AArch64 instrs -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the instruction selector of the global instruction
+/// selector for AArch64.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_AARCH64_AARCH64INSTRUCTIONSELECTOR_H
+#define LLVM_LIB_TARGET_AARCH64_AARCH64INSTRUCTIONSELECTOR_H
+
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+
+namespace llvm {
+
+class AArch64InstrInfo;
+class AArch64RegisterInfo;
+class MachineInstrBuilder;
+
+class AArch64InstructionSelector : public InstructionSelector {
+  const AArch64InstrInfo &TII;
+  const AArch64RegisterInfo &TRI;
+
+public:
+  AArch64InstructionSelector(const AArch64InstrInfo &TII,
+                             const AArch64RegisterInfo &TRI);
+
+  bool select(MachineInstr &I) const override;
+
+private:
+  /// Narrow the register classes of the virtual registers used and defined
+  /// by the target instruction \p MIB to the ones its operands require.
+  bool constrainOperands(const MachineInstrBuilder &MIB) const;
+
+  bool selectBinaryOp(MachineInstr &I) const;
+  bool selectConstant(MachineInstr &I) const;
+  bool selectICmp(MachineInstr &I) const;
+  bool selectExt(MachineInstr &I) const;
+  bool selectTrunc(MachineInstr &I) const;
+  bool selectGlobalValue(MachineInstr &I) const;
+  bool selectLoadStore(MachineInstr &I) const;
+};
+
+} // End namespace llvm.
+
+#endif
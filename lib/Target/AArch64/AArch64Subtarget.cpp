@@ -52,7 +52,8 @@ AArch64Subtarget::AArch64Subtarget(const std::string &TT,
       HasZeroCycleRegMove(false), HasZeroCycleZeroing(false),
       IsLittle(LittleEndian), CPUString(CPU), TargetTriple(TT), FrameLowering(),
       InstrInfo(initializeSubtargetDependencies(FS)),
-      TSInfo(TM.getDataLayout()), TLInfo(TM, *this) {}
+      TSInfo(TM.getDataLayout()), TLInfo(TM, *this), CallLoweringInfo(&TLInfo),
+      InstSelector(InstrInfo, InstrInfo.getRegisterInfo()) {}
 
 /// ClassifyGlobalReference - Find the target operand flags that describe
 /// how a global value should be referenced for the current subtarget.
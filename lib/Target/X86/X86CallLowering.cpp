@@ -0,0 +1,265 @@
+//===-- X86CallLowering.cpp - Call lowering for GlobalISel ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the lowering of the arguments, the return value and
+/// the calls of X86 functions for the global instruction selector.
+///
+//===----------------------------------------------------------------------===//
+
+#include "X86CallLowering.h"
+#include "X86ISelLowering.h"
+#include "X86InstrInfo.h"
+#include "X86Subtarget.h"
+#include "llvm/CodeGen/GlobalISel/MachineIRBuilder.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Target/TargetMachine.h"
+using namespace llvm;
+
+// Only handle simple cases, i.e. up to 6 integer arguments in registers.
+static const MCPhysReg GPR8ArgRegs[] = {
+  X86::DIL, X86::SIL, X86::DL, X86::CL, X86::R8B, X86::R9B
+};
+static const MCPhysReg GPR16ArgRegs[] = {
+  X86::DI, X86::SI, X86::DX, X86::CX, X86::R8W, X86::R9W
+};
+static const MCPhysReg GPR32ArgRegs[] = {
+  X86::EDI, X86::ESI, X86::EDX, X86::ECX, X86::R8D, X86::R9D
+};
+static const MCPhysReg GPR64ArgRegs[] = {
+  X86::RDI, X86::RSI, X86::RDX, X86::RCX, X86::R8 , X86::R9
+};
+
+/// Return the register that holds the \p I-th integer argument of \p Size
+/// bytes, or 0.
+static unsigned getArgReg(unsigned I, unsigned Size) {
+  switch (Size) {
+  case 1: return GPR8ArgRegs[I];
+  case 2: return GPR16ArgRegs[I];
+  case 4: return GPR32ArgRegs[I];
+  case 8: return GPR64ArgRegs[I];
+  default: return 0;
+  }
+}
+
+/// Return the register that holds the returned integer of \p Size bytes, or
+/// 0.
+static unsigned getRetReg(unsigned Size) {
+  switch (Size) {
+  case 1: return X86::AL;
+  case 2: return X86::AX;
+  case 4: return X86::EAX;
+  case 8: return X86::RAX;
+  default: return 0;
+  }
+}
+
+X86CallLowering::X86CallLowering(const X86TargetLowering *TLI)
+    : CallLowering(TLI) {}
+
+bool X86CallLowering::isSupportedFunction(const MachineFunction &MF) const {
+  const Function &F = *MF.getFunction();
+  const X86Subtarget &Subtarget = MF.getSubtarget<X86Subtarget>();
+  CallingConv::ID CC = F.getCallingConv();
+  if (!Subtarget.is64Bit() || Subtarget.isCallingConvWin64(CC))
+    return false;
+  // fastcc with -tailcallopt makes the callee pop its arguments.
+  if (CC != CallingConv::C &&
+      (CC != CallingConv::Fast ||
+       MF.getTarget().Options.GuaranteedTailCallOpt))
+    return false;
+  return !F.isVarArg() && !F.hasStructRetAttr();
+}
+
+bool X86CallLowering::lowerFormalArguments(MachineIRBuilder &MIRBuilder,
+                                           const Function &F,
+                                           ArrayRef<unsigned> VRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (!isSupportedFunction(MF))
+    return false;
+
+  if (VRegs.size() > array_lengthof(GPR64ArgRegs))
+    return false;
+
+  const AttributeSet &Attrs = F.getAttributes();
+  unsigned Idx = 0;
+  for (const Argument &Arg : F.args()) {
+    // The first argument is at index 1.
+    if (Attrs.hasAttribute(Idx + 1, Attribute::ByVal) ||
+        Attrs.hasAttribute(Idx + 1, Attribute::InReg) ||
+        Attrs.hasAttribute(Idx + 1, Attribute::Nest))
+      return false;
+    // Booleans are only known to be 0 or 1 if the caller extended them.
+    if (Arg.getType()->isIntegerTy(1) &&
+        !Attrs.hasAttribute(Idx + 1, Attribute::ZExt))
+      return false;
+    ++Idx;
+  }
+
+  const MachineRegisterInfo &MRI = MF.getRegInfo();
+  MachineBasicBlock &MBB = MIRBuilder.getMBB();
+  for (unsigned I = 0, E = VRegs.size(); I != E; ++I) {
+    unsigned PhysReg = getArgReg(I, MRI.getRegClass(VRegs[I])->getSize());
+    if (!PhysReg)
+      return false;
+    MBB.addLiveIn(PhysReg);
+    MIRBuilder.buildCopy(VRegs[I], PhysReg);
+  }
+  return true;
+}
+
+bool X86CallLowering::lowerReturn(MachineIRBuilder &MIRBuilder,
+                                  const Value *Val, unsigned VReg) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  const Function &F = *MF.getFunction();
+  if (!isSupportedFunction(MF))
+    return false;
+
+  unsigned RetReg = 0;
+  if (Val) {
+    MachineRegisterInfo &MRI = MF.getRegInfo();
+    const AttributeSet &Attrs = F.getAttributes();
+    bool IsZExt =
+        Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::ZExt);
+    bool IsSExt =
+        Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::SExt);
+    unsigned Size = MRI.getRegClass(VReg)->getSize();
+    // Extended values are returned in EAX.
+    if ((IsZExt || IsSExt) && Size < 4) {
+      // Booleans are 0 or 1; sign extending one takes more than a move.
+      if (IsSExt && Val->getType()->isIntegerTy(1))
+        return false;
+      unsigned Opc;
+      if (Size == 1)
+        Opc = IsZExt ? X86::MOVZX32rr8 : X86::MOVSX32rr8;
+      else
+        Opc = IsZExt ? X86::MOVZX32rr16 : X86::MOVSX32rr16;
+      unsigned ExtReg = MRI.createVirtualRegister(&X86::GR32RegClass);
+      MIRBuilder.buildInstr(Opc, ExtReg).addReg(VReg);
+      VReg = ExtReg;
+      Size = 4;
+    }
+    RetReg = getRetReg(Size);
+    if (!RetReg)
+      return false;
+    MIRBuilder.buildCopy(RetReg, VReg);
+  }
+
+  MachineInstrBuilder MIB = MIRBuilder.buildInstr(X86::RETQ);
+  if (RetReg)
+    MIB.addReg(RetReg, RegState::Implicit);
+  return true;
+}
+
+bool X86CallLowering::lowerCall(MachineIRBuilder &MIRBuilder,
+                                const CallInst &CI, unsigned Callee,
+                                unsigned ResVReg,
+                                ArrayRef<unsigned> ArgVRegs) const {
+  MachineFunction &MF = MIRBuilder.getMF();
+  if (!isSupportedFunction(MF))
+    return false;
+  const X86Subtarget &Subtarget = MF.getSubtarget<X86Subtarget>();
+  const TargetMachine &TM = MF.getTarget();
+  CallingConv::ID CC = CI.getCallingConv();
+  if (CC != CallingConv::C &&
+      (CC != CallingConv::Fast || TM.Options.GuaranteedTailCallOpt))
+    return false;
+  if (ArgVRegs.size() > array_lengthof(GPR64ArgRegs) ||
+      TM.getCodeModel() != CodeModel::Small)
+    return false;
+
+  const GlobalValue *GV = nullptr;
+  unsigned char OpFlags = 0;
+  if (!Callee) {
+    GV = CI.getCalledFunction();
+    // Darwin stubs aren't handled.
+    if (Subtarget.isPICStyleStubAny())
+      return false;
+    // Calls to preemptible functions go through the PLT on ELF.
+    if (Subtarget.isTargetELF() && TM.getRelocationModel() == Reloc::PIC_ &&
+        GV->hasDefaultVisibility() && !GV->hasLocalLinkage())
+      OpFlags = X86II::MO_PLT;
+  }
+
+  const AttributeSet &Attrs = CI.getAttributes();
+  if (Attrs.hasAttribute(1, Attribute::StructRet))
+    return false;
+  for (unsigned I = 0, E = ArgVRegs.size(); I != E; ++I)
+    if (Attrs.hasAttribute(I + 1, Attribute::ByVal) ||
+        Attrs.hasAttribute(I + 1, Attribute::InReg) ||
+        Attrs.hasAttribute(I + 1, Attribute::Nest) ||
+        Attrs.hasAttribute(I + 1, Attribute::InAlloca))
+      return false;
+  // Booleans are only known to be 0 or 1 if the callee extended them.
+  if (ResVReg && CI.getType()->isIntegerTy(1) &&
+      !Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::ZExt))
+    return false;
+
+  // All the arguments are in registers, so the call frame is empty.
+  const X86InstrInfo &TII = *Subtarget.getInstrInfo();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  MIRBuilder.buildInstr(TII.getCallFrameSetupOpcode()).addImm(0).addImm(0);
+
+  SmallVector<unsigned, 6> ArgRegs;
+  for (unsigned I = 0, E = ArgVRegs.size(); I != E; ++I) {
+    unsigned VReg = ArgVRegs[I];
+    unsigned Size = MRI.getRegClass(VReg)->getSize();
+    bool IsZExt = Attrs.hasAttribute(I + 1, Attribute::ZExt);
+    bool IsSExt = Attrs.hasAttribute(I + 1, Attribute::SExt);
+    // Extended arguments are passed in 32-bit registers.
+    if ((IsZExt || IsSExt) && Size < 4) {
+      if (IsSExt && CI.getArgOperand(I)->getType()->isIntegerTy(1))
+        return false;
+      unsigned Opc;
+      if (Size == 1)
+        Opc = IsZExt ? X86::MOVZX32rr8 : X86::MOVSX32rr8;
+      else
+        Opc = IsZExt ? X86::MOVZX32rr16 : X86::MOVSX32rr16;
+      unsigned ExtReg = MRI.createVirtualRegister(&X86::GR32RegClass);
+      MIRBuilder.buildInstr(Opc, ExtReg).addReg(VReg);
+      VReg = ExtReg;
+      Size = 4;
+    }
+    unsigned PhysReg = getArgReg(I, Size);
+    if (!PhysReg)
+      return false;
+    MIRBuilder.buildCopy(PhysReg, VReg);
+    ArgRegs.push_back(PhysReg);
+  }
+  // A variadic callee expects the number of vector registers used in AL.
+  if (CI.getFunctionType()->isVarArg()) {
+    MIRBuilder.buildInstr(X86::MOV8ri, X86::AL).addImm(0);
+    ArgRegs.push_back(X86::AL);
+  }
+
+  MachineInstrBuilder MIB;
+  if (GV)
+    MIB = MIRBuilder.buildInstr(X86::CALL64pcrel32)
+              .addGlobalAddress(GV, 0, OpFlags);
+  else
+    MIB = MIRBuilder.buildInstr(X86::CALL64r).addReg(Callee);
+  MIB.addRegMask(Subtarget.getRegisterInfo()->getCallPreservedMask(MF, CC));
+  for (unsigned Reg : ArgRegs)
+    MIB.addReg(Reg, RegState::Implicit);
+  unsigned RetReg = 0;
+  if (ResVReg) {
+    RetReg = getRetReg(MRI.getRegClass(ResVReg)->getSize());
+    if (!RetReg)
+      return false;
+    MIB.addReg(RetReg, RegState::ImplicitDefine);
+  }
+
+  MIRBuilder.buildInstr(TII.getCallFrameDestroyOpcode()).addImm(0).addImm(0);
+  if (RetReg)
+    MIRBuilder.buildCopy(ResVReg, RetReg);
+  return true;
+}
@@ -0,0 +1,49 @@
+//===-- X86CallLowering.h - Call lowering for GlobalISel --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file describes how the global instruction selector lowers the
+/// arguments, the return value and the calls of X86 functions.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_X86_X86CALLLOWERING_H
+#define LLVM_LIB_TARGET_X86_X86CALLLOWERING_H
+
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+
+namespace llvm {
+
+class MachineFunction;
+class X86TargetLowering;
+
+/// Only handles functions and calls of the 64-bit System V calling convention
+/// whose arguments and return value are integers passed in registers.
+class X86CallLowering : public CallLowering {
+public:
+  X86CallLowering(const X86TargetLowering *TLI);
+
+  bool lowerFormalArguments(MachineIRBuilder &MIRBuilder, const Function &F,
+                            ArrayRef<unsigned> VRegs) const override;
+
+  bool lowerReturn(MachineIRBuilder &MIRBuilder, const Value *Val,
+                   unsigned VReg) const override;
+
+  bool lowerCall(MachineIRBuilder &MIRBuilder, const CallInst &CI,
+                 unsigned Callee, unsigned ResVReg,
+                 ArrayRef<unsigned> ArgVRegs) const override;
+
+private:
+  /// Return true if the calling convention of \p MF is handled by this class.
+  bool isSupportedFunction(const MachineFunction &MF) const;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -110,6 +110,8 @@ private:
 
   bool X86SelectBranch(const Instruction *I);
 
+  bool X86SelectSwitch(const Instruction *I);
+
   bool X86SelectShift(const Instruction *I);
 
   bool X86SelectDivRem(const Instruction *I);
@@ -131,6 +133,12 @@ private:
   bool X86SelectFPTrunc(const Instruction *I);
   bool X86SelectSIToFP(const Instruction *I);
 
+  bool X86SelectExtractElement(const Instruction *I);
+
+  bool X86SelectFence(const Instruction *I);
+  bool X86SelectAtomicRMW(const Instruction *I);
+  bool X86SelectCmpXchg(const Instruction *I);
+
   const X86InstrInfo *getInstrInfo() const {
     return Subtarget->getInstrInfo();
   }
@@ -143,6 +151,9 @@ private:
   unsigned X86MaterializeInt(const ConstantInt *CI, MVT VT);
   unsigned X86MaterializeFP(const ConstantFP *CFP, MVT VT);
   unsigned X86MaterializeGV(const GlobalValue *GV, MVT VT);
+  unsigned X86MaterializeVector(const Constant *C, MVT VT);
+  unsigned X86MaterializeFromConstantPool(const Constant *C, unsigned Opc,
+                                          const TargetRegisterClass *RC);
   unsigned fastMaterializeConstant(const Constant *C) override;
 
   unsigned fastMaterializeAlloca(const AllocaInst *C) override;
@@ -158,6 +169,11 @@ private:
 
   bool isTypeLegal(Type *Ty, MVT &VT, bool AllowI1 = false);
 
+  bool isSimpleAtomicAccess(Type *Ty, unsigned Alignment);
+
+  MachineMemOperand *getAtomicMemOperand(const Value *Ptr, MVT VT,
+                                         unsigned Flags);
+
   bool IsMemcpySmall(uint64_t Len);
 
   bool TryEmitSmallMemcpy(X86AddressMode DestAM,
@@ -338,6 +354,26 @@ bool X86FastISel::isTypeLegal(Type *Ty, MVT &VT, bool AllowI1) {
   return (AllowI1 && VT == MVT::i1) || TLI.isTypeLegal(VT);
 }
 
+/// isSimpleAtomicAccess - Return true if an atomic load or store of the
+/// specified type and alignment is an ordinary MOV, which is the case for
+/// naturally aligned integers and pointers no wider than a register.
+bool X86FastISel::isSimpleAtomicAccess(Type *Ty, unsigned Alignment) {
+  MVT VT;
+  return isTypeLegal(Ty, VT) && VT.isInteger() &&
+         Alignment >= VT.getStoreSize();
+}
+
+/// getAtomicMemOperand - Return the memory operand of an atomic
+/// read-modify-write access of type VT to Ptr. Like SelectionDAG, mark it
+/// volatile so that nothing moves other memory accesses across it.
+MachineMemOperand *X86FastISel::getAtomicMemOperand(const Value *Ptr, MVT VT,
+                                                    unsigned Flags) {
+  unsigned Size = VT.getStoreSize();
+  return FuncInfo.MF->getMachineMemOperand(
+      MachinePointerInfo(Ptr), Flags | MachineMemOperand::MOVolatile, Size,
+      Size);
+}
+
 #include "X86GenCallingConv.inc"
 
 /// X86FastEmitLoad - Emit a machine instruction to load a value of type VT.
@@ -935,15 +971,46 @@ bool X86FastISel::X86SelectCallAddress(const Value *V, X86AddressMode &AM) {
 
 /// X86SelectStore - Select and emit code to implement store instructions.
 bool X86FastISel::X86SelectStore(const Instruction *I) {
-  // Atomic stores need special handling.
   const StoreInst *S = cast<StoreInst>(I);
-
-  if (S->isAtomic())
-    return false;
-
   const Value *Val = S->getValueOperand();
   const Value *Ptr = S->getPointerOperand();
 
+  // Aligned atomic stores are plain MOVs, except that a sequentially
+  // consistent one also needs a full barrier. XCHG provides both.
+  if (S->isAtomic()) {
+    if (!isSimpleAtomicAccess(Val->getType(), S->getAlignment()))
+      return false;
+    if (S->getOrdering() == SequentiallyConsistent) {
+      MVT VT;
+      if (!isTypeLegal(Val->getType(), VT))
+        return false;
+      unsigned Opc;
+      switch (VT.SimpleTy) {
+      default: return false;
+      case MVT::i8:  Opc = X86::XCHG8rm;  break;
+      case MVT::i16: Opc = X86::XCHG16rm; break;
+      case MVT::i32: Opc = X86::XCHG32rm; break;
+      case MVT::i64: Opc = X86::XCHG64rm; break;
+      }
+      unsigned ValReg = getRegForValue(Val);
+      if (ValReg == 0)
+        return false;
+      bool ValIsKill = hasTrivialKill(Val);
+
+      X86AddressMode AM;
+      if (!X86SelectAddress(Ptr, AM))
+        return false;
+
+      unsigned ResultReg = createResultReg(TLI.getRegClassFor(VT));
+      MachineInstrBuilder MIB =
+          BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc),
+                  ResultReg).addReg(ValReg, getKillRegState(ValIsKill));
+      addFullAddress(MIB, AM).addMemOperand(getAtomicMemOperand(
+          Ptr, VT, MachineMemOperand::MOLoad | MachineMemOperand::MOStore));
+      return true;
+    }
+  }
+
   MVT VT;
   if (!isTypeLegal(Val->getType(), VT, /*AllowI1=*/true))
     return false;
@@ -1096,8 +1163,9 @@ bool X86FastISel::X86SelectRet(const Instruction *I) {
 bool X86FastISel::X86SelectLoad(const Instruction *I) {
   const LoadInst *LI = cast<LoadInst>(I);
 
-  // Atomic loads need special handling.
-  if (LI->isAtomic())
+  // Aligned atomic loads are plain MOVs.
+  if (LI->isAtomic() &&
+      !isSimpleAtomicAccess(LI->getType(), LI->getAlignment()))
     return false;
 
   MVT VT;
@@ -1518,6 +1586,99 @@ bool X86FastISel::X86SelectBranch(const Instruction *I) {
   return true;
 }
 
+/// X86SelectSwitch - Select a switch whose cases all go to the same block and
+/// cover a contiguous range of values, which takes a single compare. Other
+/// switches are lowered to a chain of compares in blocks of their own, which
+/// is left to SelectionDAG.
+bool X86FastISel::X86SelectSwitch(const Instruction *I) {
+  const SwitchInst *SI = cast<SwitchInst>(I);
+  const Value *Cond = SI->getCondition();
+  MVT VT;
+  if (!isTypeLegal(Cond->getType(), VT) || !VT.isInteger())
+    return false;
+
+  const BasicBlock *CaseBB = nullptr;
+  APInt Low, High;
+  for (auto Case : SI->cases()) {
+    const APInt &Val = Case.getCaseValue()->getValue();
+    if (!CaseBB) {
+      CaseBB = Case.getCaseSuccessor();
+      Low = High = Val;
+      continue;
+    }
+    if (Case.getCaseSuccessor() != CaseBB)
+      return false;
+    if (Val.slt(Low))
+      Low = Val;
+    if (Val.sgt(High))
+      High = Val;
+  }
+
+  const BasicBlock *BB = SI->getParent();
+  if (CaseBB) {
+    // Case values are unique, so they are contiguous if there are as many of
+    // them as values in [Low, High].
+    APInt Range = High - Low;
+    if (Range.getZExtValue() != SI->getNumCases() - 1)
+      return false;
+
+    unsigned BranchOpc;
+    if (Range == 0) {
+      const ConstantInt *CaseVal = SI->case_begin().getCaseValue();
+      if (!X86FastEmitCompare(Cond, CaseVal, VT, DbgLoc))
+        return false;
+      BranchOpc = X86::JE_1;
+    } else {
+      // Branch to the case block if (Cond - Low) <=u (High - Low).
+      unsigned CondReg = getRegForValue(Cond);
+      if (CondReg == 0)
+        return false;
+      bool CondIsKill = hasTrivialKill(Cond);
+      if (Low != 0) {
+        CondReg = fastEmit_ri_(VT, ISD::SUB, CondReg, CondIsKill,
+                               Low.getSExtValue(), VT);
+        if (CondReg == 0)
+          return false;
+      }
+
+      const ConstantInt *RangeC = ConstantInt::get(SI->getContext(), Range);
+      if (unsigned CmpOpc = X86ChooseCmpImmediateOpcode(VT, RangeC)) {
+        BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(CmpOpc))
+          .addReg(CondReg)
+          .addImm(RangeC->getSExtValue());
+      } else {
+        unsigned RangeReg = getRegForValue(RangeC);
+        if (RangeReg == 0)
+          return false;
+        BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+                TII.get(X86ChooseCmpOpcode(VT, Subtarget)))
+          .addReg(CondReg)
+          .addReg(RangeReg);
+      }
+      BranchOpc = X86::JBE_1;
+    }
+
+    MachineBasicBlock *CaseMBB = FuncInfo.MBBMap[CaseBB];
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(BranchOpc))
+      .addMBB(CaseMBB);
+    uint32_t BranchWeight = 0;
+    if (FuncInfo.BPI)
+      BranchWeight = FuncInfo.BPI->getEdgeWeight(BB, CaseBB);
+    FuncInfo.MBB->addSuccessor(CaseMBB, BranchWeight);
+  }
+
+  // Branch to the default block, unless it is also the case block.
+  MachineBasicBlock *DefaultMBB = FuncInfo.MBBMap[SI->getDefaultDest()];
+  if (FuncInfo.MBB->isSuccessor(DefaultMBB)) {
+    if (!FuncInfo.MBB->isLayoutSuccessor(DefaultMBB))
+      TII.InsertBranch(*FuncInfo.MBB, DefaultMBB, nullptr,
+                       SmallVector<MachineOperand, 0>(), DbgLoc);
+    return true;
+  }
+  fastEmitBranch(DefaultMBB, DbgLoc);
+  return true;
+}
+
 bool X86FastISel::X86SelectShift(const Instruction *I) {
   unsigned CReg = 0, OpReg = 0;
   const TargetRegisterClass *RC = nullptr;
@@ -2209,6 +2370,290 @@ bool X86FastISel::X86SelectTrunc(const Instruction *I) {
   return true;
 }
 
+/// X86SelectExtractElement - Select an extract of the lowest element of a
+/// 128-bit vector, which is either the same register or a single move.
+bool X86FastISel::X86SelectExtractElement(const Instruction *I) {
+  const auto *Idx = dyn_cast<ConstantInt>(I->getOperand(1));
+  if (!Idx || !Idx->isZero() || Subtarget->hasAVX512())
+    return false;
+
+  MVT VecVT, VT;
+  if (!isTypeLegal(I->getOperand(0)->getType(), VecVT) ||
+      !isTypeLegal(I->getType(), VT) || VecVT.getSizeInBits() != 128)
+    return false;
+
+  unsigned Opc;
+  const TargetRegisterClass *RC;
+  bool HasAVX = Subtarget->hasAVX();
+  switch (VT.SimpleTy) {
+  default: return false;
+  case MVT::f32:
+    Opc = TargetOpcode::COPY;
+    RC = &X86::FR32RegClass;
+    break;
+  case MVT::f64:
+    Opc = TargetOpcode::COPY;
+    RC = &X86::FR64RegClass;
+    break;
+  case MVT::i32:
+    Opc = HasAVX ? X86::VMOVPDI2DIrr : X86::MOVPDI2DIrr;
+    RC = &X86::GR32RegClass;
+    break;
+  case MVT::i64:
+    Opc = HasAVX ? X86::VMOVPQIto64rr : X86::MOVPQIto64rr;
+    RC = &X86::GR64RegClass;
+    break;
+  }
+
+  unsigned VecReg = getRegForValue(I->getOperand(0));
+  if (VecReg == 0)
+    return false;
+  bool VecIsKill = hasTrivialKill(I->getOperand(0));
+
+  unsigned ResultReg = createResultReg(RC);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc), ResultReg)
+    .addReg(VecReg, getKillRegState(VecIsKill));
+  updateValueMap(I, ResultReg);
+  return true;
+}
+
+bool X86FastISel::X86SelectFence(const Instruction *I) {
+  const FenceInst *FI = cast<FenceInst>(I);
+
+  // Only a sequentially consistent fence between threads needs a barrier
+  // instruction; the others merely keep memory accesses from being moved
+  // across them by the compiler.
+  if (FI->getOrdering() == SequentiallyConsistent &&
+      FI->getSynchScope() == CrossThread) {
+    // Without MFENCE, leave it to SelectionDAG, which uses a locked OR.
+    if (!Subtarget->hasSSE2() && !Subtarget->is64Bit())
+      return false;
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(X86::MFENCE));
+    return true;
+  }
+
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+          TII.get(X86::Int_MemBarrier));
+  return true;
+}
+
+bool X86FastISel::X86SelectAtomicRMW(const Instruction *I) {
+  const AtomicRMWInst *RMWI = cast<AtomicRMWInst>(I);
+  MVT VT;
+  if (!isTypeLegal(RMWI->getType(), VT) || !VT.isInteger())
+    return false;
+
+  unsigned SizeIdx;
+  switch (VT.SimpleTy) {
+  default: return false;
+  case MVT::i8:  SizeIdx = 0; break;
+  case MVT::i16: SizeIdx = 1; break;
+  case MVT::i32: SizeIdx = 2; break;
+  case MVT::i64: SizeIdx = 3; break;
+  }
+
+  const Value *Ptr = RMWI->getPointerOperand();
+  const Value *Val = RMWI->getValOperand();
+  MachineMemOperand *MMO = getAtomicMemOperand(
+      Ptr, VT, MachineMemOperand::MOLoad | MachineMemOperand::MOStore);
+  AtomicRMWInst::BinOp Op = RMWI->getOperation();
+
+  // If the old value isn't used, arithmetic and logic operations are locked
+  // instructions on memory, like SelectionDAG selects them.
+  if (RMWI->use_empty() &&
+      (Op == AtomicRMWInst::Add || Op == AtomicRMWInst::Sub ||
+       Op == AtomicRMWInst::And || Op == AtomicRMWInst::Or ||
+       Op == AtomicRMWInst::Xor)) {
+    // Indexed by operation, size, and form of the operand: register,
+    // immediate, or sign-extended 8-bit immediate.
+    static const unsigned LockOpc[5][4][3] = {
+      { { X86::LOCK_ADD8mr,  X86::LOCK_ADD8mi,    X86::LOCK_ADD8mi },
+        { X86::LOCK_ADD16mr, X86::LOCK_ADD16mi,   X86::LOCK_ADD16mi8 },
+        { X86::LOCK_ADD32mr, X86::LOCK_ADD32mi,   X86::LOCK_ADD32mi8 },
+        { X86::LOCK_ADD64mr, X86::LOCK_ADD64mi32, X86::LOCK_ADD64mi8 } },
+      { { X86::LOCK_SUB8mr,  X86::LOCK_SUB8mi,    X86::LOCK_SUB8mi },
+        { X86::LOCK_SUB16mr, X86::LOCK_SUB16mi,   X86::LOCK_SUB16mi8 },
+        { X86::LOCK_SUB32mr, X86::LOCK_SUB32mi,   X86::LOCK_SUB32mi8 },
+        { X86::LOCK_SUB64mr, X86::LOCK_SUB64mi32, X86::LOCK_SUB64mi8 } },
+      { { X86::LOCK_AND8mr,  X86::LOCK_AND8mi,    X86::LOCK_AND8mi },
+        { X86::LOCK_AND16mr, X86::LOCK_AND16mi,   X86::LOCK_AND16mi8 },
+        { X86::LOCK_AND32mr, X86::LOCK_AND32mi,   X86::LOCK_AND32mi8 },
+        { X86::LOCK_AND64mr, X86::LOCK_AND64mi32, X86::LOCK_AND64mi8 } },
+      { { X86::LOCK_OR8mr,   X86::LOCK_OR8mi,     X86::LOCK_OR8mi },
+        { X86::LOCK_OR16mr,  X86::LOCK_OR16mi,    X86::LOCK_OR16mi8 },
+        { X86::LOCK_OR32mr,  X86::LOCK_OR32mi,    X86::LOCK_OR32mi8 },
+        { X86::LOCK_OR64mr,  X86::LOCK_OR64mi32,  X86::LOCK_OR64mi8 } },
+      { { X86::LOCK_XOR8mr,  X86::LOCK_XOR8mi,    X86::LOCK_XOR8mi },
+        { X86::LOCK_XOR16mr, X86::LOCK_XOR16mi,   X86::LOCK_XOR16mi8 },
+        { X86::LOCK_XOR32mr, X86::LOCK_XOR32mi,   X86::LOCK_XOR32mi8 },
+        { X86::LOCK_XOR64mr, X86::LOCK_XOR64mi32, X86::LOCK_XOR64mi8 } }
+    };
+    static const unsigned LockIncOpc[] = {
+      X86::LOCK_INC8m, X86::LOCK_INC16m, X86::LOCK_INC32m, X86::LOCK_INC64m
+    };
+    static const unsigned LockDecOpc[] = {
+      X86::LOCK_DEC8m, X86::LOCK_DEC16m, X86::LOCK_DEC32m, X86::LOCK_DEC64m
+    };
+
+    unsigned OpIdx;
+    switch (Op) {
+    default: llvm_unreachable("Unexpected atomicrmw operation!");
+    case AtomicRMWInst::Add: OpIdx = 0; break;
+    case AtomicRMWInst::Sub: OpIdx = 1; break;
+    case AtomicRMWInst::And: OpIdx = 2; break;
+    case AtomicRMWInst::Or:  OpIdx = 3; break;
+    case AtomicRMWInst::Xor: OpIdx = 4; break;
+    }
+
+    const auto *CI = dyn_cast<ConstantInt>(Val);
+    if (CI && isInt<32>(CI->getSExtValue())) {
+      int64_t Imm = CI->getSExtValue();
+      // Canonicalize adding and subtracting a constant to the form with a
+      // positive immediate, or to an increment or decrement.
+      if (OpIdx <= 1 && Imm != INT32_MIN) {
+        if (OpIdx == 1) {
+          OpIdx = 0;
+          Imm = -Imm;
+        }
+        if ((Imm == 1 || Imm == -1) && !Subtarget->slowIncDec()) {
+          X86AddressMode AM;
+          if (!X86SelectAddress(Ptr, AM))
+            return false;
+          unsigned Opc = Imm == 1 ? LockIncOpc[SizeIdx] : LockDecOpc[SizeIdx];
+          MachineInstrBuilder MIB =
+              BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc));
+          addFullAddress(MIB, AM).addMemOperand(MMO);
+          return true;
+        }
+        if (Imm < 0) {
+          OpIdx = 1;
+          Imm = -Imm;
+        }
+      }
+
+      X86AddressMode AM;
+      if (!X86SelectAddress(Ptr, AM))
+        return false;
+      unsigned Opc = LockOpc[OpIdx][SizeIdx][isInt<8>(Imm) ? 2 : 1];
+      MachineInstrBuilder MIB =
+          BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc));
+      addFullAddress(MIB, AM).addImm(Imm).addMemOperand(MMO);
+      return true;
+    }
+
+    unsigned ValReg = getRegForValue(Val);
+    if (ValReg == 0)
+      return false;
+    bool ValIsKill = hasTrivialKill(Val);
+
+    X86AddressMode AM;
+    if (!X86SelectAddress(Ptr, AM))
+      return false;
+    MachineInstrBuilder MIB =
+        BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+                TII.get(LockOpc[OpIdx][SizeIdx][0]));
+    addFullAddress(MIB, AM)
+      .addReg(ValReg, getKillRegState(ValIsKill))
+      .addMemOperand(MMO);
+    return true;
+  }
+
+  // Exchange, add and subtract each map to a single locked instruction that
+  // returns the old value. Anything else needs a cmpxchg loop.
+  static const unsigned XchgOpc[] = {
+    X86::XCHG8rm, X86::XCHG16rm, X86::XCHG32rm, X86::XCHG64rm
+  };
+  static const unsigned XAddOpc[] = {
+    X86::LXADD8, X86::LXADD16, X86::LXADD32, X86::LXADD64
+  };
+  static const unsigned NegOpc[] = {
+    X86::NEG8r, X86::NEG16r, X86::NEG32r, X86::NEG64r
+  };
+
+  unsigned Opc;
+  switch (Op) {
+  default: return false;
+  case AtomicRMWInst::Xchg: Opc = XchgOpc[SizeIdx]; break;
+  case AtomicRMWInst::Add:
+  case AtomicRMWInst::Sub:  Opc = XAddOpc[SizeIdx]; break;
+  }
+
+  unsigned ValReg = getRegForValue(Val);
+  if (ValReg == 0)
+    return false;
+  bool ValIsKill = hasTrivialKill(Val);
+
+  X86AddressMode AM;
+  if (!X86SelectAddress(Ptr, AM))
+    return false;
+
+  const TargetRegisterClass *RC = TLI.getRegClassFor(VT);
+  if (Op == AtomicRMWInst::Sub) {
+    ValReg = fastEmitInst_r(NegOpc[SizeIdx], RC, ValReg, ValIsKill);
+    ValIsKill = true;
+  }
+
+  unsigned ResultReg = createResultReg(RC);
+  MachineInstrBuilder MIB =
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc),
+              ResultReg).addReg(ValReg, getKillRegState(ValIsKill));
+  addFullAddress(MIB, AM).addMemOperand(MMO);
+  updateValueMap(I, ResultReg);
+  return true;
+}
+
+bool X86FastISel::X86SelectCmpXchg(const Instruction *I) {
+  const AtomicCmpXchgInst *CXI = cast<AtomicCmpXchgInst>(I);
+  const Value *Cmp = CXI->getCompareOperand();
+  const Value *New = CXI->getNewValOperand();
+  MVT VT;
+  if (!isTypeLegal(Cmp->getType(), VT) || !VT.isInteger())
+    return false;
+
+  unsigned Opc, AccReg;
+  switch (VT.SimpleTy) {
+  default: return false;
+  case MVT::i8:  Opc = X86::LCMPXCHG8;  AccReg = X86::AL;  break;
+  case MVT::i16: Opc = X86::LCMPXCHG16; AccReg = X86::AX;  break;
+  case MVT::i32: Opc = X86::LCMPXCHG32; AccReg = X86::EAX; break;
+  case MVT::i64: Opc = X86::LCMPXCHG64; AccReg = X86::RAX; break;
+  }
+
+  unsigned CmpReg = getRegForValue(Cmp);
+  if (CmpReg == 0)
+    return false;
+  unsigned NewReg = getRegForValue(New);
+  if (NewReg == 0)
+    return false;
+  bool NewIsKill = hasTrivialKill(New);
+
+  X86AddressMode AM;
+  if (!X86SelectAddress(CXI->getPointerOperand(), AM))
+    return false;
+
+  // CMPXCHG compares with and returns the old value in the accumulator.
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+          TII.get(TargetOpcode::COPY), AccReg).addReg(CmpReg);
+  MachineInstrBuilder MIB =
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(Opc));
+  addFullAddress(MIB, AM)
+    .addReg(NewReg, getKillRegState(NewIsKill))
+    .addMemOperand(getAtomicMemOperand(
+        CXI->getPointerOperand(), VT,
+        MachineMemOperand::MOLoad | MachineMemOperand::MOStore));
+
+  // The {value, success} result lives in two consecutive registers.
+  unsigned ResultReg = createResultReg(TLI.getRegClassFor(VT));
+  unsigned SuccessReg = createResultReg(&X86::GR8RegClass);
+  assert((ResultReg + 1) == SuccessReg && "Nonconsecutive result registers.");
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc,
+          TII.get(TargetOpcode::COPY), ResultReg).addReg(AccReg);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(X86::SETEr),
+          SuccessReg);
+  updateValueMap(I, ResultReg, 2);
+  return true;
+}
+
 bool X86FastISel::IsMemcpySmall(uint64_t Len) {
   return Len <= (Subtarget->is64Bit() ? 32 : 16);
 }
@@ -2371,11 +2816,10 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
   }
   case Intrinsic::memcpy: {
     const MemCpyInst *MCI = cast<MemCpyInst>(II);
-    // Don't handle volatile or variable length memcpys.
-    if (MCI->isVolatile())
-      return false;
-
-    if (isa<ConstantInt>(MCI->getLength())) {
+    // Expand small constant-length memcpys inline. The expansion doesn't
+    // mark its accesses volatile, so volatile ones go to the library call,
+    // as SelectionDAG does for those it doesn't expand.
+    if (!MCI->isVolatile() && isa<ConstantInt>(MCI->getLength())) {
       // Small memcpy's are common enough that we want to do them
       // without a call if possible.
       uint64_t Len = cast<ConstantInt>(MCI->getLength())->getZExtValue();
@@ -2398,12 +2842,21 @@ bool X86FastISel::fastLowerIntrinsicCall(const IntrinsicInst *II) {
 
     return lowerCallTo(II, "memcpy", II->getNumArgOperands() - 2);
   }
-  case Intrinsic::memset: {
-    const MemSetInst *MSI = cast<MemSetInst>(II);
+  case Intrinsic::memmove: {
+    const MemMoveInst *MMI = cast<MemMoveInst>(II);
 
-    if (MSI->isVolatile())
+    unsigned SizeWidth = Subtarget->is64Bit() ? 64 : 32;
+    if (!MMI->getLength()->getType()->isIntegerTy(SizeWidth))
       return false;
 
+    if (MMI->getSourceAddressSpace() > 255 || MMI->getDestAddressSpace() > 255)
+      return false;
+
+    return lowerCallTo(II, "memmove", II->getNumArgOperands() - 2);
+  }
+  case Intrinsic::memset: {
+    const MemSetInst *MSI = cast<MemSetInst>(II);
+
     unsigned SizeWidth = Subtarget->is64Bit() ? 64 : 32;
     if (!MSI->getLength()->getType()->isIntegerTy(SizeWidth))
       return false;
@@ -3237,6 +3690,16 @@ X86FastISel::fastSelectInstruction(const Instruction *I)  {
     return X86SelectFPTrunc(I);
   case Instruction::SIToFP:
     return X86SelectSIToFP(I);
+  case Instruction::Switch:
+    return X86SelectSwitch(I);
+  case Instruction::ExtractElement:
+    return X86SelectExtractElement(I);
+  case Instruction::Fence:
+    return X86SelectFence(I);
+  case Instruction::AtomicRMW:
+    return X86SelectAtomicRMW(I);
+  case Instruction::AtomicCmpXchg:
+    return X86SelectCmpXchg(I);
   case Instruction::IntToPtr: // Deliberate fall-through.
   case Instruction::PtrToInt: {
     EVT SrcVT = TLI.getValueType(I->getOperand(0)->getType());
@@ -3348,11 +3811,73 @@ unsigned X86FastISel::X86MaterializeFP(const ConstantFP *CFP, MVT VT) {
     return 0;
   }
 
+  return X86MaterializeFromConstantPool(CFP, Opc, RC);
+}
+
+/// X86MaterializeVector - Materialize a 128-bit or 256-bit vector constant,
+/// zero with an xor idiom and anything else with a load from the constant
+/// pool.
+unsigned X86FastISel::X86MaterializeVector(const Constant *C, MVT VT) {
+  if (!VT.isVector() || !TLI.isTypeLegal(VT) || Subtarget->hasAVX512())
+    return 0;
+  if (!isa<ConstantAggregateZero>(C) && !isa<ConstantDataVector>(C) &&
+      !isa<ConstantVector>(C))
+    return 0;
+
+  // Load in the domain of the element type, as SelectionDAG does.
+  bool HasAVX = Subtarget->hasAVX();
+  MVT EltVT = VT.getVectorElementType();
+  unsigned ZeroOpc, LoadOpc;
+  switch (VT.getSizeInBits()) {
+  default: return 0;
+  case 128:
+    ZeroOpc = X86::V_SET0;
+    if (EltVT == MVT::f32)
+      LoadOpc = HasAVX ? X86::VMOVAPSrm : X86::MOVAPSrm;
+    else if (EltVT == MVT::f64)
+      LoadOpc = HasAVX ? X86::VMOVAPDrm : X86::MOVAPDrm;
+    else
+      LoadOpc = HasAVX ? X86::VMOVDQArm : X86::MOVDQArm;
+    break;
+  case 256:
+    ZeroOpc = X86::AVX_SET0;
+    if (EltVT == MVT::f64)
+      LoadOpc = X86::VMOVAPDYrm;
+    else if (EltVT.isInteger() && Subtarget->hasAVX2())
+      LoadOpc = X86::VMOVDQAYrm;
+    else
+      LoadOpc = X86::VMOVAPSYrm;
+    break;
+  }
+
+  const TargetRegisterClass *RC = TLI.getRegClassFor(VT);
+  if (C->isNullValue()) {
+    unsigned ResultReg = createResultReg(RC);
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DbgLoc, TII.get(ZeroOpc),
+            ResultReg);
+    return ResultReg;
+  }
+
+  // Can't handle alternate code models yet.
+  CodeModel::Model CM = TM.getCodeModel();
+  if (CM != CodeModel::Small && CM != CodeModel::Large)
+    return 0;
+
+  return X86MaterializeFromConstantPool(C, LoadOpc, RC);
+}
+
+/// X86MaterializeFromConstantPool - Load the constant C from the constant pool
+/// into a new register of class RC with the load instruction Opc.
+unsigned
+X86FastISel::X86MaterializeFromConstantPool(const Constant *C, unsigned Opc,
+                                            const TargetRegisterClass *RC) {
+  CodeModel::Model CM = TM.getCodeModel();
+
   // MachineConstantPool wants an explicit alignment.
-  unsigned Align = DL.getPrefTypeAlignment(CFP->getType());
+  unsigned Align = DL.getPrefTypeAlignment(C->getType());
   if (Align == 0) {
     // Alignment of vector types. FIXME!
-    Align = DL.getTypeAllocSize(CFP->getType());
+    Align = DL.getTypeAllocSize(C->getType());
   }
 
   // x86-32 PIC requires a PIC base register for constant pools.
@@ -3370,7 +3895,7 @@ unsigned X86FastISel::X86MaterializeFP(const ConstantFP *CFP, MVT VT) {
   }
 
   // Create the load from the constant pool.
-  unsigned CPI = MCP.getConstantPoolIndex(CFP, Align);
+  unsigned CPI = MCP.getConstantPoolIndex(C, Align);
   unsigned ResultReg = createResultReg(RC);
 
   if (CM == CodeModel::Large) {
@@ -3443,6 +3968,8 @@ unsigned X86FastISel::fastMaterializeConstant(const Constant *C) {
     return X86MaterializeFP(CFP, VT);
   else if (const GlobalValue *GV = dyn_cast<GlobalValue>(C))
     return X86MaterializeGV(GV, VT);
+  else if (VT.isVector())
+    return X86MaterializeVector(C, VT);
 
   return 0;
 }
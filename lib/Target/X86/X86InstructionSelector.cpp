@@ -0,0 +1,366 @@
+//===-- X86InstructionSelector.cpp - Select X86 instructions --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file implements the selection of the generic instructions into X86
+/// instructions for the global instruction selector. The type of a generic
+/// instruction is given by the size of the register class of its registers.
+///
+//===----------------------------------------------------------------------===//
+
+#include "X86InstructionSelector.h"
+#include "X86InstrBuilder.h"
+#include "X86InstrInfo.h"
+#include "X86RegisterInfo.h"
+#include "X86Subtarget.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Target/TargetOpcodes.h"
+using namespace llvm;
+
+X86InstructionSelector::X86InstructionSelector(const X86InstrInfo &TII,
+                                               const X86RegisterInfo &TRI)
+    : TII(TII), TRI(TRI) {}
+
+/// Return the size in bytes of the values held in \p Reg.
+static unsigned getRegSize(const MachineRegisterInfo &MRI, unsigned Reg) {
+  return MRI.getRegClass(Reg)->getSize();
+}
+
+/// Return the index of \p Size in the tables of opcodes for 8, 16, 32 and
+/// 64-bit operations below.
+static unsigned getSizeIndex(unsigned Size) {
+  assert(isPowerOf2_32(Size) && Size <= 8 && "Unexpected register size");
+  return Log2_32(Size);
+}
+
+bool X86InstructionSelector::selectBinaryOp(MachineInstr &I) const {
+  static const unsigned AddOpc[] = {
+    X86::ADD8rr, X86::ADD16rr, X86::ADD32rr, X86::ADD64rr
+  };
+  static const unsigned SubOpc[] = {
+    X86::SUB8rr, X86::SUB16rr, X86::SUB32rr, X86::SUB64rr
+  };
+  static const unsigned AndOpc[] = {
+    X86::AND8rr, X86::AND16rr, X86::AND32rr, X86::AND64rr
+  };
+  static const unsigned OrOpc[] = {
+    X86::OR8rr, X86::OR16rr, X86::OR32rr, X86::OR64rr
+  };
+  static const unsigned XorOpc[] = {
+    X86::XOR8rr, X86::XOR16rr, X86::XOR32rr, X86::XOR64rr
+  };
+  // There is no two-operand 8-bit multiply; see below.
+  static const unsigned MulOpc[] = {
+    0, X86::IMUL16rr, X86::IMUL32rr, X86::IMUL64rr
+  };
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  DebugLoc DL = I.getDebugLoc();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op0 = I.getOperand(1).getReg();
+  unsigned Op1 = I.getOperand(2).getReg();
+  unsigned SizeIdx = getSizeIndex(getRegSize(MRI, Res));
+
+  const unsigned *Opcodes;
+  switch (I.getOpcode()) {
+  default: llvm_unreachable("Unexpected binary operation");
+  case TargetOpcode::G_ADD: Opcodes = AddOpc; break;
+  case TargetOpcode::G_SUB: Opcodes = SubOpc; break;
+  case TargetOpcode::G_MUL: Opcodes = MulOpc; break;
+  case TargetOpcode::G_AND: Opcodes = AndOpc; break;
+  case TargetOpcode::G_OR:  Opcodes = OrOpc;  break;
+  case TargetOpcode::G_XOR: Opcodes = XorOpc; break;
+  }
+
+  if (unsigned Opc = Opcodes[SizeIdx]) {
+    BuildMI(MBB, II, DL, TII.get(Opc), Res).addReg(Op0).addReg(Op1);
+  } else {
+    // An 8-bit multiply takes its first operand in AL and leaves the low
+    // part of the result there.
+    BuildMI(MBB, II, DL, TII.get(TargetOpcode::COPY), X86::AL).addReg(Op0);
+    BuildMI(MBB, II, DL, TII.get(X86::MUL8r)).addReg(Op1);
+    BuildMI(MBB, II, DL, TII.get(TargetOpcode::COPY), Res).addReg(X86::AL);
+  }
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectConstant(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  unsigned Res = I.getOperand(0).getReg();
+  int64_t Imm = I.getOperand(1).getImm();
+
+  unsigned Opc;
+  switch (getRegSize(MRI, Res)) {
+  default: return false;
+  case 1: Opc = X86::MOV8ri; break;
+  case 2: Opc = X86::MOV16ri; break;
+  case 4: Opc = X86::MOV32ri; break;
+  case 8: Opc = isInt<32>(Imm) ? X86::MOV64ri32 : X86::MOV64ri; break;
+  }
+  BuildMI(MBB, II, I.getDebugLoc(), TII.get(Opc), Res).addImm(Imm);
+  I.eraseFromParent();
+  return true;
+}
+
+/// Return the SETcc opcode that materializes \p Pred after a compare.
+static unsigned getSETccOpcode(CmpInst::Predicate Pred) {
+  switch (Pred) {
+  default: return 0;
+  case CmpInst::ICMP_EQ:  return X86::SETEr;
+  case CmpInst::ICMP_NE:  return X86::SETNEr;
+  case CmpInst::ICMP_UGT: return X86::SETAr;
+  case CmpInst::ICMP_UGE: return X86::SETAEr;
+  case CmpInst::ICMP_ULT: return X86::SETBr;
+  case CmpInst::ICMP_ULE: return X86::SETBEr;
+  case CmpInst::ICMP_SGT: return X86::SETGr;
+  case CmpInst::ICMP_SGE: return X86::SETGEr;
+  case CmpInst::ICMP_SLT: return X86::SETLr;
+  case CmpInst::ICMP_SLE: return X86::SETLEr;
+  }
+}
+
+bool X86InstructionSelector::selectICmp(MachineInstr &I) const {
+  static const unsigned CmpOpc[] = {
+    X86::CMP8rr, X86::CMP16rr, X86::CMP32rr, X86::CMP64rr
+  };
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  DebugLoc DL = I.getDebugLoc();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op0 = I.getOperand(2).getReg();
+  unsigned Op1 = I.getOperand(3).getReg();
+  unsigned SETccOpc =
+      getSETccOpcode(CmpInst::Predicate(I.getOperand(1).getImm()));
+  if (!SETccOpc)
+    return false;
+
+  BuildMI(MBB, II, DL, TII.get(CmpOpc[getSizeIndex(getRegSize(MRI, Op0))]))
+      .addReg(Op0)
+      .addReg(Op1);
+  BuildMI(MBB, II, DL, TII.get(SETccOpc), Res);
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectExt(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  DebugLoc DL = I.getDebugLoc();
+  bool IsZExt = I.getOpcode() == TargetOpcode::G_ZEXT;
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op = I.getOperand(1).getReg();
+  unsigned ResSize = getRegSize(MRI, Res);
+  unsigned OpSize = getRegSize(MRI, Op);
+
+  // Only booleans are extended within a register, and they are already 0 or
+  // 1.
+  if (OpSize == ResSize) {
+    if (!IsZExt)
+      return false;
+    BuildMI(MBB, II, DL, TII.get(TargetOpcode::COPY), Res).addReg(Op);
+    I.eraseFromParent();
+    return true;
+  }
+  if (OpSize > ResSize)
+    return false;
+
+  if (ResSize == 8 && IsZExt) {
+    // Writing a 32-bit register clears the upper half of its 64-bit
+    // register, so extend to 32 bits first.
+    unsigned Ext32 = MRI.createVirtualRegister(&X86::GR32RegClass);
+    unsigned Opc = OpSize == 1 ? X86::MOVZX32rr8
+                 : OpSize == 2 ? X86::MOVZX32rr16 : X86::MOV32rr;
+    BuildMI(MBB, II, DL, TII.get(Opc), Ext32).addReg(Op);
+    BuildMI(MBB, II, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Res)
+        .addImm(0)
+        .addReg(Ext32)
+        .addImm(X86::sub_32bit);
+    I.eraseFromParent();
+    return true;
+  }
+
+  unsigned Opc;
+  switch (ResSize) {
+  default: return false;
+  case 2:
+    Opc = IsZExt ? X86::MOVZX16rr8 : X86::MOVSX16rr8;
+    break;
+  case 4:
+    if (OpSize == 1)
+      Opc = IsZExt ? X86::MOVZX32rr8 : X86::MOVSX32rr8;
+    else
+      Opc = IsZExt ? X86::MOVZX32rr16 : X86::MOVSX32rr16;
+    break;
+  case 8:
+    Opc = OpSize == 1 ? X86::MOVSX64rr8
+        : OpSize == 2 ? X86::MOVSX64rr16 : X86::MOVSX64rr32;
+    break;
+  }
+  BuildMI(MBB, II, DL, TII.get(Opc), Res).addReg(Op);
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectTrunc(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Op = I.getOperand(1).getReg();
+  unsigned SubIdx;
+  switch (getRegSize(MRI, Res)) {
+  default: return false;
+  case 1: SubIdx = X86::sub_8bit; break;
+  case 2: SubIdx = X86::sub_16bit; break;
+  case 4: SubIdx = X86::sub_32bit; break;
+  }
+
+  // The truncation is a copy of the low part of the operand.
+  const TargetRegisterClass *RC =
+      TRI.getSubClassWithSubReg(MRI.getRegClass(Op), SubIdx);
+  if (!RC || !MRI.constrainRegClass(Op, RC))
+    return false;
+  BuildMI(MBB, II, I.getDebugLoc(), TII.get(TargetOpcode::COPY), Res)
+      .addReg(Op, 0, SubIdx);
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectGlobalValue(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineFunction &MF = *MBB.getParent();
+  const X86Subtarget &STI = MF.getSubtarget<X86Subtarget>();
+  const TargetMachine &TM = MF.getTarget();
+  unsigned Res = I.getOperand(0).getReg();
+  const GlobalValue *GV = I.getOperand(1).getGlobal();
+  // The address is computed relative to RIP, which only reaches everything
+  // in the small code model.
+  if (TM.getCodeModel() != CodeModel::Small)
+    return false;
+
+  // Either compute the address, or load it from the GOT.
+  unsigned char OpFlags = STI.ClassifyGlobalReference(GV, TM);
+  if (OpFlags != X86II::MO_NO_FLAG && OpFlags != X86II::MO_GOTPCREL)
+    return false;
+  bool IsGOT = OpFlags == X86II::MO_GOTPCREL;
+  X86AddressMode AM;
+  AM.Base.Reg = X86::RIP;
+  AM.GV = GV;
+  AM.GVOpFlags = OpFlags;
+  MachineInstrBuilder MIB = addFullAddress(
+      BuildMI(MBB, II, I.getDebugLoc(),
+              TII.get(IsGOT ? X86::MOV64rm : X86::LEA64r), Res),
+      AM);
+  if (IsGOT)
+    MIB.addMemOperand(MF.getMachineMemOperand(
+        MachinePointerInfo::getGOT(), MachineMemOperand::MOLoad, 8, 8));
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::selectLoadStore(MachineInstr &I) const {
+  static const unsigned LoadOpc[] = {
+    X86::MOV8rm, X86::MOV16rm, X86::MOV32rm, X86::MOV64rm
+  };
+  static const unsigned StoreOpc[] = {
+    X86::MOV8mr, X86::MOV16mr, X86::MOV32mr, X86::MOV64mr
+  };
+
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  bool IsLoad = I.getOpcode() == TargetOpcode::G_LOAD;
+  unsigned Val = I.getOperand(0).getReg();
+  unsigned Addr = I.getOperand(1).getReg();
+  // Booleans live in 8-bit registers, so all the accesses are of the size of
+  // the register.
+  unsigned Size = getRegSize(MRI, Val);
+  if (!I.hasOneMemOperand() || (*I.memoperands_begin())->getSize() != Size)
+    return false;
+
+  MachineInstrBuilder MIB;
+  if (IsLoad) {
+    MIB = BuildMI(MBB, II, I.getDebugLoc(),
+                  TII.get(LoadOpc[getSizeIndex(Size)]), Val);
+    addDirectMem(MIB, Addr);
+  } else {
+    MIB = BuildMI(MBB, II, I.getDebugLoc(),
+                  TII.get(StoreOpc[getSizeIndex(Size)]));
+    addDirectMem(MIB, Addr).addReg(Val);
+  }
+  MIB.setMemRefs(I.memoperands_begin(), I.memoperands_end());
+  I.eraseFromParent();
+  return true;
+}
+
+bool X86InstructionSelector::select(MachineInstr &I) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock::iterator II(I);
+  switch (I.getOpcode()) {
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_SUB:
+  case TargetOpcode::G_MUL:
+  case TargetOpcode::G_AND:
+  case TargetOpcode::G_OR:
+  case TargetOpcode::G_XOR:
+    return selectBinaryOp(I);
+  case TargetOpcode::G_CONSTANT:
+    return selectConstant(I);
+  case TargetOpcode::G_ICMP:
+    return selectICmp(I);
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT:
+    return selectExt(I);
+  case TargetOpcode::G_TRUNC:
+    return selectTrunc(I);
+  case TargetOpcode::G_FRAME_INDEX:
+    addOffset(BuildMI(MBB, II, I.getDebugLoc(), TII.get(X86::LEA64r),
+                      I.getOperand(0).getReg())
+                  .addFrameIndex(I.getOperand(1).getIndex()),
+              0);
+    I.eraseFromParent();
+    return true;
+  case TargetOpcode::G_GLOBAL_VALUE:
+    return selectGlobalValue(I);
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    return selectLoadStore(I);
+  case TargetOpcode::G_BRCOND: {
+    // Booleans are always 0 or 1.
+    unsigned Cond = I.getOperand(0).getReg();
+    BuildMI(MBB, II, I.getDebugLoc(), TII.get(X86::TEST8rr))
+        .addReg(Cond)
+        .addReg(Cond);
+    BuildMI(MBB, II, I.getDebugLoc(), TII.get(X86::JNE_1))
+        .addMBB(I.getOperand(1).getMBB());
+    I.eraseFromParent();
+    return true;
+  }
+  case TargetOpcode::G_BR:
+    BuildMI(MBB, II, I.getDebugLoc(), TII.get(X86::JMP_1))
+        .addMBB(I.getOperand(0).getMBB());
+    I.eraseFromParent();
+    return true;
+  default:
+    return false;
+  }
+}
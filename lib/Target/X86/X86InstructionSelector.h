@@ -0,0 +1,47 @@
+//===-- X86InstructionSelector.h - Select X86 instructions ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares the instruction selector of the global instruction
+/// selector for X86.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_X86_X86INSTRUCTIONSELECTOR_H
+#define LLVM_LIB_TARGET_X86_X86INSTRUCTIONSELECTOR_H
+
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+
+namespace llvm {
+
+class X86InstrInfo;
+class X86RegisterInfo;
+
+class X86InstructionSelector : public InstructionSelector {
+  const X86InstrInfo &TII;
+  const X86RegisterInfo &TRI;
+
+public:
+  X86InstructionSelector(const X86InstrInfo &TII, const X86RegisterInfo &TRI);
+
+  bool select(MachineInstr &I) const override;
+
+private:
+  bool selectBinaryOp(MachineInstr &I) const;
+  bool selectConstant(MachineInstr &I) const;
+  bool selectICmp(MachineInstr &I) const;
+  bool selectExt(MachineInstr &I) const;
+  bool selectTrunc(MachineInstr &I) const;
+  bool selectGlobalValue(MachineInstr &I) const;
+  bool selectLoadStore(MachineInstr &I) const;
+};
+
+} // End namespace llvm.
+
+#endif
@@ -301,7 +301,9 @@ X86Subtarget::X86Subtarget(const std::string &TT, const std::string &CPU,
       TSInfo(*TM.getDataLayout()),
       InstrInfo(initializeSubtargetDependencies(CPU, FS)), TLInfo(TM, *this),
       FrameLowering(TargetFrameLowering::StackGrowsDown, getStackAlignment(),
-                    is64Bit() ? -8 : -4) {
+                    is64Bit() ? -8 : -4),
+      CallLoweringInfo(&TLInfo),
+      InstSelector(InstrInfo, InstrInfo.getRegisterInfo()) {
   // Determine the PICStyle based on the target selected.
   if (TM.getRelocationModel() == Reloc::Static) {
     // Unless we're in PIC or DynamicNoPIC mode, set the PIC style to None.
@@ -14,9 +14,11 @@
 #ifndef LLVM_LIB_TARGET_X86_X86SUBTARGET_H
 #define LLVM_LIB_TARGET_X86_X86SUBTARGET_H
 
+#include "X86CallLowering.h"
 #include "X86FrameLowering.h"
 #include "X86ISelLowering.h"
 #include "X86InstrInfo.h"
+#include "X86InstructionSelector.h"
 #include "X86SelectionDAGInfo.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/CallingConv.h"
@@ -248,6 +250,8 @@ private:
   X86InstrInfo InstrInfo;
   X86TargetLowering TLInfo;
   X86FrameLowering FrameLowering;
+  X86CallLowering CallLoweringInfo;
+  X86InstructionSelector InstSelector;
 
 public:
   /// This constructor initializes the data members to match that
@@ -270,6 +274,12 @@ public:
   const X86RegisterInfo *getRegisterInfo() const override {
     return &getInstrInfo()->getRegisterInfo();
   }
+  const CallLowering *getCallLowering() const override {
+    return &CallLoweringInfo;
+  }
+  const InstructionSelector *getInstructionSelector() const override {
+    return &InstSelector;
+  }
 
   /// Returns the minimum alignment known to hold of the
   /// stack frame on entry to the function and which must be maintained by every
@@ -0,0 +1,292 @@
+//===- FunctionImport.cpp - Summary-based function importing --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass implements the importing half of summary-based cross-module
+// optimization. Given a combined index of the function summaries of all the
+// modules of a program, it copies into the current module the bodies of the
+// small (or hot) external functions that the module calls, as
+// available_externally definitions. The module can then be optimized and code
+// generated on its own, in parallel with the other modules, while still
+// getting most of the inlining benefit of full LTO.
+//
+// Only the functions that are imported, and the metadata that they use, are
+// loaded from the other modules, and debug info is stripped from the imported
+// bodies.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include <algorithm>
+using namespace llvm;
+
+#define DEBUG_TYPE "function-import"
+
+STATISTIC(NumImported, "Number of functions imported");
+
+static cl::opt<std::string>
+SummaryFile("summary-file",
+            cl::desc("The combined function summary index to import from"),
+            cl::value_desc("filename"));
+
+static cl::opt<unsigned> ImportInstrLimit(
+    "import-instr-limit", cl::init(100), cl::Hidden,
+    cl::desc("Only import functions with at most this many instructions"));
+
+static cl::opt<unsigned> ImportHotInstrLimit(
+    "import-hot-instr-limit", cl::init(1000), cl::Hidden,
+    cl::desc("Only import hot functions with at most this many instructions"));
+
+static cl::opt<unsigned> ImportHotCount(
+    "import-hot-count", cl::init(10000), cl::Hidden,
+    cl::desc("Minimum profile entry count of a function to be considered hot "
+             "for importing"));
+
+namespace {
+
+/// @brief Pass to import function bodies from other modules.
+class FunctionImport : public ModulePass {
+  /// The index to import from, if it was not given on the command line.
+  const FunctionInfoIndex *Index;
+
+  /// The modules that functions were imported from, keyed by path.
+  StringMap<std::unique_ptr<Module>> SourceModules;
+
+  Module *getSourceModule(StringRef Path, LLVMContext &Context);
+  bool importFunction(Module &M, Linker &L, StringRef Name, StringRef Path);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  explicit FunctionImport(const FunctionInfoIndex *Index = nullptr)
+      : ModulePass(ID), Index(Index) {
+    initializeFunctionImportPass(*PassRegistry::getPassRegistry());
+  }
+  bool runOnModule(Module &M) override;
+};
+
+} // end anonymous namespace
+
+char FunctionImport::ID = 0;
+INITIALIZE_PASS(FunctionImport, "function-import",
+                "Summary-based function importing", false, false)
+
+/// Return whether the function described by Summary should be imported.
+static bool shouldImport(const FunctionSummary &Summary) {
+  if (!Summary.isEligibleToImport())
+    return false;
+  if (Summary.getInstCount() <= ImportInstrLimit)
+    return true;
+  return Summary.getEntryCount() >= ImportHotCount &&
+         Summary.getInstCount() <= ImportHotInstrLimit;
+}
+
+/// Add the names of the external functions that F calls to Worklist.
+static void addCallees(const Function &F,
+                       SmallVectorImpl<std::string> &Worklist) {
+  for (const BasicBlock &BB : F)
+    for (const Instruction &I : BB) {
+      ImmutableCallSite CS(&I);
+      if (!CS)
+        continue;
+      const Function *Callee =
+          dyn_cast<Function>(CS.getCalledValue()->stripPointerCasts());
+      if (Callee && Callee->isDeclaration() && !Callee->isIntrinsic())
+        Worklist.push_back(Callee->getName());
+    }
+}
+
+Module *FunctionImport::getSourceModule(StringRef Path, LLVMContext &Context) {
+  std::unique_ptr<Module> &SrcM = SourceModules[Path];
+  if (SrcM)
+    return SrcM.get();
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+      MemoryBuffer::getFile(Path);
+  if (std::error_code EC = BufferOrErr.getError()) {
+    DEBUG(dbgs() << "Cannot open " << Path << ": " << EC.message() << "\n");
+    return nullptr;
+  }
+  // Load the metadata lazily as well, so that only the nodes that are used by
+  // the imported functions are read.
+  ErrorOr<Module *> MOrErr =
+      getLazyBitcodeModule(std::move(BufferOrErr.get()), Context, nullptr,
+                           /*ShouldLazyLoadMetadata=*/true);
+  if (std::error_code EC = MOrErr.getError()) {
+    DEBUG(dbgs() << "Cannot read " << Path << ": " << EC.message() << "\n");
+    return nullptr;
+  }
+  SrcM.reset(MOrErr.get());
+  return SrcM.get();
+}
+
+namespace {
+/// Declares the globals of the source module that an imported function
+/// refers to, in the module that the function is copied to.
+class GlobalDeclarer : public ValueMaterializer {
+  Module &Dst;
+
+public:
+  explicit GlobalDeclarer(Module &Dst) : Dst(Dst) {}
+  Value *materializeValueFor(Value *V) override;
+};
+} // end anonymous namespace
+
+Value *GlobalDeclarer::materializeValueFor(Value *V) {
+  auto *GV = dyn_cast<GlobalValue>(V);
+  if (!GV)
+    return nullptr;
+
+  // An alias cannot be declared, so it is declared as a function or a global
+  // variable depending on the value type, like CloneModule does.
+  auto *PTy = cast<PointerType>(GV->getType());
+  if (auto *FTy = dyn_cast<FunctionType>(PTy->getElementType())) {
+    Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                   GV->getName(), &Dst);
+    if (isa<Function>(GV))
+      F->copyAttributesFrom(GV);
+    return F;
+  }
+  auto *Var = dyn_cast<GlobalVariable>(GV);
+  GlobalVariable *NewVar = new GlobalVariable(
+      Dst, PTy->getElementType(), Var && Var->isConstant(),
+      GlobalValue::ExternalLinkage, nullptr, GV->getName(), nullptr,
+      GV->getThreadLocalMode(), PTy->getAddressSpace());
+  if (Var)
+    NewVar->copyAttributesFrom(Var);
+  return NewVar;
+}
+
+/// Import the definition of Name from the module at Path into M as an
+/// available_externally function.
+bool FunctionImport::importFunction(Module &M, Linker &L, StringRef Name,
+                                    StringRef Path) {
+  Module *SrcM = getSourceModule(Path, M.getContext());
+  if (!SrcM)
+    return false;
+  Function *SrcF = SrcM->getFunction(Name);
+  if (!SrcF || !SrcF->hasExternalLinkage() || SrcF->isDeclaration())
+    return false;
+  if (SrcF->materialize())
+    return false;
+
+  // Copy the function into a module of its own, along with declarations of
+  // the globals that it refers to and nothing else, so that the cost of an
+  // import doesn't depend on the size of the source module.
+  std::unique_ptr<Module> Imported =
+      llvm::make_unique<Module>(SrcM->getModuleIdentifier(), M.getContext());
+  Imported->setDataLayout(SrcM->getDataLayout());
+  Imported->setTargetTriple(SrcM->getTargetTriple());
+  Function *F = Function::Create(SrcF->getFunctionType(), SrcF->getLinkage(),
+                                 Name, Imported.get());
+  ValueToValueMapTy VMap;
+  VMap[SrcF] = F;
+  Function::arg_iterator DestI = F->arg_begin();
+  for (Argument &Arg : SrcF->args()) {
+    DestI->setName(Arg.getName());
+    VMap[&Arg] = DestI++;
+  }
+  GlobalDeclarer Declarer(*Imported);
+  SmallVector<ReturnInst *, 8> Returns;
+  CloneFunctionInto(F, SrcF, VMap, /*ModuleLevelChanges=*/true, Returns, "",
+                    nullptr, nullptr, &Declarer);
+  StripDebugInfo(*Imported);
+
+  if (L.linkInModule(Imported.get()))
+    return false;
+  // The linker treats available_externally definitions like declarations, so
+  // the function is only downgraded once its body has been linked in.
+  M.getFunction(Name)->setLinkage(GlobalValue::AvailableExternallyLinkage);
+  return true;
+}
+
+bool FunctionImport::runOnModule(Module &M) {
+  std::unique_ptr<FunctionInfoIndex> IndexFromFile;
+  if (!Index) {
+    if (SummaryFile.empty())
+      return false;
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(SummaryFile);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      M.getContext().emitError("Cannot open summary file '" + SummaryFile +
+                               "': " + EC.message());
+      return false;
+    }
+    ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+        getFunctionInfoIndex(BufferOrErr.get()->getMemBufferRef(),
+                             M.getContext());
+    if (std::error_code EC = IndexOrErr.getError()) {
+      M.getContext().emitError("Cannot read summary file '" + SummaryFile +
+                               "': " + EC.message());
+      return false;
+    }
+    IndexFromFile = std::move(IndexOrErr.get());
+  }
+  const FunctionInfoIndex &TheIndex = Index ? *Index : *IndexFromFile;
+
+  SmallVector<std::string, 32> Worklist;
+  for (const Function &F : M)
+    if (F.isDeclaration() && !F.isIntrinsic() && !F.use_empty())
+      Worklist.push_back(F.getName());
+  // Process the worklist in module order.
+  std::reverse(Worklist.begin(), Worklist.end());
+
+  Linker L(&M);
+  StringSet<> Visited;
+  bool Changed = false;
+  while (!Worklist.empty()) {
+    std::string Name = Worklist.pop_back_val();
+    if (!Visited.insert(Name).second)
+      continue;
+
+    Function *F = M.getFunction(Name);
+    if (!F || !F->isDeclaration())
+      continue;
+    const FunctionInfoIndex::FunctionInfo *Info = TheIndex.findFunction(Name);
+    if (!Info || !shouldImport(Info->Summary))
+      continue;
+    StringRef Path = TheIndex.getModulePath(Info->ModuleId);
+    if (Path == M.getModuleIdentifier())
+      continue;
+
+    DEBUG(dbgs() << "Importing " << Name << " from " << Path << "\n");
+    if (!importFunction(M, L, Name, Path))
+      continue;
+    ++NumImported;
+    Changed = true;
+
+    // The callees of the imported function are candidates as well.
+    if (Function *Imported = M.getFunction(Name))
+      addCallees(*Imported, Worklist);
+  }
+
+  SourceModules.clear();
+  return Changed;
+}
+
+ModulePass *llvm::createFunctionImportPass(const FunctionInfoIndex *Index) {
+  return new FunctionImport(Index);
+}
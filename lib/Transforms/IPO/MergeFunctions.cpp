@@ -27,6 +27,11 @@
 // -- We define Function* container class with custom "operator<" (FunctionPtr).
 // -- "FunctionPtr" instances are stored in std::set collection, so every
 //    std::set::insert operation will give you result in log(N) time.
+// -- Every function is also given a cheap structural hash (see
+//    FunctionComparator::functionHash). Equal functions always have equal
+//    hashes, so the set is ordered by hash first and the deep comparison only
+//    runs between functions whose hashes collide. Functions with a hash that
+//    no other function shares are never inserted at all.
 //
 // When a match is found the functions are folded. If both functions are
 // overridable, we move the functionality into a new internal function and
@@ -82,8 +87,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
@@ -102,6 +109,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <vector>
 using namespace llvm;
 
@@ -111,6 +119,8 @@ STATISTIC(NumFunctionsMerged, "Number of functions merged");
 STATISTIC(NumThunksWritten, "Number of thunks generated");
 STATISTIC(NumAliasesWritten, "Number of aliases generated");
 STATISTIC(NumDoubleWeak, "Number of new functions created");
+STATISTIC(NumSkippedUniqueHash,
+          "Number of functions skipped due to a unique structural hash");
 
 static cl::opt<unsigned> NumFunctionsForSanityCheck(
     "mergefunc-sanity",
@@ -133,6 +143,13 @@ public:
   /// Test whether the two functions have equivalent behaviour.
   int compare();
 
+  /// Compute a hash of the structure of \p F: its signature, CFG shape and
+  /// instruction opcodes and result types, visited in the same order as
+  /// compare() walks the function. Functions that compare() considers equal
+  /// always have equal hashes, so the hash may be used to bucket functions
+  /// before running the expensive comparison.
+  static hash_code functionHash(const Function &F);
+
 private:
   /// Test whether two basic blocks have equivalent behaviour.
   int compare(const BasicBlock *BBL, const BasicBlock *BBR);
@@ -390,17 +407,66 @@ private:
 
 class FunctionNode {
   AssertingVH<Function> F;
+  hash_code Hash;
 
 public:
-  FunctionNode(Function *F) : F(F) {}
+  FunctionNode(Function *F, hash_code Hash) : F(F), Hash(Hash) {}
   Function *getFunc() const { return F; }
+  hash_code getHash() const { return Hash; }
   void release() { F = 0; }
   bool operator<(const FunctionNode &RHS) const {
+    // Order by hash first; the full comparison is only needed to tell apart
+    // functions in the same bucket.
+    if (Hash != RHS.getHash())
+      return size_t(Hash) < size_t(RHS.getHash());
     return (FunctionComparator(F, RHS.getFunc()).compare()) == -1;
   }
 };
 }
 
+/// Map \p Ty to the type ID cmpTypes() would compare it by. Pointers in
+/// address space 0 are compared as integers of pointer width there.
+static unsigned hashableTypeID(Type *Ty) {
+  if (PointerType *PTy = dyn_cast<PointerType>(Ty))
+    if (PTy->getAddressSpace() == 0)
+      return Type::IntegerTyID;
+  return Ty->getTypeID();
+}
+
+hash_code FunctionComparator::functionHash(const Function &F) {
+  hash_code H = hash_combine(F.isVarArg(), F.getCallingConv(), F.arg_size(),
+                             hashableTypeID(F.getReturnType()));
+
+  // Walk the CFG in the same order as compare(), so that unreachable blocks
+  // are ignored here too.
+  SmallVector<const BasicBlock *, 8> BBs;
+  SmallPtrSet<const BasicBlock *, 16> VisitedBBs;
+  BBs.push_back(&F.getEntryBlock());
+  VisitedBBs.insert(BBs[0]);
+  while (!BBs.empty()) {
+    const BasicBlock *BB = BBs.pop_back_val();
+    H = hash_combine(H, BB->size());
+    for (const Instruction &Inst : *BB) {
+      // GEPs with the same constant offset compare equal regardless of their
+      // indices, so only their opcode is hashed.
+      if (isa<GetElementPtrInst>(Inst))
+        H = hash_combine(H, Inst.getOpcode());
+      else
+        H = hash_combine(H, Inst.getOpcode(), Inst.getNumOperands(),
+                         hashableTypeID(Inst.getType()));
+    }
+
+    const TerminatorInst *Term = BB->getTerminator();
+    H = hash_combine(H, Term->getNumSuccessors());
+    for (unsigned i = 0, e = Term->getNumSuccessors(); i != e; ++i) {
+      if (!VisitedBBs.insert(Term->getSuccessor(i)).second)
+        continue;
+      BBs.push_back(Term->getSuccessor(i));
+    }
+  }
+  return H;
+}
+
 int FunctionComparator::cmpNumbers(uint64_t L, uint64_t R) const {
   if (L < R) return -1;
   if (L > R) return 1;
@@ -1083,17 +1149,22 @@ public:
 private:
   typedef std::set<FunctionNode> FnTreeType;
 
+  /// A function to analyze, with its structural hash. The hash only covers
+  /// the types and opcodes of the function, which merging other functions
+  /// leaves alone, so it is computed once and carried along.
+  typedef std::pair<WeakVH, hash_code> QueuedFunction;
+
   /// A work queue of functions that may have been modified and should be
   /// analyzed again.
-  std::vector<WeakVH> Deferred;
+  std::vector<QueuedFunction> Deferred;
 
   /// Checks the rules of order relation introduced among functions set.
   /// Returns true, if sanity check has been passed, and false if failed.
-  bool doSanityCheck(std::vector<WeakVH> &Worklist);
+  bool doSanityCheck(std::vector<QueuedFunction> &Worklist);
 
-  /// Insert a ComparableFunction into the FnTree, or merge it away if it's
-  /// equal to one that's already present.
-  bool insert(Function *NewFunction);
+  /// Insert a ComparableFunction with structural hash Hash into the FnTree, or
+  /// merge it away if it's equal to one that's already present.
+  bool insert(Function *NewFunction, hash_code Hash);
 
   /// Remove a Function from the FnTree and queue it up for a second sweep of
   /// analysis.
@@ -1126,6 +1197,10 @@ private:
   /// to modify it.
   FnTreeType FnTree;
 
+  /// The nodes of the functions in FnTree, which remove() uses to find a
+  /// function without comparing it to others.
+  DenseMap<Function *, FnTreeType::iterator> FNodesInTree;
+
   /// Whether or not the target supports global aliases.
   bool HasGlobalAliases;
 };
@@ -1139,7 +1214,7 @@ ModulePass *llvm::createMergeFunctionsPass() {
   return new MergeFunctions();
 }
 
-bool MergeFunctions::doSanityCheck(std::vector<WeakVH> &Worklist) {
+bool MergeFunctions::doSanityCheck(std::vector<QueuedFunction> &Worklist) {
   if (const unsigned Max = NumFunctionsForSanityCheck) {
     unsigned TripleNumber = 0;
     bool Valid = true;
@@ -1147,12 +1222,14 @@ bool MergeFunctions::doSanityCheck(std::vector<WeakVH> &Worklist) {
     dbgs() << "MERGEFUNC-SANITY: Started for first " << Max << " functions.\n";
 
     unsigned i = 0;
-    for (std::vector<WeakVH>::iterator I = Worklist.begin(), E = Worklist.end();
+    for (std::vector<QueuedFunction>::iterator I = Worklist.begin(),
+                                               E = Worklist.end();
          I != E && i < Max; ++I, ++i) {
       unsigned j = i;
-      for (std::vector<WeakVH>::iterator J = I; J != E && j < Max; ++J, ++j) {
-        Function *F1 = cast<Function>(*I);
-        Function *F2 = cast<Function>(*J);
+      for (std::vector<QueuedFunction>::iterator J = I; J != E && j < Max;
+           ++J, ++j) {
+        Function *F1 = cast<Function>(I->first);
+        Function *F2 = cast<Function>(J->first);
         int Res1 = FunctionComparator(F1, F2).compare();
         int Res2 = FunctionComparator(F2, F1).compare();
 
@@ -1169,12 +1246,12 @@ bool MergeFunctions::doSanityCheck(std::vector<WeakVH> &Worklist) {
           continue;
 
         unsigned k = j;
-        for (std::vector<WeakVH>::iterator K = J; K != E && k < Max;
+        for (std::vector<QueuedFunction>::iterator K = J; K != E && k < Max;
              ++k, ++K, ++TripleNumber) {
           if (K == J)
             continue;
 
-          Function *F3 = cast<Function>(*K);
+          Function *F3 = cast<Function>(K->first);
           int Res3 = FunctionComparator(F1, F3).compare();
           int Res4 = FunctionComparator(F2, F3).compare();
 
@@ -1214,13 +1291,33 @@ bool MergeFunctions::doSanityCheck(std::vector<WeakVH> &Worklist) {
 bool MergeFunctions::runOnModule(Module &M) {
   bool Changed = false;
 
+  // Bucket the candidate functions by their structural hash. A function whose
+  // hash is unique cannot be equal to any other function, so only functions
+  // that share a bucket are queued for the full comparison. The module order
+  // is preserved so that the choice of which function survives a merge does
+  // not depend on the hash values.
+  std::vector<std::pair<Function *, hash_code>> HashedFuncs;
+  std::vector<size_t> SortedHashes;
   for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
-    if (!I->isDeclaration() && !I->hasAvailableExternallyLinkage())
-      Deferred.push_back(WeakVH(I));
+    if (!I->isDeclaration() && !I->hasAvailableExternallyLinkage()) {
+      hash_code H = FunctionComparator::functionHash(*I);
+      HashedFuncs.push_back(std::make_pair(&*I, H));
+      SortedHashes.push_back(H);
+    }
+  }
+  std::sort(SortedHashes.begin(), SortedHashes.end());
+
+  for (auto &HF : HashedFuncs) {
+    auto Bucket = std::equal_range(SortedHashes.begin(), SortedHashes.end(),
+                                   size_t(HF.second));
+    if (Bucket.second - Bucket.first > 1)
+      Deferred.push_back(std::make_pair(WeakVH(HF.first), HF.second));
+    else
+      ++NumSkippedUniqueHash;
   }
 
   do {
-    std::vector<WeakVH> Worklist;
+    std::vector<QueuedFunction> Worklist;
     Deferred.swap(Worklist);
 
     DEBUG(doSanityCheck(Worklist));
@@ -1230,13 +1327,13 @@ bool MergeFunctions::runOnModule(Module &M) {
 
     // Insert only strong functions and merge them. Strong function merging
     // always deletes one of them.
-    for (std::vector<WeakVH>::iterator I = Worklist.begin(),
+    for (std::vector<QueuedFunction>::iterator I = Worklist.begin(),
            E = Worklist.end(); I != E; ++I) {
-      if (!*I) continue;
-      Function *F = cast<Function>(*I);
+      if (!I->first) continue;
+      Function *F = cast<Function>(I->first);
       if (!F->isDeclaration() && !F->hasAvailableExternallyLinkage() &&
           !F->mayBeOverridden()) {
-        Changed |= insert(F);
+        Changed |= insert(F, I->second);
       }
     }
 
@@ -1244,19 +1341,20 @@ bool MergeFunctions::runOnModule(Module &M) {
     // create thunks to the strong function when possible. When two weak
     // functions are identical, we create a new strong function with two weak
     // weak thunks to it which are identical but not mergable.
-    for (std::vector<WeakVH>::iterator I = Worklist.begin(),
+    for (std::vector<QueuedFunction>::iterator I = Worklist.begin(),
            E = Worklist.end(); I != E; ++I) {
-      if (!*I) continue;
-      Function *F = cast<Function>(*I);
+      if (!I->first) continue;
+      Function *F = cast<Function>(I->first);
       if (!F->isDeclaration() && !F->hasAvailableExternallyLinkage() &&
           F->mayBeOverridden()) {
-        Changed |= insert(F);
+        Changed |= insert(F, I->second);
       }
     }
     DEBUG(dbgs() << "size of FnTree: " << FnTree.size() << '\n');
   } while (!Deferred.empty());
 
   FnTree.clear();
+  FNodesInTree.clear();
 
   return Changed;
 }
@@ -1416,11 +1514,12 @@ void MergeFunctions::mergeTwoFunctions(Function *F, Function *G) {
 
 // Insert a ComparableFunction into the FnTree, or merge it away if equal to one
 // that was already inserted.
-bool MergeFunctions::insert(Function *NewFunction) {
+bool MergeFunctions::insert(Function *NewFunction, hash_code Hash) {
   std::pair<FnTreeType::iterator, bool> Result =
-      FnTree.insert(FunctionNode(NewFunction));
+      FnTree.insert(FunctionNode(NewFunction, Hash));
 
   if (Result.second) {
+    FNodesInTree[NewFunction] = Result.first;
     DEBUG(dbgs() << "Inserting as unique: " << NewFunction->getName() << '\n');
     return false;
   }
@@ -1455,17 +1554,14 @@ bool MergeFunctions::insert(Function *NewFunction) {
 void MergeFunctions::remove(Function *F) {
   // We need to make sure we remove F, not a function "equal" to F per the
   // function equality comparator.
-  FnTreeType::iterator found = FnTree.find(FunctionNode(F));
-  size_t Erased = 0;
-  if (found != FnTree.end() && found->getFunc() == F) {
-    Erased = 1;
-    FnTree.erase(found);
-  }
-
-  if (Erased) {
+  auto Found = FNodesInTree.find(F);
+  if (Found != FNodesInTree.end()) {
+    hash_code Hash = Found->second->getHash();
+    FnTree.erase(Found->second);
+    FNodesInTree.erase(Found);
     DEBUG(dbgs() << "Removed " << F->getName()
                  << " from set and deferred it.\n");
-    Deferred.emplace_back(F);
+    Deferred.push_back(std::make_pair(WeakVH(F), Hash));
   }
 }
 
@@ -39,6 +39,7 @@ struct ADCE : public FunctionPass {
   }
 
   bool runOnFunction(Function& F) override;
+  FunctionPass *createParallelCopy() const override { return new ADCE(); }
 
   void getAnalysisUsage(AnalysisUsage& AU) const override {
     AU.setPreservesCFG();
@@ -50,6 +50,7 @@ struct BDCE : public FunctionPass {
   }
 
   bool runOnFunction(Function& F) override;
+  FunctionPass *createParallelCopy() const override { return new BDCE(); }
 
   void getAnalysisUsage(AnalysisUsage& AU) const override {
     AU.setPreservesCFG();
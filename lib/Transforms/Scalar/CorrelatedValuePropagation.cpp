@@ -51,6 +51,9 @@ namespace {
     }
 
     bool runOnFunction(Function &F) override;
+    FunctionPass *createParallelCopy() const override {
+      return new CorrelatedValuePropagation();
+    }
 
     void getAnalysisUsage(AnalysisUsage &AU) const override {
       AU.addRequired<LazyValueInfo>();
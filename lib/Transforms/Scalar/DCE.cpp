@@ -82,6 +82,7 @@ namespace {
     }
 
     bool runOnFunction(Function &F) override;
+    FunctionPass *createParallelCopy() const override { return new DCE(); }
 
     void getAnalysisUsage(AnalysisUsage &AU) const override {
       AU.setPreservesCFG();
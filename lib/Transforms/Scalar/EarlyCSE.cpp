@@ -756,6 +756,10 @@ public:
     return CSE.run();
   }
 
+  FunctionPass *createParallelCopy() const override {
+    return new EarlyCSELegacyPass();
+  }
+
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<AssumptionCacheTracker>();
     AU.addRequired<DominatorTreeWrapperPass>();
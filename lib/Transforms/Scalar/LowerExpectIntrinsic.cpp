@@ -180,6 +180,9 @@ public:
   }
 
   bool runOnFunction(Function &F) override { return lowerExpectIntrinsic(F); }
+  FunctionPass *createParallelCopy() const override {
+    return new LowerExpectIntrinsic();
+  }
 };
 }
 
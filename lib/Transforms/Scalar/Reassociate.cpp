@@ -169,6 +169,9 @@ namespace {
     }
 
     bool runOnFunction(Function &F) override;
+    FunctionPass *createParallelCopy() const override {
+      return new Reassociate();
+    }
 
     void getAnalysisUsage(AnalysisUsage &AU) const override {
       AU.setPreservesCFG();
@@ -1516,6 +1516,7 @@ namespace {
     // algorithm, and return true if the function was modified.
     //
     bool runOnFunction(Function &F) override;
+    FunctionPass *createParallelCopy() const override { return new SCCP(); }
   };
 } // end anonymous namespace
 
@@ -1250,6 +1250,9 @@ public:
     initializeSROAPass(*PassRegistry::getPassRegistry());
   }
   bool runOnFunction(Function &F) override;
+  FunctionPass *createParallelCopy() const override {
+    return new SROA(RequiresDomTree);
+  }
   void getAnalysisUsage(AnalysisUsage &AU) const override;
 
   const char *getPassName() const override { return "SROA"; }
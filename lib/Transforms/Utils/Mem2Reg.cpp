@@ -37,6 +37,9 @@ namespace {
     // instructions that are safe for promotion, then we promote each one.
     //
     bool runOnFunction(Function &F) override;
+    FunctionPass *createParallelCopy() const override {
+      return new PromotePass();
+    }
 
     void getAnalysisUsage(AnalysisUsage &AU) const override {
       AU.addRequired<AssumptionCacheTracker>();
@@ -99,6 +99,10 @@ namespace {
 
       return Changed;
     }
+
+    FunctionPass *createParallelCopy() const override {
+      return new InstSimplifier();
+    }
   };
 }
 
@@ -0,0 +1,97 @@
+//===- SplitModule.cpp - Split a module into partitions -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for large modules and for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalObject.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+using namespace llvm;
+
+/// Give GV a name and linkage that can be referenced from any partition.
+/// Suffix is appended to the names of local symbols so that they cannot
+/// clash with symbols of the same name defined in other modules.
+static void externalize(GlobalValue *GV, StringRef Suffix) {
+  if (GV->hasLocalLinkage()) {
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+    // Unnamed entities must be named consistently between modules. setName
+    // will give a distinct name to each such entity.
+    GV->setName(Twine(GV->hasName() ? GV->getName() : "__llvmsplit_unnamed") +
+                Suffix);
+  } else if (!GV->hasName()) {
+    GV->setName("__llvmsplit_unnamed");
+  }
+}
+
+// Returns whether GV should be in partition (0-based) I of N.
+static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
+  if (auto GA = dyn_cast<GlobalAlias>(GV))
+    if (const GlobalObject *Base = GA->getBaseObject())
+      GV = Base;
+
+  StringRef Name;
+  if (const Comdat *C = GV->getComdat())
+    Name = C->getName();
+  else
+    Name = GV->getName();
+
+  // Partition by MD5 hash. We only need a few bits for evenness as the number
+  // of partitions will generally be in the 1-2 figure range; the low 16 bits
+  // are enough.
+  MD5 H;
+  MD5::MD5Result R;
+  H.update(Name);
+  H.final(R);
+  return (R[0] | (R[1] << 8)) % N == I;
+}
+
+void llvm::SplitModule(
+    Module &M, unsigned N,
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback) {
+  // Derive the suffix for promoted local symbols from the module identifier,
+  // which is the best approximation we have of a per-translation-unit key.
+  MD5 H;
+  MD5::MD5Result R;
+  H.update(M.getModuleIdentifier());
+  H.final(R);
+  SmallString<32> Hash;
+  MD5::stringifyResult(R, Hash);
+  std::string Suffix = (Twine(".llvm.") + Hash.substr(0, 8)).str();
+
+  for (Function &F : M)
+    externalize(&F, Suffix);
+  for (GlobalVariable &GV : M.globals())
+    externalize(&GV, Suffix);
+  for (GlobalAlias &GA : M.aliases())
+    externalize(&GA, Suffix);
+
+  for (unsigned I = 0; I != N; ++I) {
+    ValueToValueMapTy VMap;
+    std::unique_ptr<Module> MPart(
+        CloneModule(&M, VMap, [=](const GlobalValue *GV) {
+          return isInPartition(GV, I, N);
+        }));
+    if (I != 0)
+      MPart->setModuleInlineAsm("");
+    ModuleCallback(std::move(MPart));
+  }
+}
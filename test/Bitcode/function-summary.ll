@@ -0,0 +1,46 @@
+; RUN: llvm-as -function-summary < %s | llvm-bcanalyzer -dump | FileCheck %s
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s --check-prefix=NOSUMMARY
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-lto -thinlto -o %t2.bc %t.bc
+; RUN: llvm-bcanalyzer -dump %t2.bc | FileCheck %s --check-prefix=COMBINED
+
+; Only the externally visible definitions are summarized, sorted by name.
+; Entries are [instcount, flags, entrycount, name].
+; CHECK: <FUNCTION_SUMMARY_BLOCK
+; CHECK-NEXT: <ENTRY {{.*}} op0=1 op1=1 op2=0 op3=98 op4=97 op5=114/>
+; CHECK-NEXT: <ENTRY {{.*}} op0=2 op1=0 op2=0 op3=102 op4=111 op5=111/>
+; CHECK-NEXT: <ENTRY {{.*}} op0=1 op1=1 op2=2304 op3=104 op4=111 op5=116/>
+; CHECK-NEXT: </FUNCTION_SUMMARY_BLOCK>
+
+; NOSUMMARY-NOT: FUNCTION_SUMMARY_BLOCK
+
+; COMBINED: <FUNCTION_SUMMARY_BLOCK
+; COMBINED-NEXT: <MODULE_PATH {{.*}} op0=0
+; COMBINED-NEXT: <COMBINED_ENTRY {{.*}} op0=0 op1=1 op2=1 op3=0 op4=98 op5=97 op6=114/>
+; COMBINED-NEXT: <COMBINED_ENTRY {{.*}} op0=0 op1=2 op2=0 op3=0 op4=102 op5=111 op6=111/>
+; COMBINED-NEXT: <COMBINED_ENTRY {{.*}} op0=0 op1=1 op2=1 op3=2304 op4=104 op5=111 op6=116/>
+; COMBINED-NEXT: </FUNCTION_SUMMARY_BLOCK>
+
+@lv = internal global i32 0
+
+define void @bar() {
+  ret void
+}
+
+; Referring to a local symbol makes @foo ineligible for importing.
+define void @foo() {
+  store i32 1, i32* @lv
+  ret void
+}
+
+define void @hot() !prof !0 {
+  ret void
+}
+
+define internal void @local() {
+  ret void
+}
+
+declare void @decl()
+
+!0 = !{!"function_entry_count", i32 2304}
@@ -0,0 +1,35 @@
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s | llvm-bcanalyzer -dump \
+; RUN:   | FileCheck %s -check-prefix=BC
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s | llvm-dis | FileCheck %s
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=NOINDEX
+
+; The index comes first and last in the module-level metadata block, and
+; only when there are more metadata records than the threshold.
+; BC: <METADATA_BLOCK
+; BC-NEXT: <METADATA_INDEX_OFFSET
+; BC: <METADATA_NAMED_NODE
+; BC-NEXT: <METADATA_INDEX
+; BC-NEXT: </METADATA_BLOCK>
+; NOINDEX-NOT: METADATA_INDEX
+
+; The index does not get in the way of reading the whole module.
+; CHECK: store i32 0, i32* @gv, !tbaa !0
+; CHECK: !named = !{!0, !3}
+; CHECK: !0 = !{!1, !1, i64 0}
+; CHECK: !1 = !{!"int", !2}
+; CHECK: !2 = !{!"root"}
+; CHECK: !3 = distinct !{!3, !2}
+
+@gv = global i32 0
+
+define void @f() {
+  store i32 0, i32* @gv, !tbaa !0
+  ret void
+}
+
+!named = !{!0, !3}
+
+!0 = !{!1, !1, i64 0}
+!1 = !{!"int", !2}
+!2 = !{!"root"}
+!3 = distinct !{!3, !2}
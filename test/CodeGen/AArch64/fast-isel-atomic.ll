@@ -0,0 +1,76 @@
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=aarch64-linux-gnu | FileCheck %s
+; RUN: llc < %s -O0 -fast-isel-verbose -mtriple=aarch64-linux-gnu -o /dev/null 2>&1 | FileCheck %s --check-prefix=MISS
+
+; Atomic loads, stores and fences that map to single instructions are
+; selected by fast-isel.
+
+define i32 @load_monotonic(i32* %p) {
+; CHECK-LABEL: load_monotonic:
+; CHECK:       ldr w0, [x0]
+; CHECK-NEXT:  ret
+  %v = load atomic i32, i32* %p monotonic, align 4
+  ret i32 %v
+}
+
+define i32 @load_acquire(i8* %p) {
+; CHECK-LABEL: load_acquire:
+; CHECK:       ldarb [[REG:w[0-9]+]], [x0]
+; CHECK-NEXT:  uxtb w0, [[REG]]
+; CHECK-NEXT:  ret
+  %v = load atomic i8, i8* %p acquire, align 1
+  %e = zext i8 %v to i32
+  ret i32 %e
+}
+
+define i64 @load_seq_cst(i64* %p) {
+; CHECK-LABEL: load_seq_cst:
+; CHECK:       ldar x0, [x0]
+; CHECK-NEXT:  ret
+  %v = load atomic i64, i64* %p seq_cst, align 8
+  ret i64 %v
+}
+
+define void @store_unordered(i16* %p, i16 %v) {
+; CHECK-LABEL: store_unordered:
+; CHECK:       strh w1, [x0]
+; CHECK-NEXT:  ret
+  store atomic i16 %v, i16* %p unordered, align 2
+  ret void
+}
+
+define void @store_release(i32* %p, i32 %v) {
+; CHECK-LABEL: store_release:
+; CHECK:       stlr w1, [x0]
+; CHECK-NEXT:  ret
+  store atomic i32 %v, i32* %p release, align 4
+  ret void
+}
+
+define void @store_seq_cst(i16* %p, i16 %v) {
+; CHECK-LABEL: store_seq_cst:
+; CHECK:       stlrh w1, [x0]
+; CHECK-NEXT:  ret
+  store atomic i16 %v, i16* %p seq_cst, align 2
+  ret void
+}
+
+define void @fences() {
+; CHECK-LABEL: fences:
+; CHECK:       dmb ishld
+; CHECK-NEXT:  dmb ish
+; CHECK-NEXT:  dmb ish
+; CHECK-NEXT:  ret
+  fence acquire
+  fence release
+  fence seq_cst
+  ret void
+}
+
+; Read-modify-write operations expand to exclusive load/store loops, which
+; are left to SelectionDAG.
+define i32 @rmw(i32* %p, i32 %v) {
+; MISS-DAG: FastISel missed call: {{.*}}@llvm.aarch64.ldaxr
+; MISS-DAG: FastISel missed call: {{.*}}@llvm.aarch64.stlxr
+  %old = atomicrmw add i32* %p, i32 %v seq_cst
+  ret i32 %old
+}
@@ -0,0 +1,86 @@
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=aarch64-linux-gnu | FileCheck %s
+; RUN: llc < %s -O0 -fast-isel-verbose -mtriple=aarch64-linux-gnu -o /dev/null 2>&1 | FileCheck %s --check-prefix=MISS
+
+; Switches that take a single compare are selected by fast-isel.
+
+define i32 @single(i32 %x) {
+; CHECK-LABEL: single:
+; CHECK:       cmp w0, #7
+; CHECK-NEXT:  b.eq
+; CHECK-NEXT:  b .LBB
+entry:
+  switch i32 %x, label %def [ i32 7, label %case ]
+case:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+define i32 @range(i8 %x) {
+; CHECK-LABEL: range:
+; CHECK:       sxtb [[EXT:w[0-9]+]], w0
+; CHECK-NEXT:  add [[REG:w[0-9]+]], [[EXT]], #2
+; CHECK-NEXT:  cmp [[REG]], #3
+; CHECK-NEXT:  b.ls
+; CHECK-NEXT:  b .LBB
+entry:
+  switch i8 %x, label %def [ i8 0, label %case
+                             i8 -2, label %case
+                             i8 1, label %case
+                             i8 -1, label %case ]
+case:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+define i32 @range64(i64 %x) {
+; CHECK-LABEL: range64:
+; CHECK:       sub [[REG:x[0-9]+]], x0, #10
+; CHECK-NEXT:  cmp [[REG]], #2
+; CHECK-NEXT:  b.ls
+entry:
+  switch i64 %x, label %def [ i64 10, label %case
+                              i64 11, label %case
+                              i64 12, label %case ]
+case:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+define i32 @only_default(i64 %x) {
+; CHECK-LABEL: only_default:
+; CHECK-NOT:   cmp
+; CHECK:       b .LBB
+entry:
+  switch i64 %x, label %def [ ]
+def:
+  ret i32 0
+}
+
+; Switches needing a chain of compares are left to SelectionDAG.
+define i32 @chain(i32 %x) {
+; MISS:      FastISel missed terminator: switch i32 %x
+; MISS-NOT:  FastISel missed
+entry:
+  switch i32 %x, label %def [ i32 1, label %a
+                              i32 2, label %b ]
+a:
+  ret i32 1
+b:
+  ret i32 2
+def:
+  ret i32 0
+}
+
+define i32 @gap(i32 %x) {
+; MISS:      FastISel missed terminator: switch i32 %x
+entry:
+  switch i32 %x, label %def [ i32 1, label %a
+                              i32 3, label %a ]
+a:
+  ret i32 1
+def:
+  ret i32 0
+}
@@ -0,0 +1,171 @@
+; RUN: llc < %s -O0 -global-isel -global-isel-abort -verify-machineinstrs -mtriple=aarch64-linux-gnu | FileCheck %s
+; RUN: llc < %s -O0 -global-isel -global-isel-abort -verify-machineinstrs -mtriple=aarch64-linux-gnu -relocation-model=pic | FileCheck %s --check-prefix=PIC
+
+; Functions the global instruction selector handles entirely, without falling
+; back to SelectionDAG.
+
+@g = global i32 0
+@sarr = internal global [4 x { i32, i32 }] zeroinitializer
+
+declare i32 @callee(i32, i64)
+
+; CHECK-LABEL: add:
+; CHECK: add w0, w0, w1
+; CHECK: ret
+define i32 @add(i32 %a, i32 %b) {
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+; CHECK-LABEL: arith:
+; CHECK: mul x0, x0, x1
+; CHECK: movz [[R:x[0-9]+]], #0x2a
+; CHECK: sub x0, x0, [[R]]
+; CHECK: orr [[R:x[0-9]+]], xzr, #0x100000000
+; CHECK: orr x0, x0, [[R]]
+; CHECK: ret
+define i64 @arith(i64 %a, i64 %b) {
+  %x = mul i64 %a, %b
+  %y = sub i64 %x, 42
+  %z = or i64 %y, 4294967296
+  ret i64 %z
+}
+
+; CHECK-LABEL: sum:
+; CHECK: cmp
+; CHECK-NEXT: cset [[C:w[0-9]+]], lt
+; CHECK: cbnz [[C]]
+; CHECK: ret
+define i32 @sum(i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %s.next = add i32 %s, %i
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %exit
+exit:
+  ret i32 %s.next
+}
+
+; CHECK-LABEL: exts:
+; CHECK: mov w[[A:[0-9]+]], w0
+; CHECK: sxtw [[B:x[0-9]+]]
+; CHECK: add x0, x[[A]], [[B]]
+; CHECK: ret
+define i64 @exts(i32 %a, i32 %b) {
+  %a1 = zext i32 %a to i64
+  %b1 = sext i32 %b to i64
+  %s = add i64 %a1, %b1
+  ret i64 %s
+}
+
+; CHECK-LABEL: trunc:
+; CHECK: mov [[R:w[0-9]+]], w0
+; CHECK: mov w0, [[R]]
+; CHECK: ret
+define i32 @trunc(i64 %a) {
+  %t = trunc i64 %a to i32
+  ret i32 %t
+}
+
+; CHECK-LABEL: cmp:
+; CHECK: cmp w0, w1
+; CHECK: cset w0, hi
+; CHECK: ret
+define zeroext i1 @cmp(i32 %a, i32 %b) {
+  %c = icmp ugt i32 %a, %b
+  ret i1 %c
+}
+
+; CHECK-LABEL: bool:
+; CHECK: cmp w0, w1
+; CHECK-NEXT: cset [[C:w[0-9]+]], eq
+; CHECK-NEXT: and w0, [[C]], w2
+; CHECK-NEXT: ret
+define i32 @bool(i32 %a, i32 %b, i1 zeroext %f) {
+  %c = icmp eq i32 %a, %b
+  %d = and i1 %c, %f
+  %e = zext i1 %d to i32
+  ret i32 %e
+}
+
+; CHECK-LABEL: nothing:
+; CHECK-NEXT: .cfi_startproc
+; CHECK-NEXT: // BB#0:
+; CHECK-NEXT: ret
+define void @nothing() {
+  ret void
+}
+
+; CHECK-LABEL: local:
+; CHECK: add [[P:x[0-9]+]], sp, #12
+; CHECK-NEXT: str w0, {{\[}}[[P]]{{\]}}
+; CHECK-NEXT: ldr w0, {{\[}}[[P]]{{\]}}
+define i32 @local(i32 %a) {
+  %p = alloca i32
+  store i32 %a, i32* %p
+  %v = load volatile i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: global:
+; CHECK: adrp [[P:x[0-9]+]], g
+; CHECK-NEXT: add [[P]], [[P]], :lo12:g
+; CHECK-NEXT: ldr [[V:w[0-9]+]], {{\[}}[[P]]{{\]}}
+; CHECK: str [[V]], {{\[}}[[P]]{{\]}}
+; PIC-LABEL: global:
+; PIC: adrp [[P:x[0-9]+]], :got:g
+; PIC-NEXT: ldr [[P]], {{\[}}[[P]], :got_lo12:g{{\]}}
+define i32 @global() {
+  %v = load i32, i32* @g
+  %w = add i32 %v, 1
+  store i32 %w, i32* @g
+  ret i32 %w
+}
+
+; Booleans take a byte in memory.
+; CHECK-LABEL: bool_mem:
+; CHECK: strb w0, {{\[}}[[P:x[0-9]+]]{{\]}}
+; CHECK-NEXT: ldrb w0, {{\[}}[[P]]{{\]}}
+define zeroext i1 @bool_mem(i1 zeroext %b) {
+  %p = alloca i1
+  store i1 %b, i1* %p
+  %v = load i1, i1* %p
+  ret i1 %v
+}
+
+; CHECK-LABEL: struct_gep:
+; CHECK: adrp [[P:x[0-9]+]], sarr
+; CHECK-NEXT: add [[P]], [[P]], :lo12:sarr
+; CHECK-NEXT: orr [[S:x[0-9]+]], xzr, #0x8
+; CHECK-NEXT: mul [[I:x[0-9]+]], x0, [[S]]
+; CHECK-NEXT: add [[P]], [[P]], [[I]]
+; CHECK-NEXT: orr [[O:x[0-9]+]], xzr, #0x4
+; CHECK-NEXT: add [[P]], [[P]], [[O]]
+; CHECK-NEXT: ldr w0, {{\[}}[[P]]{{\]}}
+define i32 @struct_gep(i64 %i) {
+  %p = getelementptr [4 x { i32, i32 }], [4 x { i32, i32 }]* @sarr, i64 0, i64 %i, i32 1
+  %v = load i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: call:
+; CHECK: sxtw x1,
+; CHECK: bl callee
+; CHECK: add w0, w0,
+define i32 @call(i32 %a, i32 %b) {
+  %b1 = sext i32 %b to i64
+  %r = call i32 @callee(i32 %a, i64 %b1)
+  %s = add i32 %r, %a
+  ret i32 %s
+}
+
+; CHECK-LABEL: indirect:
+; CHECK: blr {{x[0-9]+}}
+define void @indirect(void (i8*)* %f, i8* %p) {
+  call void %f(i8* %p)
+  ret void
+}
@@ -70,10 +70,10 @@ define void @atomic_fetch_and16() nounwind {
 ; X32:       lock
 ; X32:       andw $3
   %t2 = atomicrmw and  i16* @sc16, i16 5 acquire
-; X64:       andl
+; X64:       andw
 ; X64:       lock
 ; X64:       cmpxchgw
-; X32:       andl
+; X32:       andw
 ; X32:       lock
 ; X32:       cmpxchgw
   %t3 = atomicrmw and  i16* @sc16, i16 %t2 acquire
@@ -95,10 +95,10 @@ define void @atomic_fetch_or16() nounwind {
 ; X32:       lock
 ; X32:       orw $3
   %t2 = atomicrmw or   i16* @sc16, i16 5 acquire
-; X64:       orl
+; X64:       orw
 ; X64:       lock
 ; X64:       cmpxchgw
-; X32:       orl
+; X32:       orw
 ; X32:       lock
 ; X32:       cmpxchgw
   %t3 = atomicrmw or   i16* @sc16, i16 %t2 acquire
@@ -120,10 +120,10 @@ define void @atomic_fetch_xor16() nounwind {
 ; X32:       lock
 ; X32:       xorw $3
   %t2 = atomicrmw xor  i16* @sc16, i16 5 acquire
-; X64:       xorl
+; X64:       xorw
 ; X64:       lock
 ; X64:       cmpxchgw
-; X32:       xorl
+; X32:       xorw
 ; X32:       lock
 ; X32:       cmpxchgw
   %t3 = atomicrmw xor  i16* @sc16, i16 %t2 acquire
@@ -140,12 +140,12 @@ define void @atomic_fetch_nand16(i16 %x) nounwind {
 ; X64-LABEL:   atomic_fetch_nand16
 ; X32-LABEL:   atomic_fetch_nand16
   %t1 = atomicrmw nand i16* @sc16, i16 %x acquire
-; X64:       andl
-; X64:       notl
+; X64:       andw
+; X64:       xorw $-1
 ; X64:       lock
 ; X64:       cmpxchgw
-; X32:       andl
-; X32:       notl
+; X32:       andw
+; X32:       xorw $-1
 ; X32:       lock
 ; X32:       cmpxchgw
   ret void
@@ -155,16 +155,12 @@ define void @atomic_fetch_nand16(i16 %x) nounwind {
 
 define void @atomic_fetch_max16(i16 %x) nounwind {
   %t1 = atomicrmw max  i16* @sc16, i16 %x acquire
-; X64:       movswl
-; X64:       movswl
-; X64:       subl
+; X64:       cmpw
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgw
 
-; X32:       movswl
-; X32:       movswl
-; X32:       subl
+; X32:       cmpw
 ; X32:       cmov
 ; X32:       lock
 ; X32:       cmpxchgw
@@ -175,16 +171,12 @@ define void @atomic_fetch_max16(i16 %x) nounwind {
 
 define void @atomic_fetch_min16(i16 %x) nounwind {
   %t1 = atomicrmw min  i16* @sc16, i16 %x acquire
-; X64:       movswl
-; X64:       movswl
-; X64:       subl
+; X64:       cmpw
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgw
 
-; X32:       movswl
-; X32:       movswl
-; X32:       subl
+; X32:       cmpw
 ; X32:       cmov
 ; X32:       lock
 ; X32:       cmpxchgw
@@ -195,16 +187,12 @@ define void @atomic_fetch_min16(i16 %x) nounwind {
 
 define void @atomic_fetch_umax16(i16 %x) nounwind {
   %t1 = atomicrmw umax i16* @sc16, i16 %x acquire
-; X64:       movzwl
-; X64:       movzwl
-; X64:       subl
+; X64:       cmpw
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgw
 
-; X32:       movzwl
-; X32:       movzwl
-; X32:       subl
+; X32:       cmpw
 ; X32:       cmov
 ; X32:       lock
 ; X32:       cmpxchgw
@@ -215,16 +203,12 @@ define void @atomic_fetch_umax16(i16 %x) nounwind {
 
 define void @atomic_fetch_umin16(i16 %x) nounwind {
   %t1 = atomicrmw umin i16* @sc16, i16 %x acquire
-; X64:       movzwl
-; X64:       movzwl
-; X64:       subl
+; X64:       cmpw
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgw
 
-; X32:       movzwl
-; X32:       movzwl
-; X32:       subl
+; X32:       cmpw
 ; X32:       cmov
 ; X32:       lock
 ; X32:       cmpxchgw
@@ -94,7 +94,7 @@ define void @atomic_fetch_nand32(i32 %x) nounwind {
 ; WITH-CMOV-LABEL:   atomic_fetch_nand32:
   %t1 = atomicrmw nand i32* @sc32, i32 %x acquire
 ; WITH-CMOV:       andl
-; WITH-CMOV:       notl
+; WITH-CMOV:       xorl $-1
 ; WITH-CMOV:       lock
 ; WITH-CMOV:       cmpxchgl
   ret void
@@ -105,13 +105,13 @@ define void @atomic_fetch_max32(i32 %x) nounwind {
 ; WITH-CMOV-LABEL: atomic_fetch_max32:
 
   %t1 = atomicrmw max  i32* @sc32, i32 %x acquire
-; WITH-CMOV:       subl
+; WITH-CMOV:       cmpl
 ; WITH-CMOV:       cmov
 ; WITH-CMOV:       lock
 ; WITH-CMOV:       cmpxchgl
 
-; NOCMOV:    subl
-; NOCMOV:    jge
+; NOCMOV:    cmpl
+; NOCMOV:    jg
 ; NOCMOV:    lock
 ; NOCMOV:    cmpxchgl
   ret void
@@ -124,12 +124,12 @@ define void @atomic_fetch_min32(i32 %x) nounwind {
 ; NOCMOV-LABEL: atomic_fetch_min32:
 
   %t1 = atomicrmw min  i32* @sc32, i32 %x acquire
-; WITH-CMOV:       subl
+; WITH-CMOV:       cmpl
 ; WITH-CMOV:       cmov
 ; WITH-CMOV:       lock
 ; WITH-CMOV:       cmpxchgl
 
-; NOCMOV:    subl
+; NOCMOV:    cmpl
 ; NOCMOV:    jle
 ; NOCMOV:    lock
 ; NOCMOV:    cmpxchgl
@@ -143,12 +143,12 @@ define void @atomic_fetch_umax32(i32 %x) nounwind {
 ; NOCMOV-LABEL: atomic_fetch_umax32:
 
   %t1 = atomicrmw umax i32* @sc32, i32 %x acquire
-; WITH-CMOV:       subl
+; WITH-CMOV:       cmpl
 ; WITH-CMOV:       cmov
 ; WITH-CMOV:       lock
 ; WITH-CMOV:       cmpxchgl
 
-; NOCMOV:    subl
+; NOCMOV:    cmpl
 ; NOCMOV:    ja
 ; NOCMOV:    lock
 ; NOCMOV:    cmpxchgl
@@ -162,12 +162,12 @@ define void @atomic_fetch_umin32(i32 %x) nounwind {
 ; NOCMOV-LABEL: atomic_fetch_umin32:
 
   %t1 = atomicrmw umin i32* @sc32, i32 %x acquire
-; WITH-CMOV:       subl
+; WITH-CMOV:       cmpl
 ; WITH-CMOV:       cmov
 ; WITH-CMOV:       lock
 ; WITH-CMOV:       cmpxchgl
 
-; NOCMOV:    subl
+; NOCMOV:    cmpl
 ; NOCMOV:    jb
 ; NOCMOV:    lock
 ; NOCMOV:    cmpxchgl
@@ -48,7 +48,7 @@ define void @atomic_fetch_and64() nounwind {
 ; X64:       lock
 ; X64:       andq $3
   %t2 = atomicrmw and  i64* @sc64, i64 5 acquire
-; X64:       andl
+; X64:       andq
 ; X64:       lock
 ; X64:       cmpxchgq
   %t3 = atomicrmw and  i64* @sc64, i64 %t2 acquire
@@ -97,7 +97,7 @@ define void @atomic_fetch_nand64(i64 %x) nounwind {
 ; X32-LABEL:   atomic_fetch_nand64:
   %t1 = atomicrmw nand i64* @sc64, i64 %x acquire
 ; X64:       andq
-; X64:       notq
+; X64:       xorq $-1
 ; X64:       lock
 ; X64:       cmpxchgq
 ; X32:       andl
@@ -115,7 +115,7 @@ define void @atomic_fetch_max64(i64 %x) nounwind {
 ; X64-LABEL:   atomic_fetch_max64:
 ; X32-LABEL:   atomic_fetch_max64:
   %t1 = atomicrmw max  i64* @sc64, i64 %x acquire
-; X64:       subq
+; X64:       cmpq
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgq
@@ -136,7 +136,7 @@ define void @atomic_fetch_min64(i64 %x) nounwind {
 ; X64-LABEL:   atomic_fetch_min64:
 ; X32-LABEL:   atomic_fetch_min64:
   %t1 = atomicrmw min  i64* @sc64, i64 %x acquire
-; X64:       subq
+; X64:       cmpq
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgq
@@ -157,7 +157,7 @@ define void @atomic_fetch_umax64(i64 %x) nounwind {
 ; X64-LABEL:   atomic_fetch_umax64:
 ; X32-LABEL:   atomic_fetch_umax64:
   %t1 = atomicrmw umax i64* @sc64, i64 %x acquire
-; X64:       subq
+; X64:       cmpq
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgq
@@ -178,7 +178,7 @@ define void @atomic_fetch_umin64(i64 %x) nounwind {
 ; X64-LABEL:   atomic_fetch_umin64:
 ; X32-LABEL:   atomic_fetch_umin64:
   %t1 = atomicrmw umin i64* @sc64, i64 %x acquire
-; X64:       subq
+; X64:       cmpq
 ; X64:       cmov
 ; X64:       lock
 ; X64:       cmpxchgq
@@ -0,0 +1,19 @@
+; RUN: rm -rf %t.cache
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -cache-dir=%t.cache -o %t1.s %s
+; RUN: ls %t.cache | count 1
+; RUN: FileCheck %s < %t1.s
+
+; The cached assembly is the same as the assembly that is not cached.
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -cache-dir=%t.cache -o %t2.s %s
+; RUN: ls %t.cache | count 1
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -o %t3.s %s
+; RUN: cmp %t1.s %t2.s
+; RUN: cmp %t1.s %t3.s
+
+; CHECK: foo:
+; CHECK: leal 1(%rdi), %eax
+
+define i32 @foo(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
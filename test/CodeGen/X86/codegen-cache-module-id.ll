@@ -0,0 +1,30 @@
+; Modules with the same IR but different identifiers get different entries,
+; since the identifier names the source file in the object.
+; RUN: rm -rf %t.cache %t.dir
+; RUN: mkdir -p %t.dir
+; RUN: cp %s %t.dir/a.ll
+; RUN: cp %s %t.dir/b.ll
+; RUN: cd %t.dir
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -cache-dir=%t.cache -o a.o a.ll
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -cache-dir=%t.cache -o b.o b.ll
+; RUN: ls %t.cache | count 2
+; RUN: llvm-readobj -t a.o | FileCheck %s --check-prefix=A
+; RUN: llvm-readobj -t b.o | FileCheck %s --check-prefix=B
+
+; A: Name: a.ll
+; A-NEXT: Value: 0x0
+; A-NEXT: Size: 0
+; A-NEXT: Binding: Local
+; A-NEXT: Type: File
+; B: Name: b.ll
+; B-NEXT: Value: 0x0
+; B-NEXT: Size: 0
+; B-NEXT: Binding: Local
+; B-NEXT: Type: File
+
+define i32 @foo(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
@@ -0,0 +1,35 @@
+; REQUIRES: shell
+; RUN: rm -rf %t.cache
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -cache-dir=%t.cache -o %t1.o %s
+; RUN: ls %t.cache | count 1
+
+; A second compilation with the same options reads the cached object.
+; RUN: %python -c "import glob; [open(f, 'w').write('cached') \
+; RUN:   for f in glob.glob('%t.cache/llvmcache-*')]"
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -cache-dir=%t.cache -o %t2.o %s
+; RUN: FileCheck %s --check-prefix=HIT < %t2.o
+; HIT: cached
+
+; Different options produce a different entry.
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj -O0 \
+; RUN:   -cache-dir=%t.cache -o %t3.o %s
+; RUN: ls %t.cache | count 2
+; RUN: llvm-nm %t3.o | FileCheck %s
+
+; Pruning removes the least recently used entries to honor the size limit.
+; RUN: %python -c "open('%t.cache/llvmcache-old', 'w').write('x' * (2 << 20))"
+; RUN: touch -t 200001010000 %t.cache/llvmcache-old
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj -O1 \
+; RUN:   -cache-dir=%t.cache -cache-max-size=1 -o %t4.o %s
+; RUN: ls %t.cache | FileCheck %s --check-prefix=PRUNED
+; RUN: ls %t.cache | count 3
+; PRUNED-NOT: llvmcache-old
+
+; CHECK: T foo
+
+define i32 @foo(i32 %x) {
+  %y = add i32 %x, 1
+  ret i32 %y
+}
@@ -0,0 +1,76 @@
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=x86_64-unknown-unknown | FileCheck %s
+
+; Atomic loads, stores, fences and read-modify-write operations that map to
+; single instructions are selected by fast-isel.
+
+define i32 @load_seq_cst(i32* %p) {
+; CHECK-LABEL: load_seq_cst:
+; CHECK:       movl (%rdi), %eax
+; CHECK-NEXT:  retq
+  %v = load atomic i32, i32* %p seq_cst, align 4
+  ret i32 %v
+}
+
+define void @store_release(i16* %p, i16 %v) {
+; CHECK-LABEL: store_release:
+; CHECK:       movw [[REG:%[a-z]+]], (%rdi)
+; CHECK-NEXT:  retq
+  store atomic i16 %v, i16* %p release, align 2
+  ret void
+}
+
+define void @store_seq_cst(i64* %p, i64 %v) {
+; CHECK-LABEL: store_seq_cst:
+; CHECK:       xchgq %rsi, (%rdi)
+  store atomic i64 %v, i64* %p seq_cst, align 8
+  ret void
+}
+
+define void @fences() {
+; CHECK-LABEL: fences:
+; CHECK-NOT:   mfence
+; CHECK:       #MEMBARRIER
+; CHECK-NEXT:  #MEMBARRIER
+; CHECK-NEXT:  mfence
+; CHECK-NEXT:  retq
+  fence acquire
+  fence singlethread seq_cst
+  fence seq_cst
+  ret void
+}
+
+define i32 @rmw_add(i32* %p, i32 %v) {
+; CHECK-LABEL: rmw_add:
+; CHECK:       lock xaddl %esi, (%rdi)
+  %o = atomicrmw add i32* %p, i32 %v seq_cst
+  ret i32 %o
+}
+
+define i8 @rmw_sub(i8* %p, i8 %v) {
+; CHECK-LABEL: rmw_sub:
+; CHECK:       negb [[REG:%[a-z]+]]
+; CHECK-NEXT:  lock xaddb [[REG]], (%rdi)
+  %o = atomicrmw sub i8* %p, i8 %v monotonic
+  ret i8 %o
+}
+
+define i64 @rmw_xchg(i64* %p, i64 %v) {
+; CHECK-LABEL: rmw_xchg:
+; CHECK:       xchgq %rsi, (%rdi)
+  %o = atomicrmw xchg i64* %p, i64 %v acquire
+  ret i64 %o
+}
+
+define i32 @cmpxchg(i32* %p, i32 %old, i32 %new, i8* %ok) {
+; CHECK-LABEL: cmpxchg:
+; CHECK:       movl %esi, %eax
+; CHECK-NEXT:  lock cmpxchgl %edx, (%rdi)
+; CHECK-NEXT:  sete [[OK:%[a-z0-9]+]]
+; CHECK:       movb [[OK]], (%rcx)
+  %r = cmpxchg i32* %p, i32 %old, i32 %new acq_rel monotonic
+  %v = extractvalue { i32, i1 } %r, 0
+  %s = extractvalue { i32, i1 } %r, 1
+  %z = zext i1 %s to i8
+  store i8 %z, i8* %ok
+  ret i32 %v
+}
@@ -0,0 +1,23 @@
+; RUN: llc < %s -O0 -mtriple=x86_64-unknown-unknown -stats -o /dev/null 2>&1 | FileCheck %s
+; RUN: llc < %s -O0 -mtriple=x86_64-unknown-unknown -stats -stats-json -o /dev/null 2>&1 | FileCheck %s --check-prefix=JSON
+; REQUIRES: asserts
+
+; Instructions that fast-isel falls back to SelectionDAG on are counted per
+; opcode whenever statistics are enabled.
+
+; CHECK-DAG: 1 isel - Fast isel fails on ShuffleVector
+; CHECK-DAG: 2 isel - Fast isel fails on InsertElement
+; JSON: {"name":"isel","desc":"Fast isel fails on InsertElement","value":2}
+
+define <4 x i32> @shuffle(<4 x i32> %a) {
+  %r = shufflevector <4 x i32> %a, <4 x i32> undef, <4 x i32> <i32 1, i32 0, i32 3, i32 2>
+  ret <4 x i32> %r
+}
+
+define <4 x i32> @insert(<4 x i32> %a, i32 %b) {
+  %r = insertelement <4 x i32> %a, i32 %b, i32 1
+  br label %next
+next:
+  %s = insertelement <4 x i32> %r, i32 %b, i32 2
+  ret <4 x i32> %s
+}
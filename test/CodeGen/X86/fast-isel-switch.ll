@@ -0,0 +1,70 @@
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=x86_64-unknown-unknown | FileCheck %s
+; RUN: llc < %s -O0 -fast-isel-verbose -mtriple=x86_64-unknown-unknown -o /dev/null 2>&1 | FileCheck %s --check-prefix=MISS
+
+; Switches that take a single compare are selected by fast-isel.
+
+define i32 @single(i32 %x) {
+; CHECK-LABEL: single:
+; CHECK:       cmpl $7, %edi
+; CHECK-NEXT:  je
+; CHECK-NEXT:  jmp
+entry:
+  switch i32 %x, label %def [ i32 7, label %case ]
+case:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+define i32 @range(i8 %x) {
+; CHECK-LABEL: range:
+; CHECK:       subb $-2, [[REG:%[a-z]+]]
+; CHECK-NEXT:  cmpb $3, [[REG]]
+; CHECK-NEXT:  jbe
+; CHECK-NEXT:  jmp
+entry:
+  switch i8 %x, label %def [ i8 0, label %case
+                             i8 -2, label %case
+                             i8 1, label %case
+                             i8 -1, label %case ]
+case:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+define i32 @only_default(i64 %x) {
+; CHECK-LABEL: only_default:
+; CHECK-NOT:   cmp
+; CHECK:       jmp
+entry:
+  switch i64 %x, label %def [ ]
+def:
+  ret i32 0
+}
+
+; Switches needing a chain of compares are left to SelectionDAG.
+define i32 @chain(i32 %x) {
+; MISS:      FastISel missed terminator: switch i32 %x
+; MISS-NOT:  FastISel missed
+entry:
+  switch i32 %x, label %def [ i32 1, label %a
+                              i32 2, label %b ]
+a:
+  ret i32 1
+b:
+  ret i32 2
+def:
+  ret i32 0
+}
+
+define i32 @gap(i32 %x) {
+; MISS:      FastISel missed terminator: switch i32 %x
+entry:
+  switch i32 %x, label %def [ i32 1, label %a
+                              i32 3, label %a ]
+a:
+  ret i32 1
+def:
+  ret i32 0
+}
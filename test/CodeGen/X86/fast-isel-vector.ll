@@ -0,0 +1,65 @@
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=x86_64-unknown-unknown -mattr=+sse2 | FileCheck %s --check-prefix=ALL --check-prefix=SSE
+; RUN: llc < %s -O0 -fast-isel-abort=1 -verify-machineinstrs -mtriple=x86_64-unknown-unknown -mattr=+avx | FileCheck %s --check-prefix=ALL --check-prefix=AVX
+
+; Vector bitwise operations, constants, bitcasts and extracts of the lowest
+; element are selected by fast-isel.
+
+define <4 x i32> @and_v4i32(<4 x i32> %a, <4 x i32> %b) {
+; ALL-LABEL: and_v4i32:
+; SSE:       andps %xmm1, %xmm0
+; AVX:       vpand %xmm1, %xmm0, %xmm0
+; ALL-NEXT:  retq
+  %r = and <4 x i32> %a, %b
+  ret <4 x i32> %r
+}
+
+define <16 x i8> @xor_const(<16 x i8> %a) {
+; ALL-LABEL: xor_const:
+; SSE:       movdqa {{[^ ]+}}, [[REG:%xmm[0-9]+]]
+; SSE-NEXT:  xorps [[REG]], %xmm0
+; AVX:       vmovdqa {{[^ ]+}}, [[REG:%xmm[0-9]+]]
+; AVX-NEXT:  vpxor [[REG]], %xmm0, %xmm0
+  %r = xor <16 x i8> %a, <i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1, i8 -1, i8 1>
+  ret <16 x i8> %r
+}
+
+define <4 x float> @const_v4f32() {
+; ALL-LABEL: const_v4f32:
+; SSE:       movaps {{[^ ]+}}, %xmm0
+; AVX:       vmovaps {{[^ ]+}}, %xmm0
+; ALL-NEXT:  retq
+  ret <4 x float> <float 1.0, float 2.0, float 3.0, float 4.0>
+}
+
+define <2 x double> @zero_v2f64() {
+; ALL-LABEL: zero_v2f64:
+; SSE:       xorps %xmm0, %xmm0
+; AVX:       vxorps %xmm0, %xmm0, %xmm0
+; ALL-NEXT:  retq
+  ret <2 x double> zeroinitializer
+}
+
+define <4 x float> @bitcast(<4 x i32> %a) {
+; ALL-LABEL: bitcast:
+; ALL-NOT:   xmm
+; ALL:       retq
+  %r = bitcast <4 x i32> %a to <4 x float>
+  ret <4 x float> %r
+}
+
+define float @extract_f32(<4 x float> %a) {
+; ALL-LABEL: extract_f32:
+; ALL-NOT:   xmm
+; ALL:       retq
+  %r = extractelement <4 x float> %a, i32 0
+  ret float %r
+}
+
+define i64 @extract_i64(<2 x i64> %a) {
+; ALL-LABEL: extract_i64:
+; SSE:       movd %xmm0, %rax
+; AVX:       vmovq %xmm0, %rax
+; ALL-NEXT:  retq
+  %r = extractelement <2 x i64> %a, i32 0
+  ret i64 %r
+}
@@ -312,3 +312,18 @@ define void @allocamaterialize() {
   call void @takesi32ptr(i32* %a)
   ret void
 }
+
+declare void @llvm.memmove.p0i8.p0i8.i64(i8*, i8*, i64, i32, i1)
+declare void @llvm.memset.p0i8.i64(i8*, i8, i64, i32, i1)
+
+; memmove and volatile memcpy/memset become library calls.
+define void @test24(i8* %a, i8* %b, i64 %n) nounwind {
+  call void @llvm.memmove.p0i8.p0i8.i64(i8* %a, i8* %b, i64 %n, i32 1, i1 false)
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %a, i8* %b, i64 4, i32 4, i1 true)
+  call void @llvm.memset.p0i8.i64(i8* %a, i8 0, i64 %n, i32 1, i1 true)
+  ret void
+; CHECK-LABEL: test24:
+; CHECK: callq _memmove
+; CHECK: callq _memcpy
+; CHECK: callq _memset
+}
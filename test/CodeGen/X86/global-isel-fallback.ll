@@ -0,0 +1,44 @@
+; RUN: llc < %s -O0 -global-isel -verify-machineinstrs -mtriple=x86_64-linux | FileCheck %s
+; RUN: not llc < %s -O0 -global-isel -global-isel-abort -mtriple=x86_64-linux -o /dev/null 2>&1 | FileCheck %s --check-prefix=ABORT
+; RUN: llc < %s -O0 -global-isel -mtriple=x86_64-pc-win32 | FileCheck %s --check-prefix=WIN64
+
+; Functions the global instruction selector can't handle are selected by
+; SelectionDAG instead.
+
+declare void @g(i32*)
+
+; ABORT: LLVM ERROR: global instruction selector failed on function 'dynamic_alloca': unsupported dynamic alloca
+; CHECK-LABEL: dynamic_alloca:
+; CHECK: callq g
+; CHECK: retq
+define void @dynamic_alloca(i32 %n) {
+  %p = alloca i32, i32 %n
+  call void @g(i32* %p)
+  ret void
+}
+
+; CHECK-LABEL: float_load:
+; CHECK: movss (%rdi), %xmm0
+; CHECK-NEXT: retq
+define float @float_load(float* %p) {
+  %v = load float, float* %p
+  ret float %v
+}
+
+; Booleans that the caller didn't extend may have garbage in the upper bits.
+; CHECK-LABEL: bool_arg:
+; CHECK: retq
+define i32 @bool_arg(i1 %b) {
+  %e = zext i1 %b to i32
+  ret i32 %e
+}
+
+; The Win64 calling convention isn't supported.
+; WIN64-LABEL: add:
+; WIN64: addl %edx, %ecx
+; WIN64-NEXT: movl %ecx, %eax
+; WIN64-NEXT: retq
+define i32 @add(i32 %a, i32 %b) {
+  %r = add i32 %a, %b
+  ret i32 %r
+}
@@ -0,0 +1,264 @@
+; RUN: llc < %s -O0 -global-isel -global-isel-abort -verify-machineinstrs -mtriple=x86_64-linux | FileCheck %s
+; RUN: llc < %s -O0 -global-isel -mtriple=x86_64-linux -o /dev/null -print-after=irtranslator 2>&1 | FileCheck %s --check-prefix=GENERIC
+; RUN: llc < %s -O0 -global-isel -global-isel-abort -verify-machineinstrs -mtriple=x86_64-linux -relocation-model=pic | FileCheck %s --check-prefix=PIC
+
+; Functions the global instruction selector handles entirely, without falling
+; back to SelectionDAG.
+
+@g = global i32 0
+@arr = global [4 x i64] zeroinitializer
+@sarr = internal global [4 x { i32, i8 }] zeroinitializer
+
+declare i32 @callee(i32, i64)
+declare void @vcallee(i8*)
+declare i32 @printf(i8*, ...)
+declare void @llvm.lifetime.start(i64, i8*)
+declare void @llvm.lifetime.end(i64, i8*)
+
+; GENERIC-LABEL: Machine code for function add:
+; GENERIC: %vreg0<def> = COPY %EDI
+; GENERIC: %vreg1<def> = COPY %ESI
+; GENERIC: %vreg2<def> = G_ADD %vreg0, %vreg1
+; GENERIC: %EAX<def> = COPY %vreg2
+; GENERIC: RETQ %EAX<imp-use>
+; CHECK-LABEL: add:
+; CHECK: addl %esi, %edi
+; CHECK: movl %edi, %eax
+; CHECK: retq
+define i32 @add(i32 %a, i32 %b) {
+  %r = add i32 %a, %b
+  ret i32 %r
+}
+
+; CHECK-LABEL: arith:
+; CHECK: imulq %rsi, %rdi
+; CHECK: movq $42, [[R:%[a-z0-9]+]]
+; CHECK: subq [[R]], %rdi
+; CHECK: movabsq $4294967296, [[R:%[a-z0-9]+]]
+; CHECK: xorq [[R]], %rdi
+; CHECK: retq
+define i64 @arith(i64 %a, i64 %b) {
+  %x = mul i64 %a, %b
+  %y = sub i64 %x, 42
+  %z = xor i64 %y, 4294967296
+  ret i64 %z
+}
+
+; CHECK-LABEL: mul8:
+; CHECK: movb %dil, %al
+; CHECK: mulb %sil
+; CHECK: retq
+define i8 @mul8(i8 %a, i8 %b) {
+  %r = mul i8 %a, %b
+  ret i8 %r
+}
+
+; GENERIC-LABEL: Machine code for function sum:
+; GENERIC: G_BR <BB#1>
+; GENERIC: PHI
+; GENERIC: G_ICMP 40
+; GENERIC: G_BRCOND {{%vreg[0-9]+}}, <BB#1>
+; GENERIC: G_BR <BB#2>
+; CHECK-LABEL: sum:
+; CHECK: [[LOOP:.LBB[0-9_]+]]:
+; CHECK: cmpl
+; CHECK-NEXT: setl [[C:%[a-z]+]]
+; CHECK: testb [[C]], [[C]]
+; CHECK: jne [[LOOP]]
+; CHECK: retq
+define i32 @sum(i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %s.next = add i32 %s, %i
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %exit
+exit:
+  ret i32 %s.next
+}
+
+; CHECK-LABEL: exts:
+; CHECK-DAG: movzbl %dil
+; CHECK-DAG: movswq %si
+; CHECK-DAG: movl %edx
+; CHECK: retq
+define i64 @exts(i8 %a, i16 %b, i32 %c) {
+  %a1 = zext i8 %a to i64
+  %b1 = sext i16 %b to i64
+  %c1 = zext i32 %c to i64
+  %s = add i64 %a1, %b1
+  %t = add i64 %s, %c1
+  ret i64 %t
+}
+
+; CHECK-LABEL: trunc:
+; CHECK: movb %dil, %al
+; CHECK: movzbl %al, %eax
+; CHECK: retq
+define zeroext i8 @trunc(i64 %a) {
+  %t = trunc i64 %a to i8
+  ret i8 %t
+}
+
+; CHECK-LABEL: cmp:
+; CHECK: cmpl %esi, %edi
+; CHECK-NEXT: seta %al
+; CHECK-NEXT: movzbl %al, %eax
+; CHECK-NEXT: retq
+define zeroext i1 @cmp(i32 %a, i32 %b) {
+  %c = icmp ugt i32 %a, %b
+  ret i1 %c
+}
+
+; CHECK-LABEL: bool:
+; CHECK: sete %al
+; CHECK-NEXT: andb %dl, %al
+; CHECK-NEXT: movzbl %al, %eax
+; CHECK-NEXT: retq
+define i32 @bool(i32 %a, i32 %b, i1 zeroext %f) {
+  %c = icmp eq i32 %a, %b
+  %d = and i1 %c, %f
+  %e = zext i1 %d to i32
+  ret i32 %e
+}
+
+; CHECK-LABEL: bool8:
+; CHECK: cmpl %esi, %edi
+; CHECK-NEXT: sete %al
+; CHECK-NEXT: movzbl %al, %eax
+; CHECK-NEXT: retq
+define zeroext i8 @bool8(i32 %a, i32 %b) {
+  %c = icmp eq i32 %a, %b
+  %e = zext i1 %c to i8
+  ret i8 %e
+}
+
+; CHECK-LABEL: nothing:
+; CHECK-NEXT: .cfi_startproc
+; CHECK-NEXT: # BB#0:
+; CHECK-NEXT: retq
+define void @nothing() {
+  ret void
+}
+
+; GENERIC-LABEL: Machine code for function local:
+; GENERIC: [[P:%vreg[0-9]+]]<def> = G_FRAME_INDEX <fi#0>
+; GENERIC: G_STORE {{%vreg[0-9]+}}, [[P]]; mem:ST4[%p]
+; GENERIC: G_LOAD [[P]]; mem:Volatile LD4[%p]
+; CHECK-LABEL: local:
+; CHECK: leaq -4(%rsp), [[P:%[a-z]+]]
+; CHECK-NEXT: movl %edi, ([[P]])
+; CHECK-NEXT: movl ([[P]]), %eax
+; CHECK-NEXT: retq
+define i32 @local(i32 %a) {
+  %p = alloca i32
+  store i32 %a, i32* %p
+  %v = load volatile i32, i32* %p
+  ret i32 %v
+}
+
+; CHECK-LABEL: global:
+; CHECK: leaq g(%rip), [[P:%[a-z]+]]
+; CHECK-NEXT: movl ([[P]]), [[V:%[a-z]+]]
+; CHECK: movl [[V]], ([[P]])
+; PIC-LABEL: global:
+; PIC: movq g@GOTPCREL(%rip), [[P:%[a-z]+]]
+; PIC-NEXT: movl ([[P]]),
+define i32 @global() {
+  %v = load i32, i32* @g
+  %w = add i32 %v, 1
+  store i32 %w, i32* @g
+  ret i32 %w
+}
+
+; Variable indices are scaled by the size of the element, and the constant
+; offsets are added once at the end.
+; CHECK-LABEL: gep:
+; CHECK: movslq %esi, [[I:%[a-z]+]]
+; CHECK-NEXT: movq $8, [[S:%[a-z]+]]
+; CHECK-NEXT: imulq [[S]], [[I]]
+; CHECK-NEXT: addq [[I]], %rdi
+; CHECK-NEXT: movq $24, [[O:%[a-z]+]]
+; CHECK-NEXT: addq [[O]], %rdi
+; CHECK-NEXT: movq (%rdi), %rax
+define i64 @gep(i64* %p, i32 %i) {
+  %q = getelementptr i64, i64* %p, i32 %i
+  %r = getelementptr i64, i64* %q, i64 3
+  %v = load i64, i64* %r
+  ret i64 %v
+}
+
+; CHECK-LABEL: struct_gep:
+; CHECK: leaq sarr(%rip), [[P:%[a-z]+]]
+; CHECK-NEXT: movq $8, [[S:%[a-z]+]]
+; CHECK-NEXT: imulq [[S]], %rdi
+; CHECK-NEXT: addq %rdi, [[P]]
+; CHECK-NEXT: movq $4, [[O:%[a-z]+]]
+; CHECK-NEXT: addq [[O]], [[P]]
+; CHECK-NEXT: movb ([[P]]), %al
+; PIC-LABEL: struct_gep:
+; PIC: leaq sarr(%rip)
+define i8 @struct_gep(i64 %i) {
+  %p = getelementptr [4 x { i32, i8 }], [4 x { i32, i8 }]* @sarr, i64 0, i64 %i, i32 1
+  %v = load i8, i8* %p
+  ret i8 %v
+}
+
+; CHECK-LABEL: const_gep:
+; CHECK: leaq arr(%rip), [[P:%[a-z]+]]
+; CHECK-NEXT: movq $16, [[O:%[a-z]+]]
+; CHECK-NEXT: addq [[O]], [[P]]
+; CHECK-NEXT: movq ([[P]]), %rax
+define i64 @const_gep() {
+  %v = load i64, i64* getelementptr ([4 x i64], [4 x i64]* @arr, i64 0, i64 2)
+  ret i64 %v
+}
+
+; GENERIC-LABEL: Machine code for function call:
+; GENERIC: ADJCALLSTACKDOWN64 0, 0
+; GENERIC: CALL64pcrel32 <ga:@callee>, <regmask{{.*}}>, %EDI<imp-use>, %RSI<imp-use>, %EAX<imp-def>
+; GENERIC: ADJCALLSTACKUP64 0, 0
+; CHECK-LABEL: call:
+; CHECK: movsbq %sil, %rsi
+; CHECK: callq callee
+; CHECK: addl %edi, %eax
+; PIC-LABEL: call:
+; PIC: callq callee@PLT
+define i32 @call(i32 %a, i8 %b) {
+  %b1 = sext i8 %b to i64
+  %r = call i32 @callee(i32 %a, i64 %b1)
+  %s = add i32 %r, %a
+  ret i32 %s
+}
+
+; CHECK-LABEL: call_bitcast:
+; CHECK: leaq {{[0-9]+}}(%rsp), [[P:%[a-z]+]]
+; CHECK-NEXT: movq [[P]], %rdi
+; CHECK-NEXT: callq vcallee
+define void @call_bitcast() {
+  %buf = alloca [16 x i8]
+  %p = bitcast [16 x i8]* %buf to i8*
+  call void @llvm.lifetime.start(i64 16, i8* %p)
+  call void @vcallee(i8* %p)
+  call void @llvm.lifetime.end(i64 16, i8* %p)
+  ret void
+}
+
+; CHECK-LABEL: indirect:
+; CHECK: callq *{{%[a-z]+}}
+define void @indirect(void (i8*)* %f, i8* %p) {
+  call void %f(i8* %p)
+  ret void
+}
+
+; CHECK-LABEL: vararg:
+; CHECK: movl $1, %esi
+; CHECK-NEXT: movb $0, %al
+; CHECK-NEXT: callq printf
+define i32 @vararg(i8* %fmt) {
+  %r = call i32 (i8*, ...) @printf(i8* %fmt, i32 1)
+  ret i32 %r
+}
@@ -0,0 +1,39 @@
+; Check that -codegen-partitions splits the module into linkable objects and
+; that the output does not depend on the number of threads.
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -codegen-partitions=2 -j 2 -o %t.par %s
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj \
+; RUN:   -codegen-partitions=2 -j 1 -o %t.seq %s
+; RUN: cmp %t.par0 %t.seq0
+; RUN: cmp %t.par1 %t.seq1
+; RUN: llvm-nm %t.par0 %t.par1 | FileCheck %s
+
+; Without -codegen-partitions the module is not split, whatever -j is.
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj -j 2 -o %t.j2 %s
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -filetype=obj -o %t.j1 %s
+; RUN: cmp %t.j1 %t.j2
+; RUN: not ls %t.j20
+
+; Every definition ends up in one of the partitions, and local symbols are
+; promoted to globals so that the other partitions can refer to them.
+; CHECK-DAG: T foo
+; CHECK-DAG: T bar
+; CHECK-DAG: T baz.llvm.
+; CHECK-DAG: D gv
+
+@gv = global i32 1
+
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+define void @bar() {
+  call void @baz()
+  ret void
+}
+
+define internal void @baz() {
+  store i32 1, i32* @gv
+  ret void
+}
@@ -0,0 +1,26 @@
+; REQUIRES: shell
+; RUN: rm -rf %t.cache
+; RUN: mkdir -p %t.cache
+;
+; The JIT object cache and the code generation cache of llc can share a
+; directory: each one only prunes its own entries.
+;
+; RUN: %python -c "open('%t.cache/llvmcache-old', 'w').write('x' * (2 << 20))"
+; RUN: %python -c "open('%t.cache/llvmobjcache-old', 'w').write('x' * (2 << 20))"
+; RUN: touch -t 200001010000 %t.cache/llvmcache-old %t.cache/llvmobjcache-old
+; RUN: %lli -jit-object-cache-dir=%t.cache -jit-object-cache-size-limit=64 %s
+; RUN: ls %t.cache | FileCheck %s --check-prefix=JIT
+; RUN: ls %t.cache | count 2
+; JIT: llvmcache-old
+; JIT-NOT: llvmobjcache-old
+;
+; RUN: llc -filetype=obj -cache-dir=%t.cache -cache-max-size=1 -o %t.o %s
+; RUN: ls %t.cache | FileCheck %s --check-prefix=LLC
+; RUN: ls %t.cache | count 2
+; LLC-NOT: llvmcache-old
+; LLC: llvmobjcache-
+
+define i32 @main() {
+entry:
+  ret i32 0
+}
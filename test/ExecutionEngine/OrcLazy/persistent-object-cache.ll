@@ -0,0 +1,25 @@
+; REQUIRES: asserts
+; RUN: rm -rf %t.cache
+; RUN: lli -jit-kind=orc-lazy -jit-object-cache-dir=%t.cache -stats %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=FIRST %s
+; RUN: lli -jit-kind=orc-lazy -jit-object-cache-dir=%t.cache -stats %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=SECOND %s
+; RUN: ls %t.cache | count 3
+
+; The globals-and-stubs module and the partitions for main and foo are
+; compiled and stored by the first run, and all loaded by the second.
+; FIRST: 3 object-cache - Number of objects not found in the object cache
+; FIRST: 3 object-cache - Number of objects written to the object cache
+; SECOND: 3 object-cache - Number of objects loaded from the object cache
+; SECOND-NOT: object cache
+
+define i32 @foo() {
+entry:
+  ret i32 0
+}
+
+define i32 @main() {
+entry:
+  %r = call i32 @foo()
+  ret i32 %r
+}
@@ -0,0 +1,44 @@
+; RUN: lli -jit-kind=orc-lazy -orc-lazy-speculate-threads=2 %s | FileCheck %s
+;
+; Callees of compiled functions are compiled in the background, racing with
+; the calls made to them.
+;
+; CHECK: result = 120
+
+@fmt = private unnamed_addr constant [13 x i8] c"result = %d\0A\00"
+
+define i32 @fact(i32 %n) {
+entry:
+  %done = icmp sle i32 %n, 1
+  br i1 %done, label %base, label %recurse
+
+base:
+  ret i32 1
+
+recurse:
+  %m = sub i32 %n, 1
+  %r = call i32 @fact(i32 %m)
+  %p = mul i32 %n, %r
+  ret i32 %p
+}
+
+define i32 @compute(i32 %n) {
+entry:
+  %a = call i32 @fact(i32 %n)
+  %b = call i32 @identity(i32 %a)
+  ret i32 %b
+}
+
+define internal i32 @identity(i32 %x) {
+entry:
+  ret i32 %x
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+  %r = call i32 @compute(i32 5)
+  %0 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @fmt, i64 0, i64 0), i32 %r)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
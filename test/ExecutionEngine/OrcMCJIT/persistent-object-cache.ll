@@ -0,0 +1,19 @@
+; REQUIRES: asserts
+; RUN: rm -rf %t.cache
+; RUN: %lli -jit-kind=orc-mcjit -jit-object-cache-dir=%t.cache -stats %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=FIRST %s
+; RUN: %lli -jit-kind=orc-mcjit -jit-object-cache-dir=%t.cache -stats %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=SECOND %s
+; RUN: ls %t.cache | count 1
+
+; The first run compiles the module and stores its object; the second run
+; loads the object from the cache.
+; FIRST: 1 object-cache - Number of objects not found in the object cache
+; FIRST: 1 object-cache - Number of objects written to the object cache
+; SECOND: 1 object-cache - Number of objects loaded from the object cache
+; SECOND-NOT: object cache
+
+define i32 @main() {
+entry:
+  ret i32 0
+}
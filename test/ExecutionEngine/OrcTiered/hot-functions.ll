@@ -0,0 +1,53 @@
+; RUN: lli -jit-kind=orc-tiered -orc-tier-up-threshold=10 %s | FileCheck %s
+;
+; Functions called at least ten times through their stubs are recompiled, and
+; keep computing the same results afterwards.
+;
+; CHECK: sum = 5150
+; CHECK: calls = 101
+
+@calls = global i32 0, align 4
+@fmt = private unnamed_addr constant [21 x i8] c"sum = %d\0Acalls = %d\0A\00"
+
+define internal void @bump() {
+entry:
+  %0 = load i32, i32* @calls, align 4
+  %1 = add i32 %0, 1
+  store i32 %1, i32* @calls, align 4
+  ret void
+}
+
+define i32 @add_counted(i32 %a, i32 %b) {
+entry:
+  call void @bump()
+  %sum = add i32 %a, %b
+  ret i32 %sum
+}
+
+define void @report(i32 %sum) {
+entry:
+  %c = load i32, i32* @calls, align 4
+  %0 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([21 x i8], [21 x i8]* @fmt, i64 0, i64 0), i32 %sum, i32 %c)
+  ret void
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %t = add i32 %i, 1
+  %acc.next = call i32 @add_counted(i32 %acc, i32 %t)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 100
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %final = call i32 @add_counted(i32 %acc.next, i32 100)
+  call void @report(i32 %final)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
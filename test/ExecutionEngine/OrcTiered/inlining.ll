@@ -0,0 +1,51 @@
+; RUN: lli -jit-kind=orc-tiered -orc-tier-up-threshold=10 \
+; RUN:   -debug-only=orc-tiered %s 2>&1 | FileCheck %s --check-prefix=TIERUP
+; RUN: lli -jit-kind=orc-tiered -orc-tier-up-threshold=10 \
+; RUN:   -debug-only=inline %s 2>&1 | FileCheck %s --check-prefix=INLINE
+; REQUIRES: asserts
+;
+; A hot function is recompiled along with copies of the functions it calls, so
+; that they can be inlined into it. Functions that don't get hot are left
+; alone.
+;
+; TIERUP-DAG: [tier-up] square_plus_one
+; TIERUP-DAG: [tier-up] square
+; TIERUP-NOT: [tier-up] main
+;
+; INLINE: Inliner visiting SCC: square_plus_one
+; INLINE: Inlining: {{.*}}call i32 @square(
+
+@fmt = private unnamed_addr constant [13 x i8] c"result = %d\0A\00"
+
+define internal i32 @square(i32 %x) {
+entry:
+  %sq = mul i32 %x, %x
+  ret i32 %sq
+}
+
+define i32 @square_plus_one(i32 %x) {
+entry:
+  %sq = call i32 @square(i32 %x)
+  %r = add i32 %sq, 1
+  ret i32 %r
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %v = call i32 @square_plus_one(i32 %i)
+  %acc.next = add i32 %acc, %v
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 100
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %0 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @fmt, i64 0, i64 0), i32 %acc.next)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
@@ -0,0 +1,111 @@
+; RUN: %lli -force-interpreter=true %s
+
+; Exercise the pre-decoded instruction handlers of the interpreter.  main
+; returns the number of the first failing check, or 0.
+
+%pair = type { i8, i64 }
+
+declare i32 @llvm.bswap.i32(i32)
+
+; The PHI nodes on the back edge swap %a and %b: their copies must happen in
+; parallel.
+define i32 @swap(i32 %n) {
+entry:
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %a = phi i32 [ 1, %entry ], [ %b, %loop ]
+  %b = phi i32 [ 2, %entry ], [ %a, %loop ]
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+exit:
+  %r = sub i32 %a, %b
+  ret i32 %r
+}
+
+; The intrinsic is lowered while the outer calls of this function are still
+; executing; they must resume at the right instruction.
+define i32 @lower(i32 %n) {
+entry:
+  %base = icmp eq i32 %n, 0
+  br i1 %base, label %done, label %rec
+rec:
+  %n1 = sub i32 %n, 1
+  %r1 = call i32 @lower(i32 %n1)
+  %s = call i32 @llvm.bswap.i32(i32 %r1)
+  %t = call i32 @llvm.bswap.i32(i32 %s)
+  %r = add i32 %t, 1
+  ret i32 %r
+done:
+  ret i32 0
+}
+
+define i32 @main() {
+entry:
+  %p = alloca %pair
+  %s1 = call i32 @swap(i32 2)
+  %c1 = icmp eq i32 %s1, 1
+  br i1 %c1, label %t2, label %fail1
+
+t2:
+  %l = call i32 @lower(i32 5)
+  %c2 = icmp eq i32 %l, 5
+  br i1 %c2, label %t3, label %fail2
+
+t3:
+  ; Unordered comparisons are true on NaN, ordered ones false.
+  %nan = fdiv double 0.0, 0.0
+  %une = fcmp une double %nan, %nan
+  %one = fcmp one double %nan, 1.0
+  %ok3 = xor i1 %one, %une
+  br i1 %ok3, label %t4, label %fail3
+
+t4:
+  ; Narrow integers wrap and sign extend correctly.
+  %x = add i8 127, 1
+  %xs = sext i8 %x to i32
+  %c4 = icmp eq i32 %xs, -128
+  %y = trunc i32 %xs to i1
+  %c4b = icmp eq i1 %y, false
+  %ok4 = and i1 %c4, %c4b
+  br i1 %ok4, label %t5, label %fail4
+
+t5:
+  ; Loads and stores through struct GEPs.
+  %f0 = getelementptr %pair, %pair* %p, i32 0, i32 0
+  %f1 = getelementptr %pair, %pair* %p, i32 0, i32 1
+  store i8 -1, i8* %f0
+  store i64 -2, i64* %f1
+  %v0 = load i8, i8* %f0
+  %v1 = load i64, i64* %f1
+  %v0s = sext i8 %v0 to i64
+  %c5 = icmp eq i64 %v0s, -1
+  %c5b = icmp slt i64 %v1, 0
+  %ok5 = and i1 %c5, %c5b
+  br i1 %ok5, label %t6, label %fail5
+
+t6:
+  ; Pointers compare unsigned, and select picks the right one.
+  %lo = bitcast i8* %f0 to i64*
+  %lt = icmp ult i64* %lo, %f1
+  %min = select i1 %lt, i64* %lo, i64* %f1
+  %c6 = icmp eq i64* %min, %lo
+  %ok6 = and i1 %lt, %c6
+  br i1 %ok6, label %pass, label %fail6
+
+pass:
+  ret i32 0
+fail1:
+  ret i32 1
+fail2:
+  ret i32 2
+fail3:
+  ret i32 3
+fail4:
+  ret i32 4
+fail5:
+  ret i32 5
+fail6:
+  ret i32 6
+}
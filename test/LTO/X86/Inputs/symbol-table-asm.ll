@@ -0,0 +1 @@
+module asm ".text"
@@ -0,0 +1,28 @@
+; REQUIRES: shell
+; RUN: rm -rf %t.cache
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-lto -exported-symbol=foo -cache-dir=%t.cache -o %t1.o %t.bc
+; RUN: ls %t.cache | count 1
+; RUN: llvm-lto -exported-symbol=foo -cache-dir=%t.cache -o %t2.o %t.bc
+; RUN: cmp %t1.o %t2.o
+; RUN: ls %t.cache | count 1
+
+; Each partition of a parallel compilation gets its own entry.
+; RUN: llvm-lto -exported-symbol=foo -exported-symbol=bar -j2 \
+; RUN:   -cache-dir=%t.cache -o %t3.o %t.bc
+; RUN: ls %t.cache | count 3
+; RUN: llvm-lto -exported-symbol=foo -exported-symbol=bar -j2 \
+; RUN:   -cache-dir=%t.cache -o %t4.o %t.bc
+; RUN: cmp %t3.o0 %t4.o0
+; RUN: cmp %t3.o1 %t4.o1
+; RUN: ls %t.cache | count 3
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  ret void
+}
+
+define void @bar() {
+  ret void
+}
@@ -0,0 +1,19 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto -exported-symbol=foo -exported-symbol=bar -j2 \
+; RUN:   -use-diagnostic-handler -o %t.o %t.bc 2>&1 | FileCheck %s
+
+; The partitions are code generated in contexts of their own, which must
+; report their diagnostics through the handler of the client instead of
+; exiting.
+; CHECK: error: invalid operand for inline asm constraint 'L'
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  call void asm "", "L,~{dirflag},~{fpsr},~{flags}"(i32 7)
+  ret void
+}
+
+define void @bar() {
+  ret void
+}
@@ -0,0 +1,28 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto -exported-symbol=foo -exported-symbol=bar -j2 -o %t.o %t.bc
+; RUN: llvm-nm %t.o0 %t.o1 | FileCheck %s
+
+; The merged module is split into two objects. Every definition ends up in one
+; of them, and local symbols are promoted so that the other can refer to them.
+; CHECK-DAG: T foo
+; CHECK-DAG: T bar
+; CHECK-DAG: T baz.llvm.
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  call void @baz()
+  ret void
+}
+
+define void @bar() {
+  call void @baz()
+  ret void
+}
+
+declare void @ext()
+
+define internal void @baz() noinline {
+  call void @ext()
+  ret void
+}
@@ -0,0 +1,56 @@
+; Symbol-only modules are read from the symbol table of the bitcode. The
+; module-level asm of the second file makes the writer omit the table, so its
+; symbols come from the parsed module; both have to agree.
+; RUN: llvm-as %s -o %t.bc
+; RUN: cat %s %S/Inputs/symbol-table-asm.ll | llvm-as -o %t.asm.bc
+; RUN: llvm-lto -list-symbols-only %t.bc | FileCheck %s
+; RUN: llvm-lto -list-symbols-only %t.asm.bc | FileCheck %s
+
+; CHECK: f: code regular default{{$}}
+; CHECK-NEXT: lf: code weak default_can_be_hidden{{$}}
+; CHECK-NEXT: i: code regular internal{{$}}
+; CHECK-NEXT: g: data regular default align=8{{$}}
+; CHECK-NEXT: c: data tentative default align=4{{$}}
+; CHECK-NEXT: r: rodata regular default{{$}}
+; CHECK-NEXT: h: data regular hidden{{$}}
+; CHECK-NEXT: p: data regular protected{{$}}
+; CHECK-NEXT: l: data regular internal{{$}}
+; CHECK-NEXT: w: data weak default{{$}}
+; CHECK-NEXT: lo: rodata weak default_can_be_hidden{{$}}
+; CHECK-NEXT: a: data regular default align=8{{$}}
+; CHECK-DAG: d: undefined{{$}}
+; CHECK-DAG: u: undefined{{$}}
+; CHECK-DAG: ew: weakundef{{$}}
+; CHECK-NOT: priv
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @f() {
+  call void @d()
+  ret void
+}
+
+define linkonce_odr void @lf() unnamed_addr {
+  ret void
+}
+
+define internal void @i() {
+  ret void
+}
+
+declare void @d()
+
+@g = global i32 0, align 8
+@c = common global i32 0, align 4
+@r = constant i32 0
+@h = hidden global i32 0
+@p = protected global i32 0
+@l = internal global i32 0
+@w = weak global i32 0
+@lo = linkonce_odr unnamed_addr constant i32 0
+@priv = private global i32 0
+@u = external global i32
+@ew = extern_weak global i32
+
+@a = alias i32* @g
@@ -0,0 +1,12 @@
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s
+
+; Modules with inline asm have no symbol table, since the symbols that the asm
+; defines are only known after parsing it.
+; CHECK-NOT: SYMTAB_BLOCK
+
+module asm ".globl foo"
+module asm "foo:"
+
+define void @f() {
+  ret void
+}
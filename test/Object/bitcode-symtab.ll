@@ -0,0 +1,46 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-bcanalyzer -dump %t.bc | FileCheck %s --check-prefix=BC
+; RUN: rm -f %t.a
+; RUN: llvm-ar rcs %t.a %t.bc
+; RUN: llvm-nm -M %t.a | FileCheck %s
+
+; The symbol table follows the module block.
+; BC: </MODULE_BLOCK>
+; BC-NEXT: <SYMTAB_BLOCK
+; BC-NEXT: <BLOB
+; BC-NEXT: </SYMTAB_BLOCK>
+
+; The archive map is built from the symbol table, and only lists the global
+; definitions.
+; CHECK: Archive map
+; CHECK-NEXT: f in
+; CHECK-NEXT: w in
+; CHECK-NEXT: g in
+; CHECK-NEXT: c in
+; CHECK-NEXT: a in
+; CHECK-NOT: in
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@g = global i32 0
+@c = common global i32 0
+@p = private global i32 0
+@l = internal global i32 0
+@u = external global i32
+
+@a = alias i32* @g
+
+define void @f() {
+  ret void
+}
+
+define weak void @w() {
+  ret void
+}
+
+define internal void @i() {
+  ret void
+}
+
+declare void @d()
@@ -0,0 +1,18 @@
+; RUN: llc -mtriple=x86_64-unknown-linux -time-trace \
+; RUN:   -time-trace-granularity=0 -time-trace-file=%t.json -o /dev/null < %s
+; RUN: FileCheck %s < %t.json
+
+; CHECK: {"traceEvents":[
+; CHECK-DAG: "name":"compileModule","args":{"detail":"-"}
+; CHECK-DAG: "name":"CodeGenAndEmitDAG","args":{"detail":"f"}
+; CHECK-DAG: "name":"DAG Legalization"
+; CHECK-DAG: "name":"Instruction Selection"
+; CHECK-DAG: "name":"Instruction Scheduling"
+; CHECK-DAG: "name":"EmitFunctionBody","args":{"detail":"f"}
+; CHECK-DAG: "name":"AsmPrinter::doFinalization"
+; CHECK: "name":"process_name"
+
+define i32 @f(i32 %x) {
+  %a = add i32 %x, 1
+  ret i32 %a
+}
@@ -0,0 +1,99 @@
+; RUN: opt -S -sroa -early-cse -sccp -reassociate -adce < %s > %t.seq
+; RUN: opt -S -sroa -early-cse -sccp -reassociate -adce \
+; RUN:   -parallel-function-passes=4 -debug-only=ir < %s > %t.par 2> %t.log
+; RUN: diff %t.seq %t.par
+; RUN: FileCheck %s < %t.par
+; RUN: FileCheck %s -check-prefix=LOG < %t.log
+
+; The use lists of the shared values don't depend on the order in which the
+; threads ran.
+; RUN: opt -S -sroa -early-cse -sccp -reassociate -adce \
+; RUN:   -parallel-function-passes=4 -preserve-ll-uselistorder < %s > %t.par1
+; RUN: opt -S -sroa -early-cse -sccp -reassociate -adce \
+; RUN:   -parallel-function-passes=4 -preserve-ll-uselistorder < %s > %t.par2
+; RUN: diff %t.par1 %t.par2
+; REQUIRES: asserts
+
+; Function passes that all support it are run on several functions at once,
+; with the same result as running them on one function after the other.  The
+; functions share globals, constants and metadata.
+
+; LOG: Running function passes on 6 functions with 4 threads
+
+%pair = type { i32, i32 }
+
+@g = global i32 0
+@h = global [2 x i32] zeroinitializer
+
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8* nocapture, i8* nocapture readonly, i64, i32, i1)
+
+; CHECK-LABEL: @f0(
+; CHECK-NEXT: store i32 %x, i32* @g
+; CHECK-NEXT: ret i32 %x
+define i32 @f0(i32 %x) {
+  %p = alloca %pair
+  %a = getelementptr %pair, %pair* %p, i32 0, i32 0
+  store i32 %x, i32* %a
+  %v = load i32, i32* %a
+  store i32 %v, i32* @g
+  ret i32 %v
+}
+
+; CHECK-LABEL: @f1(
+; CHECK-NEXT: %c = add i32 %y, %x
+; CHECK-NEXT: ret i32 %c
+define i32 @f1(i32 %x, i32 %y) {
+  %a = add i32 %x, 1
+  %b = add i32 %a, %y
+  %c = sub i32 %b, 1
+  ret i32 %c
+}
+
+; CHECK-LABEL: @f2(
+; CHECK: m:
+; CHECK-NEXT: ret i32 2
+define i32 @f2() {
+entry:
+  br i1 true, label %t, label %f
+t:
+  br label %m
+f:
+  br label %m
+m:
+  %r = phi i32 [ 2, %t ], [ 3, %f ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: @f3(
+; CHECK-NEXT: store i32 1, i32* getelementptr inbounds ([2 x i32], [2 x i32]* @h, i64 0, i64 1)
+; CHECK-NEXT: ret void
+define void @f3() {
+  %dead = load i32, i32* @g
+  store i32 1, i32* getelementptr inbounds ([2 x i32], [2 x i32]* @h, i64 0, i64 1)
+  ret void
+}
+
+; CHECK-LABEL: @f4(
+; CHECK-NOT: alloca
+; CHECK: ret i32
+define i32 @f4(%pair* %src) {
+  %p = alloca %pair
+  %d = bitcast %pair* %p to i8*
+  %s = bitcast %pair* %src to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %d, i8* %s, i64 8, i32 4, i1 false)
+  %a = getelementptr %pair, %pair* %p, i32 0, i32 1
+  %v = load i32, i32* %a
+  ret i32 %v
+}
+
+; CHECK-LABEL: @f5(
+; CHECK-NEXT: %l = load i32, i32* @g
+; CHECK-NEXT: %m = mul i32 %l, 6
+; CHECK-NEXT: ret i32 %m
+define i32 @f5() {
+  %l = load i32, i32* @g
+  %l2 = load i32, i32* @g
+  %a = mul i32 %l, 2
+  %m = mul i32 %a, 3
+  ret i32 %m
+}
@@ -0,0 +1,15 @@
+; RUN: opt -instcombine -time-trace -time-trace-granularity=0 \
+; RUN:   -time-trace-file=%t.json -disable-output < %s
+; RUN: FileCheck %s < %t.json
+
+; CHECK: {"traceEvents":[
+; CHECK-DAG: "name":"RunFunctionPasses","args":{"detail":"f"}
+; CHECK-DAG: "name":"Combine redundant instructions","args":{"detail":"f"}
+; CHECK-DAG: "name":"Total RunFunctionPasses","args":{"count":1,
+; CHECK: "name":"process_name"
+; CHECK-NEXT: ]}
+
+define i32 @f(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
@@ -0,0 +1,44 @@
+@gv = global i32 0
+@lv = internal global i32 0
+@other = global i32 0
+
+define void @small() {
+  store i32 1, i32* @gv
+  call void @callee()
+  ret void
+}
+
+define void @callee() {
+  store i32 2, i32* @gv
+  ret void
+}
+
+define void @hot() !prof !0 {
+  store i32 1, i32* @gv
+  store i32 2, i32* @gv
+  store i32 3, i32* @gv
+  ret void
+}
+
+define void @big() {
+  store i32 1, i32* @gv
+  store i32 2, i32* @gv
+  store i32 3, i32* @gv
+  ret void
+}
+
+define void @uses_local() {
+  store i32 1, i32* @lv
+  ret void
+}
+
+define void @unused_function() {
+  store i32 1, i32* @other
+  ret void
+}
+
+define void @never_inline() noinline {
+  ret void
+}
+
+!0 = !{!"function_entry_count", i32 2304}
@@ -0,0 +1,59 @@
+@gv = global i32 0
+
+define void @f1(i32 %a) {
+entry:
+  call void @llvm.dbg.value(metadata i32 %a, i64 0, metadata !10, metadata !DIExpression()), !dbg !20
+  store i32 %a, i32* @gv, align 4, !dbg !21
+  ret void, !dbg !22
+}
+
+define void @f2(i32 %b) {
+entry:
+  call void @llvm.dbg.value(metadata i32 %b, i64 0, metadata !11, metadata !DIExpression()), !dbg !23
+  store i32 %b, i32* @gv, align 4, !dbg !24
+  ret void, !dbg !25
+}
+
+define void @f3(i32 %c) {
+entry:
+  call void @llvm.dbg.value(metadata i32 %c, i64 0, metadata !12, metadata !DIExpression()), !dbg !26
+  store i32 %c, i32* @gv, align 4, !dbg !27
+  ret void, !dbg !28
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!29, !30}
+!llvm.ident = !{!31}
+
+!0 = !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: true, emissionKind: 1, enums: !2, retainedTypes: !2, subprograms: !3, globals: !16)
+!1 = !DIFile(filename: "debug-info.c", directory: "/tmp")
+!2 = !{}
+!3 = !{!4, !5, !6}
+!4 = !DISubprogram(name: "f1", scope: !1, file: !1, line: 3, type: !7, isLocal: false, isDefinition: true, scopeLine: 3, isOptimized: true, function: void (i32)* @f1, variables: !13)
+!5 = !DISubprogram(name: "f2", scope: !1, file: !1, line: 7, type: !7, isLocal: false, isDefinition: true, scopeLine: 7, isOptimized: true, function: void (i32)* @f2, variables: !14)
+!6 = !DISubprogram(name: "f3", scope: !1, file: !1, line: 11, type: !7, isLocal: false, isDefinition: true, scopeLine: 11, isOptimized: true, function: void (i32)* @f3, variables: !15)
+!7 = !DISubroutineType(types: !8)
+!8 = !{null, !9}
+!9 = !DIBasicType(name: "int", size: 32, align: 32, encoding: DW_ATE_signed)
+!10 = !DILocalVariable(tag: DW_TAG_arg_variable, name: "a", arg: 1, scope: !4, file: !1, line: 3, type: !9)
+!11 = !DILocalVariable(tag: DW_TAG_arg_variable, name: "b", arg: 1, scope: !5, file: !1, line: 7, type: !9)
+!12 = !DILocalVariable(tag: DW_TAG_arg_variable, name: "c", arg: 1, scope: !6, file: !1, line: 11, type: !9)
+!13 = !{!10}
+!14 = !{!11}
+!15 = !{!12}
+!16 = !{!17}
+!17 = !DIGlobalVariable(name: "gv", scope: !0, file: !1, line: 1, type: !9, isLocal: false, isDefinition: true, variable: i32* @gv)
+!20 = !DILocation(line: 3, column: 13, scope: !4)
+!21 = !DILocation(line: 4, column: 6, scope: !4)
+!22 = !DILocation(line: 5, column: 1, scope: !4)
+!23 = !DILocation(line: 7, column: 13, scope: !5)
+!24 = !DILocation(line: 8, column: 6, scope: !5)
+!25 = !DILocation(line: 9, column: 1, scope: !5)
+!26 = !DILocation(line: 11, column: 13, scope: !6)
+!27 = !DILocation(line: 12, column: 6, scope: !6)
+!28 = !DILocation(line: 13, column: 1, scope: !6)
+!29 = !{i32 2, !"Dwarf Version", i32 4}
+!30 = !{i32 2, !"Debug Info Version", i32 3}
+!31 = !{!"clang"}
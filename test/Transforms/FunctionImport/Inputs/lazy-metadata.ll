@@ -0,0 +1,36 @@
+@gv = global i32 0
+
+define void @with_md() {
+entry:
+  store i32 1, i32* @gv, align 4, !tbaa !0, !dbg !12
+  br label %loop
+
+loop:
+  br i1 true, label %exit, label %loop, !llvm.loop !4
+
+exit:
+  ret void, !dbg !12
+}
+
+define void @unused() {
+  store i32 2, i32* @gv, align 4, !tbaa !13
+  ret void
+}
+
+!llvm.dbg.cu = !{!5}
+!llvm.module.flags = !{!11}
+
+!0 = !{!1, !1, i64 0}
+!1 = !{!"int", !2, i64 0}
+!2 = !{!"omnipotent char", !3, i64 0}
+!3 = !{!"Simple C/C++ TBAA"}
+!4 = distinct !{!4}
+!5 = !DICompileUnit(language: DW_LANG_C99, file: !6, producer: "clang", isOptimized: false, emissionKind: 1, subprograms: !7)
+!6 = !DIFile(filename: "lazy.c", directory: "/tmp")
+!7 = !{!8}
+!8 = !DISubprogram(name: "with_md", scope: !6, file: !6, line: 1, type: !9, isLocal: false, isDefinition: true, function: void ()* @with_md)
+!9 = !DISubroutineType(types: !10)
+!10 = !{null}
+!11 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = !DILocation(line: 2, scope: !8)
+!13 = !{!"unused", !2, i64 0}
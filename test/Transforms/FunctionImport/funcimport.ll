@@ -0,0 +1,40 @@
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-as -function-summary %p/Inputs/funcimport.ll -o %t2.bc
+; RUN: llvm-lto -thinlto -o %t3.bc %t.bc %t2.bc
+; RUN: opt -function-import -summary-file %t3.bc -import-instr-limit=3 \
+; RUN:   -import-hot-count=1000 -import-hot-instr-limit=5 %t.bc -S > %t.ll
+; RUN: FileCheck %s < %t.ll
+; RUN: FileCheck %s --check-prefix=UNUSED < %t.ll
+
+; Small functions are imported, along with the functions that they call.
+; CHECK-DAG: define available_externally void @small()
+; CHECK-DAG: define available_externally void @callee()
+; CHECK-DAG: define available_externally void @hot()
+
+; Functions that are too big, refer to local symbols, or are noinline are not.
+; CHECK-DAG: declare void @big()
+; CHECK-DAG: declare void @uses_local()
+; CHECK-DAG: declare void @never_inline()
+
+; The imported functions refer to the global variables of the other module.
+; CHECK-DAG: @gv = external global i32
+
+; Nothing that the imported functions don't refer to is brought in.
+; UNUSED-NOT: @other
+; UNUSED-NOT: @unused_function
+
+define i32 @main() {
+entry:
+  call void @small()
+  call void @hot()
+  call void @big()
+  call void @uses_local()
+  call void @never_inline()
+  ret i32 0
+}
+
+declare void @small()
+declare void @hot()
+declare void @big()
+declare void @uses_local()
+declare void @never_inline()
@@ -0,0 +1,28 @@
+; Write a module with debug info and enough metadata to get an index with the
+; default threshold, and import from it with lazily loaded metadata.
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-as -function-summary %p/Inputs/lazy-debug-info.ll -o %t2.bc
+; RUN: llvm-bcanalyzer -dump %t2.bc | FileCheck %s --check-prefix=BC
+; RUN: llvm-dis < %t2.bc | FileCheck %s --check-prefix=DIS
+; RUN: llvm-lto -thinlto -o %t3.bc %t.bc %t2.bc
+; RUN: opt -function-import -summary-file %t3.bc %t.bc -S | FileCheck %s
+
+; BC: <METADATA_INDEX_OFFSET
+; BC: <METADATA_INDEX
+
+; DIS: !llvm.dbg.cu = !{!0}
+; DIS: !DISubprogram(name: "f3"
+
+; The imported function is stripped of its debug info.
+; CHECK: define available_externally void @f2(i32 %b) {
+; CHECK-NEXT: entry:
+; CHECK-NEXT: store i32 %b, i32* @gv, align 4{{$}}
+; CHECK-NEXT: ret void{{$}}
+; CHECK-NOT: !DI
+
+define void @main() {
+  call void @f2(i32 1)
+  ret void
+}
+
+declare void @f2(i32)
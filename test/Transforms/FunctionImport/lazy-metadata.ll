@@ -0,0 +1,25 @@
+; Import from a module whose metadata has an index, so that only the metadata
+; used by the imported function is loaded.
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-as -function-summary -bitcode-mdindex-threshold=0 \
+; RUN:   %p/Inputs/lazy-metadata.ll -o %t2.bc
+; RUN: llvm-lto -thinlto -o %t3.bc %t.bc %t2.bc
+; RUN: opt -function-import -summary-file %t3.bc %t.bc -S | FileCheck %s
+
+; CHECK: define available_externally void @with_md()
+; CHECK-NEXT: entry:
+; CHECK-NEXT: store i32 1, i32* @gv, align 4, !tbaa [[TBAA:![0-9]+]]{{$}}
+; CHECK: br i1 true, label %exit, label %loop, !llvm.loop [[LOOP:![0-9]+]]
+; CHECK-NOT: !unused
+; CHECK-DAG: [[TBAA]] = !{[[INT:![0-9]+]], [[INT]], i64 0}
+; CHECK-DAG: [[INT]] = !{!"int", [[CHAR:![0-9]+]], i64 0}
+; CHECK-DAG: [[CHAR]] = !{!"omnipotent char", [[ROOT:![0-9]+]], i64 0}
+; CHECK-DAG: [[ROOT]] = !{!"Simple C/C++ TBAA"}
+; CHECK-DAG: [[LOOP]] = distinct !{[[LOOP]]}
+
+define void @main() {
+  call void @with_md()
+  ret void
+}
+
+declare void @with_md()
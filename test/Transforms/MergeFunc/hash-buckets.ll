@@ -0,0 +1,45 @@
+; RUN: opt -S -mergefunc < %s | FileCheck %s
+; RUN: opt -disable-output -mergefunc -stats < %s 2>&1 | FileCheck %s -check-prefix=STATS
+; REQUIRES: asserts
+
+; Functions are bucketed by a structural hash before being compared. @f0 and
+; @f1 differ only in an unreachable block, which must not affect the hash, so
+; they still end up in the same bucket and get merged. @g has a unique hash and
+; is never compared against anything.
+
+; STATS: 1 mergefunc - Number of functions merged
+; STATS: 1 mergefunc - Number of functions skipped due to a unique structural hash
+
+; CHECK-LABEL: define i32 @f0(
+define i32 @f0(i32 %x, i32 %y) {
+entry:
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %y
+  ret i32 %c
+}
+
+define i32 @f1(i32 %x, i32 %y) {
+entry:
+  %a = add i32 %x, %y
+  %b = mul i32 %a, %x
+  %c = sub i32 %b, %y
+  ret i32 %c
+
+dead:
+  %d = xor i32 %x, %y
+  ret i32 %d
+}
+
+; CHECK-LABEL: define i32 @g(
+; CHECK: xor
+; CHECK-LABEL: define i32 @f1(
+; CHECK-NEXT: tail call i32 @f0(
+define i32 @g(i32 %x, i32 %y) {
+entry:
+  %a = add i32 %x, %y
+  %b = xor i32 %a, %x
+  %c = sub i32 %b, %y
+  %d = add i32 %c, %y
+  ret i32 %d
+}
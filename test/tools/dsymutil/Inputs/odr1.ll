@@ -0,0 +1,40 @@
+; Generated from odr1.cpp:
+;   namespace N { struct S { int x; }; }
+;   int f1(N::S *s) { return s->x; }
+; Both files define N::S, which dsymutil emits only once.
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.10.0"
+
+%"struct.N::S" = type { i32 }
+
+define i32 @_Z2f1PN1N1SE(%"struct.N::S"* %s) {
+entry:
+  call void @llvm.dbg.value(metadata %"struct.N::S"* %s, i64 0, metadata !13, metadata !14), !dbg !15
+  %x = getelementptr inbounds %"struct.N::S", %"struct.N::S"* %s, i64 0, i32 0, !dbg !15
+  %0 = load i32, i32* %x, align 4, !dbg !15
+  ret i32 %0, !dbg !15
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!16}
+
+!0 = !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: 1, enums: !2, retainedTypes: !2, subprograms: !3, globals: !2, imports: !2)
+!1 = !DIFile(filename: "odr1.cpp", directory: "/tmp")
+!2 = !{}
+!3 = !{!4}
+!4 = !DISubprogram(name: "f1", linkageName: "_Z2f1PN1N1SE", scope: !1, file: !1, line: 2, type: !5, isLocal: false, isDefinition: true, scopeLine: 2, flags: DIFlagPrototyped, isOptimized: false, function: i32 (%"struct.N::S"*)* @_Z2f1PN1N1SE, variables: !2)
+!5 = !DISubroutineType(types: !6)
+!6 = !{!7, !8}
+!7 = !DIBasicType(name: "int", size: 32, align: 32, encoding: DW_ATE_signed)
+!8 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !9, size: 64, align: 64)
+!9 = !DICompositeType(tag: DW_TAG_structure_type, name: "S", scope: !10, file: !1, line: 1, size: 32, align: 32, elements: !11)
+!10 = !DINamespace(name: "N", scope: null, file: !1, line: 1)
+!11 = !{!12}
+!12 = !DIDerivedType(tag: DW_TAG_member, name: "x", scope: !9, file: !1, line: 1, baseType: !7, size: 32, align: 32)
+!13 = !DILocalVariable(tag: DW_TAG_arg_variable, name: "s", arg: 1, scope: !4, file: !1, line: 2, type: !8)
+!14 = !DIExpression()
+!15 = !DILocation(line: 2, scope: !4)
+!16 = !{i32 2, !"Debug Info Version", i32 3}
@@ -0,0 +1,20 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -u foo -u bar \
+; RUN:    -plugin-opt=jobs=2 -plugin-opt=obj-path=%t.o \
+; RUN:    -m elf_x86_64 -r -o %t %t.bc
+; RUN: llvm-nm %t.o0 %t.o1 | FileCheck %s
+
+; CHECK-DAG: T foo
+; CHECK-DAG: T bar
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+define void @bar() {
+  call void @foo()
+  ret void
+}
@@ -11,6 +11,7 @@
 #include "DebugMap.h"
 #include "dsymutil.h"
 #include "llvm/ADT/IntervalMap.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/CodeGen/AsmPrinter.h"
@@ -32,8 +33,10 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include <deque>
 #include <string>
 #include <tuple>
 
@@ -42,9 +45,10 @@ namespace dsymutil {
 
 namespace {
 
-void warn(const Twine &Warning, const Twine &Context) {
-  errs() << Twine("while processing ") + Context + ":\n";
-  errs() << Twine("warning: ") + Warning + "\n";
+void warn(const Twine &Warning, const Twine &Context,
+          raw_ostream &OS = errs()) {
+  OS << Twine("while processing ") + Context + ":\n";
+  OS << Twine("warning: ") + Warning + "\n";
 }
 
 bool error(const Twine &Error, const Twine &Context) {
@@ -90,6 +94,25 @@ struct PatchLocation {
   }
 };
 
+class CompileUnit;
+
+/// \brief A type definition that other compile units refer to instead
+/// of carrying their own copy. The One Definition Rule guarantees that
+/// all the definitions of a C++ type with a given qualified name are
+/// the same.
+struct CanonicalType {
+  /// The unit and index of the DIE while its object is being linked,
+  /// and null once the DIE has been emitted.
+  CompileUnit *Unit;
+  unsigned Idx;
+  /// The offset of the DIE in the output debug_info section, once it
+  /// has been emitted.
+  uint64_t Offset;
+
+  CanonicalType(CompileUnit *Unit, unsigned Idx)
+      : Unit(Unit), Idx(Idx), Offset(0) {}
+};
+
 /// \brief Stores all information relating to a compile unit, be it in
 /// its original instance in the object file to its brand new cloned
 /// and linked DIE tree.
@@ -102,16 +125,18 @@ public:
     uint32_t ParentIdx; ///< The index of this DIE's parent.
     bool Keep;          ///< Is the DIE part of the linked output?
     bool InDebugMap;    ///< Was this DIE's entity found in the map?
+    /// The definition that replaces this DIE if it is not kept.
+    const CanonicalType *Canonical;
   };
 
-  CompileUnit(DWARFUnit &OrigUnit, unsigned ID)
-      : OrigUnit(OrigUnit), ID(ID), LowPc(UINT64_MAX), HighPc(0), RangeAlloc(),
-        Ranges(RangeAlloc) {
+  CompileUnit(DWARFUnit &OrigUnit, unsigned ID, bool HasODR)
+      : OrigUnit(OrigUnit), ID(ID), HasODR(HasODR), LowPc(UINT64_MAX),
+        HighPc(0), RangeAlloc(), Ranges(RangeAlloc) {
     Info.resize(OrigUnit.getNumDIEs());
   }
 
   CompileUnit(CompileUnit &&RHS)
-      : OrigUnit(RHS.OrigUnit), Info(std::move(RHS.Info)),
+      : OrigUnit(RHS.OrigUnit), HasODR(RHS.HasODR), Info(std::move(RHS.Info)),
         CUDie(std::move(RHS.CUDie)), StartOffset(RHS.StartOffset),
         NextUnitOffset(RHS.NextUnitOffset), RangeAlloc(), Ranges(RangeAlloc) {
     // The CompileUnit container has been 'reserve()'d with the right
@@ -122,6 +147,11 @@ public:
   DWARFUnit &getOrigUnit() const { return OrigUnit; }
 
   unsigned getUniqueID() const { return ID; }
+  void setUniqueID(unsigned NewID) { ID = NewID; }
+
+  /// \brief Can the types of this unit be uniqued according to the
+  /// One Definition Rule?
+  bool hasODR() const { return HasODR; }
 
   DIE *getOutputUnitDIE() const { return CUDie.get(); }
   void setOutputUnitDIE(DIE *Die) { CUDie.reset(Die); }
@@ -203,6 +233,7 @@ public:
 private:
   DWARFUnit &OrigUnit;
   unsigned ID;
+  bool HasODR;
   std::vector<DIEInfo> Info;  ///< DIE info indexed by DIE index.
   std::unique_ptr<DIE> CUDie; ///< Root of the linked DIE tree.
 
@@ -1039,11 +1070,17 @@ void DwarfStreamer::emitFDE(uint32_t CIEOffset, uint32_t AddrSize,
 /// a function, the location for a variable). These relocations are
 /// called ValidRelocs in the DwarfLinker and are gathered as a very
 /// first step when we start processing a DebugMapObject.
+///
+/// Finding the relocations and the DIEs to keep only depends on the
+/// object being processed, so this analysis runs on a pool of threads,
+/// ahead of the cloning and emission. The latter assign the output
+/// offsets, string offsets and abbreviation numbers, and are thus done
+/// one object at a time in debug map order, which keeps the output
+/// deterministic.
 class DwarfLinker {
 public:
   DwarfLinker(StringRef OutputFilename, const LinkOptions &Options)
-      : OutputFilename(OutputFilename), Options(Options),
-        BinHolder(Options.Verbose), LastCIEOffset(0) {}
+      : OutputFilename(OutputFilename), Options(Options), LastCIEOffset(0) {}
 
   ~DwarfLinker() {
     for (auto *Abbrev : Abbreviations)
@@ -1054,11 +1091,22 @@ public:
   bool link(const DebugMap &);
 
 private:
+  struct LinkContext;
+
   /// \brief Called at the start of a debug object link.
-  void startDebugObject(DWARFContext &, DebugMapObject &);
+  void startDebugObject(LinkContext &Ctx);
 
   /// \brief Called at the end of a debug object link.
-  void endDebugObject();
+  void endDebugObject(LinkContext &Ctx);
+
+  /// \brief Load the object of \p Ctx, and select the DIEs to keep.
+  /// This can run on any thread, as it only touches \p Ctx.
+  void analyzeObject(LinkContext &Ctx);
+
+  /// \brief Clone the DIEs selected by analyzeObject() and emit them
+  /// along with the rest of the debug information of the object.
+  void linkObject(LinkContext &Ctx, uint64_t &OutputDebugInfoSize,
+                  unsigned &UnitID);
 
   /// \defgroup FindValidRelocations Translate debug map into a list
   /// of relevant relocations
@@ -1077,37 +1125,88 @@ private:
     bool operator<(const ValidReloc &RHS) const { return Offset < RHS.Offset; }
   };
 
-  /// \brief The valid relocations for the current DebugMapObject.
-  /// This vector is sorted by relocation offset.
-  std::vector<ValidReloc> ValidRelocs;
-
-  /// \brief Index into ValidRelocs of the next relocation to
-  /// consider. As we walk the DIEs in acsending file offset and as
-  /// ValidRelocs is sorted by file offset, keeping this index
-  /// uptodate is all we have to do to have a cheap lookup during the
-  /// root DIE selection and during DIE cloning.
-  unsigned NextValidReloc;
-
   bool findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
-                                  const DebugMapObject &DMO);
+                                  LinkContext &Ctx);
 
   bool findValidRelocs(const object::SectionRef &Section,
-                       const object::ObjectFile &Obj,
-                       const DebugMapObject &DMO);
+                       const object::ObjectFile &Obj, LinkContext &Ctx);
 
   void findValidRelocsMachO(const object::SectionRef &Section,
                             const object::MachOObjectFile &Obj,
-                            const DebugMapObject &DMO);
+                            LinkContext &Ctx);
   /// @}
 
+  /// \brief The state of the link of one DebugMapObject.
+  struct LinkContext {
+    const DebugMapObject &DMO;
+
+    /// \brief Owner of the object file. Each context has its own, so
+    /// that the objects can be loaded concurrently.
+    BinaryHolder BinHolder;
+
+    /// \brief The debug info of the object, or null if the object
+    /// could not be loaded or has nothing to link.
+    std::unique_ptr<DWARFContextInMemory> DwarfContext;
+
+    /// The units of the object.
+    std::vector<CompileUnit> Units;
+
+    /// \brief The valid relocations for the DebugMapObject.
+    /// This vector is sorted by relocation offset.
+    std::vector<ValidReloc> ValidRelocs;
+
+    /// \brief Index into ValidRelocs of the next relocation to
+    /// consider. As we walk the DIEs in acsending file offset and as
+    /// ValidRelocs is sorted by file offset, keeping this index
+    /// uptodate is all we have to do to have a cheap lookup during the
+    /// root DIE selection and during DIE cloning.
+    unsigned NextValidReloc;
+
+    /// \brief This map is keyed by the entry PC of functions in that
+    /// debug object and the associated value is a pair storing the
+    /// corresponding end PC and the offset to apply to get the linked
+    /// address.
+    ///
+    /// See startDebugObject() for a more complete description of its use.
+    std::map<uint64_t, std::pair<uint64_t, int64_t>> Ranges;
+
+    /// \brief When the object is analyzed on another thread, its
+    /// warnings are stored in Warnings and printed when the object is
+    /// linked, so that they come out in debug map order.
+    bool BufferWarnings;
+    std::string Warnings;
+
+    /// \brief Signaled when the analysis of the object is done.
+    std::shared_future<void> Analyzed;
+
+    /// \brief The canonical types defined by this object, whose output
+    /// offsets are set once the object is cloned.
+    std::vector<CanonicalType *> CanonicalTypes;
+
+    /// \brief Whether the types of the object are uniqued against the
+    /// other objects as its DIEs are selected. This depends on the
+    /// objects linked before it, so while the object is analyzed ahead
+    /// of the link, the types that can be uniqued are recorded below
+    /// instead, and resolveODRTypes() handles them in debug map order.
+    bool DeferODRTypes;
+    /// \brief The kept types to register as canonical definitions.
+    std::vector<std::pair<CompileUnit *, unsigned>> DeferredCanonicalTypes;
+    /// \brief The types referenced by kept DIEs, which are either kept
+    /// or replaced by their canonical definition.
+    std::vector<std::pair<CompileUnit *, unsigned>> DeferredTypeRefs;
+
+    LinkContext(const DebugMapObject &DMO, bool Verbose, bool BufferWarnings)
+        : DMO(DMO), BinHolder(Verbose), NextValidReloc(0),
+          BufferWarnings(BufferWarnings), DeferODRTypes(false) {}
+  };
+
   /// \defgroup FindRootDIEs Find DIEs corresponding to debug map entries.
   ///
   /// @{
   /// \brief Recursively walk the \p DIE tree and look for DIEs to
   /// keep. Store that information in \p CU's DIEInfo.
   void lookForDIEsToKeep(const DWARFDebugInfoEntryMinimal &DIE,
-                         const DebugMapObject &DMO, CompileUnit &CU,
-                         unsigned Flags);
+                         LinkContext &Ctx, CompileUnit &CU, unsigned Flags);
 
   /// \brief Flags passed to DwarfLinker::lookForDIEsToKeep
   enum TravesalFlags {
@@ -1120,25 +1219,59 @@ private:
   /// \brief Mark the passed DIE as well as all the ones it depends on
   /// as kept.
   void keepDIEAndDenpendencies(const DWARFDebugInfoEntryMinimal &DIE,
-                               CompileUnit::DIEInfo &MyInfo,
-                               const DebugMapObject &DMO, CompileUnit &CU,
-                               unsigned Flags);
+                               CompileUnit::DIEInfo &MyInfo, LinkContext &Ctx,
+                               CompileUnit &CU, unsigned Flags);
 
   unsigned shouldKeepDIE(const DWARFDebugInfoEntryMinimal &DIE,
-                         CompileUnit &Unit, CompileUnit::DIEInfo &MyInfo,
-                         unsigned Flags);
+                         LinkContext &Ctx, CompileUnit &Unit,
+                         CompileUnit::DIEInfo &MyInfo, unsigned Flags);
 
   unsigned shouldKeepVariableDIE(const DWARFDebugInfoEntryMinimal &DIE,
-                                 CompileUnit &Unit,
+                                 LinkContext &Ctx, CompileUnit &Unit,
                                  CompileUnit::DIEInfo &MyInfo, unsigned Flags);
 
   unsigned shouldKeepSubprogramDIE(const DWARFDebugInfoEntryMinimal &DIE,
-                                   CompileUnit &Unit,
+                                   LinkContext &Ctx, CompileUnit &Unit,
                                    CompileUnit::DIEInfo &MyInfo,
                                    unsigned Flags);
 
   bool hasValidRelocation(uint32_t StartOffset, uint32_t EndOffset,
-                          CompileUnit::DIEInfo &Info);
+                          CompileUnit::DIEInfo &Info, LinkContext &Ctx);
+
+  /// \brief Mark all the DIEs of the object of \p Ctx that need to be
+  /// present in the linked output, except for the types deferred to
+  /// resolveODRTypes().
+  void selectDIEsToKeep(LinkContext &Ctx);
+
+  /// \brief Unique the types whose selection was deferred by
+  /// selectDIEsToKeep(), keeping the ones that are not defined by a
+  /// previous unit. This must be done in debug map order.
+  void resolveODRTypes(LinkContext &Ctx);
+  /// @}
+
+  /// \defgroup ODR Type uniquing.
+  ///
+  /// @{
+  /// \brief Record \p DIE as the canonical definition of its type if
+  /// there is none yet.
+  void addCanonicalType(const DWARFDebugInfoEntryMinimal &DIE,
+                        LinkContext &Ctx, CompileUnit &CU, unsigned Idx);
+
+  /// \brief Check if the canonical definition of the type \p DIE of
+  /// \p CU is in another unit, and if so store it in the DIEInfo of
+  /// \p DIE, so that references to \p DIE are redirected to it.
+  bool useCanonicalType(const DWARFDebugInfoEntryMinimal &DIE,
+                        CompileUnit &CU);
+
+  /// \brief Record a reference to the type \p DIE of \p CU for
+  /// resolveODRTypes() if the uniquing of the types of \p Ctx is
+  /// deferred and \p DIE can be uniqued.
+  /// \returns true if the reference was deferred.
+  bool deferTypeReference(const DWARFDebugInfoEntryMinimal &DIE,
+                          LinkContext &Ctx, CompileUnit &CU);
+
+  /// \brief Canonical definitions of the types, keyed by getODRKey().
+  StringMap<CanonicalType> CanonicalTypes;
   /// @}
 
   /// \defgroup Linking Methods used to link the debug information
@@ -1155,8 +1288,8 @@ private:
   /// applied to the entry point of the function to get the linked address.
   ///
   /// \returns the root of the cloned tree.
-  DIE *cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE, CompileUnit &U,
-                int64_t PCOffset, uint32_t OutOffset);
+  DIE *cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE, LinkContext &Ctx,
+                CompileUnit &U, int64_t PCOffset, uint32_t OutOffset);
 
   typedef DWARFAbbreviationDeclaration::AttributeSpec AttributeSpec;
 
@@ -1180,7 +1313,8 @@ private:
 
   /// \brief Helper for cloneDIE.
   unsigned cloneAttribute(DIE &Die, const DWARFDebugInfoEntryMinimal &InputDIE,
-                          CompileUnit &U, const DWARFFormValue &Val,
+                          LinkContext &Ctx, CompileUnit &U,
+                          const DWARFFormValue &Val,
                           const AttributeSpec AttrSpec, unsigned AttrSize,
                           AttributesInfo &AttrInfo);
 
@@ -1193,7 +1327,8 @@ private:
   cloneDieReferenceAttribute(DIE &Die,
                              const DWARFDebugInfoEntryMinimal &InputDIE,
                              AttributeSpec AttrSpec, unsigned AttrSize,
-                             const DWARFFormValue &Val, CompileUnit &Unit);
+                             const DWARFFormValue &Val, LinkContext &Ctx,
+                             CompileUnit &Unit);
 
   /// \brief Helper for cloneDIE.
   unsigned cloneBlockAttribute(DIE &Die, AttributeSpec AttrSpec,
@@ -1207,13 +1342,14 @@ private:
   /// \brief Helper for cloneDIE.
   unsigned cloneScalarAttribute(DIE &Die,
                                 const DWARFDebugInfoEntryMinimal &InputDIE,
-                                CompileUnit &U, AttributeSpec AttrSpec,
+                                LinkContext &Ctx, CompileUnit &U,
+                                AttributeSpec AttrSpec,
                                 const DWARFFormValue &Val, unsigned AttrSize,
                                 AttributesInfo &Info);
 
   /// \brief Helper for cloneDIE.
   bool applyValidRelocs(MutableArrayRef<char> Data, uint32_t BaseOffset,
-                        bool isLittleEndian);
+                        bool isLittleEndian, LinkContext &Ctx);
 
   /// \brief Assign an abbreviation number to \p Abbrev
   void AssignAbbrev(DIEAbbrev &Abbrev);
@@ -1227,7 +1363,7 @@ private:
 
   /// \brief Compute and emit debug_ranges section for \p Unit, and
   /// patch the attributes referencing it.
-  void patchRangesForUnit(const CompileUnit &Unit, DWARFContext &Dwarf) const;
+  void patchRangesForUnit(const CompileUnit &Unit, LinkContext &Ctx) const;
 
   /// \brief Generate and emit the DW_AT_ranges attribute for a
   /// compile_unit if it had one.
@@ -1236,14 +1372,13 @@ private:
   /// \brief Extract the line tables fromt he original dwarf, extract
   /// the relevant parts according to the linked function ranges and
   /// emit the result in the debug_line section.
-  void patchLineTableForUnit(CompileUnit &Unit, DWARFContext &OrigDwarf);
+  void patchLineTableForUnit(CompileUnit &Unit, LinkContext &Ctx);
 
   /// \brief Emit the accelerator entries for \p Unit.
   void emitAcceleratorEntriesForUnit(CompileUnit &Unit);
 
   /// \brief Patch the frame info for an object file and emit it.
-  void patchFrameInfoForObject(const DebugMapObject &, DWARFContext &,
-                               unsigned AddressSize);
+  void patchFrameInfoForObject(LinkContext &Ctx, unsigned AddressSize);
 
   /// \brief DIELoc objects that need to be destructed (but not freed!).
   std::vector<DIELoc *> DIELocs;
@@ -1258,15 +1393,16 @@ private:
   /// @{
   const DWARFDebugInfoEntryMinimal *
   resolveDIEReference(DWARFFormValue &RefValue, const DWARFUnit &Unit,
-                      const DWARFDebugInfoEntryMinimal &DIE,
+                      const DWARFDebugInfoEntryMinimal &DIE, LinkContext &Ctx,
                       CompileUnit *&ReferencedCU);
 
-  CompileUnit *getUnitForOffset(unsigned Offset);
+  CompileUnit *getUnitForOffset(LinkContext &Ctx, unsigned Offset);
 
   bool getDIENames(const DWARFDebugInfoEntryMinimal &Die, DWARFUnit &U,
                    AttributesInfo &Info);
 
-  void reportWarning(const Twine &Warning, const DWARFUnit *Unit = nullptr,
+  void reportWarning(const Twine &Warning, LinkContext &Ctx,
+                     const DWARFUnit *Unit = nullptr,
                      const DWARFDebugInfoEntryMinimal *DIE = nullptr) const;
 
   bool createStreamer(Triple TheTriple, StringRef OutputFilename);
@@ -1275,26 +1411,11 @@ private:
 private:
   std::string OutputFilename;
   LinkOptions Options;
-  BinaryHolder BinHolder;
   std::unique_ptr<DwarfStreamer> Streamer;
 
-  /// The units of the current debug map object.
-  std::vector<CompileUnit> Units;
-
-  /// The debug map object curently under consideration.
-  DebugMapObject *CurrentDebugObject;
-
   /// \brief The Dwarf string pool
   NonRelocatableStringpool StringPool;
 
-  /// \brief This map is keyed by the entry PC of functions in that
-  /// debug object and the associated value is a pair storing the
-  /// corresponding end PC and the offset to apply to get the linked
-  /// address.
-  ///
-  /// See startDebugObject() for a more complete description of its use.
-  std::map<uint64_t, std::pair<uint64_t, int64_t>> Ranges;
-
   /// \brief The CIEs that have been emitted in the output
   /// section. The actual CIE data serves a the key to this StringMap,
   /// this takes care of comparing the semantics of CIEs defined in
@@ -1308,7 +1429,8 @@ private:
 
 /// \brief Similar to DWARFUnitSection::getUnitForOffset(), but
 /// returning our CompileUnit object instead.
-CompileUnit *DwarfLinker::getUnitForOffset(unsigned Offset) {
+CompileUnit *DwarfLinker::getUnitForOffset(LinkContext &Ctx, unsigned Offset) {
+  auto &Units = Ctx.Units;
   auto CU =
       std::upper_bound(Units.begin(), Units.end(), Offset,
                        [](uint32_t LHS, const CompileUnit &RHS) {
@@ -1323,15 +1445,16 @@ CompileUnit *DwarfLinker::getUnitForOffset(unsigned Offset) {
 /// \returns null if resolving fails for any reason.
 const DWARFDebugInfoEntryMinimal *DwarfLinker::resolveDIEReference(
     DWARFFormValue &RefValue, const DWARFUnit &Unit,
-    const DWARFDebugInfoEntryMinimal &DIE, CompileUnit *&RefCU) {
+    const DWARFDebugInfoEntryMinimal &DIE, LinkContext &Ctx,
+    CompileUnit *&RefCU) {
   assert(RefValue.isFormClass(DWARFFormValue::FC_Reference));
   uint64_t RefOffset = *RefValue.getAsReference(&Unit);
 
-  if ((RefCU = getUnitForOffset(RefOffset)))
+  if ((RefCU = getUnitForOffset(Ctx, RefOffset)))
     if (const auto *RefDie = RefCU->getOrigUnit().getDIEForOffset(RefOffset))
       return RefDie;
 
-  reportWarning("could not find referenced DIE", &Unit, &DIE);
+  reportWarning("could not find referenced DIE", Ctx, &Unit, &DIE);
   return nullptr;
 }
 
@@ -1355,18 +1478,18 @@ bool DwarfLinker::getDIENames(const DWARFDebugInfoEntryMinimal &Die,
 
 /// \brief Report a warning to the user, optionaly including
 /// information about a specific \p DIE related to the warning.
-void DwarfLinker::reportWarning(const Twine &Warning, const DWARFUnit *Unit,
+void DwarfLinker::reportWarning(const Twine &Warning, LinkContext &Ctx,
+                                const DWARFUnit *Unit,
                                 const DWARFDebugInfoEntryMinimal *DIE) const {
-  StringRef Context = "<debug map>";
-  if (CurrentDebugObject)
-    Context = CurrentDebugObject->getObjectFilename();
-  warn(Warning, Context);
+  raw_string_ostream BufferOS(Ctx.Warnings);
+  raw_ostream &OS = Ctx.BufferWarnings ? BufferOS : errs();
+  warn(Warning, Ctx.DMO.getObjectFilename(), OS);
 
   if (!Options.Verbose || !DIE)
     return;
 
-  errs() << "    in DIE:\n";
-  DIE->dump(errs(), const_cast<DWARFUnit *>(Unit), 0 /* RecurseDepth */,
+  OS << "    in DIE:\n";
+  DIE->dump(OS, const_cast<DWARFUnit *>(Unit), 0 /* RecurseDepth */,
             6 /* Indent */);
 }
 
@@ -1406,9 +1529,9 @@ static bool dieNeedsChildrenToBeMeaningful(uint32_t Tag) {
   llvm_unreachable("Invalid Tag");
 }
 
-void DwarfLinker::startDebugObject(DWARFContext &Dwarf, DebugMapObject &Obj) {
-  Units.reserve(Dwarf.getNumCompileUnits());
-  NextValidReloc = 0;
+void DwarfLinker::startDebugObject(LinkContext &Ctx) {
+  Ctx.Units.reserve(Ctx.DwarfContext->getNumCompileUnits());
+  Ctx.NextValidReloc = 0;
   // Iterate over the debug map entries and put all the ones that are
   // functions (because they have a size) into the Ranges map. This
   // map is very similar to the FunctionRanges that are stored in each
@@ -1423,19 +1546,19 @@ void DwarfLinker::startDebugObject(DWARFContext &Dwarf, DebugMapObject &Obj) {
   // FIXME: Once we understood exactly if that information is needed,
   // maybe totally remove this (or try to use it to do a real
   // -gline-tables-only on Darwin.
-  for (const auto &Entry : Obj.symbols()) {
+  for (const auto &Entry : Ctx.DMO.symbols()) {
     const auto &Mapping = Entry.getValue();
     if (Mapping.Size)
-      Ranges[Mapping.ObjectAddress] = std::make_pair(
+      Ctx.Ranges[Mapping.ObjectAddress] = std::make_pair(
           Mapping.ObjectAddress + Mapping.Size,
           int64_t(Mapping.BinaryAddress) - Mapping.ObjectAddress);
   }
 }
 
-void DwarfLinker::endDebugObject() {
-  Units.clear();
-  ValidRelocs.clear();
-  Ranges.clear();
+void DwarfLinker::endDebugObject(LinkContext &Ctx) {
+  Ctx.Units.clear();
+  Ctx.ValidRelocs.clear();
+  Ctx.Ranges.clear();
 
   for (auto *Block : DIEBlocks)
     Block->~DIEBlock();
@@ -1452,7 +1575,8 @@ void DwarfLinker::endDebugObject() {
 /// ValidRelocs array.
 void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
                                        const object::MachOObjectFile &Obj,
-                                       const DebugMapObject &DMO) {
+                                       LinkContext &Ctx) {
+  const DebugMapObject &DMO = Ctx.DMO;
   StringRef Contents;
   Section.getContents(Contents);
   DataExtractor Data(Contents, Obj.isLittleEndian(), 0);
@@ -1463,7 +1587,7 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
     unsigned RelocSize = 1 << Obj.getAnyRelocationLength(MachOReloc);
     uint64_t Offset64;
     if ((RelocSize != 4 && RelocSize != 8) || Reloc.getOffset(Offset64)) {
-      reportWarning(" unsupported relocation in debug_info section.");
+      reportWarning(" unsupported relocation in debug_info section.", Ctx);
       continue;
     }
     uint32_t Offset = Offset64;
@@ -1474,16 +1598,16 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
     if (Sym != Obj.symbol_end()) {
       StringRef SymbolName;
       if (Sym->getName(SymbolName)) {
-        reportWarning("error getting relocation symbol name.");
+        reportWarning("error getting relocation symbol name.", Ctx);
         continue;
       }
       if (const auto *Mapping = DMO.lookupSymbol(SymbolName))
-        ValidRelocs.emplace_back(Offset64, RelocSize, Addend, Mapping);
+        Ctx.ValidRelocs.emplace_back(Offset64, RelocSize, Addend, Mapping);
     } else if (const auto *Mapping = DMO.lookupObjectAddress(Addend)) {
       // Do not store the addend. The addend was the address of the
       // symbol in the object file, the address in the binary that is
       // stored in the debug map doesn't need to be offseted.
-      ValidRelocs.emplace_back(Offset64, RelocSize, 0, Mapping);
+      Ctx.ValidRelocs.emplace_back(Offset64, RelocSize, 0, Mapping);
     }
   }
 }
@@ -1492,20 +1616,22 @@ void DwarfLinker::findValidRelocsMachO(const object::SectionRef &Section,
 /// appropriate handler depending on the object file format.
 bool DwarfLinker::findValidRelocs(const object::SectionRef &Section,
                                   const object::ObjectFile &Obj,
-                                  const DebugMapObject &DMO) {
+                                  LinkContext &Ctx) {
   // Dispatch to the right handler depending on the file type.
   if (auto *MachOObj = dyn_cast<object::MachOObjectFile>(&Obj))
-    findValidRelocsMachO(Section, *MachOObj, DMO);
+    findValidRelocsMachO(Section, *MachOObj, Ctx);
   else
-    reportWarning(Twine("unsupported object file type: ") + Obj.getFileName());
+    reportWarning(Twine("unsupported object file type: ") + Obj.getFileName(),
+                  Ctx);
 
+  auto &ValidRelocs = Ctx.ValidRelocs;
   if (ValidRelocs.empty())
     return false;
 
   // Sort the relocations by offset. We will walk the DIEs linearly in
   // the file, this allows us to just keep an index in the relocation
   // array that we advance during our walk, rather than resorting to
-  // some associative container. See DwarfLinker::NextValidReloc.
+  // some associative container. See LinkContext::NextValidReloc.
   std::sort(ValidRelocs.begin(), ValidRelocs.end());
   return true;
 }
@@ -1516,7 +1642,7 @@ bool DwarfLinker::findValidRelocs(const object::SectionRef &Section,
 /// linked binary.
 /// \returns wether there are any valid relocations in the debug info.
 bool DwarfLinker::findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
-                                             const DebugMapObject &DMO) {
+                                             LinkContext &Ctx) {
   // Find the debug_info section.
   for (const object::SectionRef &Section : Obj.sections()) {
     StringRef SectionName;
@@ -1524,7 +1650,7 @@ bool DwarfLinker::findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
     SectionName = SectionName.substr(SectionName.find_first_not_of("._"));
     if (SectionName != "debug_info")
       continue;
-    return findValidRelocs(Section, Obj, DMO);
+    return findValidRelocs(Section, Obj, Ctx);
   }
   return false;
 }
@@ -1536,7 +1662,10 @@ bool DwarfLinker::findValidRelocsInDebugInfo(const object::ObjectFile &Obj,
 /// order because it never looks back at relocations it already 'went past'.
 /// \returns true and sets Info.InDebugMap if it is the case.
 bool DwarfLinker::hasValidRelocation(uint32_t StartOffset, uint32_t EndOffset,
-                                     CompileUnit::DIEInfo &Info) {
+                                     CompileUnit::DIEInfo &Info,
+                                     LinkContext &Ctx) {
+  const auto &ValidRelocs = Ctx.ValidRelocs;
+  unsigned &NextValidReloc = Ctx.NextValidReloc;
   assert(NextValidReloc == 0 ||
          StartOffset > ValidRelocs[NextValidReloc - 1].Offset);
   if (NextValidReloc >= ValidRelocs.size())
@@ -1590,7 +1719,7 @@ getAttributeOffsets(const DWARFAbbreviationDeclaration *Abbrev, unsigned Idx,
 /// \brief Check if a variable describing DIE should be kept.
 /// \returns updated TraversalFlags.
 unsigned DwarfLinker::shouldKeepVariableDIE(
-    const DWARFDebugInfoEntryMinimal &DIE, CompileUnit &Unit,
+    const DWARFDebugInfoEntryMinimal &DIE, LinkContext &Ctx, CompileUnit &Unit,
     CompileUnit::DIEInfo &MyInfo, unsigned Flags) {
   const auto *Abbrev = DIE.getAbbreviationDeclarationPtr();
 
@@ -1616,7 +1745,7 @@ unsigned DwarfLinker::shouldKeepVariableDIE(
   // always check in the variable has a valid relocation, so that the
   // DIEInfo is filled. However, we don't want a static variable in a
   // function to force us to keep the enclosing function.
-  if (!hasValidRelocation(LocationOffset, LocationEndOffset, MyInfo) ||
+  if (!hasValidRelocation(LocationOffset, LocationEndOffset, MyInfo, Ctx) ||
       (Flags & TF_InFunctionScope))
     return Flags;
 
@@ -1629,7 +1758,7 @@ unsigned DwarfLinker::shouldKeepVariableDIE(
 /// \brief Check if a function describing DIE should be kept.
 /// \returns updated TraversalFlags.
 unsigned DwarfLinker::shouldKeepSubprogramDIE(
-    const DWARFDebugInfoEntryMinimal &DIE, CompileUnit &Unit,
+    const DWARFDebugInfoEntryMinimal &DIE, LinkContext &Ctx, CompileUnit &Unit,
     CompileUnit::DIEInfo &MyInfo, unsigned Flags) {
   const auto *Abbrev = DIE.getAbbreviationDeclarationPtr();
 
@@ -1649,7 +1778,7 @@ unsigned DwarfLinker::shouldKeepSubprogramDIE(
       DIE.getAttributeValueAsAddress(&OrigUnit, dwarf::DW_AT_low_pc, -1ULL);
   assert(LowPc != -1ULL && "low_pc attribute is not an address.");
   if (LowPc == -1ULL ||
-      !hasValidRelocation(LowPcOffset, LowPcEndOffset, MyInfo))
+      !hasValidRelocation(LowPcOffset, LowPcEndOffset, MyInfo, Ctx))
     return Flags;
 
   if (Options.Verbose)
@@ -1660,7 +1789,7 @@ unsigned DwarfLinker::shouldKeepSubprogramDIE(
   DWARFFormValue HighPcValue;
   if (!DIE.getAttributeValue(&OrigUnit, dwarf::DW_AT_high_pc, HighPcValue)) {
     reportWarning("Function without high_pc. Range will be discarded.\n",
-                  &OrigUnit, &DIE);
+                  Ctx, &OrigUnit, &DIE);
     return Flags;
   }
 
@@ -1673,7 +1802,7 @@ unsigned DwarfLinker::shouldKeepSubprogramDIE(
   }
 
   // Replace the debug map range with a more accurate one.
-  Ranges[LowPc] = std::make_pair(HighPc, MyInfo.AddrAdjust);
+  Ctx.Ranges[LowPc] = std::make_pair(HighPc, MyInfo.AddrAdjust);
   Unit.addFunctionRange(LowPc, HighPc, MyInfo.AddrAdjust);
   return Flags;
 }
@@ -1681,15 +1810,15 @@ unsigned DwarfLinker::shouldKeepSubprogramDIE(
 /// \brief Check if a DIE should be kept.
 /// \returns updated TraversalFlags.
 unsigned DwarfLinker::shouldKeepDIE(const DWARFDebugInfoEntryMinimal &DIE,
-                                    CompileUnit &Unit,
+                                    LinkContext &Ctx, CompileUnit &Unit,
                                     CompileUnit::DIEInfo &MyInfo,
                                     unsigned Flags) {
   switch (DIE.getTag()) {
   case dwarf::DW_TAG_constant:
   case dwarf::DW_TAG_variable:
-    return shouldKeepVariableDIE(DIE, Unit, MyInfo, Flags);
+    return shouldKeepVariableDIE(DIE, Ctx, Unit, MyInfo, Flags);
   case dwarf::DW_TAG_subprogram:
-    return shouldKeepSubprogramDIE(DIE, Unit, MyInfo, Flags);
+    return shouldKeepSubprogramDIE(DIE, Ctx, Unit, MyInfo, Flags);
   case dwarf::DW_TAG_module:
   case dwarf::DW_TAG_imported_module:
   case dwarf::DW_TAG_imported_declaration:
@@ -1711,15 +1840,15 @@ unsigned DwarfLinker::shouldKeepDIE(const DWARFDebugInfoEntryMinimal &DIE,
 /// tree walk.
 void DwarfLinker::keepDIEAndDenpendencies(const DWARFDebugInfoEntryMinimal &DIE,
                                           CompileUnit::DIEInfo &MyInfo,
-                                          const DebugMapObject &DMO,
-                                          CompileUnit &CU, unsigned Flags) {
+                                          LinkContext &Ctx, CompileUnit &CU,
+                                          unsigned Flags) {
   const DWARFUnit &Unit = CU.getOrigUnit();
   MyInfo.Keep = true;
 
   // First mark all the parent chain as kept.
   unsigned AncestorIdx = MyInfo.ParentIdx;
   while (!CU.getInfo(AncestorIdx).Keep) {
-    lookForDIEsToKeep(*Unit.getDIEAtIndex(AncestorIdx), DMO, CU,
+    lookForDIEsToKeep(*Unit.getDIEAtIndex(AncestorIdx), Ctx, CU,
                       TF_ParentWalk | TF_Keep | TF_DependencyWalk);
     AncestorIdx = CU.getInfo(AncestorIdx).ParentIdx;
   }
@@ -1741,8 +1870,15 @@ void DwarfLinker::keepDIEAndDenpendencies(const DWARFDebugInfoEntryMinimal &DIE,
 
     Val.extractValue(Data, &Offset, &Unit);
     CompileUnit *ReferencedCU;
-    if (const auto *RefDIE = resolveDIEReference(Val, Unit, DIE, ReferencedCU))
-      lookForDIEsToKeep(*RefDIE, DMO, *ReferencedCU,
+    const auto *RefDIE = resolveDIEReference(Val, Unit, DIE, Ctx, ReferencedCU);
+    if (!RefDIE)
+      continue;
+    if (deferTypeReference(*RefDIE, Ctx, *ReferencedCU))
+      continue;
+    // Types defined in another unit are referenced there rather than
+    // being copied.
+    if (!useCanonicalType(*RefDIE, *ReferencedCU))
+      lookForDIEsToKeep(*RefDIE, Ctx, *ReferencedCU,
                         TF_Keep | TF_DependencyWalk);
   }
 }
@@ -1760,7 +1896,7 @@ void DwarfLinker::keepDIEAndDenpendencies(const DWARFDebugInfoEntryMinimal &DIE,
 /// not respected. The TF_DependencyWalk flag tells us which kind of
 /// traversal we are currently doing.
 void DwarfLinker::lookForDIEsToKeep(const DWARFDebugInfoEntryMinimal &DIE,
-                                    const DebugMapObject &DMO, CompileUnit &CU,
+                                    LinkContext &Ctx, CompileUnit &CU,
                                     unsigned Flags) {
   unsigned Idx = CU.getOrigUnit().getDIEIndex(&DIE);
   CompileUnit::DIEInfo &MyInfo = CU.getInfo(Idx);
@@ -1775,11 +1911,13 @@ void DwarfLinker::lookForDIEsToKeep(const DWARFDebugInfoEntryMinimal &DIE,
   // We must not call shouldKeepDIE while called from keepDIEAndDenpendencies,
   // because it would screw up the relocation finding logic.
   if (!(Flags & TF_DependencyWalk))
-    Flags = shouldKeepDIE(DIE, CU, MyInfo, Flags);
+    Flags = shouldKeepDIE(DIE, Ctx, CU, MyInfo, Flags);
 
   // If it is a newly kept DIE mark it as well as all its dependencies as kept.
-  if (!AlreadyKept && (Flags & TF_Keep))
-    keepDIEAndDenpendencies(DIE, MyInfo, DMO, CU, Flags);
+  if (!AlreadyKept && (Flags & TF_Keep)) {
+    addCanonicalType(DIE, Ctx, CU, Idx);
+    keepDIEAndDenpendencies(DIE, MyInfo, Ctx, CU, Flags);
+  }
 
   // The TF_ParentWalk flag tells us that we are currently walking up
   // the parent chain of a required DIE, and we don't want to mark all
@@ -1795,7 +1933,129 @@ void DwarfLinker::lookForDIEsToKeep(const DWARFDebugInfoEntryMinimal &DIE,
 
   for (auto *Child = DIE.getFirstChild(); Child && !Child->isNULL();
        Child = Child->getSibling())
-    lookForDIEsToKeep(*Child, DMO, CU, Flags);
+    lookForDIEsToKeep(*Child, Ctx, CU, Flags);
+}
+
+/// \brief Compute in \p Key the name under which the type described by
+/// \p DIE is uniqued: its tag, its fully qualified name and its size.
+/// Only the complete definitions of named types, whose parents are
+/// named namespaces or types, can be uniqued.
+/// \returns false if \p DIE cannot be uniqued.
+static bool getODRKey(const DWARFDebugInfoEntryMinimal &DIE, CompileUnit &CU,
+                      SmallVectorImpl<char> &Key) {
+  switch (DIE.getTag()) {
+  default:
+    return false;
+  case dwarf::DW_TAG_class_type:
+  case dwarf::DW_TAG_structure_type:
+  case dwarf::DW_TAG_union_type:
+  case dwarf::DW_TAG_enumeration_type:
+  case dwarf::DW_TAG_typedef:
+    break;
+  }
+
+  DWARFUnit &U = CU.getOrigUnit();
+  DWARFFormValue Declaration;
+  if (DIE.getAttributeValue(&U, dwarf::DW_AT_declaration, Declaration))
+    return false;
+
+  SmallVector<const char *, 8> Names;
+  const DWARFDebugInfoEntryMinimal *Scope = &DIE;
+  unsigned Idx = U.getDIEIndex(Scope);
+  do {
+    const char *Name = Scope->getName(&U, DINameKind::ShortName);
+    if (!Name)
+      return false;
+    Names.push_back(Name);
+
+    Idx = CU.getInfo(Idx).ParentIdx;
+    Scope = U.getDIEAtIndex(Idx);
+    switch (Scope->getTag()) {
+    default:
+      // Types local to functions are not subject to the ODR.
+      return false;
+    case dwarf::DW_TAG_compile_unit:
+    case dwarf::DW_TAG_namespace:
+    case dwarf::DW_TAG_class_type:
+    case dwarf::DW_TAG_structure_type:
+    case dwarf::DW_TAG_union_type:
+      break;
+    }
+  } while (Scope->getTag() != dwarf::DW_TAG_compile_unit);
+
+  raw_svector_ostream OS(Key);
+  OS << DIE.getTag() << ':';
+  for (auto I = Names.rbegin(), E = Names.rend(); I != E; ++I)
+    OS << "::" << *I;
+  OS << ':'
+     << DIE.getAttributeValueAsUnsignedConstant(&U, dwarf::DW_AT_byte_size, 0);
+  OS.flush();
+  return true;
+}
+
+static bool isODRLanguage(uint16_t Language) {
+  switch (Language) {
+  case dwarf::DW_LANG_C_plus_plus:
+  case dwarf::DW_LANG_C_plus_plus_03:
+  case dwarf::DW_LANG_C_plus_plus_11:
+  case dwarf::DW_LANG_C_plus_plus_14:
+  case dwarf::DW_LANG_ObjC_plus_plus:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void DwarfLinker::addCanonicalType(const DWARFDebugInfoEntryMinimal &DIE,
+                                   LinkContext &Ctx, CompileUnit &CU,
+                                   unsigned Idx) {
+  SmallString<128> Key;
+  if (!CU.hasODR() || !getODRKey(DIE, CU, Key))
+    return;
+
+  if (Ctx.DeferODRTypes) {
+    Ctx.DeferredCanonicalTypes.push_back(std::make_pair(&CU, Idx));
+    return;
+  }
+
+  auto Inserted =
+      CanonicalTypes.insert(std::make_pair(Key, CanonicalType(&CU, Idx)));
+  if (Inserted.second)
+    Ctx.CanonicalTypes.push_back(&Inserted.first->getValue());
+}
+
+bool DwarfLinker::useCanonicalType(const DWARFDebugInfoEntryMinimal &DIE,
+                                   CompileUnit &CU) {
+  if (!CU.hasODR())
+    return false;
+  CompileUnit::DIEInfo &Info = CU.getInfo(CU.getOrigUnit().getDIEIndex(&DIE));
+  if (Info.Keep)
+    return false;
+
+  SmallString<128> Key;
+  if (!getODRKey(DIE, CU, Key))
+    return false;
+  auto Canonical = CanonicalTypes.find(Key);
+  if (Canonical == CanonicalTypes.end() || Canonical->getValue().Unit == &CU)
+    return false;
+
+  Info.Canonical = &Canonical->getValue();
+  return true;
+}
+
+bool DwarfLinker::deferTypeReference(const DWARFDebugInfoEntryMinimal &DIE,
+                                     LinkContext &Ctx, CompileUnit &CU) {
+  if (!Ctx.DeferODRTypes || !CU.hasODR())
+    return false;
+  unsigned Idx = CU.getOrigUnit().getDIEIndex(&DIE);
+  if (CU.getInfo(Idx).Keep)
+    return false;
+
+  SmallString<128> Key;
+  if (!getODRKey(DIE, CU, Key))
+    return false;
+  Ctx.DeferredTypeRefs.push_back(std::make_pair(&CU, Idx));
+  return true;
 }
 
 /// \brief Assign an abbreviation numer to \p Abbrev.
@@ -1848,24 +2108,44 @@ unsigned DwarfLinker::cloneStringAttribute(DIE &Die, AttributeSpec AttrSpec,
 unsigned DwarfLinker::cloneDieReferenceAttribute(
     DIE &Die, const DWARFDebugInfoEntryMinimal &InputDIE,
     AttributeSpec AttrSpec, unsigned AttrSize, const DWARFFormValue &Val,
-    CompileUnit &Unit) {
+    LinkContext &Ctx, CompileUnit &Unit) {
   uint32_t Ref = *Val.getAsReference(&Unit.getOrigUnit());
   DIE *NewRefDie = nullptr;
   CompileUnit *RefUnit = nullptr;
   const DWARFDebugInfoEntryMinimal *RefDie = nullptr;
 
-  if (!(RefUnit = getUnitForOffset(Ref)) ||
+  if (!(RefUnit = getUnitForOffset(Ctx, Ref)) ||
       !(RefDie = RefUnit->getOrigUnit().getDIEForOffset(Ref))) {
     const char *AttributeString = dwarf::AttributeString(AttrSpec.Attr);
     if (!AttributeString)
       AttributeString = "DW_AT_???";
     reportWarning(Twine("Missing DIE for ref in attribute ") + AttributeString +
                       ". Dropping.",
-                  &Unit.getOrigUnit(), &InputDIE);
+                  Ctx, &Unit.getOrigUnit(), &InputDIE);
     return 0;
   }
 
   unsigned Idx = RefUnit->getOrigUnit().getDIEIndex(RefDie);
+  bool UseRefAddr = AttrSpec.Form == dwarf::DW_FORM_ref_addr;
+  if (!RefUnit->getInfo(Idx).Keep && RefUnit->getInfo(Idx).Canonical) {
+    // The referenced type was replaced by its definition in another
+    // unit. That unit may be in a previous object, in which case its
+    // offset is known, or in this one.
+    const CanonicalType &Canonical = *RefUnit->getInfo(Idx).Canonical;
+    const DWARFUnit &U = Unit.getOrigUnit();
+    UseRefAddr = true;
+    AttrSize = U.getVersion() == 2 ? U.getAddressByteSize() : 4;
+    if (!Canonical.Unit) {
+      Die.addValue(dwarf::Attribute(AttrSpec.Attr), dwarf::DW_FORM_ref_addr,
+                   DIEInteger(Canonical.Offset));
+      return AttrSize;
+    }
+    RefUnit = Canonical.Unit;
+    Idx = Canonical.Idx;
+    RefDie = RefUnit->getOrigUnit().getDIEAtIndex(Idx);
+    Ref = RefDie->getOffset();
+  }
+
   CompileUnit::DIEInfo &RefInfo = RefUnit->getInfo(Idx);
   if (!RefInfo.Clone) {
     assert(Ref > InputDIE.getOffset());
@@ -1875,7 +2155,7 @@ unsigned DwarfLinker::cloneDieReferenceAttribute(
   }
   NewRefDie = RefInfo.Clone;
 
-  if (AttrSpec.Form == dwarf::DW_FORM_ref_addr) {
+  if (UseRefAddr) {
     // We cannot currently rely on a DIEEntry to emit ref_addr
     // references, because the implementation calls back to DwarfDebug
     // to find the unit offset. (We don't have a DwarfDebug)
@@ -1983,9 +2263,9 @@ unsigned DwarfLinker::cloneAddressAttribute(DIE &Die, AttributeSpec AttrSpec,
 /// \brief Clone a scalar attribute  and add it to \p Die.
 /// \returns the size of the new attribute.
 unsigned DwarfLinker::cloneScalarAttribute(
-    DIE &Die, const DWARFDebugInfoEntryMinimal &InputDIE, CompileUnit &Unit,
-    AttributeSpec AttrSpec, const DWARFFormValue &Val, unsigned AttrSize,
-    AttributesInfo &Info) {
+    DIE &Die, const DWARFDebugInfoEntryMinimal &InputDIE, LinkContext &Ctx,
+    CompileUnit &Unit, AttributeSpec AttrSpec, const DWARFFormValue &Val,
+    unsigned AttrSize, AttributesInfo &Info) {
   uint64_t Value;
   if (AttrSpec.Attr == dwarf::DW_AT_high_pc &&
       Die.getTag() == dwarf::DW_TAG_compile_unit) {
@@ -2001,7 +2281,7 @@ unsigned DwarfLinker::cloneScalarAttribute(
     Value = *OptionalValue;
   else {
     reportWarning("Unsupported scalar attribute form. Dropping attribute.",
-                  &Unit.getOrigUnit(), &InputDIE);
+                  Ctx, &Unit.getOrigUnit(), &InputDIE);
     return 0;
   }
   DIEInteger Attr(Value);
@@ -2026,7 +2306,7 @@ unsigned DwarfLinker::cloneScalarAttribute(
 /// \returns the size of the cloned attribute.
 unsigned DwarfLinker::cloneAttribute(DIE &Die,
                                      const DWARFDebugInfoEntryMinimal &InputDIE,
-                                     CompileUnit &Unit,
+                                     LinkContext &Ctx, CompileUnit &Unit,
                                      const DWARFFormValue &Val,
                                      const AttributeSpec AttrSpec,
                                      unsigned AttrSize, AttributesInfo &Info) {
@@ -2042,7 +2322,7 @@ unsigned DwarfLinker::cloneAttribute(DIE &Die,
   case dwarf::DW_FORM_ref4:
   case dwarf::DW_FORM_ref8:
     return cloneDieReferenceAttribute(Die, InputDIE, AttrSpec, AttrSize, Val,
-                                      Unit);
+                                      Ctx, Unit);
   case dwarf::DW_FORM_block:
   case dwarf::DW_FORM_block1:
   case dwarf::DW_FORM_block2:
@@ -2060,11 +2340,11 @@ unsigned DwarfLinker::cloneAttribute(DIE &Die,
   case dwarf::DW_FORM_sec_offset:
   case dwarf::DW_FORM_flag:
   case dwarf::DW_FORM_flag_present:
-    return cloneScalarAttribute(Die, InputDIE, Unit, AttrSpec, Val, AttrSize,
-                                Info);
+    return cloneScalarAttribute(Die, InputDIE, Ctx, Unit, AttrSpec, Val,
+                                AttrSize, Info);
   default:
-    reportWarning("Unsupported attribute form in cloneAttribute. Dropping.", &U,
-                  &InputDIE);
+    reportWarning("Unsupported attribute form in cloneAttribute. Dropping.",
+                  Ctx, &U, &InputDIE);
   }
 
   return 0;
@@ -2079,7 +2359,10 @@ unsigned DwarfLinker::cloneAttribute(DIE &Die,
 ///
 /// \returns wether any reloc has been applied.
 bool DwarfLinker::applyValidRelocs(MutableArrayRef<char> Data,
-                                   uint32_t BaseOffset, bool isLittleEndian) {
+                                   uint32_t BaseOffset, bool isLittleEndian,
+                                   LinkContext &Ctx) {
+  const auto &ValidRelocs = Ctx.ValidRelocs;
+  unsigned &NextValidReloc = Ctx.NextValidReloc;
   assert((NextValidReloc == 0 ||
           BaseOffset > ValidRelocs[NextValidReloc - 1].Offset) &&
          "BaseOffset should only be increasing.");
@@ -2155,8 +2438,8 @@ static bool isTypeTag(uint16_t Tag) {
 ///
 /// \returns the cloned DIE object or null if nothing was selected.
 DIE *DwarfLinker::cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE,
-                           CompileUnit &Unit, int64_t PCOffset,
-                           uint32_t OutOffset) {
+                           LinkContext &Ctx, CompileUnit &Unit,
+                           int64_t PCOffset, uint32_t OutOffset) {
   DWARFUnit &U = Unit.getOrigUnit();
   unsigned Idx = U.getDIEIndex(&InputDIE);
   CompileUnit::DIEInfo &Info = Unit.getInfo(Idx);
@@ -2185,7 +2468,7 @@ DIE *DwarfLinker::cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE,
   SmallString<40> DIECopy(Data.getData().substr(Offset, NextOffset - Offset));
   Data = DataExtractor(DIECopy, Data.isLittleEndian(), Data.getAddressSize());
   // Modify the copy with relocated addresses.
-  if (applyValidRelocs(DIECopy, Offset, Data.isLittleEndian())) {
+  if (applyValidRelocs(DIECopy, Offset, Data.isLittleEndian(), Ctx)) {
     // If we applied relocations, we store the value of high_pc that was
     // potentially stored in the input DIE. If high_pc is an address
     // (Dwarf version == 2), then it might have been relocated to a
@@ -2215,8 +2498,8 @@ DIE *DwarfLinker::cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE,
     Val.extractValue(Data, &Offset, &U);
     AttrSize = Offset - AttrSize;
 
-    OutOffset +=
-        cloneAttribute(*Die, InputDIE, Unit, Val, AttrSpec, AttrSize, AttrInfo);
+    OutOffset += cloneAttribute(*Die, InputDIE, Ctx, Unit, Val, AttrSpec,
+                                AttrSize, AttrInfo);
   }
 
   // Look for accelerator entries.
@@ -2261,7 +2544,7 @@ DIE *DwarfLinker::cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE,
   // Recursively clone children.
   for (auto *Child = InputDIE.getFirstChild(); Child && !Child->isNULL();
        Child = Child->getSibling()) {
-    if (DIE *Clone = cloneDIE(*Child, Unit, PCOffset, OutOffset)) {
+    if (DIE *Clone = cloneDIE(*Child, Ctx, Unit, PCOffset, OutOffset)) {
       Die->addChild(std::unique_ptr<DIE>(Clone));
       OutOffset = Clone->getOffset() + Clone->getSize();
     }
@@ -2278,7 +2561,8 @@ DIE *DwarfLinker::cloneDIE(const DWARFDebugInfoEntryMinimal &InputDIE,
 /// and emit them in the output file. Update the relevant attributes
 /// to point at the new entries.
 void DwarfLinker::patchRangesForUnit(const CompileUnit &Unit,
-                                     DWARFContext &OrigDwarf) const {
+                                     LinkContext &Ctx) const {
+  DWARFContext &OrigDwarf = *Ctx.DwarfContext;
   DWARFDebugRangeList RangeList;
   const auto &FunctionRanges = Unit.getFunctionRanges();
   unsigned AddressSize = Unit.getOrigUnit().getAddressByteSize();
@@ -2307,7 +2591,7 @@ void DwarfLinker::patchRangesForUnit(const CompileUnit &Unit,
       CurrRange = FunctionRanges.find(First.StartAddress + OrigLowPc);
       if (CurrRange == InvalidRange ||
           CurrRange.start() > First.StartAddress + OrigLowPc) {
-        reportWarning("no mapping for range.");
+        reportWarning("no mapping for range.", Ctx);
         continue;
       }
     }
@@ -2367,8 +2651,8 @@ static void insertLineSequence(std::vector<DWARFDebugLine::Row> &Seq,
 /// \brief Extract the line table for \p Unit from \p OrigDwarf, and
 /// recreate a relocated version of these for the address ranges that
 /// are present in the binary.
-void DwarfLinker::patchLineTableForUnit(CompileUnit &Unit,
-                                        DWARFContext &OrigDwarf) {
+void DwarfLinker::patchLineTableForUnit(CompileUnit &Unit, LinkContext &Ctx) {
+  DWARFContext &OrigDwarf = *Ctx.DwarfContext;
   const DWARFDebugInfoEntryMinimal *CUDie = Unit.getOrigUnit().getUnitDIE();
   uint64_t StmtList = CUDie->getAttributeValueAsSectionOffset(
       &Unit.getOrigUnit(), dwarf::DW_AT_stmt_list, -1ULL);
@@ -2445,11 +2729,11 @@ void DwarfLinker::patchLineTableForUnit(CompileUnit &Unit,
           // for now do as dsymutil.
           // FIXME: Understand exactly what cases this addresses and
           // potentially remove it along with the Ranges map.
-          auto Range = Ranges.lower_bound(Row.Address);
-          if (Range != Ranges.begin() && Range != Ranges.end())
+          auto Range = Ctx.Ranges.lower_bound(Row.Address);
+          if (Range != Ctx.Ranges.begin() && Range != Ctx.Ranges.end())
             --Range;
 
-          if (Range != Ranges.end() && Range->first <= Row.Address &&
+          if (Range != Ctx.Ranges.end() && Range->first <= Row.Address &&
               Range->second.first >= Row.Address) {
             StopAddress = Row.Address + Range->second.second;
           }
@@ -2493,7 +2777,7 @@ void DwarfLinker::patchLineTableForUnit(CompileUnit &Unit,
       LineTable.Prologue.DefaultIsStmt != DWARF2_LINE_DEFAULT_IS_STMT ||
       LineTable.Prologue.LineBase != -5 || LineTable.Prologue.LineRange != 14 ||
       LineTable.Prologue.OpcodeBase != 13)
-    reportWarning("line table paramters mismatch. Cannot emit.");
+    reportWarning("line table paramters mismatch. Cannot emit.", Ctx);
   else
     Streamer->emitLineTableForUnit(LineData.slice(StmtList + 4, PrologueEnd),
                                    LineTable.Prologue.MinInstLength, NewRows,
@@ -2511,9 +2795,9 @@ void DwarfLinker::emitAcceleratorEntriesForUnit(CompileUnit &Unit) {
 /// This is actually pretty easy as the data of the CIEs and FDEs can
 /// be considered as black boxes and moved as is. The only thing to do
 /// is to patch the addresses in the headers.
-void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
-                                          DWARFContext &OrigDwarf,
+void DwarfLinker::patchFrameInfoForObject(LinkContext &Ctx,
                                           unsigned AddrSize) {
+  DWARFContext &OrigDwarf = *Ctx.DwarfContext;
   StringRef FrameData = OrigDwarf.getDebugFrameSection();
   if (FrameData.empty())
     return;
@@ -2529,7 +2813,7 @@ void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
     uint32_t EntryOffset = InputOffset;
     uint32_t InitialLength = Data.getU32(&InputOffset);
     if (InitialLength == 0xFFFFFFFF)
-      return reportWarning("Dwarf64 bits no supported");
+      return reportWarning("Dwarf64 bits no supported", Ctx);
 
     uint32_t CIEId = Data.getU32(&InputOffset);
     if (CIEId == 0xFFFFFFFF) {
@@ -2547,10 +2831,10 @@ void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
     // the function entry point, thus we can't just lookup the address
     // in the debug map. Use the linker's range map to see if the FDE
     // describes something that we can relocate.
-    auto Range = Ranges.upper_bound(Loc);
-    if (Range != Ranges.begin())
+    auto Range = Ctx.Ranges.upper_bound(Loc);
+    if (Range != Ctx.Ranges.begin())
       --Range;
-    if (Range == Ranges.end() || Range->first > Loc ||
+    if (Range == Ctx.Ranges.end() || Range->first > Loc ||
         Range->second.first <= Loc) {
       // The +4 is to account for the size of the InitialLength field itself.
       InputOffset = EntryOffset + InitialLength + 4;
@@ -2561,7 +2845,8 @@ void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
     // Have we already emitted a corresponding CIE?
     StringRef CIEData = LocalCIES[CIEId];
     if (CIEData.empty())
-      return reportWarning("Inconsistent debug_frame content. Dropping.");
+      return reportWarning("Inconsistent debug_frame content. Dropping.",
+                           Ctx);
 
     // Look if we already emitted a CIE that corresponds to the
     // referenced one (the CIE data is the key of that lookup).
@@ -2590,6 +2875,152 @@ void DwarfLinker::patchFrameInfoForObject(const DebugMapObject &DMO,
   }
 }
 
+void DwarfLinker::analyzeObject(LinkContext &Ctx) {
+  if (Options.Verbose)
+    outs() << "DEBUG MAP OBJECT: " << Ctx.DMO.getObjectFilename() << "\n";
+  auto ErrOrObj = Ctx.BinHolder.GetObjectFile(Ctx.DMO.getObjectFilename());
+  if (std::error_code EC = ErrOrObj.getError()) {
+    reportWarning(Twine(Ctx.DMO.getObjectFilename()) + ": " + EC.message(),
+                  Ctx);
+    return;
+  }
+
+  // Look for relocations that correspond to debug map entries.
+  if (!findValidRelocsInDebugInfo(*ErrOrObj, Ctx)) {
+    if (Options.Verbose)
+      outs() << "No valid relocations found. Skipping.\n";
+    return;
+  }
+
+  // Setup access to the debug info.
+  Ctx.DwarfContext = llvm::make_unique<DWARFContextInMemory>(*ErrOrObj);
+  startDebugObject(Ctx);
+
+  // In a first phase, just read in the debug info and store the DIE
+  // parent links that we will use during the next phase. The units
+  // get their final IDs in linkObject().
+  for (const auto &CU : Ctx.DwarfContext->compile_units()) {
+    auto *CUDie = CU->getUnitDIE(false);
+    if (Options.Verbose) {
+      outs() << "Input compilation unit:";
+      CUDie->dump(outs(), CU.get(), 0);
+    }
+    bool HasODR = !Options.NoODR &&
+                  isODRLanguage(CUDie->getAttributeValueAsUnsignedConstant(
+                      CU.get(), dwarf::DW_AT_language, 0));
+    Ctx.Units.emplace_back(*CU, 0, HasODR);
+    gatherDIEParents(CUDie, 0, Ctx.Units.back());
+  }
+
+  // The types kept for the previous objects are only known once they are
+  // linked, so leave the uniquing of the types to linkObject().
+  Ctx.DeferODRTypes = true;
+  selectDIEsToKeep(Ctx);
+  Ctx.DeferODRTypes = false;
+}
+
+void DwarfLinker::selectDIEsToKeep(LinkContext &Ctx) {
+  // Note that this loop can not be merged with the one that gathers
+  // the parents becaue cross-cu references require the ParentIdx to be
+  // setup for every CU in the object file before calling this.
+  for (auto &CurrentUnit : Ctx.Units)
+    lookForDIEsToKeep(*CurrentUnit.getOrigUnit().getUnitDIE(), Ctx,
+                      CurrentUnit, 0);
+}
+
+void DwarfLinker::resolveODRTypes(LinkContext &Ctx) {
+  for (const auto &Type : Ctx.DeferredCanonicalTypes) {
+    CompileUnit &CU = *Type.first;
+    addCanonicalType(*CU.getOrigUnit().getDIEAtIndex(Type.second), Ctx, CU,
+                     Type.second);
+  }
+
+  // The types that are still neither kept nor defined elsewhere are kept
+  // along with their dependencies, which are uniqued as they are found.
+  for (const auto &Ref : Ctx.DeferredTypeRefs) {
+    CompileUnit &CU = *Ref.first;
+    const auto *DIE = CU.getOrigUnit().getDIEAtIndex(Ref.second);
+    if (!CU.getInfo(Ref.second).Canonical && !useCanonicalType(*DIE, CU))
+      lookForDIEsToKeep(*DIE, Ctx, CU, TF_Keep | TF_DependencyWalk);
+  }
+
+  Ctx.DeferredCanonicalTypes.clear();
+  Ctx.DeferredTypeRefs.clear();
+}
+
+void DwarfLinker::linkObject(LinkContext &Ctx, uint64_t &OutputDebugInfoSize,
+                             unsigned &UnitID) {
+  // From here on the object is processed in debug map order, so its
+  // warnings can go straight out.
+  errs() << Ctx.Warnings;
+  Ctx.Warnings.clear();
+  Ctx.BufferWarnings = false;
+
+  if (!Ctx.DwarfContext)
+    return;
+  DWARFContext &DwarfContext = *Ctx.DwarfContext;
+  auto &Units = Ctx.Units;
+  for (auto &CurrentUnit : Units)
+    CurrentUnit.setUniqueID(UnitID++);
+
+  resolveODRTypes(Ctx);
+
+  // The calls to applyValidRelocs inside cloneDIE will walk the
+  // reloc array again (in the same way findValidRelocsInDebugInfo()
+  // did). We need to reset the NextValidReloc index to the beginning.
+  Ctx.NextValidReloc = 0;
+
+  // Construct the output DIE tree by cloning the DIEs we chose to
+  // keep above. If there are no valid relocs, then there's nothing
+  // to clone/emit.
+  if (!Ctx.ValidRelocs.empty())
+    for (auto &CurrentUnit : Units) {
+      const auto *InputDIE = CurrentUnit.getOrigUnit().getUnitDIE();
+      CurrentUnit.setStartOffset(OutputDebugInfoSize);
+      DIE *OutputDIE = cloneDIE(*InputDIE, Ctx, CurrentUnit, 0 /* PCOffset */,
+                                11 /* Unit Header size */);
+      CurrentUnit.setOutputUnitDIE(OutputDIE);
+      OutputDebugInfoSize = CurrentUnit.computeNextUnitOffset();
+      if (Options.NoOutput)
+        continue;
+      // FIXME: for compatibility with the classic dsymutil, we emit
+      // an empty line table for the unit, even if the unit doesn't
+      // actually exist in the DIE tree.
+      patchLineTableForUnit(CurrentUnit, Ctx);
+      if (!OutputDIE)
+        continue;
+      patchRangesForUnit(CurrentUnit, Ctx);
+      Streamer->emitLocationsForUnit(CurrentUnit, DwarfContext);
+      emitAcceleratorEntriesForUnit(CurrentUnit);
+    }
+
+  // The canonical types of the object now have their final offsets, and
+  // the next objects can refer to them directly.
+  for (CanonicalType *Type : Ctx.CanonicalTypes) {
+    const DIE *Clone = Type->Unit->getInfo(Type->Idx).Clone;
+    assert(Clone && "Canonical type was not cloned");
+    Type->Offset = Type->Unit->getStartOffset() + Clone->getOffset();
+    Type->Unit = nullptr;
+  }
+
+  // Emit all the compile unit's debug information.
+  if (!Ctx.ValidRelocs.empty() && !Options.NoOutput)
+    for (auto &CurrentUnit : Units) {
+      generateUnitRanges(CurrentUnit);
+      CurrentUnit.fixupForwardReferences();
+      Streamer->emitCompileUnitHeader(CurrentUnit);
+      if (!CurrentUnit.getOutputUnitDIE())
+        continue;
+      Streamer->emitDIE(*CurrentUnit.getOutputUnitDIE());
+    }
+
+  if (!Ctx.ValidRelocs.empty() && !Options.NoOutput && !Units.empty())
+    patchFrameInfoForObject(Ctx, Units[0].getOrigUnit().getAddressByteSize());
+
+  // Clean-up before starting working on the next object.
+  endDebugObject(Ctx);
+}
+
 bool DwarfLinker::link(const DebugMap &Map) {
 
   if (Map.begin() == Map.end()) {
@@ -2604,95 +3035,43 @@ bool DwarfLinker::link(const DebugMap &Map) {
   uint64_t OutputDebugInfoSize = 0;
   // A unique ID that identifies each compile unit.
   unsigned UnitID = 0;
-  for (const auto &Obj : Map.objects()) {
-    CurrentDebugObject = Obj.get();
-
-    if (Options.Verbose)
-      outs() << "DEBUG MAP OBJECT: " << Obj->getObjectFilename() << "\n";
-    auto ErrOrObj = BinHolder.GetObjectFile(Obj->getObjectFilename());
-    if (std::error_code EC = ErrOrObj.getError()) {
-      reportWarning(Twine(Obj->getObjectFilename()) + ": " + EC.message());
-      continue;
-    }
 
-    // Look for relocations that correspond to debug map entries.
-    if (!findValidRelocsInDebugInfo(*ErrOrObj, *Obj)) {
-      if (Options.Verbose)
-        outs() << "No valid relocations found. Skipping.\n";
-      continue;
-    }
-
-    // Setup access to the debug info.
-    DWARFContextInMemory DwarfContext(*ErrOrObj);
-    startDebugObject(DwarfContext, *Obj);
-
-    // In a first phase, just read in the debug info and store the DIE
-    // parent links that we will use during the next phase.
-    for (const auto &CU : DwarfContext.compile_units()) {
-      auto *CUDie = CU->getUnitDIE(false);
-      if (Options.Verbose) {
-        outs() << "Input compilation unit:";
-        CUDie->dump(outs(), CU.get(), 0);
+  // The objects that are being analyzed, or are waiting to be linked,
+  // in debug map order.
+  std::deque<std::unique_ptr<LinkContext>> Pending;
+
+  // The verbose output of the analysis is interleaved with the one of
+  // the link, so only analyze objects ahead of time when it is off.
+  unsigned NumThreads = Options.Verbose ? 1 : Options.NumThreads;
+  if (NumThreads == 0)
+    NumThreads = ThreadPool::getDefaultConcurrency();
+  std::unique_ptr<ThreadPool> Pool;
+  if (NumThreads > 1)
+    Pool = llvm::make_unique<ThreadPool>(NumThreads);
+
+  // Bound the number of objects that are held in memory: an object is
+  // released as soon as it is linked, and the analysis only runs a few
+  // objects ahead of the link.
+  unsigned MaxPending = Pool ? 2 * NumThreads : 1;
+
+  auto NextObj = Map.begin(), EndObj = Map.end();
+  while (NextObj != EndObj || !Pending.empty()) {
+    while (NextObj != EndObj && Pending.size() < MaxPending) {
+      Pending.push_back(llvm::make_unique<LinkContext>(
+          **NextObj++, Options.Verbose, /*BufferWarnings=*/bool(Pool)));
+      if (Pool) {
+        LinkContext &Ctx = *Pending.back();
+        Ctx.Analyzed = Pool->async([this, &Ctx] { analyzeObject(Ctx); });
       }
-      Units.emplace_back(*CU, UnitID++);
-      gatherDIEParents(CUDie, 0, Units.back());
     }
 
-    // Then mark all the DIEs that need to be present in the linked
-    // output and collect some information about them. Note that this
-    // loop can not be merged with the previous one becaue cross-cu
-    // references require the ParentIdx to be setup for every CU in
-    // the object file before calling this.
-    for (auto &CurrentUnit : Units)
-      lookForDIEsToKeep(*CurrentUnit.getOrigUnit().getUnitDIE(), *Obj,
-                        CurrentUnit, 0);
-
-    // The calls to applyValidRelocs inside cloneDIE will walk the
-    // reloc array again (in the same way findValidRelocsInDebugInfo()
-    // did). We need to reset the NextValidReloc index to the beginning.
-    NextValidReloc = 0;
-
-    // Construct the output DIE tree by cloning the DIEs we chose to
-    // keep above. If there are no valid relocs, then there's nothing
-    // to clone/emit.
-    if (!ValidRelocs.empty())
-      for (auto &CurrentUnit : Units) {
-        const auto *InputDIE = CurrentUnit.getOrigUnit().getUnitDIE();
-        CurrentUnit.setStartOffset(OutputDebugInfoSize);
-        DIE *OutputDIE = cloneDIE(*InputDIE, CurrentUnit, 0 /* PCOffset */,
-                                  11 /* Unit Header size */);
-        CurrentUnit.setOutputUnitDIE(OutputDIE);
-        OutputDebugInfoSize = CurrentUnit.computeNextUnitOffset();
-        if (Options.NoOutput)
-          continue;
-        // FIXME: for compatibility with the classic dsymutil, we emit
-        // an empty line table for the unit, even if the unit doesn't
-        // actually exist in the DIE tree.
-        patchLineTableForUnit(CurrentUnit, DwarfContext);
-        if (!OutputDIE)
-          continue;
-        patchRangesForUnit(CurrentUnit, DwarfContext);
-        Streamer->emitLocationsForUnit(CurrentUnit, DwarfContext);
-        emitAcceleratorEntriesForUnit(CurrentUnit);
-      }
-
-    // Emit all the compile unit's debug information.
-    if (!ValidRelocs.empty() && !Options.NoOutput)
-      for (auto &CurrentUnit : Units) {
-        generateUnitRanges(CurrentUnit);
-        CurrentUnit.fixupForwardReferences();
-        Streamer->emitCompileUnitHeader(CurrentUnit);
-        if (!CurrentUnit.getOutputUnitDIE())
-          continue;
-        Streamer->emitDIE(*CurrentUnit.getOutputUnitDIE());
-      }
-
-    if (!ValidRelocs.empty() && !Options.NoOutput && !Units.empty())
-      patchFrameInfoForObject(*Obj, DwarfContext,
-                              Units[0].getOrigUnit().getAddressByteSize());
-
-    // Clean-up before starting working on the next object.
-    endDebugObject();
+    std::unique_ptr<LinkContext> Ctx = std::move(Pending.front());
+    Pending.pop_front();
+    if (Pool)
+      Ctx->Analyzed.wait();
+    else
+      analyzeObject(*Ctx);
+    linkObject(*Ctx, OutputDebugInfoSize, UnitID);
   }
 
   // Emit everything that's global.
@@ -47,6 +47,19 @@ static opt<bool>
              desc("Do the link in memory, but do not emit the result file."),
              init(false));
 
+static opt<bool>
+    NoODR("no-odr",
+          desc("Do not use the One Definition Rule to unique C++ types."),
+          init(false));
+
+static opt<unsigned> NumThreads(
+    "num-threads",
+    desc("Specifies the maximum number of threads to use to analyze the "
+         "object files. Defaults to the number of cores, or 1 with -v."),
+    init(0));
+static alias NumThreadsA("j", desc("Alias for --num-threads"),
+                         aliasopt(NumThreads));
+
 static opt<bool> DumpDebugMap(
     "dump-debug-map",
     desc("Parse and dump the debug map to standard output. Not DWARF link "
@@ -71,6 +84,8 @@ int main(int argc, char **argv) {
 
   Options.Verbose = Verbose;
   Options.NoOutput = NoOutput;
+  Options.NoODR = NoODR;
+  Options.NumThreads = NumThreads;
 
   llvm::InitializeAllTargetInfos();
   llvm::InitializeAllTargetMCs();
@@ -25,10 +25,13 @@ namespace llvm {
 namespace dsymutil {
 
 struct LinkOptions {
-  bool Verbose;  ///< Verbosity
-  bool NoOutput; ///< Skip emitting output
+  bool Verbose;        ///< Verbosity
+  bool NoOutput;       ///< Skip emitting output
+  bool NoODR;          ///< Do not unique C++ types
+  unsigned NumThreads; ///< Number of threads, 0 for one per core
 
-  LinkOptions() : Verbose(false), NoOutput(false) {}
+  LinkOptions()
+      : Verbose(false), NoOutput(false), NoODR(false), NumThreads(0) {}
 };
 
 /// \brief Extract the DebugMap from the given file.
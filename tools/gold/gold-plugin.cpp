@@ -14,12 +14,14 @@
 
 #include "llvm/Config/config.h" // plugin-api.h requires HAVE_STDINT_H
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -92,6 +94,9 @@ namespace options {
   static bool generate_api_file = false;
   static OutputType TheOutputType = OT_NORMAL;
   static unsigned OptLevel = 2;
+  // Number of partitions the merged module is split into for code generation.
+  // The partitions are code generated in parallel.
+  static unsigned Parallelism = 1;
   static std::string obj_path;
   static std::string extra_library_path;
   static std::string triple;
@@ -125,6 +130,11 @@ namespace options {
       TheOutputType = OT_SAVE_TEMPS;
     } else if (opt == "disable-output") {
       TheOutputType = OT_DISABLE;
+    } else if (opt.startswith("jobs=")) {
+      if (opt.substr(strlen("jobs=")).getAsInteger(10, Parallelism) ||
+          !Parallelism)
+        message(LDPL_FATAL, "Invalid parallelism level: %s",
+                opt_ + strlen("jobs="));
     } else if (opt.size() == 2 && opt[0] == 'O') {
       if (opt[1] < '0' || opt[1] > '3')
         report_fatal_error("Optimization level must be between 0 and 3");
@@ -784,40 +794,56 @@ static void codegen(Module &M) {
   if (options::TheOutputType == options::OT_SAVE_TEMPS)
     saveBCFile(output_name + ".opt.bc", M);
 
-  legacy::PassManager CodeGenPasses;
-
-  SmallString<128> Filename;
-  int FD;
-  if (options::obj_path.empty()) {
-    std::error_code EC =
-        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
-    if (EC)
-      message(LDPL_FATAL, "Could not create temporary file: %s",
-              EC.message().c_str());
-  } else {
-    Filename = options::obj_path;
-    std::error_code EC =
-        sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
-    if (EC)
-      message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+  // Open one object file per partition. With obj-path, partition I is written
+  // to obj-path with I appended if there is more than one partition.
+  std::vector<std::string> Filenames;
+  std::list<raw_fd_ostream> OSs;
+  std::vector<raw_pwrite_stream *> OSPtrs;
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    if (options::obj_path.empty()) {
+      std::error_code EC =
+          sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+      if (EC)
+        message(LDPL_FATAL, "Could not create temporary file: %s",
+                EC.message().c_str());
+    } else {
+      Filename = options::obj_path;
+      if (options::Parallelism != 1)
+        Filename += utostr(I);
+      std::error_code EC =
+          sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
+      if (EC)
+        message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+    }
+    Filenames.push_back(Filename.str());
+    OSs.emplace_back(FD, true);
+    OSPtrs.push_back(&OSs.back());
   }
 
-  {
-    raw_fd_ostream OS(FD, true);
-
-    if (TM->addPassesToEmitFile(CodeGenPasses, OS,
+  if (options::Parallelism == 1) {
+    legacy::PassManager CodeGenPasses;
+    if (TM->addPassesToEmitFile(CodeGenPasses, *OSPtrs[0],
                                 TargetMachine::CGFT_ObjectFile))
       message(LDPL_FATAL, "Failed to setup codegen");
     CodeGenPasses.run(M);
+  } else {
+    splitCodeGen(M, OSPtrs, options::mcpu, Features.getString(), Options,
+                 RelocationModel, CodeModel::Default, CGOptLevel);
   }
+  // Close the object files before handing them to gold.
+  OSs.clear();
 
-  if (add_input_file(Filename.c_str()) != LDPS_OK)
-    message(LDPL_FATAL,
-            "Unable to add .o file to the link. File left behind in: %s",
-            Filename.c_str());
+  for (const std::string &Filename : Filenames) {
+    if (add_input_file(Filename.c_str()) != LDPS_OK)
+      message(LDPL_FATAL,
+              "Unable to add .o file to the link. File left behind in: %s",
+              Filename.c_str());
 
-  if (options::obj_path.empty())
-    Cleanup.push_back(Filename.c_str());
+    if (options::obj_path.empty())
+      Cleanup.push_back(Filename);
+  }
 }
 
 /// gold informs us that all symbols have been read. At this point, we use
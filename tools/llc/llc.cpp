@@ -15,12 +15,15 @@
 
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/CodeGen/CodeGenCache.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
 #include "llvm/CodeGen/MIRParser/MIRParser.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
@@ -42,10 +45,12 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeTraceProfiler.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetSubtargetInfo.h"
 #include <memory>
+#include <vector>
 using namespace llvm;
 
 // General options for llc.  Other pass-specific options are specified
@@ -96,11 +101,59 @@ static cl::opt<bool> AsmVerbose("asm-verbose",
                                 cl::desc("Add comments to directives."),
                                 cl::init(true));
 
+static cl::opt<unsigned>
+Threads("j", cl::desc("Number of threads to use for split code generation"),
+        cl::value_desc("N"), cl::init(1));
+
+static cl::opt<unsigned>
+CodeGenPartitions("codegen-partitions",
+                  cl::desc("Split the module into N partitions that are code "
+                           "generated in parallel, writing partition I to "
+                           "<output>I"),
+                  cl::value_desc("N"), cl::init(1));
+
+static cl::opt<std::string>
+CacheDir("cache-dir",
+         cl::desc("Reuse the output of previous compilations of the same "
+                  "module with the same options, from this directory"),
+         cl::value_desc("directory"));
+
+static cl::opt<unsigned>
+CacheMaxSize("cache-max-size",
+             cl::desc("Prune the least recently used entries of the "
+                      "-cache-dir directory down to this size (0 = no limit)"),
+             cl::value_desc("megabytes"), cl::init(0));
+
 static int compileModule(char **, LLVMContext &);
 
+namespace {
+/// A stream that collects the output for the cache in memory. Unlike
+/// raw_svector_ostream, it keeps working once it is made unbuffered, which
+/// the formatted_raw_ostream of the asm printer does to the stream it writes
+/// to.
+class CacheOutputStream : public raw_pwrite_stream {
+  SmallVectorImpl<char> &Data;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Data.append(Ptr, Ptr + Size);
+  }
+
+  void pwrite_impl(const char *Ptr, size_t Size, uint64_t Offset) override {
+    flush();
+    memcpy(Data.data() + Offset, Ptr, Size);
+  }
+
+  uint64_t current_pos() const override { return Data.size(); }
+
+public:
+  explicit CacheOutputStream(SmallVectorImpl<char> &Data) : Data(Data) {}
+  ~CacheOutputStream() override { flush(); }
+};
+} // end anonymous namespace
+
 static std::unique_ptr<tool_output_file>
 GetOutputStream(const char *TargetName, Triple::OSType OS,
-                const char *ProgName) {
+                const char *ProgName, StringRef Suffix = "") {
   // If we don't yet have an output filename, make one.
   if (OutputFilename.empty()) {
     if (InputFilename == "-")
@@ -151,13 +204,20 @@ GetOutputStream(const char *TargetName, Triple::OSType OS,
     break;
   }
 
+  // Each partition of a split module needs an output file of its own.
+  if (!Suffix.empty() && OutputFilename == "-") {
+    errs() << ProgName << ": split code generation cannot write to "
+           << "standard output\n";
+    return nullptr;
+  }
+
   // Open the file.
   std::error_code EC;
   sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
   if (!Binary)
     OpenFlags |= sys::fs::F_Text;
-  auto FDOut = llvm::make_unique<tool_output_file>(OutputFilename, EC,
-                                                   OpenFlags);
+  auto FDOut = llvm::make_unique<tool_output_file>(
+      (OutputFilename + Suffix).str(), EC, OpenFlags);
   if (EC) {
     errs() << EC.message() << '\n';
     return nullptr;
@@ -198,11 +258,18 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  timeTraceProfilerInitializeFromOptions(argv[0]);
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
-  for (unsigned I = TimeCompilations; I; --I)
+  for (unsigned I = TimeCompilations; I; --I) {
+    TimeTraceScope TraceScope("compileModule", InputFilename);
     if (int RetVal = compileModule(argv, Context))
       return RetVal;
+  }
+
+  if (timeTraceProfilerWriteFile(OutputFilename))
+    return 1;
   return 0;
 }
 
@@ -290,22 +357,49 @@ static int compileModule(char **argv, LLVMContext &Context) {
   if (FloatABIForCalls != FloatABI::Default)
     Options.FloatABIType = FloatABIForCalls;
 
+  // The number of partitions is independent of -j, so that the output of a
+  // module doesn't depend on the number of threads that produce it.
+  unsigned NumPartitions = CodeGenPartitions;
+  if (NumPartitions > 1) {
+    if (!StartAfter.empty() || !StopAfter.empty() || DisableSimplifyLibCalls) {
+      errs() << argv[0] << ": -start-after, -stop-after and "
+             << "-disable-simplify-libcalls cannot be used with split code "
+             << "generation\n";
+      return 1;
+    }
+
+    // Figure out where we are going to send the output of each partition.
+    std::vector<std::unique_ptr<tool_output_file>> Outs;
+    std::vector<raw_pwrite_stream *> OSs;
+    for (unsigned I = 0; I != NumPartitions; ++I) {
+      Outs.push_back(GetOutputStream(TheTarget->getName(), TheTriple.getOS(),
+                                     argv[0], utostr(I)));
+      if (!Outs.back())
+        return 1;
+      OSs.push_back(&Outs.back()->os());
+    }
+
+    if (const DataLayout *DL = Target->getDataLayout())
+      M->setDataLayout(*DL);
+    setFunctionAttributes(CPUStr, FeaturesStr, *M);
+
+    // Before executing passes, print the final values of the LLVM options.
+    cl::PrintOptionValues();
+
+    splitCodeGen(*M, OSs, CPUStr, FeaturesStr, Options, RelocModel,
+                 CMModel, OLvl, FileType, Threads);
+
+    // Declare success.
+    for (auto &Out : Outs)
+      Out->keep();
+    return 0;
+  }
+
   // Figure out where we are going to send the output.
   std::unique_ptr<tool_output_file> Out =
       GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]);
   if (!Out) return 1;
 
-  // Build up all of the passes that we want to do to the module.
-  legacy::PassManager PM;
-
-  // Add an appropriate TargetLibraryInfo pass for the module's triple.
-  TargetLibraryInfoImpl TLII(Triple(M->getTargetTriple()));
-
-  // The -disable-simplify-libcalls flag actually disables all builtin optzns.
-  if (DisableSimplifyLibCalls)
-    TLII.disableAllFunctions();
-  PM.add(new TargetLibraryInfoWrapperPass(TLII));
-
   // Add the target data from the target machine, if it exists, or the module.
   if (const DataLayout *DL = Target->getDataLayout())
     M->setDataLayout(*DL);
@@ -319,11 +413,54 @@ static int compileModule(char **argv, LLVMContext &Context) {
     errs() << argv[0]
              << ": warning: ignoring -mc-relax-all because filetype != obj";
 
+  // Look up the output in the cache, now that the module has been given its
+  // final attributes. MIR files cannot be cached, as the key only covers the
+  // IR of the module.
+  std::unique_ptr<CodeGenCache> Cache;
+  std::string CacheKey;
+  SmallVector<char, 0> CacheBuffer;
+  std::unique_ptr<CacheOutputStream> CacheOS;
+  if (!CacheDir.empty() && !StringRef(InputFilename).endswith_lower(".mir")) {
+    // The command line options affect the output, except for the ones that
+    // only name files or configure the cache.
+    std::vector<std::string> Args;
+    for (char **Arg = argv + 1; *Arg; ++Arg) {
+      StringRef A = *Arg;
+      if (A == InputFilename || A == OutputFilename || A == CacheDir ||
+          A == "-o" || A.startswith("-cache-") || A.startswith("--cache-"))
+        continue;
+      Args.push_back(A);
+    }
+    Cache = make_unique<CodeGenCache>(CacheDir);
+    CacheKey = CodeGenCache::computeKey(*M, *Target, FileType, Args);
+    if (std::unique_ptr<MemoryBuffer> Cached = Cache->lookup(CacheKey)) {
+      Out->os() << Cached->getBuffer();
+      Out->keep();
+      return 0;
+    }
+    CacheOS = make_unique<CacheOutputStream>(CacheBuffer);
+  }
+
+  // The passes are destroyed at the end of this scope, which flushes the
+  // output of the asm printer to OS.
   {
+    // Build up all of the passes that we want to do to the module.
+    legacy::PassManager PM;
+
+    // Add an appropriate TargetLibraryInfo pass for the module's triple.
+    TargetLibraryInfoImpl TLII(Triple(M->getTargetTriple()));
+
+    // The -disable-simplify-libcalls flag actually disables all builtin optzns.
+    if (DisableSimplifyLibCalls)
+      TLII.disableAllFunctions();
+    PM.add(new TargetLibraryInfoWrapperPass(TLII));
+
     raw_pwrite_stream *OS = &Out->os();
     std::unique_ptr<buffer_ostream> BOS;
-    if (FileType != TargetMachine::CGFT_AssemblyFile &&
-        !Out->os().supportsSeeking()) {
+    if (CacheOS) {
+      OS = CacheOS.get();
+    } else if (FileType != TargetMachine::CGFT_AssemblyFile &&
+               !Out->os().supportsSeeking()) {
       BOS = make_unique<buffer_ostream>(*OS);
       OS = BOS.get();
     }
@@ -362,6 +499,14 @@ static int compileModule(char **argv, LLVMContext &Context) {
     PM.run(*M);
   }
 
+  if (Cache) {
+    CacheOS->flush();
+    StringRef Output(CacheBuffer.data(), CacheBuffer.size());
+    Cache->store(CacheKey, Output);
+    Cache->prune(uint64_t(CacheMaxSize) << 20);
+    Out->os() << Output;
+  }
+
   // Declare success.
   Out->keep();
 
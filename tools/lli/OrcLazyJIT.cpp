@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "OrcLazyJIT.h"
+#include "llvm/ExecutionEngine/FileObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/OrcTargetSupport.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/DynamicLibrary.h"
@@ -39,6 +40,13 @@ namespace {
                                              "working directory. (WARNING: "
                                              "will overwrite existing files)."),
                                   clEnumValEnd));
+
+  cl::opt<unsigned>
+  OrcSpeculateThreads("orc-lazy-speculate-threads",
+                      cl::desc("Number of threads used by the orc-lazy JIT "
+                               "to compile the callees of each compiled "
+                               "function ahead of their first call."),
+                      cl::init(0));
 }
 
 OrcLazyJIT::CallbackManagerBuilder
@@ -108,7 +116,9 @@ OrcLazyJIT::TransformFtor OrcLazyJIT::createDebugDumper() {
   llvm_unreachable("Unknown DumpKind");
 }
 
-int llvm::runOrcLazyJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[]) {
+int llvm::runOrcLazyJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[],
+                        StringRef ObjectCacheDir,
+                        uint64_t ObjectCacheSizeLimit) {
   // Add the program's symbols into the JIT's search space.
   if (sys::DynamicLibrary::LoadLibraryPermanently(nullptr)) {
     errs() << "Error loading program symbols.\n";
@@ -130,8 +140,15 @@ int llvm::runOrcLazyJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[]) {
     return 1;
   }
 
+  // Set up the persistent object cache, if requested. It must outlive the JIT.
+  std::unique_ptr<FileObjectCache> ObjCache;
+  if (!ObjectCacheDir.empty())
+    ObjCache = llvm::make_unique<FileObjectCache>(ObjectCacheDir, *TM,
+                                                  ObjectCacheSizeLimit);
+
   // Everything looks good. Build the JIT.
-  OrcLazyJIT J(std::move(TM), Context, CallbackMgrBuilder);
+  OrcLazyJIT J(std::move(TM), Context, CallbackMgrBuilder, OrcSpeculateThreads);
+  J.setObjectCache(ObjCache.get());
 
   // Add the module, look up main and run it.
   auto MainHandle = J.addModule(std::move(M));
@@ -48,14 +48,17 @@ public:
   static CallbackManagerBuilder createCallbackManagerBuilder(Triple T);
 
   OrcLazyJIT(std::unique_ptr<TargetMachine> TM, LLVMContext &Context,
-             CallbackManagerBuilder &BuildCallbackMgr)
+             CallbackManagerBuilder &BuildCallbackMgr,
+             unsigned NumSpeculationThreads = 0)
     : TM(std::move(TM)),
       Mang(this->TM->getDataLayout()),
       ObjectLayer(),
       CompileLayer(ObjectLayer, orc::SimpleCompiler(*this->TM)),
       IRDumpLayer(CompileLayer, createDebugDumper()),
-      CCMgr(BuildCallbackMgr(IRDumpLayer, CCMgrMemMgr, Context)),
-      CODLayer(IRDumpLayer, *CCMgr),
+      CCMgrCompileLayer(ObjectLayer, orc::SimpleCompiler(*this->TM)),
+      CCMgrIRDumpLayer(CCMgrCompileLayer, createDebugDumper()),
+      CCMgr(BuildCallbackMgr(CCMgrIRDumpLayer, CCMgrMemMgr, Context)),
+      CODLayer(IRDumpLayer, *CCMgr, NumSpeculationThreads),
       CXXRuntimeOverrides([this](const std::string &S) { return mangle(S); }) {}
 
   ~OrcLazyJIT() {
@@ -129,6 +132,11 @@ public:
     return CODLayer.findSymbolIn(H, mangle(Name), true);
   }
 
+  /// Look up compiled objects in Cache, and add newly compiled objects to it.
+  void setObjectCache(ObjectCache *Cache) {
+    CompileLayer.setObjectCache(Cache);
+  }
+
 private:
 
   std::string mangle(const std::string &Name) {
@@ -149,6 +157,10 @@ private:
   ObjLayerT ObjectLayer;
   CompileLayerT CompileLayer;
   IRDumpLayerT IRDumpLayer;
+  // The trampolines of the callback manager embed its address, so they are
+  // compiled by layers of their own, which don't use the object cache.
+  CompileLayerT CCMgrCompileLayer;
+  IRDumpLayerT CCMgrIRDumpLayer;
   std::unique_ptr<CompileCallbackMgr> CCMgr;
   CODLayerT CODLayer;
 
@@ -156,7 +168,9 @@ private:
   std::vector<orc::CtorDtorRunner<CODLayerT>> IRStaticDestructorRunners;
 };
 
-int runOrcLazyJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[]);
+int runOrcLazyJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[],
+                  StringRef ObjectCacheDir = "",
+                  uint64_t ObjectCacheSizeLimit = 0);
 
 } // end namespace llvm
 
@@ -0,0 +1,137 @@
+//===----- OrcTieredJIT.cpp - Orc-based JIT with tiered compilation -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "OrcTieredJIT.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "orc-tiered"
+
+namespace {
+
+  cl::opt<unsigned>
+  HotThreshold("orc-tier-up-threshold",
+               cl::desc("Number of calls after which the orc-tiered JIT "
+                        "recompiles a function with optimization."),
+               cl::init(1000));
+}
+
+OrcTieredJIT::ModuleHandleT
+OrcTieredJIT::addModule(std::unique_ptr<Module> M) {
+  // Attach a data-layout if one isn't already present.
+  if (M->getDataLayout().isDefault())
+    M->setDataLayout(*BaselineTM->getDataLayout());
+
+  // Record the static constructors and destructors. We have to do this before
+  // we hand over ownership of the module to the JIT.
+  std::vector<std::string> CtorNames, DtorNames;
+  for (auto Ctor : orc::getConstructors(*M))
+    CtorNames.push_back(mangle(Ctor.Func->getName()));
+  for (auto Dtor : orc::getDestructors(*M))
+    DtorNames.push_back(mangle(Dtor.Func->getName()));
+
+  // Symbol resolution order:
+  //   1) Search the JIT symbols.
+  //   2) Check for C++ runtime overrides.
+  //   3) Search the host process (LLI)'s symbol table.
+  auto Resolver =
+    orc::createLambdaResolver(
+      [this](const std::string &Name) {
+
+        if (auto Sym = TieredLayer.findSymbol(Name, true))
+          return RuntimeDyld::SymbolInfo(Sym.getAddress(), Sym.getFlags());
+
+        if (auto Sym = CXXRuntimeOverrides.searchOverrides(Name))
+          return Sym;
+
+        if (auto Addr = RTDyldMemoryManager::getSymbolAddressInProcess(Name))
+          return RuntimeDyld::SymbolInfo(Addr, JITSymbolFlags::Exported);
+
+        return RuntimeDyld::SymbolInfo(nullptr);
+      },
+      [](const std::string &Name) { return RuntimeDyld::SymbolInfo(nullptr); }
+    );
+
+  // Add the module to the JIT.
+  std::vector<std::unique_ptr<Module>> S;
+  S.push_back(std::move(M));
+  auto H = TieredLayer.addModuleSet(std::move(S), nullptr, std::move(Resolver));
+
+  // Run the static constructors, and save the static destructor runner for
+  // execution when the JIT is torn down.
+  orc::CtorDtorRunner<TieredLayerT> CtorRunner(std::move(CtorNames), H);
+  CtorRunner.runViaLayer(TieredLayer);
+
+  IRStaticDestructorRunners.emplace_back(std::move(DtorNames), H);
+
+  return H;
+}
+
+OrcTieredJIT::TransformFtor OrcTieredJIT::createOptimizer() {
+  return [](std::unique_ptr<Module> M) {
+    DEBUG(for (const auto &F : *M)
+            if (!F.isDeclaration() && !F.hasAvailableExternallyLinkage())
+              dbgs() << "[tier-up] " << F.getName() << "\n");
+
+    // The module holds the hot function and available_externally copies of
+    // its callees; inline those and run the rest of the -O2 pipeline.
+    PassManagerBuilder Builder;
+    Builder.OptLevel = 2;
+    Builder.Inliner = createFunctionInliningPass(Builder.OptLevel, 0);
+    legacy::FunctionPassManager FPM(M.get());
+    Builder.populateFunctionPassManager(FPM);
+    FPM.doInitialization();
+    for (auto &F : *M)
+      FPM.run(F);
+    FPM.doFinalization();
+
+    legacy::PassManager MPM;
+    Builder.populateModulePassManager(MPM);
+    MPM.run(*M);
+    return M;
+  };
+}
+
+int llvm::runOrcTieredJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[]) {
+  // Add the program's symbols into the JIT's search space.
+  if (sys::DynamicLibrary::LoadLibraryPermanently(nullptr)) {
+    errs() << "Error loading program symbols.\n";
+    return 1;
+  }
+
+  // Functions are first compiled with FastISel, then recompiled with the
+  // default optimization level once they are hot.
+  auto BaselineTM = std::unique_ptr<TargetMachine>(
+    EngineBuilder().setOptLevel(CodeGenOpt::None).selectTarget());
+  auto OptTM = std::unique_ptr<TargetMachine>(
+    EngineBuilder().setOptLevel(CodeGenOpt::Default).selectTarget());
+
+  OrcTieredJIT J(std::move(BaselineTM), std::move(OptTM), HotThreshold);
+
+  // Add the module, look up main and run it.
+  auto MainHandle = J.addModule(std::move(M));
+  auto MainSym = J.findSymbolIn(MainHandle, "main");
+
+  if (!MainSym) {
+    errs() << "Could not find main function.\n";
+    return 1;
+  }
+
+  typedef int (*MainFnPtr)(int, char*[]);
+  auto Main = OrcTieredJIT::fromTargetAddress<MainFnPtr>(MainSym.getAddress());
+  return Main(ArgC, ArgV);
+}
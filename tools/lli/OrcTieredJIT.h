@@ -0,0 +1,102 @@
+//===--- OrcTieredJIT.h - Orc-based JIT with tiered compilation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Orc-based JIT that compiles everything with FastISel first, and recompiles
+// hot functions at -O2 in the background.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLI_ORCTIEREDJIT_H
+#define LLVM_TOOLS_LLI_ORCTIEREDJIT_H
+
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/IRTransformLayer.h"
+#include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/Orc/TieredCompileLayer.h"
+#include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
+
+namespace llvm {
+
+class OrcTieredJIT {
+public:
+
+  typedef orc::ObjectLinkingLayer<> ObjLayerT;
+  typedef orc::IRCompileLayer<ObjLayerT> CompileLayerT;
+  typedef std::function<std::unique_ptr<Module>(std::unique_ptr<Module>)>
+    TransformFtor;
+  typedef orc::IRTransformLayer<CompileLayerT, TransformFtor> OptimizeLayerT;
+  typedef orc::TieredCompileLayer<CompileLayerT, OptimizeLayerT> TieredLayerT;
+  typedef TieredLayerT::ModuleSetHandleT ModuleHandleT;
+
+  OrcTieredJIT(std::unique_ptr<TargetMachine> BaselineTM,
+               std::unique_ptr<TargetMachine> OptTM, uint64_t HotThreshold)
+    : BaselineTM(std::move(BaselineTM)), OptTM(std::move(OptTM)),
+      Mang(this->BaselineTM->getDataLayout()),
+      ObjectLayer(),
+      BaselineCompileLayer(ObjectLayer, orc::SimpleCompiler(*this->BaselineTM)),
+      OptCompileLayer(ObjectLayer, orc::SimpleCompiler(*this->OptTM)),
+      OptimizeLayer(OptCompileLayer, createOptimizer()),
+      TieredLayer(BaselineCompileLayer, OptimizeLayer, HotThreshold),
+      CXXRuntimeOverrides([this](const std::string &S) { return mangle(S); }) {}
+
+  ~OrcTieredJIT() {
+    // Run any destructors registered with __cxa_atexit.
+    CXXRuntimeOverrides.runDestructors();
+    // Run any IR destructors.
+    for (auto &DtorRunner : IRStaticDestructorRunners)
+      DtorRunner.runViaLayer(TieredLayer);
+    // Let in-flight recompilation finish while the layers below still exist.
+    TieredLayer.waitForRecompilation();
+  }
+
+  template <typename PtrTy>
+  static PtrTy fromTargetAddress(orc::TargetAddress Addr) {
+    return reinterpret_cast<PtrTy>(static_cast<uintptr_t>(Addr));
+  }
+
+  ModuleHandleT addModule(std::unique_ptr<Module> M);
+
+  orc::JITSymbol findSymbolIn(ModuleHandleT H, const std::string &Name) {
+    return TieredLayer.findSymbolIn(H, mangle(Name), true);
+  }
+
+private:
+
+  std::string mangle(const std::string &Name) {
+    std::string MangledName;
+    {
+      raw_string_ostream MangledNameStream(MangledName);
+      Mang.getNameWithPrefix(MangledNameStream, Name);
+    }
+    return MangledName;
+  }
+
+  static TransformFtor createOptimizer();
+
+  std::unique_ptr<TargetMachine> BaselineTM;
+  std::unique_ptr<TargetMachine> OptTM;
+  Mangler Mang;
+
+  ObjLayerT ObjectLayer;
+  CompileLayerT BaselineCompileLayer;
+  CompileLayerT OptCompileLayer;
+  OptimizeLayerT OptimizeLayer;
+  TieredLayerT TieredLayer;
+
+  orc::LocalCXXRuntimeOverrides CXXRuntimeOverrides;
+  std::vector<orc::CtorDtorRunner<TieredLayerT>> IRStaticDestructorRunners;
+};
+
+int runOrcTieredJIT(std::unique_ptr<Module> M, int ArgC, char* ArgV[]);
+
+} // end namespace llvm
+
+#endif
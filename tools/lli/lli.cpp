@@ -15,12 +15,14 @@
 
 #include "llvm/IR/LLVMContext.h"
 #include "OrcLazyJIT.h"
+#include "OrcTieredJIT.h"
 #include "RemoteMemoryManager.h"
 #include "RemoteTarget.h"
 #include "RemoteTargetExternal.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/ExecutionEngine/FileObjectCache.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Interpreter.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
@@ -68,7 +70,7 @@ using namespace llvm;
 
 namespace {
 
-  enum class JITKind { MCJIT, OrcMCJITReplacement, OrcLazy };
+  enum class JITKind { MCJIT, OrcMCJITReplacement, OrcLazy, OrcTiered };
 
   cl::opt<std::string>
   InputFile(cl::desc("<input bitcode>"), cl::Positional, cl::init("-"));
@@ -92,6 +94,10 @@ namespace {
                                 clEnumValN(JITKind::OrcLazy,
                                            "orc-lazy",
                                            "Orc-based lazy JIT."),
+                                clEnumValN(JITKind::OrcTiered,
+                                           "orc-tiered",
+                                           "Orc-based JIT that recompiles "
+                                           "hot functions."),
                                 clEnumValEnd));
 
   // The MCJIT supports building for a target address space separate from
@@ -173,6 +179,19 @@ namespace {
                            "(must be user writable)"),
                   cl::init(""));
 
+  cl::opt<std::string>
+  JITObjectCacheDir("jit-object-cache-dir",
+                    cl::desc("Directory in which to keep compiled objects for "
+                             "reuse by later runs, keyed by module contents "
+                             "and target"),
+                    cl::init(""));
+
+  cl::opt<unsigned>
+  JITObjectCacheSizeLimit("jit-object-cache-size-limit",
+                          cl::desc("Size limit of the -jit-object-cache-dir "
+                                   "cache in kilobytes (0 = unlimited)"),
+                          cl::init(0));
+
   cl::opt<std::string>
   FakeArgv0("fake-argv0",
             cl::desc("Override the 'argv[0]' value passed into the executing"
@@ -315,6 +334,7 @@ private:
 
 static ExecutionEngine *EE = nullptr;
 static LLIObjectCache *CacheManager = nullptr;
+static FileObjectCache *JITObjectCache = nullptr;
 
 static void do_shutdown() {
   // Cygwin-1.5 invokes DLL's dtors before atexit handler.
@@ -322,6 +342,7 @@ static void do_shutdown() {
   delete EE;
   if (CacheManager)
     delete CacheManager;
+  delete JITObjectCache;
   llvm_shutdown();
 #endif
 }
@@ -399,7 +420,11 @@ int main(int argc, char **argv, char * const *envp) {
   }
 
   if (UseJITKind == JITKind::OrcLazy)
-    return runOrcLazyJIT(std::move(Owner), argc, argv);
+    return runOrcLazyJIT(std::move(Owner), argc, argv, JITObjectCacheDir,
+                         JITObjectCacheSizeLimit * 1024ULL);
+
+  if (UseJITKind == JITKind::OrcTiered)
+    return runOrcTieredJIT(std::move(Owner), argc, argv);
 
   if (EnableCacheManager) {
     std::string CacheName("file:");
@@ -482,6 +507,11 @@ int main(int argc, char **argv, char * const *envp) {
   if (EnableCacheManager) {
     CacheManager = new LLIObjectCache(ObjectCacheDir);
     EE->setObjectCache(CacheManager);
+  } else if (!JITObjectCacheDir.empty() && EE->getTargetMachine()) {
+    JITObjectCache = new FileObjectCache(JITObjectCacheDir,
+                                         *EE->getTargetMachine(),
+                                         JITObjectCacheSizeLimit * 1024ULL);
+    EE->setObjectCache(JITObjectCache);
   }
 
   // Load any additional modules specified on the command line.
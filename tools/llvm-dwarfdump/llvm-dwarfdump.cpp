@@ -69,6 +69,17 @@ DumpType("debug-dump", cl::init(DIDT_All),
         clEnumValN(DIDT_StrOffsetsDwo, "str_offsets.dwo", ".debug_str_offsets.dwo"),
         clEnumValEnd));
 
+static cl::opt<unsigned>
+NumThreads("num-threads", cl::init(0),
+           cl::desc("Number of threads used to parse all units before "
+                    "dumping them (0 = hardware concurrency, 1 = parse "
+                    "lazily while dumping)"));
+
+static cl::opt<bool>
+StreamUnits("stream", cl::init(false),
+            cl::desc("Print the DIEs of each unit as they are decoded instead "
+                     "of extracting them first, keeping memory use bounded"));
+
 static void DumpInput(StringRef Filename) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> BuffOrErr =
       MemoryBuffer::getFileOrSTDIN(Filename);
@@ -87,12 +98,17 @@ static void DumpInput(StringRef Filename) {
   }
   ObjectFile &Obj = *ObjOrErr.get();
 
-  std::unique_ptr<DIContext> DICtx(new DWARFContextInMemory(Obj));
+  std::unique_ptr<DWARFContext> DICtx(new DWARFContextInMemory(Obj));
+  // Only the .debug_info dump walks every unit's DIEs, so only then is it
+  // worth parsing them all up front.
+  if (!StreamUnits && NumThreads != 1 &&
+      (DumpType == DIDT_All || DumpType == DIDT_Info))
+    DICtx->parseAllUnits(NumThreads);
 
   outs() << Filename
          << ":\tfile format " << Obj.getFileFormatName() << "\n\n";
   // Dump the complete DWARF structure.
-  DICtx->dump(outs(), DumpType);
+  DICtx->dump(outs(), DumpType, StreamUnits);
 }
 
 int main(int argc, char **argv) {
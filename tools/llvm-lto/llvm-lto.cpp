@@ -12,8 +12,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/Support/CommandLine.h"
@@ -22,7 +26,9 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include <list>
 
 using namespace llvm;
 
@@ -77,6 +83,25 @@ static cl::opt<bool> SetMergedModule(
     "set-merged-module", cl::init(false),
     cl::desc("Use the first input module as the merged module"));
 
+static cl::opt<unsigned> Parallelism("j", cl::Prefix, cl::init(1),
+                                     cl::desc("Number of backend threads"));
+
+static cl::opt<std::string>
+    CacheDir("cache-dir", cl::desc("Cache the generated objects in this "
+                                   "directory and reuse them when possible"),
+             cl::value_desc("directory"));
+
+static cl::opt<unsigned>
+    CacheMaxSize("cache-max-size",
+                 cl::desc("Prune the cache directory down to this size "
+                          "(0 = no limit)"),
+                 cl::value_desc("megabytes"), cl::init(0));
+
+static cl::opt<bool> ThinLTO(
+    "thinlto", cl::init(false),
+    cl::desc("Only write a combined function summary index for the input "
+             "files, for use by -function-import"));
+
 namespace {
 struct ModuleInfo {
   std::vector<bool> CanBeHidden;
@@ -116,6 +141,33 @@ getLocalLTOModule(StringRef Path, std::unique_ptr<MemoryBuffer> &Buffer,
       Buffer->getBufferStart(), Buffer->getBufferSize(), Options, Error, Path));
 }
 
+/// \brief Print the attributes of a symbol, as in "code weak hidden align=4".
+static void printSymbolAttributes(uint32_t Attrs) {
+  switch (Attrs & LTO_SYMBOL_PERMISSIONS_MASK) {
+  case LTO_SYMBOL_PERMISSIONS_CODE:   outs() << " code"; break;
+  case LTO_SYMBOL_PERMISSIONS_DATA:   outs() << " data"; break;
+  case LTO_SYMBOL_PERMISSIONS_RODATA: outs() << " rodata"; break;
+  }
+  switch (Attrs & LTO_SYMBOL_DEFINITION_MASK) {
+  case LTO_SYMBOL_DEFINITION_REGULAR:   outs() << " regular"; break;
+  case LTO_SYMBOL_DEFINITION_TENTATIVE: outs() << " tentative"; break;
+  case LTO_SYMBOL_DEFINITION_WEAK:      outs() << " weak"; break;
+  case LTO_SYMBOL_DEFINITION_UNDEFINED: outs() << " undefined"; break;
+  case LTO_SYMBOL_DEFINITION_WEAKUNDEF: outs() << " weakundef"; break;
+  }
+  switch (Attrs & LTO_SYMBOL_SCOPE_MASK) {
+  case LTO_SYMBOL_SCOPE_INTERNAL:  outs() << " internal"; break;
+  case LTO_SYMBOL_SCOPE_HIDDEN:    outs() << " hidden"; break;
+  case LTO_SYMBOL_SCOPE_PROTECTED: outs() << " protected"; break;
+  case LTO_SYMBOL_SCOPE_DEFAULT:   outs() << " default"; break;
+  case LTO_SYMBOL_SCOPE_DEFAULT_CAN_BE_HIDDEN:
+    outs() << " default_can_be_hidden";
+    break;
+  }
+  if (unsigned Align = Attrs & LTO_SYMBOL_ALIGNMENT_MASK)
+    outs() << " align=" << (1u << Align);
+}
+
 /// \brief List symbols in each IR file.
 ///
 /// The main point here is to provide lit-testable coverage for the LTOModule
@@ -136,12 +188,58 @@ static int listSymbols(StringRef Command, const TargetOptions &Options) {
 
     // List the symbols.
     outs() << Filename << ":\n";
-    for (int I = 0, E = Module->getSymbolCount(); I != E; ++I)
-      outs() << Module->getSymbolName(I) << "\n";
+    for (int I = 0, E = Module->getSymbolCount(); I != E; ++I) {
+      outs() << Module->getSymbolName(I) << ":";
+      printSymbolAttributes(Module->getSymbolAttributes(I));
+      outs() << "\n";
+    }
   }
   return 0;
 }
 
+/// \brief Create a combined index of the function summaries of the input
+/// files.
+///
+/// This is the serial step of summary-based LTO. The modules themselves are
+/// then optimized and code generated independently, each importing functions
+/// from the others as directed by the combined index.
+static int createCombinedFunctionIndex(StringRef Command) {
+  if (OutputFilename.empty()) {
+    errs() << Command << ": -thinlto requires an output file\n";
+    return 1;
+  }
+
+  LLVMContext Context;
+  FunctionInfoIndex CombinedIndex;
+  for (auto &Filename : InputFilenames) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(Filename);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      errs() << Command << ": error loading file '" << Filename
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+        getFunctionInfoIndex(BufferOrErr.get()->getMemBufferRef(), Context);
+    if (std::error_code EC = IndexOrErr.getError()) {
+      errs() << Command << ": error reading function summaries of '"
+             << Filename << "': " << EC.message() << "\n";
+      return 1;
+    }
+    CombinedIndex.mergeFrom(*IndexOrErr.get());
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(OutputFilename, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << Command << ": error opening the file '" << OutputFilename
+           << "': " << EC.message() << "\n";
+    return 1;
+  }
+  WriteFunctionSummaryToFile(CombinedIndex, OS);
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -167,6 +265,9 @@ int main(int argc, char **argv) {
   if (ListSymbolsOnly)
     return listSymbols(argv[0], Options);
 
+  if (ThinLTO)
+    return createCombinedFunctionIndex(argv[0]);
+
   unsigned BaseArg = 0;
 
   LTOCodeGenerator CodeGen;
@@ -252,7 +353,47 @@ int main(int argc, char **argv) {
   if (!attrs.empty())
     CodeGen.setAttr(attrs.c_str());
 
-  if (!OutputFilename.empty()) {
+  if (!CacheDir.empty()) {
+    CodeGen.setCacheDir(CacheDir);
+    CodeGen.setCacheMaxSize(uint64_t(CacheMaxSize) << 20);
+  }
+
+  if (Parallelism > 1) {
+    if (OutputFilename.empty()) {
+      errs() << argv[0] << ": -j requires an output filename (-o)\n";
+      return 1;
+    }
+
+    std::string ErrorInfo;
+    if (!CodeGen.optimize(DisableInline, DisableGVNLoadPRE,
+                          DisableLTOVectorization, ErrorInfo)) {
+      errs() << argv[0] << ": error optimizing the code: " << ErrorInfo << "\n";
+      return 1;
+    }
+
+    // Write partition I of the code to the output filename with I appended.
+    std::list<tool_output_file> OSs;
+    std::vector<raw_pwrite_stream *> OSPtrs;
+    for (unsigned I = 0; I != Parallelism; ++I) {
+      std::string PartFilename = OutputFilename + utostr(I);
+      std::error_code EC;
+      OSs.emplace_back(PartFilename, EC, sys::fs::F_None);
+      if (EC) {
+        errs() << argv[0] << ": error opening the file '" << PartFilename
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      OSPtrs.push_back(&OSs.back().os());
+    }
+
+    if (!CodeGen.compileOptimized(OSPtrs, ErrorInfo)) {
+      errs() << argv[0] << ": error compiling the code: " << ErrorInfo << "\n";
+      return 1;
+    }
+
+    for (tool_output_file &OS : OSs)
+      OS.keep();
+  } else if (!OutputFilename.empty()) {
     std::string ErrorInfo;
     std::unique_ptr<MemoryBuffer> Code = CodeGen.compile(
         DisableInline, DisableGVNLoadPRE, DisableLTOVectorization, ErrorInfo);
@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -20,12 +21,15 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/LineIterator.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -39,8 +43,66 @@ static void exitWithError(const Twine &Message, StringRef Whence = "") {
 
 enum ProfileKinds { instr, sample };
 
-static void mergeInstrProfile(const cl::list<std::string> &Inputs,
-                              StringRef OutputFilename) {
+namespace {
+/// The state of the merge of a contiguous shard of the inputs.  Shards are
+/// loaded in parallel, each into a writer of its own, and then merged with
+/// each other.
+struct WriterContext {
+  InstrProfWriter Writer;
+  /// The warnings of the merge.  They are printed once it is done, so that
+  /// they come out in the order of the inputs whatever the thread count.
+  std::string Warnings;
+  /// The error that stopped the merge of this shard, and the file it is about.
+  std::error_code Err;
+  std::string ErrWhence;
+};
+}
+
+/// Add the counts of \p Filename to the writer of \p WC.  Only one input is
+/// read at a time by each context, so that memory use does not grow with the
+/// number of inputs.
+static void loadInput(StringRef Filename, WriterContext *WC) {
+  auto ReaderOrErr = InstrProfReader::create(Filename);
+  if (std::error_code EC = ReaderOrErr.getError()) {
+    WC->Err = EC;
+    WC->ErrWhence = Filename;
+    return;
+  }
+
+  auto Reader = std::move(ReaderOrErr.get());
+  raw_string_ostream Warnings(WC->Warnings);
+  for (const auto &I : *Reader)
+    if (std::error_code EC =
+            WC->Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
+      Warnings << Filename << ": " << I.Name << ": " << EC.message() << "\n";
+  if (Reader->hasError()) {
+    WC->Err = Reader->getError();
+    WC->ErrWhence = Filename;
+  }
+}
+
+/// Merge the shard of \p Src, which comes right after the shard of \p Dst in
+/// the inputs, into \p Dst.
+static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
+  // The first error stops the merge.
+  if (Dst->Err)
+    return;
+  Dst->Warnings += Src->Warnings;
+  if (Src->Err) {
+    Dst->Err = Src->Err;
+    Dst->ErrWhence = Src->ErrWhence;
+    return;
+  }
+
+  raw_string_ostream Warnings(Dst->Warnings);
+  Dst->Writer.mergeRecordsFromWriter(
+      std::move(Src->Writer), [&](StringRef Name, std::error_code EC) {
+        Warnings << Name << ": " << EC.message() << "\n";
+      });
+}
+
+static void mergeInstrProfile(const std::vector<std::string> &Inputs,
+                              StringRef OutputFilename, unsigned NumThreads) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -49,24 +111,44 @@ static void mergeInstrProfile(const cl::list<std::string> &Inputs,
   if (EC)
     exitWithError(EC.message(), OutputFilename);
 
-  InstrProfWriter Writer;
-  for (const auto &Filename : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Filename);
-    if (std::error_code ec = ReaderOrErr.getError())
-      exitWithError(ec.message(), Filename);
-
-    auto Reader = std::move(ReaderOrErr.get());
-    for (const auto &I : *Reader)
-      if (std::error_code EC =
-              Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
-        errs() << Filename << ": " << I.Name << ": " << EC.message() << "\n";
-    if (Reader->hasError())
-      exitWithError(Reader->getError().message(), Filename);
+  // Split the inputs in one contiguous shard per thread.
+  if (NumThreads == 0)
+    NumThreads = ThreadPool::getDefaultConcurrency();
+  NumThreads = std::max(1u, std::min<unsigned>(NumThreads, Inputs.size()));
+  std::vector<std::unique_ptr<WriterContext>> Contexts;
+  for (unsigned I = 0; I < NumThreads; ++I)
+    Contexts.push_back(llvm::make_unique<WriterContext>());
+
+  ThreadPool Pool(NumThreads);
+  for (unsigned I = 0; I < NumThreads; ++I) {
+    size_t Begin = Inputs.size() * I / NumThreads;
+    size_t End = Inputs.size() * (I + 1) / NumThreads;
+    WriterContext *WC = Contexts[I].get();
+    Pool.async([&Inputs, Begin, End, WC]() {
+      for (size_t J = Begin; J != End && !WC->Err; ++J)
+        loadInput(Inputs[J], WC);
+    });
   }
-  Writer.write(Output);
+  Pool.wait();
+
+  // Merge the shards pairwise, in a tree, so that the merges of each level
+  // run in parallel.  Each shard is merged into the one before it, which
+  // gives the same result as a merge of the inputs in order.
+  for (unsigned Stride = 1; Stride < NumThreads; Stride *= 2) {
+    for (unsigned I = 0; I + Stride < NumThreads; I += 2 * Stride)
+      Pool.async(mergeWriterContexts, Contexts[I].get(),
+                 Contexts[I + Stride].get());
+    Pool.wait();
+  }
+
+  WriterContext &Result = *Contexts[0];
+  errs() << Result.Warnings;
+  if (Result.Err)
+    exitWithError(Result.Err.message(), Result.ErrWhence);
+  Result.Writer.write(Output);
 }
 
-static void mergeSampleProfile(const cl::list<std::string> &Inputs,
+static void mergeSampleProfile(const std::vector<std::string> &Inputs,
                                StringRef OutputFilename,
                                sampleprof::SampleProfileFormat OutputFormat) {
   using namespace sampleprof;
@@ -98,9 +180,31 @@ static void mergeSampleProfile(const cl::list<std::string> &Inputs,
   Writer->write(ProfileMap);
 }
 
+/// Add the input files listed in \p InputFilenamesFile, one per line, to
+/// \p Inputs.  Empty lines and lines starting with '#' are skipped.
+static void addInputsFromFile(StringRef InputFilenamesFile,
+                              std::vector<std::string> &Inputs) {
+  auto BufOrErr = MemoryBuffer::getFileOrSTDIN(InputFilenamesFile);
+  if (std::error_code EC = BufOrErr.getError())
+    exitWithError(EC.message(), InputFilenamesFile);
+
+  for (line_iterator I(*BufOrErr.get(), /*SkipBlanks=*/true, '#');
+       !I.is_at_eof(); ++I)
+    Inputs.push_back(I->trim());
+}
+
 static int merge_main(int argc, const char *argv[]) {
-  cl::list<std::string> Inputs(cl::Positional, cl::Required, cl::OneOrMore,
-                               cl::desc("<filenames...>"));
+  cl::list<std::string> InputFilenames(cl::Positional, cl::ZeroOrMore,
+                                       cl::desc("<filenames...>"));
+  cl::opt<std::string> InputFilenamesFile(
+      "input-files", cl::value_desc("path"),
+      cl::desc("File listing the inputs to merge, one per line"));
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(0),
+      cl::desc("Number of threads merging instrumentation profiles "
+               "(default: the number of hardware threads)"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
 
   cl::opt<std::string> OutputFilename("output", cl::value_desc("output"),
                                       cl::init("-"), cl::Required,
@@ -123,8 +227,16 @@ static int merge_main(int argc, const char *argv[]) {
 
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
+  std::vector<std::string> Inputs(InputFilenames.begin(),
+                                  InputFilenames.end());
+  if (!InputFilenamesFile.empty())
+    addInputsFromFile(InputFilenamesFile, Inputs);
+  if (Inputs.empty())
+    exitWithError("No input files specified. See " +
+                  sys::path::filename(argv[0]) + " -help");
+
   if (ProfileKind == instr)
-    mergeInstrProfile(Inputs, OutputFilename);
+    mergeInstrProfile(Inputs, OutputFilename, NumThreads);
   else
     mergeSampleProfile(Inputs, OutputFilename, OutputFormat);
 
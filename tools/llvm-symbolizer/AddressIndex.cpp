@@ -0,0 +1,475 @@
+//===-- AddressIndex.cpp --------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of the precomputed address index used by llvm-symbolizer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AddressIndex.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
+#include "llvm/Support/Dwarf.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace llvm {
+namespace symbolize {
+
+static const char IndexMagic[8] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'X'};
+static const uint32_t IndexVersion = 2;
+
+static void addRangeBounds(std::vector<uint64_t> &Breakpoints,
+                           const DWARFAddressRangesVector &Ranges) {
+  for (const auto &R : Ranges) {
+    Breakpoints.push_back(R.first);
+    Breakpoints.push_back(R.second);
+  }
+}
+
+namespace {
+/// The frames of an index entry before serialization.
+struct FrameData {
+  uint32_t FunctionName, FileName, Line, Column;
+  bool operator==(const FrameData &RHS) const {
+    return FunctionName == RHS.FunctionName && FileName == RHS.FileName &&
+           Line == RHS.Line && Column == RHS.Column;
+  }
+};
+
+/// The DIEs of the inlined chain of an address, outermost first.
+typedef SmallVector<const DWARFDebugInfoEntryMinimal *, 4> DIEChain;
+
+/// Finds the inlined chains of many addresses of one compile unit at once.
+///
+/// DWARFUnit::getInlinedChainForAddress takes the first subprogram DIE of the
+/// unit that contains the address, and then descends to the first child that
+/// contains it until there is none. Doing that for every address scans the
+/// whole unit each time. Instead, the sorted addresses are swept through the
+/// ranges of the subprograms once, and then through the ranges of the
+/// children of each DIE that some of them reached, which gives the same
+/// chains with each DIE looked at a bounded number of times.
+class InlinedChainFinder {
+  const DWARFUnit *U;
+  ArrayRef<uint64_t> Addresses;
+  std::vector<DIEChain> &Chains;
+
+  void findFirstContaining(ArrayRef<const DWARFDebugInfoEntryMinimal *> DIEs,
+                           ArrayRef<unsigned> Which, std::vector<int> &Owner);
+  void descend(const DWARFDebugInfoEntryMinimal *Parent,
+               ArrayRef<unsigned> Which);
+
+public:
+  /// Addresses must be sorted. Chains[I] receives the chain of Addresses[I].
+  InlinedChainFinder(const DWARFUnit *U, ArrayRef<uint64_t> Addresses,
+                     std::vector<DIEChain> &Chains)
+      : U(U), Addresses(Addresses), Chains(Chains) {}
+
+  void run(DWARFUnit &Unit);
+};
+
+/// Deduplicates the strings referenced by the index.
+class StringTable {
+  StringMap<uint32_t> Offsets;
+  std::string Data;
+
+public:
+  uint32_t add(StringRef S) {
+    auto Res = Offsets.insert(std::make_pair(S, (uint32_t)Data.size()));
+    if (Res.second) {
+      Data.append(S.begin(), S.end());
+      Data.push_back('\0');
+    }
+    return Res.first->second;
+  }
+  const std::string &data() const { return Data; }
+};
+} // end anonymous namespace
+
+/// Set Owner[I] to the position in DIEs of the first DIE whose address ranges
+/// contain Addresses[Which[I]], or to -1 if there is none. Which must be
+/// sorted by address.
+void InlinedChainFinder::findFirstContaining(
+    ArrayRef<const DWARFDebugInfoEntryMinimal *> DIEs, ArrayRef<unsigned> Which,
+    std::vector<int> &Owner) {
+  // The ranges of the DIEs, as (start, (end, position of the DIE)).
+  std::vector<std::pair<uint64_t, std::pair<uint64_t, unsigned>>> Ranges;
+  for (unsigned I = 0, E = DIEs.size(); I != E; ++I)
+    for (const auto &R : DIEs[I]->getAddressRanges(U))
+      if (R.first < R.second)
+        Ranges.push_back(std::make_pair(R.first, std::make_pair(R.second, I)));
+  std::sort(Ranges.begin(), Ranges.end());
+
+  // The ranges that started at or before the current address, first DIE on
+  // top. Ranges that have ended are only dropped once they reach the top,
+  // which is fine as the addresses only grow.
+  typedef std::pair<unsigned, uint64_t> ActiveRange;
+  std::priority_queue<ActiveRange, std::vector<ActiveRange>,
+                      std::greater<ActiveRange>> Active;
+  Owner.assign(Which.size(), -1);
+  size_t Next = 0;
+  for (unsigned I = 0, E = Which.size(); I != E; ++I) {
+    uint64_t Address = Addresses[Which[I]];
+    for (; Next != Ranges.size() && Ranges[Next].first <= Address; ++Next)
+      Active.push(
+          std::make_pair(Ranges[Next].second.second, Ranges[Next].second.first));
+    while (!Active.empty() && Active.top().second <= Address)
+      Active.pop();
+    if (!Active.empty())
+      Owner[I] = Active.top().first;
+  }
+}
+
+/// Extend the chains of the addresses Which, which Parent contains, with the
+/// DIEs below Parent.
+void InlinedChainFinder::descend(const DWARFDebugInfoEntryMinimal *Parent,
+                                 ArrayRef<unsigned> Which) {
+  SmallVector<const DWARFDebugInfoEntryMinimal *, 8> Children;
+  for (const DWARFDebugInfoEntryMinimal *Child = Parent->getFirstChild(); Child;
+       Child = Child->getSibling())
+    Children.push_back(Child);
+  if (Children.empty())
+    return;
+
+  std::vector<int> Owner;
+  findFirstContaining(Children, Which, Owner);
+  std::vector<std::vector<unsigned>> ByChild(Children.size());
+  for (unsigned I = 0, E = Which.size(); I != E; ++I)
+    if (Owner[I] != -1)
+      ByChild[Owner[I]].push_back(Which[I]);
+
+  for (unsigned C = 0, E = Children.size(); C != E; ++C) {
+    if (ByChild[C].empty())
+      continue;
+    // Only subroutines are part of the chain; lexical blocks are just
+    // descended into.
+    if (Children[C]->isSubroutineDIE())
+      for (unsigned A : ByChild[C])
+        Chains[A].push_back(Children[C]);
+    descend(Children[C], ByChild[C]);
+  }
+}
+
+void InlinedChainFinder::run(DWARFUnit &Unit) {
+  std::vector<const DWARFDebugInfoEntryMinimal *> Subprograms;
+  for (unsigned I = 0, E = Unit.getNumDIEs(); I != E; ++I) {
+    const DWARFDebugInfoEntryMinimal *DIE = Unit.getDIEAtIndex(I);
+    if (DIE->isSubprogramDIE())
+      Subprograms.push_back(DIE);
+  }
+
+  std::vector<unsigned> All(Addresses.size());
+  for (unsigned I = 0, E = All.size(); I != E; ++I)
+    All[I] = I;
+  std::vector<int> Owner;
+  findFirstContaining(Subprograms, All, Owner);
+  std::vector<std::vector<unsigned>> BySubprogram(Subprograms.size());
+  for (unsigned I = 0, E = All.size(); I != E; ++I)
+    if (Owner[I] != -1)
+      BySubprogram[Owner[I]].push_back(I);
+
+  for (unsigned S = 0, E = Subprograms.size(); S != E; ++S) {
+    if (BySubprogram[S].empty())
+      continue;
+    for (unsigned A : BySubprogram[S])
+      Chains[A].push_back(Subprograms[S]);
+    descend(Subprograms[S], BySubprogram[S]);
+  }
+}
+
+std::unique_ptr<AddressIndex>
+AddressIndex::build(DWARFContext &DICtx, DINameKind Kind, SourceStamp Stamp) {
+  // Collect every address at which the answer to an inlining query may
+  // change: the bounds of compile unit address ranges, of the DIEs that make
+  // up inlined chains, and of line table rows. Between two consecutive
+  // breakpoints DWARFContext::getInliningInfoForAddress returns the same
+  // chain, so it only has to be asked a bounded number of times for each.
+  std::vector<uint64_t> Breakpoints;
+
+  // Every unit is about to be walked, so parse them all concurrently first.
+  DICtx.parseAllUnits();
+
+  DataExtractor ArangesData(DICtx.getARangeSection(), DICtx.isLittleEndian(),
+                            0);
+  uint32_t ArangesOffset = 0;
+  DWARFDebugArangeSet Set;
+  while (Set.extract(ArangesData, &ArangesOffset)) {
+    for (const auto &Desc : Set.descriptors()) {
+      Breakpoints.push_back(Desc.Address);
+      Breakpoints.push_back(Desc.getEndAddress());
+    }
+  }
+
+  for (const auto &CU : DICtx.compile_units()) {
+    // Inlined chains of split DWARF units live in .dwo files, which we don't
+    // walk here; fall back to querying the context directly.
+    if (CU->getDWOId() != -1ULL)
+      return nullptr;
+
+    DWARFAddressRangesVector CURanges;
+    CU->collectAddressRanges(CURanges);
+    addRangeBounds(Breakpoints, CURanges);
+
+    for (unsigned I = 0, E = CU->getNumDIEs(); I != E; ++I) {
+      const DWARFDebugInfoEntryMinimal *DIE = CU->getDIEAtIndex(I);
+      switch (DIE->getTag()) {
+      case dwarf::DW_TAG_subprogram:
+      case dwarf::DW_TAG_inlined_subroutine:
+      case dwarf::DW_TAG_lexical_block:
+        addRangeBounds(Breakpoints, DIE->getAddressRanges(CU.get()));
+        break;
+      default:
+        break;
+      }
+    }
+
+    if (const DWARFDebugLine::LineTable *LineTable =
+            DICtx.getLineTableForUnit(CU.get()))
+      for (const DWARFDebugLine::Row &Row : LineTable->Rows)
+        Breakpoints.push_back(Row.Address);
+  }
+
+  std::sort(Breakpoints.begin(), Breakpoints.end());
+  Breakpoints.erase(std::unique(Breakpoints.begin(), Breakpoints.end()),
+                    Breakpoints.end());
+
+  // A line table lookup for exactly the address of several rows returns the
+  // first of them, while any address after it returns the last one. So the
+  // answer is constant on [B, B] and on (B, Next), and both are sampled.
+  std::vector<uint64_t> Samples;
+  for (size_t I = 0, E = Breakpoints.size(); I != E; ++I) {
+    uint64_t B = Breakpoints[I];
+    Samples.push_back(B);
+    if (B + 1 != 0 && (I + 1 == E || B + 1 < Breakpoints[I + 1]))
+      Samples.push_back(B + 1);
+  }
+
+  // Find the inlined chains of the samples of each compile unit in one go.
+  // The samples are assigned to units the way getInliningInfoForAddress does.
+  DenseMap<DWARFCompileUnit *, std::vector<unsigned>> SamplesByCU;
+  std::vector<DWARFCompileUnit *> SampleCUs(Samples.size());
+  for (unsigned I = 0, E = Samples.size(); I != E; ++I)
+    if ((SampleCUs[I] = DICtx.getCompileUnitForAddress(Samples[I])))
+      SamplesByCU[SampleCUs[I]].push_back(I);
+  std::vector<DIEChain> Chains(Samples.size());
+  for (auto &CUSamples : SamplesByCU) {
+    std::vector<uint64_t> Addresses;
+    for (unsigned I : CUSamples.second)
+      Addresses.push_back(Samples[I]);
+    std::vector<DIEChain> CUChains(Addresses.size());
+    InlinedChainFinder(CUSamples.first, Addresses, CUChains)
+        .run(*CUSamples.first);
+    for (unsigned I = 0, E = Addresses.size(); I != E; ++I)
+      Chains[CUSamples.second[I]] = std::move(CUChains[I]);
+  }
+
+  DILineInfoSpecifier::FileLineInfoKind FLIKind =
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath;
+  StringTable Strings;
+  std::vector<std::pair<uint64_t, std::pair<uint32_t, uint32_t>>> Entries;
+  std::vector<FrameData> Frames;
+  for (unsigned S = 0, SE = Samples.size(); S != SE; ++S) {
+    uint64_t Address = Samples[S];
+    DWARFCompileUnit *CU = SampleCUs[S];
+    const DIEChain &Chain = Chains[S];
+
+    // Make the frames of the chain as getInliningInfoForAddress does.
+    DIInliningInfo Info;
+    const DWARFDebugLine::LineTable *LineTable =
+        CU ? DICtx.getLineTableForUnit(CU) : nullptr;
+    if (CU && Chain.empty()) {
+      DILineInfo Frame;
+      if (LineTable &&
+          LineTable->getFileLineInfoForAddress(
+              Address, CU->getCompilationDir(), FLIKind, Frame))
+        Info.addFrame(Frame);
+    }
+    uint32_t CallFile = 0, CallLine = 0, CallColumn = 0;
+    for (unsigned I = 0, N = Chain.size(); I != N; ++I) {
+      const DWARFDebugInfoEntryMinimal *FunctionDIE = Chain[N - I - 1];
+      DILineInfo Frame;
+      if (const char *Name = FunctionDIE->getSubroutineName(CU, Kind))
+        Frame.FunctionName = Name;
+      if (I == 0) {
+        if (LineTable)
+          LineTable->getFileLineInfoForAddress(
+              Address, CU->getCompilationDir(), FLIKind, Frame);
+      } else {
+        if (LineTable)
+          LineTable->getFileNameByIndex(CallFile, CU->getCompilationDir(),
+                                        FLIKind, Frame.FileName);
+        Frame.Line = CallLine;
+        Frame.Column = CallColumn;
+      }
+      if (I + 1 < N)
+        FunctionDIE->getCallerFrame(CU, CallFile, CallLine, CallColumn);
+      Info.addFrame(Frame);
+    }
+
+    uint32_t FirstFrame = Frames.size();
+    for (uint32_t I = 0, N = Info.getNumberOfFrames(); I != N; ++I) {
+      DILineInfo LineInfo = Info.getFrame(I);
+      FrameData FD = {Strings.add(LineInfo.FunctionName),
+                      Strings.add(LineInfo.FileName), LineInfo.Line,
+                      LineInfo.Column};
+      Frames.push_back(FD);
+    }
+    uint32_t NumFrames = Frames.size() - FirstFrame;
+
+    // Merge with the previous range if the chain didn't change.
+    if (!Entries.empty()) {
+      uint32_t PrevFirst = Entries.back().second.first;
+      uint32_t PrevNum = Entries.back().second.second;
+      if (PrevNum == NumFrames &&
+          std::equal(Frames.begin() + PrevFirst,
+                     Frames.begin() + PrevFirst + PrevNum,
+                     Frames.begin() + FirstFrame)) {
+        Frames.resize(FirstFrame);
+        continue;
+      }
+    }
+    Entries.push_back(
+        std::make_pair(Address, std::make_pair(FirstFrame, NumFrames)));
+  }
+
+  std::string Data;
+  {
+    raw_string_ostream OS(Data);
+    support::endian::Writer<support::little> W(OS);
+    OS.write(IndexMagic, sizeof(IndexMagic));
+    W.write<uint32_t>(IndexVersion);
+    W.write<uint32_t>(static_cast<uint32_t>(Kind));
+    W.write<uint64_t>(Stamp.Size);
+    W.write<uint64_t>(Stamp.Hash);
+    W.write<uint32_t>(Entries.size());
+    W.write<uint32_t>(Frames.size());
+    W.write<uint32_t>(Strings.data().size());
+    for (const auto &E : Entries) {
+      W.write<uint64_t>(E.first);
+      W.write<uint32_t>(E.second.first);
+      W.write<uint32_t>(E.second.second);
+    }
+    for (const FrameData &FD : Frames) {
+      W.write<uint32_t>(FD.FunctionName);
+      W.write<uint32_t>(FD.FileName);
+      W.write<uint32_t>(FD.Line);
+      W.write<uint32_t>(FD.Column);
+    }
+    OS << Strings.data();
+  }
+  return std::unique_ptr<AddressIndex>(new AddressIndex(
+      MemoryBuffer::getMemBufferCopy(Data, "<address index>")));
+}
+
+std::unique_ptr<AddressIndex>
+AddressIndex::load(StringRef Path, DINameKind Kind, SourceStamp Stamp) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (!BufOrErr || !isValid(**BufOrErr))
+    return nullptr;
+  std::unique_ptr<AddressIndex> Index(new AddressIndex(std::move(*BufOrErr)));
+  if (Index->Hdr->NameKind != static_cast<uint32_t>(Kind) ||
+      Index->Hdr->SourceSize != Stamp.Size ||
+      Index->Hdr->SourceHash != Stamp.Hash)
+    return nullptr;
+  return Index;
+}
+
+bool AddressIndex::isValid(const MemoryBuffer &Buffer) {
+  uint64_t Size = Buffer.getBufferSize();
+  if (Size < sizeof(Header))
+    return false;
+  const Header *H = reinterpret_cast<const Header *>(Buffer.getBufferStart());
+  if (memcmp(H->Magic, IndexMagic, sizeof(IndexMagic)) != 0 ||
+      H->Version != IndexVersion)
+    return false;
+  uint64_t Expected = sizeof(Header) +
+                      uint64_t(H->NumEntries) * sizeof(Entry) +
+                      uint64_t(H->NumFrames) * sizeof(Frame) +
+                      H->StringTableSize;
+  if (Size != Expected)
+    return false;
+  // The string table must be terminated so that getString() can't overrun.
+  return H->StringTableSize == 0 || Buffer.getBufferEnd()[-1] == '\0';
+}
+
+AddressIndex::AddressIndex(std::unique_ptr<MemoryBuffer> Buffer)
+    : Buffer(std::move(Buffer)) {
+  const char *Start = this->Buffer->getBufferStart();
+  Hdr = reinterpret_cast<const Header *>(Start);
+  Entries = reinterpret_cast<const Entry *>(Start + sizeof(Header));
+  Frames = reinterpret_cast<const Frame *>(Entries + Hdr->NumEntries);
+  Strings = reinterpret_cast<const char *>(Frames + Hdr->NumFrames);
+}
+
+std::error_code AddressIndex::save(StringRef Path) const {
+  // Write to a temporary file next to the destination and rename it into
+  // place, so a concurrent reader never maps a partially written index.
+  int FD;
+  SmallString<128> TempPath;
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(Path + ".tmp-%%%%%%", FD, TempPath))
+    return EC;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Buffer->getBuffer();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return make_error_code(errc::io_error);
+    }
+  }
+  if (std::error_code EC = sys::fs::rename(TempPath, Path)) {
+    sys::fs::remove(TempPath);
+    return EC;
+  }
+  return std::error_code();
+}
+
+StringRef AddressIndex::getString(uint32_t Offset) const {
+  if (Offset >= Hdr->StringTableSize)
+    return StringRef();
+  return StringRef(Strings + Offset);
+}
+
+DIInliningInfo AddressIndex::lookup(uint64_t Address) const {
+  DIInliningInfo Result;
+  const Entry *Begin = Entries, *End = Entries + Hdr->NumEntries;
+  const Entry *I = std::upper_bound(
+      Begin, End, Address,
+      [](uint64_t A, const Entry &E) { return A < E.Address; });
+  if (I == Begin)
+    return Result;
+  --I;
+  uint32_t FirstFrame = I->FirstFrame, NumFrames = I->NumFrames;
+  if (uint64_t(FirstFrame) + NumFrames > Hdr->NumFrames)
+    return Result;
+  for (uint32_t F = FirstFrame, FE = FirstFrame + NumFrames; F != FE; ++F) {
+    DILineInfo LineInfo;
+    LineInfo.FunctionName = getString(Frames[F].FunctionName);
+    LineInfo.FileName = getString(Frames[F].FileName);
+    LineInfo.Line = Frames[F].Line;
+    LineInfo.Column = Frames[F].Column;
+    Result.addFrame(LineInfo);
+  }
+  return Result;
+}
+
+} // namespace symbolize
+} // namespace llvm
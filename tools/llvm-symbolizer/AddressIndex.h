@@ -0,0 +1,105 @@
+//===-- AddressIndex.h ------------------------------------------ C++ -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A precomputed, sorted address-to-inlining-chain index for a single binary.
+// Once built, queries are answered with a binary search and no DWARF parsing.
+// The index is stored in a flat, little-endian format, so the same buffer can
+// be written to disk and memory-mapped again by a later process.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_TOOLS_LLVM_SYMBOLIZER_ADDRESSINDEX_H
+#define LLVM_TOOLS_LLVM_SYMBOLIZER_ADDRESSINDEX_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <system_error>
+
+namespace llvm {
+
+class DWARFContext;
+
+namespace symbolize {
+
+class AddressIndex {
+public:
+  /// \brief Identifies the file the index was built from, so that a cached
+  /// index can be discarded once that file changes.
+  struct SourceStamp {
+    uint64_t Size;
+    // The low 64 bits of an MD5 of whatever identifies the contents of the
+    // file, such as its build ID.
+    uint64_t Hash;
+    SourceStamp(uint64_t Size = 0, uint64_t Hash = 0)
+        : Size(Size), Hash(Hash) {}
+  };
+
+  /// \brief Build an index answering the same inlining queries as
+  /// \p DICtx would, with function names of kind \p Kind. Returns null if
+  /// the debug info cannot be indexed exactly (e.g. split DWARF).
+  static std::unique_ptr<AddressIndex>
+  build(DWARFContext &DICtx, DINameKind Kind, SourceStamp Stamp);
+
+  /// \brief Map a previously saved index. Returns null if the file does not
+  /// exist, is malformed, or was built for a different name kind or source.
+  static std::unique_ptr<AddressIndex> load(StringRef Path, DINameKind Kind,
+                                            SourceStamp Stamp);
+
+  /// \brief Write the index to \p Path, atomically replacing any existing
+  /// file.
+  std::error_code save(StringRef Path) const;
+
+  /// \brief Return the inlining chain for \p Address, innermost frame first.
+  /// The result is empty if no debug info covers the address.
+  DIInliningInfo lookup(uint64_t Address) const;
+
+  /// \brief Number of address ranges in the index.
+  uint32_t getNumEntries() const { return Hdr->NumEntries; }
+
+private:
+  struct Header {
+    char Magic[8];
+    support::ulittle32_t Version;
+    support::ulittle32_t NameKind;
+    support::ulittle64_t SourceSize;
+    support::ulittle64_t SourceHash;
+    support::ulittle32_t NumEntries;
+    support::ulittle32_t NumFrames;
+    support::ulittle32_t StringTableSize;
+  };
+  /// An address range [Address, next entry's Address) and its frames.
+  struct Entry {
+    support::ulittle64_t Address;
+    support::ulittle32_t FirstFrame;
+    support::ulittle32_t NumFrames;
+  };
+  struct Frame {
+    support::ulittle32_t FunctionName; // Offset into the string table.
+    support::ulittle32_t FileName;     // Offset into the string table.
+    support::ulittle32_t Line;
+    support::ulittle32_t Column;
+  };
+
+  explicit AddressIndex(std::unique_ptr<MemoryBuffer> Buffer);
+  static bool isValid(const MemoryBuffer &Buffer);
+  StringRef getString(uint32_t Offset) const;
+
+  std::unique_ptr<MemoryBuffer> Buffer;
+  const Header *Hdr;
+  const Entry *Entries;
+  const Frame *Frames;
+  const char *Strings;
+};
+
+} // namespace symbolize
+} // namespace llvm
+
+#endif
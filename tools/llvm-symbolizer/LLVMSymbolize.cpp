@@ -22,8 +22,10 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include <sstream>
@@ -51,8 +53,9 @@ getDILineInfoSpecifier(const LLVMSymbolizer::Options &Opts) {
       Opts.PrintFunctions);
 }
 
-ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
-    : Module(Obj), DebugInfoContext(DICtx) {
+ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx,
+                       std::unique_ptr<AddressIndex> Index)
+    : Module(Obj), DebugInfoContext(DICtx), Index(std::move(Index)) {
   std::unique_ptr<DataExtractor> OpdExtractor;
   uint64_t OpdAddress = 0;
   // Find the .opd (function descriptor) section if any, for big-endian
@@ -154,7 +157,13 @@ bool ModuleInfo::getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
 DILineInfo ModuleInfo::symbolizeCode(
     uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const {
   DILineInfo LineInfo;
-  if (DebugInfoContext) {
+  if (Index) {
+    // The innermost frame of the inlined chain is exactly what
+    // getLineInfoForAddress would return.
+    DIInliningInfo InlinedContext = Index->lookup(ModuleOffset);
+    if (InlinedContext.getNumberOfFrames() > 0)
+      LineInfo = InlinedContext.getFrame(0);
+  } else if (DebugInfoContext) {
     LineInfo = DebugInfoContext->getLineInfoForAddress(
         ModuleOffset, getDILineInfoSpecifier(Opts));
   }
@@ -174,7 +183,9 @@ DIInliningInfo ModuleInfo::symbolizeInlinedCode(
     uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const {
   DIInliningInfo InlinedContext;
 
-  if (DebugInfoContext) {
+  if (Index) {
+    InlinedContext = Index->lookup(ModuleOffset);
+  } else if (DebugInfoContext) {
     InlinedContext = DebugInfoContext->getInliningInfoForAddress(
         ModuleOffset, getDILineInfoSpecifier(Opts));
   }
@@ -483,14 +494,140 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
                                Opts.RelativeAddresses);
     }
   }
-  if (!Context)
+  std::unique_ptr<AddressIndex> Index;
+  if (!Context && Opts.UseAddressIndex) {
+    std::unique_ptr<DIContext> DWARFCtx;
+    Index = getOrCreateAddressIndex(BinaryName, ArchName, Objects.second,
+                                    DWARFCtx);
+    // Once the index is built, the parsed DWARF is no longer needed.
+    if (!Index)
+      Context = DWARFCtx.release();
+  }
+  if (!Context && !Index)
     Context = new DWARFContextInMemory(*Objects.second);
-  assert(Context);
-  ModuleInfo *Info = new ModuleInfo(Objects.first, Context);
+  assert(Context || Index);
+  ModuleInfo *Info = new ModuleInfo(Objects.first, Context, std::move(Index));
   Modules.insert(make_pair(ModuleName, Info));
   return Info;
 }
 
+/// \brief Return the GNU build ID of the ELF file \p Obj, or an empty
+/// array if it has none.
+static ArrayRef<uint8_t> getELFBuildID(const ObjectFile *Obj) {
+  const uint32_t NT_GNU_BUILD_ID = 3;
+  for (const SectionRef &Section : Obj->sections()) {
+    StringRef Name;
+    StringRef Data;
+    if (Section.getName(Name) || !Name.startswith(".note") ||
+        Section.getContents(Data))
+      continue;
+    // Each note is a name size, a descriptor size and a type, followed by
+    // the name and the descriptor, both padded to 4 bytes.
+    DataExtractor DE(Data, Obj->isLittleEndian(), 0);
+    uint32_t Offset = 0;
+    while (DE.isValidOffsetForDataOfSize(Offset, 12)) {
+      uint32_t NameSize = DE.getU32(&Offset);
+      uint32_t DescSize = DE.getU32(&Offset);
+      uint32_t Type = DE.getU32(&Offset);
+      uint32_t DescOffset = Offset + RoundUpToAlignment(NameSize, 4);
+      if (!DE.isValidOffsetForDataOfSize(DescOffset, DescSize))
+        break;
+      if (Type == NT_GNU_BUILD_ID &&
+          Data.substr(Offset, NameSize) == StringRef("GNU", 4))
+        return ArrayRef<uint8_t>(
+            reinterpret_cast<const uint8_t *>(Data.data() + DescOffset),
+            DescSize);
+      Offset = DescOffset + RoundUpToAlignment(DescSize, 4);
+    }
+  }
+  return ArrayRef<uint8_t>();
+}
+
+/// \brief Compute the stamp of the cached address index of \p Obj without
+/// reading all of it when possible. The build ID of an ELF file and the
+/// UUID of a Mach-O file identify their contents. Other files are identified
+/// by their modification time and inode, and only the contents of the
+/// objects that are not a file of their own, such as archive members, are
+/// hashed.
+static AddressIndex::SourceStamp getSourceStamp(const ObjectFile *Obj) {
+  StringRef Contents = Obj->getData();
+  ArrayRef<uint8_t> ID;
+  if (Obj->isELF())
+    ID = getELFBuildID(Obj);
+  else if (auto *MachO = dyn_cast<MachOObjectFile>(Obj))
+    ID = MachO->getUuid();
+
+  MD5 Hash;
+  sys::fs::file_status Status;
+  if (!ID.empty()) {
+    Hash.update("id:");
+    Hash.update(ID);
+  } else if (!sys::fs::status(Obj->getFileName(), Status) &&
+             Status.getSize() == Contents.size()) {
+    uint8_t Identity[24];
+    sys::fs::UniqueID UID = Status.getUniqueID();
+    support::endian::write64le(Identity, UID.getDevice());
+    support::endian::write64le(Identity + 8, UID.getFile());
+    support::endian::write64le(
+        Identity + 16, Status.getLastModificationTime().toEpochTime());
+    Hash.update("file:");
+    Hash.update(Identity);
+  } else {
+    Hash.update("contents:");
+    Hash.update(Contents);
+  }
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return AddressIndex::SourceStamp(
+      Contents.size(),
+      support::endian::read<uint64_t, support::little, 1>(Result));
+}
+
+std::unique_ptr<AddressIndex>
+LLVMSymbolizer::getOrCreateAddressIndex(const std::string &BinaryName,
+                                        const std::string &ArchName,
+                                        ObjectFile *DbgObj,
+                                        std::unique_ptr<DIContext> &Context) {
+  // The cache file is keyed by the binary path and architecture, and stamped
+  // with the identity of the object holding the debug info.
+  std::string CachePath;
+  AddressIndex::SourceStamp Stamp;
+  if (!Opts.AddressIndexCacheDir.empty()) {
+    Stamp = getSourceStamp(DbgObj);
+
+    MD5 Hash;
+    Hash.update(BinaryName);
+    Hash.update(":");
+    Hash.update(ArchName);
+    MD5::MD5Result Result;
+    Hash.final(Result);
+    SmallString<32> HashStr;
+    MD5::stringifyResult(Result, HashStr);
+    SmallString<128> Path(Opts.AddressIndexCacheDir);
+    sys::path::append(Path, sys::path::filename(BinaryName) + "-" + HashStr +
+                                ".symidx");
+    CachePath = Path.str();
+    if (std::unique_ptr<AddressIndex> Index =
+            AddressIndex::load(CachePath, Opts.PrintFunctions, Stamp))
+      return Index;
+  }
+
+  auto *DWARFCtx = new DWARFContextInMemory(*DbgObj);
+  Context.reset(DWARFCtx);
+  std::unique_ptr<AddressIndex> Index =
+      AddressIndex::build(*DWARFCtx, Opts.PrintFunctions, Stamp);
+  if (Index && !CachePath.empty()) {
+    // A failure to write the cache only costs us a rebuild next time.
+    std::error_code EC = sys::fs::create_directories(Opts.AddressIndexCacheDir);
+    if (!EC)
+      EC = Index->save(CachePath);
+    if (EC)
+      errs() << "LLVMSymbolizer: error writing address index cache: "
+             << EC.message() << ".\n";
+  }
+  return Index;
+}
+
 std::string LLVMSymbolizer::printDILineInfo(DILineInfo LineInfo) const {
   // By default, DILineInfo contains "<invalid>" for function/filename it
   // cannot fetch. We replace it to "??" to make our output closer to addr2line.
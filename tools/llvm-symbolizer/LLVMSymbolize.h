@@ -13,6 +13,7 @@
 #ifndef LLVM_TOOLS_LLVM_SYMBOLIZER_LLVMSYMBOLIZE_H
 #define LLVM_TOOLS_LLVM_SYMBOLIZER_LLVMSYMBOLIZE_H
 
+#include "AddressIndex.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/Object/MachOUniversal.h"
@@ -40,15 +41,20 @@ public:
     bool PrintInlining : 1;
     bool Demangle : 1;
     bool RelativeAddresses : 1;
+    bool UseAddressIndex : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// If non-empty, address indices are saved to and loaded from this
+    /// directory. Only used together with UseAddressIndex.
+    std::string AddressIndexCacheDir;
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool PrintInlining = true,
             bool Demangle = true, bool RelativeAddresses = false,
             std::string DefaultArch = "")
         : PrintFunctions(PrintFunctions), UseSymbolTable(UseSymbolTable),
           PrintInlining(PrintInlining), Demangle(Demangle),
-          RelativeAddresses(RelativeAddresses), DefaultArch(DefaultArch) {}
+          RelativeAddresses(RelativeAddresses), UseAddressIndex(false),
+          DefaultArch(DefaultArch) {}
   };
 
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
@@ -78,6 +84,14 @@ private:
   /// universal binary (or the binary itself if it is an object file).
   ObjectFile *getObjectFileFromBinary(Binary *Bin, const std::string &ArchName);
 
+  /// \brief Returns an address index for the debug info in \p DbgObj, loading
+  /// it from the cache directory if possible. \p Context is created on
+  /// demand if the index has to be built and is left null otherwise.
+  std::unique_ptr<AddressIndex>
+  getOrCreateAddressIndex(const std::string &BinaryName,
+                          const std::string &ArchName, ObjectFile *DbgObj,
+                          std::unique_ptr<DIContext> &Context);
+
   std::string printDILineInfo(DILineInfo LineInfo) const;
 
   // Owns all the parsed binaries and object files.
@@ -104,7 +118,8 @@ private:
 
 class ModuleInfo {
 public:
-  ModuleInfo(ObjectFile *Obj, DIContext *DICtx);
+  ModuleInfo(ObjectFile *Obj, DIContext *DICtx,
+             std::unique_ptr<AddressIndex> Index = nullptr);
 
   DILineInfo symbolizeCode(uint64_t ModuleOffset,
                            const LLVMSymbolizer::Options &Opts) const;
@@ -124,6 +139,8 @@ private:
                  uint64_t OpdAddress = 0);
   ObjectFile *Module;
   std::unique_ptr<DIContext> DebugInfoContext;
+  // If present, answers code queries instead of DebugInfoContext.
+  std::unique_ptr<AddressIndex> Index;
 
   struct SymbolDesc {
     uint64_t Addr;
@@ -74,6 +74,16 @@ ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
                     "object files"));
 
+static cl::opt<bool>
+ClAddressIndex("address-index", cl::init(false),
+               cl::desc("Build a sorted address index for each module on "
+                        "first use and answer code queries from it"));
+
+static cl::opt<std::string>
+ClAddressIndexCacheDir("address-index-cache-dir", cl::init(""),
+                       cl::desc("Directory to save address indices to and "
+                                "reuse them from (implies -address-index)"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -143,6 +153,8 @@ int main(int argc, char **argv) {
                 "\" (must have the '.dSYM' extension).\n";
     }
   }
+  Opts.UseAddressIndex = ClAddressIndex || !ClAddressIndexCacheDir.empty();
+  Opts.AddressIndexCacheDir = ClAddressIndexCacheDir;
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
@@ -84,6 +84,7 @@ struct LibLTOCodeGenerator : LTOCodeGenerator {
       : LTOCodeGenerator(std::move(Context)) {}
 
   std::unique_ptr<MemoryBuffer> NativeObjectFile;
+  std::vector<const char *> NativeObjectFileNames;
 };
 
 }
@@ -344,6 +345,21 @@ const void *lto_codegen_compile_optimized(lto_code_gen_t cg, size_t *length) {
   return CG->NativeObjectFile->getBufferStart();
 }
 
+void lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned parallelism) {
+  unwrap(cg)->setParallelism(parallelism);
+}
+
+unsigned lto_codegen_compile_optimized_to_files(lto_code_gen_t cg,
+                                                const char ***names) {
+  maybeParseOptions(cg);
+  LibLTOCodeGenerator *CG = unwrap(cg);
+  if (!CG->compileOptimizedToFiles(CG->NativeObjectFileNames,
+                                   sLastErrorString))
+    return 0;
+  *names = CG->NativeObjectFileNames.data();
+  return CG->NativeObjectFileNames.size();
+}
+
 bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
   maybeParseOptions(cg);
   return !unwrap(cg)->compile_to_file(
@@ -0,0 +1,62 @@
+//===- llvm/unittest/ADT/StatisticTest.cpp - Statistic tests --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "unittest"
+STATISTIC(Counter, "Counts things");
+STATISTIC(Counter2, "Counts other things");
+
+namespace {
+
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+TEST(StatisticTest, CollectAndReset) {
+  EnableStatistics();
+  ResetStatistics();
+
+  Counter += 3;
+  ++Counter2;
+
+  std::vector<const Statistic *> Stats = GetStatistics();
+  ASSERT_EQ(2u, Stats.size());
+  EXPECT_STREQ("Counts other things", Stats[0]->getDesc());
+  EXPECT_EQ(1u, Stats[0]->getValue());
+  EXPECT_STREQ("Counts things", Stats[1]->getDesc());
+  EXPECT_EQ(3u, Stats[1]->getValue());
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  PrintStatisticsJSON(OS);
+  EXPECT_EQ("{\"stats\":["
+            "{\"name\":\"unittest\",\"desc\":\"Counts other things\","
+            "\"value\":1},"
+            "{\"name\":\"unittest\",\"desc\":\"Counts things\",\"value\":3}"
+            "]}\n",
+            OS.str());
+
+  // Resetting zeroes the statistics and forgets them until they are bumped
+  // again.
+  ResetStatistics();
+  EXPECT_TRUE(GetStatistics().empty());
+  EXPECT_EQ(0u, Counter);
+
+  ++Counter;
+  Stats = GetStatistics();
+  ASSERT_EQ(1u, Stats.size());
+  EXPECT_EQ(1u, Stats[0]->getValue());
+
+  ResetStatistics();
+}
+#endif
+
+} // end anonymous namespace
@@ -8,7 +8,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/ExecutionEngine/SlabMemoryManager.h"
 #include "gtest/gtest.h"
+#include <vector>
+
+#if LLVM_ENABLE_THREADS
+#include <thread>
+#endif
 
 using namespace llvm;
 
@@ -166,5 +172,118 @@ TEST(MCJITMemoryManagerTest, ManyVariedAllocations) {
   }
 }
 
-} // Namespace
+TEST(MCJITMemoryManagerTest, SlabBasicAllocations) {
+  auto Pool = std::make_shared<SlabMemoryManager::SlabPool>();
+  std::unique_ptr<SlabMemoryManager> MemMgr(new SlabMemoryManager(Pool));
+
+  uint8_t *code1 = MemMgr->allocateCodeSection(256, 0, 1, "");
+  uint8_t *data1 = MemMgr->allocateDataSection(256, 0, 2, "", true);
+  uint8_t *code2 = MemMgr->allocateCodeSection(256, 0, 3, "");
+  uint8_t *data2 = MemMgr->allocateDataSection(256, 0, 4, "", false);
+
+  EXPECT_NE((uint8_t*)nullptr, code1);
+  EXPECT_NE((uint8_t*)nullptr, code2);
+  EXPECT_NE((uint8_t*)nullptr, data1);
+  EXPECT_NE((uint8_t*)nullptr, data2);
+
+  // Initialize the data
+  for (unsigned i = 0; i < 256; ++i) {
+    code1[i] = 1;
+    code2[i] = 2;
+    data1[i] = 3;
+    data2[i] = 4;
+  }
+
+  // Verify the data (this is checking for overlaps in the addresses)
+  for (unsigned i = 0; i < 256; ++i) {
+    EXPECT_EQ(1, code1[i]);
+    EXPECT_EQ(2, code2[i]);
+    EXPECT_EQ(3, data1[i]);
+    EXPECT_EQ(4, data2[i]);
+  }
+
+  std::string Error;
+  EXPECT_FALSE(MemMgr->finalizeMemory(&Error));
+
+  // Read-write data stays writable after finalization.
+  data2[0] = 5;
+  EXPECT_EQ(5, data2[0]);
+  EXPECT_EQ(1u, Pool->getNumSlabs());
+}
 
+TEST(MCJITMemoryManagerTest, SlabReusesReleasedPages) {
+  auto Pool = std::make_shared<SlabMemoryManager::SlabPool>(1 << 16);
+
+  uint8_t *code1;
+  {
+    SlabMemoryManager MemMgr(Pool);
+    code1 = MemMgr.allocateCodeSection(256, 0, 1, "");
+    ASSERT_NE((uint8_t*)nullptr, code1);
+    code1[0] = 1;
+    std::string Error;
+    EXPECT_FALSE(MemMgr.finalizeMemory(&Error));
+  }
+  EXPECT_EQ((size_t)1 << 16, Pool->getFreeBytes());
+
+  // The next memory manager gets the same, writable again, page.
+  SlabMemoryManager MemMgr(Pool);
+  uint8_t *code2 = MemMgr.allocateCodeSection(256, 0, 1, "");
+  EXPECT_EQ(code1, code2);
+  code2[0] = 2;
+  EXPECT_EQ(2, code2[0]);
+  EXPECT_EQ(1u, Pool->getNumSlabs());
+}
+
+TEST(MCJITMemoryManagerTest, SlabReleasesEmptySlabs) {
+  const size_t SlabSize = 1 << 16;
+  auto Pool = std::make_shared<SlabMemoryManager::SlabPool>(SlabSize);
+
+  {
+    std::vector<std::unique_ptr<SlabMemoryManager>> MemMgrs;
+    for (unsigned i = 0; i < 4; ++i) {
+      MemMgrs.emplace_back(new SlabMemoryManager(Pool));
+      uint8_t *data = MemMgrs.back()->allocateDataSection(SlabSize - 64, 0, 1,
+                                                          "", false);
+      ASSERT_NE((uint8_t*)nullptr, data);
+      data[SlabSize - 65] = 1;
+    }
+    EXPECT_EQ(4u, Pool->getNumSlabs());
+  }
+
+  // Only one empty slab is kept mapped.
+  EXPECT_EQ(1u, Pool->getNumSlabs());
+  EXPECT_EQ(SlabSize, Pool->getFreeBytes());
+}
+
+#if LLVM_ENABLE_THREADS
+TEST(MCJITMemoryManagerTest, SlabConcurrentMemoryManagers) {
+  auto Pool = std::make_shared<SlabMemoryManager::SlabPool>(1 << 16);
+
+  std::vector<std::thread> Threads;
+  for (unsigned t = 0; t < 4; ++t)
+    Threads.emplace_back([&Pool, t]() {
+      for (unsigned i = 0; i < 100; ++i) {
+        SlabMemoryManager MemMgr(Pool);
+        uint8_t Value = 1 + t;
+        uint8_t *code = MemMgr.allocateCodeSection(100 * (i + 1), 0, 1, "");
+        uint8_t *data = MemMgr.allocateDataSection(64, 0, 2, "", i % 2);
+        for (unsigned j = 0; j < 100 * (i + 1); ++j)
+          code[j] = Value;
+        for (unsigned j = 0; j < 64; ++j)
+          data[j] = Value;
+        for (unsigned j = 0; j < 100 * (i + 1); ++j)
+          EXPECT_EQ(Value, code[j]);
+        for (unsigned j = 0; j < 64; ++j)
+          EXPECT_EQ(Value, data[j]);
+        std::string Error;
+        EXPECT_FALSE(MemMgr.finalizeMemory(&Error));
+      }
+    });
+  for (auto &T : Threads)
+    T.join();
+
+  EXPECT_EQ(1u, Pool->getNumSlabs());
+}
+#endif
+
+} // Namespace
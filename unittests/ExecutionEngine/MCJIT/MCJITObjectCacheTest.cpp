@@ -11,9 +11,13 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/ExecutionEngine/FileObjectCache.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
 #include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -228,5 +232,100 @@ TEST_F(MCJITObjectCacheTest, VerifyNonLoadFromCache) {
   EXPECT_FALSE(Cache->wereDuplicatesInserted());
 }
 
+// Remove the files in Dir, and Dir itself.
+static void removeCacheDir(StringRef Dir) {
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC;
+       I.increment(EC))
+    sys::fs::remove(I->path());
+  sys::fs::remove(Dir);
+}
+
+TEST_F(MCJITObjectCacheTest, FileCacheKeyedByContents) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  SmallString<128> CacheDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("jit-object-cache", CacheDir));
+
+  // Compile the module, which should write its object to the cache.
+  const Module *FirstModule = M.get();
+  createJIT(std::move(M));
+  FileObjectCache Cache(CacheDir, *TheJIT->getTargetMachine());
+  TheJIT->setObjectCache(&Cache);
+  std::string FirstPath = Cache.getObjectPath(*FirstModule);
+  EXPECT_FALSE(sys::fs::exists(FirstPath));
+  compileAndRun();
+  EXPECT_TRUE(sys::fs::exists(FirstPath));
+  TheJIT.reset();
+  MM.reset(new SectionMemoryManager());
+
+  // A module with the same contents but a different identifier maps to the
+  // same object.
+  M.reset(createEmptyModule("<other>"));
+  Main = insertMainFunction(M.get(), OriginalRC);
+  EXPECT_EQ(FirstPath, Cache.getObjectPath(*M));
+  createJIT(std::move(M));
+  TheJIT->setObjectCache(&Cache);
+  compileAndRun();
+  TheJIT.reset();
+  MM.reset(new SectionMemoryManager());
+
+  // A module with the same identifier but different contents must not use the
+  // cached object.
+  M.reset(createEmptyModule("<main>"));
+  Main = insertMainFunction(M.get(), ReplacementRC);
+  EXPECT_NE(FirstPath, Cache.getObjectPath(*M));
+  createJIT(std::move(M));
+  TheJIT->setObjectCache(&Cache);
+  compileAndRun(ReplacementRC);
+  TheJIT.reset();
+
+  removeCacheDir(CacheDir);
+}
+
+TEST_F(MCJITObjectCacheTest, FileCacheSizeLimit) {
+  SKIP_UNSUPPORTED_PLATFORM;
+
+  SmallString<128> CacheDir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("jit-object-cache", CacheDir));
+
+  // Fill the cache with one object, and make it look old.
+  const Module *FirstModule = M.get();
+  createJIT(std::move(M));
+  std::unique_ptr<FileObjectCache> Cache(
+    new FileObjectCache(CacheDir, *TheJIT->getTargetMachine()));
+  TheJIT->setObjectCache(Cache.get());
+  std::string FirstPath = Cache->getObjectPath(*FirstModule);
+  compileAndRun();
+  TheJIT.reset();
+  MM.reset(new SectionMemoryManager());
+
+  uint64_t ObjSize;
+  ASSERT_FALSE(sys::fs::file_size(FirstPath, ObjSize));
+  int FD;
+  ASSERT_FALSE(sys::fs::openFileForWrite(FirstPath, FD, sys::fs::F_Append));
+  sys::fs::setLastModificationAndAccessTime(
+    FD, sys::TimeValue::now() - sys::TimeValue(3600.0));
+  sys::Process::SafelyCloseFileDescriptor(FD);
+
+  // Adding an object of the same size goes over the limit, so the older one
+  // is removed.
+  M.reset(createEmptyModule("<main>"));
+  Main = insertMainFunction(M.get(), ReplacementRC);
+  const Module *SecondModule = M.get();
+  createJIT(std::move(M));
+  Cache.reset(new FileObjectCache(CacheDir, *TheJIT->getTargetMachine(),
+                                  ObjSize + ObjSize / 2));
+  TheJIT->setObjectCache(Cache.get());
+  std::string SecondPath = Cache->getObjectPath(*SecondModule);
+  compileAndRun(ReplacementRC);
+  TheJIT.reset();
+
+  EXPECT_FALSE(sys::fs::exists(FirstPath));
+  EXPECT_TRUE(sys::fs::exists(SecondPath));
+
+  removeCacheDir(CacheDir);
+}
+
 } // Namespace
 
@@ -10,6 +10,7 @@
 #include "OrcTestCommon.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/IR/Verifier.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -45,4 +46,44 @@ TEST(IndirectionUtilsTest, MakeStub) {
     << "makeStub should propagate byval attr on 2nd argument.";
 }
 
+TEST(IndirectionUtilsTest, MakeCountingStub) {
+  ModuleBuilder MB(getGlobalContext(), "x86_64-apple-macosx10.10", "");
+  Module &M = *MB.getModule();
+  Function *F = MB.createFunctionDecl<int(int)>(&M, "f");
+  F->addFnAttr(Attribute::ReadNone);
+
+  auto ImplPtr = orc::createImplPointer(*F->getType(), M, "f$orc_addr",
+                                        nullptr);
+  auto Count = orc::createCallCounter(M, "f$orc_count");
+  FunctionType *NotifyTy =
+    TypeBuilder<void(types::i<8>*), false>::get(M.getContext());
+  Constant *Notify = orc::createIRTypedAddress(*NotifyTy, 0x1000);
+  Constant *NotifyArg =
+    Constant::getNullValue(NotifyTy->getParamType(0));
+  orc::makeCountingStub(*F, *ImplPtr, *Count, 10, Notify, NotifyArg);
+
+  EXPECT_FALSE(verifyModule(M, &errs()));
+  EXPECT_FALSE(F->doesNotAccessMemory())
+    << "Counting stubs write memory.";
+
+  auto *RMW = dyn_cast<AtomicRMWInst>(F->getEntryBlock().begin());
+  ASSERT_TRUE(RMW != nullptr) << "Stub should start by counting the call.";
+  EXPECT_EQ(Count, RMW->getPointerOperand());
+
+  LoadInst *Load = nullptr;
+  CallInst *Call = nullptr;
+  for (auto &I : F->back()) {
+    if (auto *LI = dyn_cast<LoadInst>(&I))
+      Load = LI;
+    if (auto *CI = dyn_cast<CallInst>(&I))
+      Call = CI;
+  }
+  ASSERT_TRUE(Load != nullptr) << "Stub should load the implementation.";
+  EXPECT_TRUE(Load->isAtomic())
+    << "Implementation pointer may be updated concurrently.";
+  ASSERT_TRUE(Call != nullptr) << "Stub should call the implementation.";
+  EXPECT_TRUE(Call->isTailCall());
+  EXPECT_EQ(Load, Call->getCalledValue());
+}
+
 }
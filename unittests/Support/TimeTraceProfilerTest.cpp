@@ -0,0 +1,89 @@
+//===- llvm/unittest/Support/TimeTraceProfilerTest.cpp --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/TimeTraceProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(TimeTraceProfiler, Disabled) {
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+  // Scopes do nothing when the trace is not recorded.
+  TimeTraceScope Scope("unused");
+}
+
+TEST(TimeTraceProfiler, NestedScopes) {
+  timeTraceProfilerInitialize(0, "test");
+  EXPECT_TRUE(timeTraceProfilerEnabled());
+  {
+    TimeTraceScope Outer("outer", "function \"f\"");
+    {
+      TimeTraceScope Inner("inner");
+      TimeTraceScope Recursive("outer");
+    }
+  }
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  EXPECT_FALSE(timeTraceProfilerEnabled());
+  OS.flush();
+
+  EXPECT_EQ(0u, Out.find("{\"traceEvents\":[\n"));
+  // The enclosing scope comes first.
+  size_t OuterPos =
+      Out.find("\"name\":\"outer\",\"args\":{\"detail\":\"function \\\"f\\\"\"}");
+  size_t InnerPos = Out.find("\"name\":\"inner\"}");
+  ASSERT_NE(std::string::npos, OuterPos);
+  ASSERT_NE(std::string::npos, InnerPos);
+  EXPECT_LT(OuterPos, InnerPos);
+  // The scope nested in a scope of the same name is not counted twice.
+  EXPECT_NE(std::string::npos,
+            Out.find("\"name\":\"Total outer\",\"args\":{\"count\":1,"));
+  EXPECT_NE(std::string::npos,
+            Out.find("\"name\":\"Total inner\",\"args\":{\"count\":1,"));
+  EXPECT_NE(std::string::npos,
+            Out.find("\"name\":\"process_name\",\"args\":{\"name\":\"test\"}"));
+}
+
+TEST(TimeTraceProfiler, Granularity) {
+  // No scope of this test lasts an hour.
+  timeTraceProfilerInitialize(3600000000u, "test");
+  {
+    TimeTraceScope Scope("short");
+  }
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  EXPECT_EQ(std::string::npos, OS.str().find("short"));
+}
+
+TEST(TimeTraceProfiler, Escaping) {
+  timeTraceProfilerInitialize(0, "test");
+  {
+    // Control characters need \u escapes in JSON; UTF-8 passes through.
+    TimeTraceScope Scope("tab\tbell\x07", "caf\xc3\xa9");
+  }
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  timeTraceProfilerWrite(OS);
+  timeTraceProfilerCleanup();
+  EXPECT_NE(std::string::npos,
+            OS.str().find("\"name\":\"tab\\tbell\\u0007\",\"args\":"
+                          "{\"detail\":\"caf\xc3\xa9\"}"));
+}
+
+} // end anonymous namespace
@@ -0,0 +1,72 @@
+//===- llvm/unittest/Support/TimerTest.cpp - Timer tests ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(Timer, PrintJSON) {
+  TimerGroup TG("Test \"group\"");
+  Timer T1("first", TG);
+  Timer T2("second", TG);
+  Timer T3("never started", TG);
+  T1.startTimer();
+  T1.stopTimer();
+  T2.startTimer();
+  T2.stopTimer();
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  TG.printJSON(OS);
+  OS.flush();
+
+  EXPECT_EQ(0u, Out.find("{\"name\":\"Test \\\"group\\\"\",\"total\":{\"wall\":"));
+  EXPECT_NE(std::string::npos, Out.find("{\"name\":\"first\",\"wall\":"));
+  EXPECT_NE(std::string::npos, Out.find("{\"name\":\"second\",\"wall\":"));
+  EXPECT_EQ(std::string::npos, Out.find("never started"));
+  EXPECT_EQ("]}", Out.substr(Out.size() - 2));
+  EXPECT_EQ(std::string::npos, Out.find('\n'));
+
+  // The timers were zeroed, so printing again gives an empty group.
+  Out.clear();
+  TG.printJSON(OS);
+  OS.flush();
+  EXPECT_NE(std::string::npos, Out.find("\"timers\":[]}"));
+}
+
+TEST(Timer, PrintAllJSON) {
+  TimerGroup Started("started group");
+  TimerGroup Idle("idle group");
+  Timer T1("timer", Started);
+  Timer T2("timer", Idle);
+  T1.startTimer();
+  T1.stopTimer();
+
+  std::string Out;
+  raw_string_ostream OS(Out);
+  TimerGroup::printAllJSON(OS);
+  OS.flush();
+
+  EXPECT_EQ('[', Out[0]);
+  EXPECT_EQ("\n]\n", Out.substr(Out.size() - 3));
+  EXPECT_NE(std::string::npos, Out.find("\"name\":\"started group\""));
+  EXPECT_EQ(std::string::npos, Out.find("idle group"));
+
+  // Everything was cleared out.
+  Out.clear();
+  TimerGroup::printAllJSON(OS);
+  OS.flush();
+  EXPECT_EQ("[\n]\n", Out);
+}
+
+} // end anonymous namespace
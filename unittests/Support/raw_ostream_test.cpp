@@ -143,6 +143,27 @@ TEST(raw_ostreamTest, WriteEscaped) {
   EXPECT_EQ("\\001\\010\\200", Str);
 }
 
+TEST(raw_ostreamTest, WriteJSONString) {
+  std::string Str;
+
+  Str = "";
+  raw_string_ostream(Str).write_json_string("hi");
+  EXPECT_EQ("\"hi\"", Str);
+
+  Str = "";
+  raw_string_ostream(Str).write_json_string("\\\"\b\f\n\r\t");
+  EXPECT_EQ("\"\\\\\\\"\\b\\f\\n\\r\\t\"", Str);
+
+  Str = "";
+  raw_string_ostream(Str).write_json_string(StringRef("\0\1\37\177", 4));
+  EXPECT_EQ("\"\\u0000\\u0001\\u001F\177\"", Str);
+
+  // UTF-8 is not escaped.
+  Str = "";
+  raw_string_ostream(Str).write_json_string("\xc3\xa9");
+  EXPECT_EQ("\"\xc3\xa9\"", Str);
+}
+
 TEST(raw_ostreamTest, Justify) {  
   EXPECT_EQ("xyz   ", printToString(left_justify("xyz", 6), 6));
   EXPECT_EQ("abc",    printToString(left_justify("abc", 3), 3));
@@ -297,7 +297,11 @@ void CodeGenTarget::ComputeInstrsByEnum() const {
       "IMPLICIT_DEF", "SUBREG_TO_REG", "COPY_TO_REGCLASS", "DBG_VALUE",
       "REG_SEQUENCE", "COPY",          "BUNDLE",           "LIFETIME_START",
       "LIFETIME_END", "STACKMAP",      "PATCHPOINT",       "LOAD_STACK_GUARD",
-      "STATEPOINT",   "FRAME_ALLOC",
+      "STATEPOINT",   "FRAME_ALLOC",   "G_ADD",            "G_SUB",
+      "G_MUL",        "G_AND",         "G_OR",             "G_XOR",
+      "G_ICMP",       "G_ZEXT",        "G_SEXT",           "G_TRUNC",
+      "G_CONSTANT",   "G_BR",          "G_BRCOND",         "G_FRAME_INDEX",
+      "G_GLOBAL_VALUE", "G_LOAD",      "G_STORE",
       nullptr};
   const auto &Insts = getInstructions();
   for (const char *const *p = FixedInstrs; *p; ++p) {
@@ -0,0 +1,131 @@
+; Integer and bit manipulation code with many redundant operations, in the
+; shape a front end emits before any cleanup. Most of the work here is done
+; by InstCombine, GVN and the DAG combiner.
+
+define i32 @popcount(i32 %x) {
+entry:
+  %a0 = lshr i32 %x, 1
+  %a1 = and i32 %a0, 1431655765
+  %a2 = sub i32 %x, %a1
+  %b0 = and i32 %a2, 858993459
+  %b1 = lshr i32 %a2, 2
+  %b2 = and i32 %b1, 858993459
+  %b3 = add i32 %b0, %b2
+  %c0 = lshr i32 %b3, 4
+  %c1 = add i32 %c0, %b3
+  %c2 = and i32 %c1, 252645135
+  %c3 = mul i32 %c2, 16843009
+  %c4 = lshr i32 %c3, 24
+  ret i32 %c4
+}
+
+define i32 @bswap(i32 %x) {
+entry:
+  %b0 = shl i32 %x, 24
+  %t1 = shl i32 %x, 8
+  %b1 = and i32 %t1, 16711680
+  %t2 = lshr i32 %x, 8
+  %b2 = and i32 %t2, 65280
+  %b3 = lshr i32 %x, 24
+  %o0 = or i32 %b0, %b1
+  %o1 = or i32 %o0, %b2
+  %o2 = or i32 %o1, %b3
+  ret i32 %o2
+}
+
+define i64 @hash(i8* nocapture readonly %s, i64 %len) {
+entry:
+  %empty = icmp eq i64 %len, 0
+  br i1 %empty, label %done, label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %h = phi i64 [ -3750763034362895579, %entry ], [ %h.next, %loop ]
+  %p = getelementptr inbounds i8, i8* %s, i64 %i
+  %c = load i8, i8* %p, align 1
+  %c.ext = zext i8 %c to i64
+  %x = xor i64 %h, %c.ext
+  %h.next = mul i64 %x, 1099511628211
+  %i.next = add nuw i64 %i, 1
+  %cont = icmp ult i64 %i.next, %len
+  br i1 %cont, label %loop, label %done
+
+done:
+  %res = phi i64 [ -3750763034362895579, %entry ], [ %h.next, %loop ]
+  %s1 = lshr i64 %res, 33
+  %m1 = xor i64 %res, %s1
+  %m2 = mul i64 %m1, -49064778989728563
+  %s2 = lshr i64 %m2, 33
+  %m3 = xor i64 %m2, %s2
+  ret i64 %m3
+}
+
+define i32 @clamp_add(i32 %a, i32 %b, i32 %lo, i32 %hi) {
+entry:
+  %a.ext = sext i32 %a to i64
+  %b.ext = sext i32 %b to i64
+  %sum = add nsw i64 %a.ext, %b.ext
+  %lo.ext = sext i32 %lo to i64
+  %hi.ext = sext i32 %hi to i64
+  %too.low = icmp slt i64 %sum, %lo.ext
+  %s0 = select i1 %too.low, i64 %lo.ext, i64 %sum
+  %too.high = icmp sgt i64 %s0, %hi.ext
+  %s1 = select i1 %too.high, i64 %hi.ext, i64 %s0
+  %r = trunc i64 %s1 to i32
+  %neg = sub i32 0, %r
+  %negneg = sub i32 0, %neg
+  %x0 = xor i32 %negneg, -1
+  %x1 = xor i32 %x0, -1
+  %m = mul i32 %x1, 8
+  %d = sdiv exact i32 %m, 8
+  ret i32 %d
+}
+
+define i1 @range_checks(i32 %x, i32 %y) {
+entry:
+  %c0 = icmp sgt i32 %x, 10
+  %c1 = icmp slt i32 %x, 100
+  %and0 = and i1 %c0, %c1
+  %c2 = icmp ne i32 %x, 50
+  %and1 = and i1 %and0, %c2
+  %xy = and i32 %x, %y
+  %xy.eq = icmp eq i32 %xy, %x
+  %yx = or i32 %y, %x
+  %yx.eq = icmp eq i32 %yx, %y
+  %same = xor i1 %xy.eq, %yx.eq
+  %nsame = xor i1 %same, true
+  %r = and i1 %and1, %nsame
+  ret i1 %r
+}
+
+define void @unpack(i32* nocapture %out, i64* nocapture readonly %in, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %idx = sext i32 %i to i64
+  %in.p = getelementptr inbounds i64, i64* %in, i64 %idx
+  %w = load i64, i64* %in.p, align 8
+  %lo = trunc i64 %w to i32
+  %hi.s = lshr i64 %w, 32
+  %hi = trunc i64 %hi.s to i32
+  %lo.m = and i32 %lo, 65535
+  %hi.m = shl i32 %hi, 16
+  %hi.mm = and i32 %hi.m, -65536
+  %v = or i32 %lo.m, %hi.mm
+  %out.idx = shl nsw i64 %idx, 1
+  %out.p = getelementptr inbounds i32, i32* %out, i64 %out.idx
+  store i32 %v, i32* %out.p, align 4
+  %out.idx1 = or i64 %out.idx, 1
+  %out.p1 = getelementptr inbounds i32, i32* %out, i64 %out.idx1
+  %v1 = xor i32 %v, %lo
+  store i32 %v1, i32* %out.p1, align 4
+  %i.next = add nsw i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
@@ -0,0 +1,160 @@
+; A small call graph of helpers that take their arguments through memory,
+; as unoptimized front end output does. The inliner, SROA, mem2reg and
+; the function attribute passes do most of the work.
+
+%struct.vec = type { double, double, double }
+%struct.body = type { %struct.vec, %struct.vec, double }
+
+define internal void @vec_add(%struct.vec* %r, %struct.vec* %a, %struct.vec* %b) {
+entry:
+  %r.addr = alloca %struct.vec*, align 8
+  %a.addr = alloca %struct.vec*, align 8
+  %b.addr = alloca %struct.vec*, align 8
+  store %struct.vec* %r, %struct.vec** %r.addr, align 8
+  store %struct.vec* %a, %struct.vec** %a.addr, align 8
+  store %struct.vec* %b, %struct.vec** %b.addr, align 8
+  %0 = load %struct.vec*, %struct.vec** %a.addr, align 8
+  %1 = load %struct.vec*, %struct.vec** %b.addr, align 8
+  %2 = load %struct.vec*, %struct.vec** %r.addr, align 8
+  %ax.p = getelementptr inbounds %struct.vec, %struct.vec* %0, i32 0, i32 0
+  %bx.p = getelementptr inbounds %struct.vec, %struct.vec* %1, i32 0, i32 0
+  %rx.p = getelementptr inbounds %struct.vec, %struct.vec* %2, i32 0, i32 0
+  %ax = load double, double* %ax.p, align 8
+  %bx = load double, double* %bx.p, align 8
+  %rx = fadd double %ax, %bx
+  store double %rx, double* %rx.p, align 8
+  %ay.p = getelementptr inbounds %struct.vec, %struct.vec* %0, i32 0, i32 1
+  %by.p = getelementptr inbounds %struct.vec, %struct.vec* %1, i32 0, i32 1
+  %ry.p = getelementptr inbounds %struct.vec, %struct.vec* %2, i32 0, i32 1
+  %ay = load double, double* %ay.p, align 8
+  %by = load double, double* %by.p, align 8
+  %ry = fadd double %ay, %by
+  store double %ry, double* %ry.p, align 8
+  %az.p = getelementptr inbounds %struct.vec, %struct.vec* %0, i32 0, i32 2
+  %bz.p = getelementptr inbounds %struct.vec, %struct.vec* %1, i32 0, i32 2
+  %rz.p = getelementptr inbounds %struct.vec, %struct.vec* %2, i32 0, i32 2
+  %az = load double, double* %az.p, align 8
+  %bz = load double, double* %bz.p, align 8
+  %rz = fadd double %az, %bz
+  store double %rz, double* %rz.p, align 8
+  ret void
+}
+
+define internal void @vec_scale(%struct.vec* %r, %struct.vec* %a, double %s) {
+entry:
+  %s.addr = alloca double, align 8
+  store double %s, double* %s.addr, align 8
+  %ax.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 0
+  %ay.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 1
+  %az.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 2
+  %rx.p = getelementptr inbounds %struct.vec, %struct.vec* %r, i32 0, i32 0
+  %ry.p = getelementptr inbounds %struct.vec, %struct.vec* %r, i32 0, i32 1
+  %rz.p = getelementptr inbounds %struct.vec, %struct.vec* %r, i32 0, i32 2
+  %s0 = load double, double* %s.addr, align 8
+  %ax = load double, double* %ax.p, align 8
+  %rx = fmul double %ax, %s0
+  store double %rx, double* %rx.p, align 8
+  %s1 = load double, double* %s.addr, align 8
+  %ay = load double, double* %ay.p, align 8
+  %ry = fmul double %ay, %s1
+  store double %ry, double* %ry.p, align 8
+  %s2 = load double, double* %s.addr, align 8
+  %az = load double, double* %az.p, align 8
+  %rz = fmul double %az, %s2
+  store double %rz, double* %rz.p, align 8
+  ret void
+}
+
+define internal double @vec_dot(%struct.vec* %a, %struct.vec* %b) {
+entry:
+  %ax.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 0
+  %ay.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 1
+  %az.p = getelementptr inbounds %struct.vec, %struct.vec* %a, i32 0, i32 2
+  %bx.p = getelementptr inbounds %struct.vec, %struct.vec* %b, i32 0, i32 0
+  %by.p = getelementptr inbounds %struct.vec, %struct.vec* %b, i32 0, i32 1
+  %bz.p = getelementptr inbounds %struct.vec, %struct.vec* %b, i32 0, i32 2
+  %ax = load double, double* %ax.p, align 8
+  %ay = load double, double* %ay.p, align 8
+  %az = load double, double* %az.p, align 8
+  %bx = load double, double* %bx.p, align 8
+  %by = load double, double* %by.p, align 8
+  %bz = load double, double* %bz.p, align 8
+  %xx = fmul double %ax, %bx
+  %yy = fmul double %ay, %by
+  %zz = fmul double %az, %bz
+  %s0 = fadd double %xx, %yy
+  %s1 = fadd double %s0, %zz
+  ret double %s1
+}
+
+define internal void @body_step(%struct.body* %b, double %dt) {
+entry:
+  %dv = alloca %struct.vec, align 8
+  %dx = alloca %struct.vec, align 8
+  %pos = getelementptr inbounds %struct.body, %struct.body* %b, i32 0, i32 0
+  %vel = getelementptr inbounds %struct.body, %struct.body* %b, i32 0, i32 1
+  %mass.p = getelementptr inbounds %struct.body, %struct.body* %b, i32 0, i32 2
+  %mass = load double, double* %mass.p, align 8
+  %inv = fdiv double 1.0, %mass
+  %k = fmul double %inv, %dt
+  call void @vec_scale(%struct.vec* %dv, %struct.vec* %pos, double %k)
+  call void @vec_add(%struct.vec* %vel, %struct.vec* %vel, %struct.vec* %dv)
+  call void @vec_scale(%struct.vec* %dx, %struct.vec* %vel, double %dt)
+  call void @vec_add(%struct.vec* %pos, %struct.vec* %pos, %struct.vec* %dx)
+  ret void
+}
+
+define internal double @body_energy(%struct.body* %b) {
+entry:
+  %vel = getelementptr inbounds %struct.body, %struct.body* %b, i32 0, i32 1
+  %mass.p = getelementptr inbounds %struct.body, %struct.body* %b, i32 0, i32 2
+  %mass = load double, double* %mass.p, align 8
+  %v2 = call double @vec_dot(%struct.vec* %vel, %struct.vec* %vel)
+  %half = fmul double %mass, 5.000000e-01
+  %e = fmul double %half, %v2
+  ret double %e
+}
+
+define double @simulate(%struct.body* %bodies, i32 %n, i32 %steps, double %dt) {
+entry:
+  %n.pos = icmp sgt i32 %n, 0
+  %steps.pos = icmp sgt i32 %steps, 0
+  %run = and i1 %n.pos, %steps.pos
+  br i1 %run, label %step, label %energy.entry
+
+step:
+  %s = phi i32 [ 0, %entry ], [ %s.next, %step.latch ]
+  br label %bodies.loop
+
+bodies.loop:
+  %i = phi i32 [ 0, %step ], [ %i.next, %bodies.loop ]
+  %idx = sext i32 %i to i64
+  %b = getelementptr inbounds %struct.body, %struct.body* %bodies, i64 %idx
+  call void @body_step(%struct.body* %b, double %dt)
+  %i.next = add nsw i32 %i, 1
+  %i.done = icmp eq i32 %i.next, %n
+  br i1 %i.done, label %step.latch, label %bodies.loop
+
+step.latch:
+  %s.next = add nsw i32 %s, 1
+  %s.done = icmp eq i32 %s.next, %steps
+  br i1 %s.done, label %energy.entry, label %step
+
+energy.entry:
+  br i1 %n.pos, label %energy, label %exit
+
+energy:
+  %j = phi i32 [ 0, %energy.entry ], [ %j.next, %energy ]
+  %e = phi double [ 0.0, %energy.entry ], [ %e.next, %energy ]
+  %jdx = sext i32 %j to i64
+  %bj = getelementptr inbounds %struct.body, %struct.body* %bodies, i64 %jdx
+  %ej = call double @body_energy(%struct.body* %bj)
+  %e.next = fadd double %e, %ej
+  %j.next = add nsw i32 %j, 1
+  %j.done = icmp eq i32 %j.next, %n
+  br i1 %j.done, label %exit, label %energy
+
+exit:
+  %res = phi double [ 0.0, %energy.entry ], [ %e.next, %energy ]
+  ret double %res
+}
@@ -0,0 +1,132 @@
+; A bytecode interpreter: one large loop around a switch with many live
+; values across its cases. It stresses SimplifyCFG, jump threading, the
+; register allocators and branch lowering.
+
+define i64 @interp(i8* nocapture readonly %code, i64* nocapture %stack, i64 %len) {
+entry:
+  br label %dispatch
+
+dispatch:
+  %pc = phi i64 [ 0, %entry ], [ %pc.next, %next ]
+  %sp = phi i64 [ 0, %entry ], [ %sp.next, %next ]
+  %acc = phi i64 [ 0, %entry ], [ %acc.next, %next ]
+  %r1 = phi i64 [ 1, %entry ], [ %r1.next, %next ]
+  %r2 = phi i64 [ 2, %entry ], [ %r2.next, %next ]
+  %r3 = phi i64 [ 3, %entry ], [ %r3.next, %next ]
+  %r4 = phi i64 [ 4, %entry ], [ %r4.next, %next ]
+  %end = icmp uge i64 %pc, %len
+  br i1 %end, label %exit, label %fetch
+
+fetch:
+  %op.p = getelementptr inbounds i8, i8* %code, i64 %pc
+  %op = load i8, i8* %op.p, align 1
+  %pc.1 = add i64 %pc, 1
+  switch i8 %op, label %next [
+    i8 0, label %op.push
+    i8 1, label %op.pop
+    i8 2, label %op.add
+    i8 3, label %op.sub
+    i8 4, label %op.mul
+    i8 5, label %op.shl
+    i8 6, label %op.xor
+    i8 7, label %op.mov1
+    i8 8, label %op.mov2
+    i8 9, label %op.mov3
+    i8 10, label %op.mov4
+    i8 11, label %op.jmp
+    i8 12, label %op.jz
+    i8 13, label %op.rot
+    i8 14, label %op.halt
+  ]
+
+op.push:
+  %push.p = getelementptr inbounds i64, i64* %stack, i64 %sp
+  store i64 %acc, i64* %push.p, align 8
+  %sp.push = add i64 %sp, 1
+  br label %next
+
+op.pop:
+  %sp.pop = add i64 %sp, -1
+  %pop.p = getelementptr inbounds i64, i64* %stack, i64 %sp.pop
+  %pop.v = load i64, i64* %pop.p, align 8
+  br label %next
+
+op.add:
+  %add.a = add i64 %acc, %r1
+  %add.b = add i64 %add.a, %r2
+  br label %next
+
+op.sub:
+  %sub.a = sub i64 %acc, %r3
+  %sub.b = sub i64 %r4, %sub.a
+  br label %next
+
+op.mul:
+  %mul.a = mul i64 %acc, %r1
+  %mul.b = mul i64 %r2, %r3
+  %mul.c = add i64 %mul.a, %mul.b
+  br label %next
+
+op.shl:
+  %shl.n = and i64 %r4, 63
+  %shl.a = shl i64 %acc, %shl.n
+  br label %next
+
+op.xor:
+  %xor.a = xor i64 %acc, %r1
+  %xor.b = xor i64 %xor.a, %r2
+  %xor.c = xor i64 %xor.b, %r3
+  %xor.d = xor i64 %xor.c, %r4
+  br label %next
+
+op.mov1:
+  br label %next
+
+op.mov2:
+  br label %next
+
+op.mov3:
+  br label %next
+
+op.mov4:
+  br label %next
+
+op.jmp:
+  %jmp.p = getelementptr inbounds i8, i8* %code, i64 %pc.1
+  %jmp.off = load i8, i8* %jmp.p, align 1
+  %jmp.ext = zext i8 %jmp.off to i64
+  br label %next
+
+op.jz:
+  %jz.p = getelementptr inbounds i8, i8* %code, i64 %pc.1
+  %jz.off = load i8, i8* %jz.p, align 1
+  %jz.ext = zext i8 %jz.off to i64
+  %jz.zero = icmp eq i64 %acc, 0
+  %pc.2 = add i64 %pc, 2
+  %jz.target = select i1 %jz.zero, i64 %jz.ext, i64 %pc.2
+  br label %next
+
+op.rot:
+  br label %next
+
+op.halt:
+  br label %exit
+
+next:
+  %pc.next = phi i64 [ %pc.1, %fetch ], [ %pc.1, %op.push ], [ %pc.1, %op.pop ], [ %pc.1, %op.add ], [ %pc.1, %op.sub ], [ %pc.1, %op.mul ], [ %pc.1, %op.shl ], [ %pc.1, %op.xor ], [ %pc.1, %op.mov1 ], [ %pc.1, %op.mov2 ], [ %pc.1, %op.mov3 ], [ %pc.1, %op.mov4 ], [ %jmp.ext, %op.jmp ], [ %jz.target, %op.jz ], [ %pc.1, %op.rot ]
+  %sp.next = phi i64 [ %sp, %fetch ], [ %sp.push, %op.push ], [ %sp.pop, %op.pop ], [ %sp, %op.add ], [ %sp, %op.sub ], [ %sp, %op.mul ], [ %sp, %op.shl ], [ %sp, %op.xor ], [ %sp, %op.mov1 ], [ %sp, %op.mov2 ], [ %sp, %op.mov3 ], [ %sp, %op.mov4 ], [ %sp, %op.jmp ], [ %sp, %op.jz ], [ %sp, %op.rot ]
+  %acc.next = phi i64 [ %acc, %fetch ], [ %acc, %op.push ], [ %pop.v, %op.pop ], [ %add.b, %op.add ], [ %sub.b, %op.sub ], [ %mul.c, %op.mul ], [ %shl.a, %op.shl ], [ %xor.d, %op.xor ], [ %acc, %op.mov1 ], [ %acc, %op.mov2 ], [ %acc, %op.mov3 ], [ %acc, %op.mov4 ], [ %acc, %op.jmp ], [ %acc, %op.jz ], [ %r1, %op.rot ]
+  %r1.next = phi i64 [ %r1, %fetch ], [ %r1, %op.push ], [ %r1, %op.pop ], [ %r1, %op.add ], [ %r1, %op.sub ], [ %r1, %op.mul ], [ %r1, %op.shl ], [ %r1, %op.xor ], [ %acc, %op.mov1 ], [ %r1, %op.mov2 ], [ %r1, %op.mov3 ], [ %r1, %op.mov4 ], [ %r1, %op.jmp ], [ %r1, %op.jz ], [ %r2, %op.rot ]
+  %r2.next = phi i64 [ %r2, %fetch ], [ %r2, %op.push ], [ %r2, %op.pop ], [ %r2, %op.add ], [ %r2, %op.sub ], [ %r2, %op.mul ], [ %r2, %op.shl ], [ %r2, %op.xor ], [ %r2, %op.mov1 ], [ %acc, %op.mov2 ], [ %r2, %op.mov3 ], [ %r2, %op.mov4 ], [ %r2, %op.jmp ], [ %r2, %op.jz ], [ %r3, %op.rot ]
+  %r3.next = phi i64 [ %r3, %fetch ], [ %r3, %op.push ], [ %r3, %op.pop ], [ %r3, %op.add ], [ %r3, %op.sub ], [ %r3, %op.mul ], [ %r3, %op.shl ], [ %r3, %op.xor ], [ %r3, %op.mov1 ], [ %r3, %op.mov2 ], [ %acc, %op.mov3 ], [ %r3, %op.mov4 ], [ %r3, %op.jmp ], [ %r3, %op.jz ], [ %r4, %op.rot ]
+  %r4.next = phi i64 [ %r4, %fetch ], [ %r4, %op.push ], [ %r4, %op.pop ], [ %r4, %op.add ], [ %r4, %op.sub ], [ %r4, %op.mul ], [ %r4, %op.shl ], [ %r4, %op.xor ], [ %r4, %op.mov1 ], [ %r4, %op.mov2 ], [ %r4, %op.mov3 ], [ %acc, %op.mov4 ], [ %r4, %op.jmp ], [ %r4, %op.jz ], [ %acc, %op.rot ]
+  br label %dispatch
+
+exit:
+  %res = phi i64 [ %acc, %dispatch ], [ %acc, %op.halt ]
+  %res.1 = add i64 %res, %r1
+  %res.2 = add i64 %res.1, %r2
+  %res.3 = add i64 %res.2, %r3
+  %res.4 = add i64 %res.3, %r4
+  ret i64 %res.4
+}
@@ -0,0 +1,159 @@
+; Loop nests over arrays: matrix multiply, stencils and reductions. They
+; exercise the loop passes, the vectorizers and the register allocator.
+
+define void @matmul(double* noalias %a, double* noalias %b, double* noalias %c, i32 %n) {
+entry:
+  %cmp.i = icmp sgt i32 %n, 0
+  br i1 %cmp.i, label %for.i, label %exit
+
+for.i:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %for.i.latch ]
+  %i.n = mul nsw i32 %i, %n
+  br label %for.j
+
+for.j:
+  %j = phi i32 [ 0, %for.i ], [ %j.next, %for.j.latch ]
+  br label %for.k
+
+for.k:
+  %k = phi i32 [ 0, %for.j ], [ %k.next, %for.k ]
+  %sum = phi double [ 0.0, %for.j ], [ %sum.next, %for.k ]
+  %a.idx = add nsw i32 %i.n, %k
+  %a.idx.ext = sext i32 %a.idx to i64
+  %a.ptr = getelementptr inbounds double, double* %a, i64 %a.idx.ext
+  %a.val = load double, double* %a.ptr, align 8
+  %k.n = mul nsw i32 %k, %n
+  %b.idx = add nsw i32 %k.n, %j
+  %b.idx.ext = sext i32 %b.idx to i64
+  %b.ptr = getelementptr inbounds double, double* %b, i64 %b.idx.ext
+  %b.val = load double, double* %b.ptr, align 8
+  %mul = fmul double %a.val, %b.val
+  %sum.next = fadd double %sum, %mul
+  %k.next = add nsw i32 %k, 1
+  %k.done = icmp eq i32 %k.next, %n
+  br i1 %k.done, label %for.j.latch, label %for.k
+
+for.j.latch:
+  %c.idx = add nsw i32 %i.n, %j
+  %c.idx.ext = sext i32 %c.idx to i64
+  %c.ptr = getelementptr inbounds double, double* %c, i64 %c.idx.ext
+  store double %sum.next, double* %c.ptr, align 8
+  %j.next = add nsw i32 %j, 1
+  %j.done = icmp eq i32 %j.next, %n
+  br i1 %j.done, label %for.i.latch, label %for.j
+
+for.i.latch:
+  %i.next = add nsw i32 %i, 1
+  %i.done = icmp eq i32 %i.next, %n
+  br i1 %i.done, label %exit, label %for.i
+
+exit:
+  ret void
+}
+
+define void @stencil(float* noalias %out, float* noalias %in, i64 %w, i64 %h) {
+entry:
+  %h.1 = add i64 %h, -1
+  %w.1 = add i64 %w, -1
+  %rows = icmp ugt i64 %h.1, 1
+  br i1 %rows, label %for.y, label %exit
+
+for.y:
+  %y = phi i64 [ 1, %entry ], [ %y.next, %for.y.latch ]
+  %row = mul i64 %y, %w
+  %row.up = sub i64 %row, %w
+  %row.down = add i64 %row, %w
+  %cols = icmp ugt i64 %w.1, 1
+  br i1 %cols, label %for.x, label %for.y.latch
+
+for.x:
+  %x = phi i64 [ 1, %for.y ], [ %x.next, %for.x ]
+  %c = add i64 %row, %x
+  %l = add i64 %c, -1
+  %r = add i64 %c, 1
+  %u = add i64 %row.up, %x
+  %d = add i64 %row.down, %x
+  %c.p = getelementptr inbounds float, float* %in, i64 %c
+  %l.p = getelementptr inbounds float, float* %in, i64 %l
+  %r.p = getelementptr inbounds float, float* %in, i64 %r
+  %u.p = getelementptr inbounds float, float* %in, i64 %u
+  %d.p = getelementptr inbounds float, float* %in, i64 %d
+  %c.v = load float, float* %c.p, align 4
+  %l.v = load float, float* %l.p, align 4
+  %r.v = load float, float* %r.p, align 4
+  %u.v = load float, float* %u.p, align 4
+  %d.v = load float, float* %d.p, align 4
+  %s0 = fadd float %l.v, %r.v
+  %s1 = fadd float %u.v, %d.v
+  %s2 = fadd float %s0, %s1
+  %c4 = fmul float %c.v, 4.0
+  %lap = fsub float %s2, %c4
+  %scaled = fmul float %lap, 2.500000e-01
+  %res = fadd float %c.v, %scaled
+  %o.p = getelementptr inbounds float, float* %out, i64 %c
+  store float %res, float* %o.p, align 4
+  %x.next = add i64 %x, 1
+  %x.done = icmp eq i64 %x.next, %w.1
+  br i1 %x.done, label %for.y.latch, label %for.x
+
+for.y.latch:
+  %y.next = add i64 %y, 1
+  %y.done = icmp eq i64 %y.next, %h.1
+  br i1 %y.done, label %exit, label %for.y
+
+exit:
+  ret void
+}
+
+define i64 @reduce(i32* nocapture readonly %p, i64 %n) {
+entry:
+  %empty = icmp eq i64 %n, 0
+  br i1 %empty, label %exit, label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %sum = phi i64 [ 0, %entry ], [ %sum.next, %loop ]
+  %min = phi i32 [ 2147483647, %entry ], [ %min.next, %loop ]
+  %ptr = getelementptr inbounds i32, i32* %p, i64 %i
+  %v = load i32, i32* %ptr, align 4
+  %v.ext = sext i32 %v to i64
+  %sq = mul nsw i64 %v.ext, %v.ext
+  %sum.next = add nsw i64 %sum, %sq
+  %lt = icmp slt i32 %v, %min
+  %min.next = select i1 %lt, i32 %v, i32 %min
+  %i.next = add nuw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %loop.exit, label %loop
+
+loop.exit:
+  %min.ext = sext i32 %min.next to i64
+  %r = add nsw i64 %sum.next, %min.ext
+  br label %exit
+
+exit:
+  %res = phi i64 [ 0, %entry ], [ %r, %loop.exit ]
+  ret i64 %res
+}
+
+define void @saxpy(float* noalias %y, float* noalias readonly %x, float %a, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %idx = zext i32 %i to i64
+  %x.p = getelementptr inbounds float, float* %x, i64 %idx
+  %y.p = getelementptr inbounds float, float* %y, i64 %idx
+  %x.v = load float, float* %x.p, align 4
+  %y.v = load float, float* %y.p, align 4
+  %ax = fmul float %a, %x.v
+  %r = fadd float %ax, %y.v
+  store float %r, float* %y.p, align 4
+  %i.next = add nuw nsw i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
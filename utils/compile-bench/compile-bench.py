@@ -0,0 +1,317 @@
+#!/usr/bin/env python
+"""Compile-time benchmark driver for opt and llc.
+
+Runs a fixed set of optimizer and code generator pipelines over the IR
+modules of a corpus and records, for each module and pipeline:
+
+  - the wall, user and system time of the tool, as the median of the runs,
+  - the time of each pass, as reported by -time-passes -timers-json,
+  - the statistics reported by -stats -stats-json, when LLVM was built
+    with them,
+  - the number of instructions in the output,
+  - the peak resident set size of the tool.
+
+The results are written as JSON, so that two runs can be compared with
+--compare to flag compile-time regressions:
+
+  compile-bench.py --bin-dir build/bin -o base.json
+  (apply patch, rebuild)
+  compile-bench.py --bin-dir build/bin -o new.json
+  compile-bench.py --compare base.json new.json
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import platform
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# The pipelines to measure, as (name, tool, arguments). The llc pipelines
+# take the output of opt -O2 as input, which is what they usually see.
+PIPELINES = [
+    ('opt-O1', 'opt', ['-O1']),
+    ('opt-O2', 'opt', ['-O2']),
+    ('opt-O3', 'opt', ['-O3']),
+    ('llc-O0', 'llc', ['-O0']),
+    ('llc-O2', 'llc', ['-O2']),
+    ('llc-O3', 'llc', ['-O3']),
+    # The fast allocator only works with the register allocation pipeline of
+    # -O0. With the optimizing one, llc reports that it isn't supported.
+    ('llc-O2-regalloc-fast', 'llc',
+     ['-O2', '-regalloc=fast', '-optimize-regalloc=false']),
+    ('llc-O2-regalloc-greedy', 'llc', ['-O2', '-regalloc=greedy']),
+    ('llc-O2-fast-isel', 'llc', ['-O2', '-fast-isel']),
+]
+
+DEFAULT_CORPUS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              'Inputs')
+
+def parse_reports(text):
+  """Parse the -timers-json and -stats-json reports in text, which are
+  printed one JSON object per line.
+
+  Returns (timers, stats). timers maps the name of each timer group to a
+  dictionary mapping the name of each timer to its times, and stats maps
+  "component.description" to the value of each statistic.
+  """
+  groups = {}
+  stats = {}
+  for line in text.splitlines():
+    if not line.startswith('{'):
+      continue
+    try:
+      report = json.loads(line)
+    except ValueError:
+      continue
+    if 'stats' in report:
+      for stat in report['stats']:
+        stats['%s.%s' % (stat['name'], stat['desc'])] = stat['value']
+      continue
+    if 'timers' not in report:
+      continue
+    timers = groups.setdefault(report['name'], {})
+    for timer in report['timers'] + [dict(report['total'], name='Total')]:
+      times = {'user': timer['user'], 'system': timer['sys'],
+               'process': timer['user'] + timer['sys'],
+               'wall': timer['wall'], 'mem': timer['mem']}
+      # Timers with the same name, such as the ones of a pass that runs
+      # several times, are summed up.
+      previous = timers.get(timer['name'])
+      if previous:
+        for key, value in times.items():
+          previous[key] += value
+      else:
+        timers[timer['name']] = times
+  return groups, stats
+
+
+def count_ir_instructions(path):
+  """Count the instructions in the function bodies of a textual IR file."""
+  count = 0
+  in_function = False
+  with open(path) as f:
+    for line in f:
+      line = line.split(';', 1)[0].strip()
+      if not line:
+        continue
+      if line.startswith('define '):
+        in_function = True
+      elif line == '}':
+        in_function = False
+      elif in_function and not line.endswith(':'):
+        count += 1
+  return count
+
+
+def count_asm_instructions(path):
+  """Count the instructions in an assembly file, skipping the labels,
+  directives and comments."""
+  count = 0
+  with open(path) as f:
+    for line in f:
+      line = line.strip()
+      if not line or line[0] in '.#;@/' or line.endswith(':'):
+        continue
+      count += 1
+  return count
+
+
+def run_tool(args, stdout_path):
+  """Run args and return (stderr, times, peak RSS in kilobytes)."""
+  with open(stdout_path, 'w') as out:
+    with tempfile.TemporaryFile() as err:
+      start = os.times()
+      process = subprocess.Popen(args, stdout=out, stderr=err)
+      # wait4 gives the resource usage of this child alone, which is what
+      # the peak RSS has to be measured on.
+      _, status, usage = os.wait4(process.pid, 0)
+      end = os.times()
+      process.returncode = status
+      err.seek(0)
+      stderr = err.read().decode('utf-8', 'replace')
+  if status != 0:
+    raise RuntimeError('%s failed:\n%s' % (' '.join(args), stderr))
+  times = {'user': usage.ru_utime, 'system': usage.ru_stime,
+           'wall': end[4] - start[4]}
+  # ru_maxrss is in kilobytes on Linux, and in bytes on Darwin.
+  peak_rss = usage.ru_maxrss
+  if sys.platform == 'darwin':
+    peak_rss //= 1024
+  return stderr, times, peak_rss
+
+
+def median(values):
+  values = sorted(values)
+  return values[len(values) // 2]
+
+
+def run_pipeline(bin_dir, tool, pipeline_args, input_path, work_dir, runs):
+  output = os.path.join(work_dir, 'out.s' if tool == 'llc' else 'out.ll')
+  args = [os.path.join(bin_dir, tool)] + pipeline_args + [input_path, '-o', '-']
+  if tool == 'opt':
+    args.append('-S')
+
+  # The timed runs are done without -time-passes and -stats, which have
+  # some overhead of their own.
+  samples = []
+  peak_rss = 0
+  for _ in range(runs):
+    _, times, rss = run_tool(args, output)
+    samples.append(times)
+    peak_rss = max(peak_rss, rss)
+
+  stderr, _, _ = run_tool(args + ['-time-passes', '-stats', '-timers-json',
+                                   '-stats-json'], output)
+  groups, stats = parse_reports(stderr)
+
+  result = {
+      'wall_time': median([s['wall'] for s in samples]),
+      'user_time': median([s['user'] for s in samples]),
+      'system_time': median([s['system'] for s in samples]),
+      'peak_rss_kb': peak_rss,
+      'timers': groups,
+      'stats': stats,
+  }
+  if tool == 'opt':
+    result['instructions'] = count_ir_instructions(output)
+  else:
+    result['instructions'] = count_asm_instructions(output)
+  return result
+
+
+def run_benchmarks(args):
+  corpus = sorted(f for f in os.listdir(args.corpus)
+                  if f.endswith('.ll') or f.endswith('.bc'))
+  pipelines = [p for p in PIPELINES
+               if not args.filter or re.search(args.filter, p[0])]
+  results = []
+  work_dir = tempfile.mkdtemp(prefix='compile-bench-')
+  try:
+    for module in corpus:
+      input_path = os.path.join(args.corpus, module)
+      # The input of llc, computed once.
+      optimized = os.path.join(work_dir, 'input.O2.bc')
+      subprocess.check_call([os.path.join(args.bin_dir, 'opt'), '-O2',
+                             input_path, '-o', optimized])
+      for name, tool, pipeline_args in pipelines:
+        if not args.quiet:
+          print('%s %s' % (module, name), file=sys.stderr)
+        tool_input = optimized if tool == 'llc' else input_path
+        extra = ['-mtriple=' + args.triple] if tool == 'llc' and args.triple \
+                else []
+        result = run_pipeline(args.bin_dir, tool, pipeline_args + extra,
+                              tool_input, work_dir, args.runs)
+        result['module'] = module
+        result['pipeline'] = name
+        results.append(result)
+  finally:
+    shutil.rmtree(work_dir)
+
+  return {
+      'host': platform.node(),
+      'platform': platform.platform(),
+      'runs': args.runs,
+      'triple': args.triple,
+      'results': results,
+  }
+
+
+def compare(base_path, new_path, threshold, min_time):
+  """Print the changes between two result files. Returns the number of
+  regressions above threshold percent."""
+  with open(base_path) as f:
+    base = json.load(f)
+  with open(new_path) as f:
+    new = json.load(f)
+
+  def key(r):
+    return (r['module'], r['pipeline'])
+
+  def pass_times(result):
+    times = {}
+    for group, timers in result['timers'].items():
+      for name, t in timers.items():
+        if name != 'Total':
+          times[group + ': ' + name] = t.get('process', t['wall'])
+    return times
+
+  base_results = dict((key(r), r) for r in base['results'])
+  regressions = 0
+  for result in new['results']:
+    old = base_results.get(key(result))
+    if not old:
+      continue
+    rows = [('total', old['user_time'] + old['system_time'],
+             result['user_time'] + result['system_time'])]
+    old_passes = pass_times(old)
+    for name, t in sorted(pass_times(result).items()):
+      if name in old_passes:
+        rows.append((name, old_passes[name], t))
+    for name, before, after in rows:
+      # Changes in timers that are too short are only noise.
+      if max(before, after) < min_time:
+        continue
+      delta = (after - before) * 100.0 / before if before else float('inf')
+      if abs(delta) < threshold:
+        continue
+      if delta > 0:
+        regressions += 1
+      print('%-20s %-24s %+7.1f%%  %.4fs -> %.4fs  %s' %
+            (result['module'], result['pipeline'], delta, before, after,
+             name))
+    for field in ('peak_rss_kb', 'instructions'):
+      if old[field] != result[field]:
+        print('%-20s %-24s %s: %d -> %d' % (result['module'],
+                                            result['pipeline'], field,
+                                            old[field], result[field]))
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--bin-dir', default='',
+                      help='Directory containing opt and llc')
+  parser.add_argument('--corpus', default=DEFAULT_CORPUS,
+                      help='Directory of the IR modules to compile')
+  parser.add_argument('--runs', type=int, default=5,
+                      help='Number of timed runs of each pipeline')
+  parser.add_argument('--filter', default=None,
+                      help='Only run the pipelines matching this regex')
+  parser.add_argument('--triple', default=None,
+                      help='Target triple for llc')
+  parser.add_argument('-o', '--output', default='-',
+                      help='Output file for the JSON results')
+  parser.add_argument('-q', '--quiet', action='store_true',
+                      help='Do not print progress')
+  parser.add_argument('--compare', nargs=2, metavar=('BASE', 'NEW'),
+                      help='Compare two result files instead of running')
+  parser.add_argument('--threshold', type=float, default=5.0,
+                      help='Report changes above this percentage')
+  parser.add_argument('--min-time', type=float, default=0.01,
+                      help='Ignore timers below this many seconds')
+  args = parser.parse_args()
+
+  if args.compare:
+    regressions = compare(args.compare[0], args.compare[1], args.threshold,
+                          args.min_time)
+    return 1 if regressions else 0
+
+  data = run_benchmarks(args)
+  if args.output == '-':
+    json.dump(data, sys.stdout, indent=2, sort_keys=True)
+    print()
+  else:
+    with open(args.output, 'w') as f:
+      json.dump(data, f, indent=2, sort_keys=True)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())